@@ -0,0 +1,50 @@
+#include "AssetLoader.h"
+
+//---------------------------------------------------------------------
+AssetLoader::AssetLoader(unsigned int numWorkers) : pool{ numWorkers }
+{}
+
+//----------------------------------------------------------------------------------------------------------------
+ImageHandle AssetLoader::loadImage(const std::string& fileName, ImageReadyCallback onReady, ImageDecoder decoder)
+{
+	pending++;
+	std::future<ImagePtr> result = pool.submitTask([this, fileName, onReady, decoder]() -> ImagePtr
+	{
+		auto image = std::make_shared<CpuImage>();
+		ImagePtr decoded = decoder(fileName, *image) ? ImagePtr{ image } : ImagePtr{};
+
+		{
+			std::lock_guard<std::mutex> lock{ completedMutex };
+			completed.push_back({ onReady, decoded });
+		}
+		return decoded;
+	});
+	return result.share();
+}
+
+//-----------------------------------------------------------
+size_t AssetLoader::processCompleted(size_t maxCallbacks)
+{
+	size_t processed{ 0 };
+	while (processed < maxCallbacks)
+	{
+		Completion completion;
+		{
+			std::lock_guard<std::mutex> lock{ completedMutex };
+			if (completed.empty())
+			{
+				break;
+			}
+			completion = std::move(completed.front());
+			completed.pop_front();
+		}
+
+		if (completion.callback)
+		{
+			completion.callback(completion.image);
+		}
+		pending--;
+		processed++;
+	}
+	return processed;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "CpuImage.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+
+using ImagePtr = std::shared_ptr<const CpuImage>;
+
+//Future for an image being decoded; holds nullptr if the file could not be decoded
+using ImageHandle = std::shared_future<ImagePtr>;
+
+//Decodes a file into a CpuImage, must be safe to call from any thread
+using ImageDecoder = std::function<bool(const std::string&, CpuImage&)>;
+
+//Runs on the device thread once the image is decoded (image is nullptr on failure)
+using ImageReadyCallback = std::function<void(const ImagePtr&)>;
+
+//Asynchronous asset loading
+//File I/O and decoding run on a worker pool. Work that needs the device (creating
+//textures from the decoded data) is queued back and only runs when the device
+//thread calls processCompleted, usually once per frame
+class AssetLoader
+{
+public:
+
+	explicit AssetLoader(unsigned int numWorkers);
+
+	ImageHandle loadImage(const std::string& fileName, ImageReadyCallback onReady = nullptr, ImageDecoder decoder = loadBmpFile);
+
+	//Runs up to maxCallbacks pending device thread callbacks, returns how many ran
+	size_t processCompleted(size_t maxCallbacks = SIZE_MAX);
+
+	//Loads whose device thread callback has not run yet
+	size_t pendingCount() const { return pending; }
+
+	unsigned int workerCount() const { return pool.workerCount(); }
+
+private:
+
+	struct Completion
+	{
+		ImageReadyCallback callback;
+		ImagePtr image;
+	};
+
+	std::mutex completedMutex;
+	std::deque<Completion> completed;
+	std::atomic<size_t> pending{ 0 };
+
+	//Declared last so the workers are joined before the completion queue is destroyed
+	ThreadPool pool;
+};
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include "BVH.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	const uint32_t maxLeafSize{ 4 };
+	const int numBins{ 16 };
+
+	//Keeps the fixed size traversal stacks (depth + 1 entries) from overflowing
+	const uint32_t maxDepth{ 60 };
+
+	//Subtrees with more primitives than this are built in parallel with their sibling
+	const uint32_t minParallelBuildSize{ 16384 };
+
+	//-------------------------------------------------
+	void growBounds(AABB& bounds, const AABB& other)
+	{
+		bounds.aabbMin.x = std::min(bounds.aabbMin.x, other.aabbMin.x);
+		bounds.aabbMin.y = std::min(bounds.aabbMin.y, other.aabbMin.y);
+		bounds.aabbMin.z = std::min(bounds.aabbMin.z, other.aabbMin.z);
+		bounds.aabbMax.x = std::max(bounds.aabbMax.x, other.aabbMax.x);
+		bounds.aabbMax.y = std::max(bounds.aabbMax.y, other.aabbMax.y);
+		bounds.aabbMax.z = std::max(bounds.aabbMax.z, other.aabbMax.z);
+	}
+
+	//----------------------------------------------------
+	void growBounds(AABB& bounds, const XMFLOAT3& point)
+	{
+		growBounds(bounds, AABB{ point, point });
+	}
+
+	//-------------------------
+	AABB emptyBounds()
+	{
+		return AABB{ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	}
+
+	//--------------------------------------
+	float surfaceArea(const AABB& bounds)
+	{
+		float x = bounds.aabbMax.x - bounds.aabbMin.x;
+		float y = bounds.aabbMax.y - bounds.aabbMin.y;
+		float z = bounds.aabbMax.z - bounds.aabbMin.z;
+		if (x < 0.0f || y < 0.0f || z < 0.0f)
+		{
+			return 0.0f;
+		}
+		return 2.0f * (x * y + y * z + z * x);
+	}
+
+	//------------------------------------------------
+	float component(const XMFLOAT3& v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	//--------------------------------------------------
+	bool overlaps(const AABB& a, const AABB& b)
+	{
+		return a.aabbMin.x <= b.aabbMax.x && a.aabbMax.x >= b.aabbMin.x &&
+			a.aabbMin.y <= b.aabbMax.y && a.aabbMax.y >= b.aabbMin.y &&
+			a.aabbMin.z <= b.aabbMax.z && a.aabbMax.z >= b.aabbMin.z;
+	}
+
+	//-------------------------------------------------------------------------------
+	bool overlapsSphere(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, const XMFLOAT3& center, float radius)
+	{
+		float dx = std::max(std::max(boxMin.x - center.x, 0.0f), center.x - boxMax.x);
+		float dy = std::max(std::max(boxMin.y - center.y, 0.0f), center.y - boxMax.y);
+		float dz = std::max(std::max(boxMin.z - center.z, 0.0f), center.z - boxMax.z);
+		return dx * dx + dy * dy + dz * dz <= radius * radius;
+	}
+
+	enum class FrustumTest { Outside, Intersecting, Inside };
+
+	//------------------------------------------------------------------------------------------
+	FrustumTest classifyAABB(const Frustum& frustum, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+	{
+		FrustumTest result{ FrustumTest::Inside };
+		for (const XMFLOAT4& plane : frustum.planes)
+		{
+			//Corners furthest along and against the plane normal
+			float px = plane.x >= 0.0f ? boxMax.x : boxMin.x;
+			float py = plane.y >= 0.0f ? boxMax.y : boxMin.y;
+			float pz = plane.z >= 0.0f ? boxMax.z : boxMin.z;
+			if (plane.x * px + plane.y * py + plane.z * pz + plane.w < 0.0f)
+			{
+				return FrustumTest::Outside;
+			}
+
+			float nx = plane.x >= 0.0f ? boxMin.x : boxMax.x;
+			float ny = plane.y >= 0.0f ? boxMin.y : boxMax.y;
+			float nz = plane.z >= 0.0f ? boxMin.z : boxMax.z;
+			if (plane.x * nx + plane.y * ny + plane.z * nz + plane.w < 0.0f)
+			{
+				result = FrustumTest::Intersecting;
+			}
+		}
+		return result;
+	}
+}
+
+//-------------------------------------------------------
+void BVH::build(const AABB primitives[], size_t count)
+{
+	primBounds.assign(primitives, primitives + count);
+	primIndices.resize(count);
+	centroids.resize(count);
+	for (size_t i{ 0 }; i < count; i++)
+	{
+		primIndices[i] = static_cast<uint32_t>(i);
+		centroids[i] = { (primitives[i].aabbMin.x + primitives[i].aabbMax.x) * 0.5f,
+						 (primitives[i].aabbMin.y + primitives[i].aabbMax.y) * 0.5f,
+						 (primitives[i].aabbMin.z + primitives[i].aabbMax.z) * 0.5f };
+	}
+
+	//A binary tree with at least one primitive per leaf never needs more than 2n - 1 nodes
+	nodes.resize(std::max<size_t>(1, 2 * count));
+	nodesUsed = 1;
+	nodes[0] = BVHNode{ { 0.0f, 0.0f, 0.0f }, 0, { 0.0f, 0.0f, 0.0f }, 0 };
+	if (count == 0)
+	{
+		return;
+	}
+
+	int parallelDepth{ 0 };
+	for (unsigned int threads = workerThreadCount(); threads > 1; threads >>= 1)
+	{
+		parallelDepth++;
+	}
+	buildRecursive(0, 0, static_cast<uint32_t>(count), 0, parallelDepth);
+}
+
+//--------------------------------------------------------------------------------------------
+void BVH::buildRecursive(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, int parallelDepth)
+{
+	BVHNode& node = nodes[nodeIndex];
+
+	//Node and centroid bounds
+	AABB bounds = emptyBounds();
+	AABB centroidBounds = emptyBounds();
+	for (uint32_t i{ first }; i < first + count; i++)
+	{
+		growBounds(bounds, primBounds[primIndices[i]]);
+		growBounds(centroidBounds, centroids[primIndices[i]]);
+	}
+	node.aabbMin = bounds.aabbMin;
+	node.aabbMax = bounds.aabbMax;
+	node.leftFirst = first;
+	node.count = count;
+
+	if (count <= maxLeafSize || depth >= maxDepth)
+	{
+		return;
+	}
+
+	//Binned SAH over all three axes
+	int bestAxis{ -1 };
+	int bestSplit{ 0 };
+	float bestCost{ FLT_MAX };
+	for (int axis{ 0 }; axis < 3; axis++)
+	{
+		float axisMin = component(centroidBounds.aabbMin, axis);
+		float axisExtent = component(centroidBounds.aabbMax, axis) - axisMin;
+		if (axisExtent <= 0.0f)
+		{
+			continue;
+		}
+
+		AABB binBounds[numBins];
+		uint32_t binCounts[numBins]{};
+		for (AABB& binBound : binBounds)
+		{
+			binBound = emptyBounds();
+		}
+
+		float scale = numBins / axisExtent;
+		for (uint32_t i{ first }; i < first + count; i++)
+		{
+			uint32_t prim = primIndices[i];
+			int bin = std::min(numBins - 1, static_cast<int>((component(centroids[prim], axis) - axisMin) * scale));
+			binCounts[bin]++;
+			growBounds(binBounds[bin], primBounds[prim]);
+		}
+
+		//Sweep from the right to get the area and count of every right partition
+		float rightArea[numBins - 1];
+		uint32_t rightCount[numBins - 1];
+		AABB rightBounds = emptyBounds();
+		uint32_t rightSum{ 0 };
+		for (int i{ numBins - 1 }; i > 0; i--)
+		{
+			growBounds(rightBounds, binBounds[i]);
+			rightSum += binCounts[i];
+			rightArea[i - 1] = surfaceArea(rightBounds);
+			rightCount[i - 1] = rightSum;
+		}
+
+		AABB leftBounds = emptyBounds();
+		uint32_t leftSum{ 0 };
+		for (int i{ 0 }; i < numBins - 1; i++)
+		{
+			growBounds(leftBounds, binBounds[i]);
+			leftSum += binCounts[i];
+			if (leftSum == 0 || rightCount[i] == 0)
+			{
+				continue;
+			}
+			float cost = leftSum * surfaceArea(leftBounds) + rightCount[i] * rightArea[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	//Stop when splitting is not cheaper than testing every primitive, or when all
+	//centroids coincide and no split exists
+	float leafCost = count * surfaceArea(bounds);
+	if (bestAxis < 0 || bestCost >= leafCost)
+	{
+		return;
+	}
+
+	//Partition primitive indices around the chosen bin boundary
+	float axisMin = component(centroidBounds.aabbMin, bestAxis);
+	float scale = numBins / (component(centroidBounds.aabbMax, bestAxis) - axisMin);
+	uint32_t* middle = std::partition(primIndices.data() + first, primIndices.data() + first + count, [&](uint32_t prim)
+	{
+		int bin = std::min(numBins - 1, static_cast<int>((component(centroids[prim], bestAxis) - axisMin) * scale));
+		return bin <= bestSplit;
+	});
+	uint32_t leftCount = static_cast<uint32_t>(middle - (primIndices.data() + first));
+
+	uint32_t leftChild = nodesUsed.fetch_add(2);
+	node.leftFirst = leftChild;
+	node.count = 0;
+
+	//Large subtrees on both sides are built side by side on the parallel pool
+	if (parallelDepth > 0 && leftCount > minParallelBuildSize && count - leftCount > minParallelBuildSize)
+	{
+		parallelFor(2, 1, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t side = begin; side < end; side++)
+			{
+				if (side == 0)
+				{
+					buildRecursive(leftChild, first, leftCount, depth + 1, parallelDepth - 1);
+				}
+				else
+				{
+					buildRecursive(leftChild + 1, first + leftCount, count - leftCount, depth + 1, parallelDepth - 1);
+				}
+			}
+		});
+	}
+	else
+	{
+		buildRecursive(leftChild, first, leftCount, depth + 1, 0);
+		buildRecursive(leftChild + 1, first + leftCount, count - leftCount, depth + 1, 0);
+	}
+}
+
+//-----------------
+void BVH::refit()
+{
+	for (size_t i = nodesUsed; i-- > 0;)
+	{
+		BVHNode& node = nodes[i];
+		AABB bounds = emptyBounds();
+		if (node.count > 0)
+		{
+			for (uint32_t j{ node.leftFirst }; j < node.leftFirst + node.count; j++)
+			{
+				growBounds(bounds, primBounds[primIndices[j]]);
+			}
+		}
+		else if (primBounds.size() > 0)
+		{
+			const BVHNode& left = nodes[node.leftFirst];
+			const BVHNode& right = nodes[node.leftFirst + 1];
+			bounds = AABB{ left.aabbMin, left.aabbMax };
+			growBounds(bounds, AABB{ right.aabbMin, right.aabbMax });
+		}
+		node.aabbMin = bounds.aabbMin;
+		node.aabbMax = bounds.aabbMax;
+	}
+}
+
+//----------------------------------------------------------------------------
+void BVH::appendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& out) const
+{
+	const BVHNode& node = nodes[nodeIndex];
+	if (node.count > 0)
+	{
+		out.insert(out.end(), primIndices.begin() + node.leftFirst, primIndices.begin() + node.leftFirst + node.count);
+		return;
+	}
+	appendSubtree(node.leftFirst, out);
+	appendSubtree(node.leftFirst + 1, out);
+}
+
+//Nodes fully inside the frustum add their whole subtree without further tests
+//---------------------------------------------------------------------------------
+void BVH::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& out) const
+{
+	if (primBounds.empty())
+	{
+		return;
+	}
+
+	uint32_t stack[64];
+	int stackSize{ 0 };
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = nodes[stack[--stackSize]];
+		FrustumTest test = classifyAABB(frustum, node.aabbMin, node.aabbMax);
+		if (test == FrustumTest::Outside)
+		{
+			continue;
+		}
+		if (test == FrustumTest::Inside)
+		{
+			appendSubtree(static_cast<uint32_t>(&node - nodes.data()), out);
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i{ node.leftFirst }; i < node.leftFirst + node.count; i++)
+			{
+				const AABB& prim = primBounds[primIndices[i]];
+				if (aabbInFrustum(frustum, prim.aabbMin, prim.aabbMax))
+				{
+					out.push_back(primIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------
+void BVH::querySphere(const XMFLOAT3& center, float radius, std::vector<uint32_t>& out) const
+{
+	if (primBounds.empty())
+	{
+		return;
+	}
+
+	uint32_t stack[64];
+	int stackSize{ 0 };
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = nodes[stack[--stackSize]];
+		if (!overlapsSphere(node.aabbMin, node.aabbMax, center, radius))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i{ node.leftFirst }; i < node.leftFirst + node.count; i++)
+			{
+				const AABB& prim = primBounds[primIndices[i]];
+				if (overlapsSphere(prim.aabbMin, prim.aabbMax, center, radius))
+				{
+					out.push_back(primIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------
+void BVH::queryAABB(const AABB& box, std::vector<uint32_t>& out) const
+{
+	if (primBounds.empty())
+	{
+		return;
+	}
+
+	uint32_t stack[64];
+	int stackSize{ 0 };
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = nodes[stack[--stackSize]];
+		if (!overlaps(AABB{ node.aabbMin, node.aabbMax }, box))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (uint32_t i{ node.leftFirst }; i < node.leftFirst + node.count; i++)
+			{
+				if (overlaps(primBounds[primIndices[i]], box))
+				{
+					out.push_back(primIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include "Culling.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//World space axis aligned box of a single instance
+struct AABB
+{
+	XMFLOAT3 aabbMin;
+	XMFLOAT3 aabbMax;
+};
+
+//32 byte flattened node. Children are always allocated as an adjacent pair
+//(left = leftFirst, right = leftFirst + 1) and after their parent, so a reverse
+//walk over the node array visits children before parents
+struct alignas(32) BVHNode
+{
+	XMFLOAT3 aabbMin;
+	uint32_t leftFirst;	//interior : left child index, leaf : first entry in primIndices
+	XMFLOAT3 aabbMax;
+	uint32_t count;		//0 for interior nodes
+};
+
+//Bounding volume hierarchy over static instance bounds
+//Built top down with a binned SAH; large subtrees are built on worker threads.
+//Moved instances are handled with refit which keeps the topology and only
+//recomputes bounds
+class BVH
+{
+public:
+
+	void build(const AABB primitives[], size_t count);
+	void build(const std::vector<AABB>& primitives) { build(primitives.data(), primitives.size()); }
+
+	//Replace the bounds of one instance; call refit once all updates are done
+	void updatePrimitive(uint32_t index, const AABB& bounds) { primBounds[index] = bounds; }
+	void refit();
+
+	//Queries append the indices of matching instances to out (order is unspecified)
+	void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& out) const;
+	void querySphere(const XMFLOAT3& center, float radius, std::vector<uint32_t>& out) const;
+	void queryAABB(const AABB& box, std::vector<uint32_t>& out) const;
+
+	size_t nodeCount() const { return nodesUsed; }
+	size_t primitiveCount() const { return primBounds.size(); }
+	const BVHNode* nodeData() const { return nodes.data(); }
+
+private:
+
+	void buildRecursive(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, int parallelDepth);
+	void appendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& out) const;
+
+	std::vector<BVHNode> nodes;
+	std::vector<uint32_t> primIndices;
+	std::vector<AABB> primBounds;
+	std::vector<XMFLOAT3> centroids;
+	std::atomic<uint32_t> nodesUsed{ 0 };
+};
\ No newline at end of file
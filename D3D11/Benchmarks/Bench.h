@@ -0,0 +1,30 @@
+#pragma once
+//Minimal benchmark helpers, benchmarks are plain executables and are not run by ctest
+//Each case reports the best of a few runs, which is less noisy than the mean on a shared machine
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+//Best wall time of runs calls of func, milliseconds
+template <typename Func>
+double benchBestMs(int runs, Func&& func)
+{
+	double best{ 1e30 };
+	for (int run = 0; run < runs; run++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		const auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+//Keeps the optimizer from discarding a result
+inline const void* volatile benchSink{ nullptr };
+
+template <typename T>
+void benchKeep(const T& value)
+{
+	benchSink = &value;
+}
@@ -0,0 +1,54 @@
+//Loading the 120 FireAnim frames through AssetLoader with 1 to 8 workers, plus packing them into the atlas
+//Run from the D3D11 directory so the image paths resolve
+#include "Bench.h"
+#include "AssetLoader.h"
+#include "Flipbook.h"
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	const std::vector<std::string> fileNames = flipbookFrameFileNames("Images/FireAnim/Fire", 120, ".bmp");
+
+	const double serialMs = benchBestMs(5, [&]()
+	{
+		for (const std::string& fileName : fileNames)
+		{
+			CpuImage image;
+			loadBmpFile(fileName, image);
+			benchKeep(image);
+		}
+	});
+	std::printf("%8s %10s %10s\n", "workers", "load ms", "speedup");
+	std::printf("%8s %10.3f %10s\n", "inline", serialMs, "1.00x");
+
+	for (unsigned int workers : { 1u, 2u, 4u, 8u })
+	{
+		AssetLoader loader{ workers };
+		const double loadMs = benchBestMs(5, [&]()
+		{
+			std::vector<ImageHandle> handles;
+			handles.reserve(fileNames.size());
+			for (const std::string& fileName : fileNames)
+			{
+				handles.push_back(loader.loadImage(fileName));
+			}
+			for (ImageHandle& handle : handles)
+			{
+				benchKeep(handle.get());
+			}
+			loader.processCompleted();
+		});
+		std::printf("%8u %10.3f %9.2fx\n", workers, loadMs, serialMs / loadMs);
+	}
+
+	std::vector<CpuImage> frames(fileNames.size());
+	for (size_t i{ 0 }; i < fileNames.size(); i++)
+	{
+		loadBmpFile(fileNames[i], frames[i]);
+	}
+	Flipbook flipbook;
+	const double packMs = benchBestMs(5, [&]() { flipbook.pack(frames); });
+	std::printf("atlas pack %ux%u : %.3f ms\n", flipbook.atlas().width, flipbook.atlas().height, packMs);
+	return 0;
+}
@@ -0,0 +1,51 @@
+//BVH build, refit and frustum query for 10k to 1M boxes against a brute force frustum test
+#include "Bench.h"
+#include "BVH.h"
+#include "Parallel.h"
+#include <random>
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 20.0f, -150.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const Frustum frustum = extractFrustumPlanes(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 200.0f)));
+
+	std::printf("%u hardware threads\n", workerThreadCount());
+	std::printf("%10s %10s %10s %10s %10s %12s\n", "boxes", "visible", "build ms", "refit ms", "query ms", "brute ms");
+	for (size_t count : { size_t{ 10000 }, size_t{ 100000 }, size_t{ 1000000 } })
+	{
+		std::mt19937 random{ 1 };
+		std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+		std::vector<AABB> boxes(count);
+		for (AABB& box : boxes)
+		{
+			const XMFLOAT3 center{ position(random), position(random) * 0.1f, position(random) };
+			box = AABB{ { center.x - 1.0f, center.y - 1.0f, center.z - 1.0f }, { center.x + 1.0f, center.y + 1.0f, center.z + 1.0f } };
+		}
+
+		const int runs{ count >= 1000000 ? 3 : 10 };
+		BVH bvh;
+		const double buildMs = benchBestMs(runs, [&]() { bvh.build(boxes); });
+		const double refitMs = benchBestMs(runs, [&]() { bvh.refit(); });
+
+		std::vector<uint32_t> visible;
+		visible.reserve(count);
+		const double queryMs = benchBestMs(runs, [&]() { visible.clear(); bvh.queryFrustum(frustum, visible); benchKeep(visible); });
+		const size_t numVisible{ visible.size() };
+		const double bruteMs = benchBestMs(runs, [&]()
+		{
+			visible.clear();
+			for (uint32_t i{ 0 }; i < count; i++)
+			{
+				if (aabbInFrustum(frustum, boxes[i].aabbMin, boxes[i].aabbMax))
+				{
+					visible.push_back(i);
+				}
+			}
+			benchKeep(visible);
+		});
+		std::printf("%10zu %10zu %10.3f %10.3f %10.3f %12.3f\n", count, numVisible, buildMs, refitMs, queryMs, bruteMs);
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+//LightClusterGrid::assign for 256 to 16384 lights in a 16x9x24 grid, one thread and every
+//hardware thread, against testing every point light with every cluster box. The lights per
+//cluster column is what a pixel shades instead of every light in the scene
+#include "Bench.h"
+#include "ClusteredLighting.h"
+#include "Parallel.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const uint32_t tilesX{ 16 };
+	const uint32_t tilesY{ 9 };
+	const uint32_t slices{ 24 };
+	const float nearZ{ 0.5f };
+	const float farZ{ 200.0f };
+
+	//Cluster boxes and every point light against every one, the cost binning avoids
+	//-------------------------------------------------------
+	size_t bruteForce(const XMFLOAT4X4& view, const XMFLOAT4X4& proj, const std::vector<PointLight>& lights)
+	{
+		std::vector<XMFLOAT4> viewLights(lights.size());
+		for (size_t l{ 0 }; l < lights.size(); l++)
+		{
+			const XMFLOAT3& p = lights[l].lightPos;
+			viewLights[l] = { p.x * view._11 + p.y * view._21 + p.z * view._31 + view._41, p.x * view._12 + p.y * view._22 + p.z * view._32 + view._42,
+				p.x * view._13 + p.y * view._23 + p.z * view._33 + view._43, lights[l].range };
+		}
+
+		size_t overlaps{ 0 };
+		for (uint32_t k{ 0 }; k < slices; k++)
+		{
+			const float zNear = nearZ * std::pow(farZ / nearZ, static_cast<float>(k) / slices);
+			const float zFar = nearZ * std::pow(farZ / nearZ, static_cast<float>(k + 1) / slices);
+			for (uint32_t j{ 0 }; j < tilesY; j++)
+			{
+				const float top = 1.0f - 2.0f * j / tilesY;
+				const float bottom = 1.0f - 2.0f * (j + 1) / tilesY;
+				const float minY = std::min(bottom * zNear, bottom * zFar) / proj._22;
+				const float maxY = std::max(top * zNear, top * zFar) / proj._22;
+				for (uint32_t i{ 0 }; i < tilesX; i++)
+				{
+					const float left = -1.0f + 2.0f * i / tilesX;
+					const float right = -1.0f + 2.0f * (i + 1) / tilesX;
+					const float minX = std::min(left * zNear, left * zFar) / proj._11;
+					const float maxX = std::max(right * zNear, right * zFar) / proj._11;
+					for (const XMFLOAT4& light : viewLights)
+					{
+						const float dx = std::max({ minX - light.x, 0.0f, light.x - maxX });
+						const float dy = std::max({ minY - light.y, 0.0f, light.y - maxY });
+						const float dz = std::max({ zNear - light.z, 0.0f, light.z - zFar });
+						overlaps += dx * dx + dy * dy + dz * dz <= light.w * light.w;
+					}
+				}
+			}
+		}
+		return overlaps;
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	XMFLOAT4X4 view, proj;
+	XMStoreFloat4x4(&view, XMMatrixLookAtLH(XMVectorSet(0.0f, 8.0f, -20.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 40.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+	XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(0.25f * 3.14159265f, 1280.0f / 720.0f, nearZ, farZ));
+
+	std::vector<unsigned int> threadCounts{ 1 };
+	if (workerThreadCount() > 1)
+	{
+		threadCounts.push_back(workerThreadCount());
+	}
+
+	std::printf("%8s %8s %8s %12s %14s %14s\n", "points", "spots", "threads", "assign ms", "brute ms", "lights/cluster");
+	for (uint32_t count : { 256u, 1024u, 4096u, 16384u })
+	{
+		std::mt19937 random{ count };
+		std::uniform_real_distribution<float> x{ -100.0f, 100.0f };
+		std::uniform_real_distribution<float> y{ -5.0f, 20.0f };
+		std::uniform_real_distribution<float> z{ -20.0f, 200.0f };
+		std::uniform_real_distribution<float> range{ 1.0f, 8.0f };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+		std::vector<PointLight> points(count);
+		for (PointLight& light : points)
+		{
+			light.lightPos = XMFLOAT3{ x(random), y(random), z(random) };
+			light.range = range(random);
+		}
+		std::vector<SpotLight> spots(count / 4);
+		for (SpotLight& light : spots)
+		{
+			light.lightPos = XMFLOAT3{ x(random), y(random), z(random) };
+			light.range = range(random) * 2.0f;
+			light.lightDir = XMFLOAT3{ unit(random), -1.0f, unit(random) };
+			light.spotPower = 16.0f;
+		}
+
+		size_t overlaps{ 0 };
+		const double bruteMs = benchBestMs(3, [&]()
+		{
+			overlaps = bruteForce(view, proj, points);
+			benchKeep(overlaps);
+		});
+
+		for (unsigned int threads : threadCounts)
+		{
+			setParallelWorkerCount(threads);
+			LightClusterGrid grid;
+			grid.build(tilesX, tilesY, slices, proj, nearZ, farZ);
+			const double assignMs = benchBestMs(20, [&]()
+			{
+				grid.assign(view, points.data(), points.size(), spots.data(), spots.size());
+			});
+			std::printf("%8u %8zu %8u %12.3f %14.3f %14.2f\n", count, spots.size(), threads, assignMs, bruteMs,
+				static_cast<double>(grid.lightIndices().size()) / grid.clusterCount());
+		}
+	}
+	setParallelWorkerCount(0);
+	return 0;
+}
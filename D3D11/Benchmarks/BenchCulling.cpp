@@ -0,0 +1,61 @@
+//cullSpheres on 10k to 1M spheres against a scalar loop, and the cost of clearing the visible buffer every call
+#include "Bench.h"
+#include "Culling.h"
+#include <random>
+#include <vector>
+
+namespace
+{
+	//-------------------------------------------------------
+	size_t scalarCull(const Frustum& frustum, const SphereBoundsSoA& spheres, std::vector<uint32_t>& visible)
+	{
+		size_t numVisible{ 0 };
+		for (size_t i{ 0 }; i < spheres.size(); i++)
+		{
+			bool inside{ true };
+			for (const XMFLOAT4& plane : frustum.planes)
+			{
+				inside &= plane.x * spheres.centerX[i] + plane.y * spheres.centerY[i] + plane.z * spheres.centerZ[i] + plane.w >= -spheres.radius[i];
+			}
+			if (inside)
+			{
+				visible[numVisible++] = static_cast<uint32_t>(i);
+			}
+		}
+		return numVisible;
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const Frustum frustum = extractFrustumPlanes(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 100.0f)));
+
+	std::printf("%10s %10s %10s %16s %10s\n", "spheres", "visible", "simd ms", "simd+clear ms", "scalar ms");
+	for (size_t count : { size_t{ 10000 }, size_t{ 100000 }, size_t{ 1000000 } })
+	{
+		std::mt19937 random{ 1 };
+		std::uniform_real_distribution<float> position{ -60.0f, 120.0f };
+		SphereBoundsSoA spheres;
+		spheres.resize(count);
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			spheres.set(i, XMFLOAT3{ position(random) * 0.5f, position(random) * 0.3f, position(random) }, 1.0f);
+		}
+
+		std::vector<uint32_t> visible;
+		size_t numVisible = cullSpheres(frustum, spheres, visible);
+		const double simdMs = benchBestMs(20, [&]() { numVisible = cullSpheres(frustum, spheres, visible); benchKeep(numVisible); });
+		//What every call cost when the buffer was shrunk to the visible count and zero filled again
+		const double clearMs = benchBestMs(20, [&]()
+		{
+			visible.resize(numVisible);
+			numVisible = cullSpheres(frustum, spheres, visible);
+			benchKeep(numVisible);
+		});
+		const double scalarMs = benchBestMs(20, [&]() { benchKeep(scalarCull(frustum, spheres, visible)); });
+		std::printf("%10zu %10zu %10.3f %16.3f %10.3f\n", count, numVisible, simdMs, clearMs, scalarMs);
+	}
+	return 0;
+}
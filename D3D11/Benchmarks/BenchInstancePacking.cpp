@@ -0,0 +1,41 @@
+//InstancePacker cost per frame for 1k to 100k instances, general matrices against the translation fast path
+#include "Bench.h"
+#include "Instancing.h"
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	std::printf("%10s %12s %14s %10s\n", "instances", "add ms", "translation ms", "MB");
+	for (size_t count : { size_t{ 1000 }, size_t{ 10000 }, size_t{ 100000 } })
+	{
+		std::vector<XMFLOAT3> translations(count);
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			translations[i] = XMFLOAT3{ static_cast<float>(i % 100), static_cast<float>(i / 100 % 100), static_cast<float>(i / 10000) };
+		}
+		Material material;
+		material.diffuseColor = XMFLOAT4{ 0.8f, 0.8f, 0.8f, 1.0f };
+
+		//Storage is kept between runs as it is between frames, so only the first run allocates
+		InstancePacker packer;
+		packer.reserve(count);
+		const double addMs = benchBestMs(20, [&]()
+		{
+			packer.clear();
+			for (const XMFLOAT3& translation : translations)
+			{
+				packer.add(XMMatrixTranslation(translation.x, translation.y, translation.z), material, INSTANCE_USE_TEXTURE);
+			}
+			benchKeep(packer.data()[count - 1]);
+		});
+		const double translationMs = benchBestMs(20, [&]()
+		{
+			packer.clear();
+			packer.addTranslations(translations.data(), count, material, INSTANCE_USE_TEXTURE);
+			benchKeep(packer.data()[count - 1]);
+		});
+		std::printf("%10zu %12.3f %14.3f %10.2f\n", count, addMs, translationMs, packer.sizeInBytes() / (1024.0 * 1024.0));
+	}
+	return 0;
+}
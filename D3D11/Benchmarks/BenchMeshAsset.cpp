@@ -0,0 +1,121 @@
+//Loading a cooked .mesh against importing the same mesh from OBJ text, for height field grids
+//of 0.5M to 4.5M triangles written to temporary files. Opening only maps the file and checks
+//the tables, the copy column also reads both blobs out of the mapping the way buffer creation
+//does. Times are warm, the files are in the page cache after writing
+#include "Bench.h"
+#include "MeshAsset.h"
+#include "MeshImporter.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	//size x size quads, written as an OBJ file with positions, texture coordinates and normals
+	//-------------------------------------------------------
+	void makeGrid(uint32_t size, std::vector<VertexNormTex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const uint32_t row{ size + 1 };
+		vertices.resize(size_t{ row } * row);
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				const float u = static_cast<float>(x) / size;
+				const float v = static_cast<float>(y) / size;
+				vertices[size_t{ y } * row + x] = { XMFLOAT3{ u, std::sin(u * 20.0f) * std::cos(v * 20.0f) * 0.05f, v },
+					XMFLOAT3{ 0.0f, 1.0f, 0.0f }, XMFLOAT2{ u, v } };
+			}
+		}
+		indices.clear();
+		indices.reserve(size_t{ size } * size * 6);
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const uint32_t i{ y * row + x };
+				const uint32_t quad[6]{ i, i + row, i + row + 1, i, i + row + 1, i + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	//-------------------------------------------------------
+	void writeObj(const std::string& fileName, const std::vector<VertexNormTex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::ofstream file{ fileName, std::ios::out | std::ios::trunc };
+		char line[128];
+		for (const VertexNormTex& vertex : vertices)
+		{
+			std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", vertex.position.x, vertex.position.y, vertex.position.z);
+			file << line;
+		}
+		for (const VertexNormTex& vertex : vertices)
+		{
+			std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", vertex.texCoords.x, vertex.texCoords.y);
+			file << line;
+		}
+		file << "vn 0 1 0\n";
+		for (size_t i{ 0 }; i < indices.size(); i += 3)
+		{
+			std::snprintf(line, sizeof(line), "f %u/%u/1 %u/%u/1 %u/%u/1\n", indices[i] + 1, indices[i] + 1,
+				indices[i + 1] + 1, indices[i + 1] + 1, indices[i + 2] + 1, indices[i + 2] + 1);
+			file << line;
+		}
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "BenchMeshAsset";
+	std::filesystem::create_directories(directory);
+	const std::string meshName = (directory / "bench.mesh").string();
+	const std::string objName = (directory / "bench.obj").string();
+
+	std::printf("%10s %10s %10s %10s %12s %10s\n", "triangles", "mesh MB", "obj MB", "open ms", "open+copy ms", "obj ms");
+	for (uint32_t size : { 500u, 1000u, 1500u })
+	{
+		std::vector<VertexNormTex> vertices;
+		std::vector<uint32_t> indices;
+		makeGrid(size, vertices, indices);
+		MeshAssetWriter writer;
+		writer.setVertices(vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(VertexNormTex), vertexNormTexLayout, 3);
+		writer.setIndices(indices.data(), indices.size());
+		writer.addSubmesh({ { 0, static_cast<uint32_t>(indices.size()), 0.0f } });
+		writer.write(meshName);
+		writeObj(objName, vertices, indices);
+
+		const double openMs = benchBestMs(10, [&]()
+		{
+			MeshAsset asset;
+			asset.open(meshName);
+			benchKeep(asset.vertexCount());
+		});
+
+		std::vector<uint8_t> vertexCopy(vertices.size() * sizeof(VertexNormTex));
+		std::vector<uint8_t> indexCopy(indices.size() * sizeof(uint32_t));
+		const double copyMs = benchBestMs(5, [&]()
+		{
+			MeshAsset asset;
+			asset.open(meshName);
+			memcpy(vertexCopy.data(), asset.vertexData(), size_t{ asset.vertexCount() } * asset.vertexStride());
+			memcpy(indexCopy.data(), asset.indexData(), size_t{ asset.indexCount() } * (asset.indexFormat() == IndexFormat::UInt16 ? 2 : 4));
+			benchKeep(vertexCopy[0]);
+		});
+
+		const double objMs = benchBestMs(2, [&]()
+		{
+			ImportedMesh mesh;
+			importObj(objName, mesh);
+			benchKeep(mesh.indices[0]);
+		});
+
+		std::printf("%10zu %10.1f %10.1f %10.2f %12.1f %10.1f\n", indices.size() / 3, std::filesystem::file_size(meshName) / 1e6,
+			std::filesystem::file_size(objName) / 1e6, openMs, copyMs, objMs);
+	}
+	std::filesystem::remove_all(directory);
+	return 0;
+}
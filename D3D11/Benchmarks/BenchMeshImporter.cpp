@@ -0,0 +1,158 @@
+//MeshImporter throughput on height field grids of 0.5M to 4.5M triangles, as OBJ text and as a
+//.glb with a binary buffer, on one thread and on every hardware thread. Files are written to a
+//temporary directory and are warm in the page cache
+#include "Bench.h"
+#include "MeshImporter.h"
+#include "Parallel.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	//-------------------------------------------------------
+	void writeBytes(const std::string& fileName, const void* data, size_t size)
+	{
+		std::ofstream file{ fileName, std::ios::out | std::ios::binary | std::ios::trunc };
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	}
+
+	//size x size quads with positions, texture coordinates and one shared normal as OBJ text
+	//-------------------------------------------------------
+	void writeObj(const std::string& fileName, uint32_t size)
+	{
+		const uint32_t row{ size + 1 };
+		std::string text;
+		char line[128];
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				const float u = static_cast<float>(x) / size;
+				const float v = static_cast<float>(y) / size;
+				std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", u, std::sin(u * 20.0f) * std::cos(v * 20.0f) * 0.05f, v, u, v);
+				text += line;
+			}
+		}
+		text += "vn 0 1 0\n";
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const uint32_t i{ y * row + x + 1 };
+				std::snprintf(line, sizeof(line), "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n", i, i, i + row, i + row, i + row + 1, i + row + 1, i + 1, i + 1);
+				text += line;
+			}
+		}
+		writeBytes(fileName, text.data(), text.size());
+	}
+
+	//The same grid as a .glb: float3 positions, float3 normals, float2 texCoords, 32 bit indices
+	//-------------------------------------------------------
+	void writeGlb(const std::string& fileName, uint32_t size)
+	{
+		const uint32_t row{ size + 1 };
+		const uint32_t vertexCount{ row * row };
+		const uint32_t indexCount{ size * size * 6 };
+		std::vector<float> positions, normals, texCoords;
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				const float u = static_cast<float>(x) / size;
+				const float v = static_cast<float>(y) / size;
+				positions.insert(positions.end(), { u, std::sin(u * 20.0f) * std::cos(v * 20.0f) * 0.05f, v });
+				normals.insert(normals.end(), { 0.0f, 1.0f, 0.0f });
+				texCoords.insert(texCoords.end(), { u, v });
+			}
+		}
+		std::vector<uint32_t> indices;
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const uint32_t i{ y * row + x };
+				indices.insert(indices.end(), { i, i + row, i + row + 1, i, i + row + 1, i + 1 });
+			}
+		}
+
+		const size_t positionBytes = positions.size() * sizeof(float);
+		const size_t normalBytes = normals.size() * sizeof(float);
+		const size_t texCoordBytes = texCoords.size() * sizeof(float);
+		const size_t indexBytes = indices.size() * sizeof(uint32_t);
+		const size_t binarySize = positionBytes + normalBytes + texCoordBytes + indexBytes;
+		const std::string count = std::to_string(vertexCount);
+		std::string json = R"({"asset":{"version":"2.0"},"meshes":[{"primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":3}]}],)" +
+			std::string{ R"("accessors":[{"bufferView":0,"componentType":5126,"count":)" } + count + R"(,"type":"VEC3"},)" +
+			R"({"bufferView":1,"componentType":5126,"count":)" + count + R"(,"type":"VEC3"},)" +
+			R"({"bufferView":2,"componentType":5126,"count":)" + count + R"(,"type":"VEC2"},)" +
+			R"({"bufferView":3,"componentType":5125,"count":)" + std::to_string(indexCount) + R"(,"type":"SCALAR"}],"bufferViews":[)" +
+			R"({"buffer":0,"byteLength":)" + std::to_string(positionBytes) + "}," +
+			R"({"buffer":0,"byteOffset":)" + std::to_string(positionBytes) + R"(,"byteLength":)" + std::to_string(normalBytes) + "}," +
+			R"({"buffer":0,"byteOffset":)" + std::to_string(positionBytes + normalBytes) + R"(,"byteLength":)" + std::to_string(texCoordBytes) + "}," +
+			R"({"buffer":0,"byteOffset":)" + std::to_string(positionBytes + normalBytes + texCoordBytes) + R"(,"byteLength":)" + std::to_string(indexBytes) + "}]," +
+			R"("buffers":[{"byteLength":)" + std::to_string(binarySize) + "}]}";
+		json.resize((json.size() + 3) / 4 * 4, ' ');
+
+		const uint32_t header[5]{ 0x46546C67, 2, static_cast<uint32_t>(20 + json.size() + 8 + binarySize), static_cast<uint32_t>(json.size()), 0x4E4F534A };
+		const uint32_t binaryHeader[2]{ static_cast<uint32_t>(binarySize), 0x004E4942 };
+		std::vector<uint8_t> bytes(header[2]);
+		uint8_t* destination = bytes.data();
+		auto append = [&destination](const void* data, size_t size)
+		{
+			memcpy(destination, data, size);
+			destination += size;
+		};
+		append(header, sizeof(header));
+		append(json.data(), json.size());
+		append(binaryHeader, sizeof(binaryHeader));
+		append(positions.data(), positionBytes);
+		append(normals.data(), normalBytes);
+		append(texCoords.data(), texCoordBytes);
+		append(indices.data(), indexBytes);
+		writeBytes(fileName, bytes.data(), bytes.size());
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "BenchMeshImporter";
+	std::filesystem::create_directories(directory);
+	const std::string objName = (directory / "bench.obj").string();
+	const std::string glbName = (directory / "bench.glb").string();
+
+	std::vector<unsigned int> threadCounts{ 1 };
+	if (workerThreadCount() > 1)
+	{
+		threadCounts.push_back(workerThreadCount());
+	}
+
+	std::printf("%10s %8s %8s %10s %10s %12s\n", "triangles", "format", "threads", "ms", "MB/s", "Mtris/s");
+	for (uint32_t size : { 500u, 1000u, 1500u })
+	{
+		writeObj(objName, size);
+		writeGlb(glbName, size);
+		for (const std::string& fileName : { objName, glbName })
+		{
+			for (unsigned int threads : threadCounts)
+			{
+				setParallelWorkerCount(threads);
+				ImportedMesh mesh;
+				ImportStats stats;
+				const double ms = benchBestMs(2, [&]()
+				{
+					importMesh(fileName, mesh, &stats);
+					benchKeep(mesh.indices[0]);
+				});
+				std::printf("%10zu %8s %8u %10.1f %10.0f %12.2f\n", mesh.indices.size() / 3, fileName == objName ? "obj" : "glb", threads, ms,
+					stats.fileBytes / ms / 1e3, mesh.indices.size() / 3 / ms / 1e3);
+			}
+		}
+	}
+	setParallelWorkerCount(0);
+	std::filesystem::remove_all(directory);
+	return 0;
+}
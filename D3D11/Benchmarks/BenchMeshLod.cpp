@@ -0,0 +1,119 @@
+//Mesh levels of detail: LOD chain build time for a set of height fields one mesh at a time
+//and across workers, and the triangles LodSelector leaves to draw as instances move away
+#include "Bench.h"
+#include "LodSelector.h"
+#include "Parallel.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	//size x size quads over the unit square, height scaled by amplitude
+	//-------------------------------------------------------
+	void makeHeightField(uint32_t size, float amplitude, std::vector<Position>& positions, std::vector<uint32_t>& indices)
+	{
+		const uint32_t row{ size + 1 };
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				float u = static_cast<float>(x) / size;
+				float v = static_cast<float>(y) / size;
+				positions.push_back({ u, v, amplitude * std::sin(u * 9.0f) * std::cos(v * 7.0f) });
+			}
+		}
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const uint32_t i{ y * row + x };
+				const uint32_t quad[6]{ i, i + row, i + row + 1, i, i + row + 1, i + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	const uint32_t meshCount{ 24 };
+	std::vector<std::vector<Position>> positions(meshCount);
+	std::vector<std::vector<uint32_t>> sourceIndices(meshCount);
+	size_t sourceTriangles{ 0 };
+	for (uint32_t i{ 0 }; i < meshCount; i++)
+	{
+		makeHeightField(96 + i * 4, 0.02f + 0.01f * i, positions[i], sourceIndices[i]);
+		sourceTriangles += sourceIndices[i].size() / 3;
+	}
+
+	std::vector<std::vector<uint32_t>> indices(meshCount);
+	std::vector<std::vector<MeshLod>> lods(meshCount);
+	const double serialMs = benchBestMs(3, [&]()
+	{
+		for (uint32_t i{ 0 }; i < meshCount; i++)
+		{
+			indices[i] = sourceIndices[i];
+			lods[i] = buildLodChain(indices[i], positions[i].data(), sizeof(Position), static_cast<uint32_t>(positions[i].size()));
+		}
+	});
+
+	std::vector<LodMesh> meshes(meshCount);
+	const double parallelMs = benchBestMs(3, [&]()
+	{
+		for (uint32_t i{ 0 }; i < meshCount; i++)
+		{
+			indices[i] = sourceIndices[i];
+			meshes[i] = { &indices[i], positions[i].data(), sizeof(Position), static_cast<uint32_t>(positions[i].size()), &lods[i] };
+		}
+		buildLodChains(meshes.data(), meshes.size());
+	});
+	std::printf("%u meshes, %zu triangles: buildLodChain %.1f ms, buildLodChains %.1f ms on %u threads\n\n",
+		meshCount, sourceTriangles, serialMs, parallelMs, workerThreadCount());
+
+	//Instances of the roughest mesh spread along the view axis, 720 pixels high, 45 degree fovY
+	const std::vector<MeshLod>& chain = lods[meshCount - 1];
+	const float radius{ 0.75f };
+	const float proj22 = 1.0f / std::tan(3.14159265f / 8.0f);
+	const uint32_t instanceCount{ 100000 };
+	LodSelector selector;
+	selector.resize(instanceCount);
+	std::vector<uint32_t> instances(instanceCount);
+	std::vector<uint32_t> grouped;
+	std::vector<uint32_t> levelCounts;
+
+	std::printf("%10s %14s %14s %8s\n", "distance", "full tris", "drawn tris", "ratio");
+	for (float distance : { 0.5f, 1.0f, 2.0f, 4.0f, 8.0f })
+	{
+		uint64_t drawn{ 0 };
+		for (uint32_t i{ 0 }; i < instanceCount; i++)
+		{
+			//Spread each band over [distance, 2 * distance)
+			const float depth = distance * (1.0f + static_cast<float>(i) / instanceCount);
+			instances[i] = i;
+			const uint32_t level = selector.select(i, chain, radius, LodSelector::projectedRadius(radius, depth, proj22, 720.0f));
+			drawn += chain[level].indexCount / 3;
+		}
+		const uint64_t full = uint64_t{ chain[0].indexCount / 3 } * instanceCount;
+		std::printf("%10.1f %14llu %14llu %8.3f\n", distance, static_cast<unsigned long long>(full), static_cast<unsigned long long>(drawn),
+			static_cast<double>(drawn) / full);
+	}
+
+	const double selectMs = benchBestMs(5, [&]()
+	{
+		for (uint32_t i{ 0 }; i < instanceCount; i++)
+		{
+			const float depth = 2.0f + 510.0f * static_cast<float>(i) / instanceCount;
+			selector.select(i, chain, radius, LodSelector::projectedRadius(radius, depth, proj22, 720.0f));
+		}
+		selector.groupByLevel(instances, static_cast<uint32_t>(chain.size()), grouped, levelCounts);
+		benchKeep(grouped[0]);
+	});
+	std::printf("\nselect and groupByLevel for %u instances: %.2f ms\n", instanceCount, selectMs);
+	return 0;
+}
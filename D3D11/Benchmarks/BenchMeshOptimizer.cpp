@@ -0,0 +1,101 @@
+//MeshOptimizer passes on shuffled grids of 0.5M to 4.5M triangles, with ACMR and ATVR
+//before and after so the cost can be weighed against the cache gain
+#include "Bench.h"
+#include "MeshOptimizer.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Vertex
+	{
+		float position[3];
+		float normal[3];
+		float texCoords[2];
+	};
+
+	//size x size quads with triangles shuffled, the worst case input order
+	//-------------------------------------------------------
+	void makeShuffledGrid(uint32_t size, std::vector<uint8_t>& vertexBytes, std::vector<uint32_t>& indices)
+	{
+		const uint32_t row{ size + 1 };
+		std::vector<Vertex> vertices(size_t{ row } * row);
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				vertices[size_t{ y } * row + x] = { { static_cast<float>(x), std::sin(x * 0.05f) * std::cos(y * 0.05f) * 10.0f, static_cast<float>(y) },
+					{ 0.0f, 1.0f, 0.0f }, { static_cast<float>(x) / size, static_cast<float>(y) / size } };
+			}
+		}
+
+		std::vector<uint32_t> quads(size_t{ size } * size);
+		for (uint32_t i{ 0 }; i < quads.size(); i++)
+		{
+			quads[i] = i;
+		}
+		std::mt19937 random{ 3 };
+		std::shuffle(quads.begin(), quads.end(), random);
+		indices.clear();
+		indices.reserve(quads.size() * 6);
+		for (uint32_t quad : quads)
+		{
+			const uint32_t i{ quad / size * row + quad % size };
+			const uint32_t corners[6]{ i, i + row, i + row + 1, i, i + row + 1, i + 1 };
+			indices.insert(indices.end(), corners, corners + 6);
+		}
+		vertexBytes.resize(vertices.size() * sizeof(Vertex));
+		memcpy(vertexBytes.data(), vertices.data(), vertexBytes.size());
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	std::printf("%10s %12s %12s %12s %12s %8s %8s %8s %8s\n", "triangles", "cache ms", "overdraw ms", "fetch ms", "mesh ms",
+		"acmr in", "acmr out", "atvr in", "atvr out");
+	for (uint32_t size : { 500u, 1000u, 1500u })
+	{
+		std::vector<uint8_t> vertexBytes;
+		std::vector<uint32_t> indices;
+		makeShuffledGrid(size, vertexBytes, indices);
+		const uint32_t vertexCount = static_cast<uint32_t>(vertexBytes.size() / sizeof(Vertex));
+		const int runs{ 3 };
+
+		std::vector<uint32_t> cacheOrder(indices.size());
+		std::vector<uint32_t> clusters;
+		const double cacheMs = benchBestMs(runs, [&]()
+		{
+			optimizeVertexCache(cacheOrder.data(), indices.data(), indices.size(), vertexCount, 16, &clusters);
+		});
+
+		std::vector<uint32_t> overdrawOrder(indices.size());
+		const double overdrawMs = benchBestMs(runs, [&]()
+		{
+			optimizeOverdraw(overdrawOrder.data(), cacheOrder.data(), cacheOrder.size(), vertexBytes.data(), sizeof(Vertex), vertexCount, clusters);
+		});
+
+		std::vector<uint8_t> fetched(vertexBytes.size());
+		std::vector<uint32_t> fetchIndices;
+		const double fetchMs = benchBestMs(runs, [&]()
+		{
+			fetchIndices = overdrawOrder;
+			optimizeVertexFetch(fetched.data(), fetchIndices.data(), fetchIndices.size(), vertexBytes.data(), vertexCount, sizeof(Vertex));
+		});
+
+		MeshOptimizeReport report;
+		const double meshMs = benchBestMs(runs, [&]()
+		{
+			std::vector<uint8_t> meshVertices = vertexBytes;
+			std::vector<uint32_t> meshIndices = indices;
+			report = optimizeMesh(meshVertices, sizeof(Vertex), 0, meshIndices);
+			benchKeep(meshIndices[0]);
+		});
+
+		std::printf("%10zu %12.1f %12.1f %12.1f %12.1f %8.3f %8.3f %8.3f %8.3f\n", indices.size() / 3, cacheMs, overdrawMs, fetchMs, meshMs,
+			report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+	}
+	return 0;
+}
@@ -0,0 +1,53 @@
+//calculateNormals against calculateNormalsParallel, 10k to 10M triangles
+#include "Bench.h"
+#include "MathHelper.h"
+#include "Vertex.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	//-------------------------------------------------------
+	void buildGrid(uint32_t size, std::vector<VertexNormTex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.assign(size_t{ size } * size, VertexNormTex{});
+		for (uint32_t z{ 0 }; z < size; z++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				vertices[size_t{ z } * size + x].position = XMFLOAT3{ static_cast<float>(x), std::sin(x * 0.3f) * std::cos(z * 0.2f), static_cast<float>(z) };
+			}
+		}
+		indices.clear();
+		indices.reserve(size_t{ size - 1 } * (size - 1) * 6);
+		for (uint32_t z{ 0 }; z + 1 < size; z++)
+		{
+			for (uint32_t x{ 0 }; x + 1 < size; x++)
+			{
+				const uint32_t corner{ z * size + x };
+				indices.insert(indices.end(), { corner, corner + size, corner + 1, corner + 1, corner + size, corner + size + 1 });
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	std::printf("%u hardware threads\n", workerThreadCount());
+	std::printf("%12s %12s %12s %8s\n", "triangles", "serial ms", "parallel ms", "speedup");
+	for (uint32_t size : { 72u, 225u, 708u, 2237u })
+	{
+		std::vector<VertexNormTex> vertices;
+		std::vector<uint32_t> indices;
+		buildGrid(size, vertices, indices);
+		const int vertexCount{ static_cast<int>(vertices.size()) };
+		const int triangleCount{ static_cast<int>(indices.size() / 3) };
+
+		const int runs{ triangleCount > 1000000 ? 3 : 10 };
+		const double serialMs = benchBestMs(runs, [&]() { calculateNormals(vertices.data(), vertexCount, indices.data(), triangleCount); });
+		const double parallelMs = benchBestMs(runs, [&]() { calculateNormalsParallel(vertices.data(), vertexCount, indices.data(), triangleCount); });
+		std::printf("%12d %12.3f %12.3f %7.2fx\n", triangleCount, serialMs, parallelMs, serialMs / parallelMs);
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+//CPU cost of updating and submitting a 100k object scene on the null backend
+//Mirrors the per object path of drawScene: world matrices, sort, one constant ring map
+//for every object, then bind and draw through the StateCache
+#include "Bench.h"
+#include "ConstantRing.h"
+#include "NullRenderDevice.h"
+#include "OpaqueQueue.h"
+#include "ShaderConstants.h"
+#include "StateCache.h"
+#include <cstring>
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	const uint32_t objectCount{ 100000 };
+	const uint32_t materialCount{ 16 };
+
+	NullRenderDevice device;
+	StateCache context{ device.immediateContext() };
+	ConstantUploadRing ring{ device, 1 << 20 };
+
+	const uint32_t indexCount{ 36 };
+	BufferHandle vertexBuffer = device.createBuffer(BufferDesc{ 24 * 32, BufferBinding::Vertex, ResourceUsage::Immutable }, nullptr);
+	BufferHandle indexBuffer = device.createBuffer(BufferDesc{ indexCount * 4, BufferBinding::Index, ResourceUsage::Immutable }, nullptr);
+	std::vector<TextureHandle> textures;
+	const uint8_t pixel[4]{};
+	for (uint32_t i{ 0 }; i < materialCount; i++)
+	{
+		textures.push_back(device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4));
+	}
+	const uint32_t stride{ 32 };
+	const uint32_t offset{ 0 };
+
+	std::vector<XMFLOAT3> positions(objectCount);
+	for (uint32_t i{ 0 }; i < objectCount; i++)
+	{
+		positions[i] = XMFLOAT3{ static_cast<float>(i % 100), static_cast<float>(i / 100 % 100), static_cast<float>(i / 10000) };
+	}
+	XMMATRIX viewProj = XMMatrixTranslation(-50.0f, -50.0f, 10.0f) * XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+
+	OpaqueQueue queue;
+	cbufferPerObject constants;
+	float angle{ 0.0f };
+	auto frame = [&]()
+	{
+		ring.beginFrame();
+		angle += 0.01f;
+
+		queue.clear();
+		for (uint32_t i{ 0 }; i < objectCount; i++)
+		{
+			queue.push(0, 1, i % materialCount, positions[i].z, i);
+		}
+		queue.sort();
+
+		ConstantAllocation allocation;
+		uint8_t* mapped = static_cast<uint8_t*>(ring.map(context, sizeof(cbufferPerObject), objectCount, allocation));
+		for (size_t i{ 0 }; i < queue.size(); i++)
+		{
+			const XMFLOAT3& position = positions[queue[i].drawIndex];
+			XMMATRIX world = XMMatrixRotationQuaternion(XMVectorSet(0.0f, std::sin(angle), 0.0f, std::cos(angle))) * XMMatrixTranslation(position.x, position.y, position.z);
+			constants.world = XMMatrixTranspose(world);
+			constants.worldViewProj = XMMatrixTranspose(world * viewProj);
+			memcpy(mapped + i * allocation.elementSize, &constants, sizeof(cbufferPerObject));
+		}
+		ring.unmap(context);
+
+		for (size_t i{ 0 }; i < queue.size(); i++)
+		{
+			ConstantUploadRing::bind(context, ShaderStage::Vertex, 0, allocation, static_cast<uint32_t>(i));
+			ConstantUploadRing::bind(context, ShaderStage::Pixel, 0, allocation, static_cast<uint32_t>(i));
+			context.setVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+			context.setIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+			context.setTexture(ShaderStage::Pixel, 0, textures[queue[i].drawIndex % materialCount]);
+			context.drawIndexed(indexCount, 0, 0);
+		}
+
+		ring.endFrame();
+		device.present(0);
+	};
+
+	frame();
+	device.nullContext().resetStats();
+	context.resetStats();
+	ring.resetStats();
+	const int frames{ 20 };
+	const double frameMs = benchBestMs(frames, frame);
+
+	const RenderStats& stats = device.nullContext().stats();
+	std::printf("%u objects, best of %d frames\n", objectCount, frames);
+	std::printf("  frame                 %10.3f ms\n", frameMs);
+	std::printf("  draws / frame         %10llu\n", static_cast<unsigned long long>(stats.drawCalls() / frames));
+	std::printf("  context calls / frame %10llu\n", static_cast<unsigned long long>(stats.totalCalls() / frames));
+	std::printf("  calls elided / frame  %10llu\n", static_cast<unsigned long long>(context.stats().elided / frames));
+	//The ring maps with WriteNoOverwrite, which the null context does not count as an upload
+	std::printf("  bytes uploaded / frame%10llu\n", static_cast<unsigned long long>((stats.bytesUploaded + ring.stats().bytesWritten) / frames));
+	return 0;
+}
@@ -0,0 +1,80 @@
+//OpaqueQueue key build plus sort at 100k and 1M draws: push and serial sort against
+//parallel build and sort, and shader / material changes per frame before and after sorting
+#include "Bench.h"
+#include "OpaqueQueue.h"
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct DrawDesc
+	{
+		uint32_t shader;
+		uint32_t material;
+		float viewDepth;
+	};
+
+	//Shader or material changes when draws are submitted in the given order
+	//-------------------------------------------------------
+	template <typename GetDraw>
+	size_t countStateChanges(size_t count, GetDraw&& getDraw)
+	{
+		size_t changes{ 0 };
+		for (size_t i{ 1 }; i < count; i++)
+		{
+			const DrawDesc& a = getDraw(i - 1);
+			const DrawDesc& b = getDraw(i);
+			changes += (a.shader != b.shader ? 1 : 0) + (a.material != b.material ? 1 : 0);
+		}
+		return changes;
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	const uint32_t shaderCount{ 8 };
+	const uint32_t materialCount{ 64 };
+
+	std::printf("%u hardware threads, %u shaders, %u materials\n", workerThreadCount(), shaderCount, materialCount);
+	std::printf("%10s %12s %12s %16s %16s\n", "draws", "serial ms", "parallel ms", "changes before", "changes after");
+	for (size_t count : { size_t{ 100000 }, size_t{ 1000000 } })
+	{
+		std::mt19937 random{ 1 };
+		std::uniform_real_distribution<float> depth{ 0.1f, 1000.0f };
+		std::vector<DrawDesc> descs(count);
+		for (DrawDesc& desc : descs)
+		{
+			desc = { static_cast<uint32_t>(random() % shaderCount), static_cast<uint32_t>(random() % materialCount), depth(random) };
+		}
+
+		//Queue storage is reserved once and reused, as it is across frames
+		OpaqueQueue queue{ count };
+		const int runs{ count >= 1000000 ? 5 : 20 };
+		const double serialMs = benchBestMs(runs, [&]()
+		{
+			queue.clear();
+			for (uint32_t i{ 0 }; i < count; i++)
+			{
+				queue.push(0, descs[i].shader, descs[i].material, descs[i].viewDepth, i);
+			}
+			queue.sort(false);
+			benchKeep(queue[0]);
+		});
+		const double parallelMs = benchBestMs(runs, [&]()
+		{
+			queue.build(count, [&](size_t i)
+			{
+				const DrawDesc& desc = descs[i];
+				return OpaqueDraw{ OpaqueSortKey::make(0, desc.shader, desc.material, desc.viewDepth, 1000.0f), static_cast<uint32_t>(i) };
+			});
+			queue.sort(true);
+			benchKeep(queue[0]);
+		});
+
+		const size_t before = countStateChanges(count, [&](size_t i) -> const DrawDesc& { return descs[i]; });
+		const size_t after = countStateChanges(count, [&](size_t i) -> const DrawDesc& { return descs[queue[i].drawIndex]; });
+		std::printf("%10zu %12.3f %12.3f %16zu %16zu\n", count, serialMs, parallelMs, before, after);
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+//ParallelRecorder::record of a 200k draw scene on the null backend, 1 to 8 threads. Each draw binds
+//its constants, buffers, texture and sampler through the chunk's StateCache like drawObjectIndexed.
+//The longest chunk is the wall time record approaches with enough cores; on fewer cores than
+//threads the total only shows the cost of splitting. Total includes executing the lists
+#include "Bench.h"
+#include "NullRenderDevice.h"
+#include "ParallelRecorder.h"
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	const size_t drawCount{ 200000 };
+	const size_t minDrawsPerChunk{ 1024 };
+
+	NullRenderDevice device;
+	const VertexShaderHandle vertexShader = device.createVertexShader(nullptr, 0);
+	const PixelShaderHandle pixelShader = device.createPixelShader(nullptr, 0);
+	const InputElement elements[]{ { "POSITION", 0, VertexFormat::Float3, 0, 0, false } };
+	const InputLayoutHandle inputLayout = device.createInputLayout(elements, 1, nullptr, 0);
+	const BufferHandle vertexBuffer = device.createBuffer(BufferDesc{ 24 * 32, BufferBinding::Vertex, ResourceUsage::Immutable }, nullptr);
+	const BufferHandle indexBuffer = device.createBuffer(BufferDesc{ 36 * 4, BufferBinding::Index, ResourceUsage::Immutable }, nullptr);
+	const BufferHandle constants = device.createBuffer(BufferDesc{ 16, BufferBinding::Constant, ResourceUsage::Dynamic }, nullptr);
+	const SamplerHandle sampler = device.createSampler(SamplerDesc{});
+	std::vector<TextureHandle> textures;
+	const uint8_t pixel[4]{};
+	for (int i{ 0 }; i < 16; i++)
+	{
+		textures.push_back(device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4));
+	}
+	const uint32_t stride{ 32 };
+	const uint32_t offset{ 0 };
+
+	auto recordDraws = [&](IRenderContext& context, size_t begin, size_t end)
+	{
+		context.setVertexShader(vertexShader);
+		context.setPixelShader(pixelShader);
+		context.setInputLayout(inputLayout);
+		context.setPrimitiveTopology(PrimitiveTopology::TriangleList);
+		context.setConstantBuffer(ShaderStage::Pixel, 1, constants, 0, 16);
+		for (size_t i{ begin }; i < end; i++)
+		{
+			//One 256 byte constant element per draw, sorted by texture like the opaque queue
+			const uint32_t firstConstant = 16 + static_cast<uint32_t>(i) * 16;
+			context.setConstantBuffer(ShaderStage::Vertex, 0, constants, firstConstant, 16);
+			context.setConstantBuffer(ShaderStage::Pixel, 0, constants, firstConstant, 16);
+			context.setVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+			context.setIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+			context.setTexture(ShaderStage::Pixel, 0, textures[i * textures.size() / drawCount]);
+			context.setSampler(ShaderStage::Pixel, 0, sampler);
+			context.drawIndexed(36, 0, 0);
+		}
+	};
+
+	std::printf("%zu draws, at least %zu per chunk\n", drawCount, minDrawsPerChunk);
+	std::printf("%8s %8s %12s %14s %14s %12s\n", "threads", "chunks", "total ms", "longest ms", "chunks sum ms", "execute ms");
+	for (unsigned int threads{ 1 }; threads <= 8; threads++)
+	{
+		ParallelRecorder recorder{ device, threads };
+		double longestMs{ 1e30 };
+		double chunksMs{ 1e30 };
+		double executeMs{ 1e30 };
+		const double totalMs = benchBestMs(10, [&]()
+		{
+			recorder.record(device.immediateContext(), drawCount, minDrawsPerChunk, recordDraws);
+			const ParallelRecordStats& stats = recorder.stats();
+			longestMs = std::min(longestMs, stats.longestChunkNanoseconds / 1e6);
+			chunksMs = std::min(chunksMs, stats.chunkNanoseconds / 1e6);
+			executeMs = std::min(executeMs, stats.executeNanoseconds / 1e6);
+		});
+		std::printf("%8u %8zu %12.3f %14.3f %14.3f %12.3f\n", threads, recorder.stats().chunks, totalMs, longestMs, chunksMs, executeMs);
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+//Opening a shader archive and looking up every shader, against reading one file per shader
+//Shader blobs are written to temporary files of 2 to 8 KB, about the size of the sample's compiled shaders
+#include "Bench.h"
+#include "CpuImage.h"
+#include "ShaderArchive.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "BenchShaderArchive";
+	std::filesystem::create_directories(directory);
+
+	std::printf("%8s %14s %14s %12s\n", "shaders", "archive ms", "files ms", "lookups/ms");
+	for (size_t count : { size_t{ 6 }, size_t{ 64 }, size_t{ 512 } })
+	{
+		ShaderArchiveWriter writer;
+		std::vector<std::string> names;
+		std::vector<std::string> fileNames;
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			names.push_back("shader_" + std::to_string(i));
+			std::vector<uint8_t> bytecode(2000 + (i * 977) % 6000, static_cast<uint8_t>(i));
+			writer.add(names.back(), bytecode.data(), bytecode.size());
+
+			fileNames.push_back((directory / (names.back() + ".cso")).string());
+			std::ofstream file{ fileNames.back(), std::ios::out | std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(bytecode.data()), static_cast<std::streamsize>(bytecode.size()));
+		}
+		const std::string archiveName = (directory / "bench.shar").string();
+		writer.write(archiveName);
+
+		const double archiveMs = benchBestMs(20, [&]()
+		{
+			ShaderArchive archive;
+			archive.open(archiveName);
+			ShaderBytecode bytecode;
+			for (const std::string& name : names)
+			{
+				archive.find(name, bytecode);
+				benchKeep(bytecode);
+			}
+		});
+		const double filesMs = benchBestMs(20, [&]()
+		{
+			std::vector<uint8_t> bytes;
+			for (const std::string& fileName : fileNames)
+			{
+				readFileBytes(fileName, bytes);
+				benchKeep(bytes);
+			}
+		});
+
+		ShaderArchive archive;
+		archive.open(archiveName);
+		const double lookupMs = benchBestMs(20, [&]()
+		{
+			ShaderBytecode bytecode;
+			for (int repeat{ 0 }; repeat < 100; repeat++)
+			{
+				for (const std::string& name : names)
+				{
+					archive.find(name, bytecode);
+				}
+			}
+			benchKeep(bytecode);
+		});
+		std::printf("%8zu %14.3f %14.3f %12.0f\n", count, archiveMs, filesMs, count * 100 / lookupMs);
+	}
+	std::filesystem::remove_all(directory);
+	return 0;
+}
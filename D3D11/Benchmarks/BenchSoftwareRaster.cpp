@@ -0,0 +1,160 @@
+//Software rasterizer throughput at 1280x720: a grid of lit, textured boxes drawn with
+//drawIndexed the way drawObjectIndexed does, reported in triangles and pixels per second
+//for one thread and for every hardware thread
+#include "Bench.h"
+#include "SoftwareRenderDevice.h"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	struct Vertex
+	{
+		XMFLOAT3 position;
+		XMFLOAT3 normal;
+		XMFLOAT2 texCoords;
+	};
+
+	//Unit box with per face normals, clockwise front faces as in the sample's box mesh
+	//-------------------------------------------------------
+	void makeBox(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const XMFLOAT3 normals[6]{ { 0, 0, -1 }, { 0, 0, 1 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+		for (const XMFLOAT3& n : normals)
+		{
+			XMVECTOR normal = XMLoadFloat3(&n);
+			XMVECTOR up = std::fabs(n.y) > 0.5f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+			XMVECTOR right = XMVector3Cross(up, normal);
+			const float corners[4][2]{ { -1, -1 }, { -1, 1 }, { 1, 1 }, { 1, -1 } };
+			uint32_t base = static_cast<uint32_t>(vertices.size());
+			for (const auto& c : corners)
+			{
+				Vertex v;
+				XMStoreFloat3(&v.position, (normal + right * c[0] + up * c[1]) * 0.5f);
+				v.normal = n;
+				v.texCoords = XMFLOAT2{ c[0] * 0.5f + 0.5f, 0.5f - c[1] * 0.5f };
+				vertices.push_back(v);
+			}
+			const uint32_t face[6]{ 0, 1, 2, 0, 2, 3 };
+			for (uint32_t i : face)
+			{
+				indices.push_back(base + i);
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	const uint32_t width{ 1280 };
+	const uint32_t height{ 720 };
+	const int gridSize{ 24 };
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeBox(vertices, indices);
+	const InputElement layoutElements[]
+	{
+		{ "POSITION", 0, VertexFormat::Float3, 0, 0, false },
+		{ "NORMAL", 0, VertexFormat::Float3, 0, 12, false },
+		{ "TEXCOORD", 0, VertexFormat::Float2, 0, 24, false },
+	};
+
+	std::vector<uint8_t> texels(64 * 64 * 4);
+	for (uint32_t i{ 0 }; i < 64 * 64; i++)
+	{
+		const uint8_t value = ((i % 64) / 8 + (i / 64) / 8) % 2 != 0 ? 255 : 96;
+		texels[i * 4] = value;
+		texels[i * 4 + 1] = value;
+		texels[i * 4 + 2] = value;
+		texels[i * 4 + 3] = 255;
+	}
+
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -30.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, static_cast<float>(width) / height, 1.0f, 1000.0f);
+
+	std::printf("%dx%d boxes at %ux%u, best of 10 frames\n", gridSize, gridSize, width, height);
+	std::vector<unsigned int> threadCounts{ 1 };
+	if (workerThreadCount() > 1)
+	{
+		threadCounts.push_back(workerThreadCount());
+	}
+	for (unsigned int threads : threadCounts)
+	{
+		SoftwareRenderDevice device{ threads };
+		device.resize(width, height);
+		IRenderContext& context = device.immediateContext();
+
+		const BufferHandle vertexBuffer = device.createBuffer(BufferDesc{ static_cast<uint32_t>(vertices.size() * sizeof(Vertex)), BufferBinding::Vertex, ResourceUsage::Immutable }, vertices.data());
+		const BufferHandle indexBuffer = device.createBuffer(BufferDesc{ static_cast<uint32_t>(indices.size() * 4), BufferBinding::Index, ResourceUsage::Immutable }, indices.data());
+		const InputLayoutHandle layout = device.createInputLayout(layoutElements, 3, nullptr, 0);
+		const TextureHandle texture = device.createTexture(TextureDesc{ 64, 64, TextureFormat::RGBA8 }, texels.data(), 64 * 4);
+		const SamplerHandle sampler = device.createSampler(SamplerDesc{ TextureFilter::Linear, TextureAddress::Wrap, 1 });
+
+		cbufferPerFrame frame;
+		frame.dirLight.ambientColor = XMFLOAT4{ 0.3f, 0.3f, 0.3f, 1.0f };
+		frame.dirLight.diffuseColor = XMFLOAT4{ 0.8f, 0.8f, 0.8f, 1.0f };
+		frame.dirLight.specColor = XMFLOAT4{ 0.5f, 0.5f, 0.5f, 1.0f };
+		frame.dirLight.lightDir = XMFLOAT3{ 0.3f, 0.5f, -1.0f };
+		frame.viewPos = XMFLOAT4{ 0.0f, 0.0f, -30.0f, 1.0f };
+		const BufferHandle frameBuffer = device.createBuffer(BufferDesc{ sizeof(cbufferPerFrame), BufferBinding::Constant, ResourceUsage::Default }, &frame);
+		const BufferHandle objectBuffer = device.createBuffer(BufferDesc{ sizeof(cbufferPerObject), BufferBinding::Constant, ResourceUsage::Default }, nullptr);
+
+		const uint32_t stride{ sizeof(Vertex) };
+		const uint32_t offset{ 0 };
+		cbufferPerObject object;
+		object.material.ambientColor = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
+		object.material.diffuseColor = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
+		object.material.specColor = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 16.0f };
+		object.texTransformMatrix = XMMatrixIdentity();
+		object.useTexture = 1;
+
+		float angle{ 0.0f };
+		auto renderFrame = [&]()
+		{
+			const float clearColor[4]{ 0.1f, 0.1f, 0.2f, 1.0f };
+			context.clear(clearColor, 1.0f, 0);
+			context.setVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+			context.setIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+			context.setInputLayout(layout);
+			context.setTexture(ShaderStage::Pixel, 0, texture);
+			context.setSampler(ShaderStage::Pixel, 0, sampler);
+			context.setConstantBuffer(ShaderStage::Pixel, 1, frameBuffer, 0, sizeof(cbufferPerFrame) / 16);
+			context.setConstantBuffer(ShaderStage::Vertex, 0, objectBuffer, 0, sizeof(cbufferPerObject) / 16);
+
+			angle += 0.05f;
+			const XMMATRIX rotation = XMMatrixRotationQuaternion(XMVectorSet(0.6f * std::sin(angle), 0.8f * std::sin(angle), 0.0f, std::cos(angle)));
+			for (int y{ 0 }; y < gridSize; y++)
+			{
+				for (int x{ 0 }; x < gridSize; x++)
+				{
+					XMMATRIX world = rotation * XMMatrixTranslation(x - gridSize * 0.5f + 0.5f, y - gridSize * 0.5f + 0.5f, 0.0f);
+					object.world = XMMatrixTranspose(world);
+					object.worldInvTranspose = object.world;	//rigid, normals transform like positions
+					object.worldViewProj = XMMatrixTranspose(world * view * proj);
+					context.updateBuffer(objectBuffer, 0, &object, sizeof(object));
+					context.drawIndexed(static_cast<uint32_t>(indices.size()), 0, 0);
+				}
+			}
+			device.present(0);
+		};
+
+		renderFrame();
+		device.resetRasterStats();
+		const int frames{ 10 };
+		const double frameMs = benchBestMs(frames, renderFrame);
+		const SoftwareRasterStats& stats = device.rasterStats();
+
+		std::printf("%u thread(s)\n", device.threadCount());
+		std::printf("  frame                 %10.3f ms\n", frameMs);
+		std::printf("  setup                 %10.3f ms / frame\n", stats.setupNanoseconds / 1e6 / frames);
+		std::printf("  raster                %10.3f ms / frame\n", stats.rasterNanoseconds / 1e6 / frames);
+		std::printf("  triangles / frame     %10llu rasterized of %llu\n",
+			static_cast<unsigned long long>(stats.trianglesRasterized / frames), static_cast<unsigned long long>(stats.trianglesSubmitted / frames));
+		std::printf("  pixels / frame        %10llu shaded\n", static_cast<unsigned long long>(stats.pixelsShaded / frames));
+		std::printf("  triangles / second    %10.3f M\n", stats.trianglesPerSecond() / 1e6);
+		std::printf("  pixels / second       %10.3f M\n", stats.pixelsPerSecond() / 1e6);
+	}
+	return 0;
+}
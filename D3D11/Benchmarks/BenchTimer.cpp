@@ -0,0 +1,35 @@
+//Per call cost of GameTimer::tick on the steady clock and of FixedTimestep::advance
+#include "Bench.h"
+#include "GameTimer.h"
+
+//-------------------------------------------------------
+int main()
+{
+	const int calls{ 1000000 };
+
+	GameTimer timer;
+	timer.reset();
+	const double tickMs = benchBestMs(5, [&]()
+	{
+		for (int i{ 0 }; i < calls; i++)
+		{
+			timer.tick();
+		}
+		benchKeep(timer.deltaNanoseconds());
+	});
+
+	FixedTimestep timestep{ 60 };
+	uint64_t steps{ 0 };
+	const double advanceMs = benchBestMs(5, [&]()
+	{
+		for (int i{ 0 }; i < calls; i++)
+		{
+			steps += timestep.advance(6944444 + (i & 7));
+		}
+		benchKeep(steps);
+	});
+
+	std::printf("GameTimer::tick          %8.2f ns\n", tickMs * 1e6 / calls);
+	std::printf("FixedTimestep::advance   %8.2f ns\n", advanceMs * 1e6 / calls);
+	return 0;
+}
@@ -0,0 +1,51 @@
+//TransparentQueue push and sort for 1k to 1M draws, serial and parallel radix sort against std::stable_sort
+#include "Bench.h"
+#include "TransparentQueue.h"
+#include <random>
+#include <vector>
+
+//-------------------------------------------------------
+int main()
+{
+	std::printf("%u hardware threads\n", workerThreadCount());
+	std::printf("%10s %12s %12s %14s\n", "draws", "serial ms", "parallel ms", "stable_sort ms");
+	for (size_t count : { size_t{ 1000 }, size_t{ 100000 }, size_t{ 1000000 } })
+	{
+		std::mt19937 random{ 1 };
+		std::uniform_real_distribution<float> distance{ 0.1f, 1000.0f };
+		std::vector<float> distances(count);
+		for (float& value : distances)
+		{
+			value = distance(random);
+		}
+
+		//Queue storage is reserved once and reused, as it is across frames
+		TransparentQueue queue{ count };
+		auto fillAndSort = [&](bool parallel)
+		{
+			queue.clear();
+			for (uint32_t i{ 0 }; i < count; i++)
+			{
+				queue.push(distances[i], i);
+			}
+			queue.sort(parallel);
+			benchKeep(queue[0]);
+		};
+		const int runs{ count >= 1000000 ? 5 : 20 };
+		const double serialMs = benchBestMs(runs, [&]() { fillAndSort(false); });
+		const double parallelMs = benchBestMs(runs, [&]() { fillAndSort(true); });
+
+		std::vector<TransparentDraw> draws(count);
+		const double stableSortMs = benchBestMs(runs, [&]()
+		{
+			for (uint32_t i{ 0 }; i < count; i++)
+			{
+				draws[i] = { ~floatToSortableUint(distances[i]), i };
+			}
+			std::stable_sort(draws.begin(), draws.end(), [](const TransparentDraw& a, const TransparentDraw& b) { return a.key < b.key; });
+			benchKeep(draws[0]);
+		});
+		std::printf("%10zu %12.3f %12.3f %14.3f\n", count, serialMs, parallelMs, stableSortMs);
+	}
+	return 0;
+}
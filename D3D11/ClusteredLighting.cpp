@@ -0,0 +1,379 @@
+#include "ClusteredLighting.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Lights transformed per chunk of the light loop
+	const size_t minLightsPerChunk{ 1024 };
+
+	//---------------------------------------------------------------------------------------------
+	bool sphereOverlapsBox(const XMFLOAT3& center, float radius, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+	{
+		float dx = std::max(std::max(boxMin.x - center.x, 0.0f), center.x - boxMax.x);
+		float dy = std::max(std::max(boxMin.y - center.y, 0.0f), center.y - boxMax.y);
+		float dz = std::max(std::max(boxMin.z - center.z, 0.0f), center.z - boxMax.z);
+		return dx * dx + dy * dy + dz * dz <= radius * radius;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------
+void LightClusterGrid::build(uint32_t tilesX, uint32_t tilesY, uint32_t slices, const XMFLOAT4X4& proj, float nearZ, float farZ)
+{
+	this->tilesX = tilesX;
+	this->tilesY = tilesY;
+	this->slices = slices;
+	this->nearZ = nearZ;
+	this->farZ = farZ;
+	sliceScale = slices / std::log(farZ / nearZ);
+	sidePlanes = { proj._11, proj._22, 1.0f / std::sqrt(proj._11 * proj._11 + 1.0f), 1.0f / std::sqrt(proj._22 * proj._22 + 1.0f) };
+
+	const size_t count = size_t{ tilesX } * tilesY * slices;
+	for (std::vector<float>* values : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ, &centerX, &centerY, &centerZ, &radius })
+	{
+		values->resize(count);
+	}
+	sliceDepths.resize(slices + 1);
+	clusters.assign(count, LightCluster{ 0, 0, 0 });
+
+	//View space x = ndc x * z / _11, so a tile spans [left * z, right * z] / _11 at depth z and its
+	//bounds over a slice are found at the slice's near and far depth
+	const float invX = 1.0f / proj._11;
+	const float invY = 1.0f / proj._22;
+	for (uint32_t k{ 0 }; k < slices; k++)
+	{
+		const float zNear = nearZ * std::pow(farZ / nearZ, static_cast<float>(k) / slices);
+		const float zFar = k + 1 == slices ? farZ : nearZ * std::pow(farZ / nearZ, static_cast<float>(k + 1) / slices);
+		sliceDepths[k] = zNear;
+		sliceDepths[k + 1] = zFar;
+		for (uint32_t j{ 0 }; j < tilesY; j++)
+		{
+			const float top = 1.0f - 2.0f * j / tilesY;
+			const float bottom = 1.0f - 2.0f * (j + 1) / tilesY;
+			const float yMin = std::min(bottom * zNear, bottom * zFar) * invY;
+			const float yMax = std::max(top * zNear, top * zFar) * invY;
+
+			const size_t row = size_t{ k } * tilesY + j;
+			for (uint32_t i{ 0 }; i < tilesX; i++)
+			{
+				const float left = -1.0f + 2.0f * i / tilesX;
+				const float right = -1.0f + 2.0f * (i + 1) / tilesX;
+				const size_t c = row * tilesX + i;
+				minX[c] = std::min(left * zNear, left * zFar) * invX;
+				maxX[c] = std::max(right * zNear, right * zFar) * invX;
+				minY[c] = yMin;
+				maxY[c] = yMax;
+				minZ[c] = zNear;
+				maxZ[c] = zFar;
+
+				centerX[c] = 0.5f * (minX[c] + maxX[c]);
+				centerY[c] = 0.5f * (yMin + yMax);
+				centerZ[c] = 0.5f * (zNear + zFar);
+				const float ex = maxX[c] - minX[c];
+				const float ey = yMax - yMin;
+				const float ez = zFar - zNear;
+				radius[c] = 0.5f * std::sqrt(ex * ex + ey * ey + ez * ez);
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------
+void LightClusterGrid::assign(const XMFLOAT4X4& view, const PointLight* pointLights, size_t pointCount, const SpotLight* spotLights, size_t spotCount)
+{
+	viewLights.resize(pointCount + spotCount);
+	pointLightCount = pointCount;
+	parallelFor(viewLights.size(), minLightsPerChunk, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (i < pointCount)
+			{
+				viewLights[i] = toViewSpace(view, pointLights[i].lightPos, pointLights[i].range);
+				continue;
+			}
+
+			const SpotLight& spot = spotLights[i - pointCount];
+			ViewLight& light = viewLights[i];
+			light = toViewSpace(view, spot.lightPos, spot.range);
+
+			const XMFLOAT3& d = spot.lightDir;
+			float x = d.x * view._11 + d.y * view._21 + d.z * view._31;
+			float y = d.x * view._12 + d.y * view._22 + d.z * view._32;
+			float z = d.x * view._13 + d.y * view._23 + d.z * view._33;
+			float length = std::sqrt(x * x + y * y + z * z);
+			if (spot.spotPower > 0.0f && length > 0.0f)
+			{
+				light.direction = { x / length, y / length, z / length };
+				light.cosAngle = std::pow(spotCutoff, 1.0f / spot.spotPower);
+				light.sinAngle = std::sqrt(std::max(1.0f - light.cosAngle * light.cosAngle, 0.0f));
+			}
+		}
+	});
+
+	//Every chunk owns a range of slices and with it their clusters, so chunks never write
+	//to the same cluster. Their index lists are concatenated in slice order afterwards
+	const size_t numChunks = parallelChunkCount(slices, 1);
+	if (scratch.size() < numChunks)
+	{
+		scratch.resize(numChunks);
+	}
+	for (ChunkScratch& chunk : scratch)
+	{
+		chunk.firstCluster = 0;
+		chunk.endCluster = 0;
+		chunk.indices.clear();
+	}
+	parallelFor(slices, 1, [&](size_t chunk, size_t begin, size_t end)
+	{
+		binSlices(scratch[chunk], static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+	});
+
+	chunkOffsets.assign(numChunks + 1, 0);
+	for (size_t chunk{ 0 }; chunk < numChunks; chunk++)
+	{
+		chunkOffsets[chunk + 1] = chunkOffsets[chunk] + static_cast<uint32_t>(scratch[chunk].indices.size());
+	}
+	indices.resize(chunkOffsets[numChunks]);
+	parallelFor(numChunks, 1, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			const ChunkScratch& part = scratch[chunk];
+			std::copy(part.indices.begin(), part.indices.end(), indices.begin() + chunkOffsets[chunk]);
+			for (uint32_t c = part.firstCluster; c < part.endCluster; c++)
+			{
+				clusters[c].offset += chunkOffsets[chunk];
+			}
+		}
+	});
+}
+
+//---------------------------------------------------------------------------------------------------------------
+ClusterConstants LightClusterGrid::constants(const XMFLOAT4X4& view, float viewportWidth, float viewportHeight) const
+{
+	ClusterConstants constants;
+	constants.viewDepth = { view._13, view._23, view._33, view._43 };
+	constants.clusterScale = { tilesX / viewportWidth, tilesY / viewportHeight, sliceScale, -std::log(nearZ) * sliceScale };
+	constants.tilesX = tilesX;
+	constants.tilesY = tilesY;
+	constants.slices = slices;
+	constants.pad = 0;
+	return constants;
+}
+
+//Position and range in view space, no cone
+//---------------------------------------------------------------------------------------------------------------------------
+LightClusterGrid::ViewLight LightClusterGrid::toViewSpace(const XMFLOAT4X4& view, const XMFLOAT3& position, float range) const
+{
+	const XMFLOAT3& p = position;
+	ViewLight light;
+	light.position.x = p.x * view._11 + p.y * view._21 + p.z * view._31 + view._41;
+	light.position.y = p.x * view._12 + p.y * view._22 + p.z * view._32 + view._42;
+	light.position.z = p.x * view._13 + p.y * view._23 + p.z * view._33 + view._43;
+	light.range = range;
+	light.direction = { 0.0f, 0.0f, 0.0f };
+	light.cosAngle = -1.0f;
+	light.sinAngle = 0.0f;
+
+	//Outside the grid if beyond the near or far plane, or a side plane (x * _11 = +-z, y * _22 = +-z)
+	const float zMin = light.position.z - range;
+	const float zMax = light.position.z + range;
+	const float x = light.position.x * sidePlanes.x;
+	const float y = light.position.y * sidePlanes.y;
+	const float z = light.position.z;
+	const bool outsideSides = (z - std::abs(x)) * sidePlanes.z < -range || (z - std::abs(y)) * sidePlanes.w < -range;
+	if (range <= 0.0f || zMax < nearZ || zMin > farZ || outsideSides)
+	{
+		light.firstSlice = 1;
+		light.lastSlice = 0;
+		return light;
+	}
+	light.firstSlice = sliceOf(zMin);
+	light.lastSlice = sliceOf(zMax);
+	return light;
+}
+
+//Slice holding view space depth viewZ, clamped to the grid
+//-----------------------------------------------------
+uint32_t LightClusterGrid::sliceOf(float viewZ) const
+{
+	if (viewZ <= nearZ)
+	{
+		return 0;
+	}
+	float slice = std::log(viewZ / nearZ) * sliceScale;
+	return std::min<uint32_t>(static_cast<uint32_t>(std::min(slice, static_cast<float>(slices))), slices - 1);
+}
+
+//Tile holding ndc along an axis split into tiles, clamped to the grid
+//------------------------------------------------------------------
+uint32_t LightClusterGrid::tileOf(float ndc, uint32_t tiles) const
+{
+	float tile = (ndc + 1.0f) * 0.5f * tiles;
+	if (tile <= 0.0f)
+	{
+		return 0;
+	}
+	return std::min<uint32_t>(static_cast<uint32_t>(std::min(tile, static_cast<float>(tiles))), tiles - 1);
+}
+
+//Scalar sphere / AABB test and, for spot lights, the cone against the cluster's bounding sphere.
+//The cone test is from "Cull that cone" (Wronski): the sphere is outside if it lies beyond
+//the cone's side, past its range or behind its apex
+//---------------------------------------------------------------------------
+bool LightClusterGrid::overlaps(const ViewLight& light, size_t cluster) const
+{
+	const size_t c = cluster;
+	if (!sphereOverlapsBox(light.position, light.range, { minX[c], minY[c], minZ[c] }, { maxX[c], maxY[c], maxZ[c] }))
+	{
+		return false;
+	}
+	if (light.cosAngle < 0.0f)
+	{
+		return true;
+	}
+
+	const float vx = centerX[c] - light.position.x;
+	const float vy = centerY[c] - light.position.y;
+	const float vz = centerZ[c] - light.position.z;
+	const float lengthSq = vx * vx + vy * vy + vz * vz;
+	const float along = vx * light.direction.x + vy * light.direction.y + vz * light.direction.z;
+	const float closest = light.cosAngle * std::sqrt(std::max(lengthSq - along * along, 0.0f)) - along * light.sinAngle;
+	return closest <= radius[c] && along <= radius[c] + light.range && along >= -radius[c];
+}
+
+//Tests the clusters [firstColumn, endColumn) of a row, 4 at a time, and appends the overlaps.
+//localRow is the row's first cluster relative to the chunk
+//---------------------------------------------------------------------------------------------------------------------------------
+void LightClusterGrid::testRow(const ViewLight& light, uint32_t spot, uint32_t lightIndex, uint32_t row, uint32_t firstColumn, uint32_t endColumn,
+	uint32_t localRow, std::vector<Overlap>& out) const
+{
+	const size_t base = size_t{ row } * tilesX;
+	uint32_t i = firstColumn;
+
+#if defined(_XM_SSE_INTRINSICS_)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 px = _mm_set1_ps(light.position.x);
+	const __m128 py = _mm_set1_ps(light.position.y);
+	const __m128 pz = _mm_set1_ps(light.position.z);
+	const __m128 range = _mm_set1_ps(light.range);
+	const __m128 rangeSq = _mm_set1_ps(light.range * light.range);
+	const __m128 dirX = _mm_set1_ps(light.direction.x);
+	const __m128 dirY = _mm_set1_ps(light.direction.y);
+	const __m128 dirZ = _mm_set1_ps(light.direction.z);
+	const __m128 cosAngle = _mm_set1_ps(light.cosAngle);
+	const __m128 sinAngle = _mm_set1_ps(light.sinAngle);
+	const bool cone = light.cosAngle >= 0.0f;
+
+	for (; i + 4 <= endColumn; i += 4)
+	{
+		const size_t c = base + i;
+
+		//Distance from the light to the box, per axis 0 inside the slab
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[c]), px), _mm_sub_ps(px, _mm_loadu_ps(&maxX[c]))), zero);
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[c]), py), _mm_sub_ps(py, _mm_loadu_ps(&maxY[c]))), zero);
+		__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[c]), pz), _mm_sub_ps(pz, _mm_loadu_ps(&maxZ[c]))), zero);
+		__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 inside = _mm_cmple_ps(distanceSq, rangeSq);
+
+		if (cone && _mm_movemask_ps(inside) != 0)
+		{
+			__m128 r = _mm_loadu_ps(&radius[c]);
+			__m128 vx = _mm_sub_ps(_mm_loadu_ps(&centerX[c]), px);
+			__m128 vy = _mm_sub_ps(_mm_loadu_ps(&centerY[c]), py);
+			__m128 vz = _mm_sub_ps(_mm_loadu_ps(&centerZ[c]), pz);
+			__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+			__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dirX), _mm_mul_ps(vy, dirY)), _mm_mul_ps(vz, dirZ));
+			__m128 side = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSq, _mm_mul_ps(along, along)), zero));
+			__m128 closest = _mm_sub_ps(_mm_mul_ps(cosAngle, side), _mm_mul_ps(along, sinAngle));
+			inside = _mm_and_ps(inside, _mm_cmple_ps(closest, r));
+			inside = _mm_and_ps(inside, _mm_cmple_ps(along, _mm_add_ps(r, range)));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(along, _mm_sub_ps(zero, r)));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (uint32_t lane{ 0 }; lane < 4; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				out.push_back({ (localRow + i + lane) * 2 + spot, lightIndex });
+			}
+		}
+	}
+#endif
+	for (; i < endColumn; i++)
+	{
+		if (overlaps(light, base + i))
+		{
+			out.push_back({ (localRow + i) * 2 + spot, lightIndex });
+		}
+	}
+}
+
+//Bins every light into the clusters of slices [firstSlice, endSlice), then sorts the
+//overlaps by cluster with a counting sort. Light order is kept, points before spots
+//---------------------------------------------------------------------------------------------
+void LightClusterGrid::binSlices(ChunkScratch& chunk, uint32_t firstSlice, uint32_t endSlice)
+{
+	const uint32_t clustersPerSlice = tilesX * tilesY;
+	chunk.firstCluster = firstSlice * clustersPerSlice;
+	chunk.endCluster = endSlice * clustersPerSlice;
+	chunk.overlaps.clear();
+
+	for (size_t l{ 0 }; l < viewLights.size(); l++)
+	{
+		const ViewLight& light = viewLights[l];
+		const uint32_t first = std::max(light.firstSlice, firstSlice);
+		const uint32_t last = std::min(light.lastSlice, endSlice - 1);
+		const uint32_t spot = l < pointLightCount ? 0 : 1;
+		const uint32_t lightIndex = static_cast<uint32_t>(spot ? l - pointLightCount : l);
+		for (uint32_t k = first; k <= last && first <= last; k++)
+		{
+			//Tiles the light's bounding box covers over the part of the slice it spans. Its ndc
+			//x range is widest at the near end for negative x and at the far end for positive x
+			const XMFLOAT3& p = light.position;
+			const float zNear = std::max(sliceDepths[k], p.z - light.range);
+			const float zFar = std::min(sliceDepths[k + 1], p.z + light.range);
+			const float left = p.x - light.range;
+			const float right = p.x + light.range;
+			const float bottom = p.y - light.range;
+			const float top = p.y + light.range;
+			const uint32_t firstColumn = tileOf((left < 0.0f ? left / zNear : left / zFar) * sidePlanes.x, tilesX);
+			const uint32_t lastColumn = tileOf((right < 0.0f ? right / zFar : right / zNear) * sidePlanes.x, tilesX);
+			const uint32_t firstRow = tilesY - 1 - tileOf((top < 0.0f ? top / zFar : top / zNear) * sidePlanes.y, tilesY);
+			const uint32_t lastRow = tilesY - 1 - tileOf((bottom < 0.0f ? bottom / zNear : bottom / zFar) * sidePlanes.y, tilesY);
+
+			for (uint32_t j = firstRow; j <= lastRow; j++)
+			{
+				testRow(light, spot, lightIndex, k * tilesY + j, firstColumn, lastColumn + 1, (k - firstSlice) * clustersPerSlice + j * tilesX, chunk.overlaps);
+			}
+		}
+	}
+
+	//Cluster ranges with offsets local to the chunk, then the indices in cluster order
+	const uint32_t localClusters = chunk.endCluster - chunk.firstCluster;
+	std::vector<uint32_t>& counts = chunk.counts;
+	counts.assign(size_t{ localClusters } * 2, 0);
+	for (const Overlap& overlap : chunk.overlaps)
+	{
+		counts[overlap.key]++;
+	}
+
+	uint32_t offset{ 0 };
+	for (uint32_t c{ 0 }; c < localClusters; c++)
+	{
+		LightCluster& cluster = clusters[chunk.firstCluster + c];
+		cluster = { offset, counts[c * 2], counts[c * 2 + 1] };
+		counts[c * 2] = offset;
+		counts[c * 2 + 1] = offset + cluster.pointCount;
+		offset += cluster.pointCount + cluster.spotCount;
+	}
+
+	chunk.indices.resize(offset);
+	for (const Overlap& overlap : chunk.overlaps)
+	{
+		chunk.indices[counts[overlap.key]++] = overlap.light;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "ShaderConstants.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Lights of one cluster: pointCount point light indices starting at offset in the index
+//list, then spotCount spot light indices. Read by Box.hlsl as StructuredBuffer<LightCluster>
+struct LightCluster
+{
+	uint32_t offset;
+	uint32_t pointCount;
+	uint32_t spotCount;
+};
+
+static_assert(sizeof(LightCluster) == 12, "LightCluster is read by Box.hlsl");
+
+//Point and spot lights binned into a 3D grid of clusters over the view frustum
+//The screen is split into tilesX * tilesY tiles, rows counted from the top like pixels,
+//and depth into slices spaced exponentially between the near and far plane. Each cluster
+//is bounded by a view space AABB; a point light goes into every cluster its range sphere
+//touches, a spot light into those that also touch its cone. Both tests are conservative.
+//Cluster index = (slice * tilesY + row) * tilesX + column
+class LightClusterGrid
+{
+public:
+
+	//Spot lights have no hard edge in Box.hlsl, the cone is cut where pow(cos, spotPower) drops below this
+	static constexpr float spotCutoff{ 1.0f / 256.0f };
+
+	//Cluster bounds for a symmetric perspective projection (XMMatrixPerspectiveFovLH),
+	//only _11 and _22 of proj are used. Call again when the projection changes
+	void build(uint32_t tilesX, uint32_t tilesY, uint32_t slices, const XMFLOAT4X4& proj, float nearZ, float farZ);
+
+	//Bins world space lights with the view matrix of the frame, on worker threads. Indices
+	//refer to the given arrays, in ascending order within a cluster
+	void assign(const XMFLOAT4X4& view, const PointLight* pointLights, size_t pointCount, const SpotLight* spotLights, size_t spotCount);
+
+	//Shader constants for a viewport of width * height pixels
+	ClusterConstants constants(const XMFLOAT4X4& view, float viewportWidth, float viewportHeight) const;
+
+	uint32_t clusterCount() const { return static_cast<uint32_t>(clusters.size()); }
+	const std::vector<LightCluster>& lightClusters() const { return clusters; }
+	const std::vector<uint32_t>& lightIndices() const { return indices; }
+
+private:
+
+	//A light in view space with its slice range, spot lights add their cone
+	struct ViewLight
+	{
+		XMFLOAT3 position;
+		float range;
+		XMFLOAT3 direction;
+		float cosAngle;
+		float sinAngle;
+		uint32_t firstSlice;
+		uint32_t lastSlice;		//firstSlice > lastSlice if the light is outside the grid
+	};
+
+	//One cluster / light overlap, key = local cluster * 2 + 1 for spot lights
+	struct Overlap
+	{
+		uint32_t key;
+		uint32_t light;
+	};
+
+	//Overlaps found by one chunk of slices and their cluster ordered light indices
+	struct ChunkScratch
+	{
+		uint32_t firstCluster{ 0 };
+		uint32_t endCluster{ 0 };
+		std::vector<Overlap> overlaps;
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> indices;
+	};
+
+	ViewLight toViewSpace(const XMFLOAT4X4& view, const XMFLOAT3& position, float range) const;
+	uint32_t sliceOf(float viewZ) const;
+	uint32_t tileOf(float ndc, uint32_t tiles) const;
+	bool overlaps(const ViewLight& light, size_t cluster) const;
+	void testRow(const ViewLight& light, uint32_t spot, uint32_t lightIndex, uint32_t row, uint32_t firstColumn, uint32_t endColumn,
+		uint32_t localRow, std::vector<Overlap>& out) const;
+	void binSlices(ChunkScratch& chunk, uint32_t firstSlice, uint32_t endSlice);
+
+	uint32_t tilesX{ 0 };
+	uint32_t tilesY{ 0 };
+	uint32_t slices{ 0 };
+	float nearZ{ 0.0f };
+	float farZ{ 0.0f };
+	float sliceScale{ 0.0f };	//slices / log(farZ / nearZ)
+	XMFLOAT4 sidePlanes{};		//x and y scale of the projection, normalized so the frustum side planes are unit length
+
+	//Cluster bounds as structure of arrays, rows of tilesX clusters are contiguous
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	//Bounding spheres of the clusters for the cone test
+	std::vector<float> centerX, centerY, centerZ, radius;
+	//Depth where each slice starts, then farZ
+	std::vector<float> sliceDepths;
+
+	std::vector<ViewLight> viewLights;		//point lights, then spot lights
+	size_t pointLightCount{ 0 };
+	std::vector<ChunkScratch> scratch;
+	std::vector<uint32_t> chunkOffsets;	//start of each chunk's indices, kept to avoid a per frame allocation
+	std::vector<LightCluster> clusters;
+	std::vector<uint32_t> indices;
+};
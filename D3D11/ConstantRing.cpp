@@ -0,0 +1,200 @@
+#include "ConstantRing.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+//---------------------------------------------------------------------
+ConstantRingAllocator::ConstantRingAllocator(uint32_t capacity) :
+	ringCapacity{ capacity & ~(alignment - 1) }
+{}
+
+//------------------------------------------------------
+uint32_t ConstantRingAllocator::allocate(uint32_t size)
+{
+	uint32_t aligned = alignedSize(size);
+	if (aligned == 0 || aligned > ringCapacity)
+	{
+		return invalidOffset;
+	}
+	if (usedBytes == 0)
+	{
+		head = 0;
+	}
+
+	//Skip the tail of the ring when the allocation would straddle the end
+	uint32_t padding = head + aligned > ringCapacity ? ringCapacity - head : 0;
+	if (usedBytes + padding + aligned > ringCapacity)
+	{
+		return invalidOffset;
+	}
+
+	if (padding != 0)
+	{
+		head = 0;
+	}
+	uint32_t offset = head;
+	head = (head + aligned) % ringCapacity;
+	usedBytes += padding + aligned;
+	frameBytes += padding + aligned;
+	return offset;
+}
+
+//----------------------------------------------------
+void ConstantRingAllocator::endFrame(uint64_t fence)
+{
+	if (frameBytes != 0)
+	{
+		frames.push_back({ fence, frameBytes });
+		frameBytes = 0;
+	}
+}
+
+//--------------------------------------------------------------
+void ConstantRingAllocator::release(uint64_t completedFence)
+{
+	while (!frames.empty() && frames.front().fence <= completedFence)
+	{
+		usedBytes -= frames.front().bytes;
+		frames.pop_front();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+ConstantUploadRing::ConstantUploadRing(IRenderDevice& device, uint32_t capacity) :
+	device{ device }, allocator{ ConstantRingAllocator::alignedSize(capacity) }
+{
+	BufferDesc desc{ allocator.capacity(), BufferBinding::Constant, ResourceUsage::Dynamic };
+	buffer = device.createBuffer(desc, nullptr);
+}
+
+//------------------------------------------
+ConstantUploadRing::~ConstantUploadRing()
+{
+	device.destroyBuffer(buffer);
+	for (const RetiredBuffer& old : retired)
+	{
+		device.destroyBuffer(old.buffer);
+	}
+}
+
+//----------------------------------
+void ConstantUploadRing::beginFrame()
+{
+	uint64_t completed = device.completedFrames();
+	allocator.release(completed);
+
+	auto done = [completed](const RetiredBuffer& old) { return old.fence <= completed; };
+	for (const RetiredBuffer& old : retired)
+	{
+		if (done(old))
+		{
+			device.destroyBuffer(old.buffer);
+		}
+	}
+	retired.erase(std::remove_if(retired.begin(), retired.end(), done), retired.end());
+}
+
+//--------------------------------
+void ConstantUploadRing::endFrame()
+{
+	//The frame being recorded ends at the next present
+	allocator.endFrame(device.presentedFrames() + 1);
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+void* ConstantUploadRing::map(IRenderContext& context, uint32_t elementSize, uint32_t count, ConstantAllocation& allocation)
+{
+	assert(!mapped && !mappedEmpty);
+
+	//Nothing to write: no space, no fence wait and no map of the buffer
+	if (elementSize == 0 || count == 0)
+	{
+		allocation = ConstantAllocation{};
+		mappedEmpty = true;
+		return nullptr;
+	}
+
+	allocation.elementSize = ConstantRingAllocator::alignedSize(elementSize);
+	allocation.size = allocation.elementSize * count;
+	allocation.offset = allocate(allocation.size);
+	allocation.buffer = buffer;
+
+	uint8_t* data = static_cast<uint8_t*>(context.mapBuffer(buffer, discarded ? MapMode::WriteNoOverwrite : MapMode::WriteDiscard));
+	discarded = true;
+	mapped = true;
+
+	ringStats.bytesWritten += uint64_t{ elementSize } * count;
+	ringStats.allocations += count;
+	ringStats.maps++;
+	return data + allocation.offset;
+}
+
+//----------------------------------------------------
+void ConstantUploadRing::unmap(IRenderContext& context)
+{
+	assert(mapped || mappedEmpty);
+	if (mapped)
+	{
+		context.unmapBuffer(buffer);
+	}
+	mapped = false;
+	mappedEmpty = false;
+}
+
+//----------------------------------------------------------------------------------------------------
+ConstantAllocation ConstantUploadRing::upload(IRenderContext& context, const void* data, uint32_t size)
+{
+	ConstantAllocation allocation;
+	void* mapped = map(context, size, 1, allocation);
+	if (mapped != nullptr)
+	{
+		memcpy(mapped, data, size);
+	}
+	unmap(context);
+	return allocation;
+}
+
+//Waits for the GPU while older frames hold the space, grows when the current frame alone fills the ring
+//------------------------------------------------------
+uint32_t ConstantUploadRing::allocate(uint32_t size)
+{
+	uint32_t offset = allocator.allocate(size);
+	if (offset != ConstantRingAllocator::invalidOffset)
+	{
+		return offset;
+	}
+
+	if (allocator.hasFramesInFlight())
+	{
+		ringStats.fenceWaits++;
+		do
+		{
+			std::this_thread::yield();
+			allocator.release(device.completedFrames());
+			offset = allocator.allocate(size);
+		} while (offset == ConstantRingAllocator::invalidOffset && allocator.hasFramesInFlight());
+
+		if (offset != ConstantRingAllocator::invalidOffset)
+		{
+			return offset;
+		}
+	}
+
+	grow(size);
+	return allocator.allocate(size);
+}
+
+//--------------------------------------------------
+void ConstantUploadRing::grow(uint32_t minCapacity)
+{
+	//Draws of this frame and of frames still in flight may read the old buffer
+	retired.push_back({ buffer, device.presentedFrames() + 1 });
+
+	uint32_t capacity = std::max(allocator.capacity() * 2, ConstantRingAllocator::alignedSize(minCapacity));
+	allocator = ConstantRingAllocator{ capacity };
+	BufferDesc desc{ capacity, BufferBinding::Constant, ResourceUsage::Dynamic };
+	buffer = device.createBuffer(desc, nullptr);
+	discarded = false;
+	ringStats.grows++;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include "RenderDevice.h"
+#include <deque>
+
+//Bookkeeping of a ring of constant data, no API calls so it can be driven by tests
+//Allocations are aligned to 256 bytes (D3D11.1 constant buffer offsets are multiples of
+//16 constants). Everything allocated before endFrame(fence) belongs to that fence and is
+//only handed out again once release is called with a completed fence >= it.
+//An allocation never straddles the end of the ring, the tail is skipped instead
+class ConstantRingAllocator
+{
+public:
+
+	static constexpr uint32_t alignment{ 256 };
+	static constexpr uint32_t invalidOffset{ 0xffffffff };
+
+	explicit ConstantRingAllocator(uint32_t capacity);
+
+	//Offset of size bytes rounded up to the alignment, invalidOffset when there is no room
+	uint32_t allocate(uint32_t size);
+
+	//Closes the current frame; its allocations stay in use until fence completes
+	void endFrame(uint64_t fence);
+
+	//Frees every closed frame whose fence is <= completedFence
+	void release(uint64_t completedFence);
+
+	//Frames closed by endFrame that have not been released
+	bool hasFramesInFlight() const { return !frames.empty(); }
+
+	uint32_t capacity() const { return ringCapacity; }
+	uint32_t bytesInUse() const { return usedBytes; }
+
+	static uint32_t alignedSize(uint32_t size) { return (size + alignment - 1) & ~(alignment - 1); }
+
+private:
+
+	struct FrameRange
+	{
+		uint64_t fence;
+		uint32_t bytes;
+	};
+
+	uint32_t ringCapacity;
+	uint32_t head{ 0 };			//next free byte, the oldest used byte is head - usedBytes
+	uint32_t usedBytes{ 0 };
+	uint32_t frameBytes{ 0 };	//allocated since the last endFrame, padding included
+	std::deque<FrameRange> frames;
+};
+
+//Sub-range of the ring's constant buffer, bound with setConstantBuffer(..., firstConstant, numConstants)
+struct ConstantAllocation
+{
+	BufferHandle buffer;
+	uint32_t offset{ 0 };
+	uint32_t size{ 0 };			//aligned
+	uint32_t elementSize{ 0 };	//aligned stride between elements of a batched allocation
+
+	uint32_t firstConstant(uint32_t element = 0) const { return (offset + element * elementSize) / 16; }
+	uint32_t numConstants() const { return elementSize / 16; }
+};
+
+//Upload counters since the last resetStats
+struct ConstantRingStats
+{
+	uint64_t bytesWritten{ 0 };	//unaligned sizes passed to map / upload
+	uint64_t allocations{ 0 };
+	uint64_t maps{ 0 };
+	uint64_t fenceWaits{ 0 };	//allocations that had to wait for the GPU to finish a frame
+	uint64_t grows{ 0 };
+};
+
+//Per frame constant data in one large dynamic constant buffer, replacing an
+//UpdateSubresource or Map(DISCARD) of a small buffer per draw.
+//Space is mapped with WriteNoOverwrite and bound by offset, so the driver neither
+//copies nor renames the buffer. Frames are fenced with the device's frame fences:
+//call beginFrame before the first allocation and endFrame just before present.
+//When the ring is full the allocation waits for the oldest frame; if the current frame
+//alone does not fit, the ring moves to a buffer twice the size and the old one is
+//destroyed once the frames using it have completed.
+//Needs constant buffer offsets (D3D 11.1) and NO_OVERWRITE maps of constant buffers
+class ConstantUploadRing
+{
+public:
+
+	ConstantUploadRing(IRenderDevice& device, uint32_t capacity);
+	~ConstantUploadRing();
+
+	ConstantUploadRing(const ConstantUploadRing&) = delete;
+	ConstantUploadRing& operator=(const ConstantUploadRing&) = delete;
+
+	void beginFrame();
+	void endFrame();
+
+	//Maps count elements of elementSize bytes, each starting on a 256 byte boundary.
+	//Element i is written at (uint8_t*)result + i * allocation.elementSize; unmap before drawing.
+	//An empty request returns nullptr and an empty allocation without touching the ring
+	void* map(IRenderContext& context, uint32_t elementSize, uint32_t count, ConstantAllocation& allocation);
+	void unmap(IRenderContext& context);
+
+	//map + memcpy + unmap of a single element
+	ConstantAllocation upload(IRenderContext& context, const void* data, uint32_t size);
+
+	//Binds element of an allocation
+	static void bind(IRenderContext& context, ShaderStage stage, uint32_t slot, const ConstantAllocation& allocation, uint32_t element = 0)
+	{
+		context.setConstantBuffer(stage, slot, allocation.buffer, allocation.firstConstant(element), allocation.numConstants());
+	}
+
+	uint32_t capacity() const { return allocator.capacity(); }
+	const ConstantRingStats& stats() const { return ringStats; }
+	void resetStats() { ringStats = ConstantRingStats{}; }
+
+private:
+
+	struct RetiredBuffer
+	{
+		BufferHandle buffer;
+		uint64_t fence;
+	};
+
+	uint32_t allocate(uint32_t size);
+	void grow(uint32_t minCapacity);
+
+	IRenderDevice& device;
+	ConstantRingAllocator allocator;
+	BufferHandle buffer;
+	bool mapped{ false };
+	bool mappedEmpty{ false };	//an empty map is outstanding, unmap has nothing to do
+	bool discarded{ false };	//the first map of a new buffer discards, later ones do not overwrite
+	std::vector<RetiredBuffer> retired;
+	ConstantRingStats ringStats;
+};
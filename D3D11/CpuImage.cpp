@@ -0,0 +1,173 @@
+#include "CpuImage.h"
+#include <fstream>
+
+namespace
+{
+	//----------------------------------------------------
+	uint16_t readU16(const uint8_t* data)
+	{
+		return static_cast<uint16_t>(data[0] | (data[1] << 8));
+	}
+
+	//----------------------------------------------------
+	uint32_t readU32(const uint8_t* data)
+	{
+		return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+	}
+
+	//Byte of a little endian pixel a channel mask selects, -1 unless the mask is exactly one whole byte
+	//---------------------------------------------------
+	int maskByte(uint32_t mask)
+	{
+		for (int byte{ 0 }; byte < 4; byte++)
+		{
+			if (mask == 0xFFu << (byte * 8))
+			{
+				return byte;
+			}
+		}
+		return -1;
+	}
+}
+
+//----------------------------------------------------------------------------
+bool readFileBytes(const std::string& fileName, std::vector<uint8_t>& bytes)
+{
+	std::ifstream file{ fileName, std::ios::in | std::ios::binary };
+	if (!file)
+	{
+		return false;
+	}
+	file.seekg(0, std::ios::end);
+	std::streamoff sizeInBytes = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	bytes.resize(static_cast<size_t>(sizeInBytes));
+	file.read(reinterpret_cast<char*>(bytes.data()), sizeInBytes);
+	return static_cast<bool>(file);
+}
+
+//BITMAPFILEHEADER (14 bytes) followed by a BITMAPINFOHEADER or later version
+//-------------------------------------------------------------------------------
+bool decodeBmp(const uint8_t* data, size_t size, CpuImage& image)
+{
+	const size_t fileHeaderSize{ 14 };
+	if (size < fileHeaderSize + 40 || data[0] != 'B' || data[1] != 'M')
+	{
+		return false;
+	}
+
+	uint32_t pixelOffset = readU32(data + 10);
+	const uint8_t* info = data + fileHeaderSize;
+	uint32_t infoSize = readU32(info);
+	int32_t width = static_cast<int32_t>(readU32(info + 4));
+	int32_t height = static_cast<int32_t>(readU32(info + 8));
+	uint16_t bitsPerPixel = readU16(info + 14);
+	uint32_t compression = readU32(info + 16);
+
+	//BI_RGB at 24 or 32 bit, or BI_BITFIELDS at 32 bit
+	const uint32_t biRgb{ 0 };
+	const uint32_t biBitfields{ 3 };
+	if ((bitsPerPixel != 24 && bitsPerPixel != 32) || (compression != biRgb && compression != biBitfields) ||
+		(compression == biBitfields && bitsPerPixel != 32) || infoSize < 40 || width <= 0 || height == 0)
+	{
+		return false;
+	}
+
+	//Byte offsets of red, green, blue and alpha within a pixel; BI_RGB is BGR(A)
+	//A negative alpha offset means the pixel has no alpha and is opaque
+	int channelBytes[4]{ 2, 1, 0, bitsPerPixel == 32 ? 3 : -1 };
+	if (compression == biBitfields)
+	{
+		//The RGB masks follow a BITMAPINFOHEADER and sit at the same place inside later headers,
+		//which also add an alpha mask. Only masks that select whole, distinct bytes are supported
+		if (size < fileHeaderSize + 40 + 12)
+		{
+			return false;
+		}
+		const uint32_t alphaMask = infoSize >= 56 && size >= fileHeaderSize + 56 ? readU32(info + 52) : 0;
+		for (int channel{ 0 }; channel < 3; channel++)
+		{
+			channelBytes[channel] = maskByte(readU32(info + 40 + channel * 4));
+		}
+		channelBytes[3] = alphaMask != 0 ? maskByte(alphaMask) : -1;
+
+		uint32_t usedBytes{ 0 };
+		for (int channel{ 0 }; channel < 4; channel++)
+		{
+			if (channelBytes[channel] < 0)
+			{
+				if (channel < 3 || alphaMask != 0)
+				{
+					return false;
+				}
+				continue;
+			}
+			const uint32_t bit{ 1u << channelBytes[channel] };
+			if (usedBytes & bit)
+			{
+				return false;
+			}
+			usedBytes |= bit;
+		}
+	}
+
+	//Positive height means rows are stored bottom up
+	bool bottomUp = height > 0;
+	uint32_t rows = static_cast<uint32_t>(bottomUp ? height : -height);
+	uint32_t bytesPerPixel = bitsPerPixel / 8;
+	size_t srcPitch = (static_cast<size_t>(width) * bytesPerPixel + 3) & ~size_t{ 3 };
+	if (pixelOffset > size || srcPitch * rows > size - pixelOffset)
+	{
+		return false;
+	}
+
+	image.width = static_cast<uint32_t>(width);
+	image.height = rows;
+	image.pixels.resize(image.rowPitch() * rows);
+
+	for (uint32_t y{ 0 }; y < rows; y++)
+	{
+		const uint8_t* src = data + pixelOffset + srcPitch * (bottomUp ? rows - 1 - y : y);
+		uint8_t* dst = image.pixels.data() + image.rowPitch() * y;
+		for (int32_t x{ 0 }; x < width; x++)
+		{
+			dst[0] = src[channelBytes[0]];
+			dst[1] = src[channelBytes[1]];
+			dst[2] = src[channelBytes[2]];
+			dst[3] = channelBytes[3] >= 0 ? src[channelBytes[3]] : 255;
+			src += bytesPerPixel;
+			dst += 4;
+		}
+	}
+
+	//32 bit bitmaps commonly leave alpha at zero, treat that as opaque
+	if (channelBytes[3] >= 0)
+	{
+		bool anyAlpha{ false };
+		for (size_t i{ 3 }; i < image.pixels.size() && !anyAlpha; i += 4)
+		{
+			anyAlpha = image.pixels[i] != 0;
+		}
+		if (!anyAlpha)
+		{
+			for (size_t i{ 3 }; i < image.pixels.size(); i += 4)
+			{
+				image.pixels[i] = 255;
+			}
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------
+bool loadBmpFile(const std::string& fileName, CpuImage& image)
+{
+	std::vector<uint8_t> bytes;
+	if (!readFileBytes(fileName, bytes))
+	{
+		return false;
+	}
+	return decodeBmp(bytes.data(), bytes.size(), image);
+}
\ No newline at end of file
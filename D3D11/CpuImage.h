@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Decoded image in system memory, always 8 bit RGBA rows top to bottom
+struct CpuImage
+{
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	std::vector<uint8_t> pixels;
+
+	size_t rowPitch() const { return static_cast<size_t>(width) * 4; }
+	size_t sizeInBytes() const { return pixels.size(); }
+};
+
+//Uncompressed 24 and 32 bit BMP decoding, returns false on unsupported or corrupt data
+//32 bit BI_BITFIELDS images are accepted when every channel mask selects one whole byte
+bool decodeBmp(const uint8_t* data, size_t size, CpuImage& image);
+bool loadBmpFile(const std::string& fileName, CpuImage& image);
+
+//Reads a whole file into memory, returns false if it cannot be opened
+bool readFileBytes(const std::string& fileName, std::vector<uint8_t>& bytes);
\ No newline at end of file
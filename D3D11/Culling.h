@@ -0,0 +1,219 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DirectX;
+
+//Local space bounds of a mesh
+struct Bounds
+{
+	XMFLOAT3 aabbMin{ 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 aabbMax{ 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 center{ 0.0f, 0.0f, 0.0f };
+	float radius{ 0.0f };
+};
+
+//View frustum as 6 normalized planes (ax + by + cz + d), normals point inwards
+//Order : left, right, bottom, top, near, far
+struct Frustum
+{
+	XMFLOAT4 planes[6];
+};
+
+//Extracts the frustum planes from a row vector view * proj matrix (Gribb/Hartmann)
+//Near uses column 2 alone as D3D clip space depth is [0, w]
+//---------------------------------------------------------------
+inline Frustum extractFrustumPlanes(FXMMATRIX viewProj)
+{
+	XMMATRIX columns = XMMatrixTranspose(viewProj);
+	XMVECTOR planes[6]
+	{
+		columns.r[3] + columns.r[0],
+		columns.r[3] - columns.r[0],
+		columns.r[3] + columns.r[1],
+		columns.r[3] - columns.r[1],
+		columns.r[2],
+		columns.r[3] - columns.r[2]
+	};
+
+	Frustum frustum;
+	for (int i{ 0 }; i < 6; i++)
+	{
+		XMStoreFloat4(&frustum.planes[i], XMPlaneNormalize(planes[i]));
+	}
+	return frustum;
+}
+
+//Conservative AABB test, the box is culled only if it is fully outside one plane
+//----------------------------------------------------------------------------------------
+inline bool aabbInFrustum(const Frustum& frustum, const XMFLOAT3& aabbMin, const XMFLOAT3& aabbMax)
+{
+	for (const XMFLOAT4& plane : frustum.planes)
+	{
+		//Corner furthest along the plane normal
+		float x = plane.x >= 0.0f ? aabbMax.x : aabbMin.x;
+		float y = plane.y >= 0.0f ? aabbMax.y : aabbMin.y;
+		float z = plane.z >= 0.0f ? aabbMax.z : aabbMin.z;
+		if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//World space bounding spheres stored as structure of arrays for SIMD culling
+class SphereBoundsSoA
+{
+public:
+
+	//----------------------------
+	void resize(size_t count)
+	{
+		centerX.resize(count);
+		centerY.resize(count);
+		centerZ.resize(count);
+		radius.resize(count);
+	}
+
+	//-----------------------------------------------------------------
+	void set(size_t i, const XMFLOAT3& center, float sphereRadius)
+	{
+		centerX[i] = center.x;
+		centerY[i] = center.y;
+		centerZ[i] = center.z;
+		radius[i] = sphereRadius;
+	}
+
+	//Instance placed with a pure translation
+	//----------------------------------------------------------------------------
+	void setTranslated(size_t i, const Bounds& bounds, const XMFLOAT3& translation)
+	{
+		set(i, { bounds.center.x + translation.x, bounds.center.y + translation.y, bounds.center.z + translation.z }, bounds.radius);
+	}
+
+	size_t size() const { return radius.size(); }
+
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+};
+
+//Tests every sphere against the frustum, 8 (AVX) or 4 (SSE) spheres at a time, and
+//writes the indices of the visible ones to the front of visible in ascending order.
+//Returns the visible count; only that many entries are valid. visible is grown to hold
+//every sphere when it is smaller and never shrunk, so it is only written, not cleared,
+//once it has reached the sphere count
+//-----------------------------------------------------------------------------------------------
+inline size_t cullSpheres(const Frustum& frustum, const SphereBoundsSoA& spheres, std::vector<uint32_t>& visible)
+{
+	const size_t count = spheres.size();
+	if (visible.size() < count)
+	{
+		visible.resize(count);
+	}
+	uint32_t* out = visible.data();
+	size_t numVisible{ 0 };
+	size_t i{ 0 };
+
+	const float* cx = spheres.centerX.data();
+	const float* cy = spheres.centerY.data();
+	const float* cz = spheres.centerZ.data();
+	const float* cr = spheres.radius.data();
+
+#if defined(_XM_SSE_INTRINSICS_)
+#if defined(__AVX__)
+	__m256 planeX8[6], planeY8[6], planeZ8[6], planeW8[6];
+	for (int p{ 0 }; p < 6; p++)
+	{
+		planeX8[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY8[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ8[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW8[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(cx + i);
+		__m256 y = _mm256_loadu_ps(cy + i);
+		__m256 z = _mm256_loadu_ps(cz + i);
+		__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(cr + i));
+
+		//Visible while the signed distance to every plane is >= -radius
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p{ 0 }; p < 6; p++)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, planeX8[p]), _mm256_mul_ps(y, planeY8[p])),
+				_mm256_add_ps(_mm256_mul_ps(z, planeZ8[p]), planeW8[p]));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+		while (mask)
+		{
+			unsigned long bit = 0;
+#if defined(_MSC_VER)
+			_BitScanForward(&bit, static_cast<unsigned long>(mask));
+#else
+			bit = static_cast<unsigned long>(__builtin_ctz(static_cast<unsigned int>(mask)));
+#endif
+			out[numVisible++] = static_cast<uint32_t>(i + bit);
+			mask &= mask - 1;
+		}
+	}
+#endif
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p{ 0 }; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(cx + i);
+		__m128 y = _mm_loadu_ps(cy + i);
+		__m128 z = _mm_loadu_ps(cz + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(cr + i));
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p{ 0 }; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, planeX[p]), _mm_mul_ps(y, planeY[p])),
+				_mm_add_ps(_mm_mul_ps(z, planeZ[p]), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int lane{ 0 }; lane < 4; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				out[numVisible++] = static_cast<uint32_t>(i + lane);
+			}
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		bool inside{ true };
+		for (const XMFLOAT4& plane : frustum.planes)
+		{
+			inside &= (plane.x * cx[i] + plane.y * cy[i] + plane.z * cz[i] + plane.w) >= -cr[i];
+		}
+		if (inside)
+		{
+			out[numVisible++] = static_cast<uint32_t>(i);
+		}
+	}
+
+	return numVisible;
+}
\ No newline at end of file
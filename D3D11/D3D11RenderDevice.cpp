@@ -0,0 +1,527 @@
+#include "D3D11RenderDevice.h"
+#include <thread>
+
+namespace
+{
+	//----------------------------------------------------
+	DXGI_FORMAT toDXGIFormat(VertexFormat format)
+	{
+		switch (format)
+		{
+		case VertexFormat::Float2: return DXGI_FORMAT_R32G32_FLOAT;
+		case VertexFormat::Float3: return DXGI_FORMAT_R32G32B32_FLOAT;
+		case VertexFormat::Float4: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case VertexFormat::UInt1: return DXGI_FORMAT_R32_UINT;
+		case VertexFormat::UShort4Norm: return DXGI_FORMAT_R16G16B16A16_UNORM;
+		case VertexFormat::Short2Norm: return DXGI_FORMAT_R16G16_SNORM;
+		case VertexFormat::Half2: return DXGI_FORMAT_R16G16_FLOAT;
+		}
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	//----------------------------------------------------
+	DXGI_FORMAT toDXGIFormat(IndexFormat format)
+	{
+		return format == IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+D3D11RenderContext::D3D11RenderContext(D3D11RenderDevice& device, ComPtr<ID3D11DeviceContext> context) :
+	device{ device }, context{ context }
+{
+	//Offset binding needs the 11.1 runtime; without it setConstantBuffer always binds whole buffers
+	//(see D3D11RenderDevice::supportsConstantBufferOffsets)
+	context.As(&context1);
+}
+
+//------------------------------------------------------------------------------------------------------------
+void D3D11RenderContext::updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size)
+{
+	//Boxes on constant buffers need D3D 11.1, which the app requires anyway (see supportsConstantBufferOffsets)
+	D3D11_BOX box{ offset, 0, 0, offset + static_cast<UINT>(size), 1, 1 };
+	context->UpdateSubresource(device.buffer(buffer), 0, &box, data, static_cast<UINT>(size), 0);
+}
+
+//-------------------------------------------------------------------
+void* D3D11RenderContext::mapBuffer(BufferHandle buffer, MapMode mode)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedSubResource;
+	D3D11_MAP mapType = mode == MapMode::WriteDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+	ThrowIfFailed(context->Map(device.buffer(buffer), 0, mapType, 0, &mappedSubResource));
+	return mappedSubResource.pData;
+}
+
+//-------------------------------------------------------
+void D3D11RenderContext::unmapBuffer(BufferHandle buffer)
+{
+	context->Unmap(device.buffer(buffer), 0);
+}
+
+//-------------------------------------------------------------------------------
+void D3D11RenderContext::clear(const float color[4], float depth, uint8_t stencil)
+{
+	context->ClearRenderTargetView(device.backBufferView(), color);
+	context->ClearDepthStencilView(device.depthView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, depth, stencil);
+}
+
+//---------------------------------------------------------------
+void D3D11RenderContext::setViewport(const Viewport& viewport)
+{
+	D3D11_VIEWPORT d3dViewport{ viewport.x, viewport.y, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+	context->RSSetViewports(1, &d3dViewport);
+}
+
+//-------------------------------------------------------------
+void D3D11RenderContext::setBlendState(BlendStateHandle state)
+{
+	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	context->OMSetBlendState(device.blendState(state), blendFactor, 0xffffffff);
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------
+void D3D11RenderContext::setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[])
+{
+	ID3D11Buffer* d3dBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+	for (uint32_t i{ 0 }; i < count; i++)
+	{
+		d3dBuffers[i] = device.buffer(buffers[i]);
+	}
+	context->IASetVertexBuffers(startSlot, count, d3dBuffers, strides, offsets);
+}
+
+//-----------------------------------------------------------------------------------------
+void D3D11RenderContext::setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset)
+{
+	context->IASetIndexBuffer(device.buffer(buffer), toDXGIFormat(format), offset);
+}
+
+//---------------------------------------------------------------
+void D3D11RenderContext::setInputLayout(InputLayoutHandle layout)
+{
+	context->IASetInputLayout(device.inputLayout(layout));
+}
+
+//-----------------------------------------------------------------------------
+void D3D11RenderContext::setPrimitiveTopology(PrimitiveTopology topology)
+{
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+//-----------------------------------------------------------------
+void D3D11RenderContext::setVertexShader(VertexShaderHandle shader)
+{
+	context->VSSetShader(device.vertexShader(shader), nullptr, 0);
+}
+
+//---------------------------------------------------------------
+void D3D11RenderContext::setPixelShader(PixelShaderHandle shader)
+{
+	context->PSSetShader(device.pixelShader(shader), nullptr, 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------
+void D3D11RenderContext::setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+{
+	ID3D11Buffer* d3dBuffer = device.buffer(buffer);
+	if (numConstants != 0 && context1)
+	{
+		if (stage == ShaderStage::Vertex)
+		{
+			context1->VSSetConstantBuffers1(slot, 1, &d3dBuffer, &firstConstant, &numConstants);
+		}
+		else
+		{
+			context1->PSSetConstantBuffers1(slot, 1, &d3dBuffer, &firstConstant, &numConstants);
+		}
+		return;
+	}
+
+	if (stage == ShaderStage::Vertex)
+	{
+		context->VSSetConstantBuffers(slot, 1, &d3dBuffer);
+	}
+	else
+	{
+		context->PSSetConstantBuffers(slot, 1, &d3dBuffer);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void D3D11RenderContext::setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture)
+{
+	ID3D11ShaderResourceView* view = device.texture(texture);
+	if (stage == ShaderStage::Vertex)
+	{
+		context->VSSetShaderResources(slot, 1, &view);
+	}
+	else
+	{
+		context->PSSetShaderResources(slot, 1, &view);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+void D3D11RenderContext::setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer)
+{
+	ID3D11ShaderResourceView* view = device.bufferView(buffer);
+	if (stage == ShaderStage::Vertex)
+	{
+		context->VSSetShaderResources(slot, 1, &view);
+	}
+	else
+	{
+		context->PSSetShaderResources(slot, 1, &view);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void D3D11RenderContext::setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler)
+{
+	ID3D11SamplerState* state = device.sampler(sampler);
+	if (stage == ShaderStage::Vertex)
+	{
+		context->VSSetSamplers(slot, 1, &state);
+	}
+	else
+	{
+		context->PSSetSamplers(slot, 1, &state);
+	}
+}
+
+//------------------------------------------------------------------------
+void D3D11RenderContext::setRasterizerState(RasterizerStateHandle state)
+{
+	context->RSSetState(device.rasterizerState(state));
+}
+
+//-------------------------------------------------------------------------------------------
+void D3D11RenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------------
+void D3D11RenderContext::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+	context->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+//-----------------------------------------------------------------------------
+void D3D11RenderContext::executeCommandList(ICommandList& commandList)
+{
+	//FALSE: the list does not inherit our state and leaves everything at the defaults
+	context->ExecuteCommandList(static_cast<D3D11CommandList&>(commandList).get(), FALSE);
+	device.bindBackBuffer(context.Get());
+}
+
+//-------------------------------------------------------------------------------------------------------
+D3D11DeferredContext::D3D11DeferredContext(D3D11RenderDevice& device, ComPtr<ID3D11DeviceContext> deferred) :
+	device{ device }, recorder{ device, deferred }
+{}
+
+//----------------------------------------------
+IRenderContext& D3D11DeferredContext::context()
+{
+	if (!started)
+	{
+		device.bindBackBuffer(recorder.get());
+		started = true;
+	}
+	return recorder;
+}
+
+//--------------------------------------------------------------
+std::unique_ptr<ICommandList> D3D11DeferredContext::finish()
+{
+	ComPtr<ID3D11CommandList> list;
+	ThrowIfFailed(recorder.get()->FinishCommandList(FALSE, list.GetAddressOf()));
+	started = false;
+	return std::make_unique<D3D11CommandList>(list);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------------
+D3D11RenderDevice::D3D11RenderDevice(ComPtr<ID3D11Device> device, ComPtr<ID3D11DeviceContext> context, ComPtr<IDXGISwapChain> swapChain, DXGI_SAMPLE_DESC sampleDesc) :
+	device{ device }, swapChain{ swapChain }, sampleDesc(sampleDesc), context{ *this, context }
+{
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+	{
+		constantBufferOffsets = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+	}
+
+	D3D11_FEATURE_DATA_THREADING threading{};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+	{
+		driverCommandLists = threading.DriverCommandLists != FALSE;
+	}
+
+	D3D11_QUERY_DESC queryDesc{ D3D11_QUERY_EVENT, 0 };
+	for (ComPtr<ID3D11Query>& query : frameQueries)
+	{
+		ThrowIfFailed(device->CreateQuery(&queryDesc, query.GetAddressOf()));
+	}
+}
+
+//----------------------------------------------------------------------------------------
+BufferHandle D3D11RenderDevice::createBuffer(const BufferDesc& desc, const void* initialData)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	bufferDesc.ByteWidth = desc.sizeInBytes;
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	switch (desc.binding)
+	{
+	case BufferBinding::Vertex: bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER; break;
+	case BufferBinding::Index: bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER; break;
+	case BufferBinding::Constant: bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER; break;
+	case BufferBinding::ShaderResource:
+		bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bufferDesc.StructureByteStride = desc.structureStride;
+		break;
+	}
+
+	switch (desc.usage)
+	{
+	case ResourceUsage::Immutable: bufferDesc.Usage = D3D11_USAGE_IMMUTABLE; break;
+	case ResourceUsage::Default: bufferDesc.Usage = D3D11_USAGE_DEFAULT; break;
+	case ResourceUsage::Dynamic:
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		break;
+	}
+
+	D3D11_SUBRESOURCE_DATA data;
+	data.pSysMem = initialData;
+	data.SysMemPitch = 0;
+	data.SysMemSlicePitch = 0;
+
+	ComPtr<ID3D11Buffer> buffer;
+	ThrowIfFailed(device->CreateBuffer(&bufferDesc, initialData != nullptr ? &data : nullptr, buffer.GetAddressOf()));
+
+	ComPtr<ID3D11ShaderResourceView> view;
+	if (desc.binding == BufferBinding::ShaderResource)
+	{
+		ThrowIfFailed(device->CreateShaderResourceView(buffer.Get(), nullptr, view.GetAddressOf()));
+	}
+	bufferViews.add(view);
+	return buffers.add(buffer);
+}
+
+//--------------------------------------------------------------------------------------------------------
+TextureHandle D3D11RenderDevice::createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch)
+{
+	D3D11_TEXTURE2D_DESC texDesc;
+	texDesc.Width = desc.width;
+	texDesc.Height = desc.height;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = 1;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA texData;
+	texData.pSysMem = pixels;
+	texData.SysMemPitch = rowPitch;
+	texData.SysMemSlicePitch = 0;
+
+	ComPtr<ID3D11Texture2D> texture;
+	ComPtr<ID3D11ShaderResourceView> view;
+	ThrowIfFailed(device->CreateTexture2D(&texDesc, &texData, texture.GetAddressOf()));
+	ThrowIfFailed(device->CreateShaderResourceView(texture.Get(), nullptr, view.GetAddressOf()));
+	return textures.add(view);
+}
+
+//----------------------------------------------------------------------------------------------
+VertexShaderHandle D3D11RenderDevice::createVertexShader(const void* bytecode, size_t size)
+{
+	ComPtr<ID3D11VertexShader> shader;
+	ThrowIfFailed(device->CreateVertexShader(bytecode, size, nullptr, shader.GetAddressOf()));
+	return vertexShaders.add(shader);
+}
+
+//--------------------------------------------------------------------------------------------
+PixelShaderHandle D3D11RenderDevice::createPixelShader(const void* bytecode, size_t size)
+{
+	ComPtr<ID3D11PixelShader> shader;
+	ThrowIfFailed(device->CreatePixelShader(bytecode, size, nullptr, shader.GetAddressOf()));
+	return pixelShaders.add(shader);
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------------
+InputLayoutHandle D3D11RenderDevice::createInputLayout(const InputElement elements[], uint32_t count, const void* vsBytecode, size_t size)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> descs(count);
+	for (uint32_t i{ 0 }; i < count; i++)
+	{
+		const InputElement& element = elements[i];
+		descs[i].SemanticName = element.semantic;
+		descs[i].SemanticIndex = element.semanticIndex;
+		descs[i].Format = toDXGIFormat(element.format);
+		descs[i].InputSlot = element.slot;
+		descs[i].AlignedByteOffset = element.offset;
+		descs[i].InputSlotClass = element.perInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+		descs[i].InstanceDataStepRate = element.perInstance ? 1 : 0;
+	}
+
+	ComPtr<ID3D11InputLayout> layout;
+	ThrowIfFailed(device->CreateInputLayout(descs.data(), count, vsBytecode, size, layout.GetAddressOf()));
+	return inputLayouts.add(layout);
+}
+
+//------------------------------------------------------------------------
+SamplerHandle D3D11RenderDevice::createSampler(const SamplerDesc& desc)
+{
+	D3D11_SAMPLER_DESC samplerDesc;
+	ZeroMemory(&samplerDesc, sizeof(samplerDesc));
+	D3D11_TEXTURE_ADDRESS_MODE address = desc.address == TextureAddress::Wrap ? D3D11_TEXTURE_ADDRESS_WRAP : D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressU = address;
+	samplerDesc.AddressV = address;
+	samplerDesc.AddressW = address;
+	samplerDesc.MaxAnisotropy = desc.maxAnisotropy;
+
+	switch (desc.filter)
+	{
+	case TextureFilter::Point: samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT; break;
+	case TextureFilter::Linear: samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR; break;
+	case TextureFilter::Anisotropic: samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC; break;
+	}
+
+	ComPtr<ID3D11SamplerState> sampler;
+	ThrowIfFailed(device->CreateSamplerState(&samplerDesc, sampler.GetAddressOf()));
+	return samplers.add(sampler);
+}
+
+//---------------------------------------------------------------------------------------------
+RasterizerStateHandle D3D11RenderDevice::createRasterizerState(const RasterizerDesc& desc)
+{
+	D3D11_RASTERIZER_DESC rastDesc;
+	ZeroMemory(&rastDesc, sizeof(rastDesc));
+	rastDesc.FillMode = D3D11_FILL_SOLID;
+	rastDesc.FrontCounterClockwise = desc.frontCounterClockwise;
+	rastDesc.DepthClipEnable = desc.depthClip;
+
+	switch (desc.cullMode)
+	{
+	case CullMode::None: rastDesc.CullMode = D3D11_CULL_NONE; break;
+	case CullMode::Front: rastDesc.CullMode = D3D11_CULL_FRONT; break;
+	case CullMode::Back: rastDesc.CullMode = D3D11_CULL_BACK; break;
+	}
+
+	ComPtr<ID3D11RasterizerState> state;
+	ThrowIfFailed(device->CreateRasterizerState(&rastDesc, state.GetAddressOf()));
+	return rasterizerStates.add(state);
+}
+
+//--------------------------------------------------------------------------
+BlendStateHandle D3D11RenderDevice::createBlendState(const BlendDesc& desc)
+{
+	D3D11_BLEND_DESC blendDesc;
+	ZeroMemory(&blendDesc, sizeof(blendDesc));
+	blendDesc.AlphaToCoverageEnable = false;
+	blendDesc.IndependentBlendEnable = false;
+	blendDesc.RenderTarget[0].BlendEnable = desc.mode == BlendMode::AlphaBlend;
+	blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+	blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+	ComPtr<ID3D11BlendState> state;
+	ThrowIfFailed(device->CreateBlendState(&blendDesc, state.GetAddressOf()));
+	return blendStates.add(state);
+}
+
+//-------------------------------------------------------------
+void D3D11RenderDevice::resize(uint32_t width, uint32_t height)
+{
+	ID3D11DeviceContext* immediate = context.get();
+	immediate->OMSetRenderTargets(0, nullptr, nullptr);
+	depthStencilView.Reset();
+	depthStencilBuffer.Reset();
+	renderTargetView.Reset();
+
+	//Create Render target view for swap chain back buffer
+	ThrowIfFailed(swapChain->ResizeBuffers(1, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, 0));
+	ComPtr<ID3D11Texture2D> backBuffer;
+	ThrowIfFailed(swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)backBuffer.GetAddressOf()));
+	ThrowIfFailed(device->CreateRenderTargetView(backBuffer.Get(), 0, renderTargetView.GetAddressOf()));
+
+	//Create Depth/Stencil buffer
+	D3D11_TEXTURE2D_DESC texDesc;
+	texDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	texDesc.Height = height;
+	texDesc.Width = width;
+	texDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = 0;
+	texDesc.ArraySize = 1;
+	texDesc.MipLevels = 1;
+	texDesc.SampleDesc = sampleDesc;
+
+	//Create Depth/Stencil View
+	ThrowIfFailed(device->CreateTexture2D(&texDesc, 0, depthStencilBuffer.GetAddressOf()));
+	ThrowIfFailed(device->CreateDepthStencilView(depthStencilBuffer.Get(), 0, depthStencilView.GetAddressOf()));
+
+	//Bind render target view and depthStencil view to output merger state
+	backBufferWidth = width;
+	backBufferHeight = height;
+	bindBackBuffer(immediate);
+}
+
+//-------------------------------------------------------------------------
+void D3D11RenderDevice::bindBackBuffer(ID3D11DeviceContext* target) const
+{
+	D3D11_VIEWPORT viewport{ 0.0f, 0.0f, static_cast<float>(backBufferWidth), static_cast<float>(backBufferHeight), 0.0f, 1.0f };
+	target->OMSetRenderTargets(1, renderTargetView.GetAddressOf(), depthStencilView.Get());
+	target->RSSetViewports(1, &viewport);
+}
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<IDeferredContext> D3D11RenderDevice::createDeferredContext()
+{
+	ComPtr<ID3D11DeviceContext> deferred;
+	ThrowIfFailed(device->CreateDeferredContext(0, deferred.GetAddressOf()));
+	return std::make_unique<D3D11DeferredContext>(*this, deferred);
+}
+
+//---------------------------------------------------------
+void D3D11RenderDevice::present(uint32_t syncInterval)
+{
+	ThrowIfFailed(swapChain->Present(syncInterval, 0));
+
+	//The query slot is free once the frame that last used it has completed
+	while (frames - completedFrames() >= maxFramesInFlight)
+	{
+		std::this_thread::yield();
+	}
+	context.get()->End(frameQueries[frames % maxFramesInFlight].Get());
+	frames++;
+}
+
+//Polls the event queries of the frames in flight without flushing
+//----------------------------------------------
+uint64_t D3D11RenderDevice::completedFrames()
+{
+	while (completed < frames)
+	{
+		HRESULT hr = context.get()->GetData(frameQueries[completed % maxFramesInFlight].Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		ThrowIfFailed(hr);
+		if (hr != S_OK)
+		{
+			break;
+		}
+		completed++;
+	}
+	return completed;
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "d3dUtil.h"
+#include "RenderDevice.h"
+#include <d3d11_1.h>
+
+class D3D11RenderDevice;
+
+//IRenderContext over an ID3D11DeviceContext
+class D3D11RenderContext : public IRenderContext
+{
+public:
+
+	D3D11RenderContext(D3D11RenderDevice& device, ComPtr<ID3D11DeviceContext> context);
+
+	void updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size) override;
+	void* mapBuffer(BufferHandle buffer, MapMode mode) override;
+	void unmapBuffer(BufferHandle buffer) override;
+
+	void clear(const float color[4], float depth, uint8_t stencil) override;
+	void setViewport(const Viewport& viewport) override;
+	void setBlendState(BlendStateHandle state) override;
+
+	void setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[]) override;
+	void setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) override;
+	void setInputLayout(InputLayoutHandle layout) override;
+	void setPrimitiveTopology(PrimitiveTopology topology) override;
+
+	void setVertexShader(VertexShaderHandle shader) override;
+	void setPixelShader(PixelShaderHandle shader) override;
+	void setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+	void setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture) override;
+	void setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer) override;
+	void setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler) override;
+
+	void setRasterizerState(RasterizerStateHandle state) override;
+
+	void drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+	void executeCommandList(ICommandList& commandList) override;
+
+	ID3D11DeviceContext* get() const { return context.Get(); }
+
+private:
+
+	D3D11RenderDevice& device;
+	ComPtr<ID3D11DeviceContext> context;
+	ComPtr<ID3D11DeviceContext1> context1;	//offset constant buffer binding, D3D 11.1
+};
+
+//Command list finished by a D3D11DeferredContext
+class D3D11CommandList : public ICommandList
+{
+public:
+
+	explicit D3D11CommandList(ComPtr<ID3D11CommandList> list) : list{ list } {}
+
+	ID3D11CommandList* get() const { return list.Get(); }
+
+private:
+
+	ComPtr<ID3D11CommandList> list;
+};
+
+//IDeferredContext over an ID3D11 deferred context
+//The back buffer is bound when recording starts rather than after finish, so idle
+//deferred contexts hold no reference to it and the swap chain can still be resized.
+//The first map of a dynamic buffer in each command list has to be WriteDiscard
+class D3D11DeferredContext : public IDeferredContext
+{
+public:
+
+	D3D11DeferredContext(D3D11RenderDevice& device, ComPtr<ID3D11DeviceContext> deferred);
+
+	IRenderContext& context() override;
+	std::unique_ptr<ICommandList> finish() override;
+
+private:
+
+	D3D11RenderDevice& device;
+	D3D11RenderContext recorder;
+	bool started{ false };
+};
+
+//IRenderDevice over an existing device, immediate context and swap chain
+//Owns the back buffer render target and depth/stencil buffer and keeps them bound
+class D3D11RenderDevice : public IRenderDevice
+{
+public:
+
+	D3D11RenderDevice(ComPtr<ID3D11Device> device, ComPtr<ID3D11DeviceContext> context, ComPtr<IDXGISwapChain> swapChain, DXGI_SAMPLE_DESC sampleDesc);
+
+	BufferHandle createBuffer(const BufferDesc& desc, const void* initialData) override;
+	TextureHandle createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch) override;
+	VertexShaderHandle createVertexShader(const void* bytecode, size_t size) override;
+	PixelShaderHandle createPixelShader(const void* bytecode, size_t size) override;
+	InputLayoutHandle createInputLayout(const InputElement elements[], uint32_t count, const void* vsBytecode, size_t size) override;
+	SamplerHandle createSampler(const SamplerDesc& desc) override;
+	RasterizerStateHandle createRasterizerState(const RasterizerDesc& desc) override;
+	BlendStateHandle createBlendState(const BlendDesc& desc) override;
+
+	void destroyBuffer(BufferHandle buffer) override
+	{
+		buffers.remove(buffer);
+		bufferViews.remove(buffer);
+	}
+	void destroyTexture(TextureHandle texture) override { textures.remove(texture); }
+
+	void resize(uint32_t width, uint32_t height) override;
+	void present(uint32_t syncInterval) override;
+	uint64_t presentedFrames() const override { return frames; }
+	uint64_t completedFrames() override;
+
+	IRenderContext& immediateContext() override { return context; }
+	std::unique_ptr<IDeferredContext> createDeferredContext() override;
+
+	//Offset constant buffer binding and NO_OVERWRITE maps of dynamic constant buffers (D3D 11.1),
+	//both needed by ConstantUploadRing
+	bool supportsConstantBufferOffsets() const { return constantBufferOffsets; }
+
+	//Whether the driver builds command lists itself; otherwise the runtime emulates them and
+	//recording on several threads saves less
+	bool supportsDriverCommandLists() const { return driverCommandLists; }
+
+	//Binds the back buffer and depth buffer with a viewport covering them, the state
+	//command lists start from and leave behind
+	void bindBackBuffer(ID3D11DeviceContext* target) const;
+
+	//Wraps a view created outside the interface, e.g. by the WIC / DDS loaders
+	TextureHandle addShaderResourceView(ComPtr<ID3D11ShaderResourceView> view) { return textures.add(view); }
+
+	ID3D11Device* get() const { return device.Get(); }
+
+	//Handle lookups for D3D11RenderContext
+	ID3D11Buffer* buffer(BufferHandle handle) const { return buffers.get(handle).Get(); }
+	ID3D11ShaderResourceView* bufferView(BufferHandle handle) const { return bufferViews.get(handle).Get(); }
+	ID3D11ShaderResourceView* texture(TextureHandle handle) const { return textures.get(handle).Get(); }
+	ID3D11VertexShader* vertexShader(VertexShaderHandle handle) const { return vertexShaders.get(handle).Get(); }
+	ID3D11PixelShader* pixelShader(PixelShaderHandle handle) const { return pixelShaders.get(handle).Get(); }
+	ID3D11InputLayout* inputLayout(InputLayoutHandle handle) const { return inputLayouts.get(handle).Get(); }
+	ID3D11SamplerState* sampler(SamplerHandle handle) const { return samplers.get(handle).Get(); }
+	ID3D11RasterizerState* rasterizerState(RasterizerStateHandle handle) const { return rasterizerStates.get(handle).Get(); }
+	ID3D11BlendState* blendState(BlendStateHandle handle) const { return blendStates.get(handle).Get(); }
+	ID3D11RenderTargetView* backBufferView() const { return renderTargetView.Get(); }
+	ID3D11DepthStencilView* depthView() const { return depthStencilView.Get(); }
+
+private:
+
+	ComPtr<ID3D11Device> device;
+	ComPtr<IDXGISwapChain> swapChain;
+	DXGI_SAMPLE_DESC sampleDesc;
+	D3D11RenderContext context;
+
+	ComPtr<ID3D11RenderTargetView> renderTargetView;
+	ComPtr<ID3D11Texture2D> depthStencilBuffer;
+	ComPtr<ID3D11DepthStencilView> depthStencilView;
+
+	//Frame fences: an event query is issued after each present, slots are reused round robin
+	static constexpr uint32_t maxFramesInFlight{ 8 };
+	ComPtr<ID3D11Query> frameQueries[maxFramesInFlight];
+	uint64_t frames{ 0 };
+	uint64_t completed{ 0 };
+	bool constantBufferOffsets{ false };
+	bool driverCommandLists{ false };
+
+	uint32_t backBufferWidth{ 0 };
+	uint32_t backBufferHeight{ 0 };
+
+	HandleTable<ComPtr<ID3D11Buffer>, BufferHandle> buffers;
+	//Views of ShaderResource buffers, null for the others. Added and removed with buffers so the ids match
+	HandleTable<ComPtr<ID3D11ShaderResourceView>, BufferHandle> bufferViews;
+	HandleTable<ComPtr<ID3D11ShaderResourceView>, TextureHandle> textures;
+	HandleTable<ComPtr<ID3D11VertexShader>, VertexShaderHandle> vertexShaders;
+	HandleTable<ComPtr<ID3D11PixelShader>, PixelShaderHandle> pixelShaders;
+	HandleTable<ComPtr<ID3D11InputLayout>, InputLayoutHandle> inputLayouts;
+	HandleTable<ComPtr<ID3D11SamplerState>, SamplerHandle> samplers;
+	HandleTable<ComPtr<ID3D11RasterizerState>, RasterizerStateHandle> rasterizerStates;
+	HandleTable<ComPtr<ID3D11BlendState>, BlendStateHandle> blendStates;
+};
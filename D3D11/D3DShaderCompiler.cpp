@@ -0,0 +1,41 @@
+#include "D3DShaderCompiler.h"
+#include "d3dUtil.h"
+
+//-----------------------------------------------------------------------------------------------------------------
+bool D3DShaderCompiler::compile(const ShaderCompileDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors)
+{
+	//D3D_SHADER_MACRO array terminated by a null entry
+	std::vector<D3D_SHADER_MACRO> macros;
+	macros.reserve(desc.defines.size() + 1);
+	for (const ShaderDefine& define : desc.defines)
+	{
+		macros.push_back({ define.name.c_str(), define.value.c_str() });
+	}
+	macros.push_back({ nullptr, nullptr });
+
+	ComPtr<ID3D10Blob> compiledCode;
+	ComPtr<ID3D10Blob> errorMsgs;
+	HRESULT result = D3DCompileFromFile(ansiToWString(desc.sourceFile).c_str(), macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		desc.entryPoint.c_str(), desc.profile.c_str(), desc.flags, 0, compiledCode.GetAddressOf(), errorMsgs.GetAddressOf());
+
+	errors.clear();
+	if (errorMsgs != nullptr)
+	{
+		errors.assign(reinterpret_cast<const char*>(errorMsgs->GetBufferPointer()), errorMsgs->GetBufferSize());
+	}
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	const uint8_t* code = static_cast<const uint8_t*>(compiledCode->GetBufferPointer());
+	bytecode.assign(code, code + compiledCode->GetBufferSize());
+	return true;
+}
+
+//D3D_COMPILER_VERSION is the d3dcompiler_NN.dll the sample links against
+//-------------------------------------------------------
+std::string D3DShaderCompiler::identity() const
+{
+	return "d3dcompiler_" + std::to_string(D3D_COMPILER_VERSION);
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "ShaderCompiler.h"
+
+//IShaderCompiler backed by D3DCompileFromFile with the standard file include handler
+class D3DShaderCompiler : public IShaderCompiler
+{
+public:
+
+	bool compile(const ShaderCompileDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors) override;
+	std::string identity() const override;
+};
@@ -0,0 +1,102 @@
+#include "Flipbook.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//----------------------------------------------------------------------
+bool Flipbook::pack(const std::vector<CpuImage>& frames, uint32_t gutter)
+{
+	std::vector<const CpuImage*> framePtrs;
+	framePtrs.reserve(frames.size());
+	for (const CpuImage& frame : frames)
+	{
+		framePtrs.push_back(&frame);
+	}
+	return pack(framePtrs.data(), framePtrs.size(), gutter);
+}
+
+//-------------------------------------------------------------------------------------
+bool Flipbook::pack(const CpuImage* const frames[], size_t frameCount, uint32_t gutter)
+{
+	if (frameCount == 0)
+	{
+		return false;
+	}
+
+	const uint32_t frameWidth = frames[0]->width;
+	const uint32_t frameHeight = frames[0]->height;
+	for (size_t i{ 0 }; i < frameCount; i++)
+	{
+		const CpuImage& frame = *frames[i];
+		if (frame.width != frameWidth || frame.height != frameHeight || frame.pixels.size() != frame.rowPitch() * frame.height)
+		{
+			return false;
+		}
+	}
+
+	//Roughly square grid
+	const uint32_t count = static_cast<uint32_t>(frameCount);
+	const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+	const uint32_t rows = (count + columns - 1) / columns;
+	const uint32_t cellWidth = frameWidth + 2 * gutter;
+	const uint32_t cellHeight = frameHeight + 2 * gutter;
+
+	atlasImage.width = columns * cellWidth;
+	atlasImage.height = rows * cellHeight;
+	atlasImage.pixels.assign(atlasImage.rowPitch() * atlasImage.height, 0);
+
+	frameScale = { static_cast<float>(frameWidth) / atlasImage.width, static_cast<float>(frameHeight) / atlasImage.height };
+	frameOffsets.resize(count);
+
+	for (uint32_t i{ 0 }; i < count; i++)
+	{
+		const CpuImage& frame = *frames[i];
+		const uint32_t cellX = (i % columns) * cellWidth;
+		const uint32_t cellY = (i / columns) * cellHeight;
+
+		//Copy the frame with clamped source coordinates so the gutter repeats the edge texels
+		for (uint32_t y{ 0 }; y < cellHeight; y++)
+		{
+			uint32_t srcY = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(int64_t{ y } - gutter, 0), frameHeight - 1));
+			const uint8_t* srcRow = frame.pixels.data() + frame.rowPitch() * srcY;
+			uint8_t* dstRow = atlasImage.pixels.data() + atlasImage.rowPitch() * (cellY + y) + size_t{ cellX } * 4;
+
+			for (uint32_t x{ 0 }; x < gutter; x++)
+			{
+				memcpy(dstRow + x * 4, srcRow, 4);
+				memcpy(dstRow + (gutter + frameWidth + x) * 4, srcRow + (frameWidth - 1) * 4, 4);
+			}
+			memcpy(dstRow + gutter * 4, srcRow, frame.rowPitch());
+		}
+
+		frameOffsets[i] = { static_cast<float>(cellX + gutter) / atlasImage.width, static_cast<float>(cellY + gutter) / atlasImage.height };
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+XMFLOAT4X4 Flipbook::frameTransform(uint32_t frame) const
+{
+	const XMFLOAT2& offset = frameOffsets[frame % frameOffsets.size()];
+	return XMFLOAT4X4{ frameScale.x, 0.0f, 0.0f, 0.0f,
+					   0.0f, frameScale.y, 0.0f, 0.0f,
+					   0.0f, 0.0f, 1.0f, 0.0f,
+					   offset.x, offset.y, 0.0f, 1.0f };
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+std::vector<std::string> flipbookFrameFileNames(const std::string& prefix, uint32_t frameCount, const std::string& extension)
+{
+	std::vector<std::string> fileNames;
+	fileNames.reserve(frameCount);
+	for (uint32_t i{ 1 }; i <= frameCount; i++)
+	{
+		std::string number = std::to_string(i);
+		if (number.size() < 3)
+		{
+			number.insert(0, 3 - number.size(), '0');
+		}
+		fileNames.push_back(prefix + number + extension);
+	}
+	return fileNames;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include "CpuImage.h"
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+//Flipbook animation packed into a single texture atlas
+//Frames are laid out row by row in equally sized cells. Each cell has a gutter of
+//replicated edge texels so filtering never picks up the neighbouring frame.
+//Selecting a frame only changes the texture transform (scale + offset), the
+//atlas itself stays bound
+class Flipbook
+{
+public:
+
+	//Packs equally sized frames; returns false if there are none or sizes differ
+	bool pack(const CpuImage* const frames[], size_t count, uint32_t gutter = 4);
+	bool pack(const std::vector<CpuImage>& frames, uint32_t gutter = 4);
+
+	//Texture transform mapping [0, 1] uvs onto the given frame's cell
+	XMFLOAT4X4 frameTransform(uint32_t frame) const;
+
+	uint32_t frameCount() const { return static_cast<uint32_t>(frameOffsets.size()); }
+	const CpuImage& atlas() const { return atlasImage; }
+
+private:
+
+	CpuImage atlasImage;
+	XMFLOAT2 frameScale{ 0.0f, 0.0f };
+	std::vector<XMFLOAT2> frameOffsets;
+};
+
+//Frame file names of a numbered sequence e.g. Images/FireAnim/Fire001.bmp ... Fire120.bmp
+std::vector<std::string> flipbookFrameFileNames(const std::string& prefix, uint32_t frameCount, const std::string& extension);
\ No newline at end of file
@@ -1,26 +1,20 @@
 #include "GameTimer.h"
 
-//--------------------
-GameTimer::GameTimer()
-{
-	_int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)& countsPerSec);
-
-	//this is needed as QueryPerformanceCounter will return number of counts
-	//that have passed since the application was launched and since we are targeting
-	//fps dependent rendering updates we need to convert said counts into seconds corresponding to those counts
-	numSecondsPerCount = 1.0 / static_cast<double>(countsPerSec);
-}
+//-------------------------------------------------------------
+GameTimer::GameTimer(TimeSource& source) : source{ &source }
+{}
 
 //---------------------
 void GameTimer::reset()
 {
-	_int64 currentTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-	
+	int64_t currentTime = source->now();
+
 	launchTime = currentTime;
+	currTime = currentTime;
 	prevTime = currentTime;
 	stopTime = 0;
+	pausedTime = 0;
+	deltaTime = 0;
 	stopped = false;
 }
 
@@ -29,29 +23,25 @@ void GameTimer::tick()
 {
 	if (stopped)
 	{
-		deltaTime = 0.0;
+		deltaTime = 0;
 		return;
 	}
 
-	_int64 currentTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-	currTime = currentTime;
-	deltaTime = (currTime - prevTime) * numSecondsPerCount;
+	currTime = source->now();
+	deltaTime = currTime - prevTime;
 	prevTime = currTime;
 
-	// Force nonnegative. The DXSDK's CDXUTTimer mentions that if the
-	// processor goes into a power save mode or we get shuffled to another
-	// processor, then deltaTime can be negative.
-	if (deltaTime < 0.0)
+	//Force nonnegative in case a time source misbehaves (the steady clock never goes backwards)
+	if (deltaTime < 0)
 	{
-		deltaTime = 0.0;
+		deltaTime = 0;
 	}
 }
 
 //-----------------------------------
 float GameTimer::getDeltaTime() const
 {
-	return static_cast<float>(deltaTime);
+	return static_cast<float>(deltaTime * 1e-9);
 }
 
 //---------------------
@@ -59,8 +49,7 @@ void GameTimer::start()
 {
 	if (stopped)
 	{
-		_int64 startTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+		int64_t startTime = source->now();
 
 		pausedTime += startTime - stopTime;
 		prevTime = startTime;
@@ -74,27 +63,66 @@ void GameTimer::stop()
 {
 	if (!stopped)
 	{
-		_int64 currentTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currentTime);
-
-		stopTime = currentTime;
+		stopTime = source->now();
 		stopped = true;
 	}
 }
 
 //return time passed since app was 
 //launched but exclude pause time
-//--------------------------------
-float GameTimer::totalTime() const
+//-------------------------------------------
+int64_t GameTimer::totalNanoseconds() const
 {
 	if (stopped)
 	{
 		//considering previous pauses 
 		//(stoptime - pausedTime) - launchTime gives the total time app has been active
-		return static_cast<float>(((stopTime - pausedTime) - launchTime) * numSecondsPerCount);
+		return (stopTime - pausedTime) - launchTime;
 	}
 	else
 	{
-		return static_cast<float>(((currTime - pausedTime) - launchTime) * numSecondsPerCount);
+		return (currTime - pausedTime) - launchTime;
+	}
+}
+
+//---------------------------------
+double GameTimer::totalTime() const
+{
+	return totalNanoseconds() * 1e-9;
+}
+
+//-----------------------------------------------------------------------------------
+FixedTimestep::FixedTimestep(uint32_t stepsPerSecond, uint32_t maxStepsPerFrame) :
+	stepsPerSecond{ stepsPerSecond > 0 ? stepsPerSecond : 1 }, maxStepsPerFrame{ maxStepsPerFrame }
+{}
+
+//-------------------------------------------------------
+uint32_t FixedTimestep::advance(int64_t frameNanoseconds)
+{
+	if (frameNanoseconds <= 0)
+	{
+		return 0;
+	}
+
+	//remainder is in units of 1 / (nanosecondsPerSecond * stepsPerSecond) seconds
+	//and stays below one step, frameNanoseconds * stepsPerSecond cannot overflow for any real frame time
+	remainder += frameNanoseconds * stepsPerSecond;
+	int64_t newSteps = remainder / nanosecondsPerSecond;
+	remainder %= nanosecondsPerSecond;
+
+	if (newSteps > maxStepsPerFrame)
+	{
+		droppedSteps += static_cast<uint64_t>(newSteps - maxStepsPerFrame);
+		newSteps = maxStepsPerFrame;
 	}
+	steps += static_cast<uint64_t>(newSteps);
+	return static_cast<uint32_t>(newSteps);
+}
+
+//--------------------------
+void FixedTimestep::reset()
+{
+	remainder = 0;
+	steps = 0;
+	droppedSteps = 0;
 }
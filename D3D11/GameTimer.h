@@ -1,28 +1,73 @@
 #pragma once
-#include <windows.h>
+#include "TimeSource.h"
 
 class GameTimer
 {
 public:
 
-	GameTimer();
+	explicit GameTimer(TimeSource& source = steadyTimeSource());
 	void reset();
 	void tick();
 	void start();
 	void stop();
-	float totalTime() const;
+
+	//Seconds since reset excluding paused time. Kept in double, a float total
+	//only resolves ~8ms after a day of uptime
+	double totalTime() const;
 	float getDeltaTime() const;
 
+	//Exact integer values for fixed timestep accumulation
+	int64_t totalNanoseconds() const;
+	int64_t deltaNanoseconds() const { return deltaTime; }
+
 private:
 
-	double numSecondsPerCount{ 0.0f };
-	double deltaTime{ 0.0f };
+	TimeSource* source;
+
+	int64_t deltaTime{ 0 };
 
-	_int64 launchTime{ 0 };
-	_int64 currTime{ 0 };
-	_int64 prevTime{ 0 };
-	_int64 stopTime{ 0 };
-	_int64 pausedTime{ 0 };
+	int64_t launchTime{ 0 };
+	int64_t currTime{ 0 };
+	int64_t prevTime{ 0 };
+	int64_t stopTime{ 0 };
+	int64_t pausedTime{ 0 };
 
 	bool stopped{ false };
 };
+
+//Fixed timestep accumulator
+//Frame times go in, a whole number of simulation steps comes out, so simulation
+//cost and results do not depend on the render rate. The leftover time is kept as
+//an exact integer remainder (nanoseconds * stepsPerSecond), so the step count never
+//drifts from elapsed time however long the app runs. alpha is the fraction of a
+//step left over, used to interpolate between the previous and current simulation state
+class FixedTimestep
+{
+public:
+
+	explicit FixedTimestep(uint32_t stepsPerSecond = 60, uint32_t maxStepsPerFrame = 8);
+
+	//Returns the number of steps to simulate for this frame. Steps beyond
+	//maxStepsPerFrame (e.g. after a breakpoint or a long hitch) are dropped
+	uint32_t advance(int64_t frameNanoseconds);
+	void reset();
+
+	double stepSeconds() const { return 1.0 / stepsPerSecond; }
+	float alpha() const { return static_cast<float>(static_cast<double>(remainder) / nanosecondsPerSecond); }
+
+	uint64_t stepCount() const { return steps; }
+	uint64_t droppedStepCount() const { return droppedSteps; }
+
+	//Simulated time, stepCount / stepsPerSecond
+	double simulatedTime() const { return static_cast<double>(steps) / stepsPerSecond; }
+
+private:
+
+	static const int64_t nanosecondsPerSecond{ 1000000000 };
+
+	uint32_t stepsPerSecond;
+	uint32_t maxStepsPerFrame;
+	int64_t remainder{ 0 };
+	uint64_t steps{ 0 };
+	uint64_t droppedSteps{ 0 };
+};
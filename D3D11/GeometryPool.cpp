@@ -0,0 +1,136 @@
+#include "GeometryPool.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------------------------
+GeometryPool::GeometryPool(IRenderDevice& device, uint32_t vertexPageBytes, uint32_t indexPageBytes) :
+	device{ device }, vertexPageBytes{ vertexPageBytes }, indexPageBytes{ indexPageBytes }
+{}
+
+//------------------------------
+GeometryPool::~GeometryPool()
+{
+	for (const Page& page : vertexPages)
+	{
+		device.destroyBuffer(page.buffer);
+	}
+	for (const Page& page : indexPages)
+	{
+		device.destroyBuffer(page.buffer);
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+GeometryAllocation GeometryPool::allocate(IRenderContext& context, const void* vertices, uint32_t vertexCount, uint32_t stride,
+	const uint32_t* indices, uint32_t indexCount)
+{
+	//Half the index memory and bandwidth when the mesh allows it
+	if (fitsIndex16(vertexCount))
+	{
+		std::vector<uint16_t> indices16(indices, indices + indexCount);
+		return allocate(context, vertices, vertexCount, stride, indices16.data(), IndexFormat::UInt16, indexCount);
+	}
+	return allocate(context, vertices, vertexCount, stride, indices, IndexFormat::UInt32, indexCount);
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+GeometryAllocation GeometryPool::allocate(IRenderContext& context, const void* vertices, uint32_t vertexCount, uint32_t stride,
+	const void* indices, IndexFormat indexFormat, uint32_t indexCount)
+{
+	GeometryAllocation allocation;
+	if (vertexCount == 0 || indexCount == 0 || stride == 0)
+	{
+		return allocation;
+	}
+
+	allocation.stride = stride;
+	allocation.vertexCount = vertexCount;
+	allocation.indexCount = indexCount;
+	allocation.indexFormat = indexFormat;
+	allocation.baseVertex = allocateIn(vertexPages, BufferBinding::Vertex, stride, vertexCount, vertexPageBytes, allocation.vertexBuffer);
+
+	const uint32_t indexSize = indexFormat == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	allocation.startIndex = allocateIn(indexPages, BufferBinding::Index, indexSize, indexCount, indexPageBytes, allocation.indexBuffer);
+
+	uint32_t vertexBytes = vertexCount * stride;
+	uint32_t indexBytes = indexCount * indexSize;
+	context.updateBuffer(allocation.vertexBuffer, allocation.baseVertex * stride, vertices, vertexBytes);
+	context.updateBuffer(allocation.indexBuffer, allocation.startIndex * indexSize, indices, indexBytes);
+	bytesUploaded += vertexBytes + indexBytes;
+	return allocation;
+}
+
+//------------------------------------------------------------
+void GeometryPool::free(const GeometryAllocation& allocation)
+{
+	if (Page* page = findPage(vertexPages, allocation.vertexBuffer))
+	{
+		page->ranges.free(allocation.baseVertex);
+	}
+	if (Page* page = findPage(indexPages, allocation.indexBuffer))
+	{
+		page->ranges.free(allocation.startIndex);
+	}
+}
+
+//--------------------------------------------------
+GeometryPoolStats GeometryPool::stats() const
+{
+	GeometryPoolStats stats;
+	stats.vertexPages = static_cast<uint32_t>(vertexPages.size());
+	stats.indexPages = static_cast<uint32_t>(indexPages.size());
+	for (const Page& page : vertexPages)
+	{
+		addStats(page, stats.vertexBytes);
+	}
+	for (const Page& page : indexPages)
+	{
+		addStats(page, stats.indexBytes);
+	}
+	stats.bytesUploaded = bytesUploaded;
+	return stats;
+}
+
+//----------------------------------------------------------------------------------
+GeometryPool::Page* GeometryPool::findPage(std::vector<Page>& pages, BufferHandle buffer)
+{
+	auto page = std::find_if(pages.begin(), pages.end(), [buffer](const Page& candidate) { return candidate.buffer == buffer; });
+	return page == pages.end() ? nullptr : &*page;
+}
+
+//First page of the stride with room, otherwise a new page big enough for count elements
+//-------------------------------------------------------------------------------------------------------------------------------------------
+uint32_t GeometryPool::allocateIn(std::vector<Page>& pages, BufferBinding binding, uint32_t stride, uint32_t count, uint32_t pageBytes, BufferHandle& buffer)
+{
+	for (Page& page : pages)
+	{
+		if (page.stride != stride)
+		{
+			continue;
+		}
+		uint32_t offset = page.ranges.allocate(count);
+		if (offset != RangeAllocator::invalidOffset)
+		{
+			buffer = page.buffer;
+			return offset;
+		}
+	}
+
+	uint32_t capacity = std::max(pageBytes / stride, count);
+	BufferDesc desc{ capacity * stride, binding, ResourceUsage::Default };
+	pages.push_back({ device.createBuffer(desc, nullptr), stride, RangeAllocator{ capacity } });
+	buffer = pages.back().buffer;
+	return pages.back().ranges.allocate(count);
+}
+
+//Adds a page to byte totals; the largest free block is the largest of any page
+//--------------------------------------------------------------------------
+void GeometryPool::addStats(const Page& page, RangeAllocatorStats& bytes)
+{
+	RangeAllocatorStats units = page.ranges.stats();
+	bytes.capacity += units.capacity * page.stride;
+	bytes.used += units.used * page.stride;
+	bytes.allocations += units.allocations;
+	bytes.freeBlocks += units.freeBlocks;
+	bytes.largestFreeBlock = std::max(bytes.largestFreeBlock, units.largestFreeBlock * page.stride);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "RenderDevice.h"
+#include "RangeAllocator.h"
+
+//Vertices and indices of one mesh inside a GeometryPool
+//Draw with drawIndexed(indexCount, startIndex, baseVertex) after binding the two buffers
+struct GeometryAllocation
+{
+	BufferHandle vertexBuffer;
+	BufferHandle indexBuffer;
+	uint32_t stride{ 0 };
+	uint32_t baseVertex{ 0 };
+	uint32_t vertexCount{ 0 };
+	uint32_t startIndex{ 0 };
+	uint32_t indexCount{ 0 };
+	IndexFormat indexFormat{ IndexFormat::UInt32 };
+
+	bool isValid() const { return vertexBuffer.isValid() && indexBuffer.isValid(); }
+};
+
+//Pool occupancy summed over pages, in bytes
+struct GeometryPoolStats
+{
+	uint32_t vertexPages{ 0 };
+	uint32_t indexPages{ 0 };
+	RangeAllocatorStats vertexBytes;
+	RangeAllocatorStats indexBytes;
+	uint64_t bytesUploaded{ 0 };
+};
+
+//Meshes sub-allocated from a few large vertex and index buffers
+//Vertex buffers are kept per stride, so every mesh with the same vertex format lands in the
+//same buffer and a whole pass binds it once. Indices are stored as 16 bit whenever the mesh
+//has at most 65536 vertices (they are relative to baseVertex), otherwise as 32 bit. The
+//pool works in pages: when a mesh does not fit in any buffer of its kind, another page of
+//the configured size (or larger for a huge mesh) is created rather than copying the old one.
+//Ranges come from a best fit RangeAllocator in vertex / index units, so baseVertex and
+//startIndex can be used as they are. Buffers are Default usage and filled with updateBuffer
+class GeometryPool
+{
+public:
+
+	GeometryPool(IRenderDevice& device, uint32_t vertexPageBytes, uint32_t indexPageBytes);
+	~GeometryPool();
+
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	//Copies the mesh into the pool; vertices are stride bytes apart. Only fails, with an
+	//invalid allocation, for empty meshes
+	GeometryAllocation allocate(IRenderContext& context, const void* vertices, uint32_t vertexCount, uint32_t stride,
+		const uint32_t* indices, uint32_t indexCount);
+
+	//Same with indices already in their final format, they are uploaded as they are. For data
+	//that is stored ready for the device, such as a memory mapped MeshAsset
+	GeometryAllocation allocate(IRenderContext& context, const void* vertices, uint32_t vertexCount, uint32_t stride,
+		const void* indices, IndexFormat indexFormat, uint32_t indexCount);
+	void free(const GeometryAllocation& allocation);
+
+	//Binds the buffers of an allocation to vertex slot 0 and the index buffer
+	static void bind(IRenderContext& context, const GeometryAllocation& allocation)
+	{
+		const uint32_t offset{ 0 };
+		context.setVertexBuffers(0, 1, &allocation.vertexBuffer, &allocation.stride, &offset);
+		context.setIndexBuffer(allocation.indexBuffer, allocation.indexFormat, 0);
+	}
+
+	GeometryPoolStats stats() const;
+
+private:
+
+	struct Page
+	{
+		BufferHandle buffer;
+		uint32_t stride;		//bytes per allocator unit: the vertex stride, or the index size
+		RangeAllocator ranges;
+	};
+
+	static Page* findPage(std::vector<Page>& pages, BufferHandle buffer);
+	uint32_t allocateIn(std::vector<Page>& pages, BufferBinding binding, uint32_t stride, uint32_t count, uint32_t pageBytes, BufferHandle& buffer);
+	static void addStats(const Page& page, RangeAllocatorStats& bytes);
+
+	IRenderDevice& device;
+	uint32_t vertexPageBytes;
+	uint32_t indexPageBytes;
+	std::vector<Page> vertexPages;
+	std::vector<Page> indexPages;
+	uint64_t bytesUploaded{ 0 };
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//64 bit FNV-1a. Not cryptographic, used for name lookups and cache keys
+const uint64_t fnv1aOffsetBasis{ 14695981039346656037ull };
+const uint64_t fnv1aPrime{ 1099511628211ull };
+
+//Pass the previous result as hash to continue hashing across several buffers
+//------------------------------------------------------------------------------------------
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = fnv1aOffsetBasis)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i{ 0 }; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= fnv1aPrime;
+	}
+	return hash;
+}
+
+//----------------------------------------------------------------------------------
+inline uint64_t fnv1a64(const std::string& text, uint64_t hash = fnv1aOffsetBasis)
+{
+	return fnv1a64(text.data(), text.size(), hash);
+}
@@ -0,0 +1,68 @@
+#include "InputQueue.h"
+
+//----------------------------------------------
+void InputState::apply(const InputEvent& event)
+{
+	const uint32_t word{ event.code >> 6 };
+	const uint64_t bit{ uint64_t{ 1 } << (event.code & 63) };
+	switch (event.type)
+	{
+	case InputEventType::KeyDown:
+		if (event.code < keyCount && (down[word] & bit) == 0)
+		{
+			down[word] |= bit;
+			pressed[word] |= bit;
+		}
+		break;
+	case InputEventType::KeyUp:
+		if (event.code < keyCount && (down[word] & bit) != 0)
+		{
+			down[word] &= ~bit;
+			released[word] |= bit;
+		}
+		break;
+	case InputEventType::MouseButtonDown:
+	case InputEventType::MouseButtonUp:
+	case InputEventType::MouseMove:
+		//Mouse messages carry the buttons held after the event
+		buttons = event.code;
+		if (mouseKnown)
+		{
+			deltaX += event.x - x;
+			deltaY += event.y - y;
+		}
+		x = event.x;
+		y = event.y;
+		mouseKnown = true;
+		break;
+	case InputEventType::FocusLost:
+		releaseAll();
+		break;
+	default:
+		break;
+	}
+}
+
+//----------------------------
+void InputState::beginFrame()
+{
+	for (uint32_t i{ 0 }; i < keyCount / 64; i++)
+	{
+		pressed[i] = 0;
+		released[i] = 0;
+	}
+	deltaX = 0;
+	deltaY = 0;
+}
+
+//----------------------------
+void InputState::releaseAll()
+{
+	for (uint32_t i{ 0 }; i < keyCount / 64; i++)
+	{
+		down[i] = 0;
+	}
+	buttons = 0;
+	//The cursor may come back anywhere
+	mouseKnown = false;
+}
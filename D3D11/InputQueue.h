@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//Lock free single producer / single consumer ring
+//One thread pushes and one other thread pops, neither ever blocks. Both indices only
+//grow; each side keeps a copy of the other side's index and only reloads it when the
+//ring looks full (or empty), so the shared cache lines are touched about once per burst
+template <typename T>
+class SpscQueue
+{
+public:
+
+	//Capacity is rounded up to a power of two
+	explicit SpscQueue(size_t capacity = 1024)
+	{
+		size_t size{ 1 };
+		while (size < capacity)
+		{
+			size *= 2;
+		}
+		slots.reset(new T[size]);
+		mask = size - 1;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	//Producer thread only, false if the ring is full
+	bool push(const T& item)
+	{
+		const uint64_t write = head.load(std::memory_order_relaxed);
+		if (write - cachedTail > mask)
+		{
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (write - cachedTail > mask)
+			{
+				return false;
+			}
+		}
+		slots[write & mask] = item;
+		head.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	//Consumer thread only, false if the ring is empty
+	bool pop(T& item)
+	{
+		const uint64_t read = tail.load(std::memory_order_relaxed);
+		if (read == cachedHead)
+		{
+			cachedHead = head.load(std::memory_order_acquire);
+			if (read == cachedHead)
+			{
+				return false;
+			}
+		}
+		item = slots[read & mask];
+		tail.store(read + 1, std::memory_order_release);
+		return true;
+	}
+
+	//Exact on either side's thread when the other is idle, a snapshot otherwise
+	size_t size() const
+	{
+		return static_cast<size_t>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+	}
+
+	size_t capacity() const { return mask + 1; }
+
+private:
+
+	std::unique_ptr<T[]> slots;
+	size_t mask{ 0 };
+
+	//Producer side
+	alignas(64) std::atomic<uint64_t> head{ 0 };	//next slot to write
+	uint64_t cachedTail{ 0 };
+
+	//Consumer side
+	alignas(64) std::atomic<uint64_t> tail{ 0 };	//next slot to read
+	uint64_t cachedHead{ 0 };
+};
+
+//Events passed from the window thread to the render thread
+//Window events travel the same queue as input so a resize or focus change is seen
+//in order with the keys and clicks around it
+enum class InputEventType : uint8_t
+{
+	KeyDown,
+	KeyUp,
+	MouseButtonDown,
+	MouseButtonUp,
+	MouseMove,
+	FocusLost,		//key and button ups go to another window, release everything
+	Resize,			//x, y : client size, code : 1 if the swap chain should follow now
+	Pause,
+	Resume
+};
+
+struct InputEvent
+{
+	InputEventType type;
+	uint32_t code;	//virtual key for key events, MK_ button flags for mouse events
+	int32_t x;
+	int32_t y;
+	int64_t time;	//profilerNow() when the window thread received the message
+};
+
+//True for the events that come from the user, the ones input to present latency is measured for
+inline bool isUserInput(InputEventType type)
+{
+	return type <= InputEventType::MouseMove;
+}
+
+//Keyboard and mouse state sampled once per frame
+//Events are applied in the order they arrived; held keys are read from the state, so
+//movement follows frame time instead of the OS key repeat rate. A key pressed and
+//released within one frame still reports keyPressed for that frame. Key repeats
+//(KeyDown of a key already down) change nothing
+class InputState
+{
+public:
+
+	static const uint32_t keyCount{ 256 };
+
+	void apply(const InputEvent& event);
+
+	//Clears the pressed / released edges and the mouse movement of the last frame
+	void beginFrame();
+
+	//Releases every key and button without reporting them as released
+	void releaseAll();
+
+	bool keyDown(uint32_t key) const { return test(down, key); }
+	bool keyPressed(uint32_t key) const { return test(pressed, key); }
+	bool keyReleased(uint32_t key) const { return test(released, key); }
+
+	uint32_t mouseButtons() const { return buttons; }
+	int32_t mouseX() const { return x; }
+	int32_t mouseY() const { return y; }
+	//Mouse movement since beginFrame, pixels
+	int32_t mouseDeltaX() const { return deltaX; }
+	int32_t mouseDeltaY() const { return deltaY; }
+
+private:
+
+	static bool test(const uint64_t bits[], uint32_t key) { return key < keyCount && (bits[key >> 6] >> (key & 63) & 1) != 0; }
+
+	uint64_t down[keyCount / 64]{};
+	uint64_t pressed[keyCount / 64]{};
+	uint64_t released[keyCount / 64]{};
+	uint32_t buttons{ 0 };
+	int32_t x{ 0 };
+	int32_t y{ 0 };
+	int32_t deltaX{ 0 };
+	int32_t deltaY{ 0 };
+	bool mouseKnown{ false };	//no delta for the first position
+};
+
+//Events taken from the queue for one frame
+struct InputFrame
+{
+	size_t eventCount{ 0 };
+	int64_t oldestInputTime{ 0 };	//receive time of the earliest user input event, 0 if there was none
+};
+
+//Starts a frame of state and applies the events queued so far, calling handler(event) after each
+//Events pushed while draining wait for the next frame, so a flood of mouse moves can't hold a frame back
+//-------------------------------------------------------------------------------------------
+template <typename Handler>
+InputFrame drainInput(SpscQueue<InputEvent>& queue, InputState& state, Handler&& handler)
+{
+	InputFrame frame;
+	state.beginFrame();
+
+	const size_t queued = queue.size();
+	InputEvent event;
+	while (frame.eventCount < queued && queue.pop(event))
+	{
+		frame.eventCount++;
+		if (isUserInput(event.type) && (frame.oldestInputTime == 0 || event.time < frame.oldestInputTime))
+		{
+			frame.oldestInputTime = event.time;
+		}
+		state.apply(event);
+		handler(event);
+	}
+	return frame;
+}
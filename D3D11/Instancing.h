@@ -0,0 +1,96 @@
+#pragma once
+#include "Lighting.h"
+#include <cstdint>
+#include <vector>
+
+//Instance flag bits, mirrored in Box.hlsl
+enum InstanceFlags : uint32_t
+{
+	INSTANCE_USE_TEXTURE = 1 << 0,
+	INSTANCE_CLIP_ALPHA = 1 << 1
+};
+
+//Per instance vertex stream data (input slot 1)
+//The world matrix is stored row major as each WORLD semantic is read as a matrix row in hlsl
+struct InstanceData
+{
+	XMFLOAT4X4 world;
+	Material material;
+	uint32_t flags;
+	uint32_t pad[3];
+};
+
+//Packs per instance data into a contiguous array ready to be copied into the
+//per instance buffer. Storage is kept between frames so packing does not allocate
+//once the high water mark has been reached
+class InstancePacker
+{
+public:
+
+	//----------------------------
+	void reserve(size_t count)
+	{
+		instances.reserve(count);
+	}
+
+	//----------------
+	void clear()
+	{
+		instances.clear();
+	}
+
+	//-------------------------------------------------------------------------
+	void add(FXMMATRIX world, const Material& material, uint32_t flags)
+	{
+		instances.emplace_back();
+		InstanceData& instance = instances.back();
+		XMStoreFloat4x4(&instance.world, world);
+		instance.material = material;
+		instance.flags = flags;
+	}
+
+	//Fast path for translated copies, skips the matrix store
+	//------------------------------------------------------------------------------------------
+	void addTranslation(const XMFLOAT3& translation, const Material& material, uint32_t flags)
+	{
+		instances.emplace_back();
+		InstanceData& instance = instances.back();
+		instance.world = XMFLOAT4X4{ 1.0f, 0.0f, 0.0f, 0.0f,
+									 0.0f, 1.0f, 0.0f, 0.0f,
+									 0.0f, 0.0f, 1.0f, 0.0f,
+									 translation.x, translation.y, translation.z, 1.0f };
+		instance.material = material;
+		instance.flags = flags;
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	void addTranslations(const XMFLOAT3 translations[], size_t count, const Material& material, uint32_t flags)
+	{
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			addTranslation(translations[i], material, flags);
+		}
+	}
+
+	//------------------------------------
+	const InstanceData* data() const
+	{
+		return instances.data();
+	}
+
+	//-------------------------
+	size_t count() const
+	{
+		return instances.size();
+	}
+
+	//------------------------------
+	size_t sizeInBytes() const
+	{
+		return instances.size() * sizeof(InstanceData);
+	}
+
+private:
+
+	std::vector<InstanceData> instances;
+};
\ No newline at end of file
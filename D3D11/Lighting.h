@@ -1,9 +1,12 @@
 #pragma once
-#include "d3dUtil.h"
+#include <DirectXMath.h>
+#include <cstring>
+
+using namespace DirectX;
 
 struct Material
 {
-	Material() { ZeroMemory(this, sizeof(this)); }
+	Material() { memset(this, 0, sizeof(*this)); }
 
 	XMFLOAT4 ambientColor;
 	XMFLOAT4 diffuseColor;
@@ -12,7 +15,7 @@ struct Material
 
 struct DirectLight
 {
-	DirectLight() { ZeroMemory(this, sizeof(this)); }
+	DirectLight() { memset(this, 0, sizeof(*this)); }
 
 	XMFLOAT4 ambientColor;
 	XMFLOAT4 diffuseColor;
@@ -23,7 +26,7 @@ struct DirectLight
 
 struct PointLight
 {
-	PointLight() { ZeroMemory(this, sizeof(this)); }
+	PointLight() { memset(this, 0, sizeof(*this)); }
 
 	XMFLOAT4 ambientColor;
 	XMFLOAT4 diffuseColor;
@@ -40,7 +43,7 @@ struct PointLight
 
 struct SpotLight
 {
-	SpotLight() { ZeroMemory(this, sizeof(this)); }
+	SpotLight() { memset(this, 0, sizeof(*this)); }
 
 	XMFLOAT4 ambientColor;
 	XMFLOAT4 diffuseColor;
@@ -0,0 +1,108 @@
+#pragma once
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//Picks a level of detail per instance from the projected size of its bounding sphere
+//A level is good enough while its error, scaled by the projected size, stays within
+//maxPixelError on screen. The selector drops to a coarser level only once that level is
+//under maxPixelError * (1 - hysteresis), and goes back to a finer one as soon as the
+//current level is over maxPixelError, so an object sitting at a switch distance does not
+//flicker between two levels from frame to frame
+class LodSelector
+{
+public:
+
+	explicit LodSelector(float maxPixelError = 1.0f, float hysteresis = 0.25f) :
+		maxPixelError{ maxPixelError }, hysteresis{ hysteresis }
+	{
+	}
+
+	//Instances start at level 0
+	//------------------------------
+	void resize(size_t instanceCount)
+	{
+		levels.assign(instanceCount, 0);
+	}
+
+	//Radius of a bounding sphere on screen in pixels, for a sphere viewDepth in front of the
+	//camera. proj22 is _22 of the projection matrix, 1 / tan(fovY / 2). Unbounded once the
+	//camera is inside the sphere, which selects level 0
+	//-------------------------------------------------------------------------------------------------
+	static float projectedRadius(float radius, float viewDepth, float proj22, float viewportHeight)
+	{
+		if (viewDepth <= radius)
+		{
+			return std::numeric_limits<float>::max();
+		}
+		return radius * proj22 * 0.5f * viewportHeight / viewDepth;
+	}
+
+	//Level for the instance this frame. radius is the local bounding sphere radius the level
+	//errors are measured against, screenRadius its projectedRadius
+	//--------------------------------------------------------------------------------------------------
+	uint32_t select(size_t instance, const std::vector<MeshLod>& lods, float radius, float screenRadius)
+	{
+		if (lods.size() < 2 || radius <= 0.0f)
+		{
+			return levels[instance] = 0;
+		}
+
+		const float pixelsPerUnit = screenRadius / radius;
+		uint32_t level = std::min<uint32_t>(levels[instance], static_cast<uint32_t>(lods.size() - 1));
+
+		//Too coarse: the finest level that is over the limit is replaced at once
+		while (level > 0 && lods[level].error * pixelsPerUnit > maxPixelError)
+		{
+			level--;
+		}
+
+		//Coarser levels have to clear the limit with some margin
+		const float coarsenError = maxPixelError * (1.0f - hysteresis);
+		while (level + 1 < lods.size() && lods[level + 1].error * pixelsPerUnit <= coarsenError)
+		{
+			level++;
+		}
+
+		levels[instance] = static_cast<uint8_t>(level);
+		return level;
+	}
+
+	//Level chosen by the last select for the instance
+	uint32_t level(size_t instance) const { return levels[instance]; }
+
+	//Orders instances by their last selected level, keeping their order within a level, so
+	//every level is one run for a single instanced draw. levelCounts receives the length of
+	//each run; levels past levelCount - 1 join the last run, as Model::lod clamps them
+	//-------------------------------------------------------------------------------------------------
+	void groupByLevel(const std::vector<uint32_t>& instances, uint32_t levelCount, std::vector<uint32_t>& grouped, std::vector<uint32_t>& levelCounts) const
+	{
+		levelCount = std::min(std::max(levelCount, 1u), 256u);
+		levelCounts.assign(levelCount, 0);
+		for (uint32_t instance : instances)
+		{
+			levelCounts[std::min<uint32_t>(levels[instance], levelCount - 1)]++;
+		}
+
+		uint32_t next[256];
+		uint32_t start{ 0 };
+		for (uint32_t level{ 0 }; level < levelCount; level++)
+		{
+			next[level] = start;
+			start += levelCounts[level];
+		}
+		grouped.resize(instances.size());
+		for (uint32_t instance : instances)
+		{
+			grouped[next[std::min<uint32_t>(levels[instance], levelCount - 1)]++] = instance;
+		}
+	}
+
+private:
+
+	float maxPixelError;
+	float hysteresis;
+	std::vector<uint8_t> levels;
+};
@@ -0,0 +1,174 @@
+#include "MappedFile.h"
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//----------------------
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+//-------------------------------------------------
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	swap(other);
+}
+
+//------------------------------------------------------------
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		swap(other);
+	}
+	return *this;
+}
+
+//-------------------------------------------
+void MappedFile::swap(MappedFile& other) noexcept
+{
+	std::swap(mappedData, other.mappedData);
+	std::swap(mappedSize, other.mappedSize);
+	std::swap(opened, other.opened);
+#if defined(_WIN32)
+	std::swap(fileHandle, other.fileHandle);
+	std::swap(mappingHandle, other.mappingHandle);
+#endif
+}
+
+#if defined(_WIN32)
+
+//----------------------------------------------------
+bool MappedFile::open(const std::string& fileName)
+{
+	close();
+
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	opened = true;
+
+	//Zero sized files cannot be mapped
+	if (fileSize.QuadPart == 0)
+	{
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		close();
+		return false;
+	}
+	mappedData = static_cast<const uint8_t*>(view);
+	mappedSize = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+//-----------------------
+void MappedFile::close()
+{
+	if (mappedData != nullptr)
+	{
+		UnmapViewOfFile(mappedData);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr)
+	{
+		CloseHandle(fileHandle);
+	}
+	mappedData = nullptr;
+	mappedSize = 0;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+	opened = false;
+}
+
+#else
+
+//----------------------------------------------------
+bool MappedFile::open(const std::string& fileName)
+{
+	close();
+
+	int file = ::open(fileName.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat fileInfo;
+	if (fstat(file, &fileInfo) != 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	opened = true;
+	if (fileInfo.st_size == 0)
+	{
+		::close(file);
+		return true;
+	}
+
+	//The mapping keeps its own reference to the file, the descriptor is not needed afterwards
+	void* view = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (view == MAP_FAILED)
+	{
+		opened = false;
+		return false;
+	}
+	mappedData = static_cast<const uint8_t*>(view);
+	mappedSize = static_cast<size_t>(fileInfo.st_size);
+	return true;
+}
+
+//-----------------------
+void MappedFile::close()
+{
+	if (mappedData != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+	}
+	mappedData = nullptr;
+	mappedSize = 0;
+	opened = false;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//Read-only memory mapping of a whole file
+//The mapping lives as long as the object, pointers into data() are invalidated
+//by close, open or destruction. Empty files open successfully with size 0
+class MappedFile
+{
+public:
+
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	//Returns false if the file cannot be opened or mapped
+	bool open(const std::string& fileName);
+	void close();
+
+	bool isOpen() const { return opened; }
+	const uint8_t* data() const { return mappedData; }
+	size_t size() const { return mappedSize; }
+
+private:
+
+	void swap(MappedFile& other) noexcept;
+
+	const uint8_t* mappedData{ nullptr };
+	size_t mappedSize{ 0 };
+	bool opened{ false };
+#if defined(_WIN32)
+	void* fileHandle{ nullptr };
+	void* mappingHandle{ nullptr };
+#endif
+};
@@ -1,14 +1,55 @@
 #pragma once
 #include "Model.h"
+#include "Parallel.h"
+#include <algorithm>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
 
+//Local space AABB and bounding sphere of a vertex array
+//The sphere is centered on the AABB and encloses every vertex
+//---------------------------------------------------------
 template <typename T>
-void calculateNormals(T vertices[], int numVertices, UINT indices[], int numTriangles)
+Bounds calculateBounds(const T vertices[], int numVertices)
 {
-	for (size_t i{ 0 }; i < numTriangles; i++)
+	Bounds bounds;
+	if (numVertices <= 0)
 	{
-		UINT i0 = indices[i * 3 + 0];
-		UINT i1 = indices[i * 3 + 1];
-		UINT i2 = indices[i * 3 + 2];
+		return bounds;
+	}
+
+	XMVECTOR aabbMin = XMLoadFloat3(&(vertices[0].position));
+	XMVECTOR aabbMax = aabbMin;
+	for (int i{ 1 }; i < numVertices; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&(vertices[i].position));
+		aabbMin = XMVectorMin(aabbMin, position);
+		aabbMax = XMVectorMax(aabbMax, position);
+	}
+
+	XMVECTOR center = (aabbMin + aabbMax) * 0.5f;
+	XMVECTOR radiusSq = XMVectorZero();
+	for (int i{ 0 }; i < numVertices; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&(vertices[i].position));
+		radiusSq = XMVectorMax(radiusSq, XMVector3LengthSq(position - center));
+	}
+
+	XMStoreFloat3(&bounds.aabbMin, aabbMin);
+	XMStoreFloat3(&bounds.aabbMax, aabbMax);
+	XMStoreFloat3(&bounds.center, center);
+	bounds.radius = XMVectorGetX(XMVectorSqrt(radiusSq));
+	return bounds;
+}
+
+template <typename T>
+void calculateNormals(T vertices[], int numVertices, const uint32_t indices[], int numTriangles)
+{
+	for (size_t i{ 0 }; i < static_cast<size_t>(numTriangles); i++)
+	{
+		uint32_t i0 = indices[i * 3 + 0];
+		uint32_t i1 = indices[i * 3 + 1];
+		uint32_t i2 = indices[i * 3 + 2];
 
 		XMVECTOR vertex1 = XMLoadFloat3(&(vertices[i0].position));
 		XMVECTOR vertex2 = XMLoadFloat3(&(vertices[i1].position));
@@ -32,10 +73,214 @@ void calculateNormals(T vertices[], int numVertices, UINT indices[], int numTria
 		XMStoreFloat3(&(vertices[i2].normal), normal3);
 	}
 
-	for (size_t i{ 0 }; i < numVertices; i++)
+	for (size_t i{ 0 }; i < static_cast<size_t>(numVertices); i++)
 	{
 		XMVECTOR normal = XMLoadFloat3(&(vertices[i].normal));
 		normal = XMVector3Normalize(normal);
 		XMStoreFloat3(&(vertices[i].normal), normal);
 	}
-}
\ No newline at end of file
+}
+
+//Batch normalize of 4 float wide normals (w is ignored and written as 0)
+//Uses the reciprocal square root estimate refined with one Newton-Raphson step
+//which is accurate to roughly 1e-7 relative error. Zero length normals stay zero
+//----------------------------------------------------------------------------
+inline void normalizeBatch(XMFLOAT4A normals[], size_t count)
+{
+	size_t i{ 0 };
+#if defined(_XM_SSE_INTRINSICS_)
+#if defined(__AVX__)
+	const __m256 half8 = _mm256_set1_ps(0.5f);
+	const __m256 three8 = _mm256_set1_ps(3.0f);
+	const __m256 zero8 = _mm256_setzero_ps();
+	for (; i + 8 <= count; i += 8)
+	{
+		float* base = &normals[i].x;
+
+		//AoS -> SoA for 8 normals (two 4x4 transposes packed into 256 bit lanes)
+		__m256 r0 = _mm256_loadu2_m128(base + 16, base + 0);
+		__m256 r1 = _mm256_loadu2_m128(base + 20, base + 4);
+		__m256 r2 = _mm256_loadu2_m128(base + 24, base + 8);
+		__m256 r3 = _mm256_loadu2_m128(base + 28, base + 12);
+		__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+		__m256 t1 = _mm256_unpackhi_ps(r0, r1);
+		__m256 t2 = _mm256_unpacklo_ps(r2, r3);
+		__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+		__m256 x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+		__m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+		__m256 estimate = _mm256_rsqrt_ps(lengthSq);
+		//Newton-Raphson : e' = 0.5 * e * (3 - l * e * e)
+		__m256 refined = _mm256_mul_ps(_mm256_mul_ps(half8, estimate),
+			_mm256_sub_ps(three8, _mm256_mul_ps(lengthSq, _mm256_mul_ps(estimate, estimate))));
+		refined = _mm256_and_ps(refined, _mm256_cmp_ps(lengthSq, zero8, _CMP_GT_OQ));
+
+		x = _mm256_mul_ps(x, refined);
+		y = _mm256_mul_ps(y, refined);
+		z = _mm256_mul_ps(z, refined);
+
+		//SoA -> AoS
+		t0 = _mm256_unpacklo_ps(x, y);
+		t1 = _mm256_unpackhi_ps(x, y);
+		t2 = _mm256_unpacklo_ps(z, zero8);
+		t3 = _mm256_unpackhi_ps(z, zero8);
+		r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		_mm256_storeu2_m128(base + 16, base + 0, r0);
+		_mm256_storeu2_m128(base + 20, base + 4, r1);
+		_mm256_storeu2_m128(base + 24, base + 8, r2);
+		_mm256_storeu2_m128(base + 28, base + 12, r3);
+	}
+#endif
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 three = _mm_set1_ps(3.0f);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_load_ps(&normals[i + 0].x);
+		__m128 y = _mm_load_ps(&normals[i + 1].x);
+		__m128 z = _mm_load_ps(&normals[i + 2].x);
+		__m128 w = _mm_load_ps(&normals[i + 3].x);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 estimate = _mm_rsqrt_ps(lengthSq);
+		__m128 refined = _mm_mul_ps(_mm_mul_ps(half, estimate),
+			_mm_sub_ps(three, _mm_mul_ps(lengthSq, _mm_mul_ps(estimate, estimate))));
+		refined = _mm_and_ps(refined, _mm_cmpgt_ps(lengthSq, zero));
+
+		x = _mm_mul_ps(x, refined);
+		y = _mm_mul_ps(y, refined);
+		z = _mm_mul_ps(z, refined);
+		w = zero;
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_store_ps(&normals[i + 0].x, x);
+		_mm_store_ps(&normals[i + 1].x, y);
+		_mm_store_ps(&normals[i + 2].x, z);
+		_mm_store_ps(&normals[i + 3].x, w);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		XMVECTOR normal = XMLoadFloat4A(&normals[i]);
+		normal = XMVectorSetW(XMVector3Normalize(normal), 0.0f);
+		XMStoreFloat4A(&normals[i], normal);
+	}
+}
+
+//Multithreaded version of calculateNormals for large meshes
+//The vertices are split into power of two sized ranges, a few per worker for balance,
+//and every range owns its normals outright, so no locks or atomics are needed. Pass 1 bins
+//the triangles, one contiguous run per worker, by the ranges their corners fall in.
+//Pass 2 sums the face normals of each range's bins in triangle order and normalizes
+//them with normalizeBatch. Scratch memory is one index per triangle and range it
+//touches (one for most triangles) plus one XMFLOAT4A per vertex, whatever the number
+//of workers or the index order. The sums are bitwise those of calculateNormals, results
+//match to within 1e-6 per component on unit normals because of the rsqrt based normalize.
+//With a single range it is calculateNormals
+//------------------------------------------------------------------------------------------
+template <typename T>
+void calculateNormalsParallel(T vertices[], int numVertices, const uint32_t indices[], int numTriangles)
+{
+	const size_t minTrianglesPerChunk{ 16384 };
+	const size_t minVerticesPerRange{ 4096 };
+	const size_t triangleCount{ static_cast<size_t>(std::max(numTriangles, 0)) };
+	const size_t vertexCount{ static_cast<size_t>(std::max(numVertices, 0)) };
+
+	const size_t workerRanges = parallelChunkCount(vertexCount, minVerticesPerRange);
+	if (workerRanges <= 1)
+	{
+		calculateNormals(vertices, numVertices, indices, numTriangles);
+		return;
+	}
+	uint32_t rangeShift{ 0 };
+	while ((size_t{ 1 } << rangeShift) * workerRanges * 4 < vertexCount)
+	{
+		rangeShift++;
+	}
+	const size_t rangeCount{ ((vertexCount - 1) >> rangeShift) + 1 };
+
+	//bins[chunk * rangeCount + range] : triangles of the chunk with a corner in the range
+	std::vector<std::vector<uint32_t>> bins(parallelChunkCount(triangleCount, minTrianglesPerChunk) * rangeCount);
+
+	//Pass 1 : bin triangles by vertex range, counted first so every bin is allocated once
+	parallelFor(triangleCount, minTrianglesPerChunk, [&](size_t chunk, size_t begin, size_t end)
+	{
+		std::vector<uint32_t>* chunkBins = bins.data() + chunk * rangeCount;
+		auto forEachRange = [&](auto&& binTriangle)
+		{
+			for (size_t i{ begin }; i < end; i++)
+			{
+				const uint32_t range0{ indices[i * 3 + 0] >> rangeShift };
+				const uint32_t range1{ indices[i * 3 + 1] >> rangeShift };
+				const uint32_t range2{ indices[i * 3 + 2] >> rangeShift };
+				binTriangle(range0, i);
+				if (range1 != range0)
+				{
+					binTriangle(range1, i);
+				}
+				if (range2 != range0 && range2 != range1)
+				{
+					binTriangle(range2, i);
+				}
+			}
+		};
+
+		std::vector<size_t> counts(rangeCount, 0);
+		forEachRange([&](uint32_t range, size_t) { counts[range]++; });
+		for (size_t range{ 0 }; range < rangeCount; range++)
+		{
+			chunkBins[range].reserve(counts[range]);
+		}
+		forEachRange([&](uint32_t range, size_t triangle) { chunkBins[range].push_back(static_cast<uint32_t>(triangle)); });
+	});
+
+	//Pass 2 : sum the face normals of each range in triangle order, normalize and write back
+	const size_t chunkCount{ bins.size() / rangeCount };
+	parallelFor(rangeCount, 1, [&](size_t, size_t firstRange, size_t lastRange)
+	{
+		std::vector<XMFLOAT4A> sums;
+		for (size_t range{ firstRange }; range < lastRange; range++)
+		{
+			const size_t begin{ range << rangeShift };
+			const size_t end{ std::min<size_t>(vertexCount, (range + 1) << rangeShift) };
+
+			//Start from the existing vertex normal, as calculateNormals does
+			sums.resize(end - begin);
+			for (size_t v{ begin }; v < end; v++)
+			{
+				XMStoreFloat4A(&sums[v - begin], XMLoadFloat3(&(vertices[v].normal)));
+			}
+
+			for (size_t chunk{ 0 }; chunk < chunkCount; chunk++)
+			{
+				for (uint32_t triangle : bins[chunk * rangeCount + range])
+				{
+					const uint32_t* corners = indices + size_t{ triangle } * 3;
+					XMVECTOR vertex1 = XMLoadFloat3(&(vertices[corners[0]].position));
+					XMVECTOR vertex2 = XMLoadFloat3(&(vertices[corners[1]].position));
+					XMVECTOR vertex3 = XMLoadFloat3(&(vertices[corners[2]].position));
+					XMVECTOR normal = XMVector3Cross(vertex2 - vertex1, vertex3 - vertex1);
+					for (int corner{ 0 }; corner < 3; corner++)
+					{
+						if ((corners[corner] >> rangeShift) == range)
+						{
+							XMFLOAT4A& sum = sums[corners[corner] - begin];
+							XMStoreFloat4A(&sum, XMLoadFloat4A(&sum) + normal);
+						}
+					}
+				}
+			}
+
+			normalizeBatch(sums.data(), sums.size());
+			for (size_t v{ begin }; v < end; v++)
+			{
+				XMStoreFloat3(&(vertices[v].normal), XMLoadFloat4A(&sums[v - begin]));
+			}
+		}
+	});
+}
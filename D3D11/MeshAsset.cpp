@@ -0,0 +1,298 @@
+#include "MeshAsset.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+const MeshAssetAttribute vertexNormTexLayout[3]
+{
+	{ MeshSemantic::Position, 0, static_cast<uint32_t>(VertexFormat::Float3), 0 },
+	{ MeshSemantic::Normal, 0, static_cast<uint32_t>(VertexFormat::Float3), 12 },
+	{ MeshSemantic::TexCoord, 0, static_cast<uint32_t>(VertexFormat::Float2), 24 }
+};
+
+const MeshAssetAttribute vertexNormTexPackedLayout[3]
+{
+	{ MeshSemantic::Position, 0, static_cast<uint32_t>(VertexFormat::UShort4Norm), 0 },
+	{ MeshSemantic::Normal, 0, static_cast<uint32_t>(VertexFormat::Short2Norm), 8 },
+	{ MeshSemantic::TexCoord, 0, static_cast<uint32_t>(VertexFormat::Half2), 12 }
+};
+
+namespace
+{
+	//----------------------------------------------------
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//Bytes of a vertex format, 0 for values no VertexFormat has
+	//-----------------------------------------
+	uint32_t vertexFormatSize(uint32_t format)
+	{
+		switch (static_cast<VertexFormat>(format))
+		{
+		case VertexFormat::Float2: return 8;
+		case VertexFormat::Float3: return 12;
+		case VertexFormat::Float4: return 16;
+		case VertexFormat::UInt1: return 4;
+		case VertexFormat::UShort4Norm: return 8;
+		case VertexFormat::Short2Norm: return 4;
+		case VertexFormat::Half2: return 4;
+		}
+		return 0;
+	}
+
+	//Copies count table entries from the mapping, returns the offset after them or 0 if they do not fit
+	//------------------------------------------------------------------------------------------------
+	template <typename T>
+	uint64_t readTable(const MappedFile& file, uint64_t offset, uint32_t count, std::vector<T>& table)
+	{
+		const uint64_t end = offset + uint64_t{ count } * sizeof(T);
+		if (end > file.size())
+		{
+			return 0;
+		}
+		table.resize(count);
+		if (count > 0)
+		{
+			memcpy(table.data(), file.data() + offset, table.size() * sizeof(T));
+		}
+		return end;
+	}
+}
+
+//------------------------------------------------------
+bool MeshAsset::open(const std::string& fileName)
+{
+	close();
+	if (!file.open(fileName) || file.size() < sizeof(MeshAssetHeader))
+	{
+		close();
+		return false;
+	}
+
+	memcpy(&header, file.data(), sizeof(header));
+	if (header.magic != meshAssetMagic || header.version != meshAssetVersion ||
+		header.alignment == 0 || (header.alignment & (header.alignment - 1)) != 0 ||
+		header.vertexStride == 0 || (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)))
+	{
+		close();
+		return false;
+	}
+
+	//The tables are small, copying them avoids unaligned reads from the mapping
+	uint64_t offset = readTable(file, sizeof(MeshAssetHeader), header.attributeCount, attributes);
+	offset = offset == 0 ? 0 : readTable(file, offset, header.submeshCount, submeshes);
+	offset = offset == 0 ? 0 : readTable(file, offset, header.lodCount, lods);
+
+	const uint64_t vertexBytes = uint64_t{ header.vertexCount } * header.vertexStride;
+	const uint64_t indexBytes = uint64_t{ header.indexCount } * header.indexSize;
+	bool blobsInRange = offset != 0 &&
+		header.vertexOffset >= offset && header.vertexOffset <= file.size() && vertexBytes <= file.size() - header.vertexOffset &&
+		header.indexOffset >= offset && header.indexOffset <= file.size() && indexBytes <= file.size() - header.indexOffset &&
+		header.vertexOffset % header.alignment == 0 && header.indexOffset % header.alignment == 0;
+	if (!blobsInRange || (header.indexSize == sizeof(uint16_t) && !fitsIndex16(header.vertexCount)))
+	{
+		close();
+		return false;
+	}
+
+	for (const MeshAssetAttribute& attribute : attributes)
+	{
+		const uint32_t size = vertexFormatSize(attribute.format);
+		if (size == 0 || uint64_t{ attribute.offset } + size > header.vertexStride)
+		{
+			close();
+			return false;
+		}
+	}
+	for (const MeshAssetLod& lod : lods)
+	{
+		if (uint64_t{ lod.startIndex } + lod.indexCount > header.indexCount)
+		{
+			close();
+			return false;
+		}
+	}
+	for (const MeshAssetSubmesh& submesh : submeshes)
+	{
+		if (submesh.lodCount == 0 || uint64_t{ submesh.firstLod } + submesh.lodCount > lods.size())
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+//------------------------
+void MeshAsset::close()
+{
+	header = MeshAssetHeader{};
+	attributes.clear();
+	submeshes.clear();
+	lods.clear();
+	file.close();
+}
+
+//--------------------------------------------------------------------------------------------------------
+bool MeshAsset::hasLayout(const MeshAssetAttribute* layout, size_t attributeCount, uint32_t stride) const
+{
+	if (stride != header.vertexStride || attributeCount != attributes.size())
+	{
+		return false;
+	}
+	for (size_t i{ 0 }; i < attributeCount; i++)
+	{
+		const MeshAssetAttribute& attribute = attributes[i];
+		if (attribute.semantic != layout[i].semantic || attribute.semanticIndex != layout[i].semanticIndex ||
+			attribute.format != layout[i].format || attribute.offset != layout[i].offset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//-----------------------------
+Bounds MeshAsset::bounds() const
+{
+	Bounds bounds;
+	bounds.aabbMin = header.aabbMin;
+	bounds.aabbMax = header.aabbMax;
+	bounds.center = header.center;
+	bounds.radius = header.radius;
+	return bounds;
+}
+
+//-------------------------------------------------------------------
+std::vector<MeshLod> MeshAsset::submeshLods(size_t submesh) const
+{
+	const MeshAssetSubmesh& range = submeshes[submesh];
+	std::vector<MeshLod> levels(range.lodCount);
+	for (uint32_t i{ 0 }; i < range.lodCount; i++)
+	{
+		const MeshAssetLod& lod = lods[range.firstLod + i];
+		levels[i] = { lod.startIndex, lod.indexCount, lod.error };
+	}
+	return levels;
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------
+void MeshAssetWriter::setVertices(const void* data, uint32_t count, uint32_t vertexStride, const MeshAssetAttribute* layout, size_t attributeCount)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	vertices.assign(bytes, bytes + size_t{ count } * vertexStride);
+	vertexCount = count;
+	stride = vertexStride;
+	attributes.assign(layout, layout + attributeCount);
+}
+
+//--------------------------------------------------------------------------
+void MeshAssetWriter::setIndices(const uint32_t* data, size_t indexCount)
+{
+	indices.assign(data, data + indexCount);
+}
+
+//--------------------------------------------------------------------
+bool MeshAssetWriter::addSubmesh(const std::vector<MeshLod>& levels)
+{
+	if (levels.empty())
+	{
+		return false;
+	}
+	for (const MeshLod& level : levels)
+	{
+		if (uint64_t{ level.startIndex } + level.indexCount > indices.size())
+		{
+			return false;
+		}
+	}
+
+	submeshes.push_back({ static_cast<uint32_t>(lods.size()), static_cast<uint32_t>(levels.size()) });
+	for (const MeshLod& level : levels)
+	{
+		lods.push_back({ level.startIndex, level.indexCount, level.error });
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------
+void MeshAssetWriter::serialize(std::vector<uint8_t>& asset) const
+{
+	const bool index16 = fitsIndex16(vertexCount);
+
+	MeshAssetHeader header{};
+	header.magic = meshAssetMagic;
+	header.version = meshAssetVersion;
+	header.alignment = meshAssetAlignment;
+	header.vertexStride = stride;
+	header.vertexCount = vertexCount;
+	header.indexCount = static_cast<uint32_t>(indices.size());
+	header.indexSize = index16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	header.attributeCount = static_cast<uint32_t>(attributes.size());
+	header.submeshCount = static_cast<uint32_t>(submeshes.size());
+	header.lodCount = static_cast<uint32_t>(lods.size());
+	header.aabbMin = bounds.aabbMin;
+	header.aabbMax = bounds.aabbMax;
+	header.center = bounds.center;
+	header.radius = bounds.radius;
+	header.decodeOffset = positionDecode.offset;
+	header.decodeScale = positionDecode.scale;
+
+	//Tables after the header, then the aligned blobs
+	const uint64_t tablesEnd = sizeof(MeshAssetHeader) + attributes.size() * sizeof(MeshAssetAttribute) +
+		submeshes.size() * sizeof(MeshAssetSubmesh) + lods.size() * sizeof(MeshAssetLod);
+	header.vertexOffset = alignUp(tablesEnd, meshAssetAlignment);
+	header.indexOffset = alignUp(header.vertexOffset + vertices.size(), meshAssetAlignment);
+	const uint64_t size = header.indexOffset + uint64_t{ header.indexCount } * header.indexSize;
+
+	asset.assign(static_cast<size_t>(size), 0);
+	uint8_t* destination = asset.data();
+	memcpy(destination, &header, sizeof(header));
+	destination += sizeof(header);
+	if (!attributes.empty())
+	{
+		memcpy(destination, attributes.data(), attributes.size() * sizeof(MeshAssetAttribute));
+		destination += attributes.size() * sizeof(MeshAssetAttribute);
+	}
+	if (!submeshes.empty())
+	{
+		memcpy(destination, submeshes.data(), submeshes.size() * sizeof(MeshAssetSubmesh));
+		destination += submeshes.size() * sizeof(MeshAssetSubmesh);
+	}
+	if (!lods.empty())
+	{
+		memcpy(destination, lods.data(), lods.size() * sizeof(MeshAssetLod));
+	}
+
+	if (!vertices.empty())
+	{
+		memcpy(asset.data() + header.vertexOffset, vertices.data(), vertices.size());
+	}
+	if (index16)
+	{
+		uint16_t* indices16 = reinterpret_cast<uint16_t*>(asset.data() + header.indexOffset);
+		std::copy(indices.begin(), indices.end(), indices16);
+	}
+	else if (!indices.empty())
+	{
+		memcpy(asset.data() + header.indexOffset, indices.data(), indices.size() * sizeof(uint32_t));
+	}
+}
+
+//---------------------------------------------------------------
+bool MeshAssetWriter::write(const std::string& fileName) const
+{
+	std::vector<uint8_t> asset;
+	serialize(asset);
+
+	std::ofstream file{ fileName, std::ios::out | std::ios::binary | std::ios::trunc };
+	if (!file)
+	{
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(asset.data()), asset.size());
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include "Culling.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "RenderDevice.h"
+#include "VertexQuantization.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Cooked mesh asset (.mesh)
+//One vertex and one index buffer with their layout, the bounds and the index ranges of every
+//submesh and level of detail, laid out as
+//	header | attributes | submeshes | levels | padding | vertices | padding | indices
+//Both blobs start on a multiple of the header's alignment and are stored exactly as the device
+//consumes them, all fields are little endian. The file is memory mapped read-only and the
+//blobs go to buffer creation straight from the mapping, nothing is parsed or converted.
+//Written by Tools/CookMesh.cpp
+const uint32_t meshAssetMagic{ 0x4853454D };	//'MESH'
+const uint32_t meshAssetVersion{ 1 };
+const uint32_t meshAssetAlignment{ 64 };
+
+//What a vertex attribute holds
+enum class MeshSemantic : uint32_t { Position, Normal, TexCoord, Color };
+
+struct MeshAssetHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t alignment;
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t indexSize;			//2 or 4 bytes
+	uint32_t attributeCount;
+	uint32_t submeshCount;
+	uint32_t lodCount;
+	XMFLOAT3 aabbMin;
+	XMFLOAT3 aabbMax;
+	XMFLOAT3 center;
+	float radius;
+	XMFLOAT3 decodeOffset;		//PositionDecode of UShort4Norm positions, zero for float positions
+	XMFLOAT3 decodeScale;
+	uint64_t vertexOffset;		//from the start of the file
+	uint64_t indexOffset;
+};
+
+struct MeshAssetAttribute
+{
+	MeshSemantic semantic;
+	uint32_t semanticIndex;
+	uint32_t format;			//VertexFormat
+	uint32_t offset;			//in the vertex
+};
+
+//Levels [firstLod, firstLod + lodCount) of the level table, the full submesh first
+struct MeshAssetSubmesh
+{
+	uint32_t firstLod;
+	uint32_t lodCount;
+};
+
+//Index range of one level, relative to the start of the index blob
+struct MeshAssetLod
+{
+	uint32_t startIndex;
+	uint32_t indexCount;
+	float error;
+};
+
+static_assert(sizeof(MeshAssetHeader) == 120, "MeshAssetHeader layout is part of the file format");
+static_assert(sizeof(MeshAssetAttribute) == 16, "MeshAssetAttribute layout is part of the file format");
+static_assert(sizeof(MeshAssetSubmesh) == 8, "MeshAssetSubmesh layout is part of the file format");
+static_assert(sizeof(MeshAssetLod) == 12, "MeshAssetLod layout is part of the file format");
+
+//Layouts of VertexNormTex and VertexNormTexPacked
+extern const MeshAssetAttribute vertexNormTexLayout[3];
+extern const MeshAssetAttribute vertexNormTexPackedLayout[3];
+
+class MeshAsset
+{
+public:
+
+	//Maps the asset and validates the header, tables and blob ranges, returns false on missing or
+	//corrupt files. Index values are not read, the cooker keeps them below vertexCount
+	bool open(const std::string& fileName);
+	void close();
+
+	//True if the vertices are stride bytes apart and have exactly these attributes in this order
+	bool hasLayout(const MeshAssetAttribute* layout, size_t attributeCount, uint32_t stride) const;
+
+	uint32_t vertexStride() const { return header.vertexStride; }
+	uint32_t vertexCount() const { return header.vertexCount; }
+	uint32_t indexCount() const { return header.indexCount; }
+	IndexFormat indexFormat() const { return header.indexSize == sizeof(uint16_t) ? IndexFormat::UInt16 : IndexFormat::UInt32; }
+
+	//Views into the mapping, valid until close
+	const void* vertexData() const { return file.data() + header.vertexOffset; }
+	const void* indexData() const { return file.data() + header.indexOffset; }
+
+	Bounds bounds() const;
+	PositionDecode positionDecode() const { return { header.decodeOffset, header.decodeScale }; }
+
+	size_t submeshCount() const { return submeshes.size(); }
+	//Levels of a submesh, the full submesh first
+	std::vector<MeshLod> submeshLods(size_t submesh) const;
+
+private:
+
+	MappedFile file;
+	MeshAssetHeader header{};
+	std::vector<MeshAssetAttribute> attributes;
+	std::vector<MeshAssetSubmesh> submeshes;
+	std::vector<MeshAssetLod> lods;
+};
+
+//Builds assets, used by Tools/CookMesh.cpp
+class MeshAssetWriter
+{
+public:
+
+	//Copies the vertices, stride bytes apart and described by layout
+	void setVertices(const void* vertices, uint32_t vertexCount, uint32_t stride, const MeshAssetAttribute* layout, size_t attributeCount);
+
+	//Copies the indices, stored as 16 bit when the vertex count allows it
+	void setIndices(const uint32_t* indices, size_t indexCount);
+
+	void setBounds(const Bounds& meshBounds) { bounds = meshBounds; }
+	void setPositionDecode(const PositionDecode& decode) { positionDecode = decode; }
+
+	//Levels index into the indices given to setIndices; returns false if one is out of range or there are none
+	bool addSubmesh(const std::vector<MeshLod>& levels);
+
+	void serialize(std::vector<uint8_t>& asset) const;
+	bool write(const std::string& fileName) const;
+
+private:
+
+	std::vector<uint8_t> vertices;
+	uint32_t vertexCount{ 0 };
+	uint32_t stride{ 0 };
+	std::vector<MeshAssetAttribute> attributes;
+	std::vector<uint32_t> indices;
+	Bounds bounds;
+	PositionDecode positionDecode;
+	std::vector<MeshAssetSubmesh> submeshes;
+	std::vector<MeshAssetLod> lods;
+};
@@ -0,0 +1,1380 @@
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "MathHelper.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	const size_t minBytesPerChunk{ 1 << 20 };
+	const size_t minItemsPerChunk{ 65536 };
+	//Below this the threads cost more than they save
+	const int minTrianglesForParallelNormals{ 65536 };
+
+	//----------------------------------------------------------------------//
+	//-----------------------HASH DEDUPLICATION------------------------------//
+	//----------------------------------------------------------------------//
+
+	//Finalizer of MurmurHash3, spreads every input bit over the whole result
+	//------------------------------------
+	inline uint64_t mixHash(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	//Gives every key the id of its first occurrence in remap, ids count up in order of first
+	//occurrence, and returns the number of distinct keys. Keys are partitioned by the top
+	//bits of their hash in parallel (the scatter keeps them in input order), then each
+	//partition is deduplicated with its own open addressing table on a worker thread
+	//-------------------------------------------------------------------------------------
+	template <typename Key, typename Hash, typename Equal>
+	uint32_t deduplicate(const Key* keys, size_t count, Hash hash, Equal equal, uint32_t* remap)
+	{
+		const unsigned int partitionBits{ 8 };
+		const size_t partitionCount{ size_t{ 1 } << partitionBits };
+		const size_t chunkCount = parallelChunkCount(count, minItemsPerChunk);
+		if (chunkCount == 0)
+		{
+			return 0;
+		}
+
+		//Count and scatter key indices by partition, per chunk so the threads never share a counter
+		std::vector<uint32_t> histograms(chunkCount * partitionCount, 0);
+		parallelFor(count, minItemsPerChunk, [&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t* histogram = histograms.data() + chunk * partitionCount;
+			for (size_t i{ begin }; i < end; i++)
+			{
+				histogram[hash(keys[i]) >> (64 - partitionBits)]++;
+			}
+		});
+
+		std::vector<uint32_t> partitionStarts(partitionCount + 1, 0);
+		uint32_t offset{ 0 };
+		for (size_t partition{ 0 }; partition < partitionCount; partition++)
+		{
+			partitionStarts[partition] = offset;
+			for (size_t chunk{ 0 }; chunk < chunkCount; chunk++)
+			{
+				uint32_t& entry = histograms[chunk * partitionCount + partition];
+				uint32_t chunkCountInPartition = entry;
+				entry = offset;
+				offset += chunkCountInPartition;
+			}
+		}
+		partitionStarts[partitionCount] = offset;
+
+		std::vector<uint32_t> order(count);
+		parallelFor(count, minItemsPerChunk, [&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t* cursor = histograms.data() + chunk * partitionCount;
+			for (size_t i{ begin }; i < end; i++)
+			{
+				order[cursor[hash(keys[i]) >> (64 - partitionBits)]++] = static_cast<uint32_t>(i);
+			}
+		});
+
+		//remap holds the first occurrence of every key for now
+		parallelFor(partitionCount, 1, [&](size_t, size_t begin, size_t end)
+		{
+			std::vector<uint32_t> table;
+			for (size_t partition{ begin }; partition < end; partition++)
+			{
+				const uint32_t* first = order.data() + partitionStarts[partition];
+				const uint32_t* last = order.data() + partitionStarts[partition + 1];
+				size_t tableSize{ 16 };
+				while (tableSize < size_t(last - first) * 2)
+				{
+					tableSize *= 2;
+				}
+				table.assign(tableSize, UINT32_MAX);
+
+				for (const uint32_t* index = first; index < last; index++)
+				{
+					size_t slot = static_cast<size_t>(hash(keys[*index])) & (tableSize - 1);
+					while (table[slot] != UINT32_MAX && !equal(keys[table[slot]], keys[*index]))
+					{
+						slot = (slot + 1) & (tableSize - 1);
+					}
+					if (table[slot] == UINT32_MAX)
+					{
+						table[slot] = *index;
+					}
+					remap[*index] = table[slot];
+				}
+			}
+		});
+
+		//Number the first occurrences in input order, then point the others at them
+		std::vector<uint32_t> chunkIds(chunkCount + 1, 0);
+		parallelFor(count, minItemsPerChunk, [&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t firsts{ 0 };
+			for (size_t i{ begin }; i < end; i++)
+			{
+				firsts += remap[i] == i;
+			}
+			chunkIds[chunk + 1] = firsts;
+		});
+		for (size_t chunk{ 0 }; chunk < chunkCount; chunk++)
+		{
+			chunkIds[chunk + 1] += chunkIds[chunk];
+		}
+
+		std::vector<uint32_t> ids(count);
+		parallelFor(count, minItemsPerChunk, [&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t id = chunkIds[chunk];
+			for (size_t i{ begin }; i < end; i++)
+			{
+				ids[i] = remap[i] == i ? id++ : 0;
+			}
+		});
+		parallelFor(count, minItemsPerChunk, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i{ begin }; i < end; i++)
+			{
+				remap[i] = ids[remap[i]];
+			}
+		});
+		return chunkIds[chunkCount];
+	}
+
+	//Left handed, clockwise version of a right handed position or normal
+	//------------------------------------------
+	inline XMFLOAT3 mirrorZ(const XMFLOAT3& value)
+	{
+		return XMFLOAT3{ value.x, value.y, -value.z };
+	}
+
+	//----------------------------------------------------------------------//
+	//-------------------------------OBJ-------------------------------------//
+	//----------------------------------------------------------------------//
+
+	//Position / texCoord / normal of a face corner, 0 based, UINT32_MAX when missing
+	struct ObjCorner
+	{
+		uint32_t position;
+		uint32_t texCoord;
+		uint32_t normal;
+	};
+
+	//A negative index of a corner, resolved once the element counts of the earlier chunks are known
+	struct ObjRelativeIndex
+	{
+		uint32_t corner;
+		uint32_t element;		//0 position, 1 texCoord, 2 normal
+		int64_t index;			//0 based from the start of the chunk, may point into earlier chunks
+	};
+
+	struct ObjChunk
+	{
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT2> texCoords;
+		std::vector<XMFLOAT3> normals;
+		std::vector<ObjCorner> corners;		//3 per triangle, winding already reversed
+		std::vector<ObjRelativeIndex> relative;
+		bool failed{ false };
+	};
+
+	const double powersOfTen[]{ 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	//------------------------------------------------
+	inline const char* skipBlanks(const char* text, const char* end)
+	{
+		while (text < end && (*text == ' ' || *text == '\t' || *text == '\r'))
+		{
+			text++;
+		}
+		return text;
+	}
+
+	//Decimal float with optional sign, fraction and exponent. The first 19 significant digits
+	//are accumulated exactly and scaled once, which is within an ulp of strtof for the values
+	//exporters write. Returns nullptr if there is no number at text
+	//---------------------------------------------------------------------------------------
+	const char* parseFloat(const char* text, const char* end, float& value)
+	{
+		text = skipBlanks(text, end);
+		bool negative = text < end && *text == '-';
+		text += text < end && (*text == '-' || *text == '+');
+
+		uint64_t mantissa{ 0 };
+		int digits{ 0 };
+		int exponent{ 0 };
+		const char* start = text;
+		for (; text < end && unsigned(*text - '0') < 10; text++)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + unsigned(*text - '0');
+				digits += mantissa != 0;
+			}
+			else
+			{
+				exponent++;
+			}
+		}
+		if (text < end && *text == '.')
+		{
+			for (text++; text < end && unsigned(*text - '0') < 10; text++)
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + unsigned(*text - '0');
+					digits += mantissa != 0;
+					exponent--;
+				}
+			}
+		}
+		if (text == start || (text == start + 1 && *start == '.'))
+		{
+			return nullptr;
+		}
+		if (text < end && (*text == 'e' || *text == 'E'))
+		{
+			const char* cursor = text + 1;
+			bool negativeExponent = cursor < end && *cursor == '-';
+			cursor += cursor < end && (*cursor == '-' || *cursor == '+');
+			int written{ 0 };
+			bool anyDigit{ false };
+			for (; cursor < end && unsigned(*cursor - '0') < 10; cursor++)
+			{
+				written = std::min(written * 10 + int(*cursor - '0'), 10000);
+				anyDigit = true;
+			}
+			if (anyDigit)
+			{
+				exponent += negativeExponent ? -written : written;
+				text = cursor;
+			}
+		}
+
+		double result = static_cast<double>(mantissa);
+		if (exponent < 0)
+		{
+			result = exponent >= -22 ? result / powersOfTen[-exponent] : result * std::pow(10.0, exponent);
+		}
+		else if (exponent > 0)
+		{
+			result = exponent <= 22 ? result * powersOfTen[exponent] : result * std::pow(10.0, exponent);
+		}
+		value = static_cast<float>(negative ? -result : result);
+		return text;
+	}
+
+	//Signed decimal integer, returns nullptr if there is none at text
+	//-------------------------------------------------------------------
+	const char* parseInt(const char* text, const char* end, int64_t& value)
+	{
+		bool negative = text < end && *text == '-';
+		text += text < end && (*text == '-' || *text == '+');
+		const char* start = text;
+		int64_t result{ 0 };
+		for (; text < end && unsigned(*text - '0') < 10; text++)
+		{
+			result = std::min<int64_t>(result * 10 + (*text - '0'), INT64_C(1) << 40);
+		}
+		value = negative ? -result : result;
+		return text == start ? nullptr : text;
+	}
+
+	//A face corner as written: 0 based indices, negative ones still relative to the
+	//elements the chunk had read when the face came
+	struct ParsedCorner
+	{
+		int64_t index[3]{ 0, 0, 0 };
+		bool present[3]{ false, false, false };
+		bool relative[3]{ false, false, false };
+	};
+
+	//----------------------------------------------------------------------------------------------
+	bool resolveIndex(int64_t index, size_t localCount, ParsedCorner& corner, uint32_t element)
+	{
+		corner.present[element] = index != 0;
+		corner.relative[element] = index < 0;
+		corner.index[element] = index < 0 ? static_cast<int64_t>(localCount) + index : index - 1;
+		return index != 0;
+	}
+
+	//One face corner, v, v/vt, v//vn or v/vt/vn. Returns nullptr if it is malformed
+	//---------------------------------------------------------------------------------------------------------
+	const char* parseCorner(const char* text, const char* end, const ObjChunk& chunk, ParsedCorner& corner)
+	{
+		int64_t index;
+		text = parseInt(text, end, index);
+		if (text == nullptr || !resolveIndex(index, chunk.positions.size(), corner, 0))
+		{
+			return nullptr;
+		}
+		if (text < end && *text == '/')
+		{
+			text++;
+			if (text < end && *text != '/')
+			{
+				text = parseInt(text, end, index);
+				if (text == nullptr || !resolveIndex(index, chunk.texCoords.size(), corner, 1))
+				{
+					return nullptr;
+				}
+			}
+			if (text < end && *text == '/')
+			{
+				text = parseInt(text + 1, end, index);
+				if (text == nullptr || !resolveIndex(index, chunk.normals.size(), corner, 2))
+				{
+					return nullptr;
+				}
+			}
+		}
+		return text;
+	}
+
+	//Appends a corner, relative indices are left at 0 and recorded for the fix up
+	//-----------------------------------------------------------------
+	void emitCorner(ObjChunk& chunk, const ParsedCorner& parsed)
+	{
+		const uint32_t cornerIndex = static_cast<uint32_t>(chunk.corners.size());
+		uint32_t elements[3]{ 0, UINT32_MAX, UINT32_MAX };
+		for (uint32_t element{ 0 }; element < 3; element++)
+		{
+			if (parsed.relative[element])
+			{
+				chunk.relative.push_back({ cornerIndex, element, parsed.index[element] });
+				elements[element] = 0;
+			}
+			else if (parsed.present[element])
+			{
+				elements[element] = static_cast<uint32_t>(std::min<int64_t>(parsed.index[element], UINT32_MAX - 1));
+			}
+		}
+		chunk.corners.push_back({ elements[0], elements[1], elements[2] });
+	}
+
+	//Parses the lines in [text, end), which starts at a line start
+	//------------------------------------------------------------------
+	void parseObjChunk(const char* text, const char* end, ObjChunk& chunk)
+	{
+		std::vector<ParsedCorner> polygon;
+		while (text < end)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(text, '\n', end - text));
+			lineEnd = lineEnd == nullptr ? end : lineEnd;
+			const char* cursor = skipBlanks(text, lineEnd);
+			const char* next = lineEnd + 1;
+
+			if (lineEnd - cursor >= 2 && cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+			{
+				XMFLOAT3 position;
+				cursor = parseFloat(cursor + 2, lineEnd, position.x);
+				cursor = cursor ? parseFloat(cursor, lineEnd, position.y) : nullptr;
+				cursor = cursor ? parseFloat(cursor, lineEnd, position.z) : nullptr;
+				chunk.failed |= cursor == nullptr;
+				chunk.positions.push_back(mirrorZ(position));
+			}
+			else if (lineEnd - cursor >= 3 && cursor[0] == 'v' && cursor[1] == 't' && (cursor[2] == ' ' || cursor[2] == '\t'))
+			{
+				//v is optional, and a w is ignored
+				XMFLOAT2 texCoord{ 0.0f, 0.0f };
+				cursor = parseFloat(cursor + 3, lineEnd, texCoord.x);
+				if (cursor != nullptr && skipBlanks(cursor, lineEnd) < lineEnd)
+				{
+					cursor = parseFloat(cursor, lineEnd, texCoord.y);
+				}
+				chunk.failed |= cursor == nullptr;
+				chunk.texCoords.push_back(XMFLOAT2{ texCoord.x, 1.0f - texCoord.y });
+			}
+			else if (lineEnd - cursor >= 3 && cursor[0] == 'v' && cursor[1] == 'n' && (cursor[2] == ' ' || cursor[2] == '\t'))
+			{
+				XMFLOAT3 normal;
+				cursor = parseFloat(cursor + 3, lineEnd, normal.x);
+				cursor = cursor ? parseFloat(cursor, lineEnd, normal.y) : nullptr;
+				cursor = cursor ? parseFloat(cursor, lineEnd, normal.z) : nullptr;
+				chunk.failed |= cursor == nullptr;
+				chunk.normals.push_back(mirrorZ(normal));
+			}
+			else if (lineEnd - cursor >= 2 && cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+			{
+				polygon.clear();
+				cursor = skipBlanks(cursor + 2, lineEnd);
+				while (cursor != nullptr && cursor < lineEnd)
+				{
+					polygon.emplace_back();
+					cursor = parseCorner(cursor, lineEnd, chunk, polygon.back());
+					cursor = cursor ? skipBlanks(cursor, lineEnd) : nullptr;
+				}
+				chunk.failed |= cursor == nullptr || polygon.size() < 3;
+
+				//Fan with the winding reversed: 0, i, i - 1
+				for (size_t i{ 2 }; i < polygon.size() && !chunk.failed; i++)
+				{
+					emitCorner(chunk, polygon[0]);
+					emitCorner(chunk, polygon[i]);
+					emitCorner(chunk, polygon[i - 1]);
+				}
+			}
+			text = next;
+		}
+	}
+
+	//Start of the line that contains position, or end
+	//------------------------------------------------------------------
+	const char* lineStart(const char* begin, const char* end, size_t position)
+	{
+		if (position == 0)
+		{
+			return begin;
+		}
+		const char* newline = static_cast<const char*>(memchr(begin + position - 1, '\n', end - (begin + position - 1)));
+		return newline == nullptr ? end : newline + 1;
+	}
+
+	//----------------------------------------------------------------------//
+	//-------------------------------GLTF------------------------------------//
+	//----------------------------------------------------------------------//
+
+	//Just enough JSON for glTF: a DOM with numbers as doubles and strings unescaped
+	struct JsonValue
+	{
+		enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+
+		Type type{ Type::Null };
+		double number{ 0.0 };
+		std::string string;
+		std::vector<JsonValue> items;
+		std::vector<std::pair<std::string, JsonValue>> members;
+
+		//--------------------------------------------------------
+		const JsonValue* find(const char* key) const
+		{
+			for (const auto& member : members)
+			{
+				if (member.first == key)
+				{
+					return &member.second;
+				}
+			}
+			return nullptr;
+		}
+
+		//Non negative integer, SIZE_MAX for anything else
+		//----------------------
+		size_t index() const
+		{
+			return type == Type::Number && number >= 0.0 && number < 4294967296.0 && number == std::floor(number) ? static_cast<size_t>(number) : SIZE_MAX;
+		}
+
+		//Non negative integer member, fallback when it is missing and SIZE_MAX when it is not one
+		//-----------------------------------------------------------------
+		size_t indexOr(const char* key, size_t fallback = SIZE_MAX) const
+		{
+			const JsonValue* value = find(key);
+			return value != nullptr ? value->index() : fallback;
+		}
+
+		//--------------------------------------------------------
+		double numberOr(const char* key, double fallback) const
+		{
+			const JsonValue* value = find(key);
+			return value != nullptr && value->type == Type::Number ? value->number : fallback;
+		}
+
+		//------------------------------------------------------------------
+		const std::vector<JsonValue>& array(const char* key) const
+		{
+			static const std::vector<JsonValue> empty;
+			const JsonValue* value = find(key);
+			return value != nullptr && value->type == Type::Array ? value->items : empty;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+
+		JsonParser(const char* text, size_t size) : cursor{ text }, end{ text + size } {}
+
+		//----------------------------------
+		bool parse(JsonValue& root)
+		{
+			return parseValue(root, 0) && skipSpace() == end;
+		}
+
+	private:
+
+		//----------------------------
+		const char* skipSpace()
+		{
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+			{
+				cursor++;
+			}
+			return cursor;
+		}
+
+		//-----------------------------------------------
+		bool parseValue(JsonValue& value, int depth)
+		{
+			if (skipSpace() == end || depth > 64)
+			{
+				return false;
+			}
+			switch (*cursor)
+			{
+			case '{': return parseObject(value, depth);
+			case '[': return parseArray(value, depth);
+			case '"': value.type = JsonValue::Type::String; return parseString(value.string);
+			case 't': value.type = JsonValue::Type::Bool; value.number = 1.0; return parseLiteral("true");
+			case 'f': value.type = JsonValue::Type::Bool; return parseLiteral("false");
+			case 'n': value.type = JsonValue::Type::Null; return parseLiteral("null");
+			}
+
+			value.type = JsonValue::Type::Number;
+			char* numberEnd = nullptr;
+			std::string number{ cursor, static_cast<size_t>(std::min<ptrdiff_t>(end - cursor, 64)) };
+			value.number = strtod(number.c_str(), &numberEnd);
+			if (numberEnd == number.c_str())
+			{
+				return false;
+			}
+			cursor += numberEnd - number.c_str();
+			return true;
+		}
+
+		//-----------------------------------------
+		bool parseLiteral(const char* literal)
+		{
+			size_t length = strlen(literal);
+			if (size_t(end - cursor) < length || memcmp(cursor, literal, length) != 0)
+			{
+				return false;
+			}
+			cursor += length;
+			return true;
+		}
+
+		//Unescapes into text, \u escapes become UTF-8
+		//-----------------------------------------
+		bool parseString(std::string& text)
+		{
+			for (cursor++; cursor < end && *cursor != '"'; cursor++)
+			{
+				if (*cursor != '\\')
+				{
+					text += *cursor;
+					continue;
+				}
+				if (++cursor == end)
+				{
+					return false;
+				}
+				switch (*cursor)
+				{
+				case 'b': text += '\b'; break;
+				case 'f': text += '\f'; break;
+				case 'n': text += '\n'; break;
+				case 'r': text += '\r'; break;
+				case 't': text += '\t'; break;
+				case 'u':
+				{
+					if (end - cursor < 5)
+					{
+						return false;
+					}
+					unsigned long code = strtoul(std::string{ cursor + 1, 4 }.c_str(), nullptr, 16);
+					cursor += 4;
+					if (code < 0x80)
+					{
+						text += static_cast<char>(code);
+					}
+					else if (code < 0x800)
+					{
+						text += static_cast<char>(0xC0 | (code >> 6));
+						text += static_cast<char>(0x80 | (code & 0x3F));
+					}
+					else
+					{
+						text += static_cast<char>(0xE0 | (code >> 12));
+						text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+						text += static_cast<char>(0x80 | (code & 0x3F));
+					}
+					break;
+				}
+				default: text += *cursor; break;
+				}
+			}
+			if (cursor == end)
+			{
+				return false;
+			}
+			cursor++;
+			return true;
+		}
+
+		//------------------------------------------------
+		bool parseArray(JsonValue& value, int depth)
+		{
+			value.type = JsonValue::Type::Array;
+			cursor++;
+			if (skipSpace() < end && *cursor == ']')
+			{
+				cursor++;
+				return true;
+			}
+			while (true)
+			{
+				value.items.emplace_back();
+				if (!parseValue(value.items.back(), depth + 1) || skipSpace() == end)
+				{
+					return false;
+				}
+				if (*cursor++ == ']')
+				{
+					return true;
+				}
+				if (cursor[-1] != ',')
+				{
+					return false;
+				}
+			}
+		}
+
+		//-------------------------------------------------
+		bool parseObject(JsonValue& value, int depth)
+		{
+			value.type = JsonValue::Type::Object;
+			cursor++;
+			if (skipSpace() < end && *cursor == '}')
+			{
+				cursor++;
+				return true;
+			}
+			while (true)
+			{
+				value.members.emplace_back();
+				auto& member = value.members.back();
+				if (skipSpace() == end || *cursor != '"' || !parseString(member.first) ||
+					skipSpace() == end || *cursor++ != ':' || !parseValue(member.second, depth + 1) || skipSpace() == end)
+				{
+					return false;
+				}
+				if (*cursor++ == '}')
+				{
+					return true;
+				}
+				if (cursor[-1] != ',')
+				{
+					return false;
+				}
+			}
+		}
+
+		const char* cursor;
+		const char* end;
+	};
+
+	//A glTF buffer: the .glb binary chunk or an external file, both mapped, or a decoded data URI
+	struct GltfBuffer
+	{
+		std::unique_ptr<MappedFile> file;
+		std::vector<uint8_t> decoded;
+		const uint8_t* data{ nullptr };
+		size_t size{ 0 };
+	};
+
+	//Typed view of an accessor's elements inside a buffer
+	struct AccessorView
+	{
+		const uint8_t* data{ nullptr };
+		size_t stride{ 0 };
+		uint32_t count{ 0 };
+		uint32_t componentType{ 0 };
+		uint32_t components{ 0 };
+		bool normalized{ false };
+
+		//Component c of element i as float, normalized integers are scaled as glTF specifies
+		//--------------------------------------------------------
+		float read(size_t i, uint32_t c) const
+		{
+			const uint8_t* element = data + i * stride;
+			switch (componentType)
+			{
+			case 5126: { float value; memcpy(&value, element + c * 4, 4); return value; }
+			case 5121: return normalized ? element[c] / 255.0f : element[c];
+			case 5123: { uint16_t value; memcpy(&value, element + c * 2, 2); return normalized ? value / 65535.0f : value; }
+			case 5120: { int8_t value = static_cast<int8_t>(element[c]); return normalized ? std::max(value / 127.0f, -1.0f) : value; }
+			case 5122: { int16_t value; memcpy(&value, element + c * 2, 2); return normalized ? std::max(value / 32767.0f, -1.0f) : value; }
+			}
+			return 0.0f;
+		}
+
+		//Element i of an index accessor
+		//------------------------------------
+		uint32_t readIndex(size_t i) const
+		{
+			const uint8_t* element = data + i * stride;
+			switch (componentType)
+			{
+			case 5121: return element[0];
+			case 5123: { uint16_t value; memcpy(&value, element, 2); return value; }
+			case 5125: { uint32_t value; memcpy(&value, element, 4); return value; }
+			}
+			return UINT32_MAX;
+		}
+	};
+
+	//------------------------------------------
+	uint32_t componentSize(uint32_t componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: case 5121: return 1;
+		case 5122: case 5123: return 2;
+		case 5125: case 5126: return 4;
+		}
+		return 0;
+	}
+
+	//--------------------------------------------
+	uint32_t componentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	//----------------------------------------------------------------------
+	bool decodeBase64(const char* text, size_t size, std::vector<uint8_t>& bytes)
+	{
+		uint32_t bits{ 0 };
+		int bitCount{ 0 };
+		for (size_t i{ 0 }; i < size && text[i] != '='; i++)
+		{
+			const char c = text[i];
+			int value = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 : c >= '0' && c <= '9' ? c - '0' + 52 :
+				c == '+' ? 62 : c == '/' ? 63 : -1;
+			if (value < 0)
+			{
+				return false;
+			}
+			bits = bits << 6 | static_cast<uint32_t>(value);
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back(static_cast<uint8_t>(bits >> bitCount));
+			}
+		}
+		return true;
+	}
+
+	class GltfLoader
+	{
+	public:
+
+		GltfLoader(const JsonValue& root, std::vector<GltfBuffer>& buffers, ImportedMesh& mesh) : root{ root }, buffers{ buffers }, mesh{ mesh } {}
+
+		//Adds the meshes of the default scene, or of every root node if there are no scenes
+		//----------------------------
+		bool load()
+		{
+			const std::vector<JsonValue>& nodes = root.array("nodes");
+			const std::vector<JsonValue>& scenes = root.array("scenes");
+			XMFLOAT4X4 identity;
+			XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+			if (nodes.empty())
+			{
+				for (size_t i{ 0 }; i < root.array("meshes").size(); i++)
+				{
+					if (!addMesh(i, identity))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			std::vector<size_t> roots;
+			if (!scenes.empty())
+			{
+				size_t scene = root.indexOr("scene", 0);
+				if (scene >= scenes.size())
+				{
+					return false;
+				}
+				for (const JsonValue& node : scenes[scene].array("nodes"))
+				{
+					roots.push_back(node.index());
+				}
+			}
+			else
+			{
+				std::vector<bool> isChild(nodes.size(), false);
+				for (const JsonValue& node : nodes)
+				{
+					for (const JsonValue& child : node.array("children"))
+					{
+						if (child.index() < nodes.size())
+						{
+							isChild[child.index()] = true;
+						}
+					}
+				}
+				for (size_t i{ 0 }; i < nodes.size(); i++)
+				{
+					if (!isChild[i])
+					{
+						roots.push_back(i);
+					}
+				}
+			}
+
+			for (size_t node : roots)
+			{
+				if (!addNode(node, identity, 0))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+	private:
+
+		//Row vector transform of a node relative to its parent
+		//-----------------------------------------------------
+		static XMMATRIX localTransform(const JsonValue& node)
+		{
+			const std::vector<JsonValue>& matrix = node.array("matrix");
+			if (matrix.size() == 16)
+			{
+				//Column major with column vectors reads as row major with row vectors
+				XMFLOAT4X4 values;
+				for (size_t i{ 0 }; i < 16; i++)
+				{
+					values.m[i / 4][i % 4] = static_cast<float>(matrix[i].number);
+				}
+				return XMLoadFloat4x4(&values);
+			}
+
+			auto component = [&node](const char* key, size_t i, double fallback)
+			{
+				const std::vector<JsonValue>& values = node.array(key);
+				return static_cast<float>(i < values.size() ? values[i].number : fallback);
+			};
+			XMVECTOR rotation = XMVectorSet(component("rotation", 0, 0.0), component("rotation", 1, 0.0), component("rotation", 2, 0.0), component("rotation", 3, 1.0));
+			return XMMatrixScaling(component("scale", 0, 1.0), component("scale", 1, 1.0), component("scale", 2, 1.0)) *
+				XMMatrixRotationQuaternion(rotation) *
+				XMMatrixTranslation(component("translation", 0, 0.0), component("translation", 1, 0.0), component("translation", 2, 0.0));
+		}
+
+		//--------------------------------------------------------------------------
+		bool addNode(size_t index, const XMFLOAT4X4& parent, int depth)
+		{
+			const std::vector<JsonValue>& nodes = root.array("nodes");
+			if (index >= nodes.size() || depth > 64)
+			{
+				return false;
+			}
+
+			const JsonValue& node = nodes[index];
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, localTransform(node) * XMLoadFloat4x4(&parent));
+
+			const JsonValue* meshIndex = node.find("mesh");
+			if (meshIndex != nullptr && !addMesh(meshIndex->index(), world))
+			{
+				return false;
+			}
+			for (const JsonValue& child : node.array("children"))
+			{
+				if (!addNode(child.index(), world, depth + 1))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//------------------------------------------------------------------------
+		bool addMesh(size_t index, const XMFLOAT4X4& world)
+		{
+			const std::vector<JsonValue>& meshes = root.array("meshes");
+			if (index >= meshes.size())
+			{
+				return false;
+			}
+			for (const JsonValue& primitive : meshes[index].array("primitives"))
+			{
+				//Triangles only, points and lines have nothing to draw here
+				if (primitive.numberOr("mode", 4.0) == 4.0 && !addPrimitive(primitive, world))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Checks an accessor against its buffer view and returns a view of its elements
+		//---------------------------------------------------------------------------------
+		bool accessorView(size_t index, AccessorView& view) const
+		{
+			const std::vector<JsonValue>& accessors = root.array("accessors");
+			const std::vector<JsonValue>& bufferViews = root.array("bufferViews");
+			if (index >= accessors.size())
+			{
+				return false;
+			}
+			const JsonValue& accessor = accessors[index];
+			const JsonValue* type = accessor.find("type");
+			const JsonValue* normalized = accessor.find("normalized");
+			size_t bufferViewIndex = accessor.indexOr("bufferView");
+			if (accessor.find("sparse") != nullptr || type == nullptr || bufferViewIndex >= bufferViews.size())
+			{
+				return false;
+			}
+
+			const JsonValue& bufferView = bufferViews[bufferViewIndex];
+			size_t bufferIndex = bufferView.indexOr("buffer");
+			if (bufferIndex >= buffers.size())
+			{
+				return false;
+			}
+			const GltfBuffer& buffer = buffers[bufferIndex];
+
+			const size_t count = accessor.indexOr("count");
+			const size_t stride = bufferView.indexOr("byteStride", 0);
+			const size_t viewOffset = bufferView.indexOr("byteOffset", 0);
+			const size_t viewLength = bufferView.indexOr("byteLength");
+			const size_t accessorOffset = accessor.indexOr("byteOffset", 0);
+			if (count == SIZE_MAX || stride == SIZE_MAX || viewOffset == SIZE_MAX || viewLength == SIZE_MAX || accessorOffset == SIZE_MAX)
+			{
+				return false;
+			}
+
+			view.componentType = static_cast<uint32_t>(accessor.indexOr("componentType", 0));
+			view.components = componentCount(type->string);
+			view.count = static_cast<uint32_t>(count);
+			view.normalized = normalized != nullptr && normalized->number != 0.0;
+			const size_t elementSize = size_t{ componentSize(view.componentType) } * view.components;
+			view.stride = stride == 0 ? elementSize : stride;
+
+			const uint64_t accessorBytes = count == 0 ? 0 : uint64_t{ count - 1 } * view.stride + elementSize;
+			if (elementSize == 0 || uint64_t{ viewOffset } + viewLength > buffer.size || uint64_t{ accessorOffset } + accessorBytes > viewLength)
+			{
+				return false;
+			}
+			view.data = buffer.data + viewOffset + accessorOffset;
+			return true;
+		}
+
+		//Converts the primitive's vertices on worker threads and appends its triangles
+		//---------------------------------------------------------------------------------
+		bool addPrimitive(const JsonValue& primitive, const XMFLOAT4X4& world)
+		{
+			const JsonValue* attributes = primitive.find("attributes");
+			const JsonValue* positionAccessor = attributes != nullptr ? attributes->find("POSITION") : nullptr;
+			AccessorView positions;
+			if (positionAccessor == nullptr || !accessorView(positionAccessor->index(), positions) || positions.components != 3)
+			{
+				return false;
+			}
+
+			AccessorView normals;
+			AccessorView texCoords;
+			const JsonValue* normalAccessor = attributes->find("NORMAL");
+			const JsonValue* texCoordAccessor = attributes->find("TEXCOORD_0");
+			bool hasNormals = normalAccessor != nullptr;
+			bool hasTexCoords = texCoordAccessor != nullptr;
+			if ((hasNormals && (!accessorView(normalAccessor->index(), normals) || normals.components != 3 || normals.count != positions.count)) ||
+				(hasTexCoords && (!accessorView(texCoordAccessor->index(), texCoords) || texCoords.components != 2 || texCoords.count != positions.count)))
+			{
+				return false;
+			}
+
+			//Local indices, sequential when the primitive has none
+			std::vector<uint32_t> indices;
+			const JsonValue* indexAccessor = primitive.find("indices");
+			if (indexAccessor != nullptr)
+			{
+				AccessorView view;
+				if (!accessorView(indexAccessor->index(), view) || view.components != 1)
+				{
+					return false;
+				}
+				indices.resize(view.count - view.count % 3);
+				for (size_t i{ 0 }; i < indices.size(); i++)
+				{
+					indices[i] = view.readIndex(i);
+					if (indices[i] >= positions.count)
+					{
+						return false;
+					}
+				}
+			}
+			else
+			{
+				indices.resize(positions.count - positions.count % 3);
+				for (uint32_t i{ 0 }; i < indices.size(); i++)
+				{
+					indices[i] = i;
+				}
+			}
+
+			const uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+			mesh.vertices.resize(baseVertex + size_t{ positions.count });
+			VertexNormTex* vertices = mesh.vertices.data() + baseVertex;
+
+			//Normals go through the inverse transpose, so non uniform scales keep them perpendicular
+			XMMATRIX transform = XMLoadFloat4x4(&world);
+			XMFLOAT4X4 normalTransform;
+			XMStoreFloat4x4(&normalTransform, XMMatrixTranspose(XMMatrixInverse(nullptr, transform)));
+			parallelFor(positions.count, minItemsPerChunk, [&](size_t, size_t begin, size_t end)
+			{
+				XMMATRIX positionMatrix = XMLoadFloat4x4(&world);
+				XMMATRIX normalMatrix = XMLoadFloat4x4(&normalTransform);
+				for (size_t i{ begin }; i < end; i++)
+				{
+					VertexNormTex& vertex = vertices[i];
+					XMVECTOR position = XMVectorSet(positions.read(i, 0), positions.read(i, 1), positions.read(i, 2), 1.0f);
+					XMStoreFloat3(&vertex.position, XMVector3TransformCoord(position, positionMatrix));
+					vertex.position = mirrorZ(vertex.position);
+
+					vertex.normal = XMFLOAT3{ 0.0f, 0.0f, 0.0f };
+					if (hasNormals)
+					{
+						XMVECTOR normal = XMVectorSet(normals.read(i, 0), normals.read(i, 1), normals.read(i, 2), 0.0f);
+						XMStoreFloat3(&vertex.normal, XMVector3Normalize(XMVector3TransformNormal(normal, normalMatrix)));
+						vertex.normal = mirrorZ(vertex.normal);
+					}
+					vertex.texCoords = hasTexCoords ? XMFLOAT2{ texCoords.read(i, 0), texCoords.read(i, 1) } : XMFLOAT2{ 0.0f, 0.0f };
+				}
+			});
+
+			//Reverse the winding for the mirror
+			for (size_t i{ 0 }; i < indices.size(); i += 3)
+			{
+				std::swap(indices[i + 1], indices[i + 2]);
+			}
+			if (!hasNormals)
+			{
+				generateNormals(vertices, positions.count, indices.data(), indices.size());
+				mesh.generatedNormals = true;
+			}
+			for (uint32_t index : indices)
+			{
+				mesh.indices.push_back(baseVertex + index);
+			}
+			return true;
+		}
+
+		const JsonValue& root;
+		std::vector<GltfBuffer>& buffers;
+		ImportedMesh& mesh;
+	};
+
+	//Directory part of a path, with its trailing separator
+	//-------------------------------------------------------
+	std::string directoryOf(const std::string& path)
+	{
+		size_t separator = path.find_last_of("/\\");
+		return separator == std::string::npos ? std::string{} : path.substr(0, separator + 1);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool importObj(const std::string& fileName, ImportedMesh& mesh, ImportStats* stats)
+{
+	MappedFile file;
+	if (!file.open(fileName))
+	{
+		return false;
+	}
+
+	//Pass 1 : parse chunks that start at line starts
+	const char* text = reinterpret_cast<const char*>(file.data());
+	const char* textEnd = text + file.size();
+	std::vector<ObjChunk> chunks(parallelChunkCount(file.size(), minBytesPerChunk));
+	parallelFor(file.size(), minBytesPerChunk, [&](size_t chunk, size_t begin, size_t end)
+	{
+		parseObjChunk(lineStart(text, textEnd, begin), lineStart(text, textEnd, end), chunks[chunk]);
+	});
+
+	//Element and corner offsets of every chunk
+	struct ChunkBase
+	{
+		size_t positions{ 0 };
+		size_t texCoords{ 0 };
+		size_t normals{ 0 };
+		size_t corners{ 0 };
+	};
+	std::vector<ChunkBase> bases(chunks.size() + 1);
+	for (size_t i{ 0 }; i < chunks.size(); i++)
+	{
+		if (chunks[i].failed)
+		{
+			return false;
+		}
+		bases[i + 1].positions = bases[i].positions + chunks[i].positions.size();
+		bases[i + 1].texCoords = bases[i].texCoords + chunks[i].texCoords.size();
+		bases[i + 1].normals = bases[i].normals + chunks[i].normals.size();
+		bases[i + 1].corners = bases[i].corners + chunks[i].corners.size();
+	}
+	const ChunkBase& totals = bases.back();
+	if (totals.corners == 0 || totals.corners > UINT32_MAX || totals.positions >= UINT32_MAX ||
+		totals.texCoords >= UINT32_MAX || totals.normals >= UINT32_MAX)
+	{
+		return false;
+	}
+
+	//Pass 2 : gather the chunks, resolving negative indices and checking every index
+	std::vector<XMFLOAT3> positions(totals.positions);
+	std::vector<XMFLOAT2> texCoords(totals.texCoords);
+	std::vector<XMFLOAT3> normals(totals.normals);
+	std::vector<ObjCorner> corners(totals.corners);
+	std::vector<char> chunkValid(chunks.size(), 1);
+	parallelFor(chunks.size(), 1, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i{ begin }; i < end; i++)
+		{
+			ObjChunk& chunk = chunks[i];
+			const ChunkBase& base = bases[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + base.positions);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + base.texCoords);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + base.normals);
+
+			for (const ObjRelativeIndex& entry : chunk.relative)
+			{
+				const size_t elementBase = entry.element == 0 ? base.positions : entry.element == 1 ? base.texCoords : base.normals;
+				const int64_t absolute = static_cast<int64_t>(elementBase) + entry.index;
+				uint32_t* element = &chunk.corners[entry.corner].position + entry.element;
+				*element = absolute < 0 ? UINT32_MAX - 1 : static_cast<uint32_t>(std::min<int64_t>(absolute, UINT32_MAX - 1));
+			}
+
+			ObjCorner* destination = corners.data() + base.corners;
+			for (const ObjCorner& corner : chunk.corners)
+			{
+				bool valid = corner.position < totals.positions &&
+					(corner.texCoord == UINT32_MAX || corner.texCoord < totals.texCoords) &&
+					(corner.normal == UINT32_MAX || corner.normal < totals.normals);
+				chunkValid[i] &= valid;
+				*destination++ = corner;
+			}
+			chunk = ObjChunk{};
+		}
+	});
+	if (std::find(chunkValid.begin(), chunkValid.end(), 0) != chunkValid.end())
+	{
+		return false;
+	}
+
+	//Pass 3 : one vertex per distinct corner
+	mesh.indices.resize(corners.size());
+	const uint32_t vertexCount = deduplicate(corners.data(), corners.size(),
+		[](const ObjCorner& corner) { return mixHash((uint64_t{ corner.position } << 32 | corner.texCoord) ^ mixHash(corner.normal)); },
+		[](const ObjCorner& a, const ObjCorner& b) { return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal; },
+		mesh.indices.data());
+
+	mesh.vertices.resize(vertexCount);
+	parallelFor(corners.size(), minItemsPerChunk, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i{ begin }; i < end; i++)
+		{
+			const ObjCorner& corner = corners[i];
+			VertexNormTex& vertex = mesh.vertices[mesh.indices[i]];
+			vertex.position = positions[corner.position];
+			vertex.normal = corner.normal == UINT32_MAX ? XMFLOAT3{ 0.0f, 0.0f, 0.0f } : normals[corner.normal];
+			vertex.texCoords = corner.texCoord == UINT32_MAX ? XMFLOAT2{ 0.0f, 0.0f } : texCoords[corner.texCoord];
+		}
+	});
+
+	mesh.generatedNormals = normals.empty();
+	if (mesh.generatedNormals)
+	{
+		generateNormals(mesh.vertices.data(), vertexCount, mesh.indices.data(), mesh.indices.size());
+	}
+
+	if (stats != nullptr)
+	{
+		stats->fileBytes = file.size();
+		stats->sourceVertices = corners.size();
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+bool importGltf(const std::string& fileName, ImportedMesh& mesh, ImportStats* stats)
+{
+	auto file = std::make_unique<MappedFile>();
+	if (!file->open(fileName))
+	{
+		return false;
+	}
+	size_t fileBytes = file->size();
+
+	//.glb: 12 byte header, then a JSON chunk and an optional binary chunk
+	const char* json = reinterpret_cast<const char*>(file->data());
+	size_t jsonSize = file->size();
+	const uint8_t* binary = nullptr;
+	size_t binarySize{ 0 };
+	uint32_t header[5]{};
+	if (file->size() >= 20 && memcmp(file->data(), "glTF", 4) == 0)
+	{
+		memcpy(header, file->data(), sizeof(header));
+		const uint32_t jsonChunkType{ 0x4E4F534A };
+		const uint32_t binaryChunkType{ 0x004E4942 };
+		if (header[1] != 2 || header[2] < 20 || header[2] > file->size() || header[4] != jsonChunkType || header[3] > header[2] - 20)
+		{
+			return false;
+		}
+		json += 20;
+		jsonSize = header[3];
+
+		const size_t binaryChunk = 20 + size_t{ header[3] };
+		uint32_t chunkHeader[2]{};
+		if (binaryChunk + 8 <= header[2])
+		{
+			memcpy(chunkHeader, file->data() + binaryChunk, sizeof(chunkHeader));
+			if (chunkHeader[1] == binaryChunkType && chunkHeader[0] <= header[2] - binaryChunk - 8)
+			{
+				binary = file->data() + binaryChunk + 8;
+				binarySize = chunkHeader[0];
+			}
+		}
+	}
+
+	JsonValue root;
+	if (!JsonParser{ json, jsonSize }.parse(root) || root.type != JsonValue::Type::Object)
+	{
+		return false;
+	}
+
+	//Buffers stay mapped while the vertices are converted, only data URIs are decoded into memory
+	const std::vector<JsonValue>& bufferDescs = root.array("buffers");
+	std::vector<GltfBuffer> buffers(bufferDescs.size());
+	for (size_t i{ 0 }; i < bufferDescs.size(); i++)
+	{
+		GltfBuffer& buffer = buffers[i];
+		const JsonValue* uri = bufferDescs[i].find("uri");
+		if (uri == nullptr)
+		{
+			if (i != 0 || binary == nullptr)
+			{
+				return false;
+			}
+			buffer.data = binary;
+			buffer.size = binarySize;
+		}
+		else if (uri->string.compare(0, 5, "data:") == 0)
+		{
+			size_t comma = uri->string.find(";base64,");
+			if (comma == std::string::npos || !decodeBase64(uri->string.data() + comma + 8, uri->string.size() - comma - 8, buffer.decoded))
+			{
+				return false;
+			}
+			buffer.data = buffer.decoded.data();
+			buffer.size = buffer.decoded.size();
+		}
+		else
+		{
+			buffer.file = std::make_unique<MappedFile>();
+			if (!buffer.file->open(directoryOf(fileName) + uri->string))
+			{
+				return false;
+			}
+			buffer.data = buffer.file->data();
+			buffer.size = buffer.file->size();
+			fileBytes += buffer.size;
+		}
+		buffer.size = std::min<size_t>(buffer.size, bufferDescs[i].indexOr("byteLength", 0));
+	}
+
+	ImportedMesh loaded;
+	if (!GltfLoader{ root, buffers, loaded }.load() || loaded.indices.empty())
+	{
+		return false;
+	}
+
+	const size_t sourceVertices = loaded.vertices.size();
+	deduplicateVertices(loaded.vertices, loaded.indices);
+	mesh = std::move(loaded);
+
+	if (stats != nullptr)
+	{
+		stats->fileBytes = fileBytes;
+		stats->sourceVertices = sourceVertices;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+bool importMesh(const std::string& fileName, ImportedMesh& mesh, ImportStats* stats)
+{
+	size_t dot = fileName.find_last_of('.');
+	std::string extension = dot == std::string::npos ? std::string{} : fileName.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+	if (extension == "gltf" || extension == "glb")
+	{
+		return importGltf(fileName, mesh, stats);
+	}
+	return importObj(fileName, mesh, stats);
+}
+
+//--------------------------------------------------------------------------------------------------------
+void generateNormals(VertexNormTex* vertices, uint32_t vertexCount, const uint32_t* indices, size_t indexCount)
+{
+	for (uint32_t i{ 0 }; i < vertexCount; i++)
+	{
+		vertices[i].normal = XMFLOAT3{ 0.0f, 0.0f, 0.0f };
+	}
+	const int triangleCount{ static_cast<int>(indexCount / 3) };
+	if (triangleCount >= minTrianglesForParallelNormals)
+	{
+		calculateNormalsParallel(vertices, static_cast<int>(vertexCount), indices, triangleCount);
+	}
+	else
+	{
+		calculateNormals(vertices, static_cast<int>(vertexCount), indices, triangleCount);
+	}
+}
+
+//---------------------------------------------------------------------------------------------------
+uint32_t deduplicateVertices(std::vector<VertexNormTex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertices.size());
+	const uint32_t vertexCount = deduplicate(vertices.data(), vertices.size(),
+		[](const VertexNormTex& vertex)
+		{
+			uint64_t words[4];
+			memcpy(words, &vertex, sizeof(words));
+			return mixHash(words[0] ^ mixHash(words[1] ^ mixHash(words[2] ^ mixHash(words[3]))));
+		},
+		[](const VertexNormTex& a, const VertexNormTex& b) { return memcmp(&a, &b, sizeof(VertexNormTex)) == 0; },
+		remap.data());
+
+	//Ids are in order of first occurrence, so moving each first occurrence down never overwrites one still to come
+	for (size_t i{ 0 }; i < vertices.size(); i++)
+	{
+		vertices[remap[i]] = vertices[i];
+	}
+	vertices.resize(vertexCount);
+	for (uint32_t& index : indices)
+	{
+		index = remap[index];
+	}
+	return vertexCount;
+}
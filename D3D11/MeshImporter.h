@@ -0,0 +1,47 @@
+#pragma once
+#include "Vertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Indexed triangle list read from a model file, in the layout the cooker works on
+struct ImportedMesh
+{
+	std::vector<VertexNormTex> vertices;
+	std::vector<uint32_t> indices;
+	bool generatedNormals{ false };		//the file had no normals for some or all of the triangles
+};
+
+//Size of the input, for throughput figures
+struct ImportStats
+{
+	size_t fileBytes{ 0 };				//the model file, plus external glTF buffers
+	size_t sourceVertices{ 0 };			//OBJ face corners or glTF vertices before deduplication
+};
+
+//Both formats are right handed with counter clockwise front faces. Imported meshes are
+//mirrored in z and their winding reversed, so they show the same side in the left handed,
+//clockwise setup the app uses. Texture coordinates get a top left origin
+
+//Wavefront OBJ: v, vt, vn and f lines, anything else is skipped. The file is memory mapped
+//and split at line starts into chunks that are parsed on worker threads; polygons become
+//triangle fans. Every distinct position / texCoord / normal combination becomes one vertex,
+//found by hashing the corners in parallel. Returns false on unreadable files and bad indices
+bool importObj(const std::string& fileName, ImportedMesh& mesh, ImportStats* stats = nullptr);
+
+//glTF 2.0, .gltf with external or base64 buffers or binary .glb. Every triangle primitive of
+//the default scene is added with its node transform. POSITION, NORMAL and TEXCOORD_0 are
+//read straight from the mapped buffers (zero copy buffer views), then bitwise identical
+//vertices are merged. Sparse accessors and other topologies are not supported
+bool importGltf(const std::string& fileName, ImportedMesh& mesh, ImportStats* stats = nullptr);
+
+//importObj or importGltf from the file extension
+bool importMesh(const std::string& fileName, ImportedMesh& mesh, ImportStats* stats = nullptr);
+
+//Area weighted vertex normals from the triangles, replacing the existing ones
+void generateNormals(VertexNormTex* vertices, uint32_t vertexCount, const uint32_t* indices, size_t indexCount);
+
+//Merges bitwise identical vertices and remaps the indices, the first occurrence is kept.
+//Returns the new vertex count
+uint32_t deduplicateVertices(std::vector<VertexNormTex>& vertices, std::vector<uint32_t>& indices);
@@ -0,0 +1,375 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	//Triangles using each vertex, as offsets into one flat array
+	struct TriangleAdjacency
+	{
+		std::vector<uint32_t> offsets;		//vertexCount + 1 entries
+		std::vector<uint32_t> triangles;
+	};
+
+	//------------------------------------------------------------------------------------------------------------------
+	void buildAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+	{
+		adjacency.offsets.assign(size_t{ vertexCount } + 1, 0);
+		for (size_t i{ 0 }; i < indexCount; i++)
+		{
+			adjacency.offsets[indices[i] + 1]++;
+		}
+		std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+		adjacency.triangles.resize(indexCount);
+		std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (size_t i{ 0 }; i < indexCount; i++)
+		{
+			adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	//FIFO cache of vertex timestamps: a vertex is cached while fewer than cacheSize misses came after it
+	struct FifoCache
+	{
+		std::vector<uint32_t> timestamps;
+		uint32_t time;
+		uint32_t size;
+
+		FifoCache(uint32_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), time{ cacheSize + 1 }, size{ cacheSize } {}
+
+		//Returns 1 on a miss
+		uint32_t use(uint32_t vertex)
+		{
+			if (time - timestamps[vertex] > size)
+			{
+				timestamps[vertex] = time++;
+				return 1;
+			}
+			return 0;
+		}
+
+		void flush() { time += size + 1; }
+	};
+
+	//--------------------------------------------------------------------------------
+	void readPosition(const void* positions, size_t stride, uint32_t vertex, float position[3])
+	{
+		memcpy(position, static_cast<const uint8_t*>(positions) + stride * vertex, sizeof(float) * 3);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	FifoCache cache{ vertexCount, cacheSize };
+	std::vector<uint8_t> referenced(vertexCount, 0);
+	uint32_t uniqueVertices{ 0 };
+	for (size_t i{ 0 }; i < indexCount; i++)
+	{
+		stats.misses += cache.use(indices[i]);
+		uniqueVertices += referenced[indices[i]] == 0 ? 1 : 0;
+		referenced[indices[i]] = 1;
+	}
+
+	size_t triangleCount = indexCount / 3;
+	stats.acmr = triangleCount == 0 ? 0.0f : static_cast<float>(stats.misses) / triangleCount;
+	stats.atvr = uniqueVertices == 0 ? 0.0f : static_cast<float>(stats.misses) / uniqueVertices;
+	return stats;
+}
+
+//Fans around the current vertex, emitting its remaining triangles, then moves on to the
+//cached vertex with the most remaining triangles that will still be cached when its fan
+//is done; when there is none, back to the most recently used vertex that has triangles left
+//-------------------------------------------------------------------------------------------------------------------
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+	uint32_t cacheSize, std::vector<uint32_t>* clusters)
+{
+	assert(indexCount % 3 == 0);
+	const size_t triangleCount = indexCount / 3;
+	if (clusters)
+	{
+		clusters->clear();
+	}
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//Input copy so destination may alias indices
+	std::vector<uint32_t> source(indices, indices + indexCount);
+
+	TriangleAdjacency adjacency;
+	buildAdjacency(adjacency, source.data(), indexCount, vertexCount);
+
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (uint32_t v{ 0 }; v < vertexCount; v++)
+	{
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> deadEnd;
+	deadEnd.reserve(indexCount);
+	std::vector<uint32_t> candidates;
+	candidates.reserve(64);
+
+	uint32_t time{ cacheSize + 1 };
+	uint32_t cursor{ 0 };		//next vertex to try when the dead end stack runs dry
+	size_t output{ 0 };
+	int64_t fanVertex{ source[0] };
+	bool coldStart{ true };
+
+	while (fanVertex >= 0)
+	{
+		uint32_t fan = static_cast<uint32_t>(fanVertex);
+		if (clusters && coldStart)
+		{
+			clusters->push_back(static_cast<uint32_t>(output / 3));
+		}
+
+		candidates.clear();
+		for (uint32_t a{ adjacency.offsets[fan] }; a < adjacency.offsets[fan + 1]; a++)
+		{
+			uint32_t triangle = adjacency.triangles[a];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			emitted[triangle] = 1;
+			for (uint32_t corner{ 0 }; corner < 3; corner++)
+			{
+				uint32_t v = source[triangle * 3 + corner];
+				destination[output++] = v;
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (time - timestamps[v] > cacheSize)
+				{
+					timestamps[v] = time++;
+				}
+			}
+		}
+
+		//Best candidate of the fan that will still be in the cache after its own fan
+		fanVertex = -1;
+		int64_t bestPriority{ -1 };
+		for (uint32_t v : candidates)
+		{
+			if (liveTriangles[v] == 0)
+			{
+				continue;
+			}
+			int64_t priority{ 0 };
+			if (time - timestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+			{
+				priority = time - timestamps[v];
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanVertex = v;
+			}
+		}
+
+		//Dead end: most recently used vertex with triangles left, else the next one in input order
+		coldStart = false;
+		while (fanVertex < 0 && !deadEnd.empty())
+		{
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[v] > 0)
+			{
+				fanVertex = v;
+				coldStart = time - timestamps[v] > cacheSize;
+			}
+		}
+		while (fanVertex < 0 && cursor < vertexCount)
+		{
+			if (liveTriangles[cursor] > 0)
+			{
+				fanVertex = cursor;
+				coldStart = true;
+			}
+			cursor++;
+		}
+	}
+	assert(output == indexCount);
+}
+
+//Sander et al.'s view independent ordering: clusters whose surface faces away from the
+//mesh centroid are on the outside of the mesh and are drawn first
+//--------------------------------------------------------------------------------------------------------------------------------------
+uint32_t optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* positions, size_t positionStride,
+	uint32_t vertexCount, const std::vector<uint32_t>& clusters, uint32_t cacheSize, float threshold)
+{
+	assert(destination != indices);
+	const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+	if (triangleCount == 0)
+	{
+		return 0;
+	}
+
+	//Soft boundaries: split hard clusters wherever the cache is warm enough that starting
+	//over costs little compared to the cluster as a whole
+	std::vector<uint32_t> starts;
+	starts.reserve(clusters.size() * 2);
+	FifoCache cache{ vertexCount, cacheSize };
+	for (size_t c{ 0 }; c < clusters.size(); c++)
+	{
+		uint32_t begin = clusters[c];
+		uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+		cache.flush();
+		uint32_t clusterMisses{ 0 };
+		for (uint32_t t{ begin }; t < end; t++)
+		{
+			clusterMisses += cache.use(indices[t * 3]) + cache.use(indices[t * 3 + 1]) + cache.use(indices[t * 3 + 2]);
+		}
+		float clusterThreshold = threshold * clusterMisses / (end - begin);
+
+		cache.flush();
+		uint32_t start{ begin };
+		uint32_t misses{ 0 };
+		starts.push_back(begin);
+		for (uint32_t t{ begin }; t < end; t++)
+		{
+			misses += cache.use(indices[t * 3]) + cache.use(indices[t * 3 + 1]) + cache.use(indices[t * 3 + 2]);
+			if (t + 1 < end && misses <= clusterThreshold * (t + 1 - start))
+			{
+				starts.push_back(t + 1);
+				start = t + 1;
+				misses = 0;
+				cache.flush();
+			}
+		}
+	}
+	if (starts.empty() || starts.front() != 0)
+	{
+		starts.insert(starts.begin(), 0);
+	}
+
+	//Area weighted centroid and normal of the mesh and of each cluster
+	const size_t clusterCount = starts.size();
+	std::vector<float> clusterCentroids(clusterCount * 3, 0.0f);
+	std::vector<float> clusterNormals(clusterCount * 3, 0.0f);
+	float meshCentroid[3]{ 0.0f, 0.0f, 0.0f };
+	float meshArea{ 0.0f };
+	for (size_t c{ 0 }; c < clusterCount; c++)
+	{
+		uint32_t end = c + 1 < clusterCount ? starts[c + 1] : triangleCount;
+		float area{ 0.0f };
+		float* centroid = &clusterCentroids[c * 3];
+		float* normal = &clusterNormals[c * 3];
+		for (uint32_t t{ starts[c] }; t < end; t++)
+		{
+			float p0[3], p1[3], p2[3];
+			readPosition(positions, positionStride, indices[t * 3], p0);
+			readPosition(positions, positionStride, indices[t * 3 + 1], p1);
+			readPosition(positions, positionStride, indices[t * 3 + 2], p2);
+
+			float e1[3]{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3]{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3]{ e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (int k{ 0 }; k < 3; k++)
+			{
+				centroid[k] += (p0[k] + p1[k] + p2[k]) * (triangleArea / 3.0f);
+				normal[k] += n[k];
+			}
+			area += triangleArea;
+		}
+
+		for (int k{ 0 }; k < 3; k++)
+		{
+			meshCentroid[k] += centroid[k];
+			centroid[k] = area > 0.0f ? centroid[k] / area : 0.0f;
+		}
+		meshArea += area;
+	}
+	for (int k{ 0 }; k < 3; k++)
+	{
+		meshCentroid[k] = meshArea > 0.0f ? meshCentroid[k] / meshArea : 0.0f;
+	}
+
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c{ 0 }; c < clusterCount; c++)
+	{
+		const float* centroid = &clusterCentroids[c * 3];
+		const float* normal = &clusterNormals[c * 3];
+		float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float dot{ 0.0f };
+		for (int k{ 0 }; k < 3; k++)
+		{
+			dot += (centroid[k] - meshCentroid[k]) * normal[k];
+		}
+		sortKeys[c] = length > 0.0f ? dot / length : 0.0f;
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	size_t output{ 0 };
+	for (uint32_t c : order)
+	{
+		uint32_t end = c + 1 < clusterCount ? starts[c + 1] : triangleCount;
+		size_t count = size_t{ end - starts[c] } * 3;
+		memcpy(destination + output, indices + size_t{ starts[c] } * 3, count * sizeof(uint32_t));
+		output += count;
+	}
+	return static_cast<uint32_t>(clusterCount);
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------------
+uint32_t optimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, uint32_t vertexCount, uint32_t stride)
+{
+	assert(destination != vertices);
+	const uint32_t unused{ 0xffffffff };
+	std::vector<uint32_t> remap(vertexCount, unused);
+
+	uint8_t* out = static_cast<uint8_t*>(destination);
+	const uint8_t* in = static_cast<const uint8_t*>(vertices);
+	uint32_t next{ 0 };
+	for (size_t i{ 0 }; i < indexCount; i++)
+	{
+		uint32_t& mapped = remap[indices[i]];
+		if (mapped == unused)
+		{
+			memcpy(out + size_t{ next } * stride, in + size_t{ indices[i] } * stride, stride);
+			mapped = next++;
+		}
+		indices[i] = mapped;
+	}
+	return next;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+MeshOptimizeReport optimizeMesh(std::vector<uint8_t>& vertices, uint32_t stride, uint32_t positionOffset, std::vector<uint32_t>& indices,
+	uint32_t cacheSize)
+{
+	MeshOptimizeReport report;
+	const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+	report.verticesBefore = vertexCount;
+	report.before = analyzeVertexCache(indices.data(), indices.size(), vertexCount, cacheSize);
+
+	std::vector<uint32_t> clusters;
+	std::vector<uint32_t> scratch(indices.size());
+	optimizeVertexCache(scratch.data(), indices.data(), indices.size(), vertexCount, cacheSize, &clusters);
+	report.clusters = optimizeOverdraw(indices.data(), scratch.data(), indices.size(), vertices.data() + positionOffset, stride,
+		vertexCount, clusters, cacheSize);
+
+	std::vector<uint8_t> fetchOrdered(vertices.size());
+	report.verticesAfter = optimizeVertexFetch(fetchOrdered.data(), indices.data(), indices.size(), vertices.data(), vertexCount, stride);
+	fetchOrdered.resize(size_t{ report.verticesAfter } * stride);
+	vertices.swap(fetchOrdered);
+
+	report.after = analyzeVertexCache(indices.data(), indices.size(), report.verticesAfter, cacheSize);
+	return report;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Post transform cache behaviour of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats
+{
+	uint32_t misses{ 0 };	//vertices transformed
+	float acmr{ 0.0f };		//average cache miss ratio, misses per triangle (0.5 at best, 3 at worst)
+	float atvr{ 0.0f };		//average transform to vertex ratio, misses per vertex (1 at best)
+};
+
+//Everything optimizeMesh did, for logging
+struct MeshOptimizeReport
+{
+	VertexCacheStats before;
+	VertexCacheStats after;
+	uint32_t verticesBefore{ 0 };
+	uint32_t verticesAfter{ 0 };	//unreferenced vertices are dropped
+	uint32_t clusters{ 0 };			//overdraw clusters the triangles were sorted in
+};
+
+//Simulates a FIFO cache of cacheSize vertices over a triangle list
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+//Tipsify (Sander, Nehab, Barczak 2007): reorders triangles for the post transform cache in
+//linear time. destination may equal indices. When clusters is given it receives the first
+//triangle of every run that starts with a cold cache, the input to optimizeOverdraw
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+	uint32_t cacheSize = 16, std::vector<uint32_t>* clusters = nullptr);
+
+//Splits the clusters further wherever the cache has warmed up to within threshold of the
+//cluster's miss ratio, then orders them so outward facing clusters on the outside of the
+//mesh come first and occlude the rest. Positions are 3 floats every positionStride bytes.
+//Returns the number of clusters; destination may not equal indices
+uint32_t optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* positions, size_t positionStride,
+	uint32_t vertexCount, const std::vector<uint32_t>& clusters, uint32_t cacheSize = 16, float threshold = 1.05f);
+
+//Moves vertices into the order the index buffer first uses them, so fetches walk memory
+//forwards, and rewrites indices to match. Unreferenced vertices are dropped; returns the
+//new vertex count. destination may not equal vertices
+uint32_t optimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, uint32_t vertexCount, uint32_t stride);
+
+//Vertex cache, overdraw and vertex fetch passes in order, in place.
+//The position is 3 floats at positionOffset in every vertex
+MeshOptimizeReport optimizeMesh(std::vector<uint8_t>& vertices, uint32_t stride, uint32_t positionOffset, std::vector<uint32_t>& indices,
+	uint32_t cacheSize = 16);
+
+//Whether indices into vertexCount vertices fit 16 bit indices
+inline bool fitsIndex16(uint32_t vertexCount) { return vertexCount <= 0x10000; }
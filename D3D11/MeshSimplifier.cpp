@@ -0,0 +1,420 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "Parallel.h"
+#include "RadixSort.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	//Sum of squared distances to a set of planes, as the symmetric 4x4 matrix p * p^T
+	//weighted by triangle area. weight is the summed area, so cost / weight is a mean
+	struct Quadric
+	{
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+		double weight;
+
+		//------------------------------------------------------------
+		void addPlane(double x, double y, double z, double d, double w)
+		{
+			a00 += w * x * x; a01 += w * x * y; a02 += w * x * z; a03 += w * x * d;
+			a11 += w * y * y; a12 += w * y * z; a13 += w * y * d;
+			a22 += w * z * z; a23 += w * z * d;
+			a33 += w * d * d;
+			weight += w;
+		}
+
+		//-------------------------------------
+		void add(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+			a11 += q.a11; a12 += q.a12; a13 += q.a13;
+			a22 += q.a22; a23 += q.a23;
+			a33 += q.a33;
+			weight += q.weight;
+		}
+
+		//----------------------------------------------------
+		double evaluate(const float p[3]) const
+		{
+			double x = p[0], y = p[1], z = p[2];
+			return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+				+ a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+				+ a22 * z * z + 2.0 * a23 * z
+				+ a33;
+		}
+	};
+
+	//Squared mean distance of p to the planes of both quadrics
+	//--------------------------------------------------------------------------
+	double collapseCost(const Quadric& from, const Quadric& to, const float p[3])
+	{
+		double weight = from.weight + to.weight;
+		double cost = from.evaluate(p) + to.evaluate(p);
+		return weight > 0.0 ? std::max(cost / weight, 0.0) : 0.0;
+	}
+
+	//--------------------------------------------------------------------------------
+	void readPosition(const void* positions, size_t stride, uint32_t vertex, float position[3])
+	{
+		memcpy(position, static_cast<const uint8_t*>(positions) + stride * vertex, sizeof(float) * 3);
+	}
+
+	//-------------------------------------------------------------------------
+	void triangleNormal(const float a[3], const float b[3], const float c[3], double n[3])
+	{
+		double e0[3]{ double{ b[0] } - a[0], double{ b[1] } - a[1], double{ b[2] } - a[2] };
+		double e1[3]{ double{ c[0] } - a[0], double{ c[1] } - a[1], double{ c[2] } - a[2] };
+		n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+		n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+		n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+	}
+
+	//Vertices that must stay: attribute seams, borders and non manifold edges, found on the
+	//mesh welded by position
+	//--------------------------------------------------------------------------------------------------------------------------
+	std::vector<uint8_t> findLockedVertices(const uint32_t* indices, size_t indexCount, const void* positions, size_t positionStride,
+		uint32_t vertexCount)
+	{
+		std::vector<float> points(size_t{ vertexCount } * 3);
+		for (uint32_t v{ 0 }; v < vertexCount; v++)
+		{
+			readPosition(positions, positionStride, v, &points[size_t{ v } * 3]);
+		}
+
+		//Weld by sorting on position
+		std::vector<uint32_t> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0);
+		auto less = [&points](uint32_t a, uint32_t b)
+		{
+			return std::lexicographical_compare(&points[size_t{ a } * 3], &points[size_t{ a } * 3 + 3], &points[size_t{ b } * 3], &points[size_t{ b } * 3 + 3]);
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		std::vector<uint32_t> welded(vertexCount);
+		std::vector<uint8_t> locked(vertexCount, 0);
+		for (size_t i{ 0 }; i < order.size();)
+		{
+			size_t end = i + 1;
+			while (end < order.size() && !less(order[i], order[end]))
+			{
+				end++;
+			}
+			for (size_t j{ i }; j < end; j++)
+			{
+				welded[order[j]] = order[i];
+				locked[order[j]] = end - i > 1 ? 1 : 0;
+			}
+			i = end;
+		}
+
+		//An edge of a closed manifold is used by exactly two triangles
+		std::vector<uint64_t> edges;
+		edges.reserve(indexCount);
+		for (size_t i{ 0 }; i + 3 <= indexCount; i += 3)
+		{
+			for (int e{ 0 }; e < 3; e++)
+			{
+				uint32_t a = welded[indices[i + e]];
+				uint32_t b = welded[indices[i + (e + 1) % 3]];
+				edges.push_back(uint64_t{ std::min(a, b) } << 32 | std::max(a, b));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		std::vector<uint8_t> lockedWelded(vertexCount, 0);
+		for (size_t i{ 0 }; i < edges.size();)
+		{
+			size_t end = i + 1;
+			while (end < edges.size() && edges[end] == edges[i])
+			{
+				end++;
+			}
+			if (end - i != 2)
+			{
+				lockedWelded[edges[i] >> 32] = 1;
+				lockedWelded[edges[i] & 0xffffffff] = 1;
+			}
+			i = end;
+		}
+		for (uint32_t v{ 0 }; v < vertexCount; v++)
+		{
+			locked[v] |= lockedWelded[welded[v]];
+		}
+		return locked;
+	}
+
+	//Candidate collapse of vertex from into its neighbour to, key orders by cost
+	struct Collapse
+	{
+		uint32_t key;
+		uint32_t from;
+		uint32_t to;
+		float cost;
+	};
+
+	//-------------------------------------------------------------------------
+	Collapse makeCollapse(uint32_t from, uint32_t to, double cost)
+	{
+		float value = static_cast<float>(cost);
+		return Collapse{ floatToSortableUint(value), from, to, value };
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* positions, size_t positionStride,
+	uint32_t vertexCount, size_t targetIndexCount, float targetError, float* resultError)
+{
+	std::vector<uint32_t> current(indices, indices + indexCount - indexCount % 3);
+	const std::vector<uint8_t> locked = findLockedVertices(current.data(), current.size(), positions, positionStride, vertexCount);
+	const double maxCost = targetError > 0.0f ? double{ targetError } * targetError : HUGE_VAL;
+
+	std::vector<float> points(size_t{ vertexCount } * 3);
+	for (uint32_t v{ 0 }; v < vertexCount; v++)
+	{
+		readPosition(positions, positionStride, v, &points[size_t{ v } * 3]);
+	}
+	auto point = [&points](uint32_t v) { return &points[size_t{ v } * 3]; };
+
+	//Plane quadrics of every triangle on its three vertices
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for (size_t i{ 0 }; i < current.size(); i += 3)
+	{
+		double n[3];
+		triangleNormal(point(current[i]), point(current[i + 1]), point(current[i + 2]), n);
+		double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length == 0.0)
+		{
+			continue;
+		}
+		double x = n[0] / length, y = n[1] / length, z = n[2] / length;
+		const float* p = point(current[i]);
+		double d = -(x * p[0] + y * p[1] + z * p[2]);
+		for (int k{ 0 }; k < 3; k++)
+		{
+			quadrics[current[i + k]].addPlane(x, y, z, d, length * 0.5);
+		}
+	}
+
+	//Vertex to triangle lists, rebuilt every pass
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	std::vector<Collapse> collapses;
+	std::vector<Collapse> sortScratch;
+	std::vector<uint32_t> sortHistograms;
+	double error{ 0.0 };
+
+	//Every pass takes the cheapest collapses whose neighbourhoods do not overlap, then
+	//compacts the index buffer; a vertex is collapsed at most once per pass
+	while (current.size() > targetIndexCount)
+	{
+		offsets.assign(size_t{ vertexCount } + 1, 0);
+		for (uint32_t index : current)
+		{
+			offsets[index + 1]++;
+		}
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		triangles.resize(current.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i{ 0 }; i < current.size(); i++)
+		{
+			triangles[fill[current[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		collapses.clear();
+		for (size_t i{ 0 }; i < current.size(); i += 3)
+		{
+			for (int e{ 0 }; e < 3; e++)
+			{
+				//Interior edges show up once in each direction, take them from one side
+				uint32_t a = current[i + e];
+				uint32_t b = current[i + (e + 1) % 3];
+				if (a > b)
+				{
+					continue;
+				}
+				if (!locked[a])
+				{
+					collapses.push_back(makeCollapse(a, b, collapseCost(quadrics[a], quadrics[b], point(b))));
+				}
+				if (!locked[b])
+				{
+					collapses.push_back(makeCollapse(b, a, collapseCost(quadrics[b], quadrics[a], point(a))));
+				}
+			}
+		}
+		radixSort(collapses, sortScratch, sortHistograms);
+
+		//A collapse removes two triangles, so twice as many candidates as triangles left to
+		//remove is plenty for a pass. Stopping there, rather than running down to expensive
+		//collapses, lets the cheap ones update the quadrics first
+		size_t triangleCount = current.size() / 3;
+		const size_t targetTriangles = targetIndexCount / 3;
+		collapses.resize(std::min<size_t>(collapses.size(), (triangleCount - targetTriangles) * 2));
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(touched.begin(), touched.end(), uint8_t{ 0 });
+		size_t collapsed{ 0 };
+		for (const Collapse& collapse : collapses)
+		{
+			if (triangleCount <= targetTriangles || collapse.cost > maxCost)
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			//The triangles around from that survive must not flip or become slivers
+			bool valid{ true };
+			size_t removed{ 0 };
+			for (uint32_t t{ offsets[collapse.from] }; t < offsets[collapse.from + 1] && valid; t++)
+			{
+				const uint32_t* triangle = &current[size_t{ triangles[t] } * 3];
+				uint32_t v[3]{ remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+				if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+				{
+					continue;
+				}
+				if (v[0] == collapse.to || v[1] == collapse.to || v[2] == collapse.to)
+				{
+					removed++;
+					continue;
+				}
+
+				double before[3], after[3];
+				triangleNormal(point(v[0]), point(v[1]), point(v[2]), before);
+				for (uint32_t& vertex : v)
+				{
+					vertex = vertex == collapse.from ? collapse.to : vertex;
+				}
+				triangleNormal(point(v[0]), point(v[1]), point(v[2]), after);
+				double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+				double lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+					(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+				valid = lengths > 0.0 && dot > 0.25 * lengths;
+			}
+			if (!valid)
+			{
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			touched[collapse.from] = 1;
+			touched[collapse.to] = 1;
+			triangleCount -= removed;
+			error = std::max(error, double{ collapse.cost });
+			collapsed++;
+		}
+
+		if (collapsed == 0)
+		{
+			break;
+		}
+
+		//Drop the triangles that lost an edge
+		size_t write{ 0 };
+		for (size_t i{ 0 }; i < current.size(); i += 3)
+		{
+			uint32_t a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+			if (a != b && b != c && c != a)
+			{
+				current[write++] = a;
+				current[write++] = b;
+				current[write++] = c;
+			}
+		}
+		current.resize(write);
+	}
+
+	std::copy(current.begin(), current.end(), destination);
+	if (resultError != nullptr)
+	{
+		*resultError = static_cast<float>(std::sqrt(error));
+	}
+	return current.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+std::vector<MeshLod> buildLodChain(std::vector<uint32_t>& indices, const void* positions, size_t positionStride, uint32_t vertexCount,
+	const LodChainSettings& settings)
+{
+	std::vector<MeshLod> lods;
+	lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+	//The error limit scales with the mesh
+	float maxError{ 0.0f };
+	if (settings.maxError > 0.0f && !indices.empty())
+	{
+		float low[3], high[3];
+		readPosition(positions, positionStride, indices[0], low);
+		readPosition(positions, positionStride, indices[0], high);
+		for (uint32_t index : indices)
+		{
+			float p[3];
+			readPosition(positions, positionStride, index, p);
+			for (int c{ 0 }; c < 3; c++)
+			{
+				low[c] = std::min(low[c], p[c]);
+				high[c] = std::max(high[c], p[c]);
+			}
+		}
+		maxError = settings.maxError * std::max({ high[0] - low[0], high[1] - low[1], high[2] - low[2] });
+	}
+
+	std::vector<uint32_t> level;
+	while (lods.size() < settings.maxLevels)
+	{
+		const MeshLod& previous = lods.back();
+		size_t target = static_cast<size_t>(previous.indexCount / 3 * settings.reduction) * 3;
+		if (target < size_t{ settings.minTriangles } * 3)
+		{
+			break;
+		}
+
+		//The level may add whatever error the chain has left
+		level.assign(indices.begin() + previous.startIndex, indices.begin() + previous.startIndex + previous.indexCount);
+		float levelError{ 0.0f };
+		float errorLeft = maxError > 0.0f ? maxError - previous.error : 0.0f;
+		if (maxError > 0.0f && errorLeft <= 0.0f)
+		{
+			break;
+		}
+		size_t count = simplifyMesh(level.data(), level.data(), level.size(), positions, positionStride, vertexCount, target, errorLeft, &levelError);
+
+		//Not worth a level unless it removes a good share of the triangles
+		if (count == 0 || count > previous.indexCount - previous.indexCount / 8)
+		{
+			break;
+		}
+		optimizeVertexCache(level.data(), level.data(), count, vertexCount);
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(count), previous.error + levelError });
+		indices.insert(indices.end(), level.begin(), level.begin() + count);
+	}
+	return lods;
+}
+
+//---------------------------------------------------------------------------------------
+void buildLodChains(LodMesh* meshes, size_t meshCount, const LodChainSettings& settings)
+{
+	//Meshes differ a lot in size, so chunks pull the next mesh rather than taking fixed ranges
+	std::atomic<size_t> next{ 0 };
+	parallelFor(meshCount, 1, [&](size_t, size_t, size_t)
+	{
+		for (size_t i = next++; i < meshCount; i = next++)
+		{
+			LodMesh& mesh = meshes[i];
+			*mesh.lods = buildLodChain(*mesh.indices, mesh.positions, mesh.positionStride, mesh.vertexCount, settings);
+		}
+	});
+}
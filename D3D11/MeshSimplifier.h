@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//One level of detail: a range of a mesh's index buffer over the same vertices
+struct MeshLod
+{
+	uint32_t startIndex{ 0 };
+	uint32_t indexCount{ 0 };
+	float error{ 0.0f };	//geometric error in local space units, 0 for the full mesh
+};
+
+//How buildLodChain spaces the levels
+struct LodChainSettings
+{
+	float reduction{ 0.5f };		//triangles of a level relative to the one before
+	uint32_t maxLevels{ 6 };		//including the full mesh
+	uint32_t minTriangles{ 32 };	//no level is built below this
+	float maxError{ 0.05f };		//relative to the largest side of the mesh bounds, 0 for no limit
+};
+
+//A mesh for buildLodChains. indices holds the full mesh on entry and every level back to
+//back on exit, positions are 3 floats every positionStride bytes
+struct LodMesh
+{
+	std::vector<uint32_t>* indices{ nullptr };
+	const void* positions{ nullptr };
+	size_t positionStride{ 0 };
+	uint32_t vertexCount{ 0 };
+	std::vector<MeshLod>* lods{ nullptr };
+};
+
+//Quadric error metric simplification (Garland, Heckbert 1997) by half edge collapse: a vertex
+//is merged into a neighbour and never moved, so the result indexes the original vertex buffer.
+//Vertices on a border, a non manifold edge or an attribute seam (several vertices at one
+//position) are kept. Collapses that flip a triangle are rejected. Stops at targetIndexCount
+//or when the next collapse would exceed targetError (0 for no limit); returns the index count
+//written to destination, which may equal indices, and the error reached in resultError
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const void* positions, size_t positionStride,
+	uint32_t vertexCount, size_t targetIndexCount, float targetError = 0.0f, float* resultError = nullptr);
+
+//Simplifies each level from the one before, reorders it for the vertex cache and appends it
+//to indices. Level errors add up and bound the mean distance to the full mesh, single
+//vertices can be a few times further. Returns the levels, the full mesh first
+std::vector<MeshLod> buildLodChain(std::vector<uint32_t>& indices, const void* positions, size_t positionStride, uint32_t vertexCount,
+	const LodChainSettings& settings = LodChainSettings{});
+
+//buildLodChain for every mesh, the meshes are shared out over worker threads as they finish
+void buildLodChains(LodMesh* meshes, size_t meshCount, const LodChainSettings& settings = LodChainSettings{});
@@ -1,56 +1,58 @@
 #pragma once
 #include "Lighting.h"
-#include "d3dUtil.h"
-
-struct VertexNorm
-{
-	XMFLOAT3 position;
-	XMFLOAT3 normal;
-};
-
-struct VertexNormTex
-{
-	XMFLOAT3 position;
-	XMFLOAT3 normal;
-	XMFLOAT2 texCoords;
-};
-
-struct VertexColor
-{
-	XMFLOAT3 position;
-	XMFLOAT4 color;
-};
+#include "Culling.h"
+#include "Flipbook.h"
+#include "GameTimer.h"
+#include "RenderDevice.h"
+#include "GeometryPool.h"
+#include "Vertex.h"
+#include "MeshSimplifier.h"
 
 class Model
 {
 public:
 
-	Model(UINT stride, UINT indexCount) : stride{stride}, indexCount{indexCount}
+	Model(uint32_t stride, uint32_t indexCount) : stride{stride}, indexCount{indexCount}
 	{ 
 		XMMATRIX identity = XMMatrixIdentity();
 		XMStoreFloat4x4(&worldMatrix, identity);
 		XMStoreFloat4x4(&texTransformMatrix, identity);
+		XMStoreFloat4x4(&positionDecode, identity);
 	}
 
 	//Vertex Buffer
-	ComPtr<ID3D11Buffer>vertexBuffer;
-	UINT stride{ 0 };
-	UINT offset{ 0 };
+	BufferHandle vertexBuffer;
+	uint32_t stride{ 0 };
+	uint32_t offset{ 0 };
 
 	XMFLOAT4X4 worldMatrix;
 	Material material;
 
+	//Takes quantized vertex positions back to local space, applied before worldMatrix
+	//Identity for float vertices
+	XMFLOAT4X4 positionDecode;
+
 	//Index Buffer
-	ComPtr<ID3D11Buffer>indexBuffer;
-	UINT indexCount{ 0 };
-	UINT startIndex{ 0 };
-	UINT baseVertex{ 0 };
+	BufferHandle indexBuffer;
+	uint32_t indexCount{ 0 };
+	uint32_t startIndex{ 0 };
+	int32_t baseVertex{ 0 };
+	IndexFormat indexFormat{ IndexFormat::UInt32 };
+
+	//Index ranges of the levels of detail in indexBuffer, level 0 is startIndex / indexCount
+	std::vector<MeshLod> lods;
+
+	//Local space bounds, computed when the vertex buffer is built
+	Bounds bounds;
 
 	//Texture
-	ComPtr<ID3D11ShaderResourceView> texViews[120];
-	ComPtr<ID3D11SamplerState> sampler;
+	TextureHandle texture;
+	SamplerHandle sampler;
 	XMFLOAT4X4 texTransformMatrix;
-	float animTimer{ 0.0f };
+
+	//Flipbook animation, frames are selected through texTransformMatrix so the texture never changes
+	const Flipbook* flipbook{ nullptr };
+	double animTimer{ 0.0 };
 	float frameChangeTimer { 1.0f / 30.0f };
 	int currentFrame{ 0 };
 	bool useTexture{ true };	
@@ -58,105 +60,57 @@ public:
 	float uOffset{ 0.0f };
 	float vOffset{ 0.0f };
 
-	//----------------------------------------------------------
-	void performInefficientAnimation(const GameTimer& gameTimer)
+	//Draws from a range of the shared geometry buffers
+	//------------------------------------------------------
+	void setGeometry(const GeometryAllocation& geometry)
 	{
-		if ((gameTimer.totalTime() - animTimer) > frameChangeTimer)
+		setGeometry(geometry, { MeshLod{ 0, geometry.indexCount, 0.0f } });
+	}
+
+	//The allocation holds every level back to back, level starts are relative to it
+	//---------------------------------------------------------------------------------------------
+	void setGeometry(const GeometryAllocation& geometry, const std::vector<MeshLod>& levels)
+	{
+		vertexBuffer = geometry.vertexBuffer;
+		stride = geometry.stride;
+		offset = 0;
+		indexBuffer = geometry.indexBuffer;
+		baseVertex = static_cast<int32_t>(geometry.baseVertex);
+		indexFormat = geometry.indexFormat;
+
+		lods = levels;
+		for (MeshLod& level : lods)
 		{
-			animTimer += frameChangeTimer;
-			currentFrame++;
-			if (currentFrame == 120)
-			{
-				currentFrame = 0;
-			}
+			level.startIndex += geometry.startIndex;
 		}
+		startIndex = lods.front().startIndex;
+		indexCount = lods.front().indexCount;
 	}
-};
 
-//-----------------------------------------------------//
-//-----------------------CUBE--------------------------//
-//-----------------------------------------------------//
-VertexNormTex cubeVertices[] =
-{
-	//Top Face
-	{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 0
-	{XMFLOAT3{-0.5f,  0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 1
-	{XMFLOAT3{ 0.5f,  0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 2
-	{XMFLOAT3{ 0.5f,  0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 3
-
-	//Bottom Face								  
-	{XMFLOAT3{-0.5f, -0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 4
-	{XMFLOAT3{-0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 5
-	{XMFLOAT3{ 0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 6
-	{XMFLOAT3{ 0.5f, -0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 7
-
-	//Left Face									  
-	{XMFLOAT3{-0.5f, -0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 8
-	{XMFLOAT3{-0.5f,  0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 9
-	{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 10
-	{XMFLOAT3{-0.5f, -0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 11
-
-	//Right Face								  
-	{XMFLOAT3{ 0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 12
-	{XMFLOAT3{ 0.5f,  0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 13
-	{XMFLOAT3{ 0.5f,  0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 14
-	{XMFLOAT3{ 0.5f, -0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 15	
-
-	//Front Face								  
-	{XMFLOAT3{-0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 16
-	{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 17
-	{XMFLOAT3{ 0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 18
-	{XMFLOAT3{ 0.5f, -0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 19
-
-	//Back Face									  
-	{XMFLOAT3{ 0.5f, -0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 20
-	{XMFLOAT3{ 0.5f,  0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 21
-	{XMFLOAT3{-0.5f,  0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 22
-	{XMFLOAT3{-0.5f, -0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 23		
-};
-
-//Cube Indices
-unsigned int cubeIndices[] = {
-	//Top Face
-	0, 1, 2,
-	0, 2, 3,
-
-	//Bottom Face
-	4, 5, 6,
-	4, 6, 7,
-
-	//Left Face
-	8, 9, 10,
-	8, 10, 11,
-
-	//Right Face
-	12, 13, 14,
-	12, 14, 15,
-
-	//Front Face
-	16, 17, 18,
-	16, 18, 19,
+	//Index range of a level of detail, clamped to the coarsest one
+	//------------------------------------------------------
+	MeshLod lod(uint32_t level) const
+	{
+		if (lods.empty())
+		{
+			return MeshLod{ startIndex, indexCount, 0.0f };
+		}
+		return level < lods.size() ? lods[level] : lods.back();
+	}
 
-	//Back Face
-	20, 21, 22,
-	20, 22, 23
-};
+	//------------------------------------------------------
+	void updateFlipbookAnimation(const GameTimer& gameTimer)
+	{
+		if (flipbook == nullptr || flipbook->frameCount() == 0)
+		{
+			return;
+		}
 
-//-----------------------------------------------------//
-//-----------------------QUAD--------------------------//
-//-----------------------------------------------------//
-VertexNormTex quadVertices[] =
-{
-	//Front Face								  
-	{XMFLOAT3{-0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 0
-	{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 1
-	{XMFLOAT3{ 0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 2
-	{XMFLOAT3{ 0.5f, -0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 3
+		if ((gameTimer.totalTime() - animTimer) > frameChangeTimer)
+		{
+			animTimer += frameChangeTimer;
+			currentFrame = (currentFrame + 1) % flipbook->frameCount();
+			texTransformMatrix = flipbook->frameTransform(currentFrame);
+		}
+	}
 };
-
-//Cube Indices
-unsigned int quadIndices[] = {
-	//Top Face
-	0, 1, 2,
-	0, 2, 3,
-};
\ No newline at end of file
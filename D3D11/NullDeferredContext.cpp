@@ -0,0 +1,279 @@
+#include "NullDeferredContext.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+//-----------------------------------------------------------
+void NullCommandList::replay(IRenderContext& context) const
+{
+	for (const Command& command : commands)
+	{
+		const uint32_t* args = command.args;
+		const uint8_t* bytes = data.data() + command.dataOffset;
+		switch (command.call)
+		{
+		case RenderCall::UpdateBuffer:
+			context.updateBuffer({ args[0] }, args[1], bytes, args[2]);
+			break;
+		case RenderCall::UnmapBuffer:
+			memcpy(context.mapBuffer({ args[0] }, static_cast<MapMode>(args[1])), bytes, args[2]);
+			context.unmapBuffer({ args[0] });
+			break;
+		case RenderCall::Clear:
+		{
+			float color[4];
+			float depth;
+			memcpy(color, bytes, sizeof(color));
+			memcpy(&depth, bytes + sizeof(color), sizeof(depth));
+			context.clear(color, depth, static_cast<uint8_t>(args[0]));
+			break;
+		}
+		case RenderCall::SetViewport:
+		{
+			Viewport viewport;
+			memcpy(&viewport, bytes, sizeof(viewport));
+			context.setViewport(viewport);
+			break;
+		}
+		case RenderCall::SetBlendState:
+			context.setBlendState({ args[0] });
+			break;
+		case RenderCall::SetVertexBuffers:
+		{
+			const uint32_t maxSlots{ 32 };	//D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT
+			const uint32_t count{ args[1] };
+			BufferHandle buffers[maxSlots];
+			uint32_t strides[maxSlots];
+			uint32_t offsets[maxSlots];
+			memcpy(buffers, bytes, count * sizeof(BufferHandle));
+			memcpy(strides, bytes + count * sizeof(BufferHandle), count * sizeof(uint32_t));
+			memcpy(offsets, bytes + count * (sizeof(BufferHandle) + sizeof(uint32_t)), count * sizeof(uint32_t));
+			context.setVertexBuffers(args[0], count, buffers, strides, offsets);
+			break;
+		}
+		case RenderCall::SetIndexBuffer:
+			context.setIndexBuffer({ args[0] }, static_cast<IndexFormat>(args[1]), args[2]);
+			break;
+		case RenderCall::SetInputLayout:
+			context.setInputLayout({ args[0] });
+			break;
+		case RenderCall::SetPrimitiveTopology:
+			context.setPrimitiveTopology(static_cast<PrimitiveTopology>(args[0]));
+			break;
+		case RenderCall::SetVertexShader:
+			context.setVertexShader({ args[0] });
+			break;
+		case RenderCall::SetPixelShader:
+			context.setPixelShader({ args[0] });
+			break;
+		case RenderCall::SetConstantBuffer:
+			context.setConstantBuffer(static_cast<ShaderStage>(args[0]), args[1], { args[2] }, args[3], args[4]);
+			break;
+		case RenderCall::SetTexture:
+			context.setTexture(static_cast<ShaderStage>(args[0]), args[1], { args[2] });
+			break;
+		case RenderCall::SetStructuredBuffer:
+			context.setStructuredBuffer(static_cast<ShaderStage>(args[0]), args[1], { args[2] });
+			break;
+		case RenderCall::SetSampler:
+			context.setSampler(static_cast<ShaderStage>(args[0]), args[1], { args[2] });
+			break;
+		case RenderCall::SetRasterizerState:
+			context.setRasterizerState({ args[0] });
+			break;
+		case RenderCall::DrawIndexed:
+			context.drawIndexed(args[0], args[1], static_cast<int32_t>(args[2]));
+			break;
+		case RenderCall::DrawIndexedInstanced:
+			context.drawIndexedInstanced(args[0], args[1], args[2], static_cast<int32_t>(args[3]), args[4]);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+//-------------------------------------------------------------
+std::unique_ptr<ICommandList> NullDeferredContext::finish()
+{
+	assert(mapped.empty());
+
+	std::unique_ptr<NullCommandList> finished{ std::move(list) };
+	list.reset(new NullCommandList);
+	//Start the next list with as much room as this one needed
+	list->commands.reserve(finished->commands.size());
+	list->data.reserve(finished->data.size());
+	return finished;
+}
+
+//-------------------------------------------------------------------------------------------------------------
+void NullDeferredContext::record(RenderCall call, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4)
+{
+	list->commands.push_back({ call, { a0, a1, a2, a3, a4 }, static_cast<uint32_t>(list->data.size()) });
+}
+
+//--------------------------------------------------------------------
+void NullDeferredContext::recordData(const void* bytes, size_t size)
+{
+	const uint8_t* first = static_cast<const uint8_t*>(bytes);
+	list->data.insert(list->data.end(), first, first + size);
+}
+
+//-------------------------------------------------------------------------------------------------------------
+void NullDeferredContext::updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size)
+{
+	size_t bufferSize = device.buffer(buffer).bytes.size();
+	size = offset < bufferSize ? std::min(size, bufferSize - offset) : 0;
+	record(RenderCall::UpdateBuffer, buffer.id, offset, static_cast<uint32_t>(size));
+	recordData(data, size);
+}
+
+//Writes go to a copy of the buffer, recorded on unmap
+//--------------------------------------------------------------------
+void* NullDeferredContext::mapBuffer(BufferHandle buffer, MapMode mode)
+{
+	const std::vector<uint8_t>& current = device.buffer(buffer).bytes;
+	MappedBuffer staging{ buffer, mode, {} };
+	if (mode == MapMode::WriteNoOverwrite)
+	{
+		staging.bytes = current;
+	}
+	else
+	{
+		staging.bytes.resize(current.size());
+	}
+	mapped.push_back(std::move(staging));
+	return mapped.back().bytes.data();
+}
+
+//-------------------------------------------------------
+void NullDeferredContext::unmapBuffer(BufferHandle buffer)
+{
+	auto staging = std::find_if(mapped.begin(), mapped.end(), [buffer](const MappedBuffer& map) { return map.buffer == buffer; });
+	assert(staging != mapped.end());
+	if (staging == mapped.end())
+	{
+		return;
+	}
+
+	record(RenderCall::UnmapBuffer, buffer.id, static_cast<uint32_t>(staging->mode), static_cast<uint32_t>(staging->bytes.size()));
+	recordData(staging->bytes.data(), staging->bytes.size());
+	mapped.erase(staging);
+}
+
+//--------------------------------------------------------------------------------
+void NullDeferredContext::clear(const float color[4], float depth, uint8_t stencil)
+{
+	record(RenderCall::Clear, stencil);
+	recordData(color, sizeof(float) * 4);
+	recordData(&depth, sizeof(depth));
+}
+
+//----------------------------------------------------------------
+void NullDeferredContext::setViewport(const Viewport& viewport)
+{
+	record(RenderCall::SetViewport);
+	recordData(&viewport, sizeof(viewport));
+}
+
+//--------------------------------------------------------------
+void NullDeferredContext::setBlendState(BlendStateHandle state)
+{
+	record(RenderCall::SetBlendState, state.id);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------
+void NullDeferredContext::setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[])
+{
+	assert(count <= 32);
+	record(RenderCall::SetVertexBuffers, startSlot, count);
+	recordData(buffers, count * sizeof(BufferHandle));
+	recordData(strides, count * sizeof(uint32_t));
+	recordData(offsets, count * sizeof(uint32_t));
+}
+
+//------------------------------------------------------------------------------------------
+void NullDeferredContext::setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset)
+{
+	record(RenderCall::SetIndexBuffer, buffer.id, static_cast<uint32_t>(format), offset);
+}
+
+//----------------------------------------------------------------
+void NullDeferredContext::setInputLayout(InputLayoutHandle layout)
+{
+	record(RenderCall::SetInputLayout, layout.id);
+}
+
+//------------------------------------------------------------------------------
+void NullDeferredContext::setPrimitiveTopology(PrimitiveTopology topology)
+{
+	record(RenderCall::SetPrimitiveTopology, static_cast<uint32_t>(topology));
+}
+
+//------------------------------------------------------------------
+void NullDeferredContext::setVertexShader(VertexShaderHandle shader)
+{
+	record(RenderCall::SetVertexShader, shader.id);
+}
+
+//----------------------------------------------------------------
+void NullDeferredContext::setPixelShader(PixelShaderHandle shader)
+{
+	record(RenderCall::SetPixelShader, shader.id);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+void NullDeferredContext::setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+{
+	record(RenderCall::SetConstantBuffer, static_cast<uint32_t>(stage), slot, buffer.id, firstConstant, numConstants);
+}
+
+//-----------------------------------------------------------------------------------------
+void NullDeferredContext::setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture)
+{
+	record(RenderCall::SetTexture, static_cast<uint32_t>(stage), slot, texture.id);
+}
+
+//------------------------------------------------------------------------------------------------
+void NullDeferredContext::setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer)
+{
+	record(RenderCall::SetStructuredBuffer, static_cast<uint32_t>(stage), slot, buffer.id);
+}
+
+//-----------------------------------------------------------------------------------------
+void NullDeferredContext::setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler)
+{
+	record(RenderCall::SetSampler, static_cast<uint32_t>(stage), slot, sampler.id);
+}
+
+//-------------------------------------------------------------------------
+void NullDeferredContext::setRasterizerState(RasterizerStateHandle state)
+{
+	record(RenderCall::SetRasterizerState, state.id);
+}
+
+//--------------------------------------------------------------------------------------------
+void NullDeferredContext::drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	record(RenderCall::DrawIndexed, indexCount, startIndex, static_cast<uint32_t>(baseVertex));
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------------------------------
+void NullDeferredContext::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+	record(RenderCall::DrawIndexedInstanced, indexCountPerInstance, instanceCount, startIndex, static_cast<uint32_t>(baseVertex), startInstance);
+}
+
+//Nested lists are copied in; unlike executing on the immediate context, state carries over
+//------------------------------------------------------------------------
+void NullDeferredContext::executeCommandList(ICommandList& commandList)
+{
+	const NullCommandList& nested = static_cast<const NullCommandList&>(commandList);
+	const uint32_t dataBase = static_cast<uint32_t>(list->data.size());
+	for (NullCommandList::Command command : nested.commands)
+	{
+		command.dataOffset += dataBase;
+		list->commands.push_back(command);
+	}
+	list->data.insert(list->data.end(), nested.data.begin(), nested.data.end());
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "NullRenderDevice.h"
+
+//Command list of the null and software backends: the recorded calls with copies of
+//their array and buffer arguments, replayed onto an immediate context when executed
+class NullCommandList : public ICommandList
+{
+public:
+
+	void replay(IRenderContext& context) const;
+
+	size_t commandCount() const { return commands.size(); }
+	size_t dataSize() const { return data.size(); }
+
+private:
+
+	friend class NullDeferredContext;
+
+	struct Command
+	{
+		RenderCall call;
+		uint32_t args[5];
+		uint32_t dataOffset;	//start of the call's bytes in data, if it has any
+	};
+
+	std::vector<Command> commands;
+	std::vector<uint8_t> data;	//viewports, clear colors, vertex buffer arrays and buffer contents
+};
+
+//Deferred context of the null and software backends
+//Nothing touches the device while recording except reads of buffer sizes and contents,
+//so several deferred contexts can record on different threads as long as buffers are
+//not created or destroyed meanwhile. A mapped buffer is staged in the context and the
+//whole buffer is written back when the list executes, so NO_OVERWRITE maps of a buffer
+//the immediate context writes to between record and execute are not supported
+class NullDeferredContext : public IDeferredContext, public IRenderContext
+{
+public:
+
+	explicit NullDeferredContext(NullRenderDevice& device) : device{ device }, list{ new NullCommandList } {}
+
+	IRenderContext& context() override { return *this; }
+	std::unique_ptr<ICommandList> finish() override;
+
+	void updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size) override;
+	void* mapBuffer(BufferHandle buffer, MapMode mode) override;
+	void unmapBuffer(BufferHandle buffer) override;
+
+	void clear(const float color[4], float depth, uint8_t stencil) override;
+	void setViewport(const Viewport& viewport) override;
+	void setBlendState(BlendStateHandle state) override;
+
+	void setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[]) override;
+	void setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) override;
+	void setInputLayout(InputLayoutHandle layout) override;
+	void setPrimitiveTopology(PrimitiveTopology topology) override;
+
+	void setVertexShader(VertexShaderHandle shader) override;
+	void setPixelShader(PixelShaderHandle shader) override;
+	void setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+	void setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture) override;
+	void setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer) override;
+	void setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler) override;
+
+	void setRasterizerState(RasterizerStateHandle state) override;
+
+	void drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+	void executeCommandList(ICommandList& commandList) override;
+
+private:
+
+	struct MappedBuffer
+	{
+		BufferHandle buffer;
+		MapMode mode;
+		std::vector<uint8_t> bytes;
+	};
+
+	void record(RenderCall call, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint32_t a3 = 0, uint32_t a4 = 0);
+	void recordData(const void* bytes, size_t size);
+
+	NullRenderDevice& device;
+	std::unique_ptr<NullCommandList> list;
+	std::vector<MappedBuffer> mapped;
+};
@@ -0,0 +1,239 @@
+#include "NullRenderDevice.h"
+#include "NullDeferredContext.h"
+#include <algorithm>
+#include <cstring>
+
+//-------------------------------------------
+const char* renderCallName(RenderCall call)
+{
+	static const char* names[]
+	{
+		"updateBuffer", "mapBuffer", "unmapBuffer",
+		"clear", "setViewport", "setBlendState",
+		"setVertexBuffers", "setIndexBuffer", "setInputLayout", "setPrimitiveTopology",
+		"setVertexShader", "setPixelShader", "setConstantBuffer", "setTexture", "setStructuredBuffer", "setSampler",
+		"setRasterizerState",
+		"drawIndexed", "drawIndexedInstanced",
+		"executeCommandList"
+	};
+	static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(RenderCall::Count), "renderCallName is missing entries");
+	return names[static_cast<size_t>(call)];
+}
+
+//-----------------------------------------
+uint64_t RenderStats::totalCalls() const
+{
+	uint64_t total{ 0 };
+	for (uint64_t count : calls)
+	{
+		total += count;
+	}
+	return total;
+}
+
+//-----------------------------------------------------------------------------------------------------------
+void NullRenderContext::record(RenderCall call, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4)
+{
+	frameStats.calls[static_cast<size_t>(call)]++;
+	if (recording)
+	{
+		calls.push_back({ call, { a0, a1, a2, a3, a4 } });
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------
+void NullRenderContext::updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size)
+{
+	record(RenderCall::UpdateBuffer, buffer.id, offset, static_cast<uint32_t>(size));
+	NullRenderDevice::BufferData& target = device.buffer(buffer);
+	size = offset < target.bytes.size() ? std::min(size, target.bytes.size() - offset) : 0;
+	memcpy(target.bytes.data() + offset, data, size);
+	frameStats.bytesUploaded += size;
+}
+
+//------------------------------------------------------------------
+void* NullRenderContext::mapBuffer(BufferHandle buffer, MapMode mode)
+{
+	record(RenderCall::MapBuffer, buffer.id, static_cast<uint32_t>(mode));
+	mapMode = mode;
+	return device.buffer(buffer).bytes.data();
+}
+
+//-----------------------------------------------------
+void NullRenderContext::unmapBuffer(BufferHandle buffer)
+{
+	record(RenderCall::UnmapBuffer, buffer.id);
+	//The written range of a NO_OVERWRITE map is unknown; sub-allocators such as ConstantUploadRing count their own bytes
+	if (mapMode == MapMode::WriteDiscard)
+	{
+		frameStats.bytesUploaded += device.buffer(buffer).bytes.size();
+	}
+}
+
+//------------------------------------------------------------------------------
+void NullRenderContext::clear(const float /*color*/[4], float /*depth*/, uint8_t stencil)
+{
+	record(RenderCall::Clear, stencil);
+}
+
+//--------------------------------------------------------------
+void NullRenderContext::setViewport(const Viewport& viewport)
+{
+	record(RenderCall::SetViewport, static_cast<uint32_t>(viewport.width), static_cast<uint32_t>(viewport.height));
+}
+
+//------------------------------------------------------------
+void NullRenderContext::setBlendState(BlendStateHandle state)
+{
+	record(RenderCall::SetBlendState, state.id);
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------------------
+void NullRenderContext::setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t /*strides*/[], const uint32_t offsets[])
+{
+	record(RenderCall::SetVertexBuffers, startSlot, count, count > 0 ? buffers[0].id : 0, count > 1 ? buffers[1].id : 0, count > 0 ? offsets[0] : 0);
+}
+
+//----------------------------------------------------------------------------------------
+void NullRenderContext::setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset)
+{
+	record(RenderCall::SetIndexBuffer, buffer.id, static_cast<uint32_t>(format), offset);
+}
+
+//--------------------------------------------------------------
+void NullRenderContext::setInputLayout(InputLayoutHandle layout)
+{
+	record(RenderCall::SetInputLayout, layout.id);
+}
+
+//----------------------------------------------------------------------------
+void NullRenderContext::setPrimitiveTopology(PrimitiveTopology topology)
+{
+	record(RenderCall::SetPrimitiveTopology, static_cast<uint32_t>(topology));
+}
+
+//----------------------------------------------------------------
+void NullRenderContext::setVertexShader(VertexShaderHandle shader)
+{
+	record(RenderCall::SetVertexShader, shader.id);
+}
+
+//--------------------------------------------------------------
+void NullRenderContext::setPixelShader(PixelShaderHandle shader)
+{
+	record(RenderCall::SetPixelShader, shader.id);
+}
+
+//---------------------------------------------------------------------------------------------------------------------------------------
+void NullRenderContext::setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+{
+	record(RenderCall::SetConstantBuffer, static_cast<uint32_t>(stage), slot, buffer.id, firstConstant, numConstants);
+}
+
+//---------------------------------------------------------------------------------------
+void NullRenderContext::setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture)
+{
+	record(RenderCall::SetTexture, static_cast<uint32_t>(stage), slot, texture.id);
+}
+
+//-----------------------------------------------------------------------------------------------
+void NullRenderContext::setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer)
+{
+	record(RenderCall::SetStructuredBuffer, static_cast<uint32_t>(stage), slot, buffer.id);
+}
+
+//---------------------------------------------------------------------------------------
+void NullRenderContext::setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler)
+{
+	record(RenderCall::SetSampler, static_cast<uint32_t>(stage), slot, sampler.id);
+}
+
+//-----------------------------------------------------------------------
+void NullRenderContext::setRasterizerState(RasterizerStateHandle state)
+{
+	record(RenderCall::SetRasterizerState, state.id);
+}
+
+//------------------------------------------------------------------------------------------
+void NullRenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	record(RenderCall::DrawIndexed, indexCount, startIndex, static_cast<uint32_t>(baseVertex));
+	frameStats.indicesDrawn += indexCount;
+	frameStats.instancesDrawn++;
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------------
+void NullRenderContext::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+	record(RenderCall::DrawIndexedInstanced, indexCountPerInstance, instanceCount, startIndex, static_cast<uint32_t>(baseVertex), startInstance);
+	frameStats.indicesDrawn += uint64_t{ indexCountPerInstance } * instanceCount;
+	frameStats.instancesDrawn += instanceCount;
+}
+
+//-------------------------------------------------------------------------
+void NullRenderContext::executeCommandList(ICommandList& commandList)
+{
+	record(RenderCall::ExecuteCommandList);
+	static_cast<NullCommandList&>(commandList).replay(*this);
+}
+
+//---------------------------------------------------------------------------------------
+BufferHandle NullRenderDevice::createBuffer(const BufferDesc& desc, const void* initialData)
+{
+	BufferData data{ desc, std::vector<uint8_t>(desc.sizeInBytes, 0) };
+	if (initialData != nullptr)
+	{
+		memcpy(data.bytes.data(), initialData, desc.sizeInBytes);
+		createdBytes += desc.sizeInBytes;
+	}
+	return buffers.add(std::move(data));
+}
+
+//-------------------------------------------------------------------------------------------------------
+TextureHandle NullRenderDevice::createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch)
+{
+	const size_t packedPitch = size_t{ desc.width } * 4;
+	TextureData data{ desc, std::vector<uint8_t>(packedPitch * desc.height, 0) };
+	if (pixels != nullptr)
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(pixels);
+		for (uint32_t y{ 0 }; y < desc.height; y++)
+		{
+			memcpy(data.pixels.data() + packedPitch * y, src + size_t{ rowPitch } * y, packedPitch);
+		}
+		createdBytes += data.pixels.size();
+	}
+	return textures.add(std::move(data));
+}
+
+//---------------------------------------------------------------------------------------------
+VertexShaderHandle NullRenderDevice::createVertexShader(const void* /*bytecode*/, size_t size)
+{
+	return vertexShaders.add(static_cast<uint32_t>(size));
+}
+
+//-------------------------------------------------------------------------------------------
+PixelShaderHandle NullRenderDevice::createPixelShader(const void* /*bytecode*/, size_t size)
+{
+	return pixelShaders.add(static_cast<uint32_t>(size));
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------------
+InputLayoutHandle NullRenderDevice::createInputLayout(const InputElement elements[], uint32_t count, const void* /*vsBytecode*/, size_t /*size*/)
+{
+	return inputLayouts.add(std::vector<InputElement>(elements, elements + count));
+}
+
+//-----------------------------------------------------------------------------
+std::unique_ptr<IDeferredContext> NullRenderDevice::createDeferredContext()
+{
+	return std::make_unique<NullDeferredContext>(*this);
+}
+
+//-----------------------------------------------------------
+void NullRenderDevice::resize(uint32_t width, uint32_t height)
+{
+	backBufferWidth = width;
+	backBufferHeight = height;
+	activeContext->setViewport({ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f });
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include "RenderDevice.h"
+#include <array>
+
+//Every IRenderContext entry point, used to index call counters
+enum class RenderCall : uint8_t
+{
+	UpdateBuffer, MapBuffer, UnmapBuffer,
+	Clear, SetViewport, SetBlendState,
+	SetVertexBuffers, SetIndexBuffer, SetInputLayout, SetPrimitiveTopology,
+	SetVertexShader, SetPixelShader, SetConstantBuffer, SetTexture, SetStructuredBuffer, SetSampler,
+	SetRasterizerState,
+	DrawIndexed, DrawIndexedInstanced,
+	ExecuteCommandList,
+	Count
+};
+
+const char* renderCallName(RenderCall call);
+
+//Counters since the last resetStats
+struct RenderStats
+{
+	std::array<uint64_t, static_cast<size_t>(RenderCall::Count)> calls{};
+	uint64_t bytesUploaded{ 0 };	//initial data, updateBuffer and DISCARD mapped buffers (whole buffer per unmap)
+	uint64_t indicesDrawn{ 0 };
+	uint64_t instancesDrawn{ 0 };
+
+	uint64_t count(RenderCall call) const { return calls[static_cast<size_t>(call)]; }
+	uint64_t totalCalls() const;
+	uint64_t drawCalls() const { return count(RenderCall::DrawIndexed) + count(RenderCall::DrawIndexedInstanced); }
+};
+
+//One recorded context call; arguments are handle ids and counts in call order
+struct RecordedCall
+{
+	RenderCall call;
+	uint32_t args[5];
+};
+
+class NullRenderDevice;
+
+//Context that executes nothing. Calls are counted and, when recording is
+//enabled, appended to a command list that tests can inspect
+class NullRenderContext : public IRenderContext
+{
+public:
+
+	explicit NullRenderContext(NullRenderDevice& device) : device{ device } {}
+
+	void updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size) override;
+	void* mapBuffer(BufferHandle buffer, MapMode mode) override;
+	void unmapBuffer(BufferHandle buffer) override;
+
+	void clear(const float color[4], float depth, uint8_t stencil) override;
+	void setViewport(const Viewport& viewport) override;
+	void setBlendState(BlendStateHandle state) override;
+
+	void setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[]) override;
+	void setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) override;
+	void setInputLayout(InputLayoutHandle layout) override;
+	void setPrimitiveTopology(PrimitiveTopology topology) override;
+
+	void setVertexShader(VertexShaderHandle shader) override;
+	void setPixelShader(PixelShaderHandle shader) override;
+	void setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+	void setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture) override;
+	void setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer) override;
+	void setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler) override;
+
+	void setRasterizerState(RasterizerStateHandle state) override;
+
+	void drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+	//Replays the list's calls onto this context, so they are counted as if made here
+	void executeCommandList(ICommandList& commandList) override;
+
+	const RenderStats& stats() const { return frameStats; }
+	void resetStats() { frameStats = RenderStats{}; }
+
+	void setRecording(bool enable) { recording = enable; }
+	const std::vector<RecordedCall>& recordedCalls() const { return calls; }
+	void clearRecordedCalls() { calls.clear(); }
+
+private:
+
+	void record(RenderCall call, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint32_t a3 = 0, uint32_t a4 = 0);
+
+	NullRenderDevice& device;
+	RenderStats frameStats;
+	MapMode mapMode{ MapMode::WriteDiscard };
+	bool recording{ false };
+	std::vector<RecordedCall> calls;
+};
+
+//Device without a GPU for headless runs and CPU submission benchmarks
+//Buffer and texture contents are kept in system memory so mapped writes land
+//somewhere and can be inspected; shaders and states only store their descriptions
+class NullRenderDevice : public IRenderDevice
+{
+public:
+
+	struct BufferData
+	{
+		BufferDesc desc;
+		std::vector<uint8_t> bytes;
+	};
+
+	struct TextureData
+	{
+		TextureDesc desc;
+		std::vector<uint8_t> pixels;	//tightly packed rows
+	};
+
+	NullRenderDevice() : context{ *this }, activeContext{ &context } {}
+
+	BufferHandle createBuffer(const BufferDesc& desc, const void* initialData) override;
+	TextureHandle createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch) override;
+	VertexShaderHandle createVertexShader(const void* bytecode, size_t size) override;
+	PixelShaderHandle createPixelShader(const void* bytecode, size_t size) override;
+	InputLayoutHandle createInputLayout(const InputElement elements[], uint32_t count, const void* vsBytecode, size_t size) override;
+	SamplerHandle createSampler(const SamplerDesc& desc) override { return samplers.add(desc); }
+	RasterizerStateHandle createRasterizerState(const RasterizerDesc& desc) override { return rasterizerStates.add(desc); }
+	BlendStateHandle createBlendState(const BlendDesc& desc) override { return blendStates.add(desc); }
+
+	void destroyBuffer(BufferHandle buffer) override { buffers.remove(buffer); }
+	void destroyTexture(TextureHandle texture) override { textures.remove(texture); }
+
+	void resize(uint32_t width, uint32_t height) override;
+	void present(uint32_t /*syncInterval*/) override { frames++; }
+	uint64_t presentedFrames() const override { return frames; }
+	uint64_t completedFrames() override { return frames; }	//no GPU, work is done when it is submitted
+
+	IRenderContext& immediateContext() override { return *activeContext; }
+	std::unique_ptr<IDeferredContext> createDeferredContext() override;
+	NullRenderContext& nullContext() { return *activeContext; }
+
+	BufferData& buffer(BufferHandle handle) { return buffers.get(handle); }
+	const TextureData& texture(TextureHandle handle) const { return textures.get(handle); }
+	const std::vector<InputElement>& inputLayout(InputLayoutHandle handle) const { return inputLayouts.get(handle); }
+	const SamplerDesc& sampler(SamplerHandle handle) const { return samplers.get(handle); }
+	const RasterizerDesc& rasterizerState(RasterizerStateHandle handle) const { return rasterizerStates.get(handle); }
+	const BlendDesc& blendState(BlendStateHandle handle) const { return blendStates.get(handle); }
+
+	uint32_t width() const { return backBufferWidth; }
+	uint32_t height() const { return backBufferHeight; }
+
+	//Initial data of buffers and textures created since the last reset
+	uint64_t bytesCreated() const { return createdBytes; }
+	void resetBytesCreated() { createdBytes = 0; }
+
+	size_t liveBufferCount() const { return buffers.size(); }
+	size_t liveTextureCount() const { return textures.size(); }
+
+protected:
+
+	//Backends built on this device replace the context with one derived from NullRenderContext
+	void setContext(NullRenderContext& replacement) { activeContext = &replacement; }
+
+private:
+
+	NullRenderContext context;
+	NullRenderContext* activeContext;
+
+	HandleTable<BufferData, BufferHandle> buffers;
+	HandleTable<TextureData, TextureHandle> textures;
+	HandleTable<uint32_t, VertexShaderHandle> vertexShaders;
+	HandleTable<uint32_t, PixelShaderHandle> pixelShaders;
+	HandleTable<std::vector<InputElement>, InputLayoutHandle> inputLayouts;
+	HandleTable<SamplerDesc, SamplerHandle> samplers;
+	HandleTable<RasterizerDesc, RasterizerStateHandle> rasterizerStates;
+	HandleTable<BlendDesc, BlendStateHandle> blendStates;
+
+	uint32_t backBufferWidth{ 0 };
+	uint32_t backBufferHeight{ 0 };
+	uint64_t frames{ 0 };
+	uint64_t createdBytes{ 0 };
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include "RadixSort.h"
+#include <algorithm>
+
+//Single opaque draw : 64 bit sort key plus an index into the caller's draw list
+struct OpaqueDraw
+{
+	uint64_t key;
+	uint32_t drawIndex;
+};
+
+//Sort key layout, most significant bits first. Draws are grouped by pass, then shader,
+//then material / texture so state changes happen as rarely as possible, and go front
+//to back inside a group so the depth test rejects hidden pixels early
+struct OpaqueSortKey
+{
+	static constexpr uint32_t passBits{ 4 };
+	static constexpr uint32_t shaderBits{ 12 };
+	static constexpr uint32_t materialBits{ 24 };
+	static constexpr uint32_t depthBits{ 24 };
+
+	static constexpr uint32_t depthShift{ 0 };
+	static constexpr uint32_t materialShift{ depthShift + depthBits };
+	static constexpr uint32_t shaderShift{ materialShift + materialBits };
+	static constexpr uint32_t passShift{ shaderShift + shaderBits };
+
+	static_assert(passShift + passBits == 64, "key fields must fill 64 bits");
+
+	//Ids are truncated to their field width; depth is view space z quantized over [0, maxDepth]
+	//--------------------------------------------------------------------------------------------------
+	static uint64_t make(uint32_t pass, uint32_t shader, uint32_t material, float viewDepth, float maxDepth)
+	{
+		const uint32_t maxQuantized{ (1u << depthBits) - 1 };
+		float normalized = std::min(std::max(viewDepth / maxDepth, 0.0f), 1.0f);
+		uint64_t depth = static_cast<uint32_t>(normalized * maxQuantized);
+
+		return (uint64_t{ pass & ((1u << passBits) - 1) } << passShift) |
+			(uint64_t{ shader & ((1u << shaderBits) - 1) } << shaderShift) |
+			(uint64_t{ material & ((1u << materialBits) - 1) } << materialShift) |
+			(depth << depthShift);
+	}
+
+	static uint32_t pass(uint64_t key) { return static_cast<uint32_t>(key >> passShift) & ((1u << passBits) - 1); }
+	static uint32_t shader(uint64_t key) { return static_cast<uint32_t>(key >> shaderShift) & ((1u << shaderBits) - 1); }
+	static uint32_t material(uint64_t key) { return static_cast<uint32_t>(key >> materialShift) & ((1u << materialBits) - 1); }
+};
+
+//Opaque draws in state then front to back order
+//Draws with equal keys stay in submission order. Like TransparentQueue the storage is
+//reused every frame, so once the queue has seen its largest frame push and sort do not allocate
+class OpaqueQueue
+{
+public:
+
+	OpaqueQueue() = default;
+	explicit OpaqueQueue(size_t capacity) { reserve(capacity); }
+
+	//----------------------------------------
+	void reserve(size_t capacity)
+	{
+		draws.reserve(capacity);
+		scratch.reserve(capacity);
+		histograms.reserve(radixHistogramSize(capacity, true));
+	}
+
+	//----------------
+	void clear()
+	{
+		draws.clear();
+	}
+
+	//Depth keys cover view space z in [0, maxDepth], normally the far plane
+	//-----------------------------------------
+	void setMaxDepth(float depth)
+	{
+		maxDepth = depth;
+	}
+
+	//------------------------------------------------------------------------------------------------
+	void push(uint32_t pass, uint32_t shader, uint32_t material, float viewDepth, uint32_t drawIndex)
+	{
+		draws.push_back({ OpaqueSortKey::make(pass, shader, material, viewDepth, maxDepth), drawIndex });
+	}
+
+	//Key building for large draw lists: resizes the queue to count draws and has
+	//makeDraw(i) return the OpaqueDraw for draw i, split across worker threads
+	//--------------------------------------------------------
+	template <typename BuildFunc>
+	void build(size_t count, BuildFunc&& makeDraw)
+	{
+		const size_t minDrawsPerChunk{ 16384 };
+		draws.resize(count);
+		parallelFor(count, minDrawsPerChunk, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i{ begin }; i < end; i++)
+			{
+				draws[i] = makeDraw(i);
+			}
+		});
+	}
+
+	//parallel splits each radix pass across worker threads; worth it from ~100k draws
+	//-----------------------------------
+	void sort(bool parallel = false)
+	{
+		radixSort(draws, scratch, histograms, parallel);
+	}
+
+	const OpaqueDraw* begin() const { return draws.data(); }
+	const OpaqueDraw* end() const { return draws.data() + draws.size(); }
+	size_t size() const { return draws.size(); }
+	const OpaqueDraw& operator[](size_t i) const { return draws[i]; }
+
+private:
+
+	std::vector<OpaqueDraw> draws;
+	std::vector<OpaqueDraw> scratch;
+	std::vector<uint32_t> histograms;
+	float maxDepth{ 1000.0f };
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//Worker count the parallel helpers plan for: the hardware threads unless
+//setParallelWorkerCount overrode it (0 goes back to the hardware threads)
+//-------------------------------------
+inline std::atomic<unsigned int>& parallelWorkerOverride()
+{
+	static std::atomic<unsigned int> count{ 0 };
+	return count;
+}
+
+//Lets tests run the multi chunk paths on machines with few cores
+//-------------------------------------
+inline void setParallelWorkerCount(unsigned int count)
+{
+	parallelWorkerOverride().store(count, std::memory_order_relaxed);
+}
+
+//Number of hardware threads available to the parallel helpers (never 0)
+//-------------------------------------
+inline unsigned int workerThreadCount()
+{
+	unsigned int count = parallelWorkerOverride().load(std::memory_order_relaxed);
+	if (count == 0)
+	{
+		count = std::thread::hardware_concurrency();
+	}
+	return count == 0 ? 1 : count;
+}
+
+//Persistent workers behind parallelFor, the calling thread is the last worker
+//-------------------------------------
+inline ThreadPool& parallelPool()
+{
+	static ThreadPool pool{ std::max(workerThreadCount(), 2u) - 1 };
+	return pool;
+}
+
+//Number of chunks parallelFor will split count items into
+//Callers use this to size per chunk scratch data before calling parallelFor
+//-----------------------------------------------------------------------------
+inline size_t parallelChunkCount(size_t count, size_t minChunkSize)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	minChunkSize = std::max<size_t>(minChunkSize, 1);
+	size_t maxChunks = (count + minChunkSize - 1) / minChunkSize;
+	return std::max<size_t>(1, std::min<size_t>(workerThreadCount(), maxChunks));
+}
+
+//Splits [0, count) into parallelChunkCount(count, minChunkSize) contiguous ranges
+//and calls func(chunkIndex, begin, end) for each of them on parallelPool().
+//Chunks are claimed from a shared counter by the pool jobs and by the calling thread,
+//which returns once all chunks are done. As the caller never waits for a chunk nobody
+//has started, parallelFor can be nested inside a chunk without starving the pool.
+//Trailing chunks that would be empty are never called
+//-----------------------------------------------------------------------------
+template <typename Func>
+void parallelFor(size_t count, size_t minChunkSize, Func&& func)
+{
+	size_t numChunks = parallelChunkCount(count, minChunkSize);
+	if (numChunks == 0)
+	{
+		return;
+	}
+	size_t chunkSize = (count + numChunks - 1) / numChunks;
+	numChunks = (count + chunkSize - 1) / chunkSize;
+	if (numChunks == 1)
+	{
+		func(size_t{ 0 }, size_t{ 0 }, count);
+		return;
+	}
+
+	//Shared with the pool jobs, which may start after the call has returned and then find nothing left
+	struct WaitGroup
+	{
+		std::atomic<size_t> nextChunk{ 0 };
+		size_t chunksDone{ 0 };
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	auto group = std::make_shared<WaitGroup>();
+
+	auto runChunks = [group, &func, numChunks, chunkSize, count]()
+	{
+		size_t finished{ 0 };
+		for (size_t chunk = group->nextChunk++; chunk < numChunks; chunk = group->nextChunk++)
+		{
+			size_t begin = chunk * chunkSize;
+			func(chunk, begin, std::min<size_t>(count, begin + chunkSize));
+			finished++;
+		}
+		if (finished != 0)
+		{
+			std::lock_guard<std::mutex> lock{ group->mutex };
+			group->chunksDone += finished;
+			if (group->chunksDone == numChunks)
+			{
+				group->done.notify_one();
+			}
+		}
+	};
+
+	ThreadPool& pool = parallelPool();
+	for (size_t job = 1; job < numChunks; job++)
+	{
+		pool.submit(runChunks);
+	}
+	runChunks();
+
+	std::unique_lock<std::mutex> lock{ group->mutex };
+	group->done.wait(lock, [&]() { return group->chunksDone == numChunks; });
+}
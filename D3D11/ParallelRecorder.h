@@ -0,0 +1,137 @@
+#pragma once
+#include "RenderDevice.h"
+#include "StateCache.h"
+#include "ThreadPool.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include <algorithm>
+
+//Timings of the last ParallelRecorder::record, nanoseconds
+struct ParallelRecordStats
+{
+	size_t chunks{ 0 };
+	int64_t recordNanoseconds{ 0 };		//from the first chunk starting to the last one finishing
+	int64_t chunkNanoseconds{ 0 };		//summed over chunks, the single threaded cost of recording
+	int64_t longestChunkNanoseconds{ 0 };
+	int64_t executeNanoseconds{ 0 };	//executing the lists on the immediate context
+};
+
+//Records a draw list on several threads and submits it in order
+//[0, count) is split into at most threadCount() contiguous chunks; each chunk is recorded
+//into a deferred context of its own, the first one on the calling thread, and the finished
+//command lists are executed on the immediate context in chunk order, so the GPU sees the
+//draws exactly as a single threaded loop would have issued them.
+//Each chunk records through a StateCache of its own, so draws sharing state within a chunk
+//only bind what changes. Deferred contexts are created on first use and reused every
+//frame. Command lists are released once executed so nothing keeps the back buffer alive
+//across a resize
+class ParallelRecorder
+{
+public:
+
+	explicit ParallelRecorder(IRenderDevice& device, unsigned int numThreads = workerThreadCount()) :
+		device{ device }, pool{ std::max(numThreads, 2u) - 1 }, threads{ std::max(numThreads, 1u) }
+	{}
+
+	//record(context, begin, end) is called once per chunk with a context that starts from
+	//default state, so it must bind everything its draws use. The immediate context is
+	//back at default state afterwards as well. Chunks run concurrently: record may read
+	//shared data but must not map buffers that other chunks or the immediate context write
+	//---------------------------------------------------------------------------------------------
+	template <typename RecordFunc>
+	void record(IRenderContext& immediate, size_t count, size_t minChunkSize, RecordFunc&& record)
+	{
+		size_t numChunks = chunkCount(count, minChunkSize);
+		recordStats = ParallelRecordStats{};
+		recordStats.chunks = numChunks;
+		if (numChunks == 0)
+		{
+			return;
+		}
+
+		while (recorders.size() < numChunks)
+		{
+			std::unique_ptr<IDeferredContext> deferred = device.createDeferredContext();
+			std::unique_ptr<StateCache> cache = std::make_unique<StateCache>(deferred->context());
+			recorders.push_back({ std::move(deferred), std::move(cache) });
+		}
+		lists.resize(numChunks);
+		chunkTimes.resize(numChunks);
+
+		size_t chunkSize = (count + numChunks - 1) / numChunks;
+		auto recordChunk = [&, chunkSize](size_t chunk)
+		{
+			int64_t start = profilerNow();
+			size_t begin = chunk * chunkSize;
+			size_t end = std::min<size_t>(count, begin + chunkSize);
+			ChunkRecorder& recorder = recorders[chunk];
+			//context() starts the recording, the cache forwards to the same context
+			recorder.deferred->context();
+			recorder.cache->invalidate();
+			record(*recorder.cache, begin, end);
+			lists[chunk] = recorder.deferred->finish();
+			chunkTimes[chunk] = profilerNow() - start;
+		};
+
+		int64_t start = profilerNow();
+		std::vector<std::future<void>> pending;
+		pending.reserve(numChunks - 1);
+		for (size_t chunk{ 1 }; chunk < numChunks; chunk++)
+		{
+			pending.push_back(pool.submitTask([&recordChunk, chunk]() { recordChunk(chunk); }));
+		}
+		recordChunk(0);
+		for (std::future<void>& chunk : pending)
+		{
+			chunk.get();
+		}
+		int64_t recorded = profilerNow();
+
+		for (std::unique_ptr<ICommandList>& list : lists)
+		{
+			immediate.executeCommandList(*list);
+			list.reset();
+		}
+
+		recordStats.recordNanoseconds = recorded - start;
+		recordStats.executeNanoseconds = profilerNow() - recorded;
+		for (int64_t time : chunkTimes)
+		{
+			recordStats.chunkNanoseconds += time;
+			recordStats.longestChunkNanoseconds = std::max(recordStats.longestChunkNanoseconds, time);
+		}
+	}
+
+	//Number of chunks record splits count draws into; every chunk gets at least one draw
+	//----------------------------------------------------------------
+	size_t chunkCount(size_t count, size_t minChunkSize) const
+	{
+		if (count == 0)
+		{
+			return 0;
+		}
+		minChunkSize = std::max<size_t>(minChunkSize, 1);
+		size_t numChunks = std::min<size_t>(threads, (count + minChunkSize - 1) / minChunkSize);
+		size_t chunkSize = (count + numChunks - 1) / numChunks;
+		return (count + chunkSize - 1) / chunkSize;
+	}
+
+	unsigned int threadCount() const { return threads; }
+	const ParallelRecordStats& stats() const { return recordStats; }
+
+private:
+
+	struct ChunkRecorder
+	{
+		std::unique_ptr<IDeferredContext> deferred;
+		std::unique_ptr<StateCache> cache;
+	};
+
+	IRenderDevice& device;
+	ThreadPool pool;
+	unsigned int threads;
+	std::vector<ChunkRecorder> recorders;
+	std::vector<std::unique_ptr<ICommandList>> lists;
+	std::vector<int64_t> chunkTimes;
+	ParallelRecordStats recordStats;
+};
@@ -0,0 +1,404 @@
+#pragma once
+//Subset of DirectXMath for the portable build (CMake on Linux / macOS)
+//Only what the portable sources use, with the same types, names, row vector convention
+//and results as DirectXMath, on SSE2 (_XM_SSE_INTRINSICS_) like the Windows build.
+//XMVECTOR arithmetic operators come from the GCC / Clang vector extensions.
+//The Windows build uses the real header from the SDK, this directory is not on its include path
+#include <cmath>
+#include <cstdint>
+#include <emmintrin.h>
+#include <xmmintrin.h>
+
+#define _XM_SSE_INTRINSICS_ 1
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	constexpr float XM_PI{ 3.141592654f };
+	constexpr float XM_2PI{ 6.283185307f };
+	constexpr float XM_PIDIV2{ 1.570796327f };
+	constexpr float XM_PIDIV4{ 0.785398163f };
+
+	inline constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	inline constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	using XMVECTOR = __m128;
+	using FXMVECTOR = const XMVECTOR;
+	using GXMVECTOR = const XMVECTOR;
+	using HXMVECTOR = const XMVECTOR&;
+	using CXMVECTOR = const XMVECTOR&;
+
+	struct XMFLOAT2
+	{
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float x, float y) : x{ x }, y{ y } {}
+		explicit XMFLOAT2(const float* array) : x{ array[0] }, y{ array[1] } {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) : x{ x }, y{ y }, z{ z } {}
+		explicit XMFLOAT3(const float* array) : x{ array[0] }, y{ array[1] }, z{ array[2] } {}
+	};
+
+	struct alignas(16) XMFLOAT3A : public XMFLOAT3
+	{
+		using XMFLOAT3::XMFLOAT3;
+		XMFLOAT3A() = default;
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) : x{ x }, y{ y }, z{ z }, w{ w } {}
+		explicit XMFLOAT4(const float* array) : x{ array[0] }, y{ array[1] }, z{ array[2] }, w{ array[3] } {}
+	};
+
+	struct alignas(16) XMFLOAT4A : public XMFLOAT4
+	{
+		using XMFLOAT4::XMFLOAT4;
+		XMFLOAT4A() = default;
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33) :
+			_11{ m00 }, _12{ m01 }, _13{ m02 }, _14{ m03 },
+			_21{ m10 }, _22{ m11 }, _23{ m12 }, _24{ m13 },
+			_31{ m20 }, _32{ m21 }, _33{ m22 }, _34{ m23 },
+			_41{ m30 }, _42{ m31 }, _43{ m32 }, _44{ m33 } {}
+
+		float operator()(size_t row, size_t column) const { return m[row][column]; }
+		float& operator()(size_t row, size_t column) { return m[row][column]; }
+	};
+
+	struct alignas(16) XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2, CXMVECTOR r3) : r{ r0, r1, r2, r3 } {}
+	};
+
+	using FXMMATRIX = const XMMATRIX&;
+	using CXMMATRIX = const XMMATRIX&;
+
+	//------------------------------------------------------------------------------------------
+	//Load / store
+
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* source) { return _mm_setr_ps(source->x, source->y, 0.0f, 0.0f); }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return _mm_setr_ps(source->x, source->y, source->z, 0.0f); }
+	inline XMVECTOR XMLoadFloat3A(const XMFLOAT3A* source) { return _mm_and_ps(_mm_load_ps(&source->x), _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return _mm_loadu_ps(&source->x); }
+	inline XMVECTOR XMLoadFloat4A(const XMFLOAT4A* source) { return _mm_load_ps(&source->x); }
+
+	inline void XMStoreFloat2(XMFLOAT2* destination, FXMVECTOR v)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(&destination->x), v);
+	}
+
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v)
+	{
+		alignas(16) float values[4];
+		_mm_store_ps(values, v);
+		destination->x = values[0];
+		destination->y = values[1];
+		destination->z = values[2];
+	}
+
+	inline void XMStoreFloat3A(XMFLOAT3A* destination, FXMVECTOR v) { XMStoreFloat3(destination, v); }
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) { _mm_storeu_ps(&destination->x, v); }
+	inline void XMStoreFloat4A(XMFLOAT4A* destination, FXMVECTOR v) { _mm_store_ps(&destination->x, v); }
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		return XMMATRIX{ _mm_loadu_ps(&source->_11), _mm_loadu_ps(&source->_21), _mm_loadu_ps(&source->_31), _mm_loadu_ps(&source->_41) };
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m)
+	{
+		_mm_storeu_ps(&destination->_11, m.r[0]);
+		_mm_storeu_ps(&destination->_21, m.r[1]);
+		_mm_storeu_ps(&destination->_31, m.r[2]);
+		_mm_storeu_ps(&destination->_41, m.r[3]);
+	}
+
+	//------------------------------------------------------------------------------------------
+	//Vector
+
+	inline XMVECTOR XMVectorZero() { return _mm_setzero_ps(); }
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+	inline XMVECTOR XMVectorReplicate(float value) { return _mm_set1_ps(value); }
+
+	inline float XMVectorGetX(FXMVECTOR v) { return _mm_cvtss_f32(v); }
+	inline float XMVectorGetY(FXMVECTOR v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))); }
+	inline float XMVectorGetZ(FXMVECTOR v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))); }
+	inline float XMVectorGetW(FXMVECTOR v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+
+	inline XMVECTOR XMVectorSetW(FXMVECTOR v, float w)
+	{
+		alignas(16) float values[4];
+		_mm_store_ps(values, v);
+		values[3] = w;
+		return _mm_load_ps(values);
+	}
+
+	inline XMVECTOR XMVectorSplatX(FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+	inline XMVECTOR XMVectorSplatY(FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)); }
+	inline XMVECTOR XMVectorSplatZ(FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)); }
+	inline XMVECTOR XMVectorSplatW(FXMVECTOR v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return _mm_add_ps(a, b); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return _mm_sub_ps(a, b); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return _mm_mul_ps(a, b); }
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return _mm_div_ps(a, b); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) { return _mm_mul_ps(v, _mm_set1_ps(scale)); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) { return _mm_sub_ps(_mm_setzero_ps(), v); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return _mm_min_ps(a, b); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return _mm_max_ps(a, b); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v) { return _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), v), v); }
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR v) { return _mm_sqrt_ps(v); }
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR v) { return _mm_div_ps(_mm_set1_ps(1.0f), v); }
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+	inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control) { return _mm_or_ps(_mm_andnot_ps(control, a), _mm_and_ps(b, control)); }
+	inline XMVECTOR XMVectorGreater(FXMVECTOR a, FXMVECTOR b) { return _mm_cmpgt_ps(a, b); }
+	inline XMVECTOR XMVectorLess(FXMVECTOR a, FXMVECTOR b) { return _mm_cmplt_ps(a, b); }
+
+	//Dot products are replicated to all four components
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR product = _mm_mul_ps(a, b);
+		XMVECTOR y = _mm_shuffle_ps(product, product, _MM_SHUFFLE(1, 1, 1, 1));
+		XMVECTOR z = _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 2, 2, 2));
+		XMVECTOR sum = _mm_add_ss(_mm_add_ss(product, y), z);
+		return _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(0, 0, 0, 0));
+	}
+
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR product = _mm_mul_ps(a, b);
+		XMVECTOR swapped = _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1));
+		XMVECTOR pairs = _mm_add_ps(product, swapped);
+		return _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		XMVECTOR bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+		XMVECTOR aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+		XMVECTOR bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		XMVECTOR cross = _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX));
+		//w = 0 like DirectXMath
+		return _mm_and_ps(cross, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+	}
+
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return _mm_sqrt_ps(XMVector3Dot(v, v)); }
+	inline XMVECTOR XMVector4Length(FXMVECTOR v) { return _mm_sqrt_ps(XMVector4Dot(v, v)); }
+
+	//Zero length gives zero, like DirectXMath
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		XMVECTOR length = XMVector3Length(v);
+		return _mm_and_ps(_mm_div_ps(v, length), _mm_cmpneq_ps(length, _mm_setzero_ps()));
+	}
+
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v)
+	{
+		XMVECTOR length = XMVector4Length(v);
+		return _mm_and_ps(_mm_div_ps(v, length), _mm_cmpneq_ps(length, _mm_setzero_ps()));
+	}
+
+	//Scales the whole plane so its normal (xyz) has unit length
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR plane)
+	{
+		XMVECTOR length = XMVector3Length(plane);
+		return _mm_and_ps(_mm_div_ps(plane, length), _mm_cmpneq_ps(length, _mm_setzero_ps()));
+	}
+
+	inline XMVECTOR XMPlaneDotCoord(FXMVECTOR plane, FXMVECTOR point)
+	{
+		return XMVector4Dot(plane, _mm_or_ps(_mm_and_ps(point, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f)));
+	}
+
+	//------------------------------------------------------------------------------------------
+	//Transforms, v is a row vector: v * m
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = _mm_mul_ps(XMVectorSplatX(v), m.r[0]);
+		result = _mm_add_ps(result, _mm_mul_ps(XMVectorSplatY(v), m.r[1]));
+		result = _mm_add_ps(result, _mm_mul_ps(XMVectorSplatZ(v), m.r[2]));
+		return _mm_add_ps(result, _mm_mul_ps(XMVectorSplatW(v), m.r[3]));
+	}
+
+	//w = 1
+	inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = _mm_mul_ps(XMVectorSplatX(v), m.r[0]);
+		result = _mm_add_ps(result, _mm_mul_ps(XMVectorSplatY(v), m.r[1]));
+		result = _mm_add_ps(result, _mm_mul_ps(XMVectorSplatZ(v), m.r[2]));
+		return _mm_add_ps(result, m.r[3]);
+	}
+
+	//w = 1, then divided by the resulting w
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVector3Transform(v, m);
+		return _mm_div_ps(result, XMVectorSplatW(result));
+	}
+
+	//w = 0
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = _mm_mul_ps(XMVectorSplatX(v), m.r[0]);
+		result = _mm_add_ps(result, _mm_mul_ps(XMVectorSplatY(v), m.r[1]));
+		return _mm_add_ps(result, _mm_mul_ps(XMVectorSplatZ(v), m.r[2]));
+	}
+
+	//------------------------------------------------------------------------------------------
+	//Matrix
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		return XMMATRIX{ _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f), _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f),
+			_mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f) };
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		return XMMATRIX{ XMVector4Transform(a.r[0], b), XMVector4Transform(a.r[1], b), XMVector4Transform(a.r[2], b), XMVector4Transform(a.r[3], b) };
+	}
+
+	inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a, b); }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		XMMATRIX result = m;
+		_MM_TRANSPOSE4_PS(result.r[0], result.r[1], result.r[2], result.r[3]);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z)
+	{
+		XMMATRIX result = XMMatrixIdentity();
+		result.r[3] = _mm_setr_ps(x, y, z, 1.0f);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z)
+	{
+		return XMMATRIX{ _mm_setr_ps(x, 0.0f, 0.0f, 0.0f), _mm_setr_ps(0.0f, y, 0.0f, 0.0f),
+			_mm_setr_ps(0.0f, 0.0f, z, 0.0f), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f) };
+	}
+
+	//Unit quaternion (x, y, z, w) to a rotation for row vectors
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR quaternion)
+	{
+		alignas(16) float q[4];
+		_mm_store_ps(q, quaternion);
+		const float x{ q[0] }, y{ q[1] }, z{ q[2] }, w{ q[3] };
+		return XMMATRIX{
+			_mm_setr_ps(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f),
+			_mm_setr_ps(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f),
+			_mm_setr_ps(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f),
+			_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f) };
+	}
+
+	//Left handed perspective, depth maps [nearZ, farZ] to [0, 1]
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		const float height{ std::cos(0.5f * fovAngleY) / std::sin(0.5f * fovAngleY) };
+		const float width{ height / aspectRatio };
+		const float range{ farZ / (farZ - nearZ) };
+		return XMMATRIX{ _mm_setr_ps(width, 0.0f, 0.0f, 0.0f), _mm_setr_ps(0.0f, height, 0.0f, 0.0f),
+			_mm_setr_ps(0.0f, 0.0f, range, 1.0f), _mm_setr_ps(0.0f, 0.0f, -range * nearZ, 0.0f) };
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eyePosition, FXMVECTOR eyeDirection, FXMVECTOR upDirection)
+	{
+		XMVECTOR zAxis = XMVector3Normalize(eyeDirection);
+		XMVECTOR xAxis = XMVector3Normalize(XMVector3Cross(upDirection, zAxis));
+		XMVECTOR yAxis = XMVector3Cross(zAxis, xAxis);
+		XMVECTOR negativeEye = XMVectorNegate(eyePosition);
+		XMMATRIX view{ xAxis, yAxis, zAxis, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f) };
+		view = XMMatrixTranspose(view);
+		view.r[3] = _mm_setr_ps(XMVectorGetX(XMVector3Dot(xAxis, negativeEye)), XMVectorGetX(XMVector3Dot(yAxis, negativeEye)),
+			XMVectorGetX(XMVector3Dot(zAxis, negativeEye)), 1.0f);
+		return view;
+	}
+
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eyePosition, FXMVECTOR focusPosition, FXMVECTOR upDirection)
+	{
+		return XMMatrixLookToLH(eyePosition, _mm_sub_ps(focusPosition, eyePosition), upDirection);
+	}
+
+	//General inverse by cofactors, determinant is optional
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		alignas(16) float a[16];
+		_mm_store_ps(a + 0, m.r[0]);
+		_mm_store_ps(a + 4, m.r[1]);
+		_mm_store_ps(a + 8, m.r[2]);
+		_mm_store_ps(a + 12, m.r[3]);
+
+		alignas(16) float inverse[16];
+		inverse[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		inverse[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		inverse[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		inverse[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		inverse[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		inverse[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		inverse[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		inverse[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		inverse[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		inverse[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		inverse[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		inverse[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		inverse[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		inverse[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		inverse[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		inverse[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		const float det{ a[0] * inverse[0] + a[1] * inverse[4] + a[2] * inverse[8] + a[3] * inverse[12] };
+		if (determinant != nullptr)
+		{
+			*determinant = _mm_set1_ps(det);
+		}
+
+		const XMVECTOR scale = _mm_set1_ps(1.0f / det);
+		return XMMATRIX{ _mm_mul_ps(_mm_load_ps(inverse + 0), scale), _mm_mul_ps(_mm_load_ps(inverse + 4), scale),
+			_mm_mul_ps(_mm_load_ps(inverse + 8), scale), _mm_mul_ps(_mm_load_ps(inverse + 12), scale) };
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+//Subset of DirectXPackedVector for the portable build, see DirectXMath.h in this directory
+#include "DirectXMath.h"
+#include <cstring>
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		using HALF = uint16_t;
+
+		//Round to nearest even; overflow goes to infinity, tiny values to half denormals or zero
+		inline HALF XMConvertFloatToHalf(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			const uint32_t sign{ (bits >> 16) & 0x8000u };
+			const uint32_t magnitude{ bits & 0x7FFFFFFFu };
+
+			if (magnitude >= 0x7F800000u)
+			{
+				//Inf stays inf, NaN stays a quiet NaN
+				return static_cast<HALF>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+			}
+			if (magnitude >= 0x477FF000u)
+			{
+				//Rounds to above the largest half (65504)
+				return static_cast<HALF>(sign | 0x7C00u);
+			}
+			if (magnitude < 0x38800000u)
+			{
+				//Half denormal: shift the mantissa with its implicit one into place and round
+				if (magnitude < 0x33000000u)
+				{
+					return static_cast<HALF>(sign);
+				}
+				const uint32_t exponent{ magnitude >> 23 };
+				const uint32_t mantissa{ (magnitude & 0x7FFFFFu) | 0x800000u };
+				const uint32_t shift{ 126 - exponent };
+				uint32_t half{ mantissa >> shift };
+				const uint32_t remainder{ mantissa & ((1u << shift) - 1) };
+				const uint32_t halfway{ 1u << (shift - 1) };
+				if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+				{
+					half++;
+				}
+				return static_cast<HALF>(sign | half);
+			}
+
+			//Normal: rebias the exponent and round the mantissa, a carry moves into the exponent
+			uint32_t rebased{ magnitude - 0x38000000u };
+			uint32_t half{ rebased >> 13 };
+			const uint32_t remainder{ rebased & 0x1FFFu };
+			if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1) != 0))
+			{
+				half++;
+			}
+			return static_cast<HALF>(sign | half);
+		}
+
+		inline float XMConvertHalfToFloat(HALF value)
+		{
+			const uint32_t sign{ static_cast<uint32_t>(value & 0x8000u) << 16 };
+			uint32_t exponent{ (value >> 10) & 0x1Fu };
+			uint32_t mantissa{ value & 0x3FFu };
+
+			uint32_t bits;
+			if (exponent == 0x1F)
+			{
+				bits = sign | 0x7F800000u | (mantissa << 13);
+			}
+			else if (exponent != 0)
+			{
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+			else if (mantissa != 0)
+			{
+				//Denormal, normalize it
+				exponent = 113;
+				while ((mantissa & 0x400u) == 0)
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+			}
+			else
+			{
+				bits = sign;
+			}
+
+			float result;
+			memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
+
+		struct XMHALF2
+		{
+			HALF x;
+			HALF y;
+
+			XMHALF2() = default;
+			constexpr XMHALF2(HALF x, HALF y) : x{ x }, y{ y } {}
+		};
+
+		//Signed normalized, value / 32767
+		struct XMSHORTN2
+		{
+			int16_t x;
+			int16_t y;
+
+			XMSHORTN2() = default;
+			constexpr XMSHORTN2(int16_t x, int16_t y) : x{ x }, y{ y } {}
+		};
+
+		//Unsigned normalized, value / 65535
+		struct XMUSHORTN4
+		{
+			uint16_t x;
+			uint16_t y;
+			uint16_t z;
+			uint16_t w;
+
+			XMUSHORTN4() = default;
+			constexpr XMUSHORTN4(uint16_t x, uint16_t y, uint16_t z, uint16_t w) : x{ x }, y{ y }, z{ z }, w{ w } {}
+		};
+	}
+}
@@ -0,0 +1,243 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	std::atomic<uint64_t> nextProfilerId{ 1 };
+
+	//Last profiler this thread wrote to and its buffer. Ids are never reused so a
+	//buffer cached for a destroyed profiler is never picked up by a new one. A miss
+	//looks the thread's buffer up in the profiler, so alternating profilers adds none
+	struct ThreadEventsCache
+	{
+		uint64_t profilerId{ 0 };
+		void* events{ nullptr };
+	};
+	thread_local ThreadEventsCache threadCache;
+
+	//------------------------------------------------
+	size_t roundUpToPowerOfTwo(size_t value)
+	{
+		size_t result{ 1 };
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+	//Writes a JSON string literal, names are normally plain identifiers
+	//-----------------------------------------------------------
+	void writeJsonString(std::ostream& out, const char* text)
+	{
+		out << '"';
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				out << '\\' << *c;
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				out << ' ';
+			}
+			else
+			{
+				out << *c;
+			}
+		}
+		out << '"';
+	}
+}
+
+//-------------------------------------------------------------------
+FrameTimeRing::FrameTimeRing(size_t capacity) : mask{ roundUpToPowerOfTwo(std::max<size_t>(capacity, 1)) - 1 }
+{
+	slots.reset(new std::atomic<float>[mask + 1]);
+	for (size_t i{ 0 }; i <= mask; i++)
+	{
+		slots[i].store(0.0f, std::memory_order_relaxed);
+	}
+}
+
+//------------------------------------------
+void FrameTimeRing::push(float frameMs)
+{
+	uint64_t index = head.load(std::memory_order_relaxed);
+	slots[index & mask].store(frameMs, std::memory_order_relaxed);
+	head.store(index + 1, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------
+void FrameTimeRing::snapshot(std::vector<float>& samples) const
+{
+	uint64_t end = head.load(std::memory_order_acquire);
+	uint64_t count = std::min<uint64_t>(end, mask + 1);
+
+	samples.resize(static_cast<size_t>(count));
+	for (uint64_t i{ 0 }; i < count; i++)
+	{
+		samples[static_cast<size_t>(i)] = slots[(end - count + i) & mask].load(std::memory_order_relaxed);
+	}
+}
+
+//----------------------------------------------------------
+FrameStats computeFrameStats(std::vector<float>& samples)
+{
+	FrameStats stats;
+	stats.sampleCount = samples.size();
+	if (samples.empty())
+	{
+		return stats;
+	}
+
+	double sum{ 0.0 };
+	for (float sample : samples)
+	{
+		sum += sample;
+	}
+	stats.averageMs = sum / samples.size();
+
+	//Nearest rank. After each nth_element everything past the selected index is at least
+	//as large, so the next (higher) percentile only has to search that tail
+	size_t from{ 0 };
+	auto percentile = [&samples, &from](double p) -> double
+	{
+		size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+		size_t index = std::max(std::min(std::max<size_t>(rank, 1), samples.size()) - 1, from);
+		std::nth_element(samples.begin() + from, samples.begin() + index, samples.end());
+		from = index;
+		return samples[index];
+	};
+
+	stats.p50Ms = percentile(0.50);
+	stats.p95Ms = percentile(0.95);
+	stats.p99Ms = percentile(0.99);
+	stats.maxMs = *std::max_element(samples.begin() + from, samples.end());
+	return stats;
+}
+
+//------------------------------------------------------------------------------------
+Profiler::Profiler(size_t frameCapacity, size_t maxEventsPerThread) :
+	frameTimes{ frameCapacity }, maxEventsPerThread{ maxEventsPerThread }, profilerId{ nextProfilerId++ }
+{}
+
+//------------------------
+void Profiler::markFrame()
+{
+	int64_t now = profilerNow();
+	if (lastFrameMark != 0)
+	{
+		frameTimes.push(static_cast<float>((now - lastFrameMark) * 1e-6));
+		frames.fetch_add(1, std::memory_order_relaxed);
+	}
+	lastFrameMark = now;
+}
+
+//-----------------------------------------
+FrameStats Profiler::frameStats() const
+{
+	std::vector<float> samples;
+	frameTimes.snapshot(samples);
+	return computeFrameStats(samples);
+}
+
+//-----------------------------------------
+void Profiler::setEnabled(bool enable)
+{
+	if (enable && !isEnabled())
+	{
+		std::lock_guard<std::mutex> lock{ threadsMutex };
+		for (auto& thread : threads)
+		{
+			std::lock_guard<std::mutex> threadLock{ thread->mutex };
+			thread->events.clear();
+		}
+		dropped = 0;
+		captureStart = profilerNow();
+	}
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+//---------------------------------------------
+Profiler::ThreadEvents& Profiler::threadEvents()
+{
+	if (threadCache.profilerId != profilerId)
+	{
+		//A thread that exited may leave its id to a new one, which then shares its buffer
+		const std::thread::id owner = std::this_thread::get_id();
+		std::lock_guard<std::mutex> lock{ threadsMutex };
+		auto found = std::find_if(threads.begin(), threads.end(), [owner](const std::unique_ptr<ThreadEvents>& thread) { return thread->owner == owner; });
+		if (found == threads.end())
+		{
+			threads.emplace_back(new ThreadEvents);
+			threads.back()->owner = owner;
+			threads.back()->threadId = static_cast<uint32_t>(threads.size());
+			found = threads.end() - 1;
+		}
+		threadCache.profilerId = profilerId;
+		threadCache.events = found->get();
+	}
+	return *static_cast<ThreadEvents*>(threadCache.events);
+}
+
+//--------------------------------------------------------------------------
+void Profiler::recordScope(const char* name, int64_t start, int64_t end)
+{
+	ThreadEvents& thread = threadEvents();
+	std::lock_guard<std::mutex> lock{ thread.mutex };
+	if (thread.events.size() >= maxEventsPerThread)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	thread.events.push_back({ name, start, end });
+}
+
+//Complete ("X") events with microsecond timestamps relative to the capture start
+//----------------------------------------------------------
+void Profiler::writeChromeTrace(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock{ threadsMutex };
+
+	out << "{\"traceEvents\":[";
+	bool first{ true };
+	char number[64];
+	for (const auto& thread : threads)
+	{
+		std::lock_guard<std::mutex> threadLock{ thread->mutex };
+		for (const ScopeEvent& event : thread->events)
+		{
+			out << (first ? "\n" : ",\n") << "{\"name\":";
+			writeJsonString(out, event.name);
+			snprintf(number, sizeof(number), "%.3f", (event.start - captureStart) * 1e-3);
+			out << ",\"ph\":\"X\",\"ts\":" << number;
+			snprintf(number, sizeof(number), "%.3f", (event.end - event.start) * 1e-3);
+			out << ",\"dur\":" << number << ",\"pid\":1,\"tid\":" << thread->threadId << '}';
+			first = false;
+		}
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+//-----------------------------------------------------------------------
+bool Profiler::writeChromeTrace(const std::string& fileName) const
+{
+	std::ofstream file{ fileName, std::ios::out | std::ios::trunc };
+	if (!file)
+	{
+		return false;
+	}
+	writeChromeTrace(file);
+	return static_cast<bool>(file);
+}
+
+//----------------------------
+Profiler& globalProfiler()
+{
+	static Profiler profiler;
+	return profiler;
+}
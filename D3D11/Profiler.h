@@ -0,0 +1,153 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Portable monotonic clock used by all profiler timestamps, nanoseconds
+//----------------------------------
+inline int64_t profilerNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Frame time distribution over the samples currently held in the ring, milliseconds
+struct FrameStats
+{
+	size_t sampleCount{ 0 };
+	double averageMs{ 0.0 };
+	double p50Ms{ 0.0 };
+	double p95Ms{ 0.0 };
+	double p99Ms{ 0.0 };
+	double maxMs{ 0.0 };
+};
+
+//Fixed size ring of the most recent frame times
+//One thread pushes, any thread may take a snapshot without locking. A snapshot
+//taken while the ring wraps can contain a sample from a newer frame in place of
+//the oldest one, which does not matter for percentiles
+class FrameTimeRing
+{
+public:
+
+	//Capacity is rounded up to a power of two
+	explicit FrameTimeRing(size_t capacity = 1024);
+
+	void push(float frameMs);
+	void snapshot(std::vector<float>& samples) const;
+	void clear() { head.store(0, std::memory_order_release); }
+
+	size_t capacity() const { return mask + 1; }
+
+private:
+
+	std::unique_ptr<std::atomic<float>[]> slots;
+	size_t mask;
+	std::atomic<uint64_t> head{ 0 };
+};
+
+//Nearest rank percentiles, samples are reordered
+FrameStats computeFrameStats(std::vector<float>& samples);
+
+//Frame time histogram plus CPU scope timing
+//Frame times are always recorded. Scope timers only record while enabled; when
+//disabled a ScopedCpuTimer costs one relaxed atomic load. Every thread writes scopes
+//into its own buffer so timers can be used from worker threads. The recorded scopes
+//can be written out in Chrome's trace event format (chrome://tracing, Perfetto)
+class Profiler
+{
+public:
+
+	struct ScopeEvent
+	{
+		const char* name;	//must outlive the profiler, normally a string literal
+		int64_t start;
+		int64_t end;
+	};
+
+	explicit Profiler(size_t frameCapacity = 1024, size_t maxEventsPerThread = 1 << 18);
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	//Call once per frame; records the time since the previous call
+	void markFrame();
+	FrameStats frameStats() const;
+	uint64_t frameCount() const { return frames.load(std::memory_order_relaxed); }
+
+	//Enabling clears previously recorded scopes
+	void setEnabled(bool enable);
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	void recordScope(const char* name, int64_t start, int64_t end);
+
+	//Scopes dropped because a thread's buffer was full
+	size_t droppedScopes() const { return dropped.load(std::memory_order_relaxed); }
+
+	void writeChromeTrace(std::ostream& out) const;
+	bool writeChromeTrace(const std::string& fileName) const;
+
+private:
+
+	struct ThreadEvents
+	{
+		std::thread::id owner;
+		uint32_t threadId;
+		std::mutex mutex;	//only contended while exporting
+		std::vector<ScopeEvent> events;
+	};
+
+	ThreadEvents& threadEvents();
+
+	FrameTimeRing frameTimes;
+	int64_t lastFrameMark{ 0 };
+	std::atomic<uint64_t> frames{ 0 };
+
+	std::atomic<bool> enabled{ false };
+	std::atomic<size_t> dropped{ 0 };
+	const size_t maxEventsPerThread;
+	const uint64_t profilerId;
+
+	mutable std::mutex threadsMutex;
+	std::vector<std::unique_ptr<ThreadEvents>> threads;
+	int64_t captureStart{ 0 };
+};
+
+//Profiler shared by the app and its worker threads
+Profiler& globalProfiler();
+
+//RAII CPU timer, scopes nest naturally
+class ScopedCpuTimer
+{
+public:
+
+	ScopedCpuTimer(Profiler& profiler, const char* name) :
+		profiler{ profiler }, name{ name }, start{ profiler.isEnabled() ? profilerNow() : 0 }
+	{}
+
+	~ScopedCpuTimer()
+	{
+		if (start != 0)
+		{
+			profiler.recordScope(name, start, profilerNow());
+		}
+	}
+
+	ScopedCpuTimer(const ScopedCpuTimer&) = delete;
+	ScopedCpuTimer& operator=(const ScopedCpuTimer&) = delete;
+
+private:
+
+	Profiler& profiler;
+	const char* name;
+	int64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedCpuTimer PROFILE_CONCAT(profileScope, __LINE__){ globalProfiler(), name }
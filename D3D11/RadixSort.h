@@ -0,0 +1,117 @@
+#pragma once
+#include "Parallel.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//Maps a float to an unsigned integer whose unsigned ordering matches the float ordering
+//Negative values have all bits flipped, positive values only the sign bit
+//---------------------------------------------------------------------------------------
+inline uint32_t floatToSortableUint(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t mask = (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+	return bits ^ mask;
+}
+
+//Number of histogram entries radixSort needs for count entries
+//----------------------------------------------------------------
+inline size_t radixHistogramSize(size_t count, bool parallel)
+{
+	const size_t minEntriesPerChunk{ 16384 };
+	return (parallel ? std::max<size_t>(1, parallelChunkCount(count, minEntriesPerChunk)) : 1) * 256;
+}
+
+//Stable LSD radix sort (8 bits per pass) on the unsigned integer member Entry::key
+//entries holds the input and receives the sorted output. scratch and histograms are
+//working storage; they are resized but never shrunk so repeated sorts of a similar
+//size do not allocate. Passes where every key shares the same digit are skipped.
+//When parallel is set each pass counts and scatters contiguous chunks on worker
+//threads using per chunk histograms; the result is identical to the serial sort
+//-----------------------------------------------------------------------------------
+template <typename Entry>
+void radixSort(std::vector<Entry>& entries, std::vector<Entry>& scratch, std::vector<uint32_t>& histograms, bool parallel = false)
+{
+	using Key = decltype(Entry::key);
+	const size_t minEntriesPerChunk{ 16384 };
+	const size_t count = entries.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	scratch.resize(count);
+	histograms.resize(radixHistogramSize(count, parallel));
+	const size_t numChunks = histograms.size() / 256;
+
+	//Runs func(chunk, begin, end) over all entries either serially or with parallelFor
+	auto forEachChunk = [&](auto&& func)
+	{
+		if (parallel)
+		{
+			parallelFor(count, minEntriesPerChunk, func);
+		}
+		else
+		{
+			func(size_t{ 0 }, size_t{ 0 }, count);
+		}
+	};
+
+	for (unsigned int shift{ 0 }; shift < sizeof(Key) * 8; shift += 8)
+	{
+		std::fill(histograms.begin(), histograms.end(), 0u);
+		const Entry* source = entries.data();
+		Entry* destination = scratch.data();
+
+		//Count digits per chunk
+		forEachChunk([&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t* histogram = histograms.data() + chunk * 256;
+			for (size_t i{ begin }; i < end; i++)
+			{
+				histogram[(source[i].key >> shift) & 0xFF]++;
+			}
+		});
+
+		//Skip the pass if every key has the same digit
+		bool trivialPass{ false };
+		for (size_t digit{ 0 }; digit < 256 && !trivialPass; digit++)
+		{
+			size_t total{ 0 };
+			for (size_t chunk{ 0 }; chunk < numChunks; chunk++)
+			{
+				total += histograms[chunk * 256 + digit];
+			}
+			trivialPass = (total == count);
+		}
+		if (trivialPass)
+		{
+			continue;
+		}
+
+		//Exclusive prefix sum ordered by digit then chunk keeps the sort stable
+		uint32_t offset{ 0 };
+		for (size_t digit{ 0 }; digit < 256; digit++)
+		{
+			for (size_t chunk{ 0 }; chunk < numChunks; chunk++)
+			{
+				uint32_t digitCount = histograms[chunk * 256 + digit];
+				histograms[chunk * 256 + digit] = offset;
+				offset += digitCount;
+			}
+		}
+
+		//Scatter
+		forEachChunk([&](size_t chunk, size_t begin, size_t end)
+		{
+			uint32_t* histogram = histograms.data() + chunk * 256;
+			for (size_t i{ begin }; i < end; i++)
+			{
+				destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+			}
+		});
+
+		entries.swap(scratch);
+	}
+}
\ No newline at end of file
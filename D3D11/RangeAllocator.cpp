@@ -0,0 +1,108 @@
+#include "RangeAllocator.h"
+#include <cassert>
+#include <iterator>
+
+//-------------------------------------------------
+RangeAllocator::RangeAllocator(uint32_t capacity) :
+	totalSize{ capacity }
+{
+	if (capacity != 0)
+	{
+		insertFree(0, capacity);
+	}
+}
+
+//-----------------------------------------------
+uint32_t RangeAllocator::allocate(uint32_t size)
+{
+	if (size == 0)
+	{
+		return invalidOffset;
+	}
+
+	//Best fit: the smallest block of at least size units
+	auto fit = freeBySize.lower_bound({ size, 0 });
+	if (fit == freeBySize.end())
+	{
+		return invalidOffset;
+	}
+
+	uint32_t blockSize = fit->first;
+	uint32_t blockOffset = fit->second;
+	eraseFree(freeByOffset.find(blockOffset));
+	if (blockSize > size)
+	{
+		insertFree(blockOffset + size, blockSize - size);
+	}
+
+	allocated.emplace(blockOffset, size);
+	usedSize += size;
+	return blockOffset;
+}
+
+//-----------------------------------------
+void RangeAllocator::free(uint32_t offset)
+{
+	auto allocation = allocated.find(offset);
+	assert(allocation != allocated.end());
+	if (allocation == allocated.end())
+	{
+		return;
+	}
+
+	uint32_t size = allocation->second;
+	allocated.erase(allocation);
+	usedSize -= size;
+
+	//Merge with the free blocks on either side
+	auto next = freeByOffset.lower_bound(offset);
+	if (next != freeByOffset.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			eraseFree(previous);
+		}
+	}
+	if (next != freeByOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		eraseFree(next);
+	}
+	insertFree(offset, size);
+}
+
+//----------------------------------------------------------------
+uint32_t RangeAllocator::allocationSize(uint32_t offset) const
+{
+	auto allocation = allocated.find(offset);
+	return allocation == allocated.end() ? 0 : allocation->second;
+}
+
+//-----------------------------------------------
+RangeAllocatorStats RangeAllocator::stats() const
+{
+	RangeAllocatorStats stats;
+	stats.capacity = totalSize;
+	stats.used = usedSize;
+	stats.allocations = static_cast<uint32_t>(allocated.size());
+	stats.freeBlocks = static_cast<uint32_t>(freeByOffset.size());
+	stats.largestFreeBlock = freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+	return stats;
+}
+
+//--------------------------------------------------------------
+void RangeAllocator::insertFree(uint32_t offset, uint32_t size)
+{
+	freeByOffset.emplace(offset, size);
+	freeBySize.emplace(size, offset);
+}
+
+//-----------------------------------------------------------------------------
+void RangeAllocator::eraseFree(std::map<uint32_t, uint32_t>::iterator block)
+{
+	freeBySize.erase({ block->second, block->first });
+	freeByOffset.erase(block);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+//Occupancy of a RangeAllocator, in the allocator's units
+struct RangeAllocatorStats
+{
+	uint32_t capacity{ 0 };
+	uint32_t used{ 0 };
+	uint32_t allocations{ 0 };
+	uint32_t freeBlocks{ 0 };
+	uint32_t largestFreeBlock{ 0 };
+
+	uint32_t free() const { return capacity - used; }
+
+	//0 when all free space is one block, towards 1 as it splits into many small ones
+	double fragmentation() const { return free() == 0 ? 0.0 : 1.0 - static_cast<double>(largestFreeBlock) / free(); }
+};
+
+//Free list sub-allocator over [0, capacity), no API calls so it can be driven by tests
+//Units are whatever the caller counts in (vertices, indices, bytes). Allocation takes the
+//smallest free block that fits and splits it; freeing merges the block with free
+//neighbours, so the free list never holds two adjacent blocks. Both are O(log blocks)
+class RangeAllocator
+{
+public:
+
+	static constexpr uint32_t invalidOffset{ 0xffffffff };
+
+	explicit RangeAllocator(uint32_t capacity);
+
+	//Start of size free units, invalidOffset when no free block is large enough
+	uint32_t allocate(uint32_t size);
+
+	//Returns an allocation by the offset allocate gave out
+	void free(uint32_t offset);
+
+	//Size of the allocation at offset, 0 if there is none
+	uint32_t allocationSize(uint32_t offset) const;
+
+	RangeAllocatorStats stats() const;
+	uint32_t capacity() const { return totalSize; }
+
+private:
+
+	void insertFree(uint32_t offset, uint32_t size);
+	void eraseFree(std::map<uint32_t, uint32_t>::iterator block);
+
+	uint32_t totalSize;
+	uint32_t usedSize{ 0 };
+	std::map<uint32_t, uint32_t> freeByOffset;			//offset -> size
+	std::set<std::pair<uint32_t, uint32_t>> freeBySize;	//(size, offset), smallest first
+	std::unordered_map<uint32_t, uint32_t> allocated;	//offset -> size
+};
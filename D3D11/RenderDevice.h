@@ -0,0 +1,307 @@
+#pragma once
+#include "CpuImage.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//Thin rendering interface between the app and the graphics API
+//Covers the subset of D3D11 the samples use: buffer/texture/state creation, state
+//binding and indexed draws. Backends: D3D11RenderDevice (Windows) and
+//NullRenderDevice (any platform, records calls and counts uploaded bytes).
+//Resources are referred to by small typed handles, id 0 is the null handle
+
+//The id packs the table slot (low bits, slot + 1) and the slot's generation (high bits).
+//Destroying a resource bumps its slot's generation, so a handle to a destroyed resource
+//never equals the handle of whatever is created in the slot next; a cached binding of
+//the old handle can't be mistaken for the new resource
+//------------------------------------------------
+template <typename Tag>
+struct RenderHandle
+{
+	static constexpr uint32_t slotBits{ 20 };
+	static constexpr uint32_t slotMask{ (1u << slotBits) - 1 };
+	static constexpr uint32_t maxGeneration{ (1u << (32 - slotBits)) - 1 };
+	static constexpr uint32_t maxSlots{ slotMask };
+
+	uint32_t id{ 0 };
+
+	bool isValid() const { return id != 0; }
+	uint32_t slot() const { return (id & slotMask) - 1; }
+	uint32_t generation() const { return id >> slotBits; }
+
+	static RenderHandle make(uint32_t slot, uint32_t generation) { return RenderHandle{ generation << slotBits | (slot + 1) }; }
+
+	bool operator==(RenderHandle other) const { return id == other.id; }
+	bool operator!=(RenderHandle other) const { return id != other.id; }
+};
+
+using BufferHandle = RenderHandle<struct BufferTag>;
+using TextureHandle = RenderHandle<struct TextureTag>;
+using VertexShaderHandle = RenderHandle<struct VertexShaderTag>;
+using PixelShaderHandle = RenderHandle<struct PixelShaderTag>;
+using InputLayoutHandle = RenderHandle<struct InputLayoutTag>;
+using SamplerHandle = RenderHandle<struct SamplerTag>;
+using RasterizerStateHandle = RenderHandle<struct RasterizerStateTag>;
+using BlendStateHandle = RenderHandle<struct BlendStateTag>;
+
+//ShaderResource buffers are read by shaders as StructuredBuffer<T>
+enum class BufferBinding : uint8_t { Vertex, Index, Constant, ShaderResource };
+enum class ResourceUsage : uint8_t { Immutable, Default, Dynamic };
+
+struct BufferDesc
+{
+	uint32_t sizeInBytes;
+	BufferBinding binding;
+	ResourceUsage usage;
+	uint32_t structureStride{ 0 };	//sizeof(T) of ShaderResource buffers, unused otherwise
+};
+
+enum class TextureFormat : uint8_t { RGBA8 };
+
+struct TextureDesc
+{
+	uint32_t width;
+	uint32_t height;
+	TextureFormat format;
+};
+
+//UShort4Norm and Short2Norm read as floats in [0, 1] and [-1, 1], Half2 as 2 floats
+//Cooked meshes store these values (MeshAsset.h), new formats go at the end
+enum class VertexFormat : uint8_t { Float2, Float3, Float4, UInt1, UShort4Norm, Short2Norm, Half2 };
+
+struct InputElement
+{
+	const char* semantic;
+	uint32_t semanticIndex;
+	VertexFormat format;
+	uint32_t slot;
+	uint32_t offset;
+	bool perInstance;
+};
+
+enum class TextureFilter : uint8_t { Point, Linear, Anisotropic };
+enum class TextureAddress : uint8_t { Wrap, Clamp };
+
+struct SamplerDesc
+{
+	TextureFilter filter;
+	TextureAddress address;
+	uint32_t maxAnisotropy;
+};
+
+enum class CullMode : uint8_t { None, Front, Back };
+
+struct RasterizerDesc
+{
+	CullMode cullMode;
+	bool frontCounterClockwise;
+	bool depthClip;
+};
+
+//AlphaBlend : color SRC_ALPHA / INV_SRC_ALPHA, alpha ONE / ONE
+enum class BlendMode : uint8_t { Opaque, AlphaBlend };
+
+struct BlendDesc
+{
+	BlendMode mode;
+};
+
+enum class IndexFormat : uint8_t { UInt16, UInt32 };
+enum class ShaderStage : uint8_t { Vertex, Pixel };
+enum class MapMode : uint8_t { WriteDiscard, WriteNoOverwrite };
+enum class PrimitiveTopology : uint8_t { TriangleList };
+
+struct Viewport
+{
+	float x;
+	float y;
+	float width;
+	float height;
+	float minDepth;
+	float maxDepth;
+};
+
+//Commands recorded on a deferred context, the equivalent of ID3D11CommandList
+class ICommandList
+{
+public:
+
+	virtual ~ICommandList() = default;
+};
+
+//Records state changes and draws, the equivalent of ID3D11DeviceContext
+class IRenderContext
+{
+public:
+
+	virtual ~IRenderContext() = default;
+
+	//Resource updates; updateBuffer writes size bytes at byte offset of a Default usage buffer
+	virtual void updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size) = 0;
+	virtual void* mapBuffer(BufferHandle buffer, MapMode mode) = 0;
+	virtual void unmapBuffer(BufferHandle buffer) = 0;
+
+	//Output merger, clears the back buffer and depth/stencil
+	virtual void clear(const float color[4], float depth, uint8_t stencil) = 0;
+	virtual void setViewport(const Viewport& viewport) = 0;
+	virtual void setBlendState(BlendStateHandle state) = 0;
+
+	//Input assembler
+	virtual void setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[]) = 0;
+	virtual void setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) = 0;
+	virtual void setInputLayout(InputLayoutHandle layout) = 0;
+	virtual void setPrimitiveTopology(PrimitiveTopology topology) = 0;
+
+	//Shader stages. firstConstant / numConstants are in 16 byte constants, numConstants 0 binds the whole buffer
+	virtual void setVertexShader(VertexShaderHandle shader) = 0;
+	virtual void setPixelShader(PixelShaderHandle shader) = 0;
+	virtual void setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant = 0, uint32_t numConstants = 0) = 0;
+	virtual void setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture) = 0;
+	//ShaderResource buffers share the t registers with textures
+	virtual void setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer) = 0;
+	virtual void setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler) = 0;
+
+	//Rasterizer, the null handle restores the default state
+	virtual void setRasterizerState(RasterizerStateHandle state) = 0;
+
+	//Draws
+	virtual void drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+	virtual void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) = 0;
+
+	//Runs a command list from a deferred context of the same device. Afterwards pipeline
+	//state is back to its defaults, with the back buffer bound and the viewport covering it
+	virtual void executeCommandList(ICommandList& commandList) = 0;
+};
+
+//Recording on a thread of its own, the equivalent of a D3D11 deferred context
+//context() starts from default pipeline state with the back buffer bound and the viewport
+//covering it, and starts over from there after every finish
+class IDeferredContext
+{
+public:
+
+	virtual ~IDeferredContext() = default;
+
+	virtual IRenderContext& context() = 0;
+	virtual std::unique_ptr<ICommandList> finish() = 0;
+};
+
+//Creates resources and owns the immediate context and back buffer
+class IRenderDevice
+{
+public:
+
+	virtual ~IRenderDevice() = default;
+
+	virtual BufferHandle createBuffer(const BufferDesc& desc, const void* initialData) = 0;
+	virtual TextureHandle createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch) = 0;
+	virtual VertexShaderHandle createVertexShader(const void* bytecode, size_t size) = 0;
+	virtual PixelShaderHandle createPixelShader(const void* bytecode, size_t size) = 0;
+	virtual InputLayoutHandle createInputLayout(const InputElement elements[], uint32_t count, const void* vsBytecode, size_t size) = 0;
+	virtual SamplerHandle createSampler(const SamplerDesc& desc) = 0;
+	virtual RasterizerStateHandle createRasterizerState(const RasterizerDesc& desc) = 0;
+	virtual BlendStateHandle createBlendState(const BlendDesc& desc) = 0;
+
+	virtual void destroyBuffer(BufferHandle buffer) = 0;
+	virtual void destroyTexture(TextureHandle texture) = 0;
+
+	//Recreates the back buffer and depth buffer
+	virtual void resize(uint32_t width, uint32_t height) = 0;
+	virtual void present(uint32_t syncInterval) = 0;
+
+	//Frame fences: the n-th present ends frame n. completedFrames is the last frame the
+	//GPU has finished executing, resources written for frames up to it can be reused
+	virtual uint64_t presentedFrames() const = 0;
+	virtual uint64_t completedFrames() = 0;
+
+	virtual IRenderContext& immediateContext() = 0;
+
+	//Each deferred context may record on a different thread, concurrently with the others
+	virtual std::unique_ptr<IDeferredContext> createDeferredContext() = 0;
+};
+
+//Immutable single mip RGBA8 texture from an image decoded on the CPU
+//--------------------------------------------------------------------------------
+inline TextureHandle createTextureFromImage(IRenderDevice& device, const CpuImage& image)
+{
+	TextureDesc desc{ image.width, image.height, TextureFormat::RGBA8 };
+	return device.createTexture(desc, image.pixels.data(), static_cast<uint32_t>(image.rowPitch()));
+}
+
+//Slot table behind the handles. Freed slots are reused with the next generation; a slot
+//whose generation is exhausted is retired instead, so ids are never handed out twice.
+//Stale handles (destroyed resources) resolve to the default resource and can't be removed twice
+//--------------------------------------------------------------------------
+template <typename Resource, typename Handle>
+class HandleTable
+{
+public:
+
+	//The null handle when all Handle::maxSlots slots are taken
+	Handle add(Resource resource)
+	{
+		uint32_t slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+			slots[slot] = std::move(resource);
+		}
+		else if (slots.size() < Handle::maxSlots)
+		{
+			slot = static_cast<uint32_t>(slots.size());
+			slots.push_back(std::move(resource));
+			generations.push_back(0);
+		}
+		else
+		{
+			return Handle{};
+		}
+		liveCount++;
+		return Handle::make(slot, generations[slot]);
+	}
+
+	void remove(Handle handle)
+	{
+		if (!contains(handle))
+		{
+			return;
+		}
+		const uint32_t slot = handle.slot();
+		slots[slot] = Resource{};
+		liveCount--;
+		if (generations[slot] < Handle::maxGeneration)
+		{
+			generations[slot]++;
+			freeSlots.push_back(slot);
+		}
+		else
+		{
+			//Reusing the slot would wrap to ids handed out before
+			generations[slot] = invalidGeneration;
+		}
+	}
+
+	//True while the resource of handle has not been removed
+	bool contains(Handle handle) const
+	{
+		return handle.isValid() && handle.slot() < slots.size() && generations[handle.slot()] == handle.generation();
+	}
+
+	//The null handle and stale handles map to a default constructed resource
+	const Resource& get(Handle handle) const { return contains(handle) ? slots[handle.slot()] : empty; }
+	Resource& get(Handle handle) { return contains(handle) ? slots[handle.slot()] : empty; }
+
+	size_t size() const { return liveCount; }
+
+private:
+
+	static constexpr uint32_t invalidGeneration{ 0xffffffff };
+
+	std::vector<Resource> slots;
+	std::vector<uint32_t> generations;	//generation of the resource in each slot, or of the next one while free
+	std::vector<uint32_t> freeSlots;
+	size_t liveCount{ 0 };
+	Resource empty{};
+};
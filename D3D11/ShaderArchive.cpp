@@ -0,0 +1,176 @@
+#include "ShaderArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	//----------------------------------------------------
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+//---------------------------------------------------------
+bool ShaderArchive::open(const std::string& fileName)
+{
+	close();
+	if (!file.open(fileName) || file.size() < sizeof(ShaderArchiveHeader))
+	{
+		close();
+		return false;
+	}
+
+	ShaderArchiveHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (header.magic != shaderArchiveMagic || header.version != shaderArchiveVersion ||
+		header.alignment == 0 || (header.alignment & (header.alignment - 1)) != 0)
+	{
+		close();
+		return false;
+	}
+
+	const uint64_t indexEnd = sizeof(ShaderArchiveHeader) + uint64_t{ header.entryCount } * sizeof(ShaderArchiveEntry);
+	if (indexEnd > file.size())
+	{
+		close();
+		return false;
+	}
+
+	//The index is small, copying it avoids unaligned reads from the mapping
+	entries.resize(header.entryCount);
+	memcpy(entries.data(), file.data() + sizeof(ShaderArchiveHeader), entries.size() * sizeof(ShaderArchiveEntry));
+
+	for (size_t i{ 0 }; i < entries.size(); i++)
+	{
+		const ShaderArchiveEntry& entry = entries[i];
+		bool inRange = entry.offset <= file.size() && entry.size <= file.size() - entry.offset &&
+			uint64_t{ entry.nameOffset } + entry.nameLength <= file.size();
+		bool sorted = i == 0 || entries[i - 1].nameHash < entry.nameHash;
+		if (!inRange || !sorted || entry.offset % header.alignment != 0)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+//------------------------
+void ShaderArchive::close()
+{
+	entries.clear();
+	file.close();
+}
+
+//------------------------------------------------------------------------------------
+const ShaderArchiveEntry* ShaderArchive::findHash(uint64_t nameHash) const
+{
+	auto it = std::lower_bound(entries.begin(), entries.end(), nameHash,
+		[](const ShaderArchiveEntry& entry, uint64_t hash) { return entry.nameHash < hash; });
+	return it != entries.end() && it->nameHash == nameHash ? &*it : nullptr;
+}
+
+//------------------------------------------------------------------------------------
+bool ShaderArchive::find(const std::string& name, ShaderBytecode& bytecode) const
+{
+	const ShaderArchiveEntry* entry = findHash(fnv1a64(name));
+	if (entry == nullptr || entry->nameLength != name.size() ||
+		memcmp(file.data() + entry->nameOffset, name.data(), name.size()) != 0)
+	{
+		return false;
+	}
+
+	bytecode.data = file.data() + entry->offset;
+	bytecode.size = static_cast<size_t>(entry->size);
+	return true;
+}
+
+//-------------------------------------------------------
+std::string ShaderArchive::entryName(size_t index) const
+{
+	const ShaderArchiveEntry& entry = entries[index];
+	return std::string{ reinterpret_cast<const char*>(file.data()) + entry.nameOffset, entry.nameLength };
+}
+
+//------------------------------------------------------------------------------------
+bool ShaderArchiveWriter::add(const std::string& name, const void* data, size_t size)
+{
+	uint64_t nameHash = fnv1a64(name);
+	for (const Shader& shader : shaders)
+	{
+		if (shader.nameHash == nameHash)
+		{
+			return false;
+		}
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	shaders.push_back({ name, nameHash, std::vector<uint8_t>(bytes, bytes + size) });
+	return true;
+}
+
+//---------------------------------------------------------------------
+void ShaderArchiveWriter::serialize(std::vector<uint8_t>& archive) const
+{
+	std::vector<const Shader*> sorted;
+	sorted.reserve(shaders.size());
+	for (const Shader& shader : shaders)
+	{
+		sorted.push_back(&shader);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Shader* a, const Shader* b) { return a->nameHash < b->nameHash; });
+
+	//Lay out the name table after the index, then the aligned blobs
+	std::vector<ShaderArchiveEntry> entries(sorted.size());
+	uint64_t offset = sizeof(ShaderArchiveHeader) + entries.size() * sizeof(ShaderArchiveEntry);
+	for (size_t i{ 0 }; i < sorted.size(); i++)
+	{
+		entries[i].nameHash = sorted[i]->nameHash;
+		entries[i].nameOffset = static_cast<uint32_t>(offset);
+		entries[i].nameLength = static_cast<uint32_t>(sorted[i]->name.size());
+		offset += sorted[i]->name.size();
+	}
+	for (size_t i{ 0 }; i < sorted.size(); i++)
+	{
+		offset = alignUp(offset, shaderArchiveAlignment);
+		entries[i].offset = offset;
+		entries[i].size = sorted[i]->bytecode.size();
+		offset += sorted[i]->bytecode.size();
+	}
+
+	archive.assign(static_cast<size_t>(offset), 0);
+
+	ShaderArchiveHeader header{ shaderArchiveMagic, shaderArchiveVersion, static_cast<uint32_t>(entries.size()), shaderArchiveAlignment };
+	memcpy(archive.data(), &header, sizeof(header));
+	if (!entries.empty())
+	{
+		memcpy(archive.data() + sizeof(header), entries.data(), entries.size() * sizeof(ShaderArchiveEntry));
+	}
+
+	for (size_t i{ 0 }; i < sorted.size(); i++)
+	{
+		const Shader& shader = *sorted[i];
+		memcpy(archive.data() + entries[i].nameOffset, shader.name.data(), shader.name.size());
+		if (!shader.bytecode.empty())
+		{
+			memcpy(archive.data() + entries[i].offset, shader.bytecode.data(), shader.bytecode.size());
+		}
+	}
+}
+
+//---------------------------------------------------------------
+bool ShaderArchiveWriter::write(const std::string& fileName) const
+{
+	std::vector<uint8_t> archive;
+	serialize(archive);
+
+	std::ofstream file{ fileName, std::ios::out | std::ios::binary | std::ios::trunc };
+	if (!file)
+	{
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(archive.data()), archive.size());
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "Hash.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Packed shader archive (.shar)
+//All compiled shader stages in one file, laid out as
+//	header | entries sorted by name hash | name table | padding | blob | padding | blob ...
+//Every blob starts on a multiple of the header's alignment, all fields are little endian.
+//The archive is memory mapped read-only and lookups return pointers straight into
+//the mapping, so bytecode is handed to the device without being copied
+const uint32_t shaderArchiveMagic{ 0x52414853 };	//'SHAR'
+const uint32_t shaderArchiveVersion{ 1 };
+const uint32_t shaderArchiveAlignment{ 64 };
+
+struct ShaderArchiveHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t alignment;
+};
+
+struct ShaderArchiveEntry
+{
+	uint64_t nameHash;		//fnv1a64 of the name
+	uint64_t offset;		//from the start of the file
+	uint64_t size;
+	uint32_t nameOffset;	//from the start of the file, not null terminated
+	uint32_t nameLength;
+};
+
+static_assert(sizeof(ShaderArchiveHeader) == 16, "ShaderArchiveHeader layout is part of the file format");
+static_assert(sizeof(ShaderArchiveEntry) == 32, "ShaderArchiveEntry layout is part of the file format");
+
+//View of one compiled shader inside the mapping
+struct ShaderBytecode
+{
+	const void* data{ nullptr };
+	size_t size{ 0 };
+};
+
+class ShaderArchive
+{
+public:
+
+	//Maps the archive and validates the header and index, returns false on missing or corrupt files
+	bool open(const std::string& fileName);
+	void close();
+
+	//Returns false if there is no shader with that name
+	bool find(const std::string& name, ShaderBytecode& bytecode) const;
+
+	size_t entryCount() const { return entries.size(); }
+	std::string entryName(size_t index) const;
+
+private:
+
+	const ShaderArchiveEntry* findHash(uint64_t nameHash) const;
+
+	MappedFile file;
+	std::vector<ShaderArchiveEntry> entries;
+};
+
+//Builds archives, used by Tools/BuildShaderArchive.cpp
+class ShaderArchiveWriter
+{
+public:
+
+	//Copies the bytecode; returns false if the name is already used or its hash collides
+	bool add(const std::string& name, const void* data, size_t size);
+
+	void serialize(std::vector<uint8_t>& archive) const;
+	bool write(const std::string& fileName) const;
+
+private:
+
+	struct Shader
+	{
+		std::string name;
+		uint64_t nameHash;
+		std::vector<uint8_t> bytecode;
+	};
+	std::vector<Shader> shaders;
+};
@@ -0,0 +1,222 @@
+#include "ShaderCompileCache.h"
+#include "CpuImage.h"
+#include "Hash.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	//Bump when the entry layout or key composition changes
+	const uint32_t cacheEntryMagic{ 0x48434353 };	//'SCCH'
+	const uint32_t cacheEntryVersion{ 2 };
+
+	struct CacheEntryHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t size;
+		uint64_t bytecodeHash;
+	};
+
+	//-------------------------------------------------------
+	std::string directoryOf(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? std::string{} : path.substr(0, slash + 1);
+	}
+
+	//Separator byte so adjacent fields cannot run into each other
+	//-----------------------------------------------------------------
+	uint64_t hashField(const std::string& text, uint64_t hash)
+	{
+		const uint8_t separator{ 0 };
+		return fnv1a64(&separator, 1, fnv1a64(text, hash));
+	}
+
+	//Hashes a file and everything it includes. Files are hashed once even if included
+	//several times; includes that cannot be found (system headers) only hash their name
+	//--------------------------------------------------------------------------------------------------------
+	bool hashSourceTree(const std::string& fileName, std::vector<std::string>& visited, uint64_t& hash)
+	{
+		for (const std::string& name : visited)
+		{
+			if (name == fileName)
+			{
+				return true;
+			}
+		}
+		visited.push_back(fileName);
+
+		std::vector<uint8_t> source;
+		if (!readFileBytes(fileName, source))
+		{
+			return false;
+		}
+		hash = hashField(fileName, hash);
+		hash = fnv1a64(source.data(), source.size(), hash);
+
+		const std::string text(source.begin(), source.end());
+		size_t lineStart{ 0 };
+		while (lineStart < text.size())
+		{
+			size_t lineEnd = text.find('\n', lineStart);
+			lineEnd = lineEnd == std::string::npos ? text.size() : lineEnd;
+
+			size_t pos = text.find_first_not_of(" \t", lineStart);
+			if (pos < lineEnd && text.compare(pos, 8, "#include") == 0)
+			{
+				size_t open = text.find_first_of("\"<", pos + 8);
+				size_t close = open < lineEnd ? text.find_first_of("\">", open + 1) : std::string::npos;
+				if (close < lineEnd)
+				{
+					std::string include = text.substr(open + 1, close - open - 1);
+					std::string includePath = directoryOf(fileName) + include;
+					if (!hashSourceTree(includePath, visited, hash))
+					{
+						hash = hashField(include, hash);
+					}
+				}
+			}
+			lineStart = lineEnd + 1;
+		}
+		return true;
+	}
+
+	//------------------------------------------------
+	void createDirectory(const std::string& path)
+	{
+#if defined(_WIN32)
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------
+ShaderCompileCache::ShaderCompileCache(IShaderCompiler& compiler, const std::string& cacheDirectory) :
+	compiler{ compiler }, directory{ cacheDirectory }
+{
+	createDirectory(directory);
+}
+
+//-----------------------------------------------------------------------------------------
+bool ShaderCompileCache::computeKey(const ShaderCompileDesc& desc, uint64_t& key) const
+{
+	uint64_t hash = fnv1a64(&cacheEntryVersion, sizeof(cacheEntryVersion));
+
+	std::vector<std::string> visited;
+	if (!hashSourceTree(desc.sourceFile, visited, hash))
+	{
+		return false;
+	}
+
+	hash = hashField(compiler.identity(), hash);
+	hash = hashField(desc.entryPoint, hash);
+	hash = hashField(desc.profile, hash);
+	for (const ShaderDefine& define : desc.defines)
+	{
+		hash = hashField(define.name, hash);
+		hash = hashField(define.value, hash);
+	}
+	key = fnv1a64(&desc.flags, sizeof(desc.flags), hash);
+	return true;
+}
+
+//-------------------------------------------------------------
+std::string ShaderCompileCache::entryFileName(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return directory + "/" + name;
+}
+
+//------------------------------------------------------------------------------------------------------------
+bool ShaderCompileCache::compile(const ShaderCompileDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors)
+{
+	errors.clear();
+
+	uint64_t key;
+	if (!computeKey(desc, key))
+	{
+		errors = "cannot read " + desc.sourceFile;
+		return false;
+	}
+
+	if (readEntry(key, bytecode))
+	{
+		std::lock_guard<std::mutex> lock{ statsMutex };
+		hits++;
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ statsMutex };
+		misses++;
+	}
+	if (!compiler.compile(desc, bytecode, errors))
+	{
+		return false;
+	}
+
+	//A failed write only costs a recompile next time
+	writeEntry(key, bytecode);
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------
+bool ShaderCompileCache::readEntry(uint64_t key, std::vector<uint8_t>& bytecode) const
+{
+	std::vector<uint8_t> entry;
+	if (!readFileBytes(entryFileName(key), entry) || entry.size() < sizeof(CacheEntryHeader))
+	{
+		return false;
+	}
+
+	CacheEntryHeader header;
+	memcpy(&header, entry.data(), sizeof(header));
+	if (header.magic != cacheEntryMagic || header.version != cacheEntryVersion || header.key != key ||
+		header.size != entry.size() - sizeof(header))
+	{
+		return false;
+	}
+
+	//Catches truncated or partially written entries
+	const uint8_t* data = entry.data() + sizeof(header);
+	if (fnv1a64(data, static_cast<size_t>(header.size)) != header.bytecodeHash)
+	{
+		return false;
+	}
+	bytecode.assign(data, data + header.size);
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------
+bool ShaderCompileCache::writeEntry(uint64_t key, const std::vector<uint8_t>& bytecode) const
+{
+	CacheEntryHeader header{ cacheEntryMagic, cacheEntryVersion, key, bytecode.size(), fnv1a64(bytecode.data(), bytecode.size()) };
+
+	//Write to a temporary name first so a reader never sees a half written entry
+	const std::string fileName = entryFileName(key);
+	const std::string tempName = fileName + ".tmp";
+	{
+		std::ofstream file{ tempName, std::ios::out | std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
+		if (!file)
+		{
+			return false;
+		}
+	}
+
+	std::remove(fileName.c_str());
+	return std::rename(tempName.c_str(), fileName.c_str()) == 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "ShaderCompiler.h"
+#include <mutex>
+
+//Persistent cache in front of an IShaderCompiler
+//Each result is stored as <cacheDirectory>/<key>.bin where the key hashes the source
+//file, every file it #includes (recursively, quoted includes resolved relative to the
+//including file), the entry point, profile, defines, flags and the compiler's identity.
+//Any change to those produces a new key, stale entries are simply never read again
+class ShaderCompileCache
+{
+public:
+
+	ShaderCompileCache(IShaderCompiler& compiler, const std::string& cacheDirectory);
+
+	//Returns cached bytecode when the key matches, otherwise compiles and stores the result.
+	//Failed compilations are not cached
+	bool compile(const ShaderCompileDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors);
+
+	//Returns false if the source file cannot be read
+	bool computeKey(const ShaderCompileDesc& desc, uint64_t& key) const;
+
+	size_t hitCount() const { return hits; }
+	size_t missCount() const { return misses; }
+
+private:
+
+	std::string entryFileName(uint64_t key) const;
+	bool readEntry(uint64_t key, std::vector<uint8_t>& bytecode) const;
+	bool writeEntry(uint64_t key, const std::vector<uint8_t>& bytecode) const;
+
+	IShaderCompiler& compiler;
+	std::string directory;
+	std::mutex statsMutex;
+	size_t hits{ 0 };
+	size_t misses{ 0 };
+};
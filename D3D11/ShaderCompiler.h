@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ShaderDefine
+{
+	std::string name;
+	std::string value;
+};
+
+//Everything that affects the compiled output of one shader stage
+struct ShaderCompileDesc
+{
+	std::string sourceFile;
+	std::string entryPoint;
+	std::string profile;
+	std::vector<ShaderDefine> defines;
+	uint32_t flags{ 0 };
+};
+
+//Compiles HLSL source to bytecode
+//Kept free of Windows types so ShaderCompileCache can be used with other compilers
+class IShaderCompiler
+{
+public:
+
+	virtual ~IShaderCompiler() = default;
+
+	//Returns false if compilation failed; errors holds the compiler output (warnings included) either way
+	virtual bool compile(const ShaderCompileDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors) = 0;
+
+	//Name and version of the compiler. Different compilers can produce different bytecode
+	//from the same inputs, so the identity is part of the compile cache key
+	virtual std::string identity() const = 0;
+};
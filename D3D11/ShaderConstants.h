@@ -0,0 +1,41 @@
+#pragma once
+#include "Lighting.h"
+#include <cstdint>
+
+//Constant buffer layouts of Box.hlsl, cbperframe (slot 1) and cbperobject (slot 0)
+//Matrices are stored transposed because hlsl reads constant buffer matrices column major
+
+//Cluster grid of clusteredPixelShader, filled by LightClusterGrid::constants
+struct ClusterConstants
+{
+	XMFLOAT4 viewDepth;		//third column of the view matrix, view space z = dot(float4(posW, 1), viewDepth)
+	XMFLOAT4 clusterScale;	//xy : tiles per pixel, zw : slice = log(view space z) * z + w
+	uint32_t tilesX;
+	uint32_t tilesY;
+	uint32_t slices;
+	uint32_t pad;
+};
+
+struct cbufferPerFrame
+{
+	cbufferPerFrame() { memset(static_cast<void*>(this), 0, sizeof(*this)); }
+
+	DirectLight dirLight;
+	PointLight pointLight;
+	SpotLight spotLight;
+	XMFLOAT4 viewPos;
+	ClusterConstants clusters;
+};
+
+struct cbufferPerObject
+{
+	cbufferPerObject() { memset(static_cast<void*>(this), 0, sizeof(*this)); }
+
+	XMMATRIX worldViewProj;
+	XMMATRIX worldInvTranspose;
+	XMMATRIX world;
+	XMMATRIX texTransformMatrix;
+	Material material;
+	int useTexture;
+	int clipAlpha;
+};
@@ -66,8 +66,27 @@ cbuffer cbperframe
 	PointLight pointLight;
 	SpotLight spotLight;
     float4 viewPosW;
+    
+    //Cluster grid of clusteredPixelShader (see ClusterConstants in ShaderConstants.h)
+    float4 viewDepth;
+    float4 clusterScale;
+    uint4 clusterDims;
 }
 
+//Clustered lights, binned on the CPU by LightClusterGrid (ClusteredLighting.h). A cluster
+//lists pointCount point light indices from offset in clusterLightIndices, then spotCount spot light indices
+struct LightCluster
+{
+    uint offset;
+    uint pointCount;
+    uint spotCount;
+};
+
+StructuredBuffer<PointLight> clusterPointLights : register(t2);
+StructuredBuffer<SpotLight> clusterSpotLights : register(t3);
+StructuredBuffer<LightCluster> lightClusters : register(t4);
+StructuredBuffer<uint> clusterLightIndices : register(t5);
+
 struct VertexIN
 {
     float3 PosL : POSITION;
@@ -75,6 +94,15 @@ struct VertexIN
     float2 texCoords : TEXCOORD;
 };
 
+//VertexNormTexPacked (see Vertex.h). POSITION is UNORM over the mesh bounds, the decode is
+//folded into gWorld and gWorldViewProj. NORMAL is octahedral SNORM, TEXCOORD half
+struct PackedVertexIN
+{
+    float3 PosL : POSITION;
+    float2 NormalOct : NORMAL;
+    float2 texCoords : TEXCOORD;
+};
+
 struct VertexOUT
 {
     float4 PosH : SV_POSITION;
@@ -83,6 +111,29 @@ struct VertexOUT
     float2 texCoords : TEXCOORD;
 };
 
+//Per instance data read from input slot 1 (see InstanceData in Instancing.h)
+struct InstanceIN
+{
+    float4x4 World : WORLD;
+    float4 ambientColor : MATAMBIENT;
+    float4 diffuseColor : MATDIFFUSE;
+    float4 specColor : MATSPECULAR;
+    uint flags : INSTANCEFLAGS;
+};
+
+struct InstancedVertexOUT
+{
+    VertexOUT vout;
+    nointerpolation float4 ambientColor : MATAMBIENT;
+    nointerpolation float4 diffuseColor : MATDIFFUSE;
+    nointerpolation float4 specColor : MATSPECULAR;
+    nointerpolation uint flags : INSTANCEFLAGS;
+};
+
+//Instance flag bits
+#define INSTANCE_USE_TEXTURE 1
+#define INSTANCE_CLIP_ALPHA 2
+
 Texture2D diffuseMap : register(t0);
 Texture2D alphaMap : register(t1);
 SamplerState sam : register(s0);
@@ -99,7 +150,39 @@ VertexOUT vertexShader(VertexIN vin)
     return vout;
 }
 
-float4 pixelShader(VertexOUT vout) : SV_TARGET
+//Inverse of encodeOctahedral in VertexQuantization.cpp
+//-------------------------------------------------
+float3 decodeOctahedral(float2 e)
+{
+    float3 n = float3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * (n.xy >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+VertexOUT packedVertexShader(PackedVertexIN vin)
+{
+    VertexIN unpacked;
+    unpacked.PosL = vin.PosL;
+    unpacked.NormalL = decodeOctahedral(vin.NormalOct);
+    unpacked.texCoords = vin.texCoords;
+    return vertexShader(unpacked);
+}
+
+//Cluster of the pixel: the tile under SV_POSITION, rows counted from the top, and the slice
+//of its view space depth
+//-------------------------------------------------
+uint clusterIndex(float4 posH, float3 posW)
+{
+    uint2 tile = min(uint2(posH.xy * clusterScale.xy), clusterDims.xy - 1);
+    float depth = max(dot(float4(posW, 1.0f), viewDepth), 1e-4f);
+    uint slice = (uint) clamp(log(depth) * clusterScale.z + clusterScale.w, 0.0f, clusterDims.z - 1.0f);
+    return (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x;
+}
+
+float4 shadePixel(VertexOUT vout, Material m, bool useTex, bool clipTex, bool clusteredLights)
 {
     float4 color = { 0.0f, 0.0f, 0.0f, 0.0f };
     float4 diffTexColor = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -107,27 +190,84 @@ float4 pixelShader(VertexOUT vout) : SV_TARGET
     float4 texColor = { 1.0f, 1.0f, 1.0f, 1.0f };
     
     [flatten]
-    if (useTexture)
+    if (useTex)
     {
         diffTexColor = diffuseMap.Sample(sam, vout.texCoords);        
     }
     
     [flatten]
-    if (clipAlpha)
+    if (clipTex)
     {
         clip(diffTexColor.a - 0.1f);
     }
     
     texColor = diffTexColor; 
     
-    color += calculateDirLight(dirLight, material, normalize(vout.NormalW), vout.PosW, texColor);
-    //color += calculatePointLight(pointLight, material, normalize(vout.NormalW), vout.PosW, texColor);
-    //color += calculateSpotLight(spotLight, material, normalize(vout.NormalW), vout.PosW, texColor);
+    color += calculateDirLight(dirLight, m, normalize(vout.NormalW), vout.PosW, texColor);
+    //color += calculatePointLight(pointLight, m, normalize(vout.NormalW), vout.PosW, texColor);
+    //color += calculateSpotLight(spotLight, m, normalize(vout.NormalW), vout.PosW, texColor);
     
-    color.a = texColor.a * material.diffuseColor.a;
+    [branch]
+    if (clusteredLights)
+    {
+        LightCluster cluster = lightClusters[clusterIndex(vout.PosH, vout.PosW)];
+        uint i = cluster.offset;
+        uint pointEnd = cluster.offset + cluster.pointCount;
+        uint spotEnd = pointEnd + cluster.spotCount;
+        for (; i < pointEnd; i++)
+        {
+            color += calculatePointLight(clusterPointLights[clusterLightIndices[i]], m, normalize(vout.NormalW), vout.PosW, texColor);
+        }
+        for (; i < spotEnd; i++)
+        {
+            color += calculateSpotLight(clusterSpotLights[clusterLightIndices[i]], m, normalize(vout.NormalW), vout.PosW, texColor);
+        }
+    }
+    
+    color.a = texColor.a * m.diffuseColor.a;
     return color;
 }
 
+float4 pixelShader(VertexOUT vout) : SV_TARGET
+{
+    return shadePixel(vout, material, useTexture, clipAlpha, false);
+}
+
+//pixelShader plus the point and spot lights of the pixel's cluster
+float4 clusteredPixelShader(VertexOUT vout) : SV_TARGET
+{
+    return shadePixel(vout, material, useTexture, clipAlpha, true);
+}
+
+//Instanced path : gWorldViewProj holds the view projection matrix and the world
+//matrix comes from the instance stream. Normals are transformed by the world matrix
+//directly which assumes instances only use uniform scaling
+InstancedVertexOUT instancedVertexShader(VertexIN vin, InstanceIN inst)
+{
+    InstancedVertexOUT iout;
+    
+    float4 posW = mul(float4(vin.PosL, 1.0), inst.World);
+    iout.vout.PosH = mul(posW, gWorldViewProj);
+    iout.vout.PosW = posW.xyz;
+    iout.vout.NormalW = mul(vin.NormalL, (float3x3) inst.World);
+    iout.vout.texCoords = mul(float4(vin.texCoords, 0.0, 1.0), gTexTransform).xy;
+    iout.ambientColor = inst.ambientColor;
+    iout.diffuseColor = inst.diffuseColor;
+    iout.specColor = inst.specColor;
+    iout.flags = inst.flags;
+    
+    return iout;
+}
+
+float4 instancedPixelShader(InstancedVertexOUT iout) : SV_TARGET
+{
+    Material m;
+    m.ambientColor = iout.ambientColor;
+    m.diffuseColor = iout.diffuseColor;
+    m.specColor = iout.specColor;
+    return shadePixel(iout.vout, m, (iout.flags & INSTANCE_USE_TEXTURE) != 0, (iout.flags & INSTANCE_CLIP_ALPHA) != 0, false);
+}
+
 //--------------------------------------------------------------------------------------------------------
 float4 calculateDirLight(DirectLight l, Material m, float3 normal, float3 vertexPosW, float4 diffTexColor)
 {
@@ -0,0 +1,23 @@
+@echo off
+rem Compiles every Box.hlsl entry point the sample uses and packs them into box.shar
+rem Run from a Developer Command Prompt so fxc.exe is on the PATH
+rem Usage: BuildShaders.bat [path\to\BuildShaderArchive.exe]
+setlocal
+cd /d "%~dp0"
+
+set ARCHIVER=%~1
+if "%ARCHIVER%"=="" set ARCHIVER=BuildShaderArchive.exe
+
+fxc.exe Box.hlsl /nologo /Od /Zi /T vs_5_0 /E vertexShader /Fo box_vs.cso /Fc box_vs.asm || goto :failed
+fxc.exe Box.hlsl /nologo /Od /Zi /T ps_5_0 /E pixelShader /Fo box_ps.cso /Fc box_ps.asm || goto :failed
+fxc.exe Box.hlsl /nologo /Od /Zi /T vs_5_0 /E instancedVertexShader /Fo box_instanced_vs.cso /Fc box_instanced_vs.asm || goto :failed
+fxc.exe Box.hlsl /nologo /Od /Zi /T ps_5_0 /E instancedPixelShader /Fo box_instanced_ps.cso /Fc box_instanced_ps.asm || goto :failed
+fxc.exe Box.hlsl /nologo /Od /Zi /T vs_5_0 /E packedVertexShader /Fo box_packed_vs.cso /Fc box_packed_vs.asm || goto :failed
+fxc.exe Box.hlsl /nologo /Od /Zi /T ps_5_0 /E clusteredPixelShader /Fo box_clustered_ps.cso /Fc box_clustered_ps.asm || goto :failed
+
+"%ARCHIVER%" box.shar box_vs.cso box_ps.cso box_instanced_vs.cso box_instanced_ps.cso box_packed_vs.cso box_clustered_ps.cso || goto :failed
+exit /b 0
+
+:failed
+echo Shader build failed
+exit /b 1
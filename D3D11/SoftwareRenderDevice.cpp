@@ -0,0 +1,1411 @@
+#include "SoftwareRenderDevice.h"
+#include "Profiler.h"
+#include "VertexQuantization.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	using ShadedVertex = SoftwareRenderDevice::ShadedVertex;
+	using DrawState = SoftwareRenderDevice::DrawState;
+	using LightTerms = SoftwareRenderDevice::LightTerms;
+	using Triangle = SoftwareRenderDevice::Triangle;
+	using Plane = SoftwareRenderDevice::Plane;
+
+	//Attribute slots of ShadedVertex
+	enum : uint32_t { ATTR_POSITION = 0, ATTR_NORMAL = 3, ATTR_TEXCOORD = 6 };
+
+	//Alpha clip threshold of Box.hlsl, clip(diffTexColor.a - 0.1f)
+	const float clipThreshold{ 0.1f };
+
+	//Vertex attributes of the bound input layout, offset -1 when the element is missing
+	struct VertexFetch
+	{
+		int32_t position{ -1 };
+		int32_t normal{ -1 };
+		int32_t texCoords{ -1 };
+		VertexFormat positionFormat{ VertexFormat::Float3 };
+		VertexFormat normalFormat{ VertexFormat::Float3 };
+		VertexFormat texCoordsFormat{ VertexFormat::Float2 };
+		int32_t world[4]{ -1, -1, -1, -1 };
+		int32_t materialAmbient{ -1 };
+		int32_t materialDiffuse{ -1 };
+		int32_t materialSpecular{ -1 };
+		int32_t flags{ -1 };
+
+		bool instanced() const { return world[0] >= 0 && world[1] >= 0 && world[2] >= 0 && world[3] >= 0; }
+	};
+
+	//---------------------------------------------------------------------
+	VertexFetch findVertexElements(const std::vector<InputElement>& layout)
+	{
+		VertexFetch fetch;
+		for (const InputElement& element : layout)
+		{
+			int32_t offset = static_cast<int32_t>(element.offset);
+			std::string semantic = element.semantic;
+			if (semantic == "POSITION" && element.slot == 0) { fetch.position = offset; fetch.positionFormat = element.format; }
+			else if (semantic == "NORMAL" && element.slot == 0) { fetch.normal = offset; fetch.normalFormat = element.format; }
+			else if (semantic == "TEXCOORD" && element.slot == 0) { fetch.texCoords = offset; fetch.texCoordsFormat = element.format; }
+			else if (semantic == "WORLD" && element.slot == 1 && element.semanticIndex < 4) { fetch.world[element.semanticIndex] = offset; }
+			else if (semantic == "MATAMBIENT" && element.slot == 1) { fetch.materialAmbient = offset; }
+			else if (semantic == "MATDIFFUSE" && element.slot == 1) { fetch.materialDiffuse = offset; }
+			else if (semantic == "MATSPECULAR" && element.slot == 1) { fetch.materialSpecular = offset; }
+			else if (semantic == "INSTANCEFLAGS" && element.slot == 1) { fetch.flags = offset; }
+		}
+		return fetch;
+	}
+
+	//--------------------------------------------------------------------------
+	XMFLOAT4 readFloat4(const uint8_t* base, int32_t offset, uint32_t count)
+	{
+		float values[4]{ 0.0f, 0.0f, 0.0f, 0.0f };
+		if (offset >= 0)
+		{
+			memcpy(values, base + offset, count * sizeof(float));
+		}
+		return XMFLOAT4{ values[0], values[1], values[2], values[3] };
+	}
+
+	//Per vertex attribute converted to floats the way the input assembler does, missing
+	//components are 0. A Short2Norm normal is octahedral and decoded as packedVertexShader does
+	//------------------------------------------------------------------------------------------------
+	XMFLOAT4 readAttribute(const uint8_t* base, int32_t offset, VertexFormat format, bool octahedral)
+	{
+		if (offset < 0)
+		{
+			return XMFLOAT4{ 0.0f, 0.0f, 0.0f, 0.0f };
+		}
+		switch (format)
+		{
+		case VertexFormat::UShort4Norm:
+		{
+			uint16_t values[4];
+			memcpy(values, base + offset, sizeof(values));
+			return XMFLOAT4{ values[0] / 65535.0f, values[1] / 65535.0f, values[2] / 65535.0f, values[3] / 65535.0f };
+		}
+		case VertexFormat::Short2Norm:
+		{
+			int16_t values[2];
+			memcpy(values, base + offset, sizeof(values));
+			float x = std::max(values[0] / 32767.0f, -1.0f);
+			float y = std::max(values[1] / 32767.0f, -1.0f);
+			if (octahedral)
+			{
+				XMFLOAT3 normal = decodeOctahedral(x, y);
+				return XMFLOAT4{ normal.x, normal.y, normal.z, 0.0f };
+			}
+			return XMFLOAT4{ x, y, 0.0f, 0.0f };
+		}
+		case VertexFormat::Half2:
+		{
+			PackedVector::HALF values[2];
+			memcpy(values, base + offset, sizeof(values));
+			return XMFLOAT4{ PackedVector::XMConvertHalfToFloat(values[0]), PackedVector::XMConvertHalfToFloat(values[1]), 0.0f, 0.0f };
+		}
+		case VertexFormat::Float2: return readFloat4(base, offset, 2);
+		case VertexFormat::Float3: return readFloat4(base, offset, 3);
+		case VertexFormat::Float4: return readFloat4(base, offset, 4);
+		case VertexFormat::UInt1: break;
+		}
+		return XMFLOAT4{ 0.0f, 0.0f, 0.0f, 0.0f };
+	}
+
+	//-------------------------------------------------------------------------------------
+	void copyLightColors(LightTerms& terms, const XMFLOAT4& ambient, const XMFLOAT4& diffuse,
+		const XMFLOAT4& specular, const Material& material)
+	{
+		terms.ambient[0] = ambient.x * material.ambientColor.x;
+		terms.ambient[1] = ambient.y * material.ambientColor.y;
+		terms.ambient[2] = ambient.z * material.ambientColor.z;
+		terms.diffuse[0] = diffuse.x * material.diffuseColor.x;
+		terms.diffuse[1] = diffuse.y * material.diffuseColor.y;
+		terms.diffuse[2] = diffuse.z * material.diffuseColor.z;
+		terms.specular[0] = specular.x * material.specColor.x;
+		terms.specular[1] = specular.y * material.specColor.y;
+		terms.specular[2] = specular.z * material.specColor.z;
+	}
+
+	//------------------------------------------------------
+	void normalizeInto(float out[3], const XMFLOAT3& v)
+	{
+		float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+		float scale = length > 0.0f ? 1.0f / length : 0.0f;
+		out[0] = v.x * scale;
+		out[1] = v.y * scale;
+		out[2] = v.z * scale;
+	}
+
+	//----------------------------------------------------------------------------------------
+	DrawState makeDrawState(const cbufferPerFrame& frame, const Material& material, uint32_t lights)
+	{
+		DrawState state;
+		memset(&state, 0, sizeof(state));
+
+		copyLightColors(state.dirLight, frame.dirLight.ambientColor, frame.dirLight.diffuseColor, frame.dirLight.specColor, material);
+		normalizeInto(state.dirLight.direction, frame.dirLight.lightDir);
+
+		copyLightColors(state.pointLight, frame.pointLight.ambientColor, frame.pointLight.diffuseColor, frame.pointLight.specColor, material);
+		memcpy(state.pointLight.position, &frame.pointLight.lightPos, sizeof(float) * 3);
+		memcpy(state.pointLight.att, &frame.pointLight.att, sizeof(float) * 3);
+		state.pointLight.range = frame.pointLight.range;
+
+		copyLightColors(state.spotLight, frame.spotLight.ambientColor, frame.spotLight.diffuseColor, frame.spotLight.specColor, material);
+		memcpy(state.spotLight.position, &frame.spotLight.lightPos, sizeof(float) * 3);
+		memcpy(state.spotLight.att, &frame.spotLight.att, sizeof(float) * 3);
+		normalizeInto(state.spotLight.direction, frame.spotLight.lightDir);
+		state.spotLight.range = frame.spotLight.range;
+		state.spotLight.spotPower = frame.spotLight.spotPower;
+
+		memcpy(state.viewPos, &frame.viewPos, sizeof(float) * 3);
+		state.specPower = material.specColor.w;
+		state.diffuseAlpha = material.diffuseColor.w;
+		state.lights = lights;
+		return state;
+	}
+
+	//-------------------------------------------------------------
+	uint32_t packColor(float r, float g, float b, float a)
+	{
+		auto toUnorm = [](float value)
+		{
+			value = std::min(std::max(value, 0.0f), 1.0f);
+			return static_cast<uint32_t>(std::lrint(value * 255.0f));
+		};
+		return toUnorm(r) | (toUnorm(g) << 8) | (toUnorm(b) << 16) | (toUnorm(a) << 24);
+	}
+
+#if !defined(__AVX2__)
+	//-------------------------------------------------------------------------
+	//Scalar path for builds without AVX2
+	//-------------------------------------------------------------------------
+
+	//-----------------------------------------------------------------------------------------------
+	void sampleTexture(const NullRenderDevice::TextureData& texture, const SamplerDesc& sampler, float u, float v, float out[4])
+	{
+		const int32_t width = static_cast<int32_t>(texture.desc.width);
+		const int32_t height = static_cast<int32_t>(texture.desc.height);
+		const uint8_t* pixels = texture.pixels.data();
+		const bool wrap = sampler.address == TextureAddress::Wrap;
+
+		auto address = [wrap](int32_t i, int32_t size)
+		{
+			if (wrap)
+			{
+				i %= size;
+				return i < 0 ? i + size : i;
+			}
+			return std::min(std::max(i, 0), size - 1);
+		};
+		auto texel = [&](int32_t x, int32_t y, int channel)
+		{
+			return pixels[(static_cast<size_t>(address(y, height)) * width + address(x, width)) * 4 + channel] * (1.0f / 255.0f);
+		};
+
+		if (wrap)
+		{
+			u -= std::floor(u);
+			v -= std::floor(v);
+		}
+
+		if (sampler.filter == TextureFilter::Point)
+		{
+			int32_t x = static_cast<int32_t>(std::floor(u * width));
+			int32_t y = static_cast<int32_t>(std::floor(v * height));
+			for (int c{ 0 }; c < 4; c++)
+			{
+				out[c] = texel(x, y, c);
+			}
+			return;
+		}
+
+		float tx = u * width - 0.5f;
+		float ty = v * height - 0.5f;
+		float x0 = std::floor(tx);
+		float y0 = std::floor(ty);
+		float fx = tx - x0;
+		float fy = ty - y0;
+		int32_t ix = static_cast<int32_t>(x0);
+		int32_t iy = static_cast<int32_t>(y0);
+		for (int c{ 0 }; c < 4; c++)
+		{
+			float top = texel(ix, iy, c) + (texel(ix + 1, iy, c) - texel(ix, iy, c)) * fx;
+			float bottom = texel(ix, iy + 1, c) + (texel(ix + 1, iy + 1, c) - texel(ix, iy + 1, c)) * fx;
+			out[c] = top + (bottom - top) * fy;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------
+	//calculateDirLight / calculatePointLight / calculateSpotLight of Box.hlsl, rgb only
+	void addLight(const LightTerms& l, int type, float specPower, const float n[3], const float posW[3],
+		const float viewDir[3], const float texColor[4], float color[3])
+	{
+		float lightDir[3]{ l.direction[0], l.direction[1], l.direction[2] };
+		float intensity{ 1.0f };
+		float spotFactor{ 1.0f };
+		if (type != 0)
+		{
+			float toLight[3]{ l.position[0] - posW[0], l.position[1] - posW[1], l.position[2] - posW[2] };
+			float d = std::sqrt(toLight[0] * toLight[0] + toLight[1] * toLight[1] + toLight[2] * toLight[2]);
+			if (d > l.range)
+			{
+				return;
+			}
+			for (int i{ 0 }; i < 3; i++)
+			{
+				lightDir[i] = toLight[i] / d;
+			}
+			intensity = 1.0f / (l.att[0] + l.att[1] * d + l.att[2] * d * d);
+			if (type == 2)
+			{
+				float cosAngle = -(l.direction[0] * lightDir[0] + l.direction[1] * lightDir[1] + l.direction[2] * lightDir[2]);
+				spotFactor = std::pow(std::max(cosAngle, 0.0f), l.spotPower);
+			}
+		}
+
+		float nDotL = lightDir[0] * n[0] + lightDir[1] * n[1] + lightDir[2] * n[2];
+		float diffuseFactor = std::max(nDotL, 0.0f);
+		float specFactor{ 0.0f };
+		if (diffuseFactor > 0.0f)
+		{
+			float reflectDir[3];
+			for (int i{ 0 }; i < 3; i++)
+			{
+				reflectDir[i] = -lightDir[i] + 2.0f * nDotL * n[i];
+			}
+			float rDotV = reflectDir[0] * viewDir[0] + reflectDir[1] * viewDir[1] + reflectDir[2] * viewDir[2];
+			specFactor = std::pow(std::max(rDotV, 0.0f), specPower);
+		}
+
+		for (int c{ 0 }; c < 3; c++)
+		{
+			float diffuse = diffuseFactor * l.diffuse[c] * intensity;
+			float specular = specFactor * l.specular[c] * intensity;
+			color[c] += spotFactor * (texColor[c] * (l.ambient[c] + diffuse) + specular);
+		}
+	}
+
+	//shadePixel of Box.hlsl, returns false when the pixel is clipped
+	//------------------------------------------------------------------------------------
+	bool shadePixel(const DrawState& state, const float attributes[8], float color[4])
+	{
+		float texColor[4]{ 1.0f, 1.0f, 1.0f, 1.0f };
+		if (state.useTexture && state.texture != nullptr && !state.texture->pixels.empty())
+		{
+			sampleTexture(*state.texture, state.sampler, attributes[ATTR_TEXCOORD], attributes[ATTR_TEXCOORD + 1], texColor);
+		}
+		if (state.clipAlpha && texColor[3] - clipThreshold < 0.0f)
+		{
+			return false;
+		}
+
+		const float* posW = attributes + ATTR_POSITION;
+		const float* normalW = attributes + ATTR_NORMAL;
+		float n[3];
+		normalizeInto(n, XMFLOAT3{ normalW[0], normalW[1], normalW[2] });
+		float viewDir[3];
+		normalizeInto(viewDir, XMFLOAT3{ state.viewPos[0] - posW[0], state.viewPos[1] - posW[1], state.viewPos[2] - posW[2] });
+
+		color[0] = color[1] = color[2] = 0.0f;
+		if (state.lights & SOFTWARE_LIGHT_DIRECTIONAL)
+		{
+			addLight(state.dirLight, 0, state.specPower, n, posW, viewDir, texColor, color);
+		}
+		if (state.lights & SOFTWARE_LIGHT_POINT)
+		{
+			addLight(state.pointLight, 1, state.specPower, n, posW, viewDir, texColor, color);
+		}
+		if (state.lights & SOFTWARE_LIGHT_SPOT)
+		{
+			addLight(state.spotLight, 2, state.specPower, n, posW, viewDir, texColor, color);
+		}
+		color[3] = texColor[3] * state.diffuseAlpha;
+		return true;
+	}
+
+	//SRC_ALPHA / INV_SRC_ALPHA for color, ONE / ONE for alpha (see BlendMode::AlphaBlend)
+	//-----------------------------------------------------------------
+	uint32_t blendPixel(const float src[4], uint32_t dst, bool alphaBlend)
+	{
+		if (!alphaBlend)
+		{
+			return packColor(src[0], src[1], src[2], src[3]);
+		}
+		float srcAlpha = std::min(std::max(src[3], 0.0f), 1.0f);
+		float out[4];
+		for (int c{ 0 }; c < 3; c++)
+		{
+			float s = std::min(std::max(src[c], 0.0f), 1.0f);
+			float d = ((dst >> (c * 8)) & 0xff) * (1.0f / 255.0f);
+			out[c] = s * srcAlpha + d * (1.0f - srcAlpha);
+		}
+		out[3] = srcAlpha + (dst >> 24) * (1.0f / 255.0f);
+		return packColor(out[0], out[1], out[2], out[3]);
+	}
+#else
+	//-------------------------------------------------------------------------
+	//AVX2 path, 8 horizontally adjacent pixels per step
+	//-------------------------------------------------------------------------
+
+	struct Float3x8
+	{
+		__m256 x;
+		__m256 y;
+		__m256 z;
+	};
+
+	//--------------------------------------------------------
+	inline __m256 dot3(const Float3x8& a, const Float3x8& b)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+	}
+
+	//Zero length vectors stay zero
+	//-------------------------------------------------
+	inline Float3x8 normalize3(const Float3x8& v)
+	{
+		__m256 lengthSq = dot3(v, v);
+		__m256 scale = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSq));
+		scale = _mm256_and_ps(scale, _mm256_cmp_ps(lengthSq, _mm256_setzero_ps(), _CMP_GT_OQ));
+		return { _mm256_mul_ps(v.x, scale), _mm256_mul_ps(v.y, scale), _mm256_mul_ps(v.z, scale) };
+	}
+
+	//log2 for x > 0 : exponent + atanh series of the mantissa in [sqrt(0.5), sqrt(2)), ~1e-7 abs error
+	//-----------------------------------
+	inline __m256 log2x8(__m256 x)
+	{
+		__m256i bits = _mm256_castps_si256(x);
+		__m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		__m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+
+		__m256 large = _mm256_cmp_ps(mantissa, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+		mantissa = _mm256_blendv_ps(mantissa, _mm256_mul_ps(mantissa, _mm256_set1_ps(0.5f)), large);
+		exponent = _mm256_add_ps(exponent, _mm256_and_ps(large, _mm256_set1_ps(1.0f)));
+
+		const __m256 one = _mm256_set1_ps(1.0f);
+		__m256 s = _mm256_div_ps(_mm256_sub_ps(mantissa, one), _mm256_add_ps(mantissa, one));
+		__m256 s2 = _mm256_mul_ps(s, s);
+		__m256 series = _mm256_add_ps(_mm256_set1_ps(1.0f / 5.0f), _mm256_mul_ps(s2, _mm256_set1_ps(1.0f / 7.0f)));
+		series = _mm256_add_ps(_mm256_set1_ps(1.0f / 3.0f), _mm256_mul_ps(s2, series));
+		series = _mm256_add_ps(one, _mm256_mul_ps(s2, series));
+		//ln(m) = 2 * s * series, log2(m) = ln(m) / ln(2)
+		return _mm256_add_ps(exponent, _mm256_mul_ps(_mm256_mul_ps(s, series), _mm256_set1_ps(2.0f / 0.69314718f)));
+	}
+
+	//2^x : 2^round(x) through the exponent bits times a degree 6 polynomial on [-0.5, 0.5], ~3e-6 rel error
+	//-----------------------------------
+	inline __m256 exp2x8(__m256 x)
+	{
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(126.0f));
+		__m256 whole = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256 f = _mm256_sub_ps(x, whole);
+
+		__m256 p = _mm256_set1_ps(1.5403530e-4f);
+		p = _mm256_add_ps(_mm256_set1_ps(1.3333558e-3f), _mm256_mul_ps(p, f));
+		p = _mm256_add_ps(_mm256_set1_ps(9.6181291e-3f), _mm256_mul_ps(p, f));
+		p = _mm256_add_ps(_mm256_set1_ps(5.5504109e-2f), _mm256_mul_ps(p, f));
+		p = _mm256_add_ps(_mm256_set1_ps(2.4022651e-1f), _mm256_mul_ps(p, f));
+		p = _mm256_add_ps(_mm256_set1_ps(6.9314718e-1f), _mm256_mul_ps(p, f));
+		p = _mm256_add_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(p, f));
+
+		__m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(whole), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+	}
+
+	//pow(x, power) for x >= 0 and power > 0, pow(0, power) = 0
+	//--------------------------------------------------
+	inline __m256 powx8(__m256 x, float power)
+	{
+		__m256 positive = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ);
+		__m256 safe = _mm256_blendv_ps(_mm256_set1_ps(1.0f), x, positive);
+		return _mm256_and_ps(exp2x8(_mm256_mul_ps(log2x8(safe), _mm256_set1_ps(power))), positive);
+	}
+
+	//Texel indices of a wrapped or clamped coordinate; always inside [0, size) even for NaN lanes
+	//-----------------------------------------------------------------------------
+	inline __m256i addressTexels(__m256i i, __m256i size, bool wrap)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i last = _mm256_sub_epi32(size, _mm256_set1_epi32(1));
+		if (wrap)
+		{
+			//Coordinates are already in [0, 1) so only -1 and size can occur
+			i = _mm256_blendv_epi8(i, last, _mm256_cmpgt_epi32(zero, i));
+			i = _mm256_blendv_epi8(i, zero, _mm256_cmpgt_epi32(i, last));
+		}
+		return _mm256_min_epi32(_mm256_max_epi32(i, zero), last);
+	}
+
+	//-----------------------------------------------------------------------------------
+	inline void unpackTexels(__m256i texels, __m256 channels[4])
+	{
+		const __m256i byteMask = _mm256_set1_epi32(0xff);
+		channels[0] = _mm256_cvtepi32_ps(_mm256_and_si256(texels, byteMask));
+		channels[1] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, 8), byteMask));
+		channels[2] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, 16), byteMask));
+		channels[3] = _mm256_cvtepi32_ps(_mm256_srli_epi32(texels, 24));
+	}
+
+	//-------------------------------------------------------------------------------------------------------------
+	void sampleTexture8(const NullRenderDevice::TextureData& texture, const SamplerDesc& sampler, __m256 u, __m256 v, __m256 out[4])
+	{
+		const int* pixels = reinterpret_cast<const int*>(texture.pixels.data());
+		const __m256i width = _mm256_set1_epi32(static_cast<int>(texture.desc.width));
+		const __m256i height = _mm256_set1_epi32(static_cast<int>(texture.desc.height));
+		const __m256 widthF = _mm256_set1_ps(static_cast<float>(texture.desc.width));
+		const __m256 heightF = _mm256_set1_ps(static_cast<float>(texture.desc.height));
+		const bool wrap = sampler.address == TextureAddress::Wrap;
+		const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+
+		if (wrap)
+		{
+			u = _mm256_sub_ps(u, _mm256_floor_ps(u));
+			v = _mm256_sub_ps(v, _mm256_floor_ps(v));
+		}
+
+		if (sampler.filter == TextureFilter::Point)
+		{
+			__m256i x = addressTexels(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(u, widthF))), width, wrap);
+			__m256i y = addressTexels(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(v, heightF))), height, wrap);
+			unpackTexels(_mm256_i32gather_epi32(pixels, _mm256_add_epi32(_mm256_mullo_epi32(y, width), x), 4), out);
+			for (int c{ 0 }; c < 4; c++)
+			{
+				out[c] = _mm256_mul_ps(out[c], scale);
+			}
+			return;
+		}
+
+		__m256 tx = _mm256_sub_ps(_mm256_mul_ps(u, widthF), _mm256_set1_ps(0.5f));
+		__m256 ty = _mm256_sub_ps(_mm256_mul_ps(v, heightF), _mm256_set1_ps(0.5f));
+		__m256 x0 = _mm256_floor_ps(tx);
+		__m256 y0 = _mm256_floor_ps(ty);
+		__m256 fx = _mm256_sub_ps(tx, x0);
+		__m256 fy = _mm256_sub_ps(ty, y0);
+
+		const __m256i one = _mm256_set1_epi32(1);
+		__m256i ix0 = _mm256_cvttps_epi32(x0);
+		__m256i iy0 = _mm256_cvttps_epi32(y0);
+		__m256i ix1 = addressTexels(_mm256_add_epi32(ix0, one), width, wrap);
+		__m256i iy1 = addressTexels(_mm256_add_epi32(iy0, one), height, wrap);
+		ix0 = addressTexels(ix0, width, wrap);
+		iy0 = addressTexels(iy0, height, wrap);
+
+		__m256i row0 = _mm256_mullo_epi32(iy0, width);
+		__m256i row1 = _mm256_mullo_epi32(iy1, width);
+		__m256 t00[4], t10[4], t01[4], t11[4];
+		unpackTexels(_mm256_i32gather_epi32(pixels, _mm256_add_epi32(row0, ix0), 4), t00);
+		unpackTexels(_mm256_i32gather_epi32(pixels, _mm256_add_epi32(row0, ix1), 4), t10);
+		unpackTexels(_mm256_i32gather_epi32(pixels, _mm256_add_epi32(row1, ix0), 4), t01);
+		unpackTexels(_mm256_i32gather_epi32(pixels, _mm256_add_epi32(row1, ix1), 4), t11);
+
+		for (int c{ 0 }; c < 4; c++)
+		{
+			__m256 top = _mm256_add_ps(t00[c], _mm256_mul_ps(_mm256_sub_ps(t10[c], t00[c]), fx));
+			__m256 bottom = _mm256_add_ps(t01[c], _mm256_mul_ps(_mm256_sub_ps(t11[c], t01[c]), fx));
+			out[c] = _mm256_mul_ps(_mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), fy)), scale);
+		}
+	}
+
+	//8 wide addLight
+	//---------------------------------------------------------------------------------------------------------------
+	void addLight8(const LightTerms& l, int type, float specPower, const Float3x8& n, const Float3x8& posW,
+		const Float3x8& viewDir, const __m256 texColor[4], __m256 color[3])
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		Float3x8 lightDir{ _mm256_set1_ps(l.direction[0]), _mm256_set1_ps(l.direction[1]), _mm256_set1_ps(l.direction[2]) };
+		__m256 intensity = _mm256_set1_ps(1.0f);
+		__m256 spotFactor = _mm256_set1_ps(1.0f);
+		__m256 inRange = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		if (type != 0)
+		{
+			Float3x8 toLight{ _mm256_sub_ps(_mm256_set1_ps(l.position[0]), posW.x),
+							  _mm256_sub_ps(_mm256_set1_ps(l.position[1]), posW.y),
+							  _mm256_sub_ps(_mm256_set1_ps(l.position[2]), posW.z) };
+			__m256 d = _mm256_sqrt_ps(dot3(toLight, toLight));
+			inRange = _mm256_cmp_ps(d, _mm256_set1_ps(l.range), _CMP_LE_OQ);
+			if (_mm256_movemask_ps(inRange) == 0)
+			{
+				return;
+			}
+			__m256 invD = _mm256_div_ps(_mm256_set1_ps(1.0f), d);
+			lightDir = { _mm256_mul_ps(toLight.x, invD), _mm256_mul_ps(toLight.y, invD), _mm256_mul_ps(toLight.z, invD) };
+
+			__m256 attenuation = _mm256_add_ps(_mm256_set1_ps(l.att[0]),
+				_mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(l.att[1]), _mm256_mul_ps(d, _mm256_set1_ps(l.att[2])))));
+			intensity = _mm256_div_ps(_mm256_set1_ps(1.0f), attenuation);
+			if (type == 2)
+			{
+				Float3x8 spotDir{ _mm256_set1_ps(l.direction[0]), _mm256_set1_ps(l.direction[1]), _mm256_set1_ps(l.direction[2]) };
+				__m256 cosAngle = _mm256_sub_ps(zero, dot3(spotDir, lightDir));
+				spotFactor = powx8(_mm256_max_ps(cosAngle, zero), l.spotPower);
+			}
+		}
+
+		__m256 nDotL = dot3(lightDir, n);
+		__m256 diffuseFactor = _mm256_max_ps(nDotL, zero);
+
+		//reflect(-lightDir, n) = -lightDir + 2 * dot(n, lightDir) * n
+		__m256 twoNDotL = _mm256_add_ps(nDotL, nDotL);
+		Float3x8 reflectDir{ _mm256_sub_ps(_mm256_mul_ps(twoNDotL, n.x), lightDir.x),
+							 _mm256_sub_ps(_mm256_mul_ps(twoNDotL, n.y), lightDir.y),
+							 _mm256_sub_ps(_mm256_mul_ps(twoNDotL, n.z), lightDir.z) };
+		__m256 specFactor = powx8(_mm256_max_ps(dot3(reflectDir, viewDir), zero), specPower);
+		specFactor = _mm256_and_ps(specFactor, _mm256_cmp_ps(diffuseFactor, zero, _CMP_GT_OQ));
+
+		__m256 diffuseScale = _mm256_mul_ps(diffuseFactor, intensity);
+		__m256 specularScale = _mm256_mul_ps(specFactor, intensity);
+		for (int c{ 0 }; c < 3; c++)
+		{
+			__m256 lit = _mm256_mul_ps(texColor[c], _mm256_add_ps(_mm256_set1_ps(l.ambient[c]), _mm256_mul_ps(diffuseScale, _mm256_set1_ps(l.diffuse[c]))));
+			lit = _mm256_add_ps(lit, _mm256_mul_ps(specularScale, _mm256_set1_ps(l.specular[c])));
+			lit = _mm256_and_ps(_mm256_mul_ps(lit, spotFactor), inRange);
+			color[c] = _mm256_add_ps(color[c], lit);
+		}
+	}
+
+	//8 wide shadePixel, returns the lanes that were not clipped
+	//--------------------------------------------------------------------------------------
+	__m256 shadePixel8(const DrawState& state, const __m256 attributes[8], __m256 color[4])
+	{
+		__m256 texColor[4]{ _mm256_set1_ps(1.0f), _mm256_set1_ps(1.0f), _mm256_set1_ps(1.0f), _mm256_set1_ps(1.0f) };
+		if (state.useTexture && state.texture != nullptr && !state.texture->pixels.empty())
+		{
+			sampleTexture8(*state.texture, state.sampler, attributes[ATTR_TEXCOORD], attributes[ATTR_TEXCOORD + 1], texColor);
+		}
+
+		__m256 kept = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		if (state.clipAlpha)
+		{
+			kept = _mm256_cmp_ps(_mm256_sub_ps(texColor[3], _mm256_set1_ps(clipThreshold)), _mm256_setzero_ps(), _CMP_GE_OQ);
+			if (_mm256_movemask_ps(kept) == 0)
+			{
+				return kept;
+			}
+		}
+
+		Float3x8 posW{ attributes[ATTR_POSITION], attributes[ATTR_POSITION + 1], attributes[ATTR_POSITION + 2] };
+		Float3x8 n = normalize3({ attributes[ATTR_NORMAL], attributes[ATTR_NORMAL + 1], attributes[ATTR_NORMAL + 2] });
+		Float3x8 viewDir = normalize3({ _mm256_sub_ps(_mm256_set1_ps(state.viewPos[0]), posW.x),
+										_mm256_sub_ps(_mm256_set1_ps(state.viewPos[1]), posW.y),
+										_mm256_sub_ps(_mm256_set1_ps(state.viewPos[2]), posW.z) });
+
+		color[0] = color[1] = color[2] = _mm256_setzero_ps();
+		if (state.lights & SOFTWARE_LIGHT_DIRECTIONAL)
+		{
+			addLight8(state.dirLight, 0, state.specPower, n, posW, viewDir, texColor, color);
+		}
+		if (state.lights & SOFTWARE_LIGHT_POINT)
+		{
+			addLight8(state.pointLight, 1, state.specPower, n, posW, viewDir, texColor, color);
+		}
+		if (state.lights & SOFTWARE_LIGHT_SPOT)
+		{
+			addLight8(state.spotLight, 2, state.specPower, n, posW, viewDir, texColor, color);
+		}
+		color[3] = _mm256_mul_ps(texColor[3], _mm256_set1_ps(state.diffuseAlpha));
+		return kept;
+	}
+
+	//Round to nearest after saturating, as UNORM render targets convert
+	//------------------------------------------
+	inline __m256i toUnorm8(__m256 value)
+	{
+		value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		return _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)));
+	}
+
+	//---------------------------------------------------------------------------
+	__m256i blendPixels8(const __m256 src[4], __m256i dst, bool alphaBlend)
+	{
+		__m256 out[4]{ src[0], src[1], src[2], src[3] };
+		if (alphaBlend)
+		{
+			__m256 dstChannels[4];
+			unpackTexels(dst, dstChannels);
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+			__m256 srcAlpha = _mm256_min_ps(_mm256_max_ps(src[3], _mm256_setzero_ps()), one);
+			__m256 invSrcAlpha = _mm256_sub_ps(one, srcAlpha);
+			for (int c{ 0 }; c < 3; c++)
+			{
+				__m256 s = _mm256_min_ps(_mm256_max_ps(src[c], _mm256_setzero_ps()), one);
+				out[c] = _mm256_add_ps(_mm256_mul_ps(s, srcAlpha), _mm256_mul_ps(_mm256_mul_ps(dstChannels[c], scale), invSrcAlpha));
+			}
+			out[3] = _mm256_add_ps(srcAlpha, _mm256_mul_ps(dstChannels[3], scale));
+		}
+		__m256i packed = toUnorm8(out[0]);
+		packed = _mm256_or_si256(packed, _mm256_slli_epi32(toUnorm8(out[1]), 8));
+		packed = _mm256_or_si256(packed, _mm256_slli_epi32(toUnorm8(out[2]), 16));
+		return _mm256_or_si256(packed, _mm256_slli_epi32(toUnorm8(out[3]), 24));
+	}
+
+	//-----------------------------------------------------------------------------
+	inline __m256 evaluatePlane(const Plane& plane, __m256 x, __m256 y)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.a), x), _mm256_mul_ps(_mm256_set1_ps(plane.b), y)),
+			_mm256_set1_ps(plane.c));
+	}
+#endif
+
+	//------------------------------------------------------------------------------------------
+	ShadedVertex lerpVertex(const ShadedVertex& a, const ShadedVertex& b, float t)
+	{
+		ShadedVertex v;
+		for (int i{ 0 }; i < 4; i++)
+		{
+			v.clip[i] = a.clip[i] + (b.clip[i] - a.clip[i]) * t;
+		}
+		for (int i{ 0 }; i < 8; i++)
+		{
+			v.attributes[i] = a.attributes[i] + (b.attributes[i] - a.attributes[i]) * t;
+		}
+		return v;
+	}
+}
+
+//--------------------------------------------------
+double SoftwareRasterStats::trianglesPerSecond() const
+{
+	int64_t nanoseconds = setupNanoseconds + rasterNanoseconds;
+	return nanoseconds > 0 ? trianglesRasterized * 1e9 / nanoseconds : 0.0;
+}
+
+//-----------------------------------------------
+double SoftwareRasterStats::pixelsPerSecond() const
+{
+	return rasterNanoseconds > 0 ? pixelsWritten * 1e9 / rasterNanoseconds : 0.0;
+}
+
+//-------------------------------------------------------------------------------------
+SoftwareRenderContext::SoftwareRenderContext(SoftwareRenderDevice& device) :
+	NullRenderContext{ device }, device{ device }
+{}
+
+//---------------------------------------------------------------------------------
+void SoftwareRenderContext::clear(const float color[4], float depth, uint8_t stencil)
+{
+	NullRenderContext::clear(color, depth, stencil);
+	device.flush();
+	std::fill(device.color.begin(), device.color.end(), packColor(color[0], color[1], color[2], color[3]));
+	std::fill(device.depth.begin(), device.depth.end(), depth);
+}
+
+//-----------------------------------------------------------------
+void SoftwareRenderContext::setViewport(const Viewport& viewport)
+{
+	NullRenderContext::setViewport(viewport);
+	device.viewport = viewport;
+}
+
+//---------------------------------------------------------------
+void SoftwareRenderContext::setBlendState(BlendStateHandle state)
+{
+	NullRenderContext::setBlendState(state);
+	blendState = state;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------------------
+void SoftwareRenderContext::setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[])
+{
+	NullRenderContext::setVertexBuffers(startSlot, count, buffers, strides, offsets);
+	for (uint32_t i{ 0 }; i < count && startSlot + i < 2; i++)
+	{
+		vertexStreams[startSlot + i] = { buffers[i], strides[i], offsets[i] };
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+void SoftwareRenderContext::setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset)
+{
+	NullRenderContext::setIndexBuffer(buffer, format, offset);
+	indexBuffer = buffer;
+	indexFormat = format;
+	indexOffset = offset;
+}
+
+//-----------------------------------------------------------------
+void SoftwareRenderContext::setInputLayout(InputLayoutHandle layout)
+{
+	NullRenderContext::setInputLayout(layout);
+	inputLayout = layout;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+void SoftwareRenderContext::setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+{
+	NullRenderContext::setConstantBuffer(stage, slot, buffer, firstConstant, numConstants);
+	if (stage == ShaderStage::Vertex && slot == 0)
+	{
+		vsConstants = { buffer, firstConstant };
+	}
+	else if (stage == ShaderStage::Pixel && slot < 2)
+	{
+		psConstants[slot] = { buffer, firstConstant };
+	}
+}
+
+//------------------------------------------------------------------------------------------
+void SoftwareRenderContext::setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture)
+{
+	NullRenderContext::setTexture(stage, slot, texture);
+	if (stage == ShaderStage::Pixel && slot == 0)
+	{
+		this->texture = texture;
+	}
+}
+
+//------------------------------------------------------------------------------------------
+void SoftwareRenderContext::setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler)
+{
+	NullRenderContext::setSampler(stage, slot, sampler);
+	if (stage == ShaderStage::Pixel && slot == 0)
+	{
+		this->sampler = sampler;
+	}
+}
+
+//--------------------------------------------------------------------------
+void SoftwareRenderContext::setRasterizerState(RasterizerStateHandle state)
+{
+	NullRenderContext::setRasterizerState(state);
+	rasterizerState = state;
+}
+
+//---------------------------------------------------------------------------------------------
+void SoftwareRenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	NullRenderContext::drawIndexed(indexCount, startIndex, baseVertex);
+	draw(indexCount, 1, startIndex, baseVertex, 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------------------------------
+void SoftwareRenderContext::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+	NullRenderContext::drawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+	draw(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+//----------------------------------------------------------------------------
+void SoftwareRenderContext::executeCommandList(ICommandList& commandList)
+{
+	resetState();
+	NullRenderContext::executeCommandList(commandList);
+	resetState();
+}
+
+//-------------------------------------
+void SoftwareRenderContext::resetState()
+{
+	for (VertexStream& stream : vertexStreams)
+	{
+		stream = VertexStream{};
+	}
+	indexBuffer = BufferHandle{};
+	indexFormat = IndexFormat::UInt32;
+	indexOffset = 0;
+	inputLayout = InputLayoutHandle{};
+	vsConstants = ConstantBinding{};
+	psConstants[0] = ConstantBinding{};
+	psConstants[1] = ConstantBinding{};
+	texture = TextureHandle{};
+	sampler = SamplerHandle{};
+	rasterizerState = RasterizerStateHandle{};
+	blendState = BlendStateHandle{};
+	device.viewport = { 0.0f, 0.0f, static_cast<float>(device.width()), static_cast<float>(device.height()), 0.0f, 1.0f };
+}
+
+//Start of a bound constant buffer range, nullptr if it holds fewer than size bytes
+//------------------------------------------------------------------------------------
+const uint8_t* SoftwareRenderContext::constants(const ConstantBinding& binding, size_t size)
+{
+	if (!binding.buffer.isValid())
+	{
+		return nullptr;
+	}
+	const std::vector<uint8_t>& bytes = device.buffer(binding.buffer).bytes;
+	size_t offset = size_t{ binding.firstConstant } * 16;
+	return offset + size <= bytes.size() ? bytes.data() + offset : nullptr;
+}
+
+//Vertex stage and triangle setup; rasterization waits for the next flush
+//------------------------------------------------------------------------------------------------------------------------------
+void SoftwareRenderContext::draw(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+	int64_t start = profilerNow();
+	device.stats.trianglesSubmitted += uint64_t{ indexCount / 3 } * instanceCount;
+
+	//Constant buffers may be unaligned byte storage, copy them out
+	const uint8_t* objectBytes = constants(vsConstants, sizeof(cbufferPerObject));
+	const uint8_t* frameBytes = constants(psConstants[1], sizeof(cbufferPerFrame));
+	const std::vector<uint8_t>& vertexBytes = device.buffer(vertexStreams[0].buffer).bytes;
+	const std::vector<uint8_t>& indexBytes = device.buffer(indexBuffer).bytes;
+	const uint32_t indexSize = indexFormat == IndexFormat::UInt16 ? 2 : 4;
+	const uint32_t stride = vertexStreams[0].stride;
+	if (objectBytes == nullptr || frameBytes == nullptr || stride == 0 ||
+		indexOffset + (uint64_t{ startIndex } + indexCount) * indexSize > indexBytes.size())
+	{
+		return;
+	}
+	cbufferPerObject object;
+	cbufferPerFrame frame;
+	memcpy(&object, objectBytes, sizeof(object));
+	memcpy(&frame, frameBytes, sizeof(frame));
+
+	const VertexFetch fetch = findVertexElements(device.inputLayout(inputLayout));
+	if (fetch.position < 0)
+	{
+		return;
+	}
+
+	//Referenced vertex range
+	std::vector<uint32_t> indices(indexCount);
+	const uint8_t* indexData = indexBytes.data() + indexOffset + size_t{ startIndex } * indexSize;
+	for (uint32_t i{ 0 }; i < indexCount; i++)
+	{
+		if (indexSize == 2)
+		{
+			uint16_t index;
+			memcpy(&index, indexData + i * 2, 2);
+			indices[i] = index;
+		}
+		else
+		{
+			memcpy(&indices[i], indexData + i * 4, 4);
+		}
+	}
+	if (indices.empty())
+	{
+		return;
+	}
+	const auto range = std::minmax_element(indices.begin(), indices.end());
+	const int64_t firstVertex = int64_t{ *range.first } + baseVertex;
+	const int64_t lastVertex = int64_t{ *range.second } + baseVertex;
+	if (firstVertex < 0 || vertexStreams[0].offset + static_cast<uint64_t>(lastVertex + 1) * stride > vertexBytes.size())
+	{
+		return;
+	}
+
+	RasterizerDesc rasterizer{ CullMode::Back, false, true };
+	if (rasterizerState.isValid())
+	{
+		rasterizer = device.rasterizerState(rasterizerState);
+	}
+
+	//hlsl matrices come back from the transposed cbuffer storage
+	const XMMATRIX worldViewProj = XMMatrixTranspose(object.worldViewProj);
+	const XMMATRIX worldInvTranspose = XMMatrixTranspose(object.worldInvTranspose);
+	const XMMATRIX world = XMMatrixTranspose(object.world);
+	const XMMATRIX texTransform = XMMatrixTranspose(object.texTransformMatrix);
+
+	const std::vector<uint8_t>& instanceBytes = device.buffer(vertexStreams[1].buffer).bytes;
+	const bool instanced = fetch.instanced();
+	for (uint32_t instance{ 0 }; instance < instanceCount; instance++)
+	{
+		Material material = object.material;
+		bool useTexture = object.useTexture != 0;
+		bool clipAlpha = object.clipAlpha != 0;
+		XMMATRIX instanceWorld = world;
+		XMMATRIX positionToClip = worldViewProj;
+		XMMATRIX normalToWorld = worldInvTranspose;
+
+		if (instanced)
+		{
+			//instancedVertexShader : world from the instance stream, the cbuffer holds view * proj
+			size_t offset = vertexStreams[1].offset + size_t{ startInstance + instance } * vertexStreams[1].stride;
+			if (vertexStreams[1].stride == 0 || offset + vertexStreams[1].stride > instanceBytes.size())
+			{
+				return;
+			}
+			const uint8_t* data = instanceBytes.data() + offset;
+			XMFLOAT4 rows[4];
+			for (int r{ 0 }; r < 4; r++)
+			{
+				rows[r] = readFloat4(data, fetch.world[r], 4);
+			}
+			instanceWorld = XMMATRIX{ XMLoadFloat4(&rows[0]), XMLoadFloat4(&rows[1]), XMLoadFloat4(&rows[2]), XMLoadFloat4(&rows[3]) };
+			positionToClip = instanceWorld * worldViewProj;
+			normalToWorld = instanceWorld;
+
+			material.ambientColor = readFloat4(data, fetch.materialAmbient, 4);
+			material.diffuseColor = readFloat4(data, fetch.materialDiffuse, 4);
+			material.specColor = readFloat4(data, fetch.materialSpecular, 4);
+			uint32_t flags{ 0 };
+			if (fetch.flags >= 0)
+			{
+				memcpy(&flags, data + fetch.flags, sizeof(flags));
+			}
+			useTexture = (flags & 1) != 0;
+			clipAlpha = (flags & 2) != 0;
+		}
+
+		DrawState state = makeDrawState(frame, material, device.enabledLights);
+		state.useTexture = useTexture;
+		state.clipAlpha = clipAlpha;
+		state.alphaBlend = device.blendState(blendState).mode == BlendMode::AlphaBlend;
+		state.texture = texture.isValid() ? &device.texture(texture) : nullptr;
+		state.sampler = sampler.isValid() ? device.sampler(sampler) : SamplerDesc{ TextureFilter::Linear, TextureAddress::Clamp, 1 };
+		device.draws.push_back(state);
+
+		//vertexShader / instancedVertexShader
+		std::vector<ShadedVertex>& shaded = device.shadedVertices;
+		shaded.resize(static_cast<size_t>(lastVertex - firstVertex + 1));
+		for (int64_t v{ firstVertex }; v <= lastVertex; v++)
+		{
+			const uint8_t* data = vertexBytes.data() + vertexStreams[0].offset + v * stride;
+			XMFLOAT4 position = readAttribute(data, fetch.position, fetch.positionFormat, false);
+			XMFLOAT4 normal = readAttribute(data, fetch.normal, fetch.normalFormat, true);
+			XMFLOAT4 texCoords = readAttribute(data, fetch.texCoords, fetch.texCoordsFormat, false);
+
+			XMVECTOR positionL = XMVectorSet(position.x, position.y, position.z, 1.0f);
+			XMFLOAT4 clip, positionW, normalW, uv;
+			XMStoreFloat4(&clip, XMVector4Transform(positionL, positionToClip));
+			XMStoreFloat4(&positionW, XMVector4Transform(positionL, instanceWorld));
+			XMStoreFloat4(&normalW, XMVector3TransformNormal(XMVectorSet(normal.x, normal.y, normal.z, 0.0f), normalToWorld));
+			XMStoreFloat4(&uv, XMVector4Transform(XMVectorSet(texCoords.x, texCoords.y, 0.0f, 1.0f), texTransform));
+
+			ShadedVertex& out = shaded[static_cast<size_t>(v - firstVertex)];
+			out = { { clip.x, clip.y, clip.z, clip.w },
+					{ positionW.x, positionW.y, positionW.z, normalW.x, normalW.y, normalW.z, uv.x, uv.y } };
+		}
+
+		for (uint32_t i{ 0 }; i + 3 <= indexCount; i += 3)
+		{
+			device.submitTriangle(shaded[static_cast<size_t>(indices[i] + baseVertex - firstVertex)],
+				shaded[static_cast<size_t>(indices[i + 1] + baseVertex - firstVertex)],
+				shaded[static_cast<size_t>(indices[i + 2] + baseVertex - firstVertex)],
+				rasterizer.cullMode, rasterizer.frontCounterClockwise);
+		}
+	}
+	device.stats.setupNanoseconds += profilerNow() - start;
+}
+
+//-------------------------------------------------------------------------------------------
+SoftwareRenderDevice::SoftwareRenderDevice(unsigned int numThreads) :
+	softwareContext{ *this }, pool{ numThreads > 1 ? numThreads - 1 : 0 }, rasterWorkers{ numThreads > 1 ? numThreads - 1 : 0 }
+{
+	setContext(softwareContext);
+}
+
+//-----------------------------------------------------------------------------------------------------------
+TextureHandle SoftwareRenderDevice::createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch)
+{
+	//Pending draws point into the texture table which may grow
+	flush();
+	return NullRenderDevice::createTexture(desc, pixels, rowPitch);
+}
+
+//------------------------------------------------------------
+void SoftwareRenderDevice::destroyTexture(TextureHandle texture)
+{
+	flush();
+	NullRenderDevice::destroyTexture(texture);
+}
+
+//-----------------------------------------------------------------
+void SoftwareRenderDevice::resize(uint32_t width, uint32_t height)
+{
+	flush();
+	pitch = (width + 7) & ~7u;
+	color.assign(size_t{ pitch } * height, 0);
+	depth.assign(size_t{ pitch } * height, 1.0f);
+	tilesX = (width + tileSize - 1) / tileSize;
+	tilesY = (height + tileSize - 1) / tileSize;
+	tileBins.assign(size_t{ tilesX } * tilesY, {});
+	NullRenderDevice::resize(width, height);
+}
+
+//------------------------------------------------------------
+void SoftwareRenderDevice::present(uint32_t syncInterval)
+{
+	flush();
+	NullRenderDevice::present(syncInterval);
+}
+
+//-----------------------------------------------------
+void SoftwareRenderDevice::copyBackBuffer(CpuImage& image)
+{
+	flush();
+	image.width = width();
+	image.height = height();
+	image.pixels.resize(image.rowPitch() * image.height);
+	for (uint32_t y{ 0 }; y < image.height; y++)
+	{
+		memcpy(image.pixels.data() + image.rowPitch() * y, color.data() + size_t{ pitch } * y, image.rowPitch());
+	}
+}
+
+//---------------------------------------------------------
+float SoftwareRenderDevice::depthAt(uint32_t x, uint32_t y)
+{
+	flush();
+	return depth[size_t{ pitch } * y + x];
+}
+
+//Clips against the near plane (z >= 0) and sets up the resulting triangles
+//--------------------------------------------------------------------------------------------------------------------------------------------
+void SoftwareRenderDevice::submitTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, CullMode cullMode, bool frontCounterClockwise)
+{
+	const ShadedVertex* input[3]{ &v0, &v1, &v2 };
+
+	//Trivially reject triangles fully outside one of the x / y / far planes
+	for (int axis{ 0 }; axis < 3; axis++)
+	{
+		bool allAbove{ true };
+		bool allBelow{ axis != 2 };
+		for (const ShadedVertex* v : input)
+		{
+			allAbove &= v->clip[axis] > v->clip[3];
+			allBelow &= v->clip[axis] < -v->clip[3];
+		}
+		if (allAbove || allBelow)
+		{
+			return;
+		}
+	}
+
+	bool inside[3]{ v0.clip[2] >= 0.0f, v1.clip[2] >= 0.0f, v2.clip[2] >= 0.0f };
+	if (inside[0] && inside[1] && inside[2])
+	{
+		setupTriangle(input, cullMode, frontCounterClockwise);
+		return;
+	}
+	if (!inside[0] && !inside[1] && !inside[2])
+	{
+		return;
+	}
+
+	//Sutherland-Hodgman against one plane gives at most 4 vertices
+	clipped.clear();
+	for (int i{ 0 }; i < 3; i++)
+	{
+		const ShadedVertex& current = *input[i];
+		const ShadedVertex& next = *input[(i + 1) % 3];
+		if (inside[i])
+		{
+			clipped.push_back(current);
+		}
+		if (inside[i] != inside[(i + 1) % 3])
+		{
+			float t = current.clip[2] / (current.clip[2] - next.clip[2]);
+			clipped.push_back(lerpVertex(current, next, t));
+		}
+	}
+	for (size_t i{ 1 }; i + 1 < clipped.size(); i++)
+	{
+		const ShadedVertex* fan[3]{ &clipped[0], &clipped[i], &clipped[i + 1] };
+		setupTriangle(fan, cullMode, frontCounterClockwise);
+	}
+}
+
+//Projects to the viewport, culls, computes edge functions and interpolation planes and bins the triangle
+//--------------------------------------------------------------------------------------------------------------------
+void SoftwareRenderDevice::setupTriangle(const ShadedVertex* const vertices[3], CullMode cullMode, bool frontCounterClockwise)
+{
+	double x[3], y[3];
+	float z[3], invW[3];
+	for (int i{ 0 }; i < 3; i++)
+	{
+		const float* clip = vertices[i]->clip;
+		invW[i] = 1.0f / clip[3];
+		float ndcX = clip[0] * invW[i];
+		float ndcY = clip[1] * invW[i];
+		//8 bit sub pixel snapping
+		x[i] = std::nearbyint((viewport.x + (ndcX * 0.5f + 0.5f) * viewport.width) * 256.0) / 256.0;
+		y[i] = std::nearbyint((viewport.y + (0.5f - ndcY * 0.5f) * viewport.height) * 256.0) / 256.0;
+		z[i] = viewport.minDepth + clip[2] * invW[i] * (viewport.maxDepth - viewport.minDepth);
+	}
+
+	//Positive area is clockwise on screen (y points down)
+	double area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (area == 0.0)
+	{
+		return;
+	}
+	bool front = (area > 0.0) != frontCounterClockwise;
+	if ((cullMode == CullMode::Back && !front) || (cullMode == CullMode::Front && front))
+	{
+		return;
+	}
+
+	int order[3]{ 0, 1, 2 };
+	if (area < 0.0)
+	{
+		std::swap(order[1], order[2]);
+		area = -area;
+	}
+
+	int32_t minX = static_cast<int32_t>(std::floor(std::min({ x[0], x[1], x[2] })));
+	int32_t minY = static_cast<int32_t>(std::floor(std::min({ y[0], y[1], y[2] })));
+	int32_t maxX = static_cast<int32_t>(std::floor(std::max({ x[0], x[1], x[2] })));
+	int32_t maxY = static_cast<int32_t>(std::floor(std::max({ y[0], y[1], y[2] })));
+	minX = std::max<int32_t>(minX, static_cast<int32_t>(std::max(viewport.x, 0.0f)));
+	minY = std::max<int32_t>(minY, static_cast<int32_t>(std::max(viewport.y, 0.0f)));
+	maxX = std::min<int32_t>(maxX, std::min<int32_t>(static_cast<int32_t>(std::ceil(viewport.x + viewport.width)), width()) - 1);
+	maxY = std::min<int32_t>(maxY, std::min<int32_t>(static_cast<int32_t>(std::ceil(viewport.y + viewport.height)), height()) - 1);
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	Triangle triangle;
+	double edgeA[3], edgeB[3], edgeC[3];
+	for (int e{ 0 }; e < 3; e++)
+	{
+		//Edge e is opposite vertex e, positive inside
+		int a = order[(e + 1) % 3];
+		int b = order[(e + 2) % 3];
+		edgeA[e] = y[a] - y[b];
+		edgeB[e] = x[b] - x[a];
+		edgeC[e] = -(edgeA[e] * x[a] + edgeB[e] * y[a]);
+		triangle.edgeA[e] = static_cast<float>(edgeA[e]);
+		triangle.edgeB[e] = static_cast<float>(edgeB[e]);
+		triangle.edgeC[e] = edgeC[e];
+		triangle.edgeInclusive[e] = edgeA[e] > 0.0 || (edgeA[e] == 0.0 && edgeB[e] > 0.0);
+	}
+
+	//Vertex i has weight edge i / area
+	auto makePlane = [&](const float values[3])
+	{
+		double a{ 0.0 }, b{ 0.0 }, c{ 0.0 };
+		for (int e{ 0 }; e < 3; e++)
+		{
+			a += edgeA[e] * values[order[e]];
+			b += edgeB[e] * values[order[e]];
+			c += edgeC[e] * values[order[e]];
+		}
+		return Plane{ static_cast<float>(a / area), static_cast<float>(b / area), static_cast<float>(c / area) };
+	};
+
+	triangle.depth = makePlane(z);
+	triangle.invW = makePlane(invW);
+	for (int k{ 0 }; k < 8; k++)
+	{
+		float values[3];
+		for (int i{ 0 }; i < 3; i++)
+		{
+			values[i] = vertices[i]->attributes[k] * invW[i];
+		}
+		triangle.attributes[k] = makePlane(values);
+	}
+	triangle.minX = minX;
+	triangle.minY = minY;
+	triangle.maxX = maxX;
+	triangle.maxY = maxY;
+	triangle.draw = static_cast<uint32_t>(draws.size() - 1);
+
+	const uint32_t index = static_cast<uint32_t>(triangles.size());
+	triangles.push_back(triangle);
+	stats.trianglesRasterized++;
+	for (int32_t ty{ minY / static_cast<int32_t>(tileSize) }; ty <= maxY / static_cast<int32_t>(tileSize); ty++)
+	{
+		for (int32_t tx{ minX / static_cast<int32_t>(tileSize) }; tx <= maxX / static_cast<int32_t>(tileSize); tx++)
+		{
+			tileBins[size_t{ static_cast<uint32_t>(ty) } * tilesX + tx].push_back(index);
+		}
+	}
+}
+
+//Tiles with work are shared out to the pool through an atomic counter; the calling thread helps
+//-------------------------------
+void SoftwareRenderDevice::flush()
+{
+	if (triangles.empty())
+	{
+		draws.clear();
+		return;
+	}
+
+	PROFILE_SCOPE("softwareRaster");
+	int64_t start = profilerNow();
+
+	std::vector<uint32_t> busyTiles;
+	for (uint32_t tile{ 0 }; tile < tileBins.size(); tile++)
+	{
+		if (!tileBins[tile].empty())
+		{
+			busyTiles.push_back(tile);
+		}
+	}
+
+	std::atomic<size_t> nextTile{ 0 };
+	std::atomic<uint64_t> shaded{ 0 };
+	std::atomic<uint64_t> written{ 0 };
+	auto rasterizeTiles = [&]()
+	{
+		uint64_t tileShaded{ 0 };
+		uint64_t tileWritten{ 0 };
+		for (size_t i = nextTile++; i < busyTiles.size(); i = nextTile++)
+		{
+			rasterizeTile(busyTiles[i], tileShaded, tileWritten);
+		}
+		shaded += tileShaded;
+		written += tileWritten;
+	};
+
+	std::vector<std::future<void>> jobs;
+	size_t jobCount = std::min<size_t>(rasterWorkers, busyTiles.size() - 1);
+	for (size_t i{ 0 }; i < jobCount; i++)
+	{
+		jobs.push_back(pool.submitTask(rasterizeTiles));
+	}
+	rasterizeTiles();
+	for (std::future<void>& job : jobs)
+	{
+		job.get();
+	}
+
+	for (uint32_t tile : busyTiles)
+	{
+		tileBins[tile].clear();
+	}
+	triangles.clear();
+	draws.clear();
+
+	stats.pixelsShaded += shaded;
+	stats.pixelsWritten += written;
+	stats.rasterNanoseconds += profilerNow() - start;
+}
+
+//Walks the tile's triangles in submission order
+//--------------------------------------------------------------------------------------------
+void SoftwareRenderDevice::rasterizeTile(uint32_t tile, uint64_t& shaded, uint64_t& written) const
+{
+	const int32_t tileX = static_cast<int32_t>((tile % tilesX) * tileSize);
+	const int32_t tileY = static_cast<int32_t>((tile / tilesX) * tileSize);
+	uint32_t* colorBuffer = const_cast<uint32_t*>(color.data());
+	float* depthBuffer = const_cast<float*>(depth.data());
+
+	for (uint32_t index : tileBins[tile])
+	{
+		const Triangle& tri = triangles[index];
+		const DrawState& state = draws[tri.draw];
+		const int32_t x0 = std::max(tri.minX, tileX);
+		const int32_t x1 = std::min(tri.maxX, tileX + static_cast<int32_t>(tileSize) - 1);
+		const int32_t y0 = std::max(tri.minY, tileY);
+		const int32_t y1 = std::min(tri.maxY, tileY + static_cast<int32_t>(tileSize) - 1);
+		const int32_t xStart = x0 & ~7;
+
+#if defined(__AVX2__)
+		const __m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		for (int32_t y{ y0 }; y <= y1; y++)
+		{
+			const double centerY = y + 0.5;
+			float rowEdge[3];
+			for (int e{ 0 }; e < 3; e++)
+			{
+				rowEdge[e] = static_cast<float>(tri.edgeA[e] * (xStart + 0.5) + tri.edgeB[e] * centerY + tri.edgeC[e]);
+			}
+			const __m256 py = _mm256_set1_ps(static_cast<float>(centerY));
+
+			for (int32_t x{ xStart }; x <= x1; x += 8)
+			{
+				//Lanes inside [x0, x1]
+				__m256i lane = _mm256_add_epi32(laneIndices, _mm256_set1_epi32(x));
+				__m256i inRange = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(x0), lane), _mm256_cmpgt_epi32(_mm256_set1_epi32(x1 + 1), lane));
+				__m256 mask = _mm256_castsi256_ps(inRange);
+
+				const __m256 step = _mm256_add_ps(laneOffsets, _mm256_set1_ps(static_cast<float>(x - xStart)));
+				for (int e{ 0 }; e < 3; e++)
+				{
+					__m256 edge = _mm256_add_ps(_mm256_set1_ps(rowEdge[e]), _mm256_mul_ps(_mm256_set1_ps(tri.edgeA[e]), step));
+					mask = _mm256_and_ps(mask, tri.edgeInclusive[e] ? _mm256_cmp_ps(edge, zero, _CMP_GE_OQ) : _mm256_cmp_ps(edge, zero, _CMP_GT_OQ));
+				}
+				if (_mm256_movemask_ps(mask) == 0)
+				{
+					continue;
+				}
+
+				//Depth test LESS against [0, 1] clipped depth
+				const __m256 px = _mm256_add_ps(step, _mm256_set1_ps(xStart + 0.5f));
+				float* depthRow = depthBuffer + size_t{ pitch } * y + x;
+				__m256 storedDepth = _mm256_loadu_ps(depthRow);
+				__m256 z = evaluatePlane(tri.depth, px, py);
+				mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, storedDepth, _CMP_LT_OQ));
+				mask = _mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(z, zero, _CMP_GE_OQ), _mm256_cmp_ps(z, one, _CMP_LE_OQ)));
+				int covered = _mm256_movemask_ps(mask);
+				if (covered == 0)
+				{
+					continue;
+				}
+				shaded += _mm_popcnt_u32(static_cast<unsigned int>(covered));
+
+				//Perspective correct attributes
+				__m256 w = _mm256_div_ps(one, evaluatePlane(tri.invW, px, py));
+				__m256 attributes[8];
+				for (int k{ 0 }; k < 8; k++)
+				{
+					attributes[k] = _mm256_mul_ps(evaluatePlane(tri.attributes[k], px, py), w);
+				}
+
+				__m256 pixelColor[4];
+				mask = _mm256_and_ps(mask, shadePixel8(state, attributes, pixelColor));
+				int kept = _mm256_movemask_ps(mask);
+				if (kept == 0)
+				{
+					continue;
+				}
+				written += _mm_popcnt_u32(static_cast<unsigned int>(kept));
+
+				_mm256_storeu_ps(depthRow, _mm256_blendv_ps(storedDepth, z, mask));
+				uint32_t* colorRow = colorBuffer + size_t{ pitch } * y + x;
+				__m256i dst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(colorRow));
+				__m256i blended = blendPixels8(pixelColor, dst, state.alphaBlend);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(colorRow), _mm256_blendv_epi8(dst, blended, _mm256_castps_si256(mask)));
+			}
+		}
+#else
+		for (int32_t y{ y0 }; y <= y1; y++)
+		{
+			const float py = y + 0.5f;
+			for (int32_t x{ x0 }; x <= x1; x++)
+			{
+				const float px = x + 0.5f;
+				bool inside{ true };
+				for (int e{ 0 }; e < 3; e++)
+				{
+					float edge = static_cast<float>(tri.edgeA[e] * (xStart + 0.5) + tri.edgeB[e] * double{ py } + tri.edgeC[e]) + tri.edgeA[e] * (x - xStart);
+					inside &= tri.edgeInclusive[e] ? edge >= 0.0f : edge > 0.0f;
+				}
+				if (!inside)
+				{
+					continue;
+				}
+
+				float& storedDepth = depthBuffer[size_t{ pitch } * y + x];
+				float z = tri.depth.a * px + tri.depth.b * py + tri.depth.c;
+				if (!(z < storedDepth && z >= 0.0f && z <= 1.0f))
+				{
+					continue;
+				}
+				shaded++;
+
+				float w = 1.0f / (tri.invW.a * px + tri.invW.b * py + tri.invW.c);
+				float attributes[8];
+				for (int k{ 0 }; k < 8; k++)
+				{
+					attributes[k] = (tri.attributes[k].a * px + tri.attributes[k].b * py + tri.attributes[k].c) * w;
+				}
+
+				float pixelColor[4];
+				if (!shadePixel(state, attributes, pixelColor))
+				{
+					continue;
+				}
+				written++;
+
+				storedDepth = z;
+				uint32_t& dst = colorBuffer[size_t{ pitch } * y + x];
+				dst = blendPixel(pixelColor, dst, state.alphaBlend);
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,224 @@
+#pragma once
+#include "NullRenderDevice.h"
+#include "ShaderConstants.h"
+#include "ThreadPool.h"
+#include "Parallel.h"
+
+//Counters of the software rasterizer since the last resetRasterStats
+struct SoftwareRasterStats
+{
+	uint64_t trianglesSubmitted{ 0 };	//index count / 3 over all draws and instances
+	uint64_t trianglesRasterized{ 0 };	//left after clipping, culling and zero area rejection
+	uint64_t pixelsShaded{ 0 };			//passed the depth test and were run through the pixel shader
+	uint64_t pixelsWritten{ 0 };		//survived alpha clip
+	int64_t setupNanoseconds{ 0 };		//vertex stage, clipping, triangle setup and binning
+	int64_t rasterNanoseconds{ 0 };		//tile rasterization and shading
+
+	double trianglesPerSecond() const;
+	double pixelsPerSecond() const;
+};
+
+//Light terms of Box.hlsl evaluated by the software pixel shader
+enum SoftwareLights : uint32_t
+{
+	SOFTWARE_LIGHT_DIRECTIONAL = 1 << 0,
+	SOFTWARE_LIGHT_POINT = 1 << 1,
+	SOFTWARE_LIGHT_SPOT = 1 << 2
+};
+
+class SoftwareRenderDevice;
+
+//Context that draws through the software rasterizer
+//Bound shaders are ignored: draws always run the C++ port of Box.hlsl, the instanced
+//variant when the input layout has per instance elements. Constant buffer slot 0 is
+//read as cbufferPerObject, pixel shader slot 1 as cbufferPerFrame. Structured buffers are
+//ignored, so clustered point and spot lights are not shaded
+class SoftwareRenderContext : public NullRenderContext
+{
+public:
+
+	explicit SoftwareRenderContext(SoftwareRenderDevice& device);
+
+	void clear(const float color[4], float depth, uint8_t stencil) override;
+	void setViewport(const Viewport& viewport) override;
+	void setBlendState(BlendStateHandle state) override;
+
+	void setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[]) override;
+	void setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) override;
+	void setInputLayout(InputLayoutHandle layout) override;
+
+	void setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+	void setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture) override;
+	void setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler) override;
+
+	void setRasterizerState(RasterizerStateHandle state) override;
+
+	void drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+	//Lists run from default state and leave it behind, like ExecuteCommandList(FALSE)
+	void executeCommandList(ICommandList& commandList) override;
+
+private:
+
+	struct VertexStream
+	{
+		BufferHandle buffer;
+		uint32_t stride{ 0 };
+		uint32_t offset{ 0 };
+	};
+
+	struct ConstantBinding
+	{
+		BufferHandle buffer;
+		uint32_t firstConstant{ 0 };
+	};
+
+	void draw(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance);
+	void resetState();
+	const uint8_t* constants(const ConstantBinding& binding, size_t size);
+
+	SoftwareRenderDevice& device;
+
+	VertexStream vertexStreams[2];
+	BufferHandle indexBuffer;
+	IndexFormat indexFormat{ IndexFormat::UInt32 };
+	uint32_t indexOffset{ 0 };
+	InputLayoutHandle inputLayout;
+	ConstantBinding vsConstants;
+	ConstantBinding psConstants[2];
+	TextureHandle texture;
+	SamplerHandle sampler;
+	RasterizerStateHandle rasterizerState;
+	BlendStateHandle blendState;
+};
+
+//Reference backend rasterizing on the CPU, for golden images and machines without a GPU
+//Draws are transformed, clipped against the near plane, set up and binned into
+//64x64 screen tiles on the submitting thread. Binned triangles are rasterized when the
+//frame is presented (or read back): tiles are shared out to worker threads which walk
+//their triangles in submission order, so blending and depth ties resolve exactly as a
+//single threaded rasterizer would. Coverage, depth, perspective correct interpolation,
+//texture sampling and lighting run 8 pixels at a time with AVX2, with a scalar
+//fallback for other builds.
+//Pipeline state follows the D3D11 defaults the app relies on: depth test LESS with
+//writes, null rasterizer state culls back faces (clockwise is front), top-left fill
+//rule with 8 bit sub pixel precision. Samplers filter bilinearly from the first mip
+class SoftwareRenderDevice : public NullRenderDevice
+{
+public:
+
+	static constexpr uint32_t tileSize{ 64 };
+
+	explicit SoftwareRenderDevice(unsigned int numThreads = workerThreadCount());
+
+	TextureHandle createTexture(const TextureDesc& desc, const void* pixels, uint32_t rowPitch) override;
+	void destroyTexture(TextureHandle texture) override;
+
+	void resize(uint32_t width, uint32_t height) override;
+	void present(uint32_t syncInterval) override;
+
+	//Rasterizes everything drawn so far
+	void flush();
+
+	//Flushes and copies the back buffer, e.g. to compare against a golden image
+	void copyBackBuffer(CpuImage& image);
+	float depthAt(uint32_t x, uint32_t y);
+
+	void setEnabledLights(uint32_t lights) { enabledLights = lights; }
+	uint32_t threadCount() const { return rasterWorkers + 1; }
+
+	const SoftwareRasterStats& rasterStats() const { return stats; }
+	void resetRasterStats() { stats = SoftwareRasterStats{}; }
+
+	//Pipeline data, public for the rasterizer functions in SoftwareRenderDevice.cpp
+	struct ShadedVertex
+	{
+		float clip[4];
+		float attributes[8];	//world position, world normal, texture coordinates
+	};
+
+	//a * x + b * y + c over screen pixel coordinates
+	struct Plane
+	{
+		float a;
+		float b;
+		float c;
+	};
+
+	//Light colors premultiplied by the material, directions normalized
+	struct LightTerms
+	{
+		float ambient[3];
+		float diffuse[3];
+		float specular[3];
+		float position[3];
+		float range;
+		float att[3];
+		float direction[3];
+		float spotPower;
+	};
+
+	//Everything the pixel shader reads, captured when the draw is submitted
+	struct DrawState
+	{
+		LightTerms dirLight;
+		LightTerms pointLight;
+		LightTerms spotLight;
+		float viewPos[3];
+		float specPower;
+		float diffuseAlpha;
+		uint32_t lights;
+		bool useTexture;
+		bool clipAlpha;
+		bool alphaBlend;
+		const TextureData* texture;	//valid until the next flush, texture creation flushes first
+		SamplerDesc sampler;
+	};
+
+	struct Triangle
+	{
+		float edgeA[3];
+		float edgeB[3];
+		double edgeC[3];
+		bool edgeInclusive[3];	//top-left edges include pixel centers exactly on the edge
+		Plane depth;
+		Plane invW;
+		Plane attributes[8];	//attribute / w
+		int32_t minX;
+		int32_t minY;
+		int32_t maxX;			//inclusive
+		int32_t maxY;
+		uint32_t draw;
+	};
+
+private:
+
+	friend class SoftwareRenderContext;
+
+	void submitTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, CullMode cullMode, bool frontCounterClockwise);
+	void setupTriangle(const ShadedVertex* const vertices[3], CullMode cullMode, bool frontCounterClockwise);
+	void rasterizeTile(uint32_t tile, uint64_t& shaded, uint64_t& written) const;
+
+	SoftwareRenderContext softwareContext;
+	ThreadPool pool;
+	uint32_t rasterWorkers;	//the pool keeps at least one worker, a single thread device never uses it
+
+	Viewport viewport{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	uint32_t enabledLights{ SOFTWARE_LIGHT_DIRECTIONAL };	//Box.hlsl has the point and spot light commented out
+
+	//Back buffer as packed RGBA8 and float depth, rows padded to a multiple of 8 pixels
+	uint32_t pitch{ 0 };
+	std::vector<uint32_t> color;
+	std::vector<float> depth;
+
+	uint32_t tilesX{ 0 };
+	uint32_t tilesY{ 0 };
+	std::vector<DrawState> draws;
+	std::vector<Triangle> triangles;
+	std::vector<std::vector<uint32_t>> tileBins;
+	std::vector<ShadedVertex> shadedVertices;
+	std::vector<ShadedVertex> clipped;
+
+	SoftwareRasterStats stats;
+};
@@ -0,0 +1,195 @@
+#include "StateCache.h"
+#include <algorithm>
+
+//---------------------------------------------------------------------------------------------------
+void StateCache::updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size)
+{
+	issue(false);
+	target.updateBuffer(buffer, offset, data, size);
+}
+
+//-----------------------------------------------------------
+void* StateCache::mapBuffer(BufferHandle buffer, MapMode mode)
+{
+	issue(false);
+	return target.mapBuffer(buffer, mode);
+}
+
+//----------------------------------------------
+void StateCache::unmapBuffer(BufferHandle buffer)
+{
+	issue(false);
+	target.unmapBuffer(buffer);
+}
+
+//-----------------------------------------------------------------------
+void StateCache::clear(const float color[4], float depth, uint8_t stencil)
+{
+	issue(false);
+	target.clear(color, depth, stencil);
+}
+
+//-------------------------------------------------------
+void StateCache::setViewport(const Viewport& viewport)
+{
+	if (issue(state.viewport.matches({ viewport })))
+	{
+		target.setViewport(viewport);
+	}
+}
+
+//-----------------------------------------------------
+void StateCache::setBlendState(BlendStateHandle blendState)
+{
+	if (issue(state.blendState.matches(blendState)))
+	{
+		target.setBlendState(blendState);
+	}
+}
+
+//Only the range between the first and last changed slot is forwarded
+//------------------------------------------------------------------------------------------------------------------------------------------
+void StateCache::setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[])
+{
+	uint32_t first{ count };
+	uint32_t last{ 0 };
+	for (uint32_t i{ 0 }; i < count; i++)
+	{
+		uint32_t slot = startSlot + i;
+		bool bound = slot < maxVertexStreams && state.vertexStreams[slot].matches({ buffers[i], strides[i], offsets[i] });
+		if (!bound)
+		{
+			first = std::min(first, i);
+			last = i;
+		}
+	}
+
+	if (issue(first == count))
+	{
+		target.setVertexBuffers(startSlot + first, last - first + 1, buffers + first, strides + first, offsets + first);
+	}
+}
+
+//----------------------------------------------------------------------------------
+void StateCache::setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset)
+{
+	if (issue(state.indexBuffer.matches({ buffer, format, offset })))
+	{
+		target.setIndexBuffer(buffer, format, offset);
+	}
+}
+
+//--------------------------------------------------------
+void StateCache::setInputLayout(InputLayoutHandle layout)
+{
+	if (issue(state.inputLayout.matches(layout)))
+	{
+		target.setInputLayout(layout);
+	}
+}
+
+//--------------------------------------------------------------------
+void StateCache::setPrimitiveTopology(PrimitiveTopology topology)
+{
+	if (issue(state.topology.matches(topology)))
+	{
+		target.setPrimitiveTopology(topology);
+	}
+}
+
+//-----------------------------------------------------------
+void StateCache::setVertexShader(VertexShaderHandle shader)
+{
+	if (issue(state.vertexShader.matches(shader)))
+	{
+		target.setVertexShader(shader);
+	}
+}
+
+//---------------------------------------------------------
+void StateCache::setPixelShader(PixelShaderHandle shader)
+{
+	if (issue(state.pixelShader.matches(shader)))
+	{
+		target.setPixelShader(shader);
+	}
+}
+
+//--------------------------------------------------------------------------------------------------------------------------------
+void StateCache::setConstantBuffer(ShaderStage shaderStage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+{
+	bool bound = slot < maxConstantBuffers && stage(shaderStage).constantBuffers[slot].matches({ buffer, firstConstant, numConstants });
+	if (issue(bound))
+	{
+		target.setConstantBuffer(shaderStage, slot, buffer, firstConstant, numConstants);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void StateCache::setTexture(ShaderStage shaderStage, uint32_t slot, TextureHandle texture)
+{
+	bool bound = slot < maxTextures && stage(shaderStage).textures[slot].matches(texture);
+	if (issue(bound))
+	{
+		if (slot < maxTextures)
+		{
+			stage(shaderStage).structuredBuffers[slot].known = false;
+		}
+		target.setTexture(shaderStage, slot, texture);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+void StateCache::setStructuredBuffer(ShaderStage shaderStage, uint32_t slot, BufferHandle buffer)
+{
+	bool bound = slot < maxTextures && stage(shaderStage).structuredBuffers[slot].matches(buffer);
+	if (issue(bound))
+	{
+		if (slot < maxTextures)
+		{
+			stage(shaderStage).textures[slot].known = false;
+		}
+		target.setStructuredBuffer(shaderStage, slot, buffer);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void StateCache::setSampler(ShaderStage shaderStage, uint32_t slot, SamplerHandle sampler)
+{
+	bool bound = slot < maxSamplers && stage(shaderStage).samplers[slot].matches(sampler);
+	if (issue(bound))
+	{
+		target.setSampler(shaderStage, slot, sampler);
+	}
+}
+
+//-------------------------------------------------------------------
+void StateCache::setRasterizerState(RasterizerStateHandle rasterizerState)
+{
+	if (issue(state.rasterizerState.matches(rasterizerState)))
+	{
+		target.setRasterizerState(rasterizerState);
+	}
+}
+
+//---------------------------------------------------------------------------------------
+void StateCache::drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+	issue(false);
+	target.drawIndexed(indexCount, startIndex, baseVertex);
+}
+
+//-------------------------------------------------------------------------------------------------------------------------------------------------
+void StateCache::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+	issue(false);
+	target.drawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+//-------------------------------------------------------------------
+void StateCache::executeCommandList(ICommandList& commandList)
+{
+	issue(false);
+	target.executeCommandList(commandList);
+	invalidate();
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include "RenderDevice.h"
+
+//Calls forwarded to and dropped by a StateCache since the last resetStats
+struct StateCacheStats
+{
+	uint64_t issued{ 0 };	//every forwarded call, draws and resource updates included
+	uint64_t elided{ 0 };	//Set* calls that matched the tracked state
+
+	uint64_t total() const { return issued + elided; }
+};
+
+//Redundant state filter in front of another context
+//Remembers the pipeline state bound through it, per stage and slot, and drops Set* calls
+//that would bind what is already bound. Works over any backend, so the savings can be
+//measured against the recording NullRenderContext.
+//State is unknown until first set, and must be forgotten with invalidate() when
+//something else touches the underlying context (e.g. a device resize resets the viewport).
+//Destroying a bound resource needs nothing: the handle of whatever reuses its slot differs
+//by generation (RenderDevice.h), so binding it is never taken as redundant
+class StateCache : public IRenderContext
+{
+public:
+
+	static constexpr uint32_t maxVertexStreams{ 4 };
+	static constexpr uint32_t maxConstantBuffers{ 4 };
+	static constexpr uint32_t maxTextures{ 8 };
+	static constexpr uint32_t maxSamplers{ 4 };
+
+	explicit StateCache(IRenderContext& target) : target{ target } {}
+
+	void updateBuffer(BufferHandle buffer, uint32_t offset, const void* data, size_t size) override;
+	void* mapBuffer(BufferHandle buffer, MapMode mode) override;
+	void unmapBuffer(BufferHandle buffer) override;
+
+	void clear(const float color[4], float depth, uint8_t stencil) override;
+	void setViewport(const Viewport& viewport) override;
+	void setBlendState(BlendStateHandle blendState) override;
+
+	void setVertexBuffers(uint32_t startSlot, uint32_t count, const BufferHandle buffers[], const uint32_t strides[], const uint32_t offsets[]) override;
+	void setIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) override;
+	void setInputLayout(InputLayoutHandle layout) override;
+	void setPrimitiveTopology(PrimitiveTopology topology) override;
+
+	void setVertexShader(VertexShaderHandle shader) override;
+	void setPixelShader(PixelShaderHandle shader) override;
+	void setConstantBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+	void setTexture(ShaderStage stage, uint32_t slot, TextureHandle texture) override;
+	void setStructuredBuffer(ShaderStage stage, uint32_t slot, BufferHandle buffer) override;
+	void setSampler(ShaderStage stage, uint32_t slot, SamplerHandle sampler) override;
+
+	void setRasterizerState(RasterizerStateHandle rasterizerState) override;
+
+	void drawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+	//Executing a list resets the target's state, so everything is forgotten afterwards
+	void executeCommandList(ICommandList& commandList) override;
+
+	//Forgets all tracked state, the next Set* of everything is forwarded
+	void invalidate() { state = PipelineState{}; }
+
+	const StateCacheStats& stats() const { return cacheStats; }
+	void resetStats() { cacheStats = StateCacheStats{}; }
+
+private:
+
+	//A tracked value and whether it is known
+	template <typename Value>
+	struct Tracked
+	{
+		Value value{};
+		bool known{ false };
+
+		//True when value is already bound, otherwise remembers it
+		bool matches(const Value& newValue)
+		{
+			if (known && value == newValue)
+			{
+				return true;
+			}
+			value = newValue;
+			known = true;
+			return false;
+		}
+	};
+
+	struct VertexStream
+	{
+		BufferHandle buffer;
+		uint32_t stride;
+		uint32_t offset;
+
+		bool operator==(const VertexStream& other) const { return buffer == other.buffer && stride == other.stride && offset == other.offset; }
+	};
+
+	struct IndexBinding
+	{
+		BufferHandle buffer;
+		IndexFormat format;
+		uint32_t offset;
+
+		bool operator==(const IndexBinding& other) const { return buffer == other.buffer && format == other.format && offset == other.offset; }
+	};
+
+	struct ConstantBinding
+	{
+		BufferHandle buffer;
+		uint32_t firstConstant;
+		uint32_t numConstants;
+
+		bool operator==(const ConstantBinding& other) const
+		{
+			return buffer == other.buffer && firstConstant == other.firstConstant && numConstants == other.numConstants;
+		}
+	};
+
+	struct ViewportBinding
+	{
+		Viewport viewport;
+
+		bool operator==(const ViewportBinding& other) const
+		{
+			const Viewport& a = viewport;
+			const Viewport& b = other.viewport;
+			return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height && a.minDepth == b.minDepth && a.maxDepth == b.maxDepth;
+		}
+	};
+
+	//Shader resources of one stage
+	struct StageState
+	{
+		Tracked<ConstantBinding> constantBuffers[maxConstantBuffers];
+		Tracked<TextureHandle> textures[maxTextures];
+		Tracked<BufferHandle> structuredBuffers[maxTextures];	//same t registers, binding one forgets the other
+		Tracked<SamplerHandle> samplers[maxSamplers];
+	};
+
+	struct PipelineState
+	{
+		Tracked<ViewportBinding> viewport;
+		Tracked<BlendStateHandle> blendState;
+		Tracked<RasterizerStateHandle> rasterizerState;
+		Tracked<VertexStream> vertexStreams[maxVertexStreams];
+		Tracked<IndexBinding> indexBuffer;
+		Tracked<InputLayoutHandle> inputLayout;
+		Tracked<PrimitiveTopology> topology;
+		Tracked<VertexShaderHandle> vertexShader;
+		Tracked<PixelShaderHandle> pixelShader;
+		StageState stages[2];	//indexed by ShaderStage
+	};
+
+	//Counts the call and tells whether to forward it
+	bool issue(bool redundant)
+	{
+		if (redundant)
+		{
+			cacheStats.elided++;
+			return false;
+		}
+		cacheStats.issued++;
+		return true;
+	}
+
+	StageState& stage(ShaderStage shaderStage) { return state.stages[static_cast<size_t>(shaderStage)]; }
+
+	IRenderContext& target;
+	PipelineState state;
+	StateCacheStats cacheStats;
+};
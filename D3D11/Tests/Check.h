@@ -0,0 +1,51 @@
+#pragma once
+//Minimal test helpers, each test is its own executable registered with ctest
+//CHECK records a failure and keeps going; main returns checkResult() so ctest sees the count
+#include <cmath>
+#include <cstdio>
+
+inline int& checkFailures()
+{
+	static int failures{ 0 };
+	return failures;
+}
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			checkFailures()++; \
+		} \
+	} while (false)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do \
+	{ \
+		const double checkA = static_cast<double>(a); \
+		const double checkB = static_cast<double>(b); \
+		if (!(std::fabs(checkA - checkB) <= static_cast<double>(tolerance))) \
+		{ \
+			std::printf("%s:%d: CHECK_NEAR(%s, %s) failed, %g vs %g\n", __FILE__, __LINE__, #a, #b, checkA, checkB); \
+			checkFailures()++; \
+		} \
+	} while (false)
+
+//Runs one test function and reports it
+#define RUN_TEST(test) \
+	do \
+	{ \
+		const int checkBefore = checkFailures(); \
+		test(); \
+		std::printf("%s %s\n", checkFailures() == checkBefore ? "[pass]" : "[FAIL]", #test); \
+	} while (false)
+
+inline int checkResult()
+{
+	if (checkFailures() != 0)
+	{
+		std::printf("%d check(s) failed\n", checkFailures());
+	}
+	return checkFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+//AssetLoader: device thread callbacks, failures, callback limits, and decoding the FireAnim frames
+#include "Check.h"
+#include "AssetLoader.h"
+#include "Flipbook.h"
+#include <thread>
+
+namespace
+{
+	//Decoder that fails for names starting with "bad" and otherwise makes a 1x1 image
+	//-------------------------------------------------------
+	bool fakeDecoder(const std::string& fileName, CpuImage& image)
+	{
+		if (fileName.compare(0, 3, "bad") == 0)
+		{
+			return false;
+		}
+		image.width = 1;
+		image.height = 1;
+		image.pixels.assign(4, static_cast<uint8_t>(fileName.size()));
+		return true;
+	}
+
+	//Callbacks run only inside processCompleted, on the calling thread, once per load
+	//-------------------------------------------------------
+	void testCallbacksOnCallingThread()
+	{
+		AssetLoader loader{ 4 };
+		const std::thread::id deviceThread = std::this_thread::get_id();
+		int callbacks{ 0 };
+		int wrongThread{ 0 };
+		std::vector<ImageHandle> handles;
+		for (int i{ 0 }; i < 50; i++)
+		{
+			handles.push_back(loader.loadImage(std::string(static_cast<size_t>(i + 1), 'x'), [&](const ImagePtr& image)
+			{
+				callbacks++;
+				wrongThread += std::this_thread::get_id() != deviceThread || image == nullptr;
+			}, fakeDecoder));
+		}
+		for (ImageHandle& handle : handles)
+		{
+			handle.wait();
+		}
+		CHECK(callbacks == 0);
+		CHECK(loader.pendingCount() == 50);
+
+		CHECK(loader.processCompleted() == 50);
+		CHECK(callbacks == 50);
+		CHECK(wrongThread == 0);
+		CHECK(loader.pendingCount() == 0);
+		CHECK(handles[9].get()->pixels[0] == 10);
+	}
+
+	//A failed decode hands nullptr to both the future and the callback
+	//-------------------------------------------------------
+	void testFailure()
+	{
+		AssetLoader loader{ 2 };
+		bool called{ false };
+		ImagePtr received = std::make_shared<CpuImage>();
+		ImageHandle handle = loader.loadImage("bad.bmp", [&](const ImagePtr& image) { called = true; received = image; }, fakeDecoder);
+		CHECK(handle.get() == nullptr);
+		CHECK(loader.processCompleted() == 1);
+		CHECK(called && received == nullptr);
+
+		CHECK(loader.loadImage("Images/DoesNotExist.bmp").get() == nullptr);
+		CHECK(loader.processCompleted() == 1);
+	}
+
+	//maxCallbacks spreads device work over several frames
+	//-------------------------------------------------------
+	void testCallbackLimit()
+	{
+		AssetLoader loader{ 2 };
+		std::vector<ImageHandle> handles;
+		for (int i{ 0 }; i < 10; i++)
+		{
+			handles.push_back(loader.loadImage("frame", nullptr, fakeDecoder));
+		}
+		for (ImageHandle& handle : handles)
+		{
+			handle.wait();
+		}
+		CHECK(loader.processCompleted(4) == 4);
+		CHECK(loader.pendingCount() == 6);
+		CHECK(loader.processCompleted(4) == 4);
+		CHECK(loader.processCompleted(4) == 2);
+		CHECK(loader.processCompleted() == 0);
+	}
+
+	//The real frames decode on the pool and pack into one atlas
+	//-------------------------------------------------------
+	void testFireAnimFrames()
+	{
+		AssetLoader loader{ 4 };
+		std::vector<ImageHandle> handles;
+		for (const std::string& fileName : flipbookFrameFileNames("Images/FireAnim/Fire", 120, ".bmp"))
+		{
+			handles.push_back(loader.loadImage(fileName));
+		}
+		std::vector<const CpuImage*> frames;
+		for (ImageHandle& handle : handles)
+		{
+			const ImagePtr& image = handle.get();
+			CHECK(image != nullptr);
+			if (image != nullptr)
+			{
+				frames.push_back(image.get());
+			}
+		}
+		Flipbook flipbook;
+		CHECK(frames.size() == 120 && flipbook.pack(frames.data(), frames.size()));
+		CHECK(flipbook.frameCount() == 120);
+		loader.processCompleted();
+	}
+
+	//Jobs still queued when the pool is destroyed run before it returns
+	//-------------------------------------------------------
+	void testPoolDrainsOnDestruction()
+	{
+		std::atomic<int> ran{ 0 };
+		{
+			ThreadPool pool{ 2 };
+			for (int i{ 0 }; i < 100; i++)
+			{
+				pool.submit([&ran]() { ran++; });
+			}
+		}
+		CHECK(ran == 100);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testCallbacksOnCallingThread);
+	RUN_TEST(testFailure);
+	RUN_TEST(testCallbackLimit);
+	RUN_TEST(testFireAnimFrames);
+	RUN_TEST(testPoolDrainsOnDestruction);
+	return checkResult();
+}
@@ -0,0 +1,189 @@
+//BVH queries against brute force, serial and parallel builds, refit and the node layout invariants
+#include "Check.h"
+#include "BVH.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	//Boxes of mixed sizes, with a cluster of identical boxes so some splits cannot separate centroids
+	//-------------------------------------------------------
+	std::vector<AABB> randomBoxes(size_t count, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+		std::uniform_real_distribution<float> extent{ 0.0f, 4.0f };
+		std::vector<AABB> boxes(count);
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			XMFLOAT3 center{ position(random), position(random) * 0.2f, position(random) };
+			if (i % 10 == 0)
+			{
+				center = XMFLOAT3{ 5.0f, 5.0f, 5.0f };
+			}
+			const float e{ extent(random) };
+			boxes[i] = AABB{ { center.x - e, center.y - e, center.z - e }, { center.x + e, center.y + e, center.z + e } };
+		}
+		return boxes;
+	}
+
+	//-------------------------------------------------------
+	Frustum testFrustum()
+	{
+		const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(-20.0f, 10.0f, -60.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 120.0f);
+		return extractFrustumPlanes(XMMatrixMultiply(view, proj));
+	}
+
+	//-------------------------------------------------------
+	bool overlapsSphere(const AABB& box, const XMFLOAT3& center, float radius)
+	{
+		const float dx = std::max(std::max(box.aabbMin.x - center.x, 0.0f), center.x - box.aabbMax.x);
+		const float dy = std::max(std::max(box.aabbMin.y - center.y, 0.0f), center.y - box.aabbMax.y);
+		const float dz = std::max(std::max(box.aabbMin.z - center.z, 0.0f), center.z - box.aabbMax.z);
+		return dx * dx + dy * dy + dz * dz <= radius * radius;
+	}
+
+	//-------------------------------------------------------
+	bool overlaps(const AABB& a, const AABB& b)
+	{
+		return a.aabbMin.x <= b.aabbMax.x && a.aabbMax.x >= b.aabbMin.x &&
+			a.aabbMin.y <= b.aabbMax.y && a.aabbMax.y >= b.aabbMin.y &&
+			a.aabbMin.z <= b.aabbMax.z && a.aabbMax.z >= b.aabbMin.z;
+	}
+
+	//Runs all three queries on the tree and by brute force and compares the sorted index lists
+	//-------------------------------------------------------
+	void checkQueries(const BVH& bvh, const std::vector<AABB>& boxes)
+	{
+		const Frustum frustum = testFrustum();
+		const XMFLOAT3 sphereCenter{ 10.0f, 0.0f, -5.0f };
+		const float sphereRadius{ 30.0f };
+		const AABB queryBox{ { -40.0f, -5.0f, 0.0f }, { 5.0f, 5.0f, 60.0f } };
+
+		std::vector<uint32_t> expectedFrustum, expectedSphere, expectedBox;
+		for (uint32_t i{ 0 }; i < boxes.size(); i++)
+		{
+			if (aabbInFrustum(frustum, boxes[i].aabbMin, boxes[i].aabbMax))
+			{
+				expectedFrustum.push_back(i);
+			}
+			if (overlapsSphere(boxes[i], sphereCenter, sphereRadius))
+			{
+				expectedSphere.push_back(i);
+			}
+			if (overlaps(boxes[i], queryBox))
+			{
+				expectedBox.push_back(i);
+			}
+		}
+
+		std::vector<uint32_t> found;
+		bvh.queryFrustum(frustum, found);
+		std::sort(found.begin(), found.end());
+		CHECK(found == expectedFrustum);
+
+		found.clear();
+		bvh.querySphere(sphereCenter, sphereRadius, found);
+		std::sort(found.begin(), found.end());
+		CHECK(found == expectedSphere);
+
+		found.clear();
+		bvh.queryAABB(queryBox, found);
+		std::sort(found.begin(), found.end());
+		CHECK(found == expectedBox);
+	}
+
+	//Children come after their parent and lie inside its bounds; every primitive is in exactly one leaf
+	//-------------------------------------------------------
+	void checkLayout(const BVH& bvh, const std::vector<AABB>& boxes)
+	{
+		const BVHNode* nodes = bvh.nodeData();
+		int badNodes{ 0 };
+		for (size_t i{ 0 }; i < bvh.nodeCount() && !boxes.empty(); i++)
+		{
+			const BVHNode& node = nodes[i];
+			if (node.count > 0)
+			{
+				continue;
+			}
+			for (uint32_t child : { node.leftFirst, node.leftFirst + 1 })
+			{
+				const BVHNode& c = nodes[child];
+				badNodes += child <= i || child >= bvh.nodeCount() ||
+					c.aabbMin.x < node.aabbMin.x || c.aabbMin.y < node.aabbMin.y || c.aabbMin.z < node.aabbMin.z ||
+					c.aabbMax.x > node.aabbMax.x || c.aabbMax.y > node.aabbMax.y || c.aabbMax.z > node.aabbMax.z;
+			}
+		}
+		CHECK(badNodes == 0);
+		CHECK(bvh.nodeCount() <= std::max<size_t>(1, 2 * boxes.size() - 1));
+
+		std::vector<uint32_t> all;
+		bvh.queryAABB(AABB{ { -1e9f, -1e9f, -1e9f }, { 1e9f, 1e9f, 1e9f } }, all);
+		std::sort(all.begin(), all.end());
+		CHECK(all.size() == boxes.size());
+		CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+	}
+
+	//Sizes above minParallelBuildSize take the parallel build path
+	//-------------------------------------------------------
+	void testQueriesMatchBruteForce()
+	{
+		for (size_t count : { size_t{ 0 }, size_t{ 1 }, size_t{ 5 }, size_t{ 1000 }, size_t{ 60000 } })
+		{
+			const std::vector<AABB> boxes = randomBoxes(count, static_cast<uint32_t>(count) + 1);
+			BVH bvh;
+			bvh.build(boxes);
+			CHECK(bvh.primitiveCount() == count);
+			checkLayout(bvh, boxes);
+			checkQueries(bvh, boxes);
+		}
+	}
+
+	//A single worker builds serially and must give the same query results
+	//-------------------------------------------------------
+	void testSerialBuild()
+	{
+		const std::vector<AABB> boxes = randomBoxes(40000, 3);
+		setParallelWorkerCount(1);
+		BVH serial;
+		serial.build(boxes);
+		setParallelWorkerCount(4);
+		checkLayout(serial, boxes);
+		checkQueries(serial, boxes);
+	}
+
+	//Moved boxes are found at their new position after refit
+	//-------------------------------------------------------
+	void testRefit()
+	{
+		std::vector<AABB> boxes = randomBoxes(5000, 4);
+		BVH bvh;
+		bvh.build(boxes);
+
+		std::mt19937 random{ 5 };
+		std::uniform_real_distribution<float> offset{ -30.0f, 30.0f };
+		for (uint32_t i{ 0 }; i < boxes.size(); i += 3)
+		{
+			const XMFLOAT3 move{ offset(random), offset(random), offset(random) };
+			AABB& box = boxes[i];
+			box.aabbMin = XMFLOAT3{ box.aabbMin.x + move.x, box.aabbMin.y + move.y, box.aabbMin.z + move.z };
+			box.aabbMax = XMFLOAT3{ box.aabbMax.x + move.x, box.aabbMax.y + move.y, box.aabbMax.z + move.z };
+			bvh.updatePrimitive(i, box);
+		}
+		bvh.refit();
+		checkLayout(bvh, boxes);
+		checkQueries(bvh, boxes);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	setParallelWorkerCount(4);
+	RUN_TEST(testQueriesMatchBruteForce);
+	RUN_TEST(testSerialBuild);
+	RUN_TEST(testRefit);
+	return checkResult();
+}
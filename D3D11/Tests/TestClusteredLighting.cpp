@@ -0,0 +1,377 @@
+//LightClusterGrid: assignment against a brute force sphere / box test over every cluster,
+//every lit point finding its light in the cluster Box.hlsl looks up, cluster list layout,
+//lights outside the frustum, and the same result on one and on several workers
+#include "Check.h"
+#include "ClusteredLighting.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const uint32_t tilesX{ 16 };
+	const uint32_t tilesY{ 9 };
+	const uint32_t slices{ 24 };
+	const float width{ 1280.0f };
+	const float height{ 720.0f };
+	const float nearZ{ 0.5f };
+	const float farZ{ 200.0f };
+
+	struct Scene
+	{
+		XMFLOAT4X4 view;
+		XMFLOAT4X4 proj;
+		std::vector<PointLight> points;
+		std::vector<SpotLight> spots;
+	};
+
+	//-------------------------------------------------------
+	Scene makeScene(uint32_t pointCount, uint32_t spotCount, uint32_t seed)
+	{
+		Scene scene;
+		XMStoreFloat4x4(&scene.view, XMMatrixLookAtLH(XMVectorSet(3.0f, 6.0f, -20.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 40.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+		XMStoreFloat4x4(&scene.proj, XMMatrixPerspectiveFovLH(0.25f * 3.14159265f, width / height, nearZ, farZ));
+
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> x{ -70.0f, 70.0f };
+		std::uniform_real_distribution<float> y{ -10.0f, 30.0f };
+		std::uniform_real_distribution<float> z{ -40.0f, 220.0f };
+		std::uniform_real_distribution<float> range{ 0.5f, 15.0f };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+		std::uniform_real_distribution<float> power{ 1.0f, 64.0f };
+		scene.points.resize(pointCount);
+		for (PointLight& light : scene.points)
+		{
+			light.lightPos = XMFLOAT3{ x(random), y(random), z(random) };
+			light.range = range(random);
+		}
+		scene.spots.resize(spotCount);
+		for (SpotLight& light : scene.spots)
+		{
+			light.lightPos = XMFLOAT3{ x(random), y(random), z(random) };
+			light.range = range(random);
+			light.lightDir = XMFLOAT3{ unit(random), unit(random), unit(random) };
+			light.spotPower = power(random);
+		}
+		return scene;
+	}
+
+	//-------------------------------------------------------
+	XMFLOAT3 toView(const XMFLOAT4X4& view, const XMFLOAT3& position)
+	{
+		XMFLOAT3 result;
+		XMStoreFloat3(&result, XMVector3TransformCoord(XMLoadFloat3(&position), XMLoadFloat4x4(&view)));
+		return result;
+	}
+
+	//Lights of one kind listed for a cluster, spot = false for point lights
+	//-------------------------------------------------------
+	std::vector<uint32_t> clusterLights(const LightClusterGrid& grid, size_t cluster, bool spot)
+	{
+		const LightCluster& c = grid.lightClusters()[cluster];
+		const uint32_t first = spot ? c.offset + c.pointCount : c.offset;
+		const uint32_t count = spot ? c.spotCount : c.pointCount;
+		return std::vector<uint32_t>(grid.lightIndices().begin() + first, grid.lightIndices().begin() + first + count);
+	}
+
+	//Cluster view space box, worked out from scratch as tile corners at the slice's ends
+	//-------------------------------------------------------
+	void clusterBox(const XMFLOAT4X4& proj, uint32_t i, uint32_t j, uint32_t k, XMFLOAT3& boxMin, XMFLOAT3& boxMax)
+	{
+		const float zNear = nearZ * std::pow(farZ / nearZ, static_cast<float>(k) / slices);
+		const float zFar = nearZ * std::pow(farZ / nearZ, static_cast<float>(k + 1) / slices);
+		const float ndcX[2]{ -1.0f + 2.0f * i / tilesX, -1.0f + 2.0f * (i + 1) / tilesX };
+		const float ndcY[2]{ 1.0f - 2.0f * (j + 1) / tilesY, 1.0f - 2.0f * j / tilesY };
+		boxMin = XMFLOAT3{ 1e30f, 1e30f, zNear };
+		boxMax = XMFLOAT3{ -1e30f, -1e30f, zFar };
+		for (float z : { zNear, zFar })
+		{
+			for (float ndc : ndcX)
+			{
+				boxMin.x = std::min(boxMin.x, ndc * z / proj._11);
+				boxMax.x = std::max(boxMax.x, ndc * z / proj._11);
+			}
+			for (float ndc : ndcY)
+			{
+				boxMin.y = std::min(boxMin.y, ndc * z / proj._22);
+				boxMax.y = std::max(boxMax.y, ndc * z / proj._22);
+			}
+		}
+	}
+
+	//Points spread over the cluster's frustum cell, corners included
+	//-------------------------------------------------------
+	std::vector<XMFLOAT3> cellSamples(const XMFLOAT4X4& proj, uint32_t i, uint32_t j, uint32_t k)
+	{
+		std::vector<XMFLOAT3> samples;
+		const int steps{ 4 };
+		for (int a{ 0 }; a <= steps; a++)
+		{
+			const float z = nearZ * std::pow(farZ / nearZ, (k + static_cast<float>(a) / steps) / slices);
+			for (int b{ 0 }; b <= steps; b++)
+			{
+				const float ndcY = 1.0f - 2.0f * (j + static_cast<float>(b) / steps) / tilesY;
+				for (int c{ 0 }; c <= steps; c++)
+				{
+					const float ndcX = -1.0f + 2.0f * (i + static_cast<float>(c) / steps) / tilesX;
+					samples.push_back(XMFLOAT3{ ndcX * z / proj._11, ndcY * z / proj._22, z });
+				}
+			}
+		}
+		return samples;
+	}
+
+	//-------------------------------------------------------
+	float boxDistance(const XMFLOAT3& p, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+	{
+		const float dx = std::max({ boxMin.x - p.x, 0.0f, p.x - boxMax.x });
+		const float dy = std::max({ boxMin.y - p.y, 0.0f, p.y - boxMax.y });
+		const float dz = std::max({ boxMin.z - p.z, 0.0f, p.z - boxMax.z });
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	//Every cluster a light's sphere clearly reaches into lists it, and no cluster whose box
+	//the sphere clearly misses does; spot lights are a subset of their sphere's clusters.
+	//The box is looser than the cluster's frustum cell, which is what the grid bins against,
+	//so reaching into the cell is checked on points spread over it
+	//-------------------------------------------------------
+	void testBruteForce()
+	{
+		const Scene scene = makeScene(300, 100, 11);
+		LightClusterGrid grid;
+		grid.build(tilesX, tilesY, slices, scene.proj, nearZ, farZ);
+		grid.assign(scene.view, scene.points.data(), scene.points.size(), scene.spots.data(), scene.spots.size());
+		CHECK(grid.clusterCount() == tilesX * tilesY * slices);
+
+		size_t missing{ 0 }, extra{ 0 }, spotOutside{ 0 }, pointOverlaps{ 0 }, spotOverlaps{ 0 }, spotSphereOverlaps{ 0 };
+		for (uint32_t k{ 0 }; k < slices; k++)
+		{
+			for (uint32_t j{ 0 }; j < tilesY; j++)
+			{
+				for (uint32_t i{ 0 }; i < tilesX; i++)
+				{
+					const size_t cluster = (size_t{ k } * tilesY + j) * tilesX + i;
+					XMFLOAT3 boxMin, boxMax;
+					clusterBox(scene.proj, i, j, k, boxMin, boxMax);
+					const std::vector<XMFLOAT3> samples = cellSamples(scene.proj, i, j, k);
+
+					const std::vector<uint32_t> points = clusterLights(grid, cluster, false);
+					for (uint32_t l{ 0 }; l < scene.points.size(); l++)
+					{
+						const XMFLOAT3 position = toView(scene.view, scene.points[l].lightPos);
+						const float distance = boxDistance(position, boxMin, boxMax);
+						const bool listed = std::binary_search(points.begin(), points.end(), l);
+						const float margin = 1e-3f * scene.points[l].range;
+						extra += listed && distance > scene.points[l].range + margin;
+						if (!listed && distance < scene.points[l].range)
+						{
+							const float reach = scene.points[l].range - margin;
+							missing += std::any_of(samples.begin(), samples.end(), [&](const XMFLOAT3& sample)
+							{
+								return XMVectorGetX(XMVector3Length(XMLoadFloat3(&sample) - XMLoadFloat3(&position))) < reach;
+							});
+						}
+					}
+					pointOverlaps += points.size();
+
+					const std::vector<uint32_t> spots = clusterLights(grid, cluster, true);
+					for (uint32_t l : spots)
+					{
+						spotOutside += boxDistance(toView(scene.view, scene.spots[l].lightPos), boxMin, boxMax) > scene.spots[l].range * 1.001f;
+					}
+					for (const SpotLight& spot : scene.spots)
+					{
+						spotSphereOverlaps += boxDistance(toView(scene.view, spot.lightPos), boxMin, boxMax) <= spot.range;
+					}
+					spotOverlaps += spots.size();
+				}
+			}
+		}
+		CHECK(missing == 0);
+		CHECK(extra == 0);
+		CHECK(spotOutside == 0);
+		CHECK(pointOverlaps > 500);
+
+		//The cone test has to earn its keep
+		CHECK(spotOverlaps > 0 && spotOverlaps < spotSphereOverlaps * 3 / 4);
+	}
+
+	//Points a light reaches, inside the frustum, find the light in the cluster Box.hlsl looks
+	//up for them: tile from the pixel, slice from ClusterConstants
+	//-------------------------------------------------------
+	void testLitPointsFindTheirLight()
+	{
+		const Scene scene = makeScene(200, 200, 5);
+		LightClusterGrid grid;
+		grid.build(tilesX, tilesY, slices, scene.proj, nearZ, farZ);
+		grid.assign(scene.view, scene.points.data(), scene.points.size(), scene.spots.data(), scene.spots.size());
+		const ClusterConstants constants = grid.constants(scene.view, width, height);
+
+		std::mt19937 random{ 9 };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+		size_t tested{ 0 }, missed{ 0 };
+		auto check = [&](const XMFLOAT3& pointW, uint32_t light, bool spot)
+		{
+			const float depth = pointW.x * constants.viewDepth.x + pointW.y * constants.viewDepth.y + pointW.z * constants.viewDepth.z + constants.viewDepth.w;
+			const XMFLOAT3 pointV = toView(scene.view, pointW);
+			const float ndcX = pointV.x * scene.proj._11 / pointV.z;
+			const float ndcY = pointV.y * scene.proj._22 / pointV.z;
+			if (depth < nearZ || depth > farZ || std::fabs(ndcX) >= 1.0f || std::fabs(ndcY) >= 1.0f)
+			{
+				return;
+			}
+			const float pixelX = (ndcX + 1.0f) * 0.5f * width;
+			const float pixelY = (1.0f - ndcY) * 0.5f * height;
+			const uint32_t column = std::min(static_cast<uint32_t>(pixelX * constants.clusterScale.x), tilesX - 1);
+			const uint32_t row = std::min(static_cast<uint32_t>(pixelY * constants.clusterScale.y), tilesY - 1);
+			const float slice = std::log(depth) * constants.clusterScale.z + constants.clusterScale.w;
+			const uint32_t k = static_cast<uint32_t>(std::min(std::max(slice, 0.0f), slices - 1.0f));
+			const std::vector<uint32_t> lights = clusterLights(grid, (size_t{ k } * tilesY + row) * tilesX + column, spot);
+			tested++;
+			missed += !std::binary_search(lights.begin(), lights.end(), light);
+		};
+
+		for (uint32_t l{ 0 }; l < scene.points.size(); l++)
+		{
+			const PointLight& light = scene.points[l];
+			for (int sample{ 0 }; sample < 200; sample++)
+			{
+				XMFLOAT3 offset{ unit(random), unit(random), unit(random) };
+				XMStoreFloat3(&offset, XMVector3Normalize(XMLoadFloat3(&offset)) * (light.range * 0.99f * std::cbrt(0.5f + 0.5f * unit(random))));
+				check(XMFLOAT3{ light.lightPos.x + offset.x, light.lightPos.y + offset.y, light.lightPos.z + offset.z }, l, false);
+			}
+		}
+
+		//Spot samples are kept where pow(cos, spotPower) is clearly over the cutoff
+		for (uint32_t l{ 0 }; l < scene.spots.size(); l++)
+		{
+			const SpotLight& light = scene.spots[l];
+			const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light.lightDir));
+			for (int sample{ 0 }; sample < 2000; sample++)
+			{
+				XMVECTOR offset = XMVector3Normalize(XMVectorSet(unit(random), unit(random), unit(random), 0.0f));
+				const float cosine = XMVectorGetX(XMVector3Dot(offset, direction));
+				if (cosine <= 0.0f || std::pow(cosine, light.spotPower) < LightClusterGrid::spotCutoff * 1.1f)
+				{
+					continue;
+				}
+				XMFLOAT3 point;
+				XMStoreFloat3(&point, XMLoadFloat3(&light.lightPos) + offset * (light.range * 0.99f * (0.5f + 0.5f * unit(random))));
+				check(point, l, true);
+			}
+		}
+		CHECK(tested > 5000);
+		CHECK(missed == 0);
+	}
+
+	//Offsets run through the index list in cluster order, indices ascend within a cluster
+	//-------------------------------------------------------
+	void testClusterLayout()
+	{
+		const Scene scene = makeScene(500, 150, 3);
+		LightClusterGrid grid;
+		grid.build(tilesX, tilesY, slices, scene.proj, nearZ, farZ);
+		grid.assign(scene.view, scene.points.data(), scene.points.size(), scene.spots.data(), scene.spots.size());
+
+		uint32_t next{ 0 };
+		bool contiguous{ true }, ascending{ true }, inRange{ true };
+		for (size_t c{ 0 }; c < grid.clusterCount(); c++)
+		{
+			const LightCluster& cluster = grid.lightClusters()[c];
+			contiguous = contiguous && cluster.offset == next;
+			next += cluster.pointCount + cluster.spotCount;
+			const std::vector<uint32_t> points = clusterLights(grid, c, false);
+			const std::vector<uint32_t> spots = clusterLights(grid, c, true);
+			ascending = ascending && std::adjacent_find(points.begin(), points.end(), std::greater_equal<uint32_t>()) == points.end() &&
+				std::adjacent_find(spots.begin(), spots.end(), std::greater_equal<uint32_t>()) == spots.end();
+			inRange = inRange && (points.empty() || points.back() < scene.points.size()) && (spots.empty() || spots.back() < scene.spots.size());
+		}
+		CHECK(contiguous);
+		CHECK(ascending);
+		CHECK(inRange);
+		CHECK(next == grid.lightIndices().size());
+
+		//Reassigning with fewer lights leaves nothing of the last frame behind
+		grid.assign(scene.view, scene.points.data(), 1, nullptr, 0);
+		size_t listed{ 0 };
+		for (const LightCluster& cluster : grid.lightClusters())
+		{
+			listed += cluster.pointCount + cluster.spotCount;
+		}
+		CHECK(listed == grid.lightIndices().size());
+		CHECK(std::all_of(grid.lightIndices().begin(), grid.lightIndices().end(), [](uint32_t index) { return index == 0; }));
+	}
+
+	//Behind the camera, past the far plane, beside the frustum and with no range
+	//-------------------------------------------------------
+	void testOutsideLights()
+	{
+		Scene scene = makeScene(0, 0, 1);
+		XMStoreFloat4x4(&scene.view, XMMatrixIdentity());
+		LightClusterGrid grid;
+		grid.build(tilesX, tilesY, slices, scene.proj, nearZ, farZ);
+
+		const XMFLOAT3 positions[]{ { 0.0f, 0.0f, -5.0f }, { 0.0f, 0.0f, 210.0f }, { 100.0f, 0.0f, 10.0f }, { 0.0f, -40.0f, 50.0f }, { 0.0f, 0.0f, 10.0f } };
+		const float ranges[]{ 4.0f, 9.0f, 5.0f, 5.0f, 0.0f };
+		std::vector<PointLight> points(5);
+		for (size_t i{ 0 }; i < points.size(); i++)
+		{
+			points[i].lightPos = positions[i];
+			points[i].range = ranges[i];
+		}
+		grid.assign(scene.view, points.data(), points.size(), nullptr, 0);
+		CHECK(grid.lightIndices().empty());
+
+		//Just reaching past the near plane, one light is in the first slice only
+		points[0].range = 5.6f;
+		grid.assign(scene.view, points.data(), 1, nullptr, 0);
+		CHECK(!grid.lightIndices().empty());
+		bool firstSliceOnly{ true };
+		for (size_t c{ tilesX * tilesY }; c < grid.clusterCount(); c++)
+		{
+			firstSliceOnly = firstSliceOnly && grid.lightClusters()[c].pointCount == 0;
+		}
+		CHECK(firstSliceOnly);
+	}
+
+	//Slices are split over workers; the result does not depend on how many there are
+	//-------------------------------------------------------
+	void testWorkerInvariance()
+	{
+		const Scene scene = makeScene(2000, 500, 21);
+		LightClusterGrid grid;
+		grid.build(tilesX, tilesY, slices, scene.proj, nearZ, farZ);
+		grid.assign(scene.view, scene.points.data(), scene.points.size(), scene.spots.data(), scene.spots.size());
+		const std::vector<LightCluster> clusters = grid.lightClusters();
+		const std::vector<uint32_t> indices = grid.lightIndices();
+
+		setParallelWorkerCount(1);
+		LightClusterGrid single;
+		single.build(tilesX, tilesY, slices, scene.proj, nearZ, farZ);
+		single.assign(scene.view, scene.points.data(), scene.points.size(), scene.spots.data(), scene.spots.size());
+		setParallelWorkerCount(4);
+
+		CHECK(single.lightIndices() == indices);
+		bool same = single.lightClusters().size() == clusters.size();
+		for (size_t c{ 0 }; same && c < clusters.size(); c++)
+		{
+			const LightCluster& a = clusters[c];
+			const LightCluster& b = single.lightClusters()[c];
+			same = a.offset == b.offset && a.pointCount == b.pointCount && a.spotCount == b.spotCount;
+		}
+		CHECK(same);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	setParallelWorkerCount(4);
+	RUN_TEST(testBruteForce);
+	RUN_TEST(testLitPointsFindTheirLight);
+	RUN_TEST(testClusterLayout);
+	RUN_TEST(testOutsideLights);
+	RUN_TEST(testWorkerInvariance);
+	return checkResult();
+}
@@ -0,0 +1,255 @@
+//ConstantRingAllocator wraparound and fence release, ConstantUploadRing growth and fence waits
+#include "Check.h"
+#include "ConstantRing.h"
+#include "NullRenderDevice.h"
+#include "StateCache.h"
+
+namespace
+{
+	//-------------------------------------------------------
+	void testAllocatorAlignment()
+	{
+		ConstantRingAllocator allocator{ 1024 + 100 };
+		CHECK(allocator.capacity() == 1024);
+		CHECK(allocator.allocate(1) == 0);
+		CHECK(allocator.allocate(257) == 256);
+		CHECK(allocator.bytesInUse() == 768);
+		CHECK(allocator.allocate(0) == ConstantRingAllocator::invalidOffset);
+		CHECK(allocator.allocate(2048) == ConstantRingAllocator::invalidOffset);
+	}
+
+	//Space comes back only once the fence of the frame that used it completes
+	//-------------------------------------------------------
+	void testFenceRelease()
+	{
+		ConstantRingAllocator allocator{ 1024 };
+		CHECK(allocator.allocate(512) == 0);
+		allocator.endFrame(1);
+		CHECK(allocator.allocate(512) == 512);
+		allocator.endFrame(2);
+		CHECK(allocator.hasFramesInFlight());
+		CHECK(allocator.allocate(256) == ConstantRingAllocator::invalidOffset);
+
+		allocator.release(0);
+		CHECK(allocator.bytesInUse() == 1024);
+		allocator.release(1);
+		CHECK(allocator.bytesInUse() == 512);
+		CHECK(allocator.allocate(256) == 0);
+		allocator.endFrame(3);
+
+		//Releasing past several fences frees all of them, in order
+		allocator.release(3);
+		CHECK(allocator.bytesInUse() == 0);
+		CHECK(!allocator.hasFramesInFlight());
+
+		//An empty frame records nothing
+		allocator.endFrame(4);
+		CHECK(!allocator.hasFramesInFlight());
+	}
+
+	//An allocation that would straddle the end skips the tail, which stays used until its frame completes
+	//-------------------------------------------------------
+	void testWraparound()
+	{
+		ConstantRingAllocator allocator{ 1024 };
+		CHECK(allocator.allocate(512) == 0);
+		allocator.endFrame(1);
+		CHECK(allocator.allocate(256) == 512);
+		allocator.endFrame(2);
+		allocator.release(1);
+		CHECK(allocator.bytesInUse() == 256);
+
+		//Head is at 768: 512 does not fit before the end, so the tail is skipped and it starts at 0
+		CHECK(allocator.allocate(512) == 0);
+		CHECK(allocator.bytesInUse() == 1024);
+		CHECK(allocator.allocate(1) == ConstantRingAllocator::invalidOffset);
+		allocator.endFrame(3);
+
+		//The skipped tail belongs to frame 3, not to frame 2
+		allocator.release(2);
+		CHECK(allocator.bytesInUse() == 768);
+		CHECK(allocator.allocate(256) == 512);
+		CHECK(allocator.allocate(1) == ConstantRingAllocator::invalidOffset);
+		allocator.endFrame(4);
+		allocator.release(3);
+		CHECK(allocator.bytesInUse() == 256);
+		allocator.release(4);
+		CHECK(allocator.bytesInUse() == 0);
+
+		//A tail too small for the allocation, with the start of the ring still held, fails
+		CHECK(allocator.allocate(256) == 0);
+		allocator.endFrame(5);
+		CHECK(allocator.allocate(512) == 256);
+		allocator.endFrame(6);
+		allocator.release(5);
+		CHECK(allocator.allocate(512) == ConstantRingAllocator::invalidOffset);
+		CHECK(allocator.allocate(256) == 768);
+		CHECK(allocator.allocate(256) == 0);
+		CHECK(allocator.bytesInUse() == 1024);
+	}
+
+	//Last SetConstantBuffer recorded for a stage and slot
+	//-------------------------------------------------------
+	const RecordedCall* lastConstantBind(const NullRenderContext& context, ShaderStage stage, uint32_t slot)
+	{
+		const RecordedCall* last{ nullptr };
+		for (const RecordedCall& call : context.recordedCalls())
+		{
+			if (call.call == RenderCall::SetConstantBuffer && call.args[0] == static_cast<uint32_t>(stage) && call.args[1] == slot)
+			{
+				last = &call;
+			}
+		}
+		return last;
+	}
+
+	//Growing twice: the second buffer is created in the slot the first one freed, and binding
+	//it at the offset the first one was bound at must still reach the context
+	//-------------------------------------------------------
+	void testGrowTwiceThroughStateCache()
+	{
+		NullRenderDevice device;
+		NullRenderContext& nullContext = device.nullContext();
+		nullContext.setRecording(true);
+		StateCache cache{ nullContext };
+		ConstantUploadRing ring{ device, 256 };
+		const uint8_t constants[256]{};
+
+		//Frame 1: the second upload does not fit and grows 256 -> 512
+		ring.beginFrame();
+		ConstantAllocation a = ring.upload(cache, constants, 256);
+		ConstantUploadRing::bind(cache, ShaderStage::Vertex, 0, a);
+		ConstantAllocation b = ring.upload(cache, constants, 256);
+		ConstantUploadRing::bind(cache, ShaderStage::Pixel, 0, b);
+		CHECK(ring.stats().grows == 1);
+		CHECK(a.buffer != b.buffer);
+		CHECK(ring.capacity() == 512);
+		ring.endFrame();
+		device.present(0);
+
+		//Frame 2: the first buffer is destroyed, the third upload grows 512 -> 1024
+		ring.beginFrame();
+		CHECK(device.liveBufferCount() == 1);
+		ring.upload(cache, constants, 256);
+		ring.upload(cache, constants, 256);
+		ConstantAllocation e = ring.upload(cache, constants, 256);
+		CHECK(ring.stats().grows == 2);
+		CHECK(ring.capacity() == 1024);
+		CHECK(e.buffer.slot() == a.buffer.slot());
+		CHECK(e.buffer != a.buffer);
+		CHECK(e.offset == a.offset);
+
+		ConstantUploadRing::bind(cache, ShaderStage::Vertex, 0, e);
+		const RecordedCall* bind = lastConstantBind(nullContext, ShaderStage::Vertex, 0);
+		CHECK(bind != nullptr && bind->args[2] == e.buffer.id);
+		CHECK(device.buffer(e.buffer).desc.sizeInBytes == 1024);
+
+		//Binding it again is redundant
+		const uint64_t binds{ nullContext.stats().count(RenderCall::SetConstantBuffer) };
+		ConstantUploadRing::bind(cache, ShaderStage::Vertex, 0, e);
+		CHECK(nullContext.stats().count(RenderCall::SetConstantBuffer) == binds);
+		ring.endFrame();
+		device.present(0);
+
+		ring.beginFrame();
+		CHECK(device.liveBufferCount() == 1);
+		ring.endFrame();
+	}
+
+	//A GPU that finishes a frame only after being polled a few times
+	class LaggingDevice : public NullRenderDevice
+	{
+	public:
+
+		uint64_t completedFrames() override
+		{
+			if (pollsUntilDone > 0)
+			{
+				pollsUntilDone--;
+				return presentedFrames() > 0 ? presentedFrames() - 1 : 0;
+			}
+			return presentedFrames();
+		}
+
+		int pollsUntilDone{ 0 };
+	};
+
+	//A full ring waits for the oldest frame instead of growing
+	//-------------------------------------------------------
+	void testFenceWait()
+	{
+		LaggingDevice device;
+		ConstantUploadRing ring{ device, 512 };
+		const uint8_t constants[256]{};
+
+		device.pollsUntilDone = 1000;
+		ring.beginFrame();
+		ring.upload(device.immediateContext(), constants, 256);
+		ring.upload(device.immediateContext(), constants, 256);
+		ring.endFrame();
+		device.present(0);
+
+		device.pollsUntilDone = 5;
+		ring.beginFrame();
+		ConstantAllocation allocation = ring.upload(device.immediateContext(), constants, 256);
+		CHECK(ring.stats().fenceWaits == 1);
+		CHECK(ring.stats().grows == 0);
+		CHECK(allocation.offset == 0);
+		CHECK(device.pollsUntilDone == 0);
+		ring.endFrame();
+	}
+
+	//Empty maps return nothing and leave the ring alone, even when it is full and the GPU is behind
+	//-------------------------------------------------------
+	void testEmptyMap()
+	{
+		LaggingDevice device;
+		NullRenderContext& context = device.nullContext();
+		ConstantUploadRing ring{ device, 512 };
+		const uint8_t constants[256]{};
+
+		device.pollsUntilDone = 1000;
+		ring.beginFrame();
+		ring.upload(context, constants, 256);
+		ring.upload(context, constants, 256);
+		ring.endFrame();
+		device.present(0);
+
+		ring.beginFrame();
+		ring.resetStats();
+		context.resetStats();
+		const int polls{ device.pollsUntilDone };
+		ConstantAllocation allocation;
+		allocation.offset = 77;
+		CHECK(ring.map(context, sizeof(constants), 0, allocation) == nullptr);
+		ring.unmap(context);
+		CHECK(allocation.size == 0 && allocation.offset == 0 && !allocation.buffer.isValid());
+		CHECK(ring.map(context, 0, 16, allocation) == nullptr);
+		ring.unmap(context);
+		allocation = ring.upload(context, constants, 0);
+		CHECK(allocation.size == 0);
+
+		CHECK(context.stats().totalCalls() == 0);
+		CHECK(ring.stats().maps == 0 && ring.stats().allocations == 0 && ring.stats().bytesWritten == 0);
+		CHECK(ring.stats().fenceWaits == 0 && ring.stats().grows == 0);
+		CHECK(device.pollsUntilDone == polls && ring.capacity() == 512);
+
+		//A real map afterwards still waits for the old frame and lands at the start
+		device.pollsUntilDone = 3;
+		allocation = ring.upload(context, constants, 256);
+		CHECK(allocation.offset == 0 && ring.stats().fenceWaits == 1 && ring.stats().maps == 1);
+		ring.endFrame();
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testAllocatorAlignment);
+	RUN_TEST(testFenceRelease);
+	RUN_TEST(testWraparound);
+	RUN_TEST(testGrowTwiceThroughStateCache);
+	RUN_TEST(testFenceWait);
+	RUN_TEST(testEmptyMap);
+	return checkResult();
+}
@@ -0,0 +1,137 @@
+//cullSpheres against a scalar sphere test, the visible buffer contract and aabbInFrustum
+#include "Check.h"
+#include "Culling.h"
+#include <random>
+
+namespace
+{
+	//-------------------------------------------------------
+	Frustum testFrustum()
+	{
+		const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 100.0f);
+		return extractFrustumPlanes(XMMatrixMultiply(view, proj));
+	}
+
+	//Spheres scattered around and beyond the frustum so every plane culls some of them
+	//-------------------------------------------------------
+	SphereBoundsSoA randomSpheres(size_t count, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> position{ -60.0f, 120.0f };
+		std::uniform_real_distribution<float> radius{ 0.0f, 3.0f };
+		SphereBoundsSoA spheres;
+		spheres.resize(count);
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			spheres.set(i, XMFLOAT3{ position(random) * 0.5f, position(random) * 0.3f, position(random) }, radius(random));
+		}
+		return spheres;
+	}
+
+	//-------------------------------------------------------
+	std::vector<uint32_t> scalarCull(const Frustum& frustum, const SphereBoundsSoA& spheres)
+	{
+		std::vector<uint32_t> visible;
+		for (size_t i{ 0 }; i < spheres.size(); i++)
+		{
+			bool inside{ true };
+			for (const XMFLOAT4& plane : frustum.planes)
+			{
+				inside = inside && plane.x * spheres.centerX[i] + plane.y * spheres.centerY[i] + plane.z * spheres.centerZ[i] + plane.w >= -spheres.radius[i];
+			}
+			if (inside)
+			{
+				visible.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		return visible;
+	}
+
+	//Counts around the 4 and 8 wide batches so the SIMD loops and the scalar tail all run
+	//-------------------------------------------------------
+	void testMatchesScalar()
+	{
+		const Frustum frustum = testFrustum();
+		for (size_t count : { size_t{ 0 }, size_t{ 1 }, size_t{ 3 }, size_t{ 4 }, size_t{ 7 }, size_t{ 8 }, size_t{ 13 }, size_t{ 100003 } })
+		{
+			const SphereBoundsSoA spheres = randomSpheres(count, static_cast<uint32_t>(count));
+			const std::vector<uint32_t> expected = scalarCull(frustum, spheres);
+			std::vector<uint32_t> visible;
+			const size_t numVisible = cullSpheres(frustum, spheres, visible);
+
+			CHECK(numVisible == expected.size());
+			CHECK(visible.size() >= count);
+			CHECK(std::equal(expected.begin(), expected.end(), visible.begin()));
+		}
+	}
+
+	//A sphere touching a plane from outside is kept, one just beyond it is culled
+	//-------------------------------------------------------
+	void testTouchingPlane()
+	{
+		Frustum frustum;
+		for (XMFLOAT4& plane : frustum.planes)
+		{
+			plane = XMFLOAT4{ 0.0f, 0.0f, 1.0f, 1000.0f };
+		}
+		frustum.planes[4] = XMFLOAT4{ 1.0f, 0.0f, 0.0f, 0.0f };	//x >= 0
+
+		SphereBoundsSoA spheres;
+		spheres.resize(9);
+		for (size_t i{ 0 }; i < 9; i++)
+		{
+			spheres.set(i, XMFLOAT3{ -2.0f, 0.0f, 0.0f }, i % 2 == 0 ? 2.0f : 1.5f);
+		}
+		std::vector<uint32_t> visible;
+		const size_t numVisible = cullSpheres(frustum, spheres, visible);
+		CHECK(numVisible == 5);
+		for (size_t i{ 0 }; i < numVisible; i++)
+		{
+			CHECK(visible[i] == i * 2);
+		}
+	}
+
+	//The buffer is grown to the sphere count once and is never shrunk or reallocated afterwards
+	//-------------------------------------------------------
+	void testBufferContract()
+	{
+		const Frustum frustum = testFrustum();
+		const SphereBoundsSoA spheres = randomSpheres(5000, 11);
+		const SphereBoundsSoA fewer = randomSpheres(100, 12);
+
+		std::vector<uint32_t> visible;
+		cullSpheres(frustum, spheres, visible);
+		CHECK(visible.size() == 5000);
+		const uint32_t* storage = visible.data();
+
+		for (int frame{ 0 }; frame < 3; frame++)
+		{
+			const size_t numVisible = cullSpheres(frustum, frame == 1 ? fewer : spheres, visible);
+			CHECK(visible.size() == 5000);
+			CHECK(visible.data() == storage);
+			CHECK(numVisible == scalarCull(frustum, frame == 1 ? fewer : spheres).size());
+		}
+	}
+
+	//-------------------------------------------------------
+	void testAabb()
+	{
+		const Frustum frustum = testFrustum();
+		CHECK(aabbInFrustum(frustum, XMFLOAT3{ -1.0f, -1.0f, -1.0f }, XMFLOAT3{ 1.0f, 1.0f, 1.0f }));
+		CHECK(!aabbInFrustum(frustum, XMFLOAT3{ -1.0f, -1.0f, -30.0f }, XMFLOAT3{ 1.0f, 1.0f, -20.0f }));
+		CHECK(!aabbInFrustum(frustum, XMFLOAT3{ -1.0f, -1.0f, 200.0f }, XMFLOAT3{ 1.0f, 1.0f, 210.0f }));
+		//Straddles the left plane
+		CHECK(aabbInFrustum(frustum, XMFLOAT3{ -100.0f, -1.0f, 10.0f }, XMFLOAT3{ 0.0f, 1.0f, 11.0f }));
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testMatchesScalar);
+	RUN_TEST(testTouchingPlane);
+	RUN_TEST(testBufferContract);
+	RUN_TEST(testAabb);
+	return checkResult();
+}
@@ -0,0 +1,242 @@
+//RangeAllocator best fit, coalescing and fragmentation stats against a per unit model, and
+//GeometryPool paging, index narrowing and uploads on the null backend
+#include "Check.h"
+#include "GeometryPool.h"
+#include "NullRenderDevice.h"
+#include <cstring>
+#include <random>
+
+namespace
+{
+	//-------------------------------------------------------
+	void testBestFitAndCoalescing()
+	{
+		RangeAllocator ranges{ 100 };
+		const uint32_t a = ranges.allocate(10);
+		const uint32_t b = ranges.allocate(20);
+		const uint32_t c = ranges.allocate(5);
+		const uint32_t d = ranges.allocate(30);
+		CHECK(a == 0 && b == 10 && c == 30 && d == 35);
+		CHECK(ranges.allocationSize(b) == 20);
+		CHECK(ranges.allocationSize(b + 1) == 0);
+		CHECK(ranges.allocate(0) == RangeAllocator::invalidOffset);
+
+		//A 20 unit hole at 10 and 35 free units at the end
+		ranges.free(b);
+		RangeAllocatorStats stats = ranges.stats();
+		CHECK(stats.used == 45 && stats.allocations == 3);
+		CHECK(stats.freeBlocks == 2 && stats.largestFreeBlock == 35);
+		CHECK_NEAR(stats.fragmentation(), 1.0 - 35.0 / 55.0, 1e-9);
+
+		//Best fit takes the 20 unit hole rather than the larger tail
+		const uint32_t e = ranges.allocate(15);
+		CHECK(e == 10);
+		ranges.free(e);
+
+		//Freeing c joins the holes on both sides into one block
+		ranges.free(c);
+		stats = ranges.stats();
+		CHECK(stats.freeBlocks == 2 && stats.largestFreeBlock == 35);
+		CHECK(ranges.allocate(25) == 10);
+
+		//Nothing fits a request larger than any single block, even with enough free units
+		CHECK(ranges.allocate(36) == RangeAllocator::invalidOffset);
+		ranges.free(a);
+		ranges.free(d);
+		ranges.free(10);
+		stats = ranges.stats();
+		CHECK(stats.used == 0 && stats.freeBlocks == 1 && stats.largestFreeBlock == 100);
+		CHECK(stats.fragmentation() == 0.0);
+		CHECK(ranges.allocate(100) == 0);
+		CHECK(ranges.stats().fragmentation() == 0.0);
+	}
+
+	//Random allocate / free against an owner per unit: ranges never overlap, the stats
+	//match the model, and after freeing everything the space is one block again
+	//-------------------------------------------------------
+	void testRandomAgainstModel()
+	{
+		const uint32_t capacity{ 4096 };
+		RangeAllocator ranges{ capacity };
+		std::vector<int> owner(capacity, -1);
+		std::vector<std::pair<uint32_t, uint32_t>> live;
+		std::mt19937 random{ 11 };
+		bool consistent{ true };
+
+		for (int step{ 0 }; step < 20000; step++)
+		{
+			if (!live.empty() && random() % 5 < 2)
+			{
+				size_t pick = random() % live.size();
+				const auto [offset, size] = live[pick];
+				for (uint32_t i{ offset }; i < offset + size; i++)
+				{
+					owner[i] = -1;
+				}
+				ranges.free(offset);
+				live[pick] = live.back();
+				live.pop_back();
+			}
+			else
+			{
+				const uint32_t size = 1 + static_cast<uint32_t>(random() % 64);
+				const uint32_t offset = ranges.allocate(size);
+				if (offset == RangeAllocator::invalidOffset)
+				{
+					continue;
+				}
+				for (uint32_t i{ offset }; i < offset + size; i++)
+				{
+					consistent = consistent && owner[i] == -1;
+					owner[i] = step;
+				}
+				live.push_back({ offset, size });
+			}
+
+			//Free blocks of the model, runs of unowned units
+			uint32_t used{ 0 };
+			uint32_t freeBlocks{ 0 };
+			uint32_t largest{ 0 };
+			uint32_t run{ 0 };
+			for (uint32_t i{ 0 }; i <= capacity; i++)
+			{
+				if (i < capacity && owner[i] == -1)
+				{
+					run++;
+					continue;
+				}
+				used += i < capacity ? 1 : 0;
+				freeBlocks += run != 0 ? 1 : 0;
+				largest = std::max(largest, run);
+				run = 0;
+			}
+			const RangeAllocatorStats stats = ranges.stats();
+			consistent = consistent && stats.used == used && stats.freeBlocks == freeBlocks &&
+				stats.largestFreeBlock == largest && stats.allocations == live.size();
+		}
+		CHECK(consistent);
+
+		for (const auto& allocation : live)
+		{
+			ranges.free(allocation.first);
+		}
+		const RangeAllocatorStats stats = ranges.stats();
+		CHECK(stats.used == 0 && stats.freeBlocks == 1 && stats.largestFreeBlock == capacity);
+	}
+
+	//-------------------------------------------------------
+	std::vector<uint8_t> makeVertices(uint32_t count, uint32_t stride, uint8_t seed)
+	{
+		std::vector<uint8_t> bytes(size_t{ count } * stride);
+		for (size_t i{ 0 }; i < bytes.size(); i++)
+		{
+			bytes[i] = static_cast<uint8_t>(i * 7 + seed);
+		}
+		return bytes;
+	}
+
+	//Meshes share pages per stride, land at baseVertex / startIndex, and use 16 bit indices when they can
+	//-------------------------------------------------------
+	void testPoolLayoutAndUploads()
+	{
+		NullRenderDevice device;
+		IRenderContext& context = device.immediateContext();
+		GeometryPool pool{ device, 32 * 1024, 8 * 1024 };
+
+		const std::vector<uint8_t> vertices32 = makeVertices(24, 32, 1);
+		const std::vector<uint8_t> vertices16 = makeVertices(100, 16, 2);
+		std::vector<uint32_t> indices(36);
+		for (uint32_t i{ 0 }; i < indices.size(); i++)
+		{
+			indices[i] = (i * 5) % 24;
+		}
+
+		const GeometryAllocation first = pool.allocate(context, vertices32.data(), 24, 32, indices.data(), 36);
+		const GeometryAllocation second = pool.allocate(context, vertices32.data(), 24, 32, indices.data(), 36);
+		const GeometryAllocation other = pool.allocate(context, vertices16.data(), 100, 16, indices.data(), 36);
+		CHECK(first.isValid() && second.isValid() && other.isValid());
+		CHECK(first.vertexBuffer == second.vertexBuffer);
+		CHECK(first.vertexBuffer != other.vertexBuffer);
+		CHECK(first.indexBuffer == other.indexBuffer);
+		CHECK(first.baseVertex == 0 && second.baseVertex == 24);
+		CHECK(first.startIndex == 0 && second.startIndex == 36 && other.startIndex == 72);
+		CHECK(first.indexFormat == IndexFormat::UInt16);
+
+		//Contents arrive at their offsets, indices narrowed and still relative to baseVertex
+		const std::vector<uint8_t>& vertexBytes = device.buffer(second.vertexBuffer).bytes;
+		CHECK(memcmp(vertexBytes.data() + second.baseVertex * 32, vertices32.data(), vertices32.size()) == 0);
+		const std::vector<uint8_t>& indexBytes = device.buffer(second.indexBuffer).bytes;
+		bool indicesMatch{ true };
+		for (uint32_t i{ 0 }; i < 36; i++)
+		{
+			uint16_t index;
+			memcpy(&index, indexBytes.data() + (second.startIndex + i) * 2, 2);
+			indicesMatch = indicesMatch && index == indices[i];
+		}
+		CHECK(indicesMatch);
+
+		const GeometryPoolStats stats = pool.stats();
+		CHECK(stats.vertexPages == 2 && stats.indexPages == 1);
+		CHECK(stats.vertexBytes.used == 2 * 24 * 32 + 100 * 16);
+		CHECK(stats.indexBytes.used == 3 * 36 * 2);
+		CHECK(stats.bytesUploaded == 2 * (24 * 32 + 36 * 2) + 100 * 16 + 36 * 2);
+
+		//More than 65536 vertices keeps 32 bit indices
+		const std::vector<uint8_t> big = makeVertices(70000, 4, 3);
+		const uint32_t bigIndices[3]{ 0, 69999, 35000 };
+		const GeometryAllocation wide = pool.allocate(context, big.data(), 70000, 4, bigIndices, 3);
+		CHECK(wide.indexFormat == IndexFormat::UInt32);
+		CHECK(wide.indexBuffer != first.indexBuffer);
+
+		CHECK(!pool.allocate(context, vertices32.data(), 0, 32, indices.data(), 36).isValid());
+		CHECK(!pool.allocate(context, vertices32.data(), 24, 32, indices.data(), 0).isValid());
+	}
+
+	//A full page gets a new page, an oversized mesh a page of its own size, freed ranges are reused
+	//-------------------------------------------------------
+	void testPaging()
+	{
+		NullRenderDevice device;
+		IRenderContext& context = device.immediateContext();
+		const uint32_t stride{ 32 };
+		GeometryPool pool{ device, 100 * stride, 1024 };
+		const std::vector<uint8_t> vertices = makeVertices(300, stride, 4);
+		const uint32_t indices[3]{ 0, 1, 2 };
+
+		const GeometryAllocation a = pool.allocate(context, vertices.data(), 60, stride, indices, 3);
+		const GeometryAllocation b = pool.allocate(context, vertices.data(), 60, stride, indices, 3);
+		CHECK(a.vertexBuffer != b.vertexBuffer);
+		CHECK(b.baseVertex == 0);
+		CHECK(pool.stats().vertexPages == 2);
+
+		const GeometryAllocation huge = pool.allocate(context, vertices.data(), 300, stride, indices, 3);
+		CHECK(huge.baseVertex == 0);
+		CHECK(device.buffer(huge.vertexBuffer).desc.sizeInBytes == 300 * stride);
+		CHECK(pool.stats().vertexPages == 3);
+
+		//Fits in the space a left behind, without a new page
+		pool.free(a);
+		const GeometryAllocation c = pool.allocate(context, vertices.data(), 40, stride, indices, 3);
+		CHECK(c.vertexBuffer == a.vertexBuffer && c.baseVertex == 0);
+		CHECK(pool.stats().vertexPages == 3);
+
+		pool.free(b);
+		pool.free(c);
+		pool.free(huge);
+		const GeometryPoolStats stats = pool.stats();
+		CHECK(stats.vertexBytes.used == 0 && stats.indexBytes.used == 0);
+		CHECK(stats.vertexBytes.capacity == (100 + 100 + 300) * stride);
+		CHECK(stats.vertexBytes.largestFreeBlock == 300 * stride);
+		CHECK(stats.vertexBytes.freeBlocks == 3);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testBestFitAndCoalescing);
+	RUN_TEST(testRandomAgainstModel);
+	RUN_TEST(testPoolLayoutAndUploads);
+	RUN_TEST(testPaging);
+	return checkResult();
+}
@@ -0,0 +1,267 @@
+//decodeBmp on generated files, including BI_BITFIELDS mask validation, and Flipbook atlas packing
+#include "Check.h"
+#include "CpuImage.h"
+#include "Flipbook.h"
+#include <cstring>
+
+namespace
+{
+	//-------------------------------------------------------
+	void putU16(std::vector<uint8_t>& bytes, size_t offset, uint32_t value)
+	{
+		bytes[offset] = static_cast<uint8_t>(value);
+		bytes[offset + 1] = static_cast<uint8_t>(value >> 8);
+	}
+
+	//-------------------------------------------------------
+	void putU32(std::vector<uint8_t>& bytes, size_t offset, uint32_t value)
+	{
+		for (int i{ 0 }; i < 4; i++)
+		{
+			bytes[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+		}
+	}
+
+	//Writes a BMP with the given header size whose pixels are filled by pixel(x, y, bytes) in file order.
+	//masks are written after a 40 byte header or into a larger one; alpha only fits in headers of 56 bytes or more
+	//-------------------------------------------------------
+	template <typename PixelFunc>
+	std::vector<uint8_t> makeBmp(int32_t width, int32_t height, uint16_t bitsPerPixel, uint32_t compression,
+		const uint32_t masks[4], uint32_t infoSize, PixelFunc&& pixel)
+	{
+		const size_t maskBytes = compression == 3 && infoSize == 40 ? 12 : 0;
+		const uint32_t rows = static_cast<uint32_t>(height < 0 ? -height : height);
+		const size_t pitch = (static_cast<size_t>(width) * (bitsPerPixel / 8) + 3) & ~size_t{ 3 };
+		const size_t pixelOffset = 14 + infoSize + maskBytes;
+
+		std::vector<uint8_t> bytes(pixelOffset + pitch * rows, 0);
+		bytes[0] = 'B';
+		bytes[1] = 'M';
+		putU32(bytes, 2, static_cast<uint32_t>(bytes.size()));
+		putU32(bytes, 10, static_cast<uint32_t>(pixelOffset));
+		putU32(bytes, 14, infoSize);
+		putU32(bytes, 18, static_cast<uint32_t>(width));
+		putU32(bytes, 22, static_cast<uint32_t>(height));
+		putU16(bytes, 26, 1);
+		putU16(bytes, 28, bitsPerPixel);
+		putU32(bytes, 30, compression);
+		if (masks != nullptr)
+		{
+			for (size_t i{ 0 }; i < (infoSize >= 56 ? 4u : 3u); i++)
+			{
+				putU32(bytes, 14 + 40 + i * 4, masks[i]);
+			}
+		}
+		for (uint32_t y{ 0 }; y < rows; y++)
+		{
+			for (int32_t x{ 0 }; x < width; x++)
+			{
+				pixel(static_cast<uint32_t>(x), y, bytes.data() + pixelOffset + pitch * y + static_cast<size_t>(x) * (bitsPerPixel / 8));
+			}
+		}
+		return bytes;
+	}
+
+	//-------------------------------------------------------
+	bool pixelIs(const CpuImage& image, uint32_t x, uint32_t y, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+	{
+		const uint8_t* p = image.pixels.data() + image.rowPitch() * y + x * 4;
+		return p[0] == r && p[1] == g && p[2] == b && p[3] == a;
+	}
+
+	//Bottom up rows, BGR order and row padding (3 * 3 bytes padded to 12)
+	//-------------------------------------------------------
+	void testBmp24()
+	{
+		const std::vector<uint8_t> bytes = makeBmp(3, 2, 24, 0, nullptr, 40, [](uint32_t x, uint32_t y, uint8_t* p)
+		{
+			p[0] = static_cast<uint8_t>(10 * x);	//blue
+			p[1] = static_cast<uint8_t>(100 + y);	//green
+			p[2] = 200;								//red
+		});
+		CpuImage image;
+		CHECK(decodeBmp(bytes.data(), bytes.size(), image));
+		CHECK(image.width == 3 && image.height == 2 && image.pixels.size() == 24);
+		//The last file row is the top image row
+		CHECK(pixelIs(image, 0, 0, 200, 101, 0, 255));
+		CHECK(pixelIs(image, 2, 1, 200, 100, 20, 255));
+	}
+
+	//Top down BGRA, and an all zero alpha channel read as opaque
+	//-------------------------------------------------------
+	void testBmp32()
+	{
+		std::vector<uint8_t> bytes = makeBmp(2, -2, 32, 0, nullptr, 40, [](uint32_t x, uint32_t y, uint8_t* p)
+		{
+			p[0] = 1;
+			p[1] = 2;
+			p[2] = 3;
+			p[3] = static_cast<uint8_t>(x + y * 2);
+		});
+		CpuImage image;
+		CHECK(decodeBmp(bytes.data(), bytes.size(), image));
+		CHECK(pixelIs(image, 0, 0, 3, 2, 1, 0));
+		CHECK(pixelIs(image, 1, 1, 3, 2, 1, 3));
+
+		bytes = makeBmp(2, 2, 32, 0, nullptr, 40, [](uint32_t, uint32_t, uint8_t* p) { p[0] = 9; p[3] = 0; });
+		CHECK(decodeBmp(bytes.data(), bytes.size(), image));
+		CHECK(pixelIs(image, 1, 0, 0, 0, 9, 255));
+	}
+
+	//The usual BGRX masks after a 40 byte header, and RGBA masks in a V5 (124 byte) header
+	//-------------------------------------------------------
+	void testBitfields()
+	{
+		const uint32_t bgrx[4]{ 0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0 };
+		std::vector<uint8_t> bytes = makeBmp(2, 1, 32, 3, bgrx, 40, [](uint32_t, uint32_t, uint8_t* p)
+		{
+			p[0] = 30; p[1] = 20; p[2] = 10; p[3] = 77;
+		});
+		CpuImage image;
+		CHECK(decodeBmp(bytes.data(), bytes.size(), image));
+		CHECK(pixelIs(image, 1, 0, 10, 20, 30, 255));
+
+		const uint32_t rgba[4]{ 0x000000FFu, 0x0000FF00u, 0x00FF0000u, 0xFF000000u };
+		bytes = makeBmp(2, 1, 32, 3, rgba, 124, [](uint32_t x, uint32_t, uint8_t* p)
+		{
+			p[0] = 10; p[1] = 20; p[2] = 30; p[3] = static_cast<uint8_t>(128 + x);
+		});
+		CHECK(decodeBmp(bytes.data(), bytes.size(), image));
+		CHECK(pixelIs(image, 0, 0, 10, 20, 30, 128));
+		CHECK(pixelIs(image, 1, 0, 10, 20, 30, 129));
+	}
+
+	//Layouts that are not one byte per channel, overlapping masks and corrupt files are rejected
+	//-------------------------------------------------------
+	void testRejected()
+	{
+		auto fill = [](uint32_t, uint32_t, uint8_t*) {};
+		CpuImage image;
+
+		const uint32_t rgb565[4]{ 0xF800u, 0x07E0u, 0x001Fu, 0 };
+		std::vector<uint8_t> bytes = makeBmp(2, 2, 32, 3, rgb565, 40, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		const uint32_t rgb101010[4]{ 0x3FF00000u, 0x000FFC00u, 0x000003FFu, 0 };
+		bytes = makeBmp(2, 2, 32, 3, rgb101010, 40, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		const uint32_t overlapping[4]{ 0x00FF0000u, 0x00FF0000u, 0x000000FFu, 0 };
+		bytes = makeBmp(2, 2, 32, 3, overlapping, 40, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		const uint32_t alphaNibble[4]{ 0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0x0F000000u };
+		bytes = makeBmp(2, 2, 32, 3, alphaNibble, 56, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		const uint32_t alphaOverlapsRed[4]{ 0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0x00FF0000u };
+		bytes = makeBmp(2, 2, 32, 3, alphaOverlapsRed, 56, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		const uint32_t bgr[4]{ 0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0 };
+		bytes = makeBmp(2, 2, 24, 3, bgr, 40, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		bytes = makeBmp(4, 4, 32, 0, nullptr, 40, fill);
+		bytes.resize(bytes.size() - 1);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		bytes = makeBmp(4, 4, 32, 0, nullptr, 40, fill);
+		bytes[0] = 'X';
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+
+		bytes = makeBmp(4, 4, 16, 0, nullptr, 40, fill);
+		CHECK(!decodeBmp(bytes.data(), bytes.size(), image));
+	}
+
+	//Frame with a distinct value per texel: red = x, green = y, blue = frame
+	//-------------------------------------------------------
+	CpuImage testFrame(uint32_t width, uint32_t height, uint8_t frame)
+	{
+		CpuImage image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(image.rowPitch() * height);
+		for (uint32_t y{ 0 }; y < height; y++)
+		{
+			for (uint32_t x{ 0 }; x < width; x++)
+			{
+				uint8_t* p = image.pixels.data() + image.rowPitch() * y + x * 4;
+				p[0] = static_cast<uint8_t>(x);
+				p[1] = static_cast<uint8_t>(y);
+				p[2] = frame;
+				p[3] = 255;
+			}
+		}
+		return image;
+	}
+
+	//5 frames of 6x4 with a gutter of 2 go into a 3x2 grid of 10x8 cells
+	//-------------------------------------------------------
+	void testFlipbookLayout()
+	{
+		std::vector<CpuImage> frames;
+		for (uint8_t i{ 0 }; i < 5; i++)
+		{
+			frames.push_back(testFrame(6, 4, i));
+		}
+		Flipbook flipbook;
+		CHECK(flipbook.pack(frames, 2));
+		CHECK(flipbook.frameCount() == 5);
+		const CpuImage& atlas = flipbook.atlas();
+		CHECK(atlas.width == 30 && atlas.height == 16);
+
+		for (uint32_t frame{ 0 }; frame < 5; frame++)
+		{
+			//uv (0, 0) and (1, 1) land on the frame's first and one past its last texel
+			const XMFLOAT4X4 transform = flipbook.frameTransform(frame);
+			const float left = transform._41 * atlas.width;
+			const float top = transform._42 * atlas.height;
+			const float right = (transform._11 + transform._41) * atlas.width;
+			const float bottom = (transform._22 + transform._42) * atlas.height;
+			const uint32_t cellX = (frame % 3) * 10;
+			const uint32_t cellY = (frame / 3) * 8;
+			CHECK_NEAR(left, cellX + 2, 1e-4);
+			CHECK_NEAR(top, cellY + 2, 1e-4);
+			CHECK_NEAR(right, cellX + 8, 1e-4);
+			CHECK_NEAR(bottom, cellY + 6, 1e-4);
+
+			//Interior texels are copied, gutters repeat the nearest edge texel of the same frame
+			CHECK(pixelIs(atlas, cellX + 2, cellY + 2, 0, 0, static_cast<uint8_t>(frame), 255));
+			CHECK(pixelIs(atlas, cellX + 5, cellY + 4, 3, 2, static_cast<uint8_t>(frame), 255));
+			CHECK(pixelIs(atlas, cellX, cellY, 0, 0, static_cast<uint8_t>(frame), 255));
+			CHECK(pixelIs(atlas, cellX + 9, cellY + 7, 5, 3, static_cast<uint8_t>(frame), 255));
+			CHECK(pixelIs(atlas, cellX + 9, cellY + 3, 5, 1, static_cast<uint8_t>(frame), 255));
+		}
+		//Frame indices wrap
+		const XMFLOAT4X4 wrapped = flipbook.frameTransform(7);
+		const XMFLOAT4X4 second = flipbook.frameTransform(2);
+		CHECK(wrapped._41 == second._41 && wrapped._42 == second._42);
+	}
+
+	//-------------------------------------------------------
+	void testFlipbookRejects()
+	{
+		Flipbook flipbook;
+		CHECK(!flipbook.pack(std::vector<CpuImage>{}));
+		std::vector<CpuImage> frames{ testFrame(4, 4, 0), testFrame(4, 5, 1) };
+		CHECK(!flipbook.pack(frames));
+
+		const std::vector<std::string> names = flipbookFrameFileNames("Images/FireAnim/Fire", 120, ".bmp");
+		CHECK(names.size() == 120);
+		CHECK(names.front() == "Images/FireAnim/Fire001.bmp");
+		CHECK(names.back() == "Images/FireAnim/Fire120.bmp");
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testBmp24);
+	RUN_TEST(testBmp32);
+	RUN_TEST(testBitfields);
+	RUN_TEST(testRejected);
+	RUN_TEST(testFlipbookLayout);
+	RUN_TEST(testFlipbookRejects);
+	return checkResult();
+}
@@ -0,0 +1,229 @@
+//SpscQueue ordering, full / empty behaviour and a two thread stress run, InputState edges,
+//repeats and focus loss, and drainInput's order, timing and per frame cut off
+#include "Check.h"
+#include "InputQueue.h"
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//-------------------------------------------------------
+	InputEvent makeEvent(InputEventType type, uint32_t code, int32_t x = 0, int32_t y = 0, int64_t time = 0)
+	{
+		return InputEvent{ type, code, x, y, time };
+	}
+
+	//-------------------------------------------------------
+	void testQueueBasics()
+	{
+		CHECK(SpscQueue<int>{ 1000 }.capacity() == 1024);
+		CHECK(SpscQueue<int>{ 1 }.capacity() == 1);
+		CHECK(SpscQueue<int>{ 64 }.capacity() == 64);
+
+		SpscQueue<int> queue{ 8 };
+		int value{ -1 };
+		CHECK(!queue.pop(value) && value == -1);
+
+		//Around the ring several times, filling it each time
+		bool inOrder{ true };
+		int next{ 0 };
+		for (int round{ 0 }; round < 5; round++)
+		{
+			for (int i{ 0 }; i < 8; i++)
+			{
+				inOrder = inOrder && queue.push(round * 8 + i);
+			}
+			CHECK(!queue.push(99));
+			CHECK(queue.size() == 8);
+			for (int i{ 0 }; i < 8; i++)
+			{
+				inOrder = inOrder && queue.pop(value) && value == next++;
+			}
+			CHECK(!queue.pop(value));
+			CHECK(queue.size() == 0);
+		}
+		CHECK(inOrder);
+
+		//Interleaved, never more than three queued
+		for (int i{ 0 }; i < 100; i++)
+		{
+			queue.push(i);
+			if (i >= 2)
+			{
+				inOrder = inOrder && queue.pop(value) && value == i - 2;
+			}
+		}
+		CHECK(inOrder && queue.size() == 2);
+	}
+
+	//Items carry their sequence number twice, so a torn or reordered slot shows up
+	//-------------------------------------------------------
+	void testQueueStress()
+	{
+		struct Item
+		{
+			uint64_t sequence;
+			uint64_t check;
+		};
+		const uint64_t count{ 2000000 };
+
+		for (size_t capacity : { size_t{ 2 }, size_t{ 64 }, size_t{ 4096 } })
+		{
+			SpscQueue<Item> queue{ capacity };
+			std::thread producer{ [&queue, count]()
+			{
+				for (uint64_t i{ 0 }; i < count; i++)
+				{
+					while (!queue.push(Item{ i, ~i }))
+					{
+						std::this_thread::yield();
+					}
+				}
+			} };
+
+			uint64_t expected{ 0 };
+			bool valid{ true };
+			Item item;
+			while (expected < count)
+			{
+				if (!queue.pop(item))
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				valid = valid && item.sequence == expected && item.check == ~expected;
+				expected++;
+			}
+			producer.join();
+			CHECK(valid);
+			CHECK(queue.size() == 0 && !queue.pop(item));
+		}
+	}
+
+	//-------------------------------------------------------
+	void testKeyEdges()
+	{
+		const uint32_t keyW{ 'W' };
+		InputState state;
+		state.beginFrame();
+
+		//Down and up within one frame
+		state.apply(makeEvent(InputEventType::KeyDown, keyW));
+		state.apply(makeEvent(InputEventType::KeyUp, keyW));
+		CHECK(state.keyPressed(keyW) && state.keyReleased(keyW) && !state.keyDown(keyW));
+
+		//Held across frames: pressed once, repeats change nothing
+		state.beginFrame();
+		CHECK(!state.keyPressed(keyW) && !state.keyReleased(keyW));
+		state.apply(makeEvent(InputEventType::KeyDown, keyW));
+		state.beginFrame();
+		state.apply(makeEvent(InputEventType::KeyDown, keyW));
+		state.apply(makeEvent(InputEventType::KeyDown, keyW));
+		CHECK(state.keyDown(keyW) && !state.keyPressed(keyW));
+
+		state.beginFrame();
+		state.apply(makeEvent(InputEventType::KeyUp, keyW));
+		CHECK(!state.keyDown(keyW) && state.keyReleased(keyW) && !state.keyPressed(keyW));
+
+		//An up for a key that was never down, and codes past the table, are ignored
+		state.beginFrame();
+		state.apply(makeEvent(InputEventType::KeyUp, 'S'));
+		state.apply(makeEvent(InputEventType::KeyDown, 300));
+		CHECK(!state.keyReleased('S') && !state.keyDown(300) && !state.keyPressed(300));
+
+		//Keys in every word of the bit sets
+		for (uint32_t key : { 0u, 63u, 64u, 200u, 255u })
+		{
+			state.apply(makeEvent(InputEventType::KeyDown, key));
+			CHECK(state.keyDown(key) && state.keyPressed(key));
+			CHECK(!state.keyDown(key ^ 1));
+		}
+	}
+
+	//-------------------------------------------------------
+	void testMouseAndFocus()
+	{
+		InputState state;
+		state.beginFrame();
+
+		//No delta for the first position, then movement adds up over the frame
+		state.apply(makeEvent(InputEventType::MouseMove, 0, 100, 50));
+		CHECK(state.mouseDeltaX() == 0 && state.mouseDeltaY() == 0);
+		state.apply(makeEvent(InputEventType::MouseMove, 0, 110, 45));
+		state.apply(makeEvent(InputEventType::MouseButtonDown, 1, 113, 40));
+		CHECK(state.mouseDeltaX() == 13 && state.mouseDeltaY() == -10);
+		CHECK(state.mouseX() == 113 && state.mouseY() == 40 && state.mouseButtons() == 1);
+
+		state.beginFrame();
+		CHECK(state.mouseDeltaX() == 0 && state.mouseButtons() == 1);
+		state.apply(makeEvent(InputEventType::KeyDown, 'A'));
+
+		//Focus loss releases everything without release edges, and the cursor starts over
+		state.beginFrame();
+		state.apply(makeEvent(InputEventType::FocusLost, 0));
+		CHECK(!state.keyDown('A') && !state.keyReleased('A') && state.mouseButtons() == 0);
+		state.apply(makeEvent(InputEventType::MouseMove, 0, 500, 500));
+		CHECK(state.mouseDeltaX() == 0 && state.mouseDeltaY() == 0);
+
+		//Window events leave the input alone
+		state.apply(makeEvent(InputEventType::KeyDown, 'D'));
+		state.apply(makeEvent(InputEventType::Resize, 1, 640, 480));
+		state.apply(makeEvent(InputEventType::Pause, 0));
+		state.apply(makeEvent(InputEventType::Resume, 0));
+		CHECK(state.keyDown('D') && state.mouseX() == 500);
+	}
+
+	//-------------------------------------------------------
+	void testDrainInput()
+	{
+		SpscQueue<InputEvent> queue{ 16 };
+		InputState state;
+		queue.push(makeEvent(InputEventType::Resize, 1, 800, 600, 5));
+		queue.push(makeEvent(InputEventType::KeyDown, 'W', 0, 0, 30));
+		queue.push(makeEvent(InputEventType::MouseMove, 0, 10, 10, 20));
+		queue.push(makeEvent(InputEventType::KeyUp, 'W', 0, 0, 40));
+
+		//Handler sees events in order, after they are applied; events it pushes wait a frame
+		std::vector<InputEventType> seen;
+		bool appliedFirst{ true };
+		InputFrame frame = drainInput(queue, state, [&](const InputEvent& event)
+		{
+			seen.push_back(event.type);
+			if (event.type == InputEventType::KeyDown)
+			{
+				appliedFirst = appliedFirst && state.keyDown(event.code);
+				queue.push(makeEvent(InputEventType::MouseMove, 0, 15, 12, 50));
+			}
+		});
+		CHECK(frame.eventCount == 4);
+		CHECK((seen == std::vector<InputEventType>{ InputEventType::Resize, InputEventType::KeyDown, InputEventType::MouseMove, InputEventType::KeyUp }));
+		CHECK(appliedFirst);
+		CHECK(frame.oldestInputTime == 20);		//the resize is not user input
+		CHECK(state.keyPressed('W') && state.keyReleased('W'));
+		CHECK(queue.size() == 1);
+
+		//The next frame clears the edges and takes the event pushed during the last one
+		frame = drainInput(queue, state, [](const InputEvent&) {});
+		CHECK(frame.eventCount == 1 && frame.oldestInputTime == 50);
+		CHECK(!state.keyPressed('W') && !state.keyReleased('W'));
+		CHECK(state.mouseDeltaX() == 5 && state.mouseDeltaY() == 2);
+
+		//Nothing queued, or only window events: no input time
+		frame = drainInput(queue, state, [](const InputEvent&) {});
+		CHECK(frame.eventCount == 0 && frame.oldestInputTime == 0);
+		queue.push(makeEvent(InputEventType::Pause, 0, 0, 0, 70));
+		frame = drainInput(queue, state, [](const InputEvent&) {});
+		CHECK(frame.eventCount == 1 && frame.oldestInputTime == 0);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testQueueBasics);
+	RUN_TEST(testQueueStress);
+	RUN_TEST(testKeyEdges);
+	RUN_TEST(testMouseAndFocus);
+	RUN_TEST(testDrainInput);
+	return checkResult();
+}
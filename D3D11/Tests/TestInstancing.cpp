@@ -0,0 +1,107 @@
+//InstancePacker: instance layout, matrix rows, translation fast path and storage reuse
+#include "Check.h"
+#include "Instancing.h"
+#include <cstddef>
+
+namespace
+{
+	//-------------------------------------------------------
+	Material testMaterial()
+	{
+		Material material;
+		material.ambientColor = XMFLOAT4{ 0.1f, 0.2f, 0.3f, 1.0f };
+		material.diffuseColor = XMFLOAT4{ 0.4f, 0.5f, 0.6f, 1.0f };
+		material.specColor = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 8.0f };
+		return material;
+	}
+
+	//The instanced input layout reads WORLD rows at 0-48, the material at 64-96 and the flags at 112
+	//-------------------------------------------------------
+	void testLayout()
+	{
+		CHECK(sizeof(InstanceData) == 128);
+		CHECK(offsetof(InstanceData, world) == 0);
+		CHECK(offsetof(InstanceData, material) == 64);
+		CHECK(offsetof(InstanceData, flags) == 112);
+	}
+
+	//World matrices are stored row major with the translation in the last row
+	//-------------------------------------------------------
+	void testMatrixRows()
+	{
+		InstancePacker packer;
+		const XMMATRIX world = XMMatrixMultiply(XMMatrixScaling(2.0f, 3.0f, 4.0f), XMMatrixTranslation(5.0f, 6.0f, 7.0f));
+		packer.add(world, testMaterial(), INSTANCE_USE_TEXTURE | INSTANCE_CLIP_ALPHA);
+
+		CHECK(packer.count() == 1);
+		CHECK(packer.sizeInBytes() == sizeof(InstanceData));
+		const InstanceData& instance = packer.data()[0];
+		CHECK(instance.world._11 == 2.0f && instance.world._22 == 3.0f && instance.world._33 == 4.0f);
+		CHECK(instance.world._41 == 5.0f && instance.world._42 == 6.0f && instance.world._43 == 7.0f && instance.world._44 == 1.0f);
+		CHECK(instance.world._14 == 0.0f && instance.world._24 == 0.0f && instance.world._34 == 0.0f);
+		CHECK(instance.material.diffuseColor.y == 0.5f && instance.material.specColor.w == 8.0f);
+		CHECK(instance.flags == (INSTANCE_USE_TEXTURE | INSTANCE_CLIP_ALPHA));
+	}
+
+	//addTranslations writes the same bytes as add with a translation matrix
+	//-------------------------------------------------------
+	void testTranslationFastPath()
+	{
+		const XMFLOAT3 translations[]{ { 0.0f, 0.0f, 0.0f }, { 1.5f, -2.0f, 3.25f }, { -100.0f, 0.5f, 1e4f } };
+		const Material material = testMaterial();
+
+		InstancePacker general;
+		InstancePacker fast;
+		for (const XMFLOAT3& translation : translations)
+		{
+			general.add(XMMatrixTranslation(translation.x, translation.y, translation.z), material, INSTANCE_USE_TEXTURE);
+		}
+		fast.addTranslations(translations, 3, material, INSTANCE_USE_TEXTURE);
+
+		CHECK(fast.count() == 3);
+		for (size_t i{ 0 }; i < 3; i++)
+		{
+			const InstanceData& a = general.data()[i];
+			const InstanceData& b = fast.data()[i];
+			CHECK(memcmp(&a.world, &b.world, sizeof(a.world)) == 0);
+			CHECK(memcmp(&a.material, &b.material, sizeof(a.material)) == 0);
+			CHECK(a.flags == b.flags);
+		}
+	}
+
+	//After the first frame reaches the high water mark, clear and repack reuse the same storage
+	//-------------------------------------------------------
+	void testStorageReuse()
+	{
+		InstancePacker packer;
+		packer.reserve(1000);
+		const Material material = testMaterial();
+		for (int i{ 0 }; i < 1000; i++)
+		{
+			packer.addTranslation(XMFLOAT3{ static_cast<float>(i), 0.0f, 0.0f }, material, 0);
+		}
+		const InstanceData* storage = packer.data();
+
+		for (int frame{ 0 }; frame < 3; frame++)
+		{
+			packer.clear();
+			CHECK(packer.count() == 0);
+			for (int i{ 0 }; i < 1000; i++)
+			{
+				packer.addTranslation(XMFLOAT3{ 0.0f, static_cast<float>(i), 0.0f }, material, 0);
+			}
+			CHECK(packer.data() == storage);
+			CHECK(packer.data()[999].world._42 == 999.0f);
+		}
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testLayout);
+	RUN_TEST(testMatrixRows);
+	RUN_TEST(testTranslationFastPath);
+	RUN_TEST(testStorageReuse);
+	return checkResult();
+}
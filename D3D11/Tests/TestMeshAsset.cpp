@@ -0,0 +1,203 @@
+//MeshAssetWriter / MeshAsset round trip with 16 and 32 bit indices, blob alignment, the
+//committed cube and quad, and rejection of truncated or corrupt assets
+#include "Check.h"
+#include "MeshAsset.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	//-------------------------------------------------------
+	std::string tempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	//-------------------------------------------------------
+	bool writeBytes(const std::string& fileName, const std::vector<uint8_t>& bytes)
+	{
+		std::ofstream file{ fileName, std::ios::out | std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		return static_cast<bool>(file);
+	}
+
+	//count vertices along x, a strip of quads between consecutive pairs
+	//-------------------------------------------------------
+	void makeStrip(uint32_t count, std::vector<VertexNormTex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		for (uint32_t i{ 0 }; i < count; i++)
+		{
+			vertices.push_back({ XMFLOAT3{ static_cast<float>(i / 2), static_cast<float>(i % 2), 0.0f }, XMFLOAT3{ 0.0f, 0.0f, -1.0f },
+				XMFLOAT2{ static_cast<float>(i) / count, 0.0f } });
+		}
+		for (uint32_t i{ 0 }; i + 3 < count; i += 2)
+		{
+			const uint32_t quad[6]{ i, i + 1, i + 3, i, i + 3, i + 2 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	//Writes a two submesh asset of the strip and opens it
+	//-------------------------------------------------------
+	void roundTrip(uint32_t vertexCount, IndexFormat expectedFormat)
+	{
+		std::vector<VertexNormTex> vertices;
+		std::vector<uint32_t> indices;
+		makeStrip(vertexCount, vertices, indices);
+		const uint32_t half = static_cast<uint32_t>(indices.size() / 6 * 3);
+
+		Bounds bounds;
+		bounds.aabbMax = XMFLOAT3{ static_cast<float>(vertexCount / 2), 1.0f, 0.0f };
+		bounds.center = XMFLOAT3{ bounds.aabbMax.x * 0.5f, 0.5f, 0.0f };
+		bounds.radius = bounds.aabbMax.x;
+
+		MeshAssetWriter writer;
+		writer.setVertices(vertices.data(), vertexCount, sizeof(VertexNormTex), vertexNormTexLayout, 3);
+		writer.setIndices(indices.data(), indices.size());
+		writer.setBounds(bounds);
+		CHECK(writer.addSubmesh({ { 0, half, 0.0f }, { 0, 6, 0.25f } }));
+		CHECK(writer.addSubmesh({ { half, static_cast<uint32_t>(indices.size()) - half, 0.0f } }));
+		CHECK(!writer.addSubmesh({}));
+		CHECK(!writer.addSubmesh({ { half, static_cast<uint32_t>(indices.size()), 0.0f } }));
+
+		const std::string fileName = tempPath("TestMeshAsset.mesh");
+		CHECK(writer.write(fileName));
+		MeshAsset asset;
+		CHECK(asset.open(fileName));
+		CHECK(asset.vertexCount() == vertexCount && asset.indexCount() == indices.size());
+		CHECK(asset.indexFormat() == expectedFormat);
+		CHECK(asset.hasLayout(vertexNormTexLayout, 3, sizeof(VertexNormTex)));
+		CHECK(!asset.hasLayout(vertexNormTexPackedLayout, 3, sizeof(VertexNormTexPacked)));
+		CHECK(!asset.hasLayout(vertexNormTexLayout, 2, sizeof(VertexNormTex)));
+
+		//Blobs are aligned in the file, and so in the page aligned mapping
+		CHECK(reinterpret_cast<uintptr_t>(asset.vertexData()) % meshAssetAlignment == 0);
+		CHECK(reinterpret_cast<uintptr_t>(asset.indexData()) % meshAssetAlignment == 0);
+		CHECK(memcmp(asset.vertexData(), vertices.data(), vertices.size() * sizeof(VertexNormTex)) == 0);
+		bool sameIndices{ true };
+		for (size_t i{ 0 }; i < indices.size(); i++)
+		{
+			const uint32_t index = expectedFormat == IndexFormat::UInt16 ? static_cast<const uint16_t*>(asset.indexData())[i] :
+				static_cast<const uint32_t*>(asset.indexData())[i];
+			sameIndices = sameIndices && index == indices[i];
+		}
+		CHECK(sameIndices);
+
+		CHECK(asset.bounds().radius == bounds.radius && asset.bounds().aabbMax.x == bounds.aabbMax.x);
+		CHECK(asset.submeshCount() == 2);
+		const std::vector<MeshLod> first = asset.submeshLods(0);
+		const std::vector<MeshLod> second = asset.submeshLods(1);
+		CHECK(first.size() == 2 && first[1].indexCount == 6 && first[1].error == 0.25f);
+		CHECK(second.size() == 1 && second[0].startIndex == half);
+
+		asset.close();
+		CHECK(asset.vertexCount() == 0 && asset.submeshCount() == 0);
+		std::filesystem::remove(fileName);
+	}
+
+	//-------------------------------------------------------
+	void testRoundTrip()
+	{
+		roundTrip(200, IndexFormat::UInt16);
+		roundTrip(0x10000, IndexFormat::UInt16);
+		roundTrip(0x10002, IndexFormat::UInt32);
+	}
+
+	//The meshes the sample loads, as committed
+	//-------------------------------------------------------
+	void testCommittedMeshes()
+	{
+		for (const char* fileName : { "Meshes/cube.mesh", "Meshes/quad.mesh" })
+		{
+			MeshAsset asset;
+			CHECK(asset.open(fileName));
+			CHECK(asset.hasLayout(vertexNormTexLayout, 3, sizeof(VertexNormTex)));
+			CHECK(asset.submeshCount() == 1);
+			CHECK(asset.indexFormat() == IndexFormat::UInt16);
+			const std::vector<MeshLod> lods = asset.submeshLods(0);
+			CHECK(!lods.empty() && lods[0].startIndex == 0 && lods[0].indexCount > 0);
+			CHECK(asset.bounds().radius > 0.0f);
+		}
+		MeshAsset missing;
+		CHECK(!missing.open("Meshes/missing.mesh"));
+	}
+
+	//Each corruption is applied to a fresh copy of a valid asset
+	//-------------------------------------------------------
+	void testCorruptAssets()
+	{
+		std::vector<VertexNormTex> vertices;
+		std::vector<uint32_t> indices;
+		makeStrip(40, vertices, indices);
+		MeshAssetWriter writer;
+		writer.setVertices(vertices.data(), 40, sizeof(VertexNormTex), vertexNormTexLayout, 3);
+		writer.setIndices(indices.data(), indices.size());
+		writer.addSubmesh({ { 0, static_cast<uint32_t>(indices.size()), 0.0f }, { 0, 6, 0.5f } });
+		std::vector<uint8_t> valid;
+		writer.serialize(valid);
+
+		const std::string fileName = tempPath("TestMeshAssetCorrupt.mesh");
+		auto opens = [&](const std::vector<uint8_t>& bytes)
+		{
+			writeBytes(fileName, bytes);
+			MeshAsset asset;
+			return asset.open(fileName);
+		};
+		auto corrupt = [&](size_t offset, uint32_t value)
+		{
+			std::vector<uint8_t> bytes = valid;
+			memcpy(bytes.data() + offset, &value, sizeof(value));
+			return opens(bytes);
+		};
+
+		CHECK(opens(valid));
+
+		//Every truncation loses part of the index blob or more
+		bool truncatedOpened{ false };
+		for (size_t size{ 0 }; size < valid.size(); size++)
+		{
+			truncatedOpened = truncatedOpened || opens(std::vector<uint8_t>(valid.begin(), valid.begin() + size));
+		}
+		CHECK(!truncatedOpened);
+
+		const size_t attributes{ sizeof(MeshAssetHeader) };
+		const size_t submeshes{ attributes + 3 * sizeof(MeshAssetAttribute) };
+		const size_t lods{ submeshes + sizeof(MeshAssetSubmesh) };
+		CHECK(!corrupt(offsetof(MeshAssetHeader, magic), 0x4853454E));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, version), meshAssetVersion + 1));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, alignment), 48));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, vertexStride), 0));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, vertexStride), 64));			//vertex blob past the end
+		CHECK(!corrupt(offsetof(MeshAssetHeader, indexSize), 3));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, indexSize), 4));				//index blob twice as long
+		CHECK(!corrupt(offsetof(MeshAssetHeader, vertexCount), 0x20000));		//more vertices than the blob holds
+		CHECK(!corrupt(offsetof(MeshAssetHeader, attributeCount), 100000));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, lodCount), 0x40000000));
+		CHECK(!corrupt(offsetof(MeshAssetHeader, vertexOffset), 0));			//overlaps the tables
+		CHECK(!corrupt(offsetof(MeshAssetHeader, vertexOffset), 65));			//misaligned
+		CHECK(!corrupt(offsetof(MeshAssetHeader, indexOffset) + 4, 1));		//far past the end
+		CHECK(!corrupt(attributes + offsetof(MeshAssetAttribute, format), 99));
+		CHECK(!corrupt(attributes + 2 * sizeof(MeshAssetAttribute) + offsetof(MeshAssetAttribute, offset), 28));
+		CHECK(!corrupt(submeshes + offsetof(MeshAssetSubmesh, lodCount), 0));
+		CHECK(!corrupt(submeshes + offsetof(MeshAssetSubmesh, lodCount), 3));
+		CHECK(!corrupt(lods + sizeof(MeshAssetLod) + offsetof(MeshAssetLod, startIndex), static_cast<uint32_t>(indices.size())));
+		CHECK(!corrupt(lods + offsetof(MeshAssetLod, indexCount), 0xFFFFFFFFu));
+
+		//Index values are not read, so fewer vertices than the indices use is not caught
+		CHECK(corrupt(offsetof(MeshAssetHeader, vertexCount), 20));
+		std::filesystem::remove(fileName);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRoundTrip);
+	RUN_TEST(testCommittedMeshes);
+	RUN_TEST(testCorruptAssets);
+	return checkResult();
+}
@@ -0,0 +1,289 @@
+//MeshImporter: OBJ faces, negative indices, fans and the left handed conversion, chunked parsing
+//matching a single chunk, glTF from data URIs, external buffers and .glb, and rejection of
+//bad indices and out of range accessors
+#include "Check.h"
+#include "MeshImporter.h"
+#include "Parallel.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	//-------------------------------------------------------
+	std::string tempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	//-------------------------------------------------------
+	void writeText(const std::string& fileName, const std::string& text)
+	{
+		std::ofstream file{ fileName, std::ios::out | std::ios::binary | std::ios::trunc };
+		file.write(text.data(), static_cast<std::streamsize>(text.size()));
+	}
+
+	//-------------------------------------------------------
+	bool importText(const char* name, const std::string& text, ImportedMesh& mesh)
+	{
+		const std::string fileName = tempPath(name);
+		writeText(fileName, text);
+		const bool imported = importMesh(fileName, mesh);
+		std::filesystem::remove(fileName);
+		return imported;
+	}
+
+	//-------------------------------------------------------
+	bool near3(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return std::fabs(a.x - b.x) < 1e-5f && std::fabs(a.y - b.y) < 1e-5f && std::fabs(a.z - b.z) < 1e-5f;
+	}
+
+	//Corner k of triangle t
+	//-------------------------------------------------------
+	const VertexNormTex& corner(const ImportedMesh& mesh, size_t t, size_t k)
+	{
+		return mesh.vertices[mesh.indices[t * 3 + k]];
+	}
+
+	//-------------------------------------------------------
+	std::string base64(const std::vector<uint8_t>& bytes)
+	{
+		const char* alphabet{ "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/" };
+		std::string text;
+		for (size_t i{ 0 }; i < bytes.size(); i += 3)
+		{
+			const uint32_t group = uint32_t{ bytes[i] } << 16 | (i + 1 < bytes.size() ? uint32_t{ bytes[i + 1] } << 8 : 0) |
+				(i + 2 < bytes.size() ? bytes[i + 2] : 0);
+			text += alphabet[group >> 18 & 63];
+			text += alphabet[group >> 12 & 63];
+			text += i + 1 < bytes.size() ? alphabet[group >> 6 & 63] : '=';
+			text += i + 2 < bytes.size() ? alphabet[group & 63] : '=';
+		}
+		return text;
+	}
+
+	//A unit quad in the xy plane: interleaved position and texCoord (stride 20), then 16 bit indices
+	//-------------------------------------------------------
+	std::vector<uint8_t> quadBuffer()
+	{
+		const float vertices[4][5]{ { 0, 0, 0, 0, 1 }, { 1, 0, 0, 1, 1 }, { 1, 1, 0, 1, 0 }, { 0, 1, 0, 0, 0 } };
+		const uint16_t indices[6]{ 0, 1, 2, 0, 2, 3 };
+		std::vector<uint8_t> bytes(sizeof(vertices) + sizeof(indices));
+		memcpy(bytes.data(), vertices, sizeof(vertices));
+		memcpy(bytes.data() + sizeof(vertices), indices, sizeof(indices));
+		return bytes;
+	}
+
+	//glTF for quadBuffer under a translated parent and a scaled child node. buffer is the
+	//buffer's extra members, such as its uri
+	//-------------------------------------------------------
+	std::string quadGltf(const std::string& buffer, uint32_t positionCount = 4)
+	{
+		return std::string{ R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],)" } +
+			R"("nodes":[{"children":[1],"translation":[0,0,5]},{"mesh":0,"scale":[2,2,2]}],)" +
+			R"("meshes":[{"primitives":[{"attributes":{"POSITION":0,"TEXCOORD_0":1},"indices":2}]}],)" +
+			R"("accessors":[{"bufferView":0,"componentType":5126,"count":)" + std::to_string(positionCount) + R"(,"type":"VEC3"},)" +
+			R"({"bufferView":0,"byteOffset":12,"componentType":5126,"count":4,"type":"VEC2"},)" +
+			R"({"bufferView":1,"componentType":5123,"count":6,"type":"SCALAR"}],)" +
+			R"("bufferViews":[{"buffer":0,"byteLength":80,"byteStride":20},{"buffer":0,"byteOffset":80,"byteLength":12}],)" +
+			R"("buffers":[{"byteLength":92)" + buffer + "}]}";
+	}
+
+	//-------------------------------------------------------
+	std::vector<uint8_t> glb(std::string json, const std::vector<uint8_t>& binary, uint32_t version = 2)
+	{
+		json.resize((json.size() + 3) / 4 * 4, ' ');
+		std::vector<uint8_t> padded = binary;
+		padded.resize((padded.size() + 3) / 4 * 4, 0);
+		const uint32_t header[5]{ 0x46546C67, version, static_cast<uint32_t>(20 + json.size() + 8 + padded.size()),
+			static_cast<uint32_t>(json.size()), 0x4E4F534A };
+		const uint32_t binaryHeader[2]{ static_cast<uint32_t>(padded.size()), 0x004E4942 };
+		std::vector<uint8_t> bytes(header[2]);
+		memcpy(bytes.data(), header, sizeof(header));
+		memcpy(bytes.data() + sizeof(header), json.data(), json.size());
+		memcpy(bytes.data() + sizeof(header) + json.size(), binaryHeader, sizeof(binaryHeader));
+		memcpy(bytes.data() + sizeof(header) + json.size() + sizeof(binaryHeader), padded.data(), padded.size());
+		return bytes;
+	}
+
+	//Two triangles of quadBuffer, scaled by 2, moved 5 along z and mirrored into the app's
+	//left handed space with the winding reversed
+	//-------------------------------------------------------
+	void checkQuad(const ImportedMesh& mesh)
+	{
+		CHECK(mesh.vertices.size() == 4 && mesh.indices.size() == 6);
+		CHECK(mesh.generatedNormals);
+		CHECK(near3(corner(mesh, 0, 0).position, XMFLOAT3{ 0.0f, 0.0f, -5.0f }));
+		CHECK(near3(corner(mesh, 0, 1).position, XMFLOAT3{ 2.0f, 2.0f, -5.0f }));
+		CHECK(near3(corner(mesh, 0, 2).position, XMFLOAT3{ 2.0f, 0.0f, -5.0f }));
+		CHECK(near3(corner(mesh, 1, 1).position, XMFLOAT3{ 0.0f, 2.0f, -5.0f }));
+		CHECK(corner(mesh, 0, 2).texCoords.x == 1.0f && corner(mesh, 0, 2).texCoords.y == 1.0f);
+		CHECK(near3(corner(mesh, 0, 0).normal, XMFLOAT3{ 0.0f, 0.0f, -1.0f }));
+	}
+
+	//-------------------------------------------------------
+	void testObj()
+	{
+		//A quad as one polygon, then a triangle of the same corners through negative indices
+		ImportedMesh mesh;
+		CHECK(importText("TestMeshImporter.obj",
+			"# comment\no quad\nv 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\ns off\n"
+			"f 1/1/1 2/2/1 3/3/1 4/4/1\n\tf  -4/-4/-1 -3/-3/-1 -1/-1/-1\r\n", mesh));
+		CHECK(mesh.vertices.size() == 4 && mesh.indices.size() == 9);
+		CHECK(!mesh.generatedNormals);
+
+		//Fans of 0, i, i - 1: corners 1 3 2, 1 4 3, then 1 4 2
+		CHECK(near3(corner(mesh, 0, 0).position, XMFLOAT3{ 0.0f, 0.0f, -1.0f }));
+		CHECK(near3(corner(mesh, 0, 1).position, XMFLOAT3{ 1.0f, 1.0f, -1.0f }));
+		CHECK(near3(corner(mesh, 0, 2).position, XMFLOAT3{ 1.0f, 0.0f, -1.0f }));
+		CHECK(near3(corner(mesh, 1, 1).position, XMFLOAT3{ 0.0f, 1.0f, -1.0f }));
+		CHECK(mesh.indices[6] == mesh.indices[0] && mesh.indices[7] == mesh.indices[4] && mesh.indices[8] == mesh.indices[2]);
+		CHECK(near3(corner(mesh, 0, 0).normal, XMFLOAT3{ 0.0f, 0.0f, -1.0f }));
+		CHECK(corner(mesh, 0, 0).texCoords.x == 0.0f && corner(mesh, 0, 0).texCoords.y == 1.0f);
+
+		//Without normals they are generated, facing the same way as the file's
+		CHECK(importText("TestMeshImporter.obj", "v 0 0 1\nv 1 0 1\nv 1 1 1\nf 1 2 3\n", mesh));
+		CHECK(mesh.generatedNormals && mesh.vertices.size() == 3);
+		CHECK(near3(corner(mesh, 0, 0).normal, XMFLOAT3{ 0.0f, 0.0f, -1.0f }));
+
+		CHECK(!importText("TestMeshImporter.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n", mesh));
+		CHECK(!importText("TestMeshImporter.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 -4\n", mesh));
+		CHECK(!importText("TestMeshImporter.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 0 1 2\n", mesh));
+		CHECK(!importText("TestMeshImporter.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2\n", mesh));
+		CHECK(!importText("TestMeshImporter.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1/1 2/1 3/1\n", mesh));
+		CHECK(!importText("TestMeshImporter.obj", "v 0 x 0\nv 1 0 0\nv 1 1 0\nf 1 2 3\n", mesh));
+		CHECK(!importText("TestMeshImporter.obj", "v 0 0 0\n", mesh));
+		CHECK(!importMesh(tempPath("TestMeshImporterMissing.obj"), mesh));
+	}
+
+	//A grid large enough for several 1 MB chunks, with negative indices reaching back into
+	//earlier chunks, comes out the same as it does from a single chunk
+	//-------------------------------------------------------
+	void testObjChunks()
+	{
+		const uint32_t size{ 300 };
+		const uint32_t row{ size + 1 };
+		std::string text;
+		char line[160];
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				std::snprintf(line, sizeof(line), "v %u.25 %u.5 -0.125e1\nvt %u %u\n", x, y, x, y);
+				text += line;
+			}
+		}
+		const int64_t total{ int64_t{ row } * row };
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const int64_t i{ int64_t{ y } * row + x + 1 };
+				std::snprintf(line, sizeof(line), "f %lld/%lld %lld/%lld %lld/%lld\nf %lld/%lld %lld/%lld %lld/%lld %lld/%lld\n",
+					static_cast<long long>(i), static_cast<long long>(i), static_cast<long long>(i + row), static_cast<long long>(i + row),
+					static_cast<long long>(i + row + 1), static_cast<long long>(i + row + 1),
+					static_cast<long long>(i - total - 1), static_cast<long long>(i - total - 1),
+					static_cast<long long>(i + row + 1 - total - 1), static_cast<long long>(i + row + 1 - total - 1),
+					static_cast<long long>(i + 1 - total - 1), static_cast<long long>(i + 1 - total - 1),
+					static_cast<long long>(i + 1 - total - 1), static_cast<long long>(i + 1 - total - 1));
+				text += line;
+			}
+		}
+		CHECK(text.size() > 8 * (1 << 20));
+
+		ImportedMesh chunked;
+		CHECK(importText("TestMeshImporterChunks.obj", text, chunked));
+		setParallelWorkerCount(1);
+		ImportedMesh single;
+		CHECK(importText("TestMeshImporterChunks.obj", text, single));
+		setParallelWorkerCount(4);
+
+		//The second face is a quad whose last corner repeats, a degenerate fan triangle
+		CHECK(chunked.indices.size() == size_t{ size } * size * 9);
+		CHECK(chunked.vertices.size() == size_t{ row } * row);
+		CHECK(chunked.indices == single.indices);
+		CHECK(chunked.vertices.size() == single.vertices.size());
+
+		//Generated normals are summed in a different order on more threads
+		bool valid{ true };
+		for (size_t i{ 0 }; i < chunked.vertices.size(); i++)
+		{
+			const VertexNormTex& vertex = chunked.vertices[i];
+			valid = valid && memcmp(&vertex.position, &single.vertices[i].position, sizeof(XMFLOAT3)) == 0 &&
+				memcmp(&vertex.texCoords, &single.vertices[i].texCoords, sizeof(XMFLOAT2)) == 0 && near3(vertex.normal, single.vertices[i].normal);
+			const float x = vertex.position.x - 0.25f;
+			const float y = vertex.position.y - 0.5f;
+			valid = valid && vertex.position.z == 1.25f && x == vertex.texCoords.x && y == 1.0f - vertex.texCoords.y;
+		}
+		CHECK(valid);
+		const VertexNormTex& last = corner(chunked, chunked.indices.size() / 3 - 2, 2);
+		CHECK(last.position.x == size + 0.25f && last.position.y == size + 0.5f);
+	}
+
+	//-------------------------------------------------------
+	void testGltf()
+	{
+		const std::vector<uint8_t> buffer = quadBuffer();
+		ImportedMesh mesh;
+		ImportStats stats;
+
+		CHECK(importText("TestMeshImporter.gltf", quadGltf(R"(,"uri":"data:application/octet-stream;base64,)" + base64(buffer) + "\""), mesh));
+		checkQuad(mesh);
+
+		//External buffers are found next to the .gltf
+		const std::string binName = tempPath("TestMeshImporter.bin");
+		writeText(binName, std::string(buffer.begin(), buffer.end()));
+		const std::string gltfName = tempPath("TestMeshImporter.gltf");
+		writeText(gltfName, quadGltf(R"(,"uri":"TestMeshImporter.bin")"));
+		CHECK(importGltf(gltfName, mesh, &stats));
+		checkQuad(mesh);
+		CHECK(stats.fileBytes == std::filesystem::file_size(gltfName) + buffer.size());
+		CHECK(stats.sourceVertices == 4);
+		std::filesystem::remove(binName);
+		CHECK(!importGltf(gltfName, mesh));
+		std::filesystem::remove(gltfName);
+
+		const std::vector<uint8_t> binary = glb(quadGltf(""), buffer);
+		CHECK(importText("TestMeshImporter.glb", std::string(binary.begin(), binary.end()), mesh));
+		checkQuad(mesh);
+
+		//Version 1 containers, an accessor past its view, bad JSON and an index past the vertices
+		const std::vector<uint8_t> version1 = glb(quadGltf(""), buffer, 1);
+		CHECK(!importText("TestMeshImporter.glb", std::string(version1.begin(), version1.end()), mesh));
+		const std::vector<uint8_t> pastView = glb(quadGltf("", 5), buffer);
+		CHECK(!importText("TestMeshImporter.glb", std::string(pastView.begin(), pastView.end()), mesh));
+		const std::vector<uint8_t> badJson = glb(quadGltf("").substr(1), buffer);
+		CHECK(!importText("TestMeshImporter.glb", std::string(badJson.begin(), badJson.end()), mesh));
+		std::vector<uint8_t> badIndex = buffer;
+		badIndex[80] = 9;
+		const std::vector<uint8_t> badIndexGlb = glb(quadGltf(""), badIndex);
+		CHECK(!importText("TestMeshImporter.glb", std::string(badIndexGlb.begin(), badIndexGlb.end()), mesh));
+	}
+
+	//-------------------------------------------------------
+	void testDeduplicate()
+	{
+		const VertexNormTex a{ XMFLOAT3{ 0.0f, 0.0f, 0.0f }, XMFLOAT3{ 0.0f, 1.0f, 0.0f }, XMFLOAT2{ 0.0f, 0.0f } };
+		VertexNormTex b = a;
+		b.texCoords.x = 1.0f;
+		VertexNormTex c = a;
+		c.normal.y = -1.0f;
+		std::vector<VertexNormTex> vertices{ a, b, a, c, b };
+		std::vector<uint32_t> indices{ 0, 1, 2, 3, 4, 2 };
+		CHECK(deduplicateVertices(vertices, indices) == 3);
+		CHECK(vertices.size() == 3 && vertices[1].texCoords.x == 1.0f && vertices[2].normal.y == -1.0f);
+		CHECK((indices == std::vector<uint32_t>{ 0, 1, 0, 2, 1, 0 }));
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	setParallelWorkerCount(4);
+	RUN_TEST(testObj);
+	RUN_TEST(testObjChunks);
+	RUN_TEST(testGltf);
+	RUN_TEST(testDeduplicate);
+	return checkResult();
+}
@@ -0,0 +1,271 @@
+//Mesh levels of detail: simplifyMesh and buildLodChain error against the measured distance
+//to the full mesh, the parallel chain build, LodSelector hysteresis and grouping by level
+#include "Check.h"
+#include "LodSelector.h"
+#include "Parallel.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	//size x size quads over the unit square, height scaled by amplitude
+	//-------------------------------------------------------
+	void makeHeightField(uint32_t size, float amplitude, std::vector<Position>& positions, std::vector<uint32_t>& indices)
+	{
+		positions.clear();
+		indices.clear();
+		const uint32_t row{ size + 1 };
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				float u = static_cast<float>(x) / size;
+				float v = static_cast<float>(y) / size;
+				positions.push_back({ u, v, amplitude * std::sin(u * 6.0f) * std::cos(v * 5.0f) });
+			}
+		}
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const uint32_t i{ y * row + x };
+				const uint32_t quad[6]{ i, i + row, i + row + 1, i, i + row + 1, i + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	//-------------------------------------------------------
+	float pointSegmentDistance(const XMVECTOR p, const XMVECTOR a, const XMVECTOR b)
+	{
+		XMVECTOR ab = b - a;
+		float t = XMVectorGetX(XMVector3Dot(p - a, ab)) / std::max(XMVectorGetX(XMVector3Dot(ab, ab)), 1e-20f);
+		t = std::min(std::max(t, 0.0f), 1.0f);
+		return XMVectorGetX(XMVector3Length(p - (a + ab * t)));
+	}
+
+	//-------------------------------------------------------
+	float pointTriangleDistance(const Position& point, const Position& a, const Position& b, const Position& c)
+	{
+		XMVECTOR p = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&point));
+		XMVECTOR v0 = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&a));
+		XMVECTOR v1 = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&b));
+		XMVECTOR v2 = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&c));
+		XMVECTOR normal = XMVector3Normalize(XMVector3Cross(v1 - v0, v2 - v0));
+		float planeDistance = XMVectorGetX(XMVector3Dot(p - v0, normal));
+		XMVECTOR projected = p - normal * planeDistance;
+
+		//Inside when the projection is on the inner side of all three edges
+		auto inner = [&](XMVECTOR from, XMVECTOR to)
+		{
+			return XMVectorGetX(XMVector3Dot(XMVector3Cross(to - from, projected - from), normal)) >= 0.0f;
+		};
+		if (inner(v0, v1) && inner(v1, v2) && inner(v2, v0))
+		{
+			return std::fabs(planeDistance);
+		}
+		return std::min({ pointSegmentDistance(p, v0, v1), pointSegmentDistance(p, v1, v2), pointSegmentDistance(p, v2, v0) });
+	}
+
+	//Distance from every vertex of the full mesh to the nearest triangle of a level
+	//-------------------------------------------------------
+	void measureDistance(const std::vector<Position>& positions, const std::vector<uint32_t>& indices, const MeshLod& level,
+		float& maxDistance, float& meanDistance)
+	{
+		maxDistance = 0.0f;
+		double sum{ 0.0 };
+		for (const Position& point : positions)
+		{
+			float nearest{ 1e30f };
+			for (uint32_t i{ level.startIndex }; i < level.startIndex + level.indexCount; i += 3)
+			{
+				nearest = std::min(nearest, pointTriangleDistance(point, positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]]));
+			}
+			maxDistance = std::max(maxDistance, nearest);
+			sum += nearest;
+		}
+		meanDistance = static_cast<float>(sum / positions.size());
+	}
+
+	//A plane loses most of its triangles at no cost, and keeps its corners
+	//-------------------------------------------------------
+	void testFlatMesh()
+	{
+		std::vector<Position> positions;
+		std::vector<uint32_t> indices;
+		makeHeightField(16, 0.0f, positions, indices);
+		std::vector<uint32_t> simplified(indices.size());
+		float error{ -1.0f };
+		const size_t count = simplifyMesh(simplified.data(), indices.data(), indices.size(), positions.data(), sizeof(Position),
+			static_cast<uint32_t>(positions.size()), 24, 0.0f, &error);
+		simplified.resize(count);
+
+		CHECK(count <= indices.size() / 4);
+		CHECK(count % 3 == 0 && count > 0);
+		CHECK(error >= 0.0f && error < 1e-4f);
+		for (uint32_t corner : { 0u, 16u, 17u * 16u, 17u * 17u - 1u })
+		{
+			CHECK(std::find(simplified.begin(), simplified.end(), corner) != simplified.end());
+		}
+	}
+
+	//Each level's error is the area weighted root mean square distance to the planes it
+	//replaced, summed down the chain. It bounds the mean distance from the full mesh; the
+	//worst single vertex is a small multiple of it
+	//-------------------------------------------------------
+	void testChainErrorBound()
+	{
+		std::vector<Position> positions;
+		std::vector<uint32_t> indices;
+		makeHeightField(40, 0.1f, positions, indices);
+		const uint32_t fullCount = static_cast<uint32_t>(indices.size());
+		LodChainSettings settings;
+		const std::vector<MeshLod> lods = buildLodChain(indices, positions.data(), sizeof(Position), static_cast<uint32_t>(positions.size()), settings);
+
+		CHECK(lods.size() >= 4);
+		CHECK(lods[0].startIndex == 0 && lods[0].indexCount == fullCount && lods[0].error == 0.0f);
+		for (size_t level{ 1 }; level < lods.size(); level++)
+		{
+			const MeshLod& lod = lods[level];
+			const MeshLod& previous = lods[level - 1];
+			CHECK(lod.startIndex == previous.startIndex + previous.indexCount);
+			CHECK(lod.indexCount <= previous.indexCount - previous.indexCount / 8);
+			CHECK(lod.error >= previous.error);
+			CHECK(lod.error <= settings.maxError + 1e-6f);	//relative to the largest side, which is 1
+
+			bool valid{ true };
+			for (uint32_t i{ lod.startIndex }; i < lod.startIndex + lod.indexCount; i += 3)
+			{
+				valid = valid && indices[i] < positions.size() && indices[i + 1] < positions.size() && indices[i + 2] < positions.size();
+				valid = valid && indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2];
+			}
+			CHECK(valid);
+
+			float maxDistance, meanDistance;
+			measureDistance(positions, indices, lod, maxDistance, meanDistance);
+			CHECK(meanDistance <= lod.error);
+			CHECK(maxDistance <= 4.0f * lod.error);
+		}
+		CHECK(indices.size() == size_t{ lods.back().startIndex } + lods.back().indexCount);
+	}
+
+	//The error limit stops simplification before the triangle target
+	//-------------------------------------------------------
+	void testTargetError()
+	{
+		std::vector<Position> positions;
+		std::vector<uint32_t> indices;
+		makeHeightField(32, 0.2f, positions, indices);
+		std::vector<uint32_t> simplified(indices.size());
+		float unlimitedError, limitedError;
+		const size_t unlimited = simplifyMesh(simplified.data(), indices.data(), indices.size(), positions.data(), sizeof(Position),
+			static_cast<uint32_t>(positions.size()), 30, 0.0f, &unlimitedError);
+		const size_t limited = simplifyMesh(simplified.data(), indices.data(), indices.size(), positions.data(), sizeof(Position),
+			static_cast<uint32_t>(positions.size()), 30, 0.002f, &limitedError);
+		CHECK(limitedError <= 0.002f);
+		CHECK(unlimitedError > 0.002f);
+		CHECK(limited > unlimited);
+	}
+
+	//Meshes built across workers come out as they do one at a time
+	//-------------------------------------------------------
+	void testParallelChains()
+	{
+		std::vector<std::vector<Position>> positions(6);
+		std::vector<std::vector<uint32_t>> indices(6);
+		std::vector<std::vector<uint32_t>> serialIndices(6);
+		std::vector<std::vector<MeshLod>> lods(6);
+		std::vector<LodMesh> meshes(6);
+		for (uint32_t i{ 0 }; i < 6; i++)
+		{
+			makeHeightField(8 + i * 6, 0.05f * (i + 1), positions[i], indices[i]);
+			serialIndices[i] = indices[i];
+			meshes[i] = { &indices[i], positions[i].data(), sizeof(Position), static_cast<uint32_t>(positions[i].size()), &lods[i] };
+		}
+		buildLodChains(meshes.data(), meshes.size());
+
+		for (uint32_t i{ 0 }; i < 6; i++)
+		{
+			const std::vector<MeshLod> serial = buildLodChain(serialIndices[i], positions[i].data(), sizeof(Position), static_cast<uint32_t>(positions[i].size()));
+			CHECK(serialIndices[i] == indices[i]);
+			bool same = serial.size() == lods[i].size();
+			for (size_t level{ 0 }; same && level < serial.size(); level++)
+			{
+				same = serial[level].startIndex == lods[i][level].startIndex && serial[level].indexCount == lods[i][level].indexCount &&
+					serial[level].error == lods[i][level].error;
+			}
+			CHECK(same);
+		}
+	}
+
+	//-------------------------------------------------------
+	void testSelectorHysteresis()
+	{
+		CHECK_NEAR(LodSelector::projectedRadius(1.0f, 10.0f, 2.0f, 600.0f), 60.0f, 1e-4f);
+		CHECK(LodSelector::projectedRadius(1.0f, 0.5f, 2.0f, 600.0f) > 1e30f);
+
+		//Level 1 is fine below 100 pixels per unit, coarsens only below 75 (1 pixel, 25% margin)
+		const std::vector<MeshLod> lods{ { 0, 300, 0.0f }, { 300, 150, 0.01f }, { 450, 60, 0.04f } };
+		LodSelector selector{ 1.0f, 0.25f };
+		selector.resize(2);
+		CHECK(selector.select(0, lods, 1.0f, 90.0f) == 0);
+		CHECK(selector.select(0, lods, 1.0f, 70.0f) == 1);
+		CHECK(selector.select(0, lods, 1.0f, 90.0f) == 1);
+		CHECK(selector.select(0, lods, 1.0f, 110.0f) == 0);
+		CHECK(selector.select(0, lods, 1.0f, 10.0f) == 2);
+		CHECK(selector.select(0, lods, 1.0f, 1e30f) == 0);
+		CHECK(selector.level(1) == 0);
+
+		//One level or no radius always selects the full mesh
+		CHECK(selector.select(1, { lods[0] }, 1.0f, 1.0f) == 0);
+		CHECK(selector.select(1, lods, 0.0f, 1.0f) == 0);
+	}
+
+	//Instances come out level by level in their original order, out of range levels in the last run
+	//-------------------------------------------------------
+	void testGroupByLevel()
+	{
+		const std::vector<MeshLod> lods{ { 0, 300, 0.0f }, { 300, 150, 0.01f }, { 450, 60, 0.04f } };
+		const float screenRadius[8]{ 1e30f, 10.0f, 70.0f, 1e30f, 10.0f, 70.0f, 10.0f, 1e30f };
+		LodSelector selector;
+		selector.resize(8);
+		for (uint32_t i{ 0 }; i < 8; i++)
+		{
+			selector.select(i, lods, 1.0f, screenRadius[i]);
+		}
+
+		std::vector<uint32_t> grouped;
+		std::vector<uint32_t> counts;
+		selector.groupByLevel({ 7, 6, 5, 4, 2, 1, 0 }, 3, grouped, counts);
+		CHECK((counts == std::vector<uint32_t>{ 2, 2, 3 }));
+		CHECK((grouped == std::vector<uint32_t>{ 7, 0, 5, 2, 6, 4, 1 }));
+
+		//A model with fewer levels than the selector picked from
+		selector.groupByLevel({ 0, 1, 2 }, 2, grouped, counts);
+		CHECK((counts == std::vector<uint32_t>{ 1, 2 }));
+		CHECK((grouped == std::vector<uint32_t>{ 0, 1, 2 }));
+		selector.groupByLevel({}, 0, grouped, counts);
+		CHECK(grouped.empty() && counts.size() == 1 && counts[0] == 0);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	setParallelWorkerCount(4);
+	RUN_TEST(testFlatMesh);
+	RUN_TEST(testChainErrorBound);
+	RUN_TEST(testTargetError);
+	RUN_TEST(testParallelChains);
+	RUN_TEST(testSelectorHysteresis);
+	RUN_TEST(testGroupByLevel);
+	return checkResult();
+}
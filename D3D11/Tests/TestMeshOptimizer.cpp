@@ -0,0 +1,194 @@
+//MeshOptimizer: FIFO cache simulation on hand counted inputs, and every pass keeping the
+//mesh's triangles (vertex values and winding) while improving what it is meant to improve
+#include "Check.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <random>
+
+namespace
+{
+	struct Vertex
+	{
+		float position[3];
+		uint32_t id;
+	};
+
+	//size x size quads of a height field, triangles shuffled so the input order is cache hostile
+	//-------------------------------------------------------
+	void makeShuffledGrid(uint32_t size, std::vector<uint8_t>& vertexBytes, std::vector<uint32_t>& indices)
+	{
+		const uint32_t row{ size + 1 };
+		std::vector<Vertex> vertices(size_t{ row } * row);
+		for (uint32_t y{ 0 }; y < row; y++)
+		{
+			for (uint32_t x{ 0 }; x < row; x++)
+			{
+				const uint32_t i{ y * row + x };
+				vertices[i] = { { static_cast<float>(x), std::sin(x * 0.3f) * std::cos(y * 0.2f), static_cast<float>(y) }, i };
+			}
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (uint32_t y{ 0 }; y < size; y++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const uint32_t i{ y * row + x };
+				triangles.push_back({ i, i + row, i + row + 1 });
+				triangles.push_back({ i, i + row + 1, i + 1 });
+			}
+		}
+		std::mt19937 random{ 7 };
+		std::shuffle(triangles.begin(), triangles.end(), random);
+
+		indices.clear();
+		for (const auto& triangle : triangles)
+		{
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+		}
+		vertexBytes.resize(vertices.size() * sizeof(Vertex));
+		memcpy(vertexBytes.data(), vertices.data(), vertexBytes.size());
+	}
+
+	//Triangles as sorted lists of vertex ids, each rotated so its smallest id comes first
+	//so that winding is kept but the starting corner does not matter
+	//-------------------------------------------------------
+	std::vector<std::array<uint32_t, 3>> triangleSet(const std::vector<uint8_t>& vertexBytes, const std::vector<uint32_t>& indices)
+	{
+		auto id = [&](uint32_t index)
+		{
+			Vertex vertex;
+			memcpy(&vertex, vertexBytes.data() + size_t{ index } * sizeof(Vertex), sizeof(Vertex));
+			return vertex.id;
+		};
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t i{ 0 }; i + 2 < indices.size(); i += 3)
+		{
+			std::array<uint32_t, 3> triangle{ id(indices[i]), id(indices[i + 1]), id(indices[i + 2]) };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	//-------------------------------------------------------
+	void testCacheSimulation()
+	{
+		//Two triangles sharing an edge: 4 misses, 2 per triangle, 1 per vertex
+		const uint32_t quad[6]{ 0, 1, 2, 2, 1, 3 };
+		VertexCacheStats stats = analyzeVertexCache(quad, 6, 4);
+		CHECK(stats.misses == 4);
+		CHECK_NEAR(stats.acmr, 2.0f, 1e-6f);
+		CHECK_NEAR(stats.atvr, 1.0f, 1e-6f);
+
+		//A FIFO of 3 has evicted vertex 0 by the time the last triangle comes back to it
+		const uint32_t fan[9]{ 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+		CHECK(analyzeVertexCache(fan, 9, 6, 3).misses == 9);
+		CHECK(analyzeVertexCache(fan, 9, 6, 16).misses == 6);
+		CHECK_NEAR(analyzeVertexCache(fan, 9, 6, 3).atvr, 1.5f, 1e-6f);
+
+		CHECK(fitsIndex16(0x10000));
+		CHECK(!fitsIndex16(0x10001));
+	}
+
+	//-------------------------------------------------------
+	void testVertexCacheAndOverdraw()
+	{
+		std::vector<uint8_t> vertexBytes;
+		std::vector<uint32_t> indices;
+		makeShuffledGrid(64, vertexBytes, indices);
+		const uint32_t vertexCount = static_cast<uint32_t>(vertexBytes.size() / sizeof(Vertex));
+		const auto original = triangleSet(vertexBytes, indices);
+
+		std::vector<uint32_t> cacheOrder(indices.size());
+		std::vector<uint32_t> clusters;
+		optimizeVertexCache(cacheOrder.data(), indices.data(), indices.size(), vertexCount, 16, &clusters);
+		CHECK(triangleSet(vertexBytes, cacheOrder) == original);
+		CHECK(!clusters.empty() && clusters[0] == 0);
+		CHECK(std::is_sorted(clusters.begin(), clusters.end()));
+
+		//Shuffled input transforms nearly every corner; a grid can get close to 0.5 + border
+		const VertexCacheStats before = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		const VertexCacheStats after = analyzeVertexCache(cacheOrder.data(), cacheOrder.size(), vertexCount);
+		CHECK(before.acmr > 2.0f);
+		CHECK(after.acmr < 0.8f);
+		CHECK(after.atvr < 1.5f);
+
+		//In place gives the same order
+		std::vector<uint32_t> inPlace = indices;
+		optimizeVertexCache(inPlace.data(), inPlace.data(), inPlace.size(), vertexCount);
+		CHECK(inPlace == cacheOrder);
+
+		//Overdraw ordering moves whole clusters, so it keeps the triangles and most of the cache gain
+		std::vector<uint32_t> overdrawOrder(indices.size());
+		const uint32_t clusterCount = optimizeOverdraw(overdrawOrder.data(), cacheOrder.data(), cacheOrder.size(),
+			vertexBytes.data(), sizeof(Vertex), vertexCount, clusters);
+		CHECK(clusterCount >= clusters.size());
+		CHECK(triangleSet(vertexBytes, overdrawOrder) == original);
+		CHECK(analyzeVertexCache(overdrawOrder.data(), overdrawOrder.size(), vertexCount).acmr < after.acmr * 1.05f + 0.05f);
+	}
+
+	//-------------------------------------------------------
+	void testVertexFetch()
+	{
+		//Vertex 4 is unreferenced, first use order is 3, 1, 0, 2
+		std::vector<Vertex> vertices(5);
+		for (uint32_t i{ 0 }; i < 5; i++)
+		{
+			vertices[i] = { { static_cast<float>(i), 0.0f, 0.0f }, i };
+		}
+		std::vector<uint32_t> indices{ 3, 1, 0, 0, 1, 2 };
+		std::vector<Vertex> reordered(5);
+		const uint32_t kept = optimizeVertexFetch(reordered.data(), indices.data(), indices.size(), vertices.data(), 5, sizeof(Vertex));
+		CHECK(kept == 4);
+		CHECK(reordered[0].id == 3 && reordered[1].id == 1 && reordered[2].id == 0 && reordered[3].id == 2);
+		CHECK((indices == std::vector<uint32_t>{ 0, 1, 2, 2, 1, 3 }));
+	}
+
+	//The whole pipeline keeps the mesh, drops unused vertices and reports the cache gain
+	//-------------------------------------------------------
+	void testOptimizeMesh()
+	{
+		std::vector<uint8_t> vertexBytes;
+		std::vector<uint32_t> indices;
+		makeShuffledGrid(48, vertexBytes, indices);
+		const auto original = triangleSet(vertexBytes, indices);
+
+		//An unreferenced vertex at the end is dropped
+		const uint32_t verticesBefore = static_cast<uint32_t>(vertexBytes.size() / sizeof(Vertex));
+		const Vertex unused{ { 0.0f, 0.0f, 0.0f }, 0xFFFFFFFFu };
+		vertexBytes.insert(vertexBytes.end(), reinterpret_cast<const uint8_t*>(&unused), reinterpret_cast<const uint8_t*>(&unused) + sizeof(unused));
+
+		const MeshOptimizeReport report = optimizeMesh(vertexBytes, sizeof(Vertex), offsetof(Vertex, position), indices);
+		CHECK(report.verticesBefore == verticesBefore + 1);
+		CHECK(report.verticesAfter == verticesBefore);
+		CHECK(vertexBytes.size() == size_t{ verticesBefore } * sizeof(Vertex));
+		CHECK(report.clusters >= 1);
+		CHECK(report.after.acmr < report.before.acmr * 0.5f);
+		CHECK(triangleSet(vertexBytes, indices) == original);
+
+		//Indices now walk the vertices forwards: each first use is the next new vertex
+		uint32_t next{ 0 };
+		bool forwards{ true };
+		for (uint32_t index : indices)
+		{
+			forwards = forwards && index <= next;
+			next = std::max(next, index + 1);
+		}
+		CHECK(forwards);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testCacheSimulation);
+	RUN_TEST(testVertexCacheAndOverdraw);
+	RUN_TEST(testVertexFetch);
+	RUN_TEST(testOptimizeMesh);
+	return checkResult();
+}
@@ -0,0 +1,124 @@
+//calculateNormalsParallel against calculateNormals, and generateNormals on a known surface
+#include "Check.h"
+#include "MathHelper.h"
+#include "MeshImporter.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	//Height field of size x size vertices with bumps, the vertex order is shuffled so
+	//triangles reference vertices all over the array
+	//-------------------------------------------------------
+	void buildShuffledGrid(uint32_t size, std::vector<VertexNormTex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<uint32_t> order(size * size);
+		for (uint32_t i{ 0 }; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::shuffle(order.begin(), order.end(), std::mt19937{ 7 });
+
+		vertices.assign(order.size(), VertexNormTex{});
+		for (uint32_t z{ 0 }; z < size; z++)
+		{
+			for (uint32_t x{ 0 }; x < size; x++)
+			{
+				const float height{ std::sin(x * 0.3f) * std::cos(z * 0.2f) };
+				vertices[order[z * size + x]].position = XMFLOAT3{ static_cast<float>(x), height, static_cast<float>(z) };
+			}
+		}
+
+		indices.clear();
+		for (uint32_t z{ 0 }; z + 1 < size; z++)
+		{
+			for (uint32_t x{ 0 }; x + 1 < size; x++)
+			{
+				const uint32_t corner{ z * size + x };
+				indices.insert(indices.end(), { order[corner], order[corner + size], order[corner + 1] });
+				indices.insert(indices.end(), { order[corner + 1], order[corner + size], order[corner + size + 1] });
+			}
+		}
+	}
+
+	//One worker takes the serial fallback, four split the vertices into ranges
+	//-------------------------------------------------------
+	void testParallelMatchesSerial()
+	{
+		for (unsigned int workers : { 1u, 4u })
+		{
+			setParallelWorkerCount(workers);
+			for (uint32_t size : { 2u, 37u, 300u })
+			{
+				std::vector<VertexNormTex> serial;
+				std::vector<uint32_t> indices;
+				buildShuffledGrid(size, serial, indices);
+				std::vector<VertexNormTex> parallel = serial;
+				const int triangleCount{ static_cast<int>(indices.size() / 3) };
+
+				calculateNormals(serial.data(), static_cast<int>(serial.size()), indices.data(), triangleCount);
+				calculateNormalsParallel(parallel.data(), static_cast<int>(parallel.size()), indices.data(), triangleCount);
+
+				float maxError{ 0.0f };
+				for (size_t i{ 0 }; i < serial.size(); i++)
+				{
+					maxError = std::max(maxError, std::fabs(serial[i].normal.x - parallel[i].normal.x));
+					maxError = std::max(maxError, std::fabs(serial[i].normal.y - parallel[i].normal.y));
+					maxError = std::max(maxError, std::fabs(serial[i].normal.z - parallel[i].normal.z));
+				}
+				CHECK(maxError <= 1e-6f);
+			}
+		}
+		setParallelWorkerCount(0);
+	}
+
+	//Existing normals are summed in, like calculateNormals, and unused vertices keep a zero normal
+	//-------------------------------------------------------
+	void testExistingAndUnusedNormals()
+	{
+		std::vector<VertexNormTex> vertices(4, VertexNormTex{});
+		vertices[1].position = XMFLOAT3{ 0.0f, 0.0f, 1.0f };
+		vertices[2].position = XMFLOAT3{ 1.0f, 0.0f, 0.0f };
+		vertices[0].normal = XMFLOAT3{ 5.0f, 0.0f, 0.0f };
+		const uint32_t indices[]{ 0, 1, 2 };
+
+		calculateNormalsParallel(vertices.data(), 4, indices, 1);
+		CHECK_NEAR(vertices[0].normal.x, 5.0f / std::sqrt(26.0f), 1e-6f);
+		CHECK_NEAR(vertices[0].normal.y, 1.0f / std::sqrt(26.0f), 1e-6f);
+		CHECK_NEAR(vertices[1].normal.y, 1.0f, 1e-6f);
+		CHECK(vertices[3].normal.x == 0.0f && vertices[3].normal.y == 0.0f && vertices[3].normal.z == 0.0f);
+	}
+
+	//A flat grid large enough for the parallel path faces up everywhere, whatever its old normals
+	//-------------------------------------------------------
+	void testGenerateNormals()
+	{
+		std::vector<VertexNormTex> vertices;
+		std::vector<uint32_t> indices;
+		buildShuffledGrid(400, vertices, indices);
+		for (VertexNormTex& vertex : vertices)
+		{
+			vertex.position.y = 0.0f;
+			vertex.normal = XMFLOAT3{ 1.0f, 2.0f, 3.0f };
+		}
+		CHECK(indices.size() / 3 >= 65536);
+
+		generateNormals(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), indices.size());
+		int wrong{ 0 };
+		for (const VertexNormTex& vertex : vertices)
+		{
+			wrong += std::fabs(vertex.normal.y - 1.0f) > 1e-6f || vertex.normal.x != 0.0f || vertex.normal.z != 0.0f;
+		}
+		CHECK(wrong == 0);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testParallelMatchesSerial);
+	setParallelWorkerCount(4);
+	RUN_TEST(testExistingAndUnusedNormals);
+	RUN_TEST(testGenerateNormals);
+	return checkResult();
+}
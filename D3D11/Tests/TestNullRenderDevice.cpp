@@ -0,0 +1,182 @@
+//NullRenderDevice: call counting and recording, buffer and texture contents, upload accounting
+//and deferred command lists replayed onto the immediate context
+#include "Check.h"
+#include "NullDeferredContext.h"
+#include <cstring>
+
+namespace
+{
+	//-------------------------------------------------------
+	BufferHandle makeBuffer(NullRenderDevice& device, uint32_t size, ResourceUsage usage, const void* data = nullptr)
+	{
+		return device.createBuffer(BufferDesc{ size, BufferBinding::Constant, usage }, data);
+	}
+
+	//Records a short frame: bind, update, map and draw
+	//-------------------------------------------------------
+	void recordFrame(IRenderContext& context, BufferHandle constants, BufferHandle dynamic, TextureHandle texture)
+	{
+		const float color[4]{ 1.0f, 0.5f, 0.25f, 1.0f };
+		context.clear(color, 1.0f, 0);
+		context.setViewport({ 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f });
+		const uint32_t value{ 0x12345678 };
+		context.updateBuffer(constants, 4, &value, sizeof(value));
+		uint8_t* mapped = static_cast<uint8_t*>(context.mapBuffer(dynamic, MapMode::WriteDiscard));
+		memset(mapped, 0xAB, 64);
+		context.unmapBuffer(dynamic);
+		context.setConstantBuffer(ShaderStage::Vertex, 1, constants, 0, 16);
+		context.setTexture(ShaderStage::Pixel, 0, texture);
+		context.drawIndexed(36, 0, 0);
+		context.drawIndexedInstanced(36, 100, 0, 0, 0);
+	}
+
+	//-------------------------------------------------------
+	void testCountsAndRecording()
+	{
+		NullRenderDevice device;
+		const BufferHandle constants = makeBuffer(device, 256, ResourceUsage::Default);
+		const BufferHandle dynamic = makeBuffer(device, 64, ResourceUsage::Dynamic);
+		const uint8_t pixel[4]{ 1, 2, 3, 4 };
+		const TextureHandle texture = device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4);
+
+		NullRenderContext& context = device.nullContext();
+		context.resetStats();
+		context.setRecording(true);
+		recordFrame(context, constants, dynamic, texture);
+
+		const RenderStats& stats = context.stats();
+		CHECK(stats.totalCalls() == 9);
+		CHECK(stats.drawCalls() == 2);
+		CHECK(stats.indicesDrawn == 36 + 3600);
+		CHECK(stats.instancesDrawn == 101);
+		//updateBuffer counts its bytes, a discard map counts the whole buffer
+		CHECK(stats.bytesUploaded == 4 + 64);
+
+		const std::vector<RecordedCall>& calls = context.recordedCalls();
+		CHECK(calls.size() == 9);
+		CHECK(calls[5].call == RenderCall::SetConstantBuffer && calls[5].args[1] == 1 && calls[5].args[2] == constants.id && calls[5].args[4] == 16);
+		CHECK(calls[8].call == RenderCall::DrawIndexedInstanced && calls[8].args[1] == 100);
+
+		uint32_t stored;
+		memcpy(&stored, device.buffer(constants).bytes.data() + 4, sizeof(stored));
+		CHECK(stored == 0x12345678);
+		CHECK(device.buffer(dynamic).bytes[63] == 0xAB);
+
+		context.clearRecordedCalls();
+		context.setRecording(false);
+		context.drawIndexed(3, 0, 0);
+		CHECK(context.recordedCalls().empty());
+		CHECK(std::string{ renderCallName(RenderCall::DrawIndexed) } == "drawIndexed");
+	}
+
+	//Out of range updates are clipped to the buffer instead of writing past it
+	//-------------------------------------------------------
+	void testUpdateClipping()
+	{
+		NullRenderDevice device;
+		const BufferHandle buffer = makeBuffer(device, 16, ResourceUsage::Default);
+		const uint8_t bytes[32]{ 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7 };
+		device.nullContext().resetStats();
+		device.nullContext().updateBuffer(buffer, 8, bytes, sizeof(bytes));
+		device.nullContext().updateBuffer(buffer, 100, bytes, sizeof(bytes));
+		CHECK(device.nullContext().stats().bytesUploaded == 8);
+		CHECK(device.buffer(buffer).bytes[7] == 0 && device.buffer(buffer).bytes[15] == 7);
+	}
+
+	//Textures are stored with tightly packed rows whatever the source pitch
+	//-------------------------------------------------------
+	void testResources()
+	{
+		NullRenderDevice device;
+		uint8_t pixels[3 * 16]{};
+		for (uint32_t y{ 0 }; y < 3; y++)
+		{
+			for (uint32_t i{ 0 }; i < 8; i++)
+			{
+				pixels[y * 16 + i] = static_cast<uint8_t>(y * 10 + i);
+			}
+		}
+		device.resetBytesCreated();
+		const TextureHandle texture = device.createTexture(TextureDesc{ 2, 3, TextureFormat::RGBA8 }, pixels, 16);
+		const NullRenderDevice::TextureData& data = device.texture(texture);
+		CHECK(data.pixels.size() == 24);
+		CHECK(data.pixels[8] == 10 && data.pixels[23] == 27);
+		CHECK(device.bytesCreated() == 24);
+
+		const uint32_t initial[4]{ 1, 2, 3, 4 };
+		const BufferHandle buffer = makeBuffer(device, 16, ResourceUsage::Immutable, initial);
+		CHECK(device.bytesCreated() == 40);
+		CHECK(device.liveBufferCount() == 1 && device.liveTextureCount() == 1);
+		device.destroyBuffer(buffer);
+		device.destroyTexture(texture);
+		CHECK(device.liveBufferCount() == 0 && device.liveTextureCount() == 0);
+
+		const InputElement elements[]{ { "POSITION", 0, VertexFormat::Float3, 0, 0, false }, { "TEXCOORD", 0, VertexFormat::Half2, 0, 12, false } };
+		const InputLayoutHandle layout = device.createInputLayout(elements, 2, nullptr, 0);
+		CHECK(device.inputLayout(layout).size() == 2 && device.inputLayout(layout)[1].format == VertexFormat::Half2);
+
+		device.resize(800, 600);
+		CHECK(device.width() == 800 && device.height() == 600);
+		device.present(1);
+		device.present(0);
+		CHECK(device.presentedFrames() == 2 && device.completedFrames() == 2);
+	}
+
+	//A deferred list replays the same calls and buffer contents as recording on the immediate context;
+	//nothing reaches the device until the list executes
+	//-------------------------------------------------------
+	void testDeferredReplay()
+	{
+		NullRenderDevice device;
+		const BufferHandle constants = makeBuffer(device, 256, ResourceUsage::Default);
+		const BufferHandle dynamic = makeBuffer(device, 64, ResourceUsage::Dynamic);
+		const uint8_t pixel[4]{};
+		const TextureHandle texture = device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4);
+
+		NullRenderContext& context = device.nullContext();
+		context.setRecording(true);
+		recordFrame(context, constants, dynamic, texture);
+		const std::vector<RecordedCall> direct = context.recordedCalls();
+		const std::vector<uint8_t> directConstants = device.buffer(constants).bytes;
+		const std::vector<uint8_t> directDynamic = device.buffer(dynamic).bytes;
+
+		device.buffer(constants).bytes.assign(256, 0);
+		device.buffer(dynamic).bytes.assign(64, 0);
+		context.clearRecordedCalls();
+		context.resetStats();
+
+		std::unique_ptr<IDeferredContext> deferred = device.createDeferredContext();
+		recordFrame(deferred->context(), constants, dynamic, texture);
+		std::unique_ptr<ICommandList> list = deferred->finish();
+		CHECK(context.recordedCalls().empty());
+		CHECK(device.buffer(constants).bytes[4] == 0 && device.buffer(dynamic).bytes[0] == 0);
+		CHECK(static_cast<NullCommandList&>(*list).commandCount() > 0);
+
+		context.executeCommandList(*list);
+		const std::vector<RecordedCall>& replayed = context.recordedCalls();
+		CHECK(replayed.size() == direct.size() + 1);
+		CHECK(replayed[0].call == RenderCall::ExecuteCommandList);
+		bool same{ replayed.size() == direct.size() + 1 };
+		for (size_t i{ 0 }; same && i < direct.size(); i++)
+		{
+			same = replayed[i + 1].call == direct[i].call && memcmp(replayed[i + 1].args, direct[i].args, sizeof(direct[i].args)) == 0;
+		}
+		CHECK(same);
+		CHECK(device.buffer(constants).bytes == directConstants);
+		CHECK(device.buffer(dynamic).bytes == directDynamic);
+
+		//A finished context starts a new, empty list
+		std::unique_ptr<ICommandList> empty = deferred->finish();
+		CHECK(static_cast<NullCommandList&>(*empty).commandCount() == 0);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testCountsAndRecording);
+	RUN_TEST(testUpdateClipping);
+	RUN_TEST(testResources);
+	RUN_TEST(testDeferredReplay);
+	return checkResult();
+}
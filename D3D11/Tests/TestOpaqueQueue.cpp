@@ -0,0 +1,172 @@
+//OpaqueSortKey packing and OpaqueQueue order: pass, shader, material, then front to back,
+//stable for equal keys, the same from push and build and from the serial and parallel sorts
+#include "Check.h"
+#include "OpaqueQueue.h"
+#include <random>
+#include <set>
+#include <tuple>
+
+namespace
+{
+	struct DrawDesc
+	{
+		uint32_t pass;
+		uint32_t shader;
+		uint32_t material;
+		float viewDepth;
+	};
+
+	//Few passes, shaders and materials so many draws share state
+	//-------------------------------------------------------
+	std::vector<DrawDesc> randomDraws(size_t count, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> depth{ 0.0f, 1200.0f };
+		std::vector<DrawDesc> draws(count);
+		for (DrawDesc& draw : draws)
+		{
+			draw = { static_cast<uint32_t>(random() % 3), static_cast<uint32_t>(random() % 8), static_cast<uint32_t>(random() % 64), depth(random) };
+		}
+		return draws;
+	}
+
+	//Shader or material changes when walking draws in order
+	//-------------------------------------------------------
+	template <typename GetDraw>
+	size_t countStateChanges(size_t count, GetDraw&& getDraw)
+	{
+		size_t changes{ 0 };
+		for (size_t i{ 1 }; i < count; i++)
+		{
+			const DrawDesc& a = getDraw(i - 1);
+			const DrawDesc& b = getDraw(i);
+			changes += (a.shader != b.shader ? 1 : 0) + (a.material != b.material ? 1 : 0);
+		}
+		return changes;
+	}
+
+	//-------------------------------------------------------
+	void testKeyFields()
+	{
+		const uint64_t key = OpaqueSortKey::make(5, 300, 70000, 250.0f, 1000.0f);
+		CHECK(OpaqueSortKey::pass(key) == 5);
+		CHECK(OpaqueSortKey::shader(key) == 300);
+		CHECK(OpaqueSortKey::material(key) == 70000);
+
+		//Ids wider than their field are truncated instead of spilling into the next field
+		const uint64_t truncated = OpaqueSortKey::make(0, (1u << OpaqueSortKey::shaderBits) + 7, 0, 0.0f, 1000.0f);
+		CHECK(OpaqueSortKey::shader(truncated) == 7);
+		CHECK(OpaqueSortKey::pass(truncated) == 0);
+
+		//Depth is clamped to [0, maxDepth] and ordered inside a state group
+		const uint64_t depthMask{ (uint64_t{ 1 } << OpaqueSortKey::depthBits) - 1 };
+		CHECK((OpaqueSortKey::make(1, 2, 3, -5.0f, 1000.0f) & depthMask) == 0);
+		CHECK((OpaqueSortKey::make(1, 2, 3, 5000.0f, 1000.0f) & depthMask) == depthMask);
+		CHECK(OpaqueSortKey::make(1, 2, 3, 10.0f, 1000.0f) < OpaqueSortKey::make(1, 2, 3, 10.001f, 1000.0f));
+		CHECK(OpaqueSortKey::make(1, 2, 3, 999.0f, 1000.0f) < OpaqueSortKey::make(1, 2, 4, 0.0f, 1000.0f));
+		CHECK(OpaqueSortKey::make(1, 2, 4, 999.0f, 1000.0f) < OpaqueSortKey::make(1, 3, 0, 0.0f, 1000.0f));
+		CHECK(OpaqueSortKey::make(1, 4095, 4, 999.0f, 1000.0f) < OpaqueSortKey::make(2, 0, 0, 0.0f, 1000.0f));
+	}
+
+	//-------------------------------------------------------
+	void testSortOrder()
+	{
+		const std::vector<DrawDesc> descs = randomDraws(20000, 3);
+		OpaqueQueue queue;
+		queue.setMaxDepth(1000.0f);
+		for (uint32_t i{ 0 }; i < descs.size(); i++)
+		{
+			queue.push(descs[i].pass, descs[i].shader, descs[i].material, descs[i].viewDepth, i);
+		}
+		queue.sort();
+		CHECK(queue.size() == descs.size());
+
+		bool ordered{ true };
+		bool stable{ true };
+		std::vector<bool> seen(descs.size(), false);
+		for (size_t i{ 0 }; i < queue.size(); i++)
+		{
+			seen[queue[i].drawIndex] = true;
+			if (i == 0)
+			{
+				continue;
+			}
+			const OpaqueDraw& a = queue[i - 1];
+			const OpaqueDraw& b = queue[i];
+			const DrawDesc& da = descs[a.drawIndex];
+			const DrawDesc& db = descs[b.drawIndex];
+			auto fields = [](const DrawDesc& d) { return std::make_tuple(d.pass, d.shader, d.material); };
+			ordered = ordered && a.key <= b.key && fields(da) <= fields(db);
+			if (fields(da) == fields(db))
+			{
+				//Front to back inside a group, clamped past maxDepth
+				ordered = ordered && std::min(da.viewDepth, 1000.0f) <= std::min(db.viewDepth, 1000.0f) + 1e-3f;
+			}
+			stable = stable && (a.key != b.key || a.drawIndex < b.drawIndex);
+		}
+		CHECK(ordered);
+		CHECK(stable);
+		CHECK(std::find(seen.begin(), seen.end(), false) == seen.end());
+
+		//Grouping by state cuts shader and material changes well below submission order
+		const size_t unsorted = countStateChanges(descs.size(), [&](size_t i) -> const DrawDesc& { return descs[i]; });
+		const size_t sorted = countStateChanges(queue.size(), [&](size_t i) -> const DrawDesc& { return descs[queue[i].drawIndex]; });
+		CHECK(sorted <= 3 * 8 * 64 * 2);
+		CHECK(sorted * 10 < unsorted);
+	}
+
+	//build fills the same keys as push, and the parallel sort matches the serial one
+	//-------------------------------------------------------
+	void testBuildAndParallelSort()
+	{
+		const std::vector<DrawDesc> descs = randomDraws(100000, 9);
+
+		OpaqueQueue pushed;
+		for (uint32_t i{ 0 }; i < descs.size(); i++)
+		{
+			pushed.push(descs[i].pass, descs[i].shader, descs[i].material, descs[i].viewDepth, i);
+		}
+		pushed.sort(false);
+
+		OpaqueQueue built;
+		built.build(descs.size(), [&](size_t i)
+		{
+			const DrawDesc& d = descs[i];
+			return OpaqueDraw{ OpaqueSortKey::make(d.pass, d.shader, d.material, d.viewDepth, 1000.0f), static_cast<uint32_t>(i) };
+		});
+		built.sort(true);
+
+		CHECK(built.size() == pushed.size());
+		bool same{ true };
+		for (size_t i{ 0 }; i < pushed.size(); i++)
+		{
+			same = same && pushed[i].key == built[i].key && pushed[i].drawIndex == built[i].drawIndex;
+		}
+		CHECK(same);
+
+		//Refills of a reserved queue stay in the two blocks the sort swaps between
+		OpaqueQueue reserved{ descs.size() };
+		std::set<const OpaqueDraw*> blocks;
+		for (int frame{ 0 }; frame < 4; frame++)
+		{
+			reserved.clear();
+			for (uint32_t i{ 0 }; i < descs.size(); i++)
+			{
+				reserved.push(descs[i].pass, descs[i].shader, descs[i].material, descs[i].viewDepth, i);
+			}
+			reserved.sort(true);
+			blocks.insert(reserved.begin());
+		}
+		CHECK(blocks.size() <= 2);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	setParallelWorkerCount(4);
+	RUN_TEST(testKeyFields);
+	RUN_TEST(testSortOrder);
+	RUN_TEST(testBuildAndParallelSort);
+	return checkResult();
+}
@@ -0,0 +1,78 @@
+//parallelFor on the persistent pool: coverage, chunk indices, nesting and thread reuse
+#include "Check.h"
+#include "Parallel.h"
+#include <set>
+#include <vector>
+
+namespace
+{
+	//-------------------------------------------------------
+	void testCoverage()
+	{
+		for (size_t count : { size_t{ 0 }, size_t{ 1 }, size_t{ 7 }, size_t{ 1000 }, size_t{ 100003 } })
+		{
+			std::vector<std::atomic<int>> hits(count);
+			const size_t chunks = parallelChunkCount(count, 16);
+			std::atomic<bool> badChunk{ false };
+			parallelFor(count, 16, [&](size_t chunk, size_t begin, size_t end)
+			{
+				badChunk = badChunk || chunk >= chunks || begin >= end;
+				for (size_t i = begin; i < end; i++)
+				{
+					hits[i]++;
+				}
+			});
+			CHECK(!badChunk);
+			int wrong{ 0 };
+			for (const std::atomic<int>& hit : hits)
+			{
+				wrong += hit != 1;
+			}
+			CHECK(wrong == 0);
+		}
+	}
+
+	//Every chunk of the outer loop runs an inner loop; pool workers blocked in the
+	//outer chunks must not keep the inner chunks from running
+	//-------------------------------------------------------
+	void testNested()
+	{
+		std::atomic<size_t> total{ 0 };
+		parallelFor(64, 1, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				parallelFor(1000, 10, [&](size_t, size_t innerBegin, size_t innerEnd) { total += innerEnd - innerBegin; });
+			}
+		});
+		CHECK(total == 64 * 1000);
+	}
+
+	//Calls reuse the pool's threads instead of starting new ones
+	//-------------------------------------------------------
+	void testThreadReuse()
+	{
+		std::mutex mutex;
+		std::set<std::thread::id> threads;
+		for (int call{ 0 }; call < 200; call++)
+		{
+			parallelFor(64, 1, [&](size_t, size_t, size_t)
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				threads.insert(std::this_thread::get_id());
+			});
+		}
+		CHECK(threads.size() <= parallelPool().workerCount() + 1);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	//More workers than this machine may have, so the multi chunk paths always run
+	setParallelWorkerCount(4);
+	RUN_TEST(testCoverage);
+	RUN_TEST(testNested);
+	RUN_TEST(testThreadReuse);
+	return checkResult();
+}
@@ -0,0 +1,257 @@
+//ParallelRecorder on the null backend: for 1 to 8 threads and several chunk sizes the calls replayed
+//on the immediate context are exactly what a serial StateCache records when it forgets its state at
+//every chunk boundary, and the draws and per draw constants match plain serial submission
+#include "Check.h"
+#include "NullDeferredContext.h"
+#include "ParallelRecorder.h"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	//A cube scene like drawScene's parallel path: a shared pipeline, then per draw constants,
+	//buffers, a texture every few draws and one of three levels of detail
+	struct Scene
+	{
+		VertexShaderHandle vertexShader;
+		PixelShaderHandle pixelShader;
+		InputLayoutHandle inputLayout;
+		BufferHandle vertexBuffer;
+		BufferHandle indexBuffer;
+		BufferHandle constants;
+		SamplerHandle sampler;
+		std::vector<TextureHandle> textures;
+		uint32_t stride{ 32 };
+		uint32_t offset{ 0 };
+
+		explicit Scene(NullRenderDevice& device)
+		{
+			vertexShader = device.createVertexShader(nullptr, 0);
+			pixelShader = device.createPixelShader(nullptr, 0);
+			const InputElement elements[]{ { "POSITION", 0, VertexFormat::Float3, 0, 0, false } };
+			inputLayout = device.createInputLayout(elements, 1, nullptr, 0);
+			vertexBuffer = device.createBuffer(BufferDesc{ 24 * 32, BufferBinding::Vertex, ResourceUsage::Immutable }, nullptr);
+			indexBuffer = device.createBuffer(BufferDesc{ 36 * 4, BufferBinding::Index, ResourceUsage::Immutable }, nullptr);
+			constants = device.createBuffer(BufferDesc{ 1 << 20, BufferBinding::Constant, ResourceUsage::Dynamic }, nullptr);
+			sampler = device.createSampler(SamplerDesc{});
+			const uint8_t pixel[4]{};
+			for (int i{ 0 }; i < 4; i++)
+			{
+				textures.push_back(device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4));
+			}
+		}
+
+		//-------------------------------------------------------
+		void bindPipeline(IRenderContext& context) const
+		{
+			context.setVertexShader(vertexShader);
+			context.setPixelShader(pixelShader);
+			context.setInputLayout(inputLayout);
+			context.setPrimitiveTopology(PrimitiveTopology::TriangleList);
+			context.setConstantBuffer(ShaderStage::Pixel, 1, constants, 0, 16);
+		}
+
+		//-------------------------------------------------------
+		void draw(IRenderContext& context, size_t i) const
+		{
+			const uint32_t element = static_cast<uint32_t>(i);
+			context.setConstantBuffer(ShaderStage::Vertex, 0, constants, 16 + element * 16, 16);
+			context.setConstantBuffer(ShaderStage::Pixel, 0, constants, 16 + element * 16, 16);
+			context.setVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+			context.setIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+			context.setTexture(ShaderStage::Pixel, 0, textures[i / 13 % textures.size()]);
+			context.setSampler(ShaderStage::Pixel, 0, sampler);
+			context.drawIndexed(36 >> (i % 3), 0, 0);
+		}
+
+		//-------------------------------------------------------
+		void drawRange(IRenderContext& context, size_t begin, size_t end) const
+		{
+			bindPipeline(context);
+			for (size_t i{ begin }; i < end; i++)
+			{
+				draw(context, i);
+			}
+		}
+	};
+
+	//-------------------------------------------------------
+	bool sameCalls(const RecordedCall* a, const RecordedCall* b, size_t count)
+	{
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			if (a[i].call != b[i].call || memcmp(a[i].args, b[i].args, sizeof(a[i].args)) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Draws and per object constant binds, the calls that have to survive any chunking
+	//-------------------------------------------------------
+	std::vector<RecordedCall> drawCalls(const std::vector<RecordedCall>& calls)
+	{
+		std::vector<RecordedCall> draws;
+		for (const RecordedCall& call : calls)
+		{
+			if (call.call == RenderCall::DrawIndexed || (call.call == RenderCall::SetConstantBuffer && call.args[1] == 0))
+			{
+				draws.push_back(call);
+			}
+		}
+		return draws;
+	}
+
+	//-------------------------------------------------------
+	void testChunkCount()
+	{
+		NullRenderDevice device;
+		ParallelRecorder recorder{ device, 4 };
+		CHECK(recorder.threadCount() == 4);
+		CHECK(recorder.chunkCount(0, 1) == 0);
+		CHECK(recorder.chunkCount(3, 1) == 3);
+		CHECK(recorder.chunkCount(1000, 1) == 4);
+		CHECK(recorder.chunkCount(1000, 400) == 3);
+		CHECK(recorder.chunkCount(1000, 0) == 4);
+		CHECK(recorder.chunkCount(1000, 5000) == 1);
+		//10 draws over 6 threads are chunks of 2, which makes 5 of them
+		CHECK(ParallelRecorder(device, 6).chunkCount(10, 1) == 5);
+
+		ParallelRecorder single{ device, 0 };
+		CHECK(single.threadCount() == 1 && single.chunkCount(1000, 1) == 1);
+	}
+
+	//-------------------------------------------------------
+	void testMatchesSerial()
+	{
+		NullRenderDevice device;
+		const Scene scene{ device };
+		NullRenderContext& immediate = device.nullContext();
+		immediate.setRecording(true);
+
+		//Plain serial submission through one StateCache
+		const size_t count{ 1000 };
+		{
+			StateCache serial{ immediate };
+			scene.drawRange(serial, 0, count);
+		}
+		const std::vector<RecordedCall> serialDraws = drawCalls(immediate.recordedCalls());
+		CHECK(serialDraws.size() == count * 3);
+
+		bool allMatch{ true };
+		bool drawsMatch{ true };
+		bool pipelineAtEveryChunk{ true };
+		bool statsValid{ true };
+		for (unsigned int threads{ 1 }; threads <= 8; threads++)
+		{
+			ParallelRecorder recorder{ device, threads };
+			for (size_t minChunkSize : { size_t{ 1 }, size_t{ 7 }, size_t{ 130 }, size_t{ 400 }, count })
+			{
+				const size_t numChunks = recorder.chunkCount(count, minChunkSize);
+				const size_t chunkSize = (count + numChunks - 1) / numChunks;
+
+				//The reference: a fresh cache per chunk, as each list starts from nothing bound
+				immediate.clearRecordedCalls();
+				for (size_t chunk{ 0 }; chunk < numChunks; chunk++)
+				{
+					StateCache cache{ immediate };
+					scene.drawRange(cache, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+				}
+				const std::vector<RecordedCall> expected = immediate.recordedCalls();
+
+				//Twice, so reused deferred contexts and caches start clean as well
+				for (int frame{ 0 }; frame < 2; frame++)
+				{
+					immediate.clearRecordedCalls();
+					recorder.record(immediate, count, minChunkSize, [&scene](IRenderContext& context, size_t begin, size_t end)
+					{
+						scene.drawRange(context, begin, end);
+					});
+					const std::vector<RecordedCall>& replayed = immediate.recordedCalls();
+
+					//Strip the ExecuteCommandList markers, which must come right before each chunk's pipeline
+					std::vector<RecordedCall> calls;
+					size_t lists{ 0 };
+					for (size_t i{ 0 }; i < replayed.size(); i++)
+					{
+						if (replayed[i].call == RenderCall::ExecuteCommandList)
+						{
+							lists++;
+							pipelineAtEveryChunk = pipelineAtEveryChunk && i + 1 < replayed.size() && replayed[i + 1].call == RenderCall::SetVertexShader;
+							continue;
+						}
+						calls.push_back(replayed[i]);
+					}
+					pipelineAtEveryChunk = pipelineAtEveryChunk && lists == numChunks;
+					allMatch = allMatch && calls.size() == expected.size() && sameCalls(calls.data(), expected.data(), calls.size());
+					const std::vector<RecordedCall> draws = drawCalls(calls);
+					drawsMatch = drawsMatch && draws.size() == serialDraws.size() && sameCalls(draws.data(), serialDraws.data(), draws.size());
+
+					const ParallelRecordStats& stats = recorder.stats();
+					statsValid = statsValid && stats.chunks == numChunks && stats.chunkNanoseconds >= stats.longestChunkNanoseconds &&
+						stats.longestChunkNanoseconds > 0;
+				}
+			}
+		}
+		CHECK(allMatch);
+		CHECK(drawsMatch);
+		CHECK(pipelineAtEveryChunk);
+		CHECK(statsValid);
+	}
+
+	//Within a chunk shared state is bound once; every chunk binds it again
+	//-------------------------------------------------------
+	void testStateResetPerChunk()
+	{
+		NullRenderDevice device;
+		const Scene scene{ device };
+		NullRenderContext& immediate = device.nullContext();
+
+		ParallelRecorder recorder{ device, 6 };
+		immediate.resetStats();
+		recorder.record(immediate, 600, 1, [&scene](IRenderContext& context, size_t begin, size_t end)
+		{
+			scene.drawRange(context, begin, end);
+		});
+		const RenderStats& stats = immediate.stats();
+		CHECK(recorder.stats().chunks == 6);
+		CHECK(stats.count(RenderCall::ExecuteCommandList) == 6);
+		CHECK(stats.count(RenderCall::SetVertexShader) == 6 && stats.count(RenderCall::SetInputLayout) == 6);
+		CHECK(stats.count(RenderCall::SetVertexBuffers) == 6 && stats.count(RenderCall::SetSampler) == 6);
+		CHECK(stats.drawCalls() == 600);
+		CHECK(stats.count(RenderCall::SetConstantBuffer) == 6 + 2 * 600);
+		//Textures change every 13 draws; a chunk of 100 starting mid run binds its first one again
+		uint32_t textureChanges{ 0 };
+		for (size_t i{ 0 }; i < 600; i++)
+		{
+			textureChanges += i % 100 == 0 || i % 13 == 0;
+		}
+		CHECK(stats.count(RenderCall::SetTexture) == textureChanges);
+	}
+
+	//Nothing to draw records nothing and calls back never
+	//-------------------------------------------------------
+	void testEmpty()
+	{
+		NullRenderDevice device;
+		NullRenderContext& immediate = device.nullContext();
+		ParallelRecorder recorder{ device, 4 };
+		immediate.resetStats();
+		bool called{ false };
+		recorder.record(immediate, 0, 1, [&called](IRenderContext&, size_t, size_t) { called = true; });
+		CHECK(!called);
+		CHECK(recorder.stats().chunks == 0);
+		CHECK(immediate.stats().totalCalls() == 0);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testChunkCount);
+	RUN_TEST(testMatchesSerial);
+	RUN_TEST(testStateResetPerChunk);
+	RUN_TEST(testEmpty);
+	return checkResult();
+}
@@ -0,0 +1,119 @@
+//Checks the DirectXMath subset in Portable against hand computed results, the other
+//tests rely on it off Windows. On Windows it checks the SDK's DirectXMath the same way
+#include "Check.h"
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	//-------------------------------------------------------
+	bool nearMatrix(FXMMATRIX a, CXMMATRIX b, float tolerance)
+	{
+		XMFLOAT4X4 fa, fb;
+		XMStoreFloat4x4(&fa, a);
+		XMStoreFloat4x4(&fb, b);
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				if (std::fabs(fa.m[row][column] - fb.m[row][column]) > tolerance)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------
+	void testVectors()
+	{
+		XMVECTOR a = XMVectorSet(1.0f, 2.0f, 3.0f, 4.0f);
+		XMVECTOR b = XMVectorSet(-2.0f, 0.5f, 1.0f, 0.0f);
+		XMFLOAT3 cross;
+		XMStoreFloat3(&cross, XMVector3Cross(a, b));
+		CHECK_NEAR(cross.x, 2.0f * 1.0f - 3.0f * 0.5f, 1e-6f);
+		CHECK_NEAR(cross.y, 3.0f * -2.0f - 1.0f * 1.0f, 1e-6f);
+		CHECK_NEAR(cross.z, 1.0f * 0.5f - 2.0f * -2.0f, 1e-6f);
+		CHECK_NEAR(XMVectorGetX(XMVector3LengthSq(a)), 14.0f, 1e-6f);
+		CHECK_NEAR(XMVectorGetX(XMVector3Length(XMVector3Normalize(a))), 1.0f, 1e-6f);
+		CHECK(XMVectorGetX(XMVector3LengthSq(XMVector3Normalize(XMVectorZero()))) == 0.0f);
+
+		//The plane scales as a whole, d included
+		XMFLOAT4 plane;
+		XMStoreFloat4(&plane, XMPlaneNormalize(XMVectorSet(0.0f, 3.0f, 4.0f, 10.0f)));
+		CHECK_NEAR(plane.y, 0.6f, 1e-6f);
+		CHECK_NEAR(plane.z, 0.8f, 1e-6f);
+		CHECK_NEAR(plane.w, 2.0f, 1e-6f);
+
+		XMFLOAT4 w;
+		XMStoreFloat4(&w, XMVectorSetW(a, 9.0f));
+		CHECK(w.x == 1.0f && w.y == 2.0f && w.z == 3.0f && w.w == 9.0f);
+	}
+
+	//-------------------------------------------------------
+	void testMatrices()
+	{
+		XMMATRIX world = XMMatrixScaling(2.0f, 3.0f, 4.0f) * XMMatrixRotationQuaternion(XMVector4Normalize(XMVectorSet(0.3f, -0.2f, 0.5f, 0.8f))) * XMMatrixTranslation(1.0f, -2.0f, 5.0f);
+		CHECK(nearMatrix(world * XMMatrixInverse(nullptr, world), XMMatrixIdentity(), 1e-5f));
+		CHECK(nearMatrix(XMMatrixTranspose(XMMatrixTranspose(world)), world, 0.0f));
+
+		//Row vectors: translation applies to points, not to normals
+		XMFLOAT3 point, normal;
+		XMStoreFloat3(&point, XMVector3TransformCoord(XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), XMMatrixTranslation(1.0f, 2.0f, 3.0f)));
+		XMStoreFloat3(&normal, XMVector3TransformNormal(XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), XMMatrixTranslation(1.0f, 2.0f, 3.0f)));
+		CHECK(point.x == 2.0f && point.y == 3.0f && point.z == 4.0f);
+		CHECK(normal.x == 1.0f && normal.y == 1.0f && normal.z == 1.0f);
+
+		//Near plane maps to depth 0, far plane to 1
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 1.5f, 1.0f, 100.0f);
+		CHECK_NEAR(XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), projection)), 0.0f, 1e-6f);
+		CHECK_NEAR(XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 100.0f, 0.0f), projection)), 1.0f, 1e-6f);
+	}
+
+	//-------------------------------------------------------
+	void testHalf()
+	{
+		const float exact[]{ 0.0f, 1.0f, -2.5f, 65504.0f, 0.000061035156f, 0.000000059604645f };
+		for (float value : exact)
+		{
+			CHECK(XMConvertHalfToFloat(XMConvertFloatToHalf(value)) == value);
+		}
+		CHECK(XMConvertFloatToHalf(1.0f) == 0x3C00);
+		CHECK(XMConvertFloatToHalf(-2.0f) == 0xC000);
+		CHECK(XMConvertFloatToHalf(1e6f) == 0x7C00);
+		//Ties go to even: 1 + 2^-11 lies halfway between 1 and the next half
+		CHECK(XMConvertFloatToHalf(1.00048828125f) == 0x3C00);
+		CHECK(XMConvertFloatToHalf(1.00146484375f) == 0x3C02);
+
+		//Every half that is not a NaN survives the round trip
+		int mismatches{ 0 };
+		for (uint32_t bits = 0; bits < 0x10000; bits++)
+		{
+			const HALF half{ static_cast<HALF>(bits) };
+			if ((half & 0x7C00) != 0x7C00 || (half & 0x3FF) == 0)
+			{
+				mismatches += XMConvertFloatToHalf(XMConvertHalfToFloat(half)) != half;
+			}
+		}
+		CHECK(mismatches == 0);
+
+		//Relative error of a normal half is at most 2^-11
+		for (float value = 0.001f; value < 60000.0f; value *= 1.37f)
+		{
+			CHECK_NEAR(XMConvertHalfToFloat(XMConvertFloatToHalf(value)), value, value * (1.0f / 2048.0f));
+		}
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testVectors);
+	RUN_TEST(testMatrices);
+	RUN_TEST(testHalf);
+	return checkResult();
+}
@@ -0,0 +1,324 @@
+//Profiler: nearest rank frame time percentiles, the frame time ring, scope capture on one and several
+//threads and profilers, and the Chrome trace event JSON the capture is written as
+#include "Check.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	//One "X" event line of a trace
+	struct TraceEvent
+	{
+		std::string name;
+		double ts;
+		double dur;
+		uint32_t tid;
+	};
+
+	//Checks the layout writeChromeTrace produces, one event per line, and returns the events
+	//-------------------------------------------------------
+	std::vector<TraceEvent> parseTrace(const Profiler& profiler, bool& wellFormed)
+	{
+		std::ostringstream out;
+		profiler.writeChromeTrace(out);
+		const std::string text = out.str();
+		const std::string head{ "{\"traceEvents\":[" };
+		const std::string tail{ "\n],\"displayTimeUnit\":\"ms\"}\n" };
+		wellFormed = text.compare(0, head.size(), head) == 0 && text.size() >= head.size() + tail.size() &&
+			text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+
+		std::vector<TraceEvent> events;
+		std::istringstream lines{ text.substr(head.size(), text.size() - head.size() - tail.size()) };
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			if (line.empty())
+			{
+				continue;
+			}
+			char name[64]{};
+			TraceEvent event{};
+			int length{ 0 };
+			const int fields = std::sscanf(line.c_str(), "{\"name\":\"%63[^\"]\",\"ph\":\"X\",\"ts\":%lf,\"dur\":%lf,\"pid\":1,\"tid\":%u}%n",
+				name, &event.ts, &event.dur, &event.tid, &length);
+			//Every event but the last is followed by a comma
+			const bool last = lines.peek() == std::char_traits<char>::eof();
+			wellFormed = wellFormed && fields == 4 && line.size() == static_cast<size_t>(length) + (last ? 0 : 1) && (last || line.back() == ',');
+			event.name = name;
+			events.push_back(event);
+		}
+		return events;
+	}
+
+	//-------------------------------------------------------
+	void testPercentiles()
+	{
+		std::vector<float> samples;
+		for (int i{ 1 }; i <= 1000; i++)
+		{
+			samples.push_back(static_cast<float>(i));
+		}
+		std::shuffle(samples.begin(), samples.end(), std::mt19937{ 7 });
+		FrameStats stats = computeFrameStats(samples);
+		CHECK(stats.sampleCount == 1000);
+		CHECK(stats.p50Ms == 500.0 && stats.p95Ms == 950.0 && stats.p99Ms == 990.0 && stats.maxMs == 1000.0);
+		CHECK_NEAR(stats.averageMs, 500.5, 1e-9);
+
+		//Nearest rank rounds up: the 95th of 10 samples is the 10th
+		samples = { 5.0f, 1.0f, 9.0f, 3.0f, 7.0f, 2.0f, 8.0f, 4.0f, 6.0f, 10.0f };
+		stats = computeFrameStats(samples);
+		CHECK(stats.p50Ms == 5.0 && stats.p95Ms == 10.0 && stats.p99Ms == 10.0 && stats.maxMs == 10.0);
+
+		samples = { 16.7f };
+		stats = computeFrameStats(samples);
+		CHECK(stats.sampleCount == 1 && stats.p50Ms == stats.maxMs && std::fabs(stats.p99Ms - 16.7) < 1e-5);
+
+		samples.clear();
+		stats = computeFrameStats(samples);
+		CHECK(stats.sampleCount == 0 && stats.maxMs == 0.0);
+	}
+
+	//-------------------------------------------------------
+	void testFrameTimeRing()
+	{
+		FrameTimeRing ring{ 5 };
+		CHECK(ring.capacity() == 8);
+		CHECK(FrameTimeRing{ 0 }.capacity() == 1);
+
+		std::vector<float> samples;
+		ring.snapshot(samples);
+		CHECK(samples.empty());
+
+		ring.push(1.0f);
+		ring.push(2.0f);
+		ring.push(3.0f);
+		ring.snapshot(samples);
+		CHECK((samples == std::vector<float>{ 1.0f, 2.0f, 3.0f }));
+
+		//Wrapped twice and a bit: the newest eight, oldest first
+		for (int i{ 4 }; i <= 20; i++)
+		{
+			ring.push(static_cast<float>(i));
+		}
+		ring.snapshot(samples);
+		CHECK((samples == std::vector<float>{ 13.0f, 14.0f, 15.0f, 16.0f, 17.0f, 18.0f, 19.0f, 20.0f }));
+
+		ring.clear();
+		ring.snapshot(samples);
+		CHECK(samples.empty());
+		ring.push(21.0f);
+		ring.snapshot(samples);
+		CHECK((samples == std::vector<float>{ 21.0f }));
+	}
+
+	//-------------------------------------------------------
+	void testFrameMarks()
+	{
+		Profiler profiler{ 4 };
+		profiler.markFrame();
+		CHECK(profiler.frameCount() == 0 && profiler.frameStats().sampleCount == 0);
+		for (int i{ 0 }; i < 6; i++)
+		{
+			profiler.markFrame();
+		}
+		CHECK(profiler.frameCount() == 6);
+		const FrameStats stats = profiler.frameStats();
+		CHECK(stats.sampleCount == 4 && stats.maxMs >= stats.p50Ms && stats.p50Ms >= 0.0);
+	}
+
+	//Disabled timers record nothing; enabling clears the last capture
+	//-------------------------------------------------------
+	void testEnable()
+	{
+		Profiler profiler;
+		bool wellFormed{ false };
+		{
+			ScopedCpuTimer timer{ profiler, "disabled" };
+		}
+		CHECK(parseTrace(profiler, wellFormed).empty() && wellFormed);
+
+		profiler.setEnabled(true);
+		CHECK(profiler.isEnabled());
+		{
+			ScopedCpuTimer timer{ profiler, "first" };
+		}
+		profiler.setEnabled(false);
+		{
+			ScopedCpuTimer timer{ profiler, "disabled" };
+		}
+		std::vector<TraceEvent> events = parseTrace(profiler, wellFormed);
+		CHECK(wellFormed && events.size() == 1 && events[0].name == "first");
+
+		//Disabling keeps the capture for export, enabling again starts over
+		profiler.setEnabled(true);
+		{
+			ScopedCpuTimer timer{ profiler, "second" };
+		}
+		events = parseTrace(profiler, wellFormed);
+		CHECK(wellFormed && events.size() == 1 && events[0].name == "second");
+	}
+
+	//-------------------------------------------------------
+	void testNestedScopes()
+	{
+		Profiler profiler;
+		profiler.setEnabled(true);
+		{
+			ScopedCpuTimer outer{ profiler, "outer" };
+			{
+				ScopedCpuTimer inner{ profiler, "inner" };
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+			}
+			ScopedCpuTimer after{ profiler, "after" };
+		}
+
+		//Inner scopes close first
+		bool wellFormed{ false };
+		const std::vector<TraceEvent> events = parseTrace(profiler, wellFormed);
+		CHECK(wellFormed && events.size() == 3);
+		if (events.size() == 3)
+		{
+			const TraceEvent& inner = events[0];
+			const TraceEvent& after = events[1];
+			const TraceEvent& outer = events[2];
+			CHECK(inner.name == "inner" && after.name == "after" && outer.name == "outer");
+			//ts and dur are each rounded to the nanosecond
+			const double rounding{ 0.002 };
+			CHECK(outer.ts <= inner.ts && inner.ts + inner.dur <= after.ts + rounding && after.ts + after.dur <= outer.ts + outer.dur + rounding);
+			CHECK(inner.dur >= 1000.0);
+			CHECK(inner.tid == outer.tid && after.tid == outer.tid);
+		}
+	}
+
+	//ts is relative to the capture start and both ts and dur are microseconds
+	//-------------------------------------------------------
+	void testTraceUnits()
+	{
+		Profiler profiler{ 16, 4 };
+		profiler.setEnabled(true);
+		const int64_t start = profilerNow();
+		profiler.recordScope("explicit", start + 1000000, start + 3500000);
+		profiler.recordScope("tiny", start, start + 1);
+
+		bool wellFormed{ false };
+		const std::vector<TraceEvent> events = parseTrace(profiler, wellFormed);
+		CHECK(wellFormed && events.size() == 2);
+		if (events.size() == 2)
+		{
+			CHECK(events[0].name == "explicit" && events[0].dur == 2500.0);
+			CHECK(events[0].ts >= 1000.0 && events[0].ts < 1000.0 + 1e6);
+			CHECK(events[1].dur == 0.001);
+		}
+
+		//Full buffers drop and count the rest
+		for (int i{ 0 }; i < 5; i++)
+		{
+			profiler.recordScope("more", start, start);
+		}
+		CHECK(profiler.droppedScopes() == 3);
+		CHECK(parseTrace(profiler, wellFormed).size() == 4 && wellFormed);
+
+		//Quotes and backslashes in names are escaped
+		Profiler quoting;
+		quoting.setEnabled(true);
+		quoting.recordScope("a \"quoted\"\\name", start, start);
+		std::ostringstream out;
+		quoting.writeChromeTrace(out);
+		CHECK(out.str().find("{\"name\":\"a \\\"quoted\\\"\\\\name\",\"ph\"") != std::string::npos);
+	}
+
+	//Every thread gets a tid of its own, and all of its scopes
+	//-------------------------------------------------------
+	void testThreads()
+	{
+		Profiler profiler;
+		profiler.setEnabled(true);
+		const int threadCount{ 4 };
+		const int scopesPerThread{ 1000 };
+		std::vector<std::thread> threads;
+		for (int t{ 0 }; t < threadCount; t++)
+		{
+			threads.emplace_back([&profiler]()
+			{
+				for (int i{ 0 }; i < scopesPerThread; i++)
+				{
+					ScopedCpuTimer timer{ profiler, "worker" };
+				}
+			});
+		}
+		{
+			ScopedCpuTimer timer{ profiler, "main" };
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		bool wellFormed{ false };
+		const std::vector<TraceEvent> events = parseTrace(profiler, wellFormed);
+		CHECK(wellFormed && events.size() == threadCount * scopesPerThread + 1);
+		std::set<uint32_t> workerTids;
+		uint32_t mainTid{ 0 };
+		for (const TraceEvent& event : events)
+		{
+			if (event.name == "worker")
+			{
+				workerTids.insert(event.tid);
+			}
+			else
+			{
+				mainTid = event.tid;
+			}
+		}
+		CHECK(workerTids.size() == threadCount && workerTids.count(mainTid) == 0);
+		CHECK(profiler.droppedScopes() == 0);
+	}
+
+	//A thread switching between profilers keeps one buffer in each
+	//-------------------------------------------------------
+	void testSeveralProfilers()
+	{
+		Profiler first;
+		Profiler second;
+		first.setEnabled(true);
+		second.setEnabled(true);
+		for (int i{ 0 }; i < 10; i++)
+		{
+			ScopedCpuTimer a{ first, "first" };
+			ScopedCpuTimer b{ second, "second" };
+		}
+		std::thread{ [&first]() { ScopedCpuTimer timer{ first, "other" }; } }.join();
+
+		bool wellFormed{ false };
+		std::vector<TraceEvent> events = parseTrace(first, wellFormed);
+		CHECK(wellFormed && events.size() == 11);
+		bool sameTid{ true };
+		for (size_t i{ 1 }; i < 10 && i < events.size(); i++)
+		{
+			sameTid = sameTid && events[i].tid == events[0].tid;
+		}
+		CHECK(sameTid);
+		CHECK(events.size() == 11 && events[0].tid == 1 && events[10].name == "other" && events[10].tid == 2);
+
+		events = parseTrace(second, wellFormed);
+		CHECK(wellFormed && events.size() == 10 && events.back().tid == 1);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testPercentiles);
+	RUN_TEST(testFrameTimeRing);
+	RUN_TEST(testFrameMarks);
+	RUN_TEST(testEnable);
+	RUN_TEST(testNestedScopes);
+	RUN_TEST(testTraceUnits);
+	RUN_TEST(testThreads);
+	RUN_TEST(testSeveralProfilers);
+	return checkResult();
+}
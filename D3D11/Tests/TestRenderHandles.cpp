@@ -0,0 +1,101 @@
+//HandleTable generations, and the StateCache forwarding binds of resources recreated in a freed slot
+#include "Check.h"
+#include "NullRenderDevice.h"
+#include "StateCache.h"
+
+namespace
+{
+	//-------------------------------------------------------
+	void testGenerations()
+	{
+		HandleTable<int, BufferHandle> table;
+		BufferHandle first = table.add(1);
+		BufferHandle second = table.add(2);
+		CHECK(first.isValid() && second.isValid() && first != second);
+		CHECK(table.get(first) == 1 && table.get(second) == 2);
+
+		table.remove(first);
+		CHECK(!table.contains(first));
+		CHECK(table.get(first) == 0);
+		CHECK(table.size() == 1);
+
+		//Same slot, next generation
+		BufferHandle reused = table.add(3);
+		CHECK(reused.slot() == first.slot());
+		CHECK(reused.generation() == first.generation() + 1);
+		CHECK(reused != first);
+		CHECK(table.get(reused) == 3);
+		CHECK(table.get(first) == 0);
+
+		//A stale handle can't remove the slot's new resource
+		table.remove(first);
+		CHECK(table.contains(reused) && table.size() == 2);
+
+		CHECK(table.get(BufferHandle{}) == 0);
+		table.remove(BufferHandle{});
+		CHECK(table.size() == 2);
+	}
+
+	//Once a slot has used every generation it is never handed out again
+	//-------------------------------------------------------
+	void testRetiredSlot()
+	{
+		HandleTable<int, TextureHandle> table;
+		TextureHandle handle = table.add(0);
+		const uint32_t slot = handle.slot();
+		for (uint32_t generation{ 0 }; generation < TextureHandle::maxGeneration; generation++)
+		{
+			table.remove(handle);
+			handle = table.add(static_cast<int>(generation));
+			CHECK(handle.slot() == slot);
+		}
+		CHECK(handle.generation() == TextureHandle::maxGeneration);
+
+		TextureHandle last = handle;
+		table.remove(handle);
+		handle = table.add(7);
+		CHECK(handle.slot() != slot);
+		CHECK(!table.contains(last));
+		CHECK(table.size() == 1);
+	}
+
+	//Destroy + create binds through the cache without an invalidate, as onFireFramesLoaded does
+	//-------------------------------------------------------
+	void testStateCacheAfterRecreate()
+	{
+		NullRenderDevice device;
+		NullRenderContext& nullContext = device.nullContext();
+		StateCache cache{ nullContext };
+
+		const uint8_t pixel[4]{};
+		TextureHandle texture = device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4);
+		cache.setTexture(ShaderStage::Pixel, 0, texture);
+		cache.setTexture(ShaderStage::Pixel, 0, texture);
+		CHECK(nullContext.stats().count(RenderCall::SetTexture) == 1);
+
+		device.destroyTexture(texture);
+		TextureHandle recreated = device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4);
+		CHECK(recreated.slot() == texture.slot());
+		cache.setTexture(ShaderStage::Pixel, 0, recreated);
+		CHECK(nullContext.stats().count(RenderCall::SetTexture) == 2);
+
+		BufferHandle buffer = device.createBuffer(BufferDesc{ 64, BufferBinding::Vertex, ResourceUsage::Dynamic }, nullptr);
+		const uint32_t stride{ 16 };
+		const uint32_t offset{ 0 };
+		cache.setVertexBuffers(0, 1, &buffer, &stride, &offset);
+		device.destroyBuffer(buffer);
+		buffer = device.createBuffer(BufferDesc{ 128, BufferBinding::Vertex, ResourceUsage::Dynamic }, nullptr);
+		cache.setVertexBuffers(0, 1, &buffer, &stride, &offset);
+		CHECK(nullContext.stats().count(RenderCall::SetVertexBuffers) == 2);
+		CHECK(device.buffer(buffer).desc.sizeInBytes == 128);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testGenerations);
+	RUN_TEST(testRetiredSlot);
+	RUN_TEST(testStateCacheAfterRecreate);
+	return checkResult();
+}
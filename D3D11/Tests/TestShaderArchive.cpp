@@ -0,0 +1,178 @@
+//ShaderArchiveWriter / ShaderArchive round trip, lookups, blob alignment and rejection of corrupt archives
+#include "Check.h"
+#include "ShaderArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	//-------------------------------------------------------
+	std::string tempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	//-------------------------------------------------------
+	bool writeBytes(const std::string& fileName, const std::vector<uint8_t>& bytes)
+	{
+		std::ofstream file{ fileName, std::ios::out | std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		return static_cast<bool>(file);
+	}
+
+	//Shader blobs of different sizes filled with a per shader pattern, including an empty one
+	//-------------------------------------------------------
+	std::vector<uint8_t> blob(size_t size, uint8_t seed)
+	{
+		std::vector<uint8_t> bytes(size);
+		for (size_t i{ 0 }; i < size; i++)
+		{
+			bytes[i] = static_cast<uint8_t>(seed + i * 31);
+		}
+		return bytes;
+	}
+
+	const char* const shaderNames[]{ "box_vs", "box_ps", "box_instanced_vs", "box_instanced_ps", "box_packed_vs", "box_clustered_ps", "empty" };
+	const size_t shaderSizes[]{ 1500, 3, 4096, 65, 777, 10000, 0 };
+
+	//-------------------------------------------------------
+	void testRoundTrip()
+	{
+		ShaderArchiveWriter writer;
+		for (size_t i{ 0 }; i < 7; i++)
+		{
+			const std::vector<uint8_t> bytes = blob(shaderSizes[i], static_cast<uint8_t>(i));
+			CHECK(writer.add(shaderNames[i], bytes.data(), bytes.size()));
+		}
+		CHECK(!writer.add("box_vs", "x", 1));
+
+		const std::string fileName = tempPath("TestShaderArchive.shar");
+		CHECK(writer.write(fileName));
+
+		ShaderArchive archive;
+		CHECK(archive.open(fileName));
+		CHECK(archive.entryCount() == 7);
+
+		const uint8_t* firstBlob{ nullptr };
+		for (size_t i{ 0 }; i < 7; i++)
+		{
+			ShaderBytecode bytecode;
+			CHECK(archive.find(shaderNames[i], bytecode));
+			CHECK(bytecode.size == shaderSizes[i]);
+			const std::vector<uint8_t> expected = blob(shaderSizes[i], static_cast<uint8_t>(i));
+			CHECK(bytecode.size == 0 || memcmp(bytecode.data, expected.data(), expected.size()) == 0);
+			if (i == 0)
+			{
+				firstBlob = static_cast<const uint8_t*>(bytecode.data);
+			}
+			//Blobs share the mapping's base, so their distances are multiples of the alignment
+			const ptrdiff_t distance = static_cast<const uint8_t*>(bytecode.data) - firstBlob;
+			CHECK(distance % shaderArchiveAlignment == 0);
+		}
+
+		ShaderBytecode missing;
+		CHECK(!archive.find("box", missing));
+		CHECK(!archive.find("box_vs ", missing));
+		CHECK(missing.data == nullptr);
+
+		std::vector<std::string> names;
+		for (size_t i{ 0 }; i < archive.entryCount(); i++)
+		{
+			names.push_back(archive.entryName(i));
+		}
+		for (const char* name : shaderNames)
+		{
+			CHECK(std::find(names.begin(), names.end(), name) != names.end());
+		}
+
+		archive.close();
+		CHECK(archive.entryCount() == 0);
+		std::filesystem::remove(fileName);
+	}
+
+	//-------------------------------------------------------
+	void testEmptyArchive()
+	{
+		ShaderArchiveWriter writer;
+		const std::string fileName = tempPath("TestShaderArchiveEmpty.shar");
+		CHECK(writer.write(fileName));
+		ShaderArchive archive;
+		CHECK(archive.open(fileName));
+		CHECK(archive.entryCount() == 0);
+		ShaderBytecode bytecode;
+		CHECK(!archive.find("box_vs", bytecode));
+		archive.close();
+		std::filesystem::remove(fileName);
+	}
+
+	//Each corruption is applied to a fresh copy of a valid archive
+	//-------------------------------------------------------
+	void testCorruptArchives()
+	{
+		ShaderArchiveWriter writer;
+		for (size_t i{ 0 }; i < 3; i++)
+		{
+			const std::vector<uint8_t> bytes = blob(shaderSizes[i], static_cast<uint8_t>(i));
+			writer.add(shaderNames[i], bytes.data(), bytes.size());
+		}
+		std::vector<uint8_t> valid;
+		writer.serialize(valid);
+
+		const size_t entry0{ sizeof(ShaderArchiveHeader) };
+		const size_t entry1{ entry0 + sizeof(ShaderArchiveEntry) };
+		auto corrupt = [&](auto&& modify)
+		{
+			std::vector<uint8_t> bytes = valid;
+			modify(bytes);
+			const std::string fileName = tempPath("TestShaderArchiveCorrupt.shar");
+			writeBytes(fileName, bytes);
+			ShaderArchive archive;
+			const bool opened = archive.open(fileName);
+			archive.close();
+			std::filesystem::remove(fileName);
+			return opened;
+		};
+
+		CHECK(corrupt([](std::vector<uint8_t>&) {}));
+		CHECK(!corrupt([](std::vector<uint8_t>& bytes) { bytes[0] ^= 1; }));
+		CHECK(!corrupt([](std::vector<uint8_t>& bytes) { bytes[4] = 2; }));
+		CHECK(!corrupt([](std::vector<uint8_t>& bytes) { bytes[12] = 48; }));	//alignment not a power of two
+		CHECK(!corrupt([](std::vector<uint8_t>& bytes) { bytes[8] = 200; }));	//index past the end
+		CHECK(!corrupt([](std::vector<uint8_t>& bytes) { bytes.resize(10); }));
+		CHECK(!corrupt([&](std::vector<uint8_t>& bytes) { bytes.resize(bytes.size() - 1); }));	//last blob truncated
+		CHECK(!corrupt([&](std::vector<uint8_t>& bytes)
+		{
+			//Swapped entries are no longer sorted by hash
+			std::swap_ranges(bytes.begin() + entry0, bytes.begin() + entry1, bytes.begin() + entry1);
+		}));
+		CHECK(!corrupt([&](std::vector<uint8_t>& bytes) { bytes[entry0 + 8] += 1; }));	//blob offset misaligned
+		CHECK(!corrupt([&](std::vector<uint8_t>& bytes) { bytes[entry0 + 24 + 3] = 0x7F; }));	//name offset out of range
+		CHECK(!corrupt([](std::vector<uint8_t>& bytes) { bytes.clear(); }));
+
+		ShaderArchive archive;
+		CHECK(!archive.open(tempPath("TestShaderArchiveMissing.shar")));
+	}
+
+	//The archive shipped with the sample opens and holds at least the basic pair
+	//-------------------------------------------------------
+	void testShippedArchive()
+	{
+		ShaderArchive archive;
+		CHECK(archive.open("Shaders/box.shar"));
+		ShaderBytecode bytecode;
+		CHECK(archive.find("box_vs", bytecode) && bytecode.size > 0);
+		CHECK(archive.find("box_ps", bytecode) && bytecode.size > 0);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRoundTrip);
+	RUN_TEST(testEmptyArchive);
+	RUN_TEST(testCorruptArchives);
+	RUN_TEST(testShippedArchive);
+	return checkResult();
+}
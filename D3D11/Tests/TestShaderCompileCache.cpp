@@ -0,0 +1,194 @@
+//ShaderCompileCache: hits and misses, and every input that must change the key, with a fake compiler
+#include "Check.h"
+#include "ShaderCompileCache.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	//Bytecode is the entry point plus the call number so tests can tell compiles from cache reads
+	class FakeCompiler : public IShaderCompiler
+	{
+	public:
+
+		bool compile(const ShaderCompileDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors) override
+		{
+			calls++;
+			if (desc.entryPoint == "broken")
+			{
+				errors = "error X3000: syntax error";
+				return false;
+			}
+			const std::string output = desc.entryPoint + "#" + std::to_string(calls);
+			bytecode.assign(output.begin(), output.end());
+			return true;
+		}
+
+		std::string identity() const override { return version; }
+
+		int calls{ 0 };
+		std::string version{ "fake_1" };
+	};
+
+	const std::filesystem::path testDirectory = std::filesystem::temp_directory_path() / "TestShaderCompileCache";
+
+	//-------------------------------------------------------
+	void writeText(const std::filesystem::path& path, const std::string& text)
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+		file << text;
+	}
+
+	//Fresh shader tree: main.hlsl includes common.hlsli, which includes lighting.hlsli
+	//-------------------------------------------------------
+	ShaderCompileDesc resetSources()
+	{
+		std::filesystem::remove_all(testDirectory);
+		std::filesystem::create_directories(testDirectory / "cache");
+		writeText(testDirectory / "main.hlsl", "#include \"common.hlsli\"\n#include <system.h>\nfloat4 vs() : SV_Position { return 0; }\n");
+		writeText(testDirectory / "common.hlsli", "  #include \"lighting.hlsli\"\nstatic const float a = 1;\n");
+		writeText(testDirectory / "lighting.hlsli", "static const float b = 2;\n");
+
+		ShaderCompileDesc desc;
+		desc.sourceFile = (testDirectory / "main.hlsl").string();
+		desc.entryPoint = "vs";
+		desc.profile = "vs_5_0";
+		desc.defines = { { "LIGHTS", "4" } };
+		return desc;
+	}
+
+	//-------------------------------------------------------
+	uint64_t keyOf(const ShaderCompileCache& cache, const ShaderCompileDesc& desc)
+	{
+		uint64_t key{ 0 };
+		CHECK(cache.computeKey(desc, key));
+		return key;
+	}
+
+	//-------------------------------------------------------
+	void testHitAfterMiss()
+	{
+		const ShaderCompileDesc desc = resetSources();
+		FakeCompiler compiler;
+		ShaderCompileCache cache{ compiler, (testDirectory / "cache").string() };
+
+		std::vector<uint8_t> first, second;
+		std::string errors;
+		CHECK(cache.compile(desc, first, errors));
+		CHECK(cache.compile(desc, second, errors));
+		CHECK(compiler.calls == 1);
+		CHECK(first == second);
+		CHECK(cache.hitCount() == 1 && cache.missCount() == 1);
+
+		//A new cache on the same directory reads the stored entry
+		ShaderCompileCache reopened{ compiler, (testDirectory / "cache").string() };
+		CHECK(reopened.compile(desc, second, errors));
+		CHECK(compiler.calls == 1 && first == second);
+	}
+
+	//Entry point, profile, each define, flags, the source and every included file change the key
+	//-------------------------------------------------------
+	void testKeyInputs()
+	{
+		const ShaderCompileDesc desc = resetSources();
+		FakeCompiler compiler;
+		ShaderCompileCache cache{ compiler, (testDirectory / "cache").string() };
+		const uint64_t baseKey = keyOf(cache, desc);
+		CHECK(keyOf(cache, desc) == baseKey);
+
+		ShaderCompileDesc changed = desc;
+		changed.entryPoint = "ps";
+		CHECK(keyOf(cache, changed) != baseKey);
+		changed = desc;
+		changed.profile = "vs_5_1";
+		CHECK(keyOf(cache, changed) != baseKey);
+		changed = desc;
+		changed.defines[0].value = "8";
+		CHECK(keyOf(cache, changed) != baseKey);
+		changed = desc;
+		changed.defines.push_back({ "SHADOWS", "" });
+		CHECK(keyOf(cache, changed) != baseKey);
+		changed = desc;
+		changed.flags = 1;
+		CHECK(keyOf(cache, changed) != baseKey);
+
+		//Moving a character between adjacent fields must not give the same key
+		changed = desc;
+		changed.defines[0] = { "LIGHTS4", "" };
+		CHECK(keyOf(cache, changed) != baseKey);
+
+		writeText(testDirectory / "lighting.hlsli", "static const float b = 3;\n");
+		const uint64_t includeKey = keyOf(cache, desc);
+		CHECK(includeKey != baseKey);
+		writeText(testDirectory / "main.hlsl", "#include \"common.hlsli\"\n#include <system.h>\nfloat4 vs() : SV_Position { return 1; }\n");
+		CHECK(keyOf(cache, desc) != includeKey);
+
+		changed = desc;
+		changed.sourceFile = (testDirectory / "missing.hlsl").string();
+		uint64_t key;
+		CHECK(!cache.computeKey(changed, key));
+	}
+
+	//Bytecode from another compiler version is never returned
+	//-------------------------------------------------------
+	void testCompilerIdentity()
+	{
+		const ShaderCompileDesc desc = resetSources();
+		FakeCompiler compiler;
+		ShaderCompileCache cache{ compiler, (testDirectory / "cache").string() };
+		const uint64_t oldKey = keyOf(cache, desc);
+
+		std::vector<uint8_t> bytecode;
+		std::string errors;
+		CHECK(cache.compile(desc, bytecode, errors));
+		compiler.version = "fake_2";
+		CHECK(keyOf(cache, desc) != oldKey);
+		CHECK(cache.compile(desc, bytecode, errors));
+		CHECK(compiler.calls == 2);
+		CHECK(cache.compile(desc, bytecode, errors));
+		CHECK(compiler.calls == 2);
+	}
+
+	//Failures are reported and not cached; damaged entries are compiled again
+	//-------------------------------------------------------
+	void testFailuresAndDamagedEntries()
+	{
+		ShaderCompileDesc desc = resetSources();
+		FakeCompiler compiler;
+		ShaderCompileCache cache{ compiler, (testDirectory / "cache").string() };
+
+		std::vector<uint8_t> bytecode;
+		std::string errors;
+		desc.entryPoint = "broken";
+		CHECK(!cache.compile(desc, bytecode, errors));
+		CHECK(!errors.empty());
+		CHECK(!cache.compile(desc, bytecode, errors));
+		CHECK(compiler.calls == 2);
+
+		desc.entryPoint = "vs";
+		CHECK(cache.compile(desc, bytecode, errors));
+		for (const auto& entry : std::filesystem::directory_iterator{ testDirectory / "cache" })
+		{
+			std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) - 1);
+		}
+		CHECK(cache.compile(desc, bytecode, errors));
+		CHECK(compiler.calls == 4);
+		CHECK(cache.compile(desc, bytecode, errors));
+		CHECK(compiler.calls == 4);
+
+		desc.sourceFile = (testDirectory / "missing.hlsl").string();
+		CHECK(!cache.compile(desc, bytecode, errors));
+		CHECK(!errors.empty());
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testHitAfterMiss);
+	RUN_TEST(testKeyInputs);
+	RUN_TEST(testCompilerIdentity);
+	RUN_TEST(testFailuresAndDamagedEntries);
+	std::filesystem::remove_all(testDirectory);
+	return checkResult();
+}
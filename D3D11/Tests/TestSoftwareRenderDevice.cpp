@@ -0,0 +1,298 @@
+//SoftwareRenderDevice against reference images worked out by hand: coverage and the
+//top-left fill rule, directional lighting, depth testing, alpha clip, blending, culling,
+//and identical output whatever the worker thread count
+#include "Check.h"
+#include "SoftwareRenderDevice.h"
+#include <cstring>
+#include <random>
+
+namespace
+{
+	struct Vertex
+	{
+		float position[3];
+		float normal[3];
+		float texCoords[2];
+	};
+
+	const InputElement vertexLayout[]
+	{
+		{ "POSITION", 0, VertexFormat::Float3, 0, 0, false },
+		{ "NORMAL", 0, VertexFormat::Float3, 0, 12, false },
+		{ "TEXCOORD", 0, VertexFormat::Float2, 0, 24, false },
+	};
+
+	const uint32_t width{ 100 };	//not a multiple of the 8 pixel SIMD width or the tile size
+	const uint32_t height{ 80 };
+
+	//Back buffer, constants and layout shared by the draws of one test
+	//Positions are given in clip space: the object matrices are identity
+	struct Scene
+	{
+		explicit Scene(unsigned int threads) : device{ threads }
+		{
+			device.resize(width, height);
+			IRenderContext& context = device.immediateContext();
+			context.setViewport({ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f });
+
+			//Directional light shining along +z onto quads facing -z, so n.L = 1
+			cbufferPerFrame frame;
+			frame.dirLight.ambientColor = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
+			frame.dirLight.diffuseColor = XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f };
+			frame.dirLight.lightDir = XMFLOAT3{ 0.0f, 0.0f, -1.0f };
+			frame.viewPos = XMFLOAT4{ 0.0f, 0.0f, -10.0f, 1.0f };
+			frameBuffer = device.createBuffer(BufferDesc{ sizeof(cbufferPerFrame), BufferBinding::Constant, ResourceUsage::Default }, &frame);
+
+			object.worldViewProj = XMMatrixIdentity();
+			object.worldInvTranspose = XMMatrixIdentity();
+			object.world = XMMatrixIdentity();
+			object.texTransformMatrix = XMMatrixIdentity();
+			object.material.specColor = XMFLOAT4{ 0.0f, 0.0f, 0.0f, 1.0f };
+			objectBuffer = device.createBuffer(BufferDesc{ sizeof(cbufferPerObject), BufferBinding::Constant, ResourceUsage::Default }, &object);
+
+			layout = device.createInputLayout(vertexLayout, 3, nullptr, 0);
+			const uint32_t indices[6]{ 0, 1, 2, 0, 2, 3 };
+			indexBuffer = device.createBuffer(BufferDesc{ sizeof(indices), BufferBinding::Index, ResourceUsage::Immutable }, indices);
+		}
+
+		void clear(float r, float g, float b)
+		{
+			const float color[4]{ r, g, b, 1.0f };
+			device.immediateContext().clear(color, 1.0f, 0);
+		}
+
+		//Ambient plus diffuse lit color is ambient + diffuse, alpha the diffuse alpha
+		void setMaterial(float r, float g, float b, float alpha)
+		{
+			object.material.ambientColor = XMFLOAT4{ r * 0.5f, g * 0.5f, b * 0.5f, 1.0f };
+			object.material.diffuseColor = XMFLOAT4{ r * 0.5f, g * 0.5f, b * 0.5f, alpha };
+			device.immediateContext().updateBuffer(objectBuffer, 0, &object, sizeof(object));
+		}
+
+		//Axis aligned quad from (x0, y0) to (x1, y1) in clip space, clockwise on screen unless flipped
+		void drawQuad(float x0, float y0, float x1, float y1, float z, bool flipWinding = false)
+		{
+			const Vertex vertices[4]
+			{
+				{ { x0, y0, z }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f } },
+				{ { x0, y1, z }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f } },
+				{ { x1, y1, z }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f } },
+				{ { x1, y0, z }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 1.0f } },
+			};
+			const Vertex flipped[4]{ vertices[0], vertices[3], vertices[2], vertices[1] };
+			BufferHandle vertexBuffer = device.createBuffer(BufferDesc{ sizeof(vertices), BufferBinding::Vertex, ResourceUsage::Immutable },
+				flipWinding ? flipped : vertices);
+			vertexBuffers.push_back(vertexBuffer);
+
+			IRenderContext& context = device.immediateContext();
+			const uint32_t stride{ sizeof(Vertex) };
+			const uint32_t offset{ 0 };
+			context.setVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+			context.setIndexBuffer(indexBuffer, IndexFormat::UInt32, 0);
+			context.setInputLayout(layout);
+			context.setConstantBuffer(ShaderStage::Vertex, 0, objectBuffer, 0, sizeof(cbufferPerObject) / 16);
+			context.setConstantBuffer(ShaderStage::Pixel, 1, frameBuffer, 0, sizeof(cbufferPerFrame) / 16);
+			context.drawIndexed(6, 0, 0);
+		}
+
+		CpuImage image()
+		{
+			CpuImage result;
+			device.copyBackBuffer(result);
+			return result;
+		}
+
+		SoftwareRenderDevice device;
+		cbufferPerObject object;
+		BufferHandle objectBuffer;
+		BufferHandle frameBuffer;
+		BufferHandle indexBuffer;
+		InputLayoutHandle layout;
+		std::vector<BufferHandle> vertexBuffers;
+	};
+
+	//-------------------------------------------------------
+	const uint8_t* pixel(const CpuImage& image, uint32_t x, uint32_t y)
+	{
+		return image.pixels.data() + image.rowPitch() * y + size_t{ x } * 4;
+	}
+
+	//Rounding may differ by one between the SIMD and scalar paths
+	//-------------------------------------------------------
+	bool pixelNear(const CpuImage& image, uint32_t x, uint32_t y, int r, int g, int b, int a = 255)
+	{
+		const uint8_t* p = pixel(image, x, y);
+		return std::abs(p[0] - r) <= 1 && std::abs(p[1] - g) <= 1 && std::abs(p[2] - b) <= 1 && std::abs(p[3] - a) <= 1;
+	}
+
+	//-------------------------------------------------------
+	size_t countPixels(const CpuImage& image, int r, int g, int b)
+	{
+		size_t count{ 0 };
+		for (uint32_t y{ 0 }; y < image.height; y++)
+		{
+			for (uint32_t x{ 0 }; x < image.width; x++)
+			{
+				count += pixelNear(image, x, y, r, g, b) ? 1 : 0;
+			}
+		}
+		return count;
+	}
+
+	//A quad over the left half covers exactly the pixel centers left of x = 50
+	//-------------------------------------------------------
+	void testCoverageAndLighting()
+	{
+		Scene scene{ 1 };
+		scene.clear(0.0f, 0.0f, 1.0f);
+		scene.setMaterial(1.0f, 0.5f, 0.0f, 1.0f);
+		scene.drawQuad(-1.0f, -1.0f, 0.0f, 1.0f, 0.5f);
+		const CpuImage image = scene.image();
+
+		CHECK(image.width == width && image.height == height);
+		CHECK(pixelNear(image, 0, 0, 255, 128, 0));
+		CHECK(pixelNear(image, 49, height - 1, 255, 128, 0));
+		CHECK(pixelNear(image, 50, 0, 0, 0, 255));
+		CHECK(pixelNear(image, width - 1, height - 1, 0, 0, 255));
+		CHECK(countPixels(image, 255, 128, 0) == 50 * height);
+		CHECK_NEAR(scene.device.depthAt(10, 10), 0.5f, 1e-6f);
+		CHECK_NEAR(scene.device.depthAt(60, 10), 1.0f, 1e-6f);
+
+		const SoftwareRasterStats& stats = scene.device.rasterStats();
+		CHECK(stats.trianglesSubmitted == 2);
+		CHECK(stats.trianglesRasterized == 2);
+		CHECK(stats.pixelsShaded == 50 * height);
+		CHECK(stats.pixelsWritten == 50 * height);
+	}
+
+	//The nearer quad wins whichever order the quads are drawn in
+	//-------------------------------------------------------
+	void testDepth()
+	{
+		CpuImage images[2];
+		for (int order{ 0 }; order < 2; order++)
+		{
+			Scene scene{ 1 };
+			scene.clear(0.0f, 0.0f, 0.0f);
+			for (int i{ 0 }; i < 2; i++)
+			{
+				if ((i == 0) == (order == 0))
+				{
+					scene.setMaterial(1.0f, 0.0f, 0.0f, 1.0f);
+					scene.drawQuad(-0.5f, -0.5f, 0.5f, 0.5f, 0.25f);
+				}
+				else
+				{
+					scene.setMaterial(0.0f, 1.0f, 0.0f, 1.0f);
+					scene.drawQuad(-1.0f, -1.0f, 1.0f, 1.0f, 0.75f);
+				}
+			}
+			images[order] = scene.image();
+			CHECK(pixelNear(images[order], width / 2, height / 2, 255, 0, 0));
+			CHECK(pixelNear(images[order], 5, 5, 0, 255, 0));
+			CHECK(countPixels(images[order], 255, 0, 0) == (width / 2) * (height / 2));
+			CHECK_NEAR(scene.device.depthAt(width / 2, height / 2), 0.25f, 1e-6f);
+			CHECK_NEAR(scene.device.depthAt(5, 5), 0.75f, 1e-6f);
+		}
+		CHECK(images[0].pixels == images[1].pixels);
+	}
+
+	//Half transparent quad over black: SRC_ALPHA / INV_SRC_ALPHA halves the color, and
+	//the diagonal shared by the quad's two triangles is blended once, not twice
+	//-------------------------------------------------------
+	void testBlendingAndSharedEdge()
+	{
+		Scene scene{ 1 };
+		scene.clear(0.0f, 0.0f, 0.0f);
+		scene.device.immediateContext().setBlendState(scene.device.createBlendState(BlendDesc{ BlendMode::AlphaBlend }));
+		scene.setMaterial(1.0f, 1.0f, 1.0f, 0.5f);
+		scene.drawQuad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f);
+		const CpuImage image = scene.image();
+
+		CHECK(pixelNear(image, 0, 0, 128, 128, 128));
+		CHECK(countPixels(image, pixel(image, 0, 0)[0], pixel(image, 0, 0)[1], pixel(image, 0, 0)[2]) == width * height);
+		CHECK(scene.device.rasterStats().pixelsWritten == width * height);
+	}
+
+	//Texels with alpha under clipAlpha's 0.1 threshold are discarded, leaving the clear color
+	//-------------------------------------------------------
+	void testAlphaClip()
+	{
+		Scene scene{ 1 };
+		scene.clear(0.0f, 0.0f, 1.0f);
+		const uint8_t texels[8]{ 255, 255, 255, 0, 255, 255, 255, 255 };
+		const TextureHandle texture = scene.device.createTexture(TextureDesc{ 2, 1, TextureFormat::RGBA8 }, texels, 8);
+		IRenderContext& context = scene.device.immediateContext();
+		context.setTexture(ShaderStage::Pixel, 0, texture);
+		context.setSampler(ShaderStage::Pixel, 0, scene.device.createSampler(SamplerDesc{ TextureFilter::Point, TextureAddress::Clamp, 1 }));
+		scene.object.useTexture = 1;
+		scene.object.clipAlpha = 1;
+		scene.setMaterial(0.0f, 1.0f, 0.0f, 1.0f);
+		scene.drawQuad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f);
+		const CpuImage image = scene.image();
+
+		CHECK(countPixels(image, 0, 0, 255) == (width / 2) * height);
+		CHECK(countPixels(image, 0, 255, 0) == (width / 2) * height);
+		CHECK(pixelNear(image, 0, 0, 0, 0, 255));
+		CHECK(pixelNear(image, width - 1, 0, 0, 255, 0));
+		CHECK(scene.device.rasterStats().pixelsShaded == width * height);
+		CHECK(scene.device.rasterStats().pixelsWritten == (width / 2) * height);
+	}
+
+	//Counter clockwise triangles are back faces under the default state, drawn with CullMode::None
+	//-------------------------------------------------------
+	void testCulling()
+	{
+		Scene scene{ 1 };
+		scene.clear(0.0f, 0.0f, 0.0f);
+		scene.setMaterial(1.0f, 1.0f, 1.0f, 1.0f);
+		scene.drawQuad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, true);
+		CHECK(countPixels(scene.image(), 0, 0, 0) == width * height);
+		CHECK(scene.device.rasterStats().trianglesRasterized == 0);
+
+		scene.device.immediateContext().setRasterizerState(scene.device.createRasterizerState(RasterizerDesc{ CullMode::None, false, true }));
+		scene.drawQuad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, true);
+		CHECK(countPixels(scene.image(), 255, 255, 255) == width * height);
+		CHECK(scene.device.rasterStats().trianglesRasterized == 2);
+	}
+
+	//Overlapping blended quads across tile edges: tiles are shared out to workers but
+	//each walks its triangles in submission order, so the image can't depend on the thread count
+	//-------------------------------------------------------
+	void testThreadCountInvariance()
+	{
+		CpuImage images[2];
+		const unsigned int threads[2]{ 1, 4 };
+		for (int run{ 0 }; run < 2; run++)
+		{
+			Scene scene{ threads[run] };
+			CHECK(scene.device.threadCount() == threads[run]);
+			scene.clear(0.1f, 0.2f, 0.3f);
+			scene.device.immediateContext().setBlendState(scene.device.createBlendState(BlendDesc{ BlendMode::AlphaBlend }));
+			std::mt19937 random{ 5 };
+			std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+			for (int i{ 0 }; i < 200; i++)
+			{
+				float x = unit(random) * 2.0f - 1.0f;
+				float y = unit(random) * 2.0f - 1.0f;
+				float size = unit(random) * 0.5f + 0.05f;
+				scene.setMaterial(unit(random), unit(random), unit(random), unit(random) * 0.5f + 0.25f);
+				scene.drawQuad(x - size, y - size, x + size, y + size, unit(random));
+			}
+			images[run] = scene.image();
+		}
+		CHECK(images[0].pixels == images[1].pixels);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testCoverageAndLighting);
+	RUN_TEST(testDepth);
+	RUN_TEST(testBlendingAndSharedEdge);
+	RUN_TEST(testAlphaClip);
+	RUN_TEST(testCulling);
+	RUN_TEST(testThreadCountInvariance);
+	return checkResult();
+}
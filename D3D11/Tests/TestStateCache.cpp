@@ -0,0 +1,193 @@
+//StateCache over the recording NullRenderContext: redundant binds are dropped and counted, vertex
+//buffer changes forward only the changed slot range, and invalidate or executing a command list
+//lets the next bind of everything through again
+#include "Check.h"
+#include "NullDeferredContext.h"
+#include "StateCache.h"
+
+namespace
+{
+	//-------------------------------------------------------
+	struct Resources
+	{
+		BufferHandle vertexBuffers[4];
+		BufferHandle indexBuffer;
+		BufferHandle constants;
+		TextureHandle texture;
+		SamplerHandle sampler;
+		VertexShaderHandle vertexShader;
+
+		explicit Resources(NullRenderDevice& device)
+		{
+			for (BufferHandle& buffer : vertexBuffers)
+			{
+				buffer = device.createBuffer(BufferDesc{ 256, BufferBinding::Vertex, ResourceUsage::Immutable }, nullptr);
+			}
+			indexBuffer = device.createBuffer(BufferDesc{ 64, BufferBinding::Index, ResourceUsage::Immutable }, nullptr);
+			constants = device.createBuffer(BufferDesc{ 4096, BufferBinding::Constant, ResourceUsage::Dynamic }, nullptr);
+			const uint8_t pixel[4]{};
+			texture = device.createTexture(TextureDesc{ 1, 1, TextureFormat::RGBA8 }, pixel, 4);
+			sampler = device.createSampler(SamplerDesc{});
+			vertexShader = device.createVertexShader(nullptr, 0);
+		}
+	};
+
+	//The binds of one draw, every one of them redundant the second time
+	//-------------------------------------------------------
+	void bindAll(IRenderContext& context, const Resources& resources)
+	{
+		const uint32_t strides[2]{ 32, 8 };
+		const uint32_t offsets[2]{ 0, 0 };
+		context.setVertexShader(resources.vertexShader);
+		context.setPrimitiveTopology(PrimitiveTopology::TriangleList);
+		context.setViewport({ 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f });
+		context.setVertexBuffers(0, 2, resources.vertexBuffers, strides, offsets);
+		context.setIndexBuffer(resources.indexBuffer, IndexFormat::UInt16, 0);
+		context.setConstantBuffer(ShaderStage::Vertex, 0, resources.constants, 0, 16);
+		context.setTexture(ShaderStage::Pixel, 0, resources.texture);
+		context.setSampler(ShaderStage::Pixel, 0, resources.sampler);
+	}
+
+	//-------------------------------------------------------
+	void testRedundantBinds()
+	{
+		NullRenderDevice device;
+		const Resources resources{ device };
+		NullRenderContext& target = device.nullContext();
+		StateCache cache{ target };
+
+		bindAll(cache, resources);
+		cache.drawIndexed(36, 0, 0);
+		CHECK(target.stats().totalCalls() == 9);
+		CHECK(cache.stats().issued == 9 && cache.stats().elided == 0);
+
+		bindAll(cache, resources);
+		cache.drawIndexed(36, 0, 0);
+		CHECK(target.stats().totalCalls() == 10 && target.stats().drawCalls() == 2);
+		CHECK(cache.stats().issued == 10 && cache.stats().elided == 8 && cache.stats().total() == 18);
+
+		//Any argument that differs is a new bind: offsets, formats, stages, slots
+		target.resetStats();
+		cache.resetStats();
+		cache.setConstantBuffer(ShaderStage::Vertex, 0, resources.constants, 16, 16);
+		cache.setConstantBuffer(ShaderStage::Pixel, 0, resources.constants, 16, 16);
+		cache.setConstantBuffer(ShaderStage::Vertex, 1, resources.constants, 16, 16);
+		cache.setIndexBuffer(resources.indexBuffer, IndexFormat::UInt32, 0);
+		cache.setViewport({ 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 0.5f });
+		cache.setTexture(ShaderStage::Vertex, 0, resources.texture);
+		CHECK(target.stats().totalCalls() == 6 && cache.stats().issued == 6 && cache.stats().elided == 0);
+
+		//Draws and resource updates always go through
+		cache.drawIndexed(36, 0, 0);
+		cache.drawIndexed(36, 0, 0);
+		cache.mapBuffer(resources.constants, MapMode::WriteDiscard);
+		cache.unmapBuffer(resources.constants);
+		CHECK(target.stats().totalCalls() == 10 && cache.stats().elided == 0);
+
+		//A structured buffer shares the t register with textures, so binding one forgets the other
+		cache.setStructuredBuffer(ShaderStage::Pixel, 0, resources.constants);
+		cache.setTexture(ShaderStage::Pixel, 0, resources.texture);
+		cache.setTexture(ShaderStage::Pixel, 0, resources.texture);
+		CHECK(target.stats().count(RenderCall::SetStructuredBuffer) == 1 && target.stats().count(RenderCall::SetTexture) == 2);
+		CHECK(cache.stats().elided == 1);
+
+		//Slots past what the cache tracks are always forwarded
+		cache.setTexture(ShaderStage::Pixel, StateCache::maxTextures, resources.texture);
+		cache.setTexture(ShaderStage::Pixel, StateCache::maxTextures, resources.texture);
+		CHECK(target.stats().count(RenderCall::SetTexture) == 4);
+	}
+
+	//-------------------------------------------------------
+	void testVertexBufferRanges()
+	{
+		NullRenderDevice device;
+		const Resources resources{ device };
+		NullRenderContext& target = device.nullContext();
+		StateCache cache{ target };
+		target.setRecording(true);
+
+		const BufferHandle* buffers = resources.vertexBuffers;
+		uint32_t strides[4]{ 32, 8, 12, 16 };
+		uint32_t offsets[4]{ 0, 0, 0, 0 };
+		cache.setVertexBuffers(0, 4, buffers, strides, offsets);
+		CHECK(target.recordedCalls().size() == 1);
+
+		//Only slot 2 changes: one call for slot 2 alone
+		target.clearRecordedCalls();
+		offsets[2] = 48;
+		cache.setVertexBuffers(0, 4, buffers, strides, offsets);
+		CHECK(target.recordedCalls().size() == 1);
+		if (target.recordedCalls().size() == 1)
+		{
+			const RecordedCall& call = target.recordedCalls()[0];
+			CHECK(call.args[0] == 2 && call.args[1] == 1 && call.args[2] == buffers[2].id && call.args[4] == 48);
+		}
+
+		//Slots 1 and 3 change: the range from 1 to 3, slot 2 rebound unchanged in between
+		target.clearRecordedCalls();
+		strides[1] = 16;
+		offsets[3] = 64;
+		cache.setVertexBuffers(0, 4, buffers, strides, offsets);
+		CHECK(target.recordedCalls().size() == 1);
+		if (target.recordedCalls().size() == 1)
+		{
+			const RecordedCall& call = target.recordedCalls()[0];
+			CHECK(call.args[0] == 1 && call.args[1] == 3 && call.args[2] == buffers[1].id && call.args[3] == buffers[2].id);
+		}
+
+		//A call starting past slot 0 compares against the same slots
+		target.clearRecordedCalls();
+		cache.setVertexBuffers(2, 2, buffers + 2, strides + 2, offsets + 2);
+		CHECK(target.recordedCalls().empty());
+		const BufferHandle swapped[2]{ buffers[3], buffers[3] };
+		cache.setVertexBuffers(2, 2, swapped, strides + 2, offsets + 2);
+		CHECK(target.recordedCalls().size() == 1);
+		if (target.recordedCalls().size() == 1)
+		{
+			const RecordedCall& call = target.recordedCalls()[0];
+			CHECK(call.args[0] == 2 && call.args[1] == 1 && call.args[2] == buffers[3].id);
+		}
+		CHECK(cache.stats().issued == 4 && cache.stats().elided == 1);
+	}
+
+	//-------------------------------------------------------
+	void testInvalidate()
+	{
+		NullRenderDevice device;
+		const Resources resources{ device };
+		NullRenderContext& target = device.nullContext();
+		StateCache cache{ target };
+
+		bindAll(cache, resources);
+		bindAll(cache, resources);
+		CHECK(target.stats().totalCalls() == 8);
+
+		//Something else touched the target: everything goes through once more
+		cache.invalidate();
+		bindAll(cache, resources);
+		CHECK(target.stats().totalCalls() == 16);
+		bindAll(cache, resources);
+		CHECK(target.stats().totalCalls() == 16);
+
+		//Executing a list leaves the target at default state, so the cache forgets too
+		std::unique_ptr<IDeferredContext> deferred = device.createDeferredContext();
+		deferred->context().drawIndexed(3, 0, 0);
+		std::unique_ptr<ICommandList> list = deferred->finish();
+		cache.executeCommandList(*list);
+		CHECK(target.stats().count(RenderCall::ExecuteCommandList) == 1 && target.stats().drawCalls() == 1);
+		bindAll(cache, resources);
+		CHECK(target.stats().totalCalls() == 16 + 2 + 8);
+		bindAll(cache, resources);
+		CHECK(target.stats().totalCalls() == 26);
+		CHECK(cache.stats().elided == 3 * 8);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testRedundantBinds);
+	RUN_TEST(testVertexBufferRanges);
+	RUN_TEST(testInvalidate);
+	return checkResult();
+}
@@ -0,0 +1,126 @@
+//GameTimer on virtual time and FixedTimestep step counts over a simulated day
+#include "Check.h"
+#include "GameTimer.h"
+
+namespace
+{
+	const int64_t nanosecondsPerSecond{ 1000000000 };
+	const int64_t nanosecondsPerDay{ 24 * 3600 * nanosecondsPerSecond };
+
+	//24 hours of 144 Hz frames with uneven frame times; the step count must equal
+	//elapsed time * rate rounded down, with no accumulated error
+	//-------------------------------------------------------
+	void testNoDriftOverADay()
+	{
+		VirtualTimeSource clock;
+		GameTimer timer{ clock };
+		timer.reset();
+		FixedTimestep timestep{ 60 };
+
+		//Repeating pattern of 4 frame times around 1/144 s
+		const int64_t frameTimes[4]{ 6944444, 6944445, 7100000, 6788889 };
+		uint64_t frames{ 0 };
+		uint64_t zeroStepFrames{ 0 };
+		while (timer.totalNanoseconds() < nanosecondsPerDay)
+		{
+			clock.advance(frameTimes[frames % 4]);
+			timer.tick();
+			zeroStepFrames += timestep.advance(timer.deltaNanoseconds()) == 0;
+			frames++;
+		}
+
+		const int64_t elapsed = timer.totalNanoseconds();
+		CHECK(timestep.droppedStepCount() == 0);
+		CHECK(timestep.stepCount() == static_cast<uint64_t>(elapsed / nanosecondsPerSecond * 60 + elapsed % nanosecondsPerSecond * 60 / nanosecondsPerSecond));
+		CHECK(timer.totalTime() - timestep.simulatedTime() >= 0.0);
+		CHECK(timer.totalTime() - timestep.simulatedTime() < timestep.stepSeconds());
+		CHECK_NEAR(timestep.alpha(), (timer.totalTime() - timestep.simulatedTime()) / timestep.stepSeconds(), 1e-3);
+
+		//At 144 Hz most frames run no simulation step, per frame work cannot live in the step
+		CHECK(zeroStepFrames > frames / 2);
+	}
+
+	//Steps past maxStepsPerFrame are dropped and counted, not carried into later frames
+	//-------------------------------------------------------
+	void testHitchDropsSteps()
+	{
+		FixedTimestep timestep{ 60, 8 };
+		CHECK(timestep.advance(nanosecondsPerSecond) == 8);
+		CHECK(timestep.droppedStepCount() == 52);
+		CHECK(timestep.advance(nanosecondsPerSecond / 60 + 1) == 1);
+		CHECK(timestep.advance(0) == 0);
+		CHECK(timestep.advance(-5) == 0);
+		CHECK(timestep.stepCount() == 9);
+
+		timestep.reset();
+		CHECK(timestep.stepCount() == 0 && timestep.droppedStepCount() == 0 && timestep.alpha() == 0.0f);
+	}
+
+	//Paused time is excluded from the total and produces no delta
+	//-------------------------------------------------------
+	void testPause()
+	{
+		VirtualTimeSource clock{ 1000 };
+		GameTimer timer{ clock };
+		timer.reset();
+
+		clock.advanceSeconds(2.0);
+		timer.tick();
+		CHECK(timer.deltaNanoseconds() == 2 * nanosecondsPerSecond);
+
+		timer.stop();
+		clock.advanceSeconds(10.0);
+		timer.tick();
+		CHECK(timer.deltaNanoseconds() == 0);
+		CHECK(timer.totalNanoseconds() == 2 * nanosecondsPerSecond);
+		timer.start();
+
+		clock.advanceSeconds(0.5);
+		timer.tick();
+		CHECK(timer.deltaNanoseconds() == nanosecondsPerSecond / 2);
+		CHECK(timer.totalNanoseconds() == 2 * nanosecondsPerSecond + nanosecondsPerSecond / 2);
+	}
+
+	//A recorded run replays to the same frame times and therefore the same steps
+	//-------------------------------------------------------
+	void testReplay()
+	{
+		VirtualTimeSource live;
+		RecordingTimeSource recorder{ live };
+		GameTimer recordedTimer{ recorder };
+		recordedTimer.reset();
+		FixedTimestep recordedSteps{ 60 };
+		std::vector<uint32_t> stepsPerFrame;
+		for (int frame{ 0 }; frame < 500; frame++)
+		{
+			live.advance(3000000 + (frame * 7919) % 20000000);
+			recordedTimer.tick();
+			stepsPerFrame.push_back(recordedSteps.advance(recordedTimer.deltaNanoseconds()));
+		}
+
+		VirtualTimeSource replay;
+		replay.setReplay(recorder.recording());
+		GameTimer replayTimer{ replay };
+		replayTimer.reset();
+		FixedTimestep replaySteps{ 60 };
+		int mismatches{ 0 };
+		for (uint32_t expected : stepsPerFrame)
+		{
+			replayTimer.tick();
+			mismatches += replaySteps.advance(replayTimer.deltaNanoseconds()) != expected;
+		}
+		CHECK(mismatches == 0);
+		CHECK(replay.replayFinished());
+		CHECK(replayTimer.totalNanoseconds() == recordedTimer.totalNanoseconds());
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testNoDriftOverADay);
+	RUN_TEST(testHitchDropsSteps);
+	RUN_TEST(testPause);
+	RUN_TEST(testReplay);
+	return checkResult();
+}
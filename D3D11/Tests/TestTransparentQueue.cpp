@@ -0,0 +1,148 @@
+//radixSort against std::stable_sort, serial and parallel, and TransparentQueue back to front order
+#include "Check.h"
+#include "TransparentQueue.h"
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace
+{
+	struct Entry32
+	{
+		uint32_t key;
+		uint32_t index;
+	};
+
+	struct Entry64
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	//Keys drawn from a small range so most keys repeat and stability matters
+	//-------------------------------------------------------
+	template <typename Entry>
+	std::vector<Entry> randomEntries(size_t count, uint64_t keyRange, uint32_t seed)
+	{
+		std::mt19937_64 random{ seed };
+		std::vector<Entry> entries(count);
+		for (size_t i{ 0 }; i < count; i++)
+		{
+			entries[i].key = static_cast<decltype(Entry::key)>(random() % keyRange);
+			entries[i].index = static_cast<uint32_t>(i);
+		}
+		return entries;
+	}
+
+	//-------------------------------------------------------
+	template <typename Entry>
+	bool matchesStableSort(std::vector<Entry> entries, bool parallel)
+	{
+		std::vector<Entry> expected = entries;
+		std::stable_sort(expected.begin(), expected.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+		std::vector<Entry> scratch;
+		std::vector<uint32_t> histograms;
+		radixSort(entries, scratch, histograms, parallel);
+		return std::equal(entries.begin(), entries.end(), expected.begin(),
+			[](const Entry& a, const Entry& b) { return a.key == b.key && a.index == b.index; });
+	}
+
+	//Sizes below and above the parallel chunk size, with duplicate heavy and wide key ranges
+	//-------------------------------------------------------
+	void testMatchesStableSort()
+	{
+		for (size_t count : { size_t{ 0 }, size_t{ 1 }, size_t{ 2 }, size_t{ 1000 }, size_t{ 100003 } })
+		{
+			for (bool parallel : { false, true })
+			{
+				CHECK(matchesStableSort(randomEntries<Entry32>(count, 17, 1), parallel));
+				CHECK(matchesStableSort(randomEntries<Entry32>(count, uint64_t{ 1 } << 32, 2), parallel));
+				CHECK(matchesStableSort(randomEntries<Entry64>(count, 300, 3), parallel));
+				CHECK(matchesStableSort(randomEntries<Entry64>(count, ~uint64_t{ 0 }, 4), parallel));
+			}
+		}
+	}
+
+	//Every key equal skips all passes and leaves the input untouched
+	//-------------------------------------------------------
+	void testAllKeysEqual()
+	{
+		std::vector<Entry32> entries = randomEntries<Entry32>(50000, 1, 5);
+		CHECK(matchesStableSort(entries, false));
+		CHECK(matchesStableSort(entries, true));
+	}
+
+	//The sortable mapping orders negative, zero and positive floats like the floats themselves
+	//-------------------------------------------------------
+	void testSortableFloats()
+	{
+		const float values[]{ -1e30f, -2.5f, -1.0f, -1e-30f, 0.0f, 1e-30f, 0.5f, 1.0f, 3.0f, 1e30f };
+		for (size_t i{ 1 }; i < sizeof(values) / sizeof(values[0]); i++)
+		{
+			CHECK(floatToSortableUint(values[i - 1]) < floatToSortableUint(values[i]));
+		}
+	}
+
+	//Farthest first; draws at the same distance keep their submission order
+	//-------------------------------------------------------
+	void testBackToFront()
+	{
+		for (bool parallel : { false, true })
+		{
+			std::mt19937 random{ 6 };
+			std::uniform_int_distribution<int> distance{ 0, 500 };
+			std::vector<float> distances(60000);
+			TransparentQueue queue{ distances.size() };
+			for (uint32_t i{ 0 }; i < distances.size(); i++)
+			{
+				distances[i] = distance(random) * 0.25f;
+				queue.push(distances[i], i);
+			}
+			queue.sort(parallel);
+
+			CHECK(queue.size() == distances.size());
+			int misordered{ 0 };
+			for (size_t i{ 1 }; i < queue.size(); i++)
+			{
+				const float previous = distances[queue[i - 1].drawIndex];
+				const float current = distances[queue[i].drawIndex];
+				misordered += previous < current || (previous == current && queue[i - 1].drawIndex > queue[i].drawIndex);
+			}
+			CHECK(misordered == 0);
+		}
+	}
+
+	//Once reserved, refilling and sorting the queue keeps the same storage. The sort swaps the
+	//draws with its scratch array, so the draws live in one of the two reserved blocks
+	//-------------------------------------------------------
+	void testNoReallocation()
+	{
+		TransparentQueue queue{ 200000 };
+		std::set<const TransparentDraw*> blocks;
+		for (int frame{ 0 }; frame < 6; frame++)
+		{
+			queue.clear();
+			for (uint32_t i{ 0 }; i < 200000; i++)
+			{
+				queue.push(static_cast<float>((i * 7919) % 1000), i);
+			}
+			queue.sort(true);
+			CHECK(queue.size() == 200000);
+			blocks.insert(queue.begin());
+		}
+		CHECK(blocks.size() <= 2);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	setParallelWorkerCount(4);
+	RUN_TEST(testMatchesStableSort);
+	RUN_TEST(testAllKeysEqual);
+	RUN_TEST(testSortableFloats);
+	RUN_TEST(testBackToFront);
+	RUN_TEST(testNoReallocation);
+	return checkResult();
+}
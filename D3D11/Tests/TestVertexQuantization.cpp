@@ -0,0 +1,143 @@
+//VertexNormTexPacked quantization: octahedral round trips, measured error within the
+//analytic bound on random meshes, the 8 wide path matching single vertex packing, and the
+//decode matrix agreeing with dequantizeVertex
+#include "Check.h"
+#include "VertexQuantization.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	//-------------------------------------------------------
+	std::vector<VertexNormTex> randomVertices(uint32_t count, float extent, float texRange, uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+		std::vector<VertexNormTex> vertices(count);
+		for (VertexNormTex& vertex : vertices)
+		{
+			vertex.position = XMFLOAT3{ unit(random) * extent + 3.0f, unit(random) * extent * 0.25f, unit(random) * extent - 7.0f };
+			XMStoreFloat3(&vertex.normal, XMVector3Normalize(XMVectorSet(unit(random), unit(random), unit(random), 0.0f)));
+			vertex.texCoords = XMFLOAT2{ unit(random) * texRange, unit(random) * texRange };
+		}
+		return vertices;
+	}
+
+	//-------------------------------------------------------
+	float angleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		float cosine = XMVectorGetX(XMVector3Dot(XMVector3Normalize(XMLoadFloat3(&a)), XMVector3Normalize(XMLoadFloat3(&b))));
+		return XMConvertToDegrees(std::acos(std::min(std::max(cosine, -1.0f), 1.0f)));
+	}
+
+	//Axes, the folded lower hemisphere and the octahedron's edges decode to themselves
+	//-------------------------------------------------------
+	void testOctahedral()
+	{
+		const XMFLOAT3 normals[]
+		{
+			{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+			{ 0.577f, 0.577f, -0.577f }, { -0.6f, 0.0f, -0.8f }, { 0.0f, 0.707f, 0.707f }, { 0.3f, -0.4f, -0.866f },
+		};
+		for (const XMFLOAT3& normal : normals)
+		{
+			const XMFLOAT2 encoded = encodeOctahedral(normal);
+			CHECK(std::fabs(encoded.x) <= 1.0f && std::fabs(encoded.y) <= 1.0f);
+			const XMFLOAT3 decoded = decodeOctahedral(encoded.x, encoded.y);
+			CHECK(angleDegrees(normal, decoded) < 0.01f);
+			CHECK_NEAR(XMVectorGetX(XMVector3Length(XMLoadFloat3(&decoded))), 1.0f, 1e-5f);
+		}
+		const XMFLOAT2 zero = encodeOctahedral(XMFLOAT3{ 0.0f, 0.0f, 0.0f });
+		CHECK(zero.x == 0.0f && zero.y == 0.0f);
+		CHECK(decodeOctahedral(0.0f, 0.0f).z == 1.0f);
+	}
+
+	//-------------------------------------------------------
+	void testErrorWithinBound()
+	{
+		CHECK(sizeof(VertexNormTexPacked) * 2 == sizeof(VertexNormTex));
+
+		for (float extent : { 0.5f, 20.0f, 500.0f })
+		{
+			const std::vector<VertexNormTex> vertices = randomVertices(10007, extent, 4.0f, static_cast<uint32_t>(extent * 10));
+			const PositionDecode decode = computePositionDecode(vertices.data(), static_cast<uint32_t>(vertices.size()));
+			std::vector<VertexNormTexPacked> packed(vertices.size());
+			quantizeVertices(packed.data(), vertices.data(), static_cast<uint32_t>(vertices.size()), decode);
+
+			const QuantizationError measured = measureQuantizationError(packed.data(), vertices.data(), static_cast<uint32_t>(vertices.size()), decode);
+			const QuantizationError bound = quantizationErrorBound(decode, 4.0f);
+			CHECK(measured.position <= bound.position);
+			CHECK(measured.normalDegrees <= bound.normalDegrees);
+			CHECK(measured.texCoords <= bound.texCoords);
+
+			//The bound is tight enough to mean something: 16 bit steps, well under a degree
+			CHECK(bound.position <= extent * 2.0f / 65535.0f * 2.0f);
+			CHECK(bound.normalDegrees < 0.05f);
+			CHECK(measured.position > 0.0f);
+
+			//Spot check the measurement itself on one vertex
+			const VertexNormTex unpacked = dequantizeVertex(packed[42], decode);
+			CHECK_NEAR(unpacked.position.x, vertices[42].position.x, bound.position);
+			CHECK(angleDegrees(unpacked.normal, vertices[42].normal) <= bound.normalDegrees);
+			CHECK_NEAR(unpacked.texCoords.y, vertices[42].texCoords.y, bound.texCoords);
+		}
+	}
+
+	//Meshes are packed 8 vertices at a time with a scalar tail; packing vertices one by one
+	//goes through the tail only, and both must give the same bits
+	//-------------------------------------------------------
+	void testWideMatchesSingle()
+	{
+		const std::vector<VertexNormTex> vertices = randomVertices(203, 10.0f, 2.0f, 5);
+		const PositionDecode decode = computePositionDecode(vertices.data(), static_cast<uint32_t>(vertices.size()));
+		std::vector<VertexNormTexPacked> wide(vertices.size());
+		std::vector<VertexNormTexPacked> single(vertices.size());
+		quantizeVertices(wide.data(), vertices.data(), static_cast<uint32_t>(vertices.size()), decode);
+		for (size_t i{ 0 }; i < vertices.size(); i++)
+		{
+			quantizeVertices(&single[i], &vertices[i], 1, decode);
+		}
+		CHECK(memcmp(wide.data(), single.data(), wide.size() * sizeof(VertexNormTexPacked)) == 0);
+	}
+
+	//The bounds map to the ends of the UNORM range, and decode.matrix() does what the shader does
+	//-------------------------------------------------------
+	void testPositionDecode()
+	{
+		const VertexNormTex vertices[2]
+		{
+			{ { -2.0f, 1.0f, 5.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } },
+			{ { 6.0f, 1.0f, 9.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f } },
+		};
+		const PositionDecode decode = computePositionDecode(vertices, 2);
+		CHECK(decode.offset.x == -2.0f && decode.offset.z == 5.0f);
+		CHECK(decode.scale.x == 8.0f && decode.scale.z == 4.0f);
+
+		VertexNormTexPacked packed[2];
+		quantizeVertices(packed, vertices, 2, decode);
+		CHECK(packed[0].position.x == 0 && packed[1].position.x == 65535);
+		CHECK(packed[0].position.z == 0 && packed[1].position.z == 65535);
+
+		//A flat axis still decodes to its value
+		const VertexNormTex flat = dequantizeVertex(packed[1], decode);
+		CHECK_NEAR(flat.position.y, 1.0f, 1e-6f);
+
+		XMFLOAT3 transformed;
+		const XMVECTOR unorm = XMVectorSet(packed[1].position.x / 65535.0f, packed[1].position.y / 65535.0f, packed[1].position.z / 65535.0f, 1.0f);
+		XMStoreFloat3(&transformed, XMVector3TransformCoord(unorm, decode.matrix()));
+		CHECK_NEAR(transformed.x, 6.0f, 1e-5f);
+		CHECK_NEAR(transformed.y, 1.0f, 1e-5f);
+		CHECK_NEAR(transformed.z, 9.0f, 1e-5f);
+	}
+}
+
+//-------------------------------------------------------
+int main()
+{
+	RUN_TEST(testOctahedral);
+	RUN_TEST(testErrorWithinBound);
+	RUN_TEST(testWideMatchesSingle);
+	RUN_TEST(testPositionDecode);
+	return checkResult();
+}
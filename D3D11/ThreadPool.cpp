@@ -0,0 +1,61 @@
+#include "ThreadPool.h"
+
+//------------------------------------------------
+ThreadPool::ThreadPool(unsigned int numWorkers)
+{
+	if (numWorkers == 0)
+	{
+		numWorkers = 1;
+	}
+
+	workers.reserve(numWorkers);
+	for (unsigned int i{ 0 }; i < numWorkers; i++)
+	{
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+//-----------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ jobsMutex };
+		stopping = true;
+	}
+	jobsAvailable.notify_all();
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+//-----------------------------------------------
+void ThreadPool::submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock{ jobsMutex };
+		jobs.push_back(std::move(job));
+	}
+	jobsAvailable.notify_one();
+}
+
+//----------------------------
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock{ jobsMutex };
+			jobsAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+			{
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
\ No newline at end of file
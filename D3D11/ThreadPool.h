@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads pulling jobs from a FIFO queue
+//Jobs still queued when the pool is destroyed are run before the workers exit
+class ThreadPool
+{
+public:
+
+	explicit ThreadPool(unsigned int numWorkers);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> job);
+
+	//Runs func on a worker and returns a future for its result
+	//-----------------------------------------------------------
+	template <typename Func>
+	auto submitTask(Func func) -> std::future<decltype(func())>
+	{
+		using Result = decltype(func());
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+		std::future<Result> result = task->get_future();
+		submit([task]() { (*task)(); });
+		return result;
+	}
+
+	unsigned int workerCount() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex jobsMutex;
+	std::condition_variable jobsAvailable;
+	bool stopping{ false };
+};
\ No newline at end of file
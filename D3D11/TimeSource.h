@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+//Monotonic time in nanoseconds for GameTimer
+class TimeSource
+{
+public:
+
+	virtual ~TimeSource() = default;
+	virtual int64_t now() = 0;
+};
+
+//Wall clock, std::chrono::steady_clock (QueryPerformanceCounter on Windows, clock_gettime(CLOCK_MONOTONIC) on Linux)
+class SteadyTimeSource : public TimeSource
+{
+public:
+
+	int64_t now() override
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+//Shared instance used by timers that are not given a source
+inline SteadyTimeSource& steadyTimeSource()
+{
+	static SteadyTimeSource source;
+	return source;
+}
+
+//Time that only moves when told to, for deterministic runs and benchmarks
+//Either advance it manually or load a recorded sequence of timestamps; while a
+//replay is loaded each call to now() returns the next recorded value and the
+//last value repeats once the sequence is exhausted
+class VirtualTimeSource : public TimeSource
+{
+public:
+
+	explicit VirtualTimeSource(int64_t startTime = 0) : currentTime{ startTime } {}
+
+	int64_t now() override
+	{
+		if (replayIndex < replay.size())
+		{
+			currentTime = replay[replayIndex++];
+		}
+		return currentTime;
+	}
+
+	void advance(int64_t nanoseconds) { currentTime += nanoseconds; }
+	void advanceSeconds(double seconds) { currentTime += static_cast<int64_t>(seconds * 1e9); }
+
+	void setReplay(std::vector<int64_t> timestamps)
+	{
+		replay = std::move(timestamps);
+		replayIndex = 0;
+	}
+	bool replayFinished() const { return replayIndex >= replay.size(); }
+
+private:
+
+	int64_t currentTime;
+	std::vector<int64_t> replay;
+	size_t replayIndex{ 0 };
+};
+
+//Passes another source through and keeps every value it returned, feed the
+//recording to VirtualTimeSource::setReplay to reproduce a run exactly
+class RecordingTimeSource : public TimeSource
+{
+public:
+
+	explicit RecordingTimeSource(TimeSource& source) : source{ source } {}
+
+	int64_t now() override
+	{
+		int64_t time = source.now();
+		timestamps.push_back(time);
+		return time;
+	}
+
+	const std::vector<int64_t>& recording() const { return timestamps; }
+
+private:
+
+	TimeSource& source;
+	std::vector<int64_t> timestamps;
+};
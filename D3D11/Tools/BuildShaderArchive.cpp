@@ -0,0 +1,61 @@
+//Packs compiled shaders into a single .shar archive
+//
+//	BuildShaderArchive <output.shar> <input.cso>...
+//
+//Each shader is stored under its file name without directory or extension,
+//e.g. Shaders/box_vs.cso is looked up as "box_vs".
+//Build together with ShaderArchive.cpp and MappedFile.cpp, it has no Windows dependencies
+#include "../ShaderArchive.h"
+#include <cstdio>
+
+namespace
+{
+	//-------------------------------------------------------
+	std::string shaderNameFromPath(const std::string& path)
+	{
+		size_t start = path.find_last_of("/\\");
+		start = start == std::string::npos ? 0 : start + 1;
+		size_t end = path.find_last_of('.');
+		if (end == std::string::npos || end < start)
+		{
+			end = path.size();
+		}
+		return path.substr(start, end - start);
+	}
+}
+
+//-----------------------------
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "usage: %s <output.shar> <input.cso>...\n", argv[0]);
+		return 1;
+	}
+
+	ShaderArchiveWriter writer;
+	for (int i{ 2 }; i < argc; i++)
+	{
+		MappedFile input;
+		if (!input.open(argv[i]))
+		{
+			fprintf(stderr, "cannot read %s\n", argv[i]);
+			return 1;
+		}
+
+		std::string name = shaderNameFromPath(argv[i]);
+		if (!writer.add(name, input.data(), input.size()))
+		{
+			fprintf(stderr, "duplicate shader name %s\n", name.c_str());
+			return 1;
+		}
+		printf("%s : %zu bytes\n", name.c_str(), input.size());
+	}
+
+	if (!writer.write(argv[1]))
+	{
+		fprintf(stderr, "cannot write %s\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
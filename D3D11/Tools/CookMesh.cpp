@@ -0,0 +1,237 @@
+//Cooks a mesh into a .mesh asset (see MeshAsset.h)
+//
+//	CookMesh [-packed] <output.mesh> <input.obj | input.gltf | input.glb | cube | quad>
+//
+//The input is read with MeshImporter, or is one of the built in meshes. Normals are generated
+//when the input has none, then the mesh is optimized for the vertex cache, overdraw and
+//vertex fetch, and its levels of detail are built. -packed stores VertexNormTexPacked
+//vertices instead of VertexNormTex.
+//Build together with MeshAsset.cpp, MeshImporter.cpp, MappedFile.cpp, MeshOptimizer.cpp,
+//MeshSimplifier.cpp and VertexQuantization.cpp, it has no Windows dependencies
+#include "../MeshAsset.h"
+#include "../MeshImporter.h"
+#include "../MeshOptimizer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	//-----------------------------------------------------//
+	//-----------------------CUBE--------------------------//
+	//-----------------------------------------------------//
+	const VertexNormTex cubeVertices[] =
+	{
+		//Top Face
+		{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 0
+		{XMFLOAT3{-0.5f,  0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 1
+		{XMFLOAT3{ 0.5f,  0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 2
+		{XMFLOAT3{ 0.5f,  0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 3
+
+		//Bottom Face
+		{XMFLOAT3{-0.5f, -0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 4
+		{XMFLOAT3{-0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 5
+		{XMFLOAT3{ 0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 6
+		{XMFLOAT3{ 0.5f, -0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 7
+
+		//Left Face
+		{XMFLOAT3{-0.5f, -0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 8
+		{XMFLOAT3{-0.5f,  0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 9
+		{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 10
+		{XMFLOAT3{-0.5f, -0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 11
+
+		//Right Face
+		{XMFLOAT3{ 0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 12
+		{XMFLOAT3{ 0.5f,  0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 13
+		{XMFLOAT3{ 0.5f,  0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 14
+		{XMFLOAT3{ 0.5f, -0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 15
+
+		//Front Face
+		{XMFLOAT3{-0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 16
+		{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 17
+		{XMFLOAT3{ 0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 18
+		{XMFLOAT3{ 0.5f, -0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 19
+
+		//Back Face
+		{XMFLOAT3{ 0.5f, -0.5f,  0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 20
+		{XMFLOAT3{ 0.5f,  0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 21
+		{XMFLOAT3{-0.5f,  0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 22
+		{XMFLOAT3{-0.5f, -0.5f,  0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 23
+	};
+
+	//Cube Indices
+	const uint32_t cubeIndices[] = {
+		//Top Face
+		0, 1, 2,
+		0, 2, 3,
+
+		//Bottom Face
+		4, 5, 6,
+		4, 6, 7,
+
+		//Left Face
+		8, 9, 10,
+		8, 10, 11,
+
+		//Right Face
+		12, 13, 14,
+		12, 14, 15,
+
+		//Front Face
+		16, 17, 18,
+		16, 18, 19,
+
+		//Back Face
+		20, 21, 22,
+		20, 22, 23
+	};
+
+	//-----------------------------------------------------//
+	//-----------------------QUAD--------------------------//
+	//-----------------------------------------------------//
+	const VertexNormTex quadVertices[] =
+	{
+		//Front Face
+		{XMFLOAT3{-0.5f, -0.5f, -0.5f},  XMFLOAT3(),  XMFLOAT2{0.0f, 1.0f}},  //Bottom Left - 0
+		{XMFLOAT3{-0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{0.0f, 0.0f}},  //Top Left - 1
+		{XMFLOAT3{ 0.5f,  0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 0.0f}},  //Top Right - 2
+		{XMFLOAT3{ 0.5f, -0.5f, -0.5f},	 XMFLOAT3(),  XMFLOAT2{1.0f, 1.0f}},  //Bottom Right - 3
+	};
+
+	//Quad Indices
+	const uint32_t quadIndices[] = {
+		0, 1, 2,
+		0, 2, 3,
+	};
+
+	//AABB and the sphere around its center that encloses every vertex
+	//-----------------------------------------
+	Bounds computeBounds(const ImportedMesh& mesh)
+	{
+		Bounds bounds;
+		if (mesh.vertices.empty())
+		{
+			return bounds;
+		}
+
+		XMVECTOR aabbMin = XMLoadFloat3(&mesh.vertices[0].position);
+		XMVECTOR aabbMax = aabbMin;
+		for (const VertexNormTex& vertex : mesh.vertices)
+		{
+			aabbMin = XMVectorMin(aabbMin, XMLoadFloat3(&vertex.position));
+			aabbMax = XMVectorMax(aabbMax, XMLoadFloat3(&vertex.position));
+		}
+
+		XMVECTOR center = (aabbMin + aabbMax) * 0.5f;
+		XMVECTOR radiusSq = XMVectorZero();
+		for (const VertexNormTex& vertex : mesh.vertices)
+		{
+			radiusSq = XMVectorMax(radiusSq, XMVector3LengthSq(XMLoadFloat3(&vertex.position) - center));
+		}
+
+		XMStoreFloat3(&bounds.aabbMin, aabbMin);
+		XMStoreFloat3(&bounds.aabbMax, aabbMax);
+		XMStoreFloat3(&bounds.center, center);
+		bounds.radius = XMVectorGetX(XMVectorSqrt(radiusSq));
+		return bounds;
+	}
+
+	//---------------------------------------------------------------------------------------------
+	bool loadSource(const std::string& input, ImportedMesh& mesh, ImportStats& stats)
+	{
+		if (input == "cube" || input == "quad")
+		{
+			if (input == "cube")
+			{
+				mesh.vertices.assign(std::begin(cubeVertices), std::end(cubeVertices));
+				mesh.indices.assign(std::begin(cubeIndices), std::end(cubeIndices));
+			}
+			else
+			{
+				mesh.vertices.assign(std::begin(quadVertices), std::end(quadVertices));
+				mesh.indices.assign(std::begin(quadIndices), std::end(quadIndices));
+			}
+			generateNormals(mesh.vertices.data(), static_cast<uint32_t>(mesh.vertices.size()), mesh.indices.data(), mesh.indices.size());
+			mesh.generatedNormals = true;
+			return true;
+		}
+		return importMesh(input, mesh, &stats);
+	}
+
+	//-----------------------------------------------------------
+	double secondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+//-----------------------------
+int main(int argc, char* argv[])
+{
+	bool packed = argc > 1 && strcmp(argv[1], "-packed") == 0;
+	const int first = packed ? 2 : 1;
+	if (argc != first + 2)
+	{
+		fprintf(stderr, "usage: %s [-packed] <output.mesh> <input.obj | input.gltf | input.glb | cube | quad>\n", argv[0]);
+		return 1;
+	}
+	const std::string output = argv[first];
+	const std::string input = argv[first + 1];
+
+	auto start = std::chrono::steady_clock::now();
+	ImportedMesh mesh;
+	ImportStats stats;
+	if (!loadSource(input, mesh, stats) || mesh.indices.empty())
+	{
+		fprintf(stderr, "cannot read %s\n", input.c_str());
+		return 1;
+	}
+	const double importSeconds = secondsSince(start);
+	printf("%s : %zu triangles, %zu -> %zu vertices%s, imported in %.3f s (%.1f MB/s, %.2f M triangles/s)\n", input.c_str(),
+		mesh.indices.size() / 3, stats.sourceVertices, mesh.vertices.size(), mesh.generatedNormals ? ", normals generated" : "", importSeconds,
+		stats.fileBytes / importSeconds / 1e6, mesh.indices.size() / 3 / importSeconds / 1e6);
+
+	start = std::chrono::steady_clock::now();
+
+	//Optimize and simplify
+	std::vector<uint8_t> vertices(reinterpret_cast<const uint8_t*>(mesh.vertices.data()),
+		reinterpret_cast<const uint8_t*>(mesh.vertices.data() + mesh.vertices.size()));
+	MeshOptimizeReport report = optimizeMesh(vertices, sizeof(VertexNormTex), offsetof(VertexNormTex, position), mesh.indices);
+	mesh.vertices.resize(report.verticesAfter);
+	memcpy(mesh.vertices.data(), vertices.data(), mesh.vertices.size() * sizeof(VertexNormTex));
+	printf("optimized : ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  vertices %u -> %u\n",
+		report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr, report.verticesBefore, report.verticesAfter);
+
+	const uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	std::vector<MeshLod> lods = buildLodChain(mesh.indices, &mesh.vertices[0].position, sizeof(VertexNormTex), vertexCount);
+	printf("LOD : %zu levels  triangles %u -> %u  error %g\n", lods.size(), lods.front().indexCount / 3, lods.back().indexCount / 3, lods.back().error);
+
+	MeshAssetWriter writer;
+	writer.setIndices(mesh.indices.data(), mesh.indices.size());
+	writer.setBounds(computeBounds(mesh));
+	writer.addSubmesh(lods);
+	if (packed)
+	{
+		//Positions are packed relative to the bounds, the decode is stored with them
+		PositionDecode decode = computePositionDecode(mesh.vertices.data(), vertexCount);
+		std::vector<VertexNormTexPacked> packedVertices(vertexCount);
+		quantizeVertices(packedVertices.data(), mesh.vertices.data(), vertexCount, decode);
+		writer.setVertices(packedVertices.data(), vertexCount, sizeof(VertexNormTexPacked), vertexNormTexPackedLayout, 3);
+		writer.setPositionDecode(decode);
+
+		QuantizationError error = measureQuantizationError(packedVertices.data(), mesh.vertices.data(), vertexCount, decode);
+		printf("packed : max error position %g  normal %g degrees  uv %g\n", error.position, error.normalDegrees, error.texCoords);
+	}
+	else
+	{
+		writer.setVertices(mesh.vertices.data(), vertexCount, sizeof(VertexNormTex), vertexNormTexLayout, 3);
+	}
+	printf("cooked in %.3f s\n", secondsSince(start));
+
+	if (!writer.write(output))
+	{
+		fprintf(stderr, "cannot write %s\n", output.c_str());
+		return 1;
+	}
+	return 0;
+}
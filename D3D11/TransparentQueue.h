@@ -0,0 +1,60 @@
+#pragma once
+#include "RadixSort.h"
+
+//Single transparent draw : packed depth key plus an index into the caller's draw list
+struct TransparentDraw
+{
+	uint32_t key;
+	uint32_t drawIndex;
+};
+
+//Back to front ordering of transparent draws
+//Draws at equal distances are all kept and stay in submission order.
+//Storage is preallocated with reserve and reused every frame, so once the queue
+//has seen its largest frame push and sort do not allocate
+class TransparentQueue
+{
+public:
+
+	TransparentQueue() = default;
+	explicit TransparentQueue(size_t capacity) { reserve(capacity); }
+
+	//----------------------------------------
+	void reserve(size_t capacity)
+	{
+		draws.reserve(capacity);
+		scratch.reserve(capacity);
+		histograms.reserve(radixHistogramSize(capacity, true));
+	}
+
+	//----------------
+	void clear()
+	{
+		draws.clear();
+	}
+
+	//Farther draws get smaller keys so an ascending sort gives back to front order
+	//--------------------------------------------------
+	void push(float distance, uint32_t drawIndex)
+	{
+		draws.push_back({ ~floatToSortableUint(distance), drawIndex });
+	}
+
+	//parallel splits each radix pass across worker threads; worth it from ~100k draws
+	//-----------------------------------
+	void sort(bool parallel = false)
+	{
+		radixSort(draws, scratch, histograms, parallel);
+	}
+
+	const TransparentDraw* begin() const { return draws.data(); }
+	const TransparentDraw* end() const { return draws.data() + draws.size(); }
+	size_t size() const { return draws.size(); }
+	const TransparentDraw& operator[](size_t i) const { return draws[i]; }
+
+private:
+
+	std::vector<TransparentDraw> draws;
+	std::vector<TransparentDraw> scratch;
+	std::vector<uint32_t> histograms;
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+
+struct VertexNorm
+{
+	XMFLOAT3 position;
+	XMFLOAT3 normal;
+};
+
+struct VertexNormTex
+{
+	XMFLOAT3 position;
+	XMFLOAT3 normal;
+	XMFLOAT2 texCoords;
+};
+
+//VertexNormTex in 16 bytes instead of 32, built by quantizeVertices (VertexQuantization.h)
+//and drawn with packedVertexShader in Box.hlsl
+struct VertexNormTexPacked
+{
+	PackedVector::XMUSHORTN4 position;	//xyz in [0, 1] over the mesh bounds, w unused
+	PackedVector::XMSHORTN2 normal;		//octahedral
+	PackedVector::XMHALF2 texCoords;
+};
+
+struct VertexColor
+{
+	XMFLOAT3 position;
+	XMFLOAT4 color;
+};
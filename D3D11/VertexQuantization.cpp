@@ -0,0 +1,312 @@
+#include "VertexQuantization.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//F16C ships with every AVX2 cpu, gcc and clang only need to be told
+#if defined(__AVX2__) && (defined(_MSC_VER) || defined(__F16C__))
+#define QUANTIZE_AVX2
+#endif
+
+namespace
+{
+	const float unormMax{ 65535.0f };
+	const float snormMax{ 32767.0f };
+
+	//------------------------------------
+	float signNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	//------------------------------------
+	uint16_t toUNorm16(float value)
+	{
+		return static_cast<uint16_t>(std::nearbyint(std::min(std::max(value, 0.0f), 1.0f) * unormMax));
+	}
+
+	//------------------------------------
+	int16_t toSNorm16(float value)
+	{
+		return static_cast<int16_t>(std::nearbyint(std::min(std::max(value, -1.0f), 1.0f) * snormMax));
+	}
+
+	//Reciprocal of the extent, 0 for a flat axis so every vertex lands on offset
+	//--------------------------------------------------------------
+	XMFLOAT3 inverseScale(const PositionDecode& decode)
+	{
+		return XMFLOAT3{ decode.scale.x > 0.0f ? 1.0f / decode.scale.x : 0.0f,
+			decode.scale.y > 0.0f ? 1.0f / decode.scale.y : 0.0f,
+			decode.scale.z > 0.0f ? 1.0f / decode.scale.z : 0.0f };
+	}
+
+	//Scalar reference, the AVX2 loop does the same operations in the same order
+	//-----------------------------------------------------------------------------------------------------------------
+	void quantizeVertex(VertexNormTexPacked& out, const VertexNormTex& in, const XMFLOAT3& offset, const XMFLOAT3& invScale)
+	{
+		out.position.x = toUNorm16((in.position.x - offset.x) * invScale.x);
+		out.position.y = toUNorm16((in.position.y - offset.y) * invScale.y);
+		out.position.z = toUNorm16((in.position.z - offset.z) * invScale.z);
+		out.position.w = 0;
+
+		XMFLOAT2 octahedral = encodeOctahedral(in.normal);
+		out.normal.x = toSNorm16(octahedral.x);
+		out.normal.y = toSNorm16(octahedral.y);
+
+		out.texCoords.x = PackedVector::XMConvertFloatToHalf(in.texCoords.x);
+		out.texCoords.y = PackedVector::XMConvertFloatToHalf(in.texCoords.y);
+	}
+
+#if defined(QUANTIZE_AVX2)
+	//Rows of 8 floats to columns, r[i] holds vertex i on entry and attribute i on exit
+	//-------------------------------------
+	void transpose8x8(__m256 r[8])
+	{
+		__m256 t[8];
+		for (int i{ 0 }; i < 8; i += 2)
+		{
+			t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+			t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+		}
+		__m256 s[8];
+		for (int i{ 0 }; i < 8; i += 4)
+		{
+			s[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+			s[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+			s[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+			s[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+		}
+		for (int i{ 0 }; i < 4; i++)
+		{
+			r[i] = _mm256_permute2f128_ps(s[i], s[i + 4], 0x20);
+			r[i + 4] = _mm256_permute2f128_ps(s[i], s[i + 4], 0x31);
+		}
+	}
+
+	//--------------------------------------------------
+	__m256 clampAVX2(__m256 value, __m256 low, __m256 high)
+	{
+		return _mm256_min_ps(_mm256_max_ps(value, low), high);
+	}
+
+	//--------------------------------------------------
+	__m256 signNotZeroAVX2(__m256 value)
+	{
+		__m256 negative = _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_LT_OQ);
+		return _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_set1_ps(-1.0f), negative);
+	}
+
+	//Quantizes vertices in blocks of 8, returns how many were done
+	//---------------------------------------------------------------------------------------------------------------------------------
+	uint32_t quantizeVerticesAVX2(VertexNormTexPacked* destination, const VertexNormTex* vertices, uint32_t vertexCount, const XMFLOAT3& offset,
+		const XMFLOAT3& invScale)
+	{
+		static_assert(sizeof(VertexNormTex) == sizeof(__m256), "one vertex per ymm register");
+
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 minusOne = _mm256_set1_ps(-1.0f);
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		const __m256 offsets[3]{ _mm256_set1_ps(offset.x), _mm256_set1_ps(offset.y), _mm256_set1_ps(offset.z) };
+		const __m256 invScales[3]{ _mm256_set1_ps(invScale.x), _mm256_set1_ps(invScale.y), _mm256_set1_ps(invScale.z) };
+
+		alignas(32) int32_t position[3][8];
+		alignas(32) int32_t normal[2][8];
+		alignas(16) uint16_t texCoords[2][8];
+
+		uint32_t v{ 0 };
+		for (; v + 8 <= vertexCount; v += 8)
+		{
+			__m256 rows[8];
+			for (int i{ 0 }; i < 8; i++)
+			{
+				rows[i] = _mm256_loadu_ps(&vertices[v + i].position.x);
+			}
+			transpose8x8(rows);
+
+			//Positions, cvtps rounds to nearest even like nearbyint
+			for (int c{ 0 }; c < 3; c++)
+			{
+				__m256 unorm = clampAVX2(_mm256_mul_ps(_mm256_sub_ps(rows[c], offsets[c]), invScales[c]), zero, one);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(position[c]), _mm256_cvtps_epi32(_mm256_mul_ps(unorm, _mm256_set1_ps(unormMax))));
+			}
+
+			//Normals onto the octahedron, folding the lower half
+			__m256 absX = _mm256_and_ps(rows[3], absMask);
+			__m256 absY = _mm256_and_ps(rows[4], absMask);
+			__m256 absZ = _mm256_and_ps(rows[5], absMask);
+			__m256 length = _mm256_add_ps(_mm256_add_ps(absX, absY), absZ);
+			__m256 invLength = _mm256_and_ps(_mm256_div_ps(one, length), _mm256_cmp_ps(length, zero, _CMP_GT_OQ));
+			__m256 x = _mm256_mul_ps(rows[3], invLength);
+			__m256 y = _mm256_mul_ps(rows[4], invLength);
+			__m256 foldedX = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_and_ps(y, absMask)), signNotZeroAVX2(x));
+			__m256 foldedY = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_and_ps(x, absMask)), signNotZeroAVX2(y));
+			__m256 lower = _mm256_cmp_ps(rows[5], zero, _CMP_LT_OQ);
+			x = _mm256_blendv_ps(x, foldedX, lower);
+			y = _mm256_blendv_ps(y, foldedY, lower);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(normal[0]), _mm256_cvtps_epi32(_mm256_mul_ps(clampAVX2(x, minusOne, one), _mm256_set1_ps(snormMax))));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(normal[1]), _mm256_cvtps_epi32(_mm256_mul_ps(clampAVX2(y, minusOne, one), _mm256_set1_ps(snormMax))));
+
+			//Texture coordinates
+			_mm_store_si128(reinterpret_cast<__m128i*>(texCoords[0]), _mm256_cvtps_ph(rows[6], _MM_FROUND_TO_NEAREST_INT));
+			_mm_store_si128(reinterpret_cast<__m128i*>(texCoords[1]), _mm256_cvtps_ph(rows[7], _MM_FROUND_TO_NEAREST_INT));
+
+			for (int i{ 0 }; i < 8; i++)
+			{
+				VertexNormTexPacked& out = destination[v + i];
+				out.position.x = static_cast<uint16_t>(position[0][i]);
+				out.position.y = static_cast<uint16_t>(position[1][i]);
+				out.position.z = static_cast<uint16_t>(position[2][i]);
+				out.position.w = 0;
+				out.normal.x = static_cast<int16_t>(normal[0][i]);
+				out.normal.y = static_cast<int16_t>(normal[1][i]);
+				out.texCoords.x = texCoords[0][i];
+				out.texCoords.y = texCoords[1][i];
+			}
+		}
+		return v;
+	}
+#endif
+}
+
+//---------------------------------------------------
+XMFLOAT2 encodeOctahedral(const XMFLOAT3& normal)
+{
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+	float x = normal.x * invLength;
+	float y = normal.y * invLength;
+	if (normal.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::fabs(y)) * signNotZero(x);
+		float foldedY = (1.0f - std::fabs(x)) * signNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+	return XMFLOAT2{ x, y };
+}
+
+//------------------------------------------------
+XMFLOAT3 decodeOctahedral(float x, float y)
+{
+	float z = 1.0f - std::fabs(x) - std::fabs(y);
+	if (z < 0.0f)
+	{
+		float unfoldedX = (1.0f - std::fabs(y)) * signNotZero(x);
+		float unfoldedY = (1.0f - std::fabs(x)) * signNotZero(y);
+		x = unfoldedX;
+		y = unfoldedY;
+	}
+	float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+	return XMFLOAT3{ x * invLength, y * invLength, z * invLength };
+}
+
+//---------------------------------------------------------------------------------------
+PositionDecode computePositionDecode(const VertexNormTex* vertices, uint32_t vertexCount)
+{
+	PositionDecode decode;
+	if (vertexCount == 0)
+	{
+		return decode;
+	}
+
+	XMFLOAT3 low = vertices[0].position;
+	XMFLOAT3 high = vertices[0].position;
+	for (uint32_t v{ 1 }; v < vertexCount; v++)
+	{
+		const XMFLOAT3& p = vertices[v].position;
+		low = XMFLOAT3{ std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z) };
+		high = XMFLOAT3{ std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z) };
+	}
+	decode.offset = low;
+	decode.scale = XMFLOAT3{ high.x - low.x, high.y - low.y, high.z - low.z };
+	return decode;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------
+void quantizeVertices(VertexNormTexPacked* destination, const VertexNormTex* vertices, uint32_t vertexCount, const PositionDecode& decode)
+{
+	const XMFLOAT3 invScale = inverseScale(decode);
+	uint32_t v{ 0 };
+#if defined(QUANTIZE_AVX2)
+	v = quantizeVerticesAVX2(destination, vertices, vertexCount, decode.offset, invScale);
+#endif
+	for (; v < vertexCount; v++)
+	{
+		quantizeVertex(destination[v], vertices[v], decode.offset, invScale);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+VertexNormTex dequantizeVertex(const VertexNormTexPacked& vertex, const PositionDecode& decode)
+{
+	VertexNormTex out;
+	out.position = XMFLOAT3{ decode.offset.x + vertex.position.x / unormMax * decode.scale.x,
+		decode.offset.y + vertex.position.y / unormMax * decode.scale.y,
+		decode.offset.z + vertex.position.z / unormMax * decode.scale.z };
+	//SNORM maps both -32768 and -32767 to -1
+	out.normal = decodeOctahedral(std::max(vertex.normal.x / snormMax, -1.0f), std::max(vertex.normal.y / snormMax, -1.0f));
+	out.texCoords = XMFLOAT2{ PackedVector::XMConvertHalfToFloat(vertex.texCoords.x), PackedVector::XMConvertHalfToFloat(vertex.texCoords.y) };
+	return out;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------------
+QuantizationError measureQuantizationError(const VertexNormTexPacked* packed, const VertexNormTex* vertices, uint32_t vertexCount,
+	const PositionDecode& decode)
+{
+	QuantizationError error;
+	double maxAngle{ 0.0 };
+	for (uint32_t v{ 0 }; v < vertexCount; v++)
+	{
+		const VertexNormTex& reference = vertices[v];
+		const VertexNormTex unpacked = dequantizeVertex(packed[v], decode);
+
+		double dx = double{ unpacked.position.x } - reference.position.x;
+		double dy = double{ unpacked.position.y } - reference.position.y;
+		double dz = double{ unpacked.position.z } - reference.position.z;
+		error.position = std::max(error.position, static_cast<float>(std::sqrt(dx * dx + dy * dy + dz * dz)));
+
+		//atan2 of the cross and dot products stays accurate for tiny angles, acos does not
+		const XMFLOAT3& n = reference.normal;
+		const XMFLOAT3& m = unpacked.normal;
+		double length = std::sqrt(double{ n.x } * n.x + double{ n.y } * n.y + double{ n.z } * n.z);
+		if (length > 0.0)
+		{
+			double cx = (double{ n.y } * m.z - double{ n.z } * m.y) / length;
+			double cy = (double{ n.z } * m.x - double{ n.x } * m.z) / length;
+			double cz = (double{ n.x } * m.y - double{ n.y } * m.x) / length;
+			double dot = (double{ n.x } * m.x + double{ n.y } * m.y + double{ n.z } * m.z) / length;
+			maxAngle = std::max(maxAngle, std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot));
+		}
+
+		error.texCoords = std::max({ error.texCoords, std::fabs(unpacked.texCoords.x - reference.texCoords.x),
+			std::fabs(unpacked.texCoords.y - reference.texCoords.y) });
+	}
+	error.normalDegrees = static_cast<float>(maxAngle * 180.0 / XM_PI);
+	return error;
+}
+
+//-----------------------------------------------------------------------------------------
+QuantizationError quantizationErrorBound(const PositionDecode& decode, float maxTexCoord)
+{
+	const XMFLOAT3& s = decode.scale;
+	const XMFLOAT3& o = decode.offset;
+	float extent = std::sqrt(s.x * s.x + s.y * s.y + s.z * s.z);
+	float magnitude = std::sqrt(o.x * o.x + o.y * o.y + o.z * o.z) + extent;
+
+	QuantizationError bound;
+	//Half a step per axis, plus float rounding of the encode and decode arithmetic
+	bound.position = 0.5f / unormMax * extent + 8.0f * FLT_EPSILON * magnitude;
+
+	//Half a step on x and y moves the point on the octahedron by at most sqrt(1.5) steps
+	//(z takes up both), and no point of the octahedron is closer than 1/sqrt(3) to the
+	//centre, so the angle is at most sqrt(4.5) steps in radians
+	bound.normalDegrees = static_cast<float>((std::sqrt(4.5) / snormMax + 1e-6) * 180.0 / XM_PI);
+
+	//Half an ulp of a 11 bit significand, or of the smallest subnormal
+	bound.texCoords = std::max(maxTexCoord * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25));
+	return bound;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "Vertex.h"
+#include <cstdint>
+
+//Takes the UNORM positions of a VertexNormTexPacked back to local space,
+//position = offset + unorm * scale, where scale is the extent of the mesh bounds
+struct PositionDecode
+{
+	XMFLOAT3 offset{ 0.0f, 0.0f, 0.0f };
+	XMFLOAT3 scale{ 0.0f, 0.0f, 0.0f };
+
+	//Row vector matrix, goes before the world matrix
+	XMMATRIX matrix() const { return XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixTranslation(offset.x, offset.y, offset.z); }
+};
+
+//Largest difference between packed vertices and the float vertices they came from
+struct QuantizationError
+{
+	float position{ 0.0f };			//distance in local space units
+	float normalDegrees{ 0.0f };	//angle to the normalized float normal
+	float texCoords{ 0.0f };		//per component
+};
+
+//Octahedral normal encoding (Cigolle et al. 2014): the unit sphere is projected onto the
+//octahedron |x| + |y| + |z| = 1 and the lower half folded over the upper one into [-1, 1]^2.
+//Zero vectors encode as (0, 0), which decodes to +z
+XMFLOAT2 encodeOctahedral(const XMFLOAT3& normal);
+XMFLOAT3 decodeOctahedral(float x, float y);
+
+//Bounds of the positions, the decode quantizeVertices packs against
+PositionDecode computePositionDecode(const VertexNormTex* vertices, uint32_t vertexCount);
+
+//Packs vertices into destination: positions as 16 bit UNORM relative to decode, normals
+//octahedral as 16 bit SNORM, texture coordinates as half. Rounding is to nearest (even)
+//everywhere, so the AVX2 path, which converts 8 vertices per iteration, gives the same bits
+//as the scalar one
+void quantizeVertices(VertexNormTexPacked* destination, const VertexNormTex* vertices, uint32_t vertexCount, const PositionDecode& decode);
+
+//Unpacks one vertex the way the input assembler and packedVertexShader do
+VertexNormTex dequantizeVertex(const VertexNormTexPacked& vertex, const PositionDecode& decode);
+
+//Measured error of the packed vertices against the originals
+QuantizationError measureQuantizationError(const VertexNormTexPacked* packed, const VertexNormTex* vertices, uint32_t vertexCount,
+	const PositionDecode& decode);
+
+//Worst case error of quantizeVertices for a decode and the largest texture coordinate magnitude:
+//half a UNORM step on every axis, half an SNORM step on both octahedral axes stretched by the
+//projection back to the sphere, and half a half precision ulp
+QuantizationError quantizationErrorBound(const PositionDecode& decode, float maxTexCoord);
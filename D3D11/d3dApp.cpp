@@ -156,6 +156,13 @@ bool d3dApp::initD3D()
 
 	ThrowIfFailed(factory->CreateSwapChain(d3dDevice.Get(), &swapDesc, swapChain.GetAddressOf()));
 
+	//Render device over the D3D11 objects, owns the back buffer and depth/stencil views
+	auto d3d11Device = std::make_unique<D3D11RenderDevice>(d3dDevice, d3dImmediateContext, swapChain, swapDesc.SampleDesc);
+	d3d11RenderDevice = d3d11Device.get();
+	stateCache = std::make_unique<StateCache>(d3d11Device->immediateContext());
+	renderContext = stateCache.get();
+	renderDevice = std::move(d3d11Device);
+
 	//Disable alt+enter for fullscreen switching
 	//ThrowIfFailed(factory->MakeWindowAssociation(appWindow, DXGI_MWA_NO_WINDOW_CHANGES));
 
@@ -167,59 +174,11 @@ bool d3dApp::initD3D()
 //---------------------
 void d3dApp::onResize()
 {
-	assert(d3dDevice);
-	assert(d3dImmediateContext);
-	assert(swapChain);
-
-	depthStencilView.Reset();
-	depthStencilBuffer.Reset();
-	renderTargetView.Reset();
-
-	//Create Render target view for swap chain back buffer
-	ThrowIfFailed(swapChain->ResizeBuffers(1, appWidth, appHeight, DXGI_FORMAT_R8G8B8A8_UNORM, 0));
-	ComPtr<ID3D11Texture2D> backBuffer;
-	ThrowIfFailed(swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)backBuffer.GetAddressOf()));
-	ThrowIfFailed(d3dDevice->CreateRenderTargetView(backBuffer.Get(), 0, renderTargetView.GetAddressOf()));
-	
-	//Create Depth/Stencil buffer
-	D3D11_TEXTURE2D_DESC texDesc;
-	texDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-	texDesc.Height = appHeight;
-	texDesc.Width = appWidth;
-	texDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-	texDesc.Usage = D3D11_USAGE_DEFAULT;
-	texDesc.CPUAccessFlags = 0;
-	texDesc.MiscFlags = 0;
-	texDesc.ArraySize = 1;
-	texDesc.MipLevels = 1;
+	assert(renderDevice);
 
-	if (msaaEnabled)
-	{
-		texDesc.SampleDesc.Count = 4;
-		texDesc.SampleDesc.Quality = msaaQualityLevels - 1;
-	}
-	else
-	{
-		texDesc.SampleDesc.Count = 1;
-		texDesc.SampleDesc.Quality = 0;
-	}
-
-	//Create Depth/Stencil View
-	ThrowIfFailed(d3dDevice->CreateTexture2D(&texDesc, 0, depthStencilBuffer.GetAddressOf()));
-	ThrowIfFailed(d3dDevice->CreateDepthStencilView(depthStencilBuffer.Get(), 0, depthStencilView.GetAddressOf()));
-
-	//Bind render target view and depthStencil view to output merger state
-	d3dImmediateContext->OMSetRenderTargets(1, renderTargetView.GetAddressOf(), depthStencilView.Get());
-
-	//Set Viewport
-	mainViewPort.TopLeftX = 0.0f;
-	mainViewPort.TopLeftY = 0.0f;
-	mainViewPort.Width = static_cast<float>(appWidth);
-	mainViewPort.Height = static_cast<float>(appHeight);
-	mainViewPort.MinDepth = 0.0f;
-	mainViewPort.MaxDepth = 1.0f;
-
-	d3dImmediateContext->RSSetViewports(1, &mainViewPort);
+	//Recreates the back buffer views and resets the viewport behind the state cache's back
+	renderDevice->resize(appWidth, appHeight);
+	stateCache->invalidate();
 }
 
 //-----------------------------------------------------------------
@@ -285,61 +244,214 @@ void d3dApp::displayAdapterProperties(ComPtr<IDXGIFactory> factory)
 	vAdapters.clear();		
 }
 
+//Starts the render thread and pumps window messages until the window is gone
 //---------------
 int d3dApp::run()
 {
-	MSG msg{ 0 };
 	gameTimer.reset();
+	renderThread = std::thread{ &d3dApp::renderLoop, this };
 
-	while (msg.message != WM_QUIT)
+	//GetMessage sleeps until there is a message, the render thread doesn't wait on this loop
+	MSG msg{ 0 };
+	while (GetMessage(&msg, 0, 0, 0) > 0)
 	{
-		if (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
-		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
-		else
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+
+	stopRenderThread();
+	if (renderError)
+	{
+		std::rethrow_exception(renderError);
+	}
+	return static_cast<int>(msg.wParam);
+}
+
+//Update and draw loop of the render thread
+//Events queued by the window thread are applied first, so everything a frame draws has seen all
+//input received before the frame started
+//----------------------
+void d3dApp::renderLoop()
+{
+	try
+	{
+		while (!renderQuit.load(std::memory_order_acquire))
 		{
+			InputFrame input = drainInput(inputQueue, inputState, [this](const InputEvent& event) { handleEvent(event); });
+
 			gameTimer.tick();
-			if (!appPaused)
+			if (appPaused)
 			{
-				calculateFrameStats();
-				updateScene(gameTimer.getDeltaTime());
+				Sleep(100);
+				continue;
+			}
+
+			if (inputState.keyPressed(VK_F9))
+			{
+				globalProfiler().setEnabled(!globalProfiler().isEnabled());
+			}
+			if (inputState.keyPressed(VK_F10))
+			{
+				globalProfiler().writeChromeTrace("profile.json");
+			}
+
+			updateFrameStats();
+			moveCamera(gameTimer.getDeltaTime());
+			updateFrame(gameTimer.getDeltaTime());
+			{
+				PROFILE_SCOPE("updateScene");
+				if (fixedTimestepMode)
+				{
+					uint32_t steps = fixedTimestep.advance(gameTimer.deltaNanoseconds());
+					for (uint32_t i{ 0 }; i < steps; i++)
+					{
+						updateScene(static_cast<float>(fixedTimestep.stepSeconds()));
+					}
+				}
+				else
+				{
+					updateScene(gameTimer.getDeltaTime());
+				}
+			}
+			{
+				PROFILE_SCOPE("drawScene");
 				drawScene();
 			}
-			else
+
+			//drawScene ends with Present
+			if (input.oldestInputTime != 0)
 			{
-				Sleep(100);
+				inputLatencies.push(static_cast<float>((profilerNow() - input.oldestInputTime) * 1e-6));
 			}
 		}
 	}
-	return static_cast<int>(msg.wParam);
+	catch (...)
+	{
+		//Hand the error to run and close the window; renderQuit stops postEvent waiting for room
+		renderError = std::current_exception();
+		renderQuit.store(true, std::memory_order_release);
+		PostMessage(appWindow, WM_CLOSE, 0, 0);
+	}
+}
+
+//Waits for the render thread to finish its frame and exit
+//------------------------------
+void d3dApp::stopRenderThread()
+{
+	if (!renderThread.joinable())
+	{
+		return;
+	}
+
+	renderQuit.store(true, std::memory_order_release);
+	//Keep handling messages while waiting, Present, ResizeBuffers and SetWindowText can send
+	//messages to the window and wait for this thread to handle them
+	HANDLE thread = renderThread.native_handle();
+	while (MsgWaitForMultipleObjects(1, &thread, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0 + 1)
+	{
+		MSG msg;
+		while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+		{
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+	}
+	renderThread.join();
+}
+
+//Window thread side of the queue
+//--------------------------------------------------
+void d3dApp::postEvent(const InputEvent& event)
+{
+	//Until run starts the render thread, this is the only thread there is
+	if (!renderThread.joinable())
+	{
+		inputState.apply(event);
+		handleEvent(event);
+		return;
+	}
+
+	//A dropped move is made up by the next one, it carries the absolute position. Anything else
+	//waits for the render thread to make room, it drains the whole queue every frame. Messages
+	//sent from the render thread (SetWindowText, DXGI) are handled meanwhile so it can get there
+	while (!inputQueue.push(event))
+	{
+		if (event.type == InputEventType::MouseMove || renderQuit.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		MSG msg;
+		PeekMessage(&msg, 0, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+		std::this_thread::yield();
+	}
+}
+
+//Render thread side of the queue, inputState has already seen the event
+//----------------------------------------------------
+void d3dApp::handleEvent(const InputEvent& event)
+{
+	switch (event.type)
+	{
+	case InputEventType::MouseButtonDown:
+		onMouseButtonDown(event.code, event.x, event.y);
+		break;
+	case InputEventType::MouseButtonUp:
+		onMouseButtonUp(event.code, event.x, event.y);
+		break;
+	case InputEventType::MouseMove:
+		onMouseMove(event.code, event.x, event.y);
+		break;
+	case InputEventType::Resize:
+		appWidth = event.x;
+		appHeight = event.y;
+		//if direct3d has been initialized already
+		if (event.code != 0 && renderDevice)
+		{
+			onResize();
+		}
+		break;
+	case InputEventType::Pause:
+		appPaused = true;
+		gameTimer.stop();
+		break;
+	case InputEventType::Resume:
+		appPaused = false;
+		gameTimer.start();
+		break;
+	default:
+		break;
+	}
 }
 
 //---------------------------------------------------------------------------
 LRESULT d3dApp::msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+	//Runs on the window thread, everything the render thread owns is reached through events
+	auto post = [this](InputEventType type, uint32_t code, int32_t x, int32_t y)
+	{
+		postEvent({ type, code, x, y, profilerNow() });
+	};
+
 	switch (msg)
 	{
 	//window is selected by the user or deselected 
 	case WM_ACTIVATE:
 		if (LOWORD(wParam) == WA_INACTIVE)
 		{
-			appPaused = true;
-			gameTimer.stop();
+			post(InputEventType::FocusLost, 0, 0, 0);
+			post(InputEventType::Pause, 0, 0, 0);
 		}
 		else
 		{
-			appPaused = false;
-			gameTimer.start();
+			post(InputEventType::Resume, 0, 0, 0);
 		}
 		return 0;
 
 	//Called anytime a windows size is changed in any scenario
 	//lo and hi byte of lParam contains the updated window width and height
 	case WM_SIZE:
-		appWidth = LOWORD(lParam);
-		appHeight = HIWORD(lParam);
+	{
+		bool resizeBuffers{ false };
 		//if direct3d has been initialized already
 		if (d3dDevice)
 		{
@@ -348,15 +460,14 @@ LRESULT d3dApp::msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			{
 				appMinimized = false;
 				appMaximized = true;
-				onResize();
+				resizeBuffers = true;
 			}
 			//window has been minimized
 			else if (wParam == SIZE_MINIMIZED)
 			{
 				appMinimized = true;
 				appMaximized = false; 
-				appPaused = true;
-				gameTimer.stop();
+				post(InputEventType::Pause, 0, 0, 0);
 			}
 			//called when window's size change doesn't correspond to either minimize or maximize
 			else if (wParam == SIZE_RESTORED)
@@ -365,15 +476,14 @@ LRESULT d3dApp::msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				if (appMinimized)
 				{
 					appMinimized = false;
-					appPaused = false;
-					gameTimer.start();
-					onResize();
+					post(InputEventType::Resume, 0, 0, 0);
+					resizeBuffers = true;
 				}
 				//Resizing from maximized state
 				else if (appMaximized)
 				{
 					appMaximized = false;
-					onResize();
+					resizeBuffers = true;
 				}
 				//if the user is resizing the bars then we don't need to constantly resize buffers and view
 				//therefore do nothing. WM_EXITSIZEMOVE handles resize when the user stops resizing
@@ -387,27 +497,31 @@ LRESULT d3dApp::msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 					  1.Function SetWindowPos - used to change a windows position on the screen
 					  2.Function swapChain->SetFullscreenState - automatically called when pressing alt + enter 
 					  etc. */
-					onResize();
+					resizeBuffers = true;
 				}
 			}
 		}
+		post(InputEventType::Resize, resizeBuffers ? 1 : 0, LOWORD(lParam), HIWORD(lParam));
 		return 0;
+	}
 
 	/* following two cases consider user manually resizing window and as such
 	   need not be handled in WM_SIZE case */
 	//User clicked on resize bars of window
 	case WM_ENTERSIZEMOVE:
-		appPaused = true;
 		appResizing = true;
-		gameTimer.stop();
+		post(InputEventType::Pause, 0, 0, 0);
 		return 0;
 	//User lets go of the resize bars
 	case WM_EXITSIZEMOVE:
-		appPaused = false;
+	{
 		appResizing = false;
-		gameTimer.start();
-		onResize();
+		RECT client;
+		GetClientRect(hWnd, &client);
+		post(InputEventType::Resume, 0, 0, 0);
+		post(InputEventType::Resize, 1, client.right - client.left, client.bottom - client.top);
 		return 0;
+	}
 
 	//Any key combinations pressed by the user that doesn't correspond to any window menu
 	//function shortcut will cause Windows to make a "beep" sound
@@ -426,27 +540,62 @@ LRESULT d3dApp::msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	case WM_LBUTTONDOWN:
 	case WM_RBUTTONDOWN:
 	case WM_MBUTTONDOWN:
-		onMouseButtonDown(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		post(InputEventType::MouseButtonDown, static_cast<uint32_t>(wParam), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;		
 	case WM_LBUTTONUP:
 	case WM_RBUTTONUP:
 	case WM_MBUTTONUP:
-		onMouseButtonUp(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		post(InputEventType::MouseButtonUp, static_cast<uint32_t>(wParam), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 	case WM_MOUSEMOVE:
-		onMouseMove(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		post(InputEventType::MouseMove, static_cast<uint32_t>(wParam), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
+	//Keys are sampled once per frame, auto repeat (bit 30 of lParam set) is not forwarded
 	case WM_KEYDOWN:
 		if (wParam == VK_ESCAPE)
 		{
-			DestroyWindow(appWindow);
+			PostMessage(hWnd, WM_CLOSE, 0, 0);
 		}
-		else
+		else if ((lParam & (1 << 30)) == 0)
 		{
-			moveCamera(wParam);
+			post(InputEventType::KeyDown, static_cast<uint32_t>(wParam), 0, 0);
 		}
-		return 0;	
+		return 0;
+	case WM_KEYUP:
+		post(InputEventType::KeyUp, static_cast<uint32_t>(wParam), 0, 0);
+		return 0;
+
+	//F10 arrives as a system key and would otherwise put the window into menu mode. Other
+	//system keys (alt + F4, alt + enter) keep their default handling
+	case WM_SYSKEYDOWN:
+		if (wParam == VK_F10)
+		{
+			if ((lParam & (1 << 30)) == 0)
+			{
+				post(InputEventType::KeyDown, VK_F10, 0, 0);
+			}
+			return 0;
+		}
+		break;
+	case WM_SYSKEYUP:
+		if (wParam == VK_F10)
+		{
+			post(InputEventType::KeyUp, VK_F10, 0, 0);
+			return 0;
+		}
+		break;
+
+	//The render thread stops before the window and its swap chain go away. Messages are
+	//handled while it stops, so a second close can arrive in the meantime
+	case WM_CLOSE:
+		if (!appClosing)
+		{
+			appClosing = true;
+			stopRenderThread();
+			DestroyWindow(hWnd);
+		}
+		return 0;
 
 	case WM_DESTROY:
 		PostQuitMessage(0);
@@ -456,40 +605,41 @@ LRESULT d3dApp::msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
-//------------------------------------
-void d3dApp::moveCamera(WPARAM wParam)
+//Moves the camera by the keys held this frame
+//------------------------------------------
+void d3dApp::moveCamera(float deltaTime)
 {
 	XMVECTOR camPos = XMLoadFloat4(&(this->camPos));
 	XMVECTOR camLookAt = XMLoadFloat3(&(this->camLookAt));
 	XMVECTOR right = XMVectorZero();
 
 	//W - Move Forward
-	if (wParam == 0x57)
+	if (inputState.keyDown(0x57))
 	{
-		camPos += camLookAt * camSpeed * gameTimer.getDeltaTime();
+		camPos += camLookAt * camSpeed * deltaTime;
 		XMStoreFloat4(&(this->camPos), camPos);
 	}
 
 	//S - Move Backward
-	if (wParam == 0x53)
+	if (inputState.keyDown(0x53))
 	{
-		camPos -= camLookAt * camSpeed * gameTimer.getDeltaTime();
+		camPos -= camLookAt * camSpeed * deltaTime;
 		XMStoreFloat4(&(this->camPos), camPos);
 	}
 
 	//A - Move Left
-	if (wParam == 0x41)
+	if (inputState.keyDown(0x41))
 	{
 		right = XMVector3Normalize(XMVector3Cross({ 0.0f, 1.0f, 0.0f }, camLookAt));
-		camPos -= right * camSpeed * gameTimer.getDeltaTime();
+		camPos -= right * camSpeed * deltaTime;
 		XMStoreFloat4(&(this->camPos), camPos);
 	}
 
 	//D - Move Right
-	if (wParam == 0x44)
+	if (inputState.keyDown(0x44))
 	{
 		right = XMVector3Normalize(XMVector3Cross({ 0.0f, 1.0f, 0.0f }, camLookAt));
-		camPos += right * camSpeed * gameTimer.getDeltaTime();
+		camPos += right * camSpeed * deltaTime;
 		XMStoreFloat4(&(this->camPos), camPos);
 	}
 }
@@ -537,26 +687,42 @@ void d3dApp::onMouseMove(WPARAM wParam, int x, int y)
 	}
 }
 
-//--------------------------------
-void d3dApp::calculateFrameStats()
+//-----------------------------
+void d3dApp::updateFrameStats()
 {
-	static int frameCount{ 0 };  
-	static float timeElapsed{ 0 };
-	frameCount++;
+	Profiler& profiler = globalProfiler();
+	profiler.markFrame();
 
-	//display fps
-	if ((gameTimer.totalTime() - timeElapsed) > 1.0f)
-	{
-		float fps = static_cast<float>(frameCount);
-		float mspf = 1000.0f / fps;  //ms per frame
+	lastFrameStateStats = stateCache->stats();
+	stateCache->resetStats();
 
-		std::wostringstream wout;
-		wout.precision(6);
-		wout << windowName << L"  FPS : " << fps << L"  ms : " << mspf;
-		SetWindowText(appWindow, wout.str().c_str());
+	int64_t now = profilerNow();
+	if (lastStatsUpdate == 0)
+	{
+		lastStatsUpdate = now;
+		return;
+	}
 
-		frameCount = 0;
-		timeElapsed += 1.0f;
+	//Percentiles cover the frames held in the profiler's ring, fps the last second only
+	if (now - lastStatsUpdate > 1000000000)
+	{
+		double seconds = (now - lastStatsUpdate) * 1e-9;
+		double fps = (profiler.frameCount() - lastStatsFrameCount) / seconds;
+		FrameStats stats = profiler.frameStats();
+
+		//Input latency over the last 256 frames that had input
+		std::vector<float> latencies;
+		inputLatencies.snapshot(latencies);
+		FrameStats latency = computeFrameStats(latencies);
+
+		wchar_t title[320];
+		swprintf(title, 320, L"%s  FPS : %.0f  ms p50 : %.2f  p95 : %.2f  p99 : %.2f  max : %.2f  input ms p50 : %.2f  p95 : %.2f  calls : %llu (%llu elided)%s",
+			windowName, fps, stats.p50Ms, stats.p95Ms, stats.p99Ms, stats.maxMs, latency.p50Ms, latency.p95Ms,
+			lastFrameStateStats.issued, lastFrameStateStats.elided, profiler.isEnabled() ? L"  [capturing]" : L"");
+		SetWindowText(appWindow, title);
+
+		lastStatsUpdate = now;
+		lastStatsFrameCount = profiler.frameCount();
 	}
 }
 
@@ -581,6 +747,13 @@ XMFLOAT3 d3dApp::getCameraTarget()
 //---------------
 d3dApp::~d3dApp() 
 {
+	//Only still running if run was left by an exception on the window thread
+	if (renderThread.joinable())
+	{
+		renderQuit.store(true, std::memory_order_release);
+		renderThread.join();
+	}
+
 #if defined(REPORT_LIVE_OBJECTS)
 	ComPtr<ID3D11Debug>  debug;
 	ThrowIfFailed(d3dDevice.As(&debug));
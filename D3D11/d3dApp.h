@@ -1,6 +1,14 @@
 #pragma once
 #include "D3DUtil.h"
+#include "D3D11RenderDevice.h"
+#include "StateCache.h"
 #include "GameTimer.h"
+#include "Profiler.h"
+#include "InputQueue.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
 
 class d3dApp
 {
@@ -11,10 +19,27 @@ protected:
 	HWND appWindow{ 0 };
 	const wchar_t* windowName{ L"D3D11" };
 	//App states
+	//appPaused belongs to the render thread, the others to the window thread
 	bool appPaused{ false };
 	bool appMinimized{ false };
 	bool appMaximized{ false };
 	bool appResizing{ false };
+	bool appClosing{ false };
+
+	//Threads
+	//The thread that created the window only pumps messages and turns them into events;
+	//updates, draws and every device call run on renderThread once run is called.
+	//renderError holds what the render thread threw, rethrown by run
+	std::thread renderThread;
+	std::atomic<bool> renderQuit{ false };
+	std::exception_ptr renderError;
+
+	//Input
+	//Window thread -> render thread, drained at the start of every frame into inputState
+	SpscQueue<InputEvent> inputQueue{ 1024 };
+	InputState inputState;
+	//Time from the window thread receiving the oldest input of a frame to Present returning, ms
+	FrameTimeRing inputLatencies{ 256 };
 
 	//--------------Device Vars----------------------//
 	UINT createDeviceFlags{ 0 };
@@ -31,18 +56,30 @@ protected:
 
 	//Swap Chain
 	ComPtr<IDXGISwapChain> swapChain;
-	ComPtr<ID3D11RenderTargetView> renderTargetView;
-
-	//Depth stencil buffer
-	ComPtr<ID3D11Texture2D> depthStencilBuffer;
-	ComPtr<ID3D11DepthStencilView> depthStencilView;
 
-	//Viewport
-	D3D11_VIEWPORT mainViewPort{ 0 };
+	//Rendering goes through the device interface; the D3D11 backend owns the
+	//back buffer, depth/stencil buffer and viewport. d3d11RenderDevice is the same
+	//object, for the few D3D11 only paths (WIC / DDS texture loading).
+	//renderContext is the state cache in front of the immediate context
+	std::unique_ptr<IRenderDevice> renderDevice;
+	std::unique_ptr<StateCache> stateCache;
+	IRenderContext* renderContext{ nullptr };
+	D3D11RenderDevice* d3d11RenderDevice{ nullptr };
 
 	//Timer vars
 	GameTimer gameTimer;
 
+	//Fixed timestep mode: updateScene runs zero or more times per frame with a constant step.
+	//updateFrame runs exactly once per frame in both modes
+	bool fixedTimestepMode{ false };
+	FixedTimestep fixedTimestep{ 60 };
+
+	//Frame stats shown in the title bar, refreshed once a second
+	//F9 toggles CPU scope capture, F10 writes the capture to profile.json
+	int64_t lastStatsUpdate{ 0 };
+	uint64_t lastStatsFrameCount{ 0 };
+	StateCacheStats lastFrameStateStats;
+
 	//Camera variables
 	XMFLOAT3 camLookAt;
 	XMFLOAT4 camPos;
@@ -50,7 +87,7 @@ protected:
 	float pitch{ 0 };
 	float lastX{ 0 };
 	float lastY{ 0 };
-	float camSpeed{ 10.0f };
+	float camSpeed{ 2.0f };	//units per second
 	float camSens{ 0.1f };
 
 public:
@@ -62,6 +99,9 @@ public:
 	
 	virtual bool init();
 	virtual void onResize();
+	//Per frame work that must not be skipped or repeated by the fixed timestep (asset
+	//callbacks, view matrix). Runs after input and camera movement, before updateScene
+	virtual void updateFrame(float /*deltaTime*/) {}
 	virtual void updateScene(float deltaTime) = 0;
 	virtual void drawScene() = 0;
 	virtual LRESULT msgHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -74,9 +114,14 @@ public:
 	XMFLOAT3 getCameraTarget();
 
 protected:
-	void calculateFrameStats();
+	void updateFrameStats();
 	bool initWindowApp();
 	bool initD3D();
 	float aspectRatio();
-	void moveCamera(WPARAM wParam);
+	void moveCamera(float deltaTime);
+
+	void renderLoop();
+	void stopRenderThread();
+	void postEvent(const InputEvent& event);
+	void handleEvent(const InputEvent& event);
 };
\ No newline at end of file
@@ -64,22 +64,6 @@ private:
 
 namespace
 {
-	//----------------------------------------------------------------------------
-	ComPtr<ID3D10Blob> loadCompiledShaderCodeFromFile(const std::string& fileName)
-	{
-		std::ifstream file{ fileName, std::ios::in | std::ios::binary };
-		file.seekg(0, std::ios::end);
-		int sizeInBytes{ static_cast<int>(file.tellg()) };
-		file.seekg(0, std::ios::beg);
-
-		ComPtr<ID3D10Blob> compiledCode;
-		ThrowIfFailed(D3DCreateBlob(sizeInBytes, compiledCode.GetAddressOf()));
-		file.read(reinterpret_cast<char*>(compiledCode->GetBufferPointer()), sizeInBytes);
-		file.close();
-
-		return compiledCode;
-	}
-
 	//-------------------------------------//
 	//--------Texture loading--------------//
 	//-------------------------------------//
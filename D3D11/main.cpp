@@ -1,43 +1,95 @@
 #include "D3DApp.h"
 #include "Lighting.h"
 #include "MathHelper.h"
-
-struct cbufferPerFrame
-{
-	cbufferPerFrame() { ZeroMemory(this, sizeof(this)); }
-
-	DirectLight dirLight;
-	PointLight pointLight;
-	SpotLight spotLight;
-	XMFLOAT4 viewPos;
-} cbufferperframe;
-
-struct cbufferPerObject
-{
-	cbufferPerObject() { ZeroMemory(this, sizeof(this)); }
-
-	XMMATRIX worldViewProj;
-	XMMATRIX worldInvTranspose;
-	XMMATRIX world;
-	XMMATRIX texTransformMatrix;
-	Material material;
-	int useTexture;
-	int clipAlpha;
-} cbufferperobject;
+#include "Instancing.h"
+#include "TransparentQueue.h"
+#include "OpaqueQueue.h"
+#include "BVH.h"
+#include "AssetLoader.h"
+#include "ShaderArchive.h"
+#include "ShaderCompileCache.h"
+#include "D3DShaderCompiler.h"
+#include "ShaderConstants.h"
+#include "ConstantRing.h"
+#include "ParallelRecorder.h"
+#include "GeometryPool.h"
+#include "MeshAsset.h"
+#include "LodSelector.h"
+#include "ClusteredLighting.h"
+#include <chrono>
+
+cbufferPerFrame cbufferperframe;
+cbufferPerObject cbufferperobject;
 
 class InitD3DApp : public d3dApp
 {
 private:
 
-	ComPtr<ID3D11InputLayout> inputLayout;
-	ComPtr<ID3D11RasterizerState> rastState;
-	ComPtr<ID3D11BlendState> blendState;
-
-	ComPtr<ID3D11Buffer> constantBufferPerObject;
-	ComPtr<ID3D11Buffer> constantBufferPerFrame;
-
-	ComPtr<ID3D11VertexShader> vertexShader;
-	ComPtr<ID3D11PixelShader> pixelShader;
+	InputLayoutHandle inputLayout;
+	RasterizerStateHandle rastState;
+	BlendStateHandle blendState;
+
+	//Vertices and indices of every model live in shared buffers, one vertex buffer per stride
+	std::unique_ptr<GeometryPool> geometryPool;
+
+	//Per frame and per object constants are sub-allocated from one ring, bound by offset
+	std::unique_ptr<ConstantUploadRing> constantRing;
+
+	VertexShaderHandle vertexShader;
+	PixelShaderHandle pixelShader;
+
+	//Offline compiled shaders, mapped while the shaders are created
+	ShaderArchive shaderArchive;
+
+	//Runtime compilation goes through a cache keyed on the source and compile options
+	//Used for every shader when ONLINE is defined, otherwise for entries missing from Shaders/box.shar
+	D3DShaderCompiler shaderCompiler;
+	ShaderCompileCache shaderCache{ shaderCompiler, "ShaderCache" };
+
+	//Instanced draw mode
+	//Uses box_instanced_vs / box_instanced_ps from Shaders/box.shar (see BuildShaders.bat), compiled at runtime when missing
+	bool instancedDraw{ false };
+	VertexShaderHandle instancedVertexShader;
+	PixelShaderHandle instancedPixelShader;
+	InputLayoutHandle instancedInputLayout;
+	BufferHandle instanceBuffer;
+	uint32_t instanceBufferCapacity{ 0 };
+	InstancePacker cubeInstances;
+	std::vector<uint32_t> cubesByLod;		//visible cubes grouped by level of detail
+	std::vector<uint32_t> cubeLodCounts;	//instances of each level in cubesByLod
+
+	//Per object cube draws recorded on worker threads through deferred contexts
+	//Constants are still written on this thread, chunks only bind their offsets
+	bool parallelRecording{ false };
+	std::unique_ptr<ParallelRecorder> parallelRecorder;
+
+	//Cube and quad vertices packed into 16 bytes (VertexNormTexPacked) instead of 32
+	//Uses box_packed_vs from Shaders/box.shar, compiled at runtime when missing. The instanced path keeps float vertices
+	bool packedVertices{ false };
+	bool usePackedVertices() const { return packedVertices && !instancedDraw; }
+
+	//Point and spot lights binned into view frustum clusters on the CPU, shaded per pixel from the pixel's cluster
+	//Uses box_clustered_ps from Shaders/box.shar, compiled at runtime when missing. The instanced path keeps the directional light only
+	bool clusteredLighting{ false };
+	bool useClusteredLighting() const { return clusteredLighting && !instancedDraw; }
+	LightClusterGrid lightClusters;
+	std::vector<PointLight> scenePointLights;
+	std::vector<SpotLight> sceneSpotLights;
+	BufferHandle pointLightBuffer;
+	BufferHandle spotLightBuffer;
+	BufferHandle clusterBuffer;
+	BufferHandle lightIndexBuffer;
+	uint32_t clusterBufferCapacity{ 0 };
+	uint32_t lightIndexBufferCapacity{ 0 };
+
+	//Fire flipbook on the cubes instead of the wire fence texture
+	bool animateCube{ false };
+	Flipbook fireFlipbook;
+	std::vector<ImagePtr> fireFrames;
+	size_t fireFramesLoaded{ 0 };
+
+	//Decodes on worker threads, texture creation runs in updateFrame
+	AssetLoader assetLoader{ workerThreadCount() };
 
 	XMFLOAT4X4 fViewMatrix;
 	XMFLOAT4X4 fProjMatrix;
@@ -46,9 +98,21 @@ private:
 	Model cubeModel{ sizeof(VertexNormTex), 36 };
 	std::vector<XMFLOAT3> cubeTranslateVectors;
 
+	//Level of detail of every cube, picked from its size on screen
+	LodSelector cubeLodSelector;
+
 	Model quadModel{ sizeof(VertexNormTex), 6 };
 	std::vector<XMFLOAT3> quadTranslateVectors;	
-	std::map<float, XMFLOAT3, std::less<float>> quadDistancesFromCamera;
+	TransparentQueue transparentQueue;
+	OpaqueQueue opaqueQueue;
+
+	//Frustum culling
+	//Static cubes go through a BVH, quads use the flat SIMD sphere test
+	BVH cubeBVH;
+	SphereBoundsSoA quadSpheres;
+	std::vector<uint32_t> visibleCubes;
+	std::vector<uint32_t> visibleQuads;	//sized to every quad, the first visibleQuadCount entries are valid
+	size_t visibleQuadCount{ 0 };
 
 public:
 
@@ -59,16 +123,28 @@ public:
 protected:
 
 	virtual void onResize() override;
+	virtual void updateFrame(float deltaTime) override;
 	virtual void updateScene(float deltaTime) override;
 	virtual void drawScene() override;
-	void drawObjectIndexed(const Model * desc);
+	void bindOpaquePipeline(IRenderContext& context, const ConstantAllocation& frameConstants);
+	void writeObjectConstants(const Model* model, void* destination);
+	void drawObjectIndexed(IRenderContext& context, const Model* model, const ConstantAllocation& constants, uint32_t element, uint32_t lod);
+	void drawObjectInstanced(const Model* model, const InstancePacker& instances, const std::vector<uint32_t>& lodCounts);
+	float selectCubeLod(uint32_t cube, FXMMATRIX view);
+	void uploadLightClusters();
 	
 	void buildGeometryData();
+	void loadMesh(Model& model, const std::string& fileName);
 	void buildShaderData();
+	void buildInstancedShaderData(unsigned int compileFlags);
+	void compileShader(const std::string& entryPoint, const std::string& profile, unsigned int compileFlags, std::vector<uint8_t>& compiledCode);
+	ShaderBytecode loadShader(const char* archiveName, const std::string& entryPoint, const std::string& profile, unsigned int compileFlags, std::vector<uint8_t>& compiledCode);
 	void setupLightingData();
 	void setupModelTextureData();
+	void onFireFramesLoaded();
 	void setupSamplerState();
 	void createRasterizerBlendStates();
+	void setupCullingData();
 };
 
 //------------------------------------------------------------------------------------------
@@ -114,6 +190,8 @@ InitD3DApp::InitD3DApp(HINSTANCE appInstance) : d3dApp(appInstance)
 	quadTranslateVectors.push_back({ 0.27f, 0.47f, 0.3f });
 	quadTranslateVectors.push_back({ 0.0f,  0.0f, -2.4f });
 	quadTranslateVectors.push_back({ 0.0f,  0.83f, 0.0f });
+	transparentQueue.reserve(quadTranslateVectors.size());
+	opaqueQueue.reserve(cubeTranslateVectors.size());
 }
 
 //--------------------------
@@ -124,12 +202,20 @@ bool InitD3DApp::init()
 {
 	if (!d3dApp::init()) { return false; }
 
+	//The constant ring binds by offset and maps with NO_OVERWRITE, which need D3D 11.1 (WDDM 1.2 drivers)
+	if (!d3d11RenderDevice->supportsConstantBufferOffsets())
+	{
+		MessageBox(0, L"Constant buffer offsets (Direct3D 11.1) not supported by this driver", 0, 0);
+		return false;
+	}
+
 	buildGeometryData();
 	buildShaderData();
 	setupLightingData();
 	setupModelTextureData();
 	setupSamplerState();
 	createRasterizerBlendStates();
+	setupCullingData();
 	
 	return true;
 }
@@ -137,75 +223,79 @@ bool InitD3DApp::init()
 //----------------------------------
 void InitD3DApp::buildGeometryData()
 {
-	//-----------------------------------------------------//
-	//-----------------------CUBE--------------------------//
-	//-----------------------------------------------------//
-	calculateNormals(cubeVertices, 24, cubeIndices, 12);
-	
-	//Define buffer desc
-	D3D11_BUFFER_DESC vbDesc;
-	vbDesc.ByteWidth = 24 * sizeof(VertexNormTex);
-	vbDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbDesc.CPUAccessFlags = 0;
-	vbDesc.MiscFlags = 0;
-	vbDesc.StructureByteStride = 0;
-
-	//Define sub resource data
-	D3D11_SUBRESOURCE_DATA vbData;
-	vbData.pSysMem = cubeVertices;
-
-	//Create vertex buffer
-	ThrowIfFailed(d3dDevice->CreateBuffer(&vbDesc, &vbData, cubeModel.vertexBuffer.GetAddressOf()));
-
-	//Create Index buffer
-	D3D11_BUFFER_DESC idxDesc;
-	idxDesc.ByteWidth = sizeof(unsigned int) * 36;
-	idxDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	idxDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	idxDesc.CPUAccessFlags = 0;
-	idxDesc.MiscFlags = 0;
-	idxDesc.StructureByteStride = 0;
-
-	D3D11_SUBRESOURCE_DATA idxData;
-	idxData.pSysMem = cubeIndices;
-
-	ThrowIfFailed(d3dDevice->CreateBuffer(&idxDesc, &idxData, cubeModel.indexBuffer.GetAddressOf()));
+	geometryPool = std::make_unique<GeometryPool>(*renderDevice, 1024 * 1024, 256 * 1024);
+
+	//Cooked by Tools/CookMesh.cpp (see Meshes/CookMeshCmd.txt), same stride so the cube and quad share one vertex buffer binding
+	loadMesh(cubeModel, "Meshes/cube.mesh");
+	loadMesh(quadModel, "Meshes/quad.mesh");
 
 	//Setup World Matrix
 	XMMATRIX translate = XMMatrixTranslation(0.0f, -1.0f, 0.0f);
 	XMMATRIX rotation = XMMatrixRotationAxis(XMVECTORF32{ 0.0f, 1.0f, 0.0f }, XMConvertToRadians(45.0f));
 	XMStoreFloat4x4(&cubeModel.worldMatrix, rotation * translate);
 
-	//-----------------------------------------------------//
-	//-----------------------QUAD--------------------------//
-	//-----------------------------------------------------//
-	calculateNormals(quadVertices, 4, quadIndices, 2);
-
-	vbDesc.ByteWidth = sizeof(VertexNormTex) * 4;
-	vbData.pSysMem = quadVertices;
-	ThrowIfFailed(d3dDevice->CreateBuffer(&vbDesc, &vbData, quadModel.vertexBuffer.GetAddressOf()));
-	
-	idxDesc.ByteWidth = sizeof(unsigned int) * 6;
-	idxData.pSysMem = quadIndices;
-	ThrowIfFailed(d3dDevice->CreateBuffer(&idxDesc, &idxData, quadModel.indexBuffer.GetAddressOf()));
+	cubeLodSelector.resize(cubeTranslateVectors.size());
 		
 	//----------------
 	//CONSTANT BUFFERS
 	//----------------
-	D3D11_BUFFER_DESC constDesc;
-	ZeroMemory(&constDesc, sizeof(D3D11_BUFFER_DESC));
-	constDesc.ByteWidth = sizeof(cbufferPerObject);
-	constDesc.Usage = D3D11_USAGE_DEFAULT;
-	constDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	//constDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-	ThrowIfFailed(d3dDevice->CreateBuffer(&constDesc, nullptr, constantBufferPerObject.GetAddressOf()));
-
-	constDesc.Usage = D3D11_USAGE_DYNAMIC;
-	constDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	constDesc.ByteWidth = sizeof(cbufferPerFrame);
-	ThrowIfFailed(d3dDevice->CreateBuffer(&constDesc, nullptr, constantBufferPerFrame.GetAddressOf()));	
+	//A frame of the sample scene takes 4.5 KB so 64 KB covers 14 frames in flight; the ring grows if a frame ever needs more
+	constantRing = std::make_unique<ConstantUploadRing>(*renderDevice, 64 * 1024);
+
+	if (parallelRecording)
+	{
+		parallelRecorder = std::make_unique<ParallelRecorder>(*renderDevice);
+	}
+}
+
+//Maps a cooked mesh and copies its vertices and levels of detail into the geometry pool
+//The blobs go from the mapping to the buffers as they are, unless float vertices have to be packed
+//------------------------------------------------------------------------------------------------
+void InitD3DApp::loadMesh(Model& model, const std::string& fileName)
+{
+	MeshAsset asset;
+	ThrowIfFailed(asset.open(fileName) && asset.submeshCount() > 0 ? S_OK : E_FAIL);
+	model.bounds = asset.bounds();
+
+	const std::vector<MeshLod> lods = asset.submeshLods(0);
+	wchar_t line[256];
+	swprintf(line, 256, L"Mesh : %u vertices  %u levels  triangles %u -> %u  error %g\n", asset.vertexCount(),
+		static_cast<uint32_t>(lods.size()), lods.front().indexCount / 3, lods.back().indexCount / 3, lods.back().error);
+	OutputDebugString(line);
+
+	if (asset.hasLayout(vertexNormTexPackedLayout, 3, sizeof(VertexNormTexPacked)))
+	{
+		//Cooked with -packed, the instanced path has no input layout for it
+		ThrowIfFailed(usePackedVertices() ? S_OK : E_FAIL);
+		XMStoreFloat4x4(&model.positionDecode, asset.positionDecode().matrix());
+		model.setGeometry(geometryPool->allocate(*renderContext, asset.vertexData(), asset.vertexCount(), sizeof(VertexNormTexPacked),
+			asset.indexData(), asset.indexFormat(), asset.indexCount()), lods);
+		return;
+	}
+
+	ThrowIfFailed(asset.hasLayout(vertexNormTexLayout, 3, sizeof(VertexNormTex)) ? S_OK : E_FAIL);
+	if (usePackedVertices())
+	{
+		//Positions are packed relative to the bounds, the vertex shader gets them back through the world matrix
+		const VertexNormTex* vertices = static_cast<const VertexNormTex*>(asset.vertexData());
+		PositionDecode decode = computePositionDecode(vertices, asset.vertexCount());
+		std::vector<VertexNormTexPacked> packed(asset.vertexCount());
+		quantizeVertices(packed.data(), vertices, asset.vertexCount(), decode);
+		XMStoreFloat4x4(&model.positionDecode, decode.matrix());
+
+		QuantizationError error = measureQuantizationError(packed.data(), vertices, asset.vertexCount(), decode);
+		swprintf(line, 256, L"Packed : %u -> %u bytes  max error position %g  normal %g degrees  uv %g\n",
+			static_cast<uint32_t>(asset.vertexCount() * sizeof(VertexNormTex)), static_cast<uint32_t>(packed.size() * sizeof(VertexNormTexPacked)),
+			error.position, error.normalDegrees, error.texCoords);
+		OutputDebugString(line);
+
+		model.setGeometry(geometryPool->allocate(*renderContext, packed.data(), asset.vertexCount(), sizeof(VertexNormTexPacked),
+			asset.indexData(), asset.indexFormat(), asset.indexCount()), lods);
+		return;
+	}
+
+	model.setGeometry(geometryPool->allocate(*renderContext, asset.vertexData(), asset.vertexCount(), sizeof(VertexNormTex),
+		asset.indexData(), asset.indexFormat(), asset.indexCount()), lods);
 }
 
 //--------------------------------
@@ -216,63 +306,146 @@ void InitD3DApp::buildShaderData()
 	compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
-	ComPtr<ID3D10Blob> compiledCode;
-	ComPtr<ID3D10Blob> errorMsgs;
+	std::vector<uint8_t> compiledCode;
+	ShaderBytecode bytecode;
+
+#if !defined(ONLINE)
+	//A missing archive is not fatal, every shader then goes through the compile cache
+	if (!shaderArchive.open("Shaders/box.shar"))
+	{
+		OutputDebugStringA("Shaders/box.shar not found, compiling shaders at runtime\n");
+	}
+#endif
 
 	//------------------------------------------------------------//
 	//-----------------------VERTEX SHADER------------------------//
 	//------------------------------------------------------------//
-#if defined(ONLINE) //Runtime shader compilation
-	HRESULT result = S_OK;
-	result = D3DCompileFromFile(L"Shaders/Box.hlsl", nullptr, nullptr, "vertexShader", "vs_5_0",
-		compileFlags, 0, compiledCode.GetAddressOf(), errorMsgs.GetAddressOf());
-	if (errorMsgs != nullptr)
-	{
-		OutputDebugStringA(reinterpret_cast<char*>(errorMsgs->GetBufferPointer()));
-		errorMsgs.Reset();
-	}
-	ThrowIfFailed(result);
-#else  //Offline shader compilation
-	compiledCode = loadCompiledShaderCodeFromFile("Shaders/box_vs.cso");
-#endif
-	ThrowIfFailed(d3dDevice->CreateVertexShader(compiledCode->GetBufferPointer(), compiledCode->GetBufferSize(),
-		nullptr, vertexShader.GetAddressOf()));
+	bytecode = usePackedVertices() ? loadShader("box_packed_vs", "packedVertexShader", "vs_5_0", compileFlags, compiledCode)
+		: loadShader("box_vs", "vertexShader", "vs_5_0", compileFlags, compiledCode);
+	vertexShader = renderDevice->createVertexShader(bytecode.data, bytecode.size);
 
 	//Define the input element desc structure
-	D3D11_INPUT_ELEMENT_DESC inpDesc[]
+	InputElement inpDesc[]
+	{
+		{"POSITION", 0, VertexFormat::Float3, 0, 0, false},
+		{"NORMAL", 0, VertexFormat::Float3, 0, 12, false},
+		{"TEXCOORD", 0, VertexFormat::Float2, 0, 24, false}
+	};
+	//VertexNormTexPacked
+	InputElement packedDesc[]
 	{
-		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0}
+		{"POSITION", 0, VertexFormat::UShort4Norm, 0, 0, false},
+		{"NORMAL", 0, VertexFormat::Short2Norm, 0, 8, false},
+		{"TEXCOORD", 0, VertexFormat::Half2, 0, 12, false}
 	};
-	ThrowIfFailed(d3dDevice->CreateInputLayout(inpDesc, 3, compiledCode->GetBufferPointer(),
-		compiledCode->GetBufferSize(), inputLayout.GetAddressOf()));
-	compiledCode.Reset();
+	inputLayout = renderDevice->createInputLayout(usePackedVertices() ? packedDesc : inpDesc, 3, bytecode.data, bytecode.size);
+	compiledCode.clear();
 
 	//------------------------------------------------------------//
 	//-----------------------PIXEL SHADER-------------------------//
 	//------------------------------------------------------------//
-#if defined(ONLINE)
-	result = D3DCompileFromFile(L"Shaders/Box.hlsl", nullptr, nullptr, "pixelShader", "ps_5_0",
-		compileFlags, 0, compiledCode.GetAddressOf(), errorMsgs.GetAddressOf());
+	bytecode = useClusteredLighting() ? loadShader("box_clustered_ps", "clusteredPixelShader", "ps_5_0", compileFlags, compiledCode)
+		: loadShader("box_ps", "pixelShader", "ps_5_0", compileFlags, compiledCode);
+	pixelShader = renderDevice->createPixelShader(bytecode.data, bytecode.size);
+	ID3D11ShaderReflection* reflectionInterface;
+	D3DReflect(bytecode.data, bytecode.size, IID_ID3D11ShaderReflection, (void**)&reflectionInterface);
+
+	//Used to check which register given resource is bound to in shader file
+	D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+	reflectionInterface->GetResourceBindingDescByName("diffuseMap", &bindDesc);
 
-	if (errorMsgs != nullptr)
+	if (instancedDraw)
 	{
-		OutputDebugStringA(reinterpret_cast<char*>(errorMsgs->GetBufferPointer()));
-		errorMsgs.Reset();
+		buildInstancedShaderData(compileFlags);
 	}
-	ThrowIfFailed(result);
+
+	//The device keeps its own copy of the bytecode
+	shaderArchive.close();
+}
+
+//Compiles an entry point of Box.hlsl through the shader cache and logs whether it hit
+//---------------------------------------------------------------------------------------------------------------------------------------
+void InitD3DApp::compileShader(const std::string& entryPoint, const std::string& profile, unsigned int compileFlags, std::vector<uint8_t>& compiledCode)
+{
+	ShaderCompileDesc desc;
+	desc.sourceFile = "Shaders/Box.hlsl";
+	desc.entryPoint = entryPoint;
+	desc.profile = profile;
+	desc.flags = compileFlags;
+
+	size_t hitsBefore = shaderCache.hitCount();
+	auto start = std::chrono::steady_clock::now();
+	std::string errors;
+	bool compiled = shaderCache.compile(desc, compiledCode, errors);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	if (!errors.empty())
+	{
+		OutputDebugStringA(errors.c_str());
+	}
+	char message[256];
+	snprintf(message, sizeof(message), "%s %s : %s %.2f ms\n", entryPoint.c_str(), profile.c_str(),
+		shaderCache.hitCount() > hitsBefore ? "cache hit" : "compiled", elapsed.count());
+	OutputDebugStringA(message);
+	ThrowIfFailed(compiled ? S_OK : E_FAIL);
+}
+
+//Looks the shader up in the archive and compiles the entry point when it is missing or ONLINE is defined
+//The returned bytecode points into the archive or compiledCode, so it is valid until either changes
+//---------------------------------------------------------------------------------------------------------------------------------------
+ShaderBytecode InitD3DApp::loadShader(const char* archiveName, const std::string& entryPoint, const std::string& profile, unsigned int compileFlags, std::vector<uint8_t>& compiledCode)
+{
+	ShaderBytecode bytecode;
+#if !defined(ONLINE)
+	if (shaderArchive.find(archiveName, bytecode))
+	{
+		return bytecode;
+	}
+	char message[256];
+	snprintf(message, sizeof(message), "%s missing from Shaders/box.shar, rebuild it with Shaders/BuildShaders.bat\n", archiveName);
+	OutputDebugStringA(message);
 #else
-	compiledCode = loadCompiledShaderCodeFromFile("Shaders/box_ps.cso");
+	(void)archiveName;
 #endif
-	ThrowIfFailed(d3dDevice->CreatePixelShader(compiledCode->GetBufferPointer(), compiledCode->GetBufferSize(),
-		nullptr, pixelShader.GetAddressOf()));
-	ID3D11ShaderReflection* reflectionInterface;
-	D3DReflect(compiledCode->GetBufferPointer(), compiledCode->GetBufferSize(), IID_ID3D11ShaderReflection, (void**)&reflectionInterface);
+	compileShader(entryPoint, profile, compileFlags, compiledCode);
+	return { compiledCode.data(), compiledCode.size() };
+}
 
-	//Used to check which register given resource is bound to in shader file
-	D3D11_SHADER_INPUT_BIND_DESC bindDesc;
-	reflectionInterface->GetResourceBindingDescByName("diffuseMap", &bindDesc);
+//---------------------------------------------------------------
+void InitD3DApp::buildInstancedShaderData(unsigned int compileFlags)
+{
+	std::vector<uint8_t> compiledCode;
+	ShaderBytecode bytecode;
+
+	//------------------------------------------------------------//
+	//------------------INSTANCED VERTEX SHADER-------------------//
+	//------------------------------------------------------------//
+	bytecode = loadShader("box_instanced_vs", "instancedVertexShader", "vs_5_0", compileFlags, compiledCode);
+	instancedVertexShader = renderDevice->createVertexShader(bytecode.data, bytecode.size);
+
+	//Slot 0 holds per vertex data, slot 1 holds InstanceData
+	InputElement inpDesc[]
+	{
+		{"POSITION", 0, VertexFormat::Float3, 0, 0, false},
+		{"NORMAL", 0, VertexFormat::Float3, 0, 12, false},
+		{"TEXCOORD", 0, VertexFormat::Float2, 0, 24, false},
+		{"WORLD", 0, VertexFormat::Float4, 1, 0, true},
+		{"WORLD", 1, VertexFormat::Float4, 1, 16, true},
+		{"WORLD", 2, VertexFormat::Float4, 1, 32, true},
+		{"WORLD", 3, VertexFormat::Float4, 1, 48, true},
+		{"MATAMBIENT", 0, VertexFormat::Float4, 1, 64, true},
+		{"MATDIFFUSE", 0, VertexFormat::Float4, 1, 80, true},
+		{"MATSPECULAR", 0, VertexFormat::Float4, 1, 96, true},
+		{"INSTANCEFLAGS", 0, VertexFormat::UInt1, 1, 112, true}
+	};
+	instancedInputLayout = renderDevice->createInputLayout(inpDesc, 11, bytecode.data, bytecode.size);
+	compiledCode.clear();
+
+	//------------------------------------------------------------//
+	//------------------INSTANCED PIXEL SHADER--------------------//
+	//------------------------------------------------------------//
+	bytecode = loadShader("box_instanced_ps", "instancedPixelShader", "ps_5_0", compileFlags, compiledCode);
+	instancedPixelShader = renderDevice->createPixelShader(bytecode.data, bytecode.size);
 }
 
 //----------------------------------
@@ -309,6 +482,47 @@ void InitD3DApp::setupLightingData()
 	cbufferperframe.spotLight.range = 10.0f;
 	cbufferperframe.spotLight.att = { 0.0f, 1.0f, 0.0f };
 	cbufferperframe.spotLight.spotPower = 8.0f;
+
+	if (!useClusteredLighting())
+	{
+		return;
+	}
+
+	//Clustered lights: a ring of small colored point lights around the scene and a few spot lights pointing down at it
+	const uint32_t pointCount{ 64 };
+	for (uint32_t i{ 0 }; i < pointCount; i++)
+	{
+		float angle = XM_2PI * i / pointCount;
+		float hue = static_cast<float>(i % 3);
+		PointLight light;
+		light.diffuseColor = { hue == 0.0f ? 0.8f : 0.1f, hue == 1.0f ? 0.8f : 0.1f, hue == 2.0f ? 0.8f : 0.1f, 1.0f };
+		light.specColor = light.diffuseColor;
+		light.lightPos = { 2.0f * cosf(angle), -1.0f + 2.0f * (i % 8) / 7.0f, 2.0f * sinf(angle) - 1.0f };
+		light.range = 1.5f;
+		light.att = { 1.0f, 0.0f, 1.0f };
+		scenePointLights.push_back(light);
+	}
+
+	const uint32_t spotCount{ 8 };
+	for (uint32_t i{ 0 }; i < spotCount; i++)
+	{
+		float angle = XM_2PI * i / spotCount;
+		SpotLight light;
+		light.diffuseColor = { 0.8f, 0.8f, 0.6f, 1.0f };
+		light.specColor = light.diffuseColor;
+		light.lightPos = { 1.5f * cosf(angle), 2.0f, 1.5f * sinf(angle) - 1.0f };
+		light.range = 5.0f;
+		light.att = { 1.0f, 0.0f, 0.0f };
+		XMStoreFloat3(&light.lightDir, XMVector3Normalize(XMVectorSet(-cosf(angle), -2.0f, -sinf(angle), 0.0f)));
+		light.spotPower = 16.0f;
+		sceneSpotLights.push_back(light);
+	}
+
+	//The lights don't move, only their clusters change with the camera
+	BufferDesc pointDesc{ static_cast<uint32_t>(pointCount * sizeof(PointLight)), BufferBinding::ShaderResource, ResourceUsage::Immutable, sizeof(PointLight) };
+	pointLightBuffer = renderDevice->createBuffer(pointDesc, scenePointLights.data());
+	BufferDesc spotDesc{ static_cast<uint32_t>(spotCount * sizeof(SpotLight)), BufferBinding::ShaderResource, ResourceUsage::Immutable, sizeof(SpotLight) };
+	spotLightBuffer = renderDevice->createBuffer(spotDesc, sceneSpotLights.data());
 }
 
 //--------------------------------------
@@ -317,80 +531,110 @@ void InitD3DApp::setupModelTextureData()
 	//-----------------------------------------------------//
 	//-----------------------CUBE--------------------------//
 	//-----------------------------------------------------//
-	/*for (size_t i = 0; i < 120; i++)
+	if (animateCube)
 	{
-		std::wstring fileNumber;
-		if (i < 9)
-		{
-			fileNumber = L"00" + std::to_wstring(i + 1);
-		}
-		else if (i < 99)
-		{
-			fileNumber = L"0" + std::to_wstring(i + 1);
-		}
-		else
+		//White placeholder stays bound until every fire frame has been decoded
+		CpuImage placeholder;
+		placeholder.width = 1;
+		placeholder.height = 1;
+		placeholder.pixels = { 255, 255, 255, 255 };
+		cubeModel.texture = createTextureFromImage(*renderDevice, placeholder);
+
+		//Decode the 120 fire frames on the loader's workers
+		std::vector<std::string> fileNames = flipbookFrameFileNames("Images/FireAnim/Fire", 120, ".bmp");
+		fireFrames.resize(fileNames.size());
+		fireFramesLoaded = 0;
+		for (size_t i = 0; i < fileNames.size(); i++)
 		{
-			fileNumber = std::to_wstring(i + 1);			
+			assetLoader.loadImage(fileNames[i], [this, i](const ImagePtr& image)
+			{
+				ThrowIfFailed(image ? S_OK : E_FAIL);
+				fireFrames[i] = image;
+				if (++fireFramesLoaded == fireFrames.size())
+				{
+					onFireFramesLoaded();
+				}
+			});
 		}
+	}
+	else
+	{
+		ComPtr<ID3D11ShaderResourceView> texView;
+		createShaderResourceViewFromImageFile(L"Images/WireFence.dds", d3dDevice, d3dImmediateContext, texType::DDS, &texView);
+		cubeModel.texture = d3d11RenderDevice->addShaderResourceView(texView);
 
-		createShaderResourceViewFromImageFile(L"Images/FireAnim/Fire" + fileNumber + L".bmp", d3dDevice, immediateContext, texType::WIC, &cubeModel.texViews[i]);
-	}*/
-	createShaderResourceViewFromImageFile(L"Images/WireFence.dds", d3dDevice, d3dImmediateContext, texType::DDS, &cubeModel.texViews[0]);
-	
-	XMMATRIX mtexTransformMatrix = XMLoadFloat4x4(&cubeModel.texTransformMatrix);
-	mtexTransformMatrix *= XMMatrixScaling(1.0f, 1.0f, 0.0f);
-	XMStoreFloat4x4(&cubeModel.texTransformMatrix, mtexTransformMatrix);
+		XMMATRIX mtexTransformMatrix = XMLoadFloat4x4(&cubeModel.texTransformMatrix);
+		mtexTransformMatrix *= XMMatrixScaling(1.0f, 1.0f, 0.0f);
+		XMStoreFloat4x4(&cubeModel.texTransformMatrix, mtexTransformMatrix);
+	}
 
 	//-----------------------------------------------------//
 	//-----------------------QUAD--------------------------//
 	//-----------------------------------------------------//
-	createShaderResourceViewFromImageFile(L"Images/transWindow.png", d3dDevice, d3dImmediateContext, texType::WIC, &quadModel.texViews[0]);	
+	ComPtr<ID3D11ShaderResourceView> texView;
+	createShaderResourceViewFromImageFile(L"Images/transWindow.png", d3dDevice, d3dImmediateContext, texType::WIC, &texView);
+	quadModel.texture = d3d11RenderDevice->addShaderResourceView(texView);
+}
+
+//Packs the decoded fire frames into one atlas and swaps it in for the placeholder
+//-----------------------------------
+void InitD3DApp::onFireFramesLoaded()
+{
+	std::vector<const CpuImage*> frames;
+	frames.reserve(fireFrames.size());
+	for (const ImagePtr& frame : fireFrames)
+	{
+		frames.push_back(frame.get());
+	}
+	ThrowIfFailed(fireFlipbook.pack(frames.data(), frames.size()) ? S_OK : E_FAIL);
+	fireFrames.clear();
+
+	renderDevice->destroyTexture(cubeModel.texture);
+	cubeModel.texture = createTextureFromImage(*renderDevice, fireFlipbook.atlas());
+	cubeModel.flipbook = &fireFlipbook;
+	cubeModel.texTransformMatrix = fireFlipbook.frameTransform(0);
 }
 
 //----------------------------------
 void InitD3DApp::setupSamplerState()
 {
-	D3D11_SAMPLER_DESC desc;
-	ZeroMemory(&desc, sizeof(desc));
-	desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	desc.Filter = D3D11_FILTER_ANISOTROPIC;  
-	desc.MaxAnisotropy = 16;
-	
-	/*desc.BorderColor[0] = 1.0f;
-	desc.BorderColor[1] = 0.0f;
-	desc.BorderColor[2] = 0.0f;	
-	desc.BorderColor[3] = 1.0f;*/
-
-	ThrowIfFailed(d3dDevice->CreateSamplerState(&desc, cubeModel.sampler.GetAddressOf()));	
-	ThrowIfFailed(d3dDevice->CreateSamplerState(&desc, quadModel.sampler.GetAddressOf()));	
+	SamplerDesc desc{ TextureFilter::Anisotropic, TextureAddress::Wrap, 16 };
+	cubeModel.sampler = renderDevice->createSampler(desc);
+	quadModel.sampler = renderDevice->createSampler(desc);
 }
 
 //--------------------------------------------
 void InitD3DApp::createRasterizerBlendStates()
 {
-	D3D11_RASTERIZER_DESC rastDesc;
-	ZeroMemory(&rastDesc, sizeof(rastDesc));
-	rastDesc.FillMode = D3D11_FILL_SOLID;
-	rastDesc.CullMode = D3D11_CULL_NONE;
-	rastDesc.FrontCounterClockwise = false;
-	rastDesc.DepthClipEnable = true;
-	ThrowIfFailed(d3dDevice->CreateRasterizerState(&rastDesc, rastState.GetAddressOf()));
-
-	D3D11_BLEND_DESC blendDesc;
-	ZeroMemory(&blendDesc, sizeof(blendDesc));
-	blendDesc.AlphaToCoverageEnable = false;
-	blendDesc.IndependentBlendEnable = false;
-	blendDesc.RenderTarget[0].BlendEnable = true;
-	blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
-	blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
-	blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
-	blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
-	blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
-	blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
-	blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	ThrowIfFailed(d3dDevice->CreateBlendState(&blendDesc, blendState.GetAddressOf()))
+	RasterizerDesc rastDesc{ CullMode::None, false, true };
+	rastState = renderDevice->createRasterizerState(rastDesc);
+
+	BlendDesc blendDesc{ BlendMode::AlphaBlend };
+	blendState = renderDevice->createBlendState(blendDesc);
+}
+
+//World space bounds of the static cube and quad instances
+//---------------------------------
+void InitD3DApp::setupCullingData()
+{
+	std::vector<AABB> cubeBounds(cubeTranslateVectors.size());
+	for (size_t i = 0; i < cubeTranslateVectors.size(); i++)
+	{
+		const XMFLOAT3& t = cubeTranslateVectors[i];
+		const Bounds& b = cubeModel.bounds;
+		cubeBounds[i] = { { b.aabbMin.x + t.x, b.aabbMin.y + t.y, b.aabbMin.z + t.z },
+						  { b.aabbMax.x + t.x, b.aabbMax.y + t.y, b.aabbMax.z + t.z } };
+	}
+	cubeBVH.build(cubeBounds);
+
+	quadSpheres.resize(quadTranslateVectors.size());
+	for (size_t i = 0; i < quadTranslateVectors.size(); i++)
+	{
+		quadSpheres.setTranslated(i, quadModel.bounds, quadTranslateVectors[i]);
+	}
+
+	visibleCubes.reserve(cubeTranslateVectors.size());
+	visibleQuads.resize(quadTranslateVectors.size());
 }
 
 //-------------------------
@@ -399,13 +643,27 @@ void InitD3DApp::onResize()
 	d3dApp::onResize();
 
 	//Calculate new Projection Matrix
-	XMMATRIX mProjMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), aspectRatio(), 0.1f, 1000.0f);
+	const float nearZ{ 0.1f };
+	const float farZ{ 1000.0f };
+	XMMATRIX mProjMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), aspectRatio(), nearZ, farZ);
 	XMStoreFloat4x4(&fProjMatrix, mProjMatrix);
+
+	//Opaque sort keys quantize view depth over the whole frustum
+	opaqueQueue.setMaxDepth(farZ);
+
+	//16:9 tiles of about 120 pixels at 1080p
+	lightClusters.build(16, 9, 24, fProjMatrix, nearZ, farZ);
 }
 
 //-------------------------------------------
-void InitD3DApp::updateScene(float deltaTime)
+void InitD3DApp::updateFrame(float /*deltaTime*/)
 {
+	//Create device resources for assets that finished loading
+	{
+		PROFILE_SCOPE("assetCallbacks");
+		assetLoader.processCompleted();
+	}
+
 	//Calculate new View Matrix
 	XMVECTOR camPos = XMLoadFloat4(&this->camPos);
 	XMVECTOR camLookAt = XMLoadFloat3(&this->camLookAt);
@@ -413,7 +671,12 @@ void InitD3DApp::updateScene(float deltaTime)
 
 	XMMATRIX mViewMatrix = XMMatrixLookAtLH(camPos, camPos + camLookAt, worldUp);
 	XMStoreFloat4x4(&fViewMatrix, mViewMatrix);
+}
 
+//Simulation step, fixed length in fixed timestep mode. The scene is static at the moment
+//-------------------------------------------
+void InitD3DApp::updateScene(float deltaTime)
+{
 	/*cubeModel.uOffset += gameTimer.getDeltaTime() * 0.05f;
 	cubeModel.vOffset += gameTimer.getDeltaTime() * 0.08f;
 	XMMATRIX rotate = XMMatrixRotationRollPitchYaw(0.0f, 0.0f, cubeModel.uOffset);
@@ -423,32 +686,11 @@ void InitD3DApp::updateScene(float deltaTime)
 //--------------------------
 void InitD3DApp::drawScene()
 {
-	assert(swapChain);
-	assert(d3dImmediateContext);
+	assert(renderContext);
 
-	d3dImmediateContext->ClearRenderTargetView(renderTargetView.Get(), Colors::White);
-	d3dImmediateContext->ClearDepthStencilView(depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-
-	//Set shader programs
-	d3dImmediateContext->VSSetShader(vertexShader.Get(), 0, 0);
-	d3dImmediateContext->PSSetShader(pixelShader.Get(), 0, 0);
-
-	//Set Rasterizer state
-	d3dImmediateContext->RSSetState(rastState.Get());
-	
-	//Set Constant Buffers
-	d3dImmediateContext->VSSetConstantBuffers(0, 1, constantBufferPerObject.GetAddressOf());
-	d3dImmediateContext->PSSetConstantBuffers(0, 1, constantBufferPerObject.GetAddressOf());
-	d3dImmediateContext->PSSetConstantBuffers(1, 1, constantBufferPerFrame.GetAddressOf());
-
-	//Set Input Layout
-	d3dImmediateContext->IASetInputLayout(inputLayout.Get());
-
-	//Set primitive topology
-	d3dImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	renderContext->clear(Colors::White, 1.0f, 0);
 
 	//CBUFFER PER FRAME
-	D3D11_MAPPED_SUBRESOURCE mappedSubResource;
 	XMFLOAT3 spotLightPos = Float4ToFloat3(&getCameraPos());
 	XMFLOAT3 spotLightDir = getCameraTarget();
 
@@ -456,61 +698,186 @@ void InitD3DApp::drawScene()
 //	cbufferperframe.spotLight.lightPos = spotLightPos;
 	cbufferperframe.spotLight.lightDir = spotLightDir;
 
-	ZeroMemory(&mappedSubResource, sizeof(mappedSubResource));
-	d3dImmediateContext->Map(constantBufferPerFrame.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubResource);
-	memcpy(mappedSubResource.pData, &cbufferperframe, sizeof(cbufferPerFrame));
-	d3dImmediateContext->Unmap(constantBufferPerFrame.Get(), 0);
+	if (useClusteredLighting())
+	{
+		PROFILE_SCOPE("lightClusters");
+		lightClusters.assign(fViewMatrix, scenePointLights.data(), scenePointLights.size(), sceneSpotLights.data(), sceneSpotLights.size());
+		cbufferperframe.clusters = lightClusters.constants(fViewMatrix, static_cast<float>(appWidth), static_cast<float>(appHeight));
+		uploadLightClusters();
+	}
+
+	constantRing->beginFrame();
+	ConstantAllocation frameConstants = constantRing->upload(*renderContext, &cbufferperframe, sizeof(cbufferPerFrame));
+	bindOpaquePipeline(*renderContext, frameConstants);
+
+	//Frustum cull instances
+	{
+		PROFILE_SCOPE("culling");
+		Frustum frustum = extractFrustumPlanes(XMLoadFloat4x4(&fViewMatrix) * XMLoadFloat4x4(&fProjMatrix));
+		visibleCubes.clear();
+		cubeBVH.queryFrustum(frustum, visibleCubes);
+		visibleQuadCount = cullSpheres(frustum, quadSpheres, visibleQuads);
+	}
 	
 	//Draw Cube
-	//cubeModel.performInefficientAnimation(gameTimer);
-	for (size_t i = 0; i < cubeTranslateVectors.size(); i++)
 	{
-		XMMATRIX translate = XMMatrixTranslation(cubeTranslateVectors[i].x, cubeTranslateVectors[i].y, cubeTranslateVectors[i].z);
-		XMStoreFloat4x4(&cubeModel.worldMatrix, translate);
+		PROFILE_SCOPE("cubeDraws");
+		if (animateCube)
+		{
+			cubeModel.updateFlipbookAnimation(gameTimer);
+		}
 		cubeModel.clipAlpha = true;
-		drawObjectIndexed(&cubeModel);
+		if (instancedDraw)
+		{
+			//Instances are packed level by level so each level of detail is one instanced draw
+			XMMATRIX view = XMLoadFloat4x4(&fViewMatrix);
+			for (uint32_t i : visibleCubes)
+			{
+				selectCubeLod(i, view);
+			}
+			cubeLodSelector.groupByLevel(visibleCubes, static_cast<uint32_t>(cubeModel.lods.size()), cubesByLod, cubeLodCounts);
+
+			uint32_t flags = (cubeModel.useTexture ? INSTANCE_USE_TEXTURE : 0) | (cubeModel.clipAlpha ? INSTANCE_CLIP_ALPHA : 0);
+			cubeInstances.clear();
+			for (uint32_t i : cubesByLod)
+			{
+				cubeInstances.addTranslation(cubeTranslateVectors[i], cubeModel.material, flags);
+			}
+			drawObjectInstanced(&cubeModel, cubeInstances, cubeLodCounts);
+		}
+		else if (!visibleCubes.empty())
+		{
+			//Sort by shader and texture, then front to back for early depth rejection
+			opaqueQueue.clear();
+			XMMATRIX view = XMLoadFloat4x4(&fViewMatrix);
+			for (uint32_t i : visibleCubes)
+			{
+				float viewDepth = selectCubeLod(i, view);
+				opaqueQueue.push(0, vertexShader.id, cubeModel.texture.id, viewDepth, i);
+			}
+			opaqueQueue.sort();
+
+			//Constants of every cube go in with one map, the draws then only bind offsets
+			ConstantAllocation cubeConstants;
+			uint8_t* mapped = static_cast<uint8_t*>(constantRing->map(*renderContext, sizeof(cbufferPerObject), static_cast<uint32_t>(opaqueQueue.size()), cubeConstants));
+			for (size_t i = 0; i < opaqueQueue.size(); i++)
+			{
+				const XMFLOAT3& cubePos = cubeTranslateVectors[opaqueQueue[i].drawIndex];
+				XMStoreFloat4x4(&cubeModel.worldMatrix, XMMatrixTranslation(cubePos.x, cubePos.y, cubePos.z));
+				writeObjectConstants(&cubeModel, mapped + i * cubeConstants.elementSize);
+			}
+			constantRing->unmap(*renderContext);
+
+			if (parallelRecorder)
+			{
+				const size_t minDrawsPerChunk{ 1024 };
+				parallelRecorder->record(*renderContext, opaqueQueue.size(), minDrawsPerChunk, [&](IRenderContext& context, size_t begin, size_t end)
+				{
+					bindOpaquePipeline(context, frameConstants);
+					for (size_t i = begin; i < end; i++)
+					{
+						drawObjectIndexed(context, &cubeModel, cubeConstants, static_cast<uint32_t>(i), cubeLodSelector.level(opaqueQueue[i].drawIndex));
+					}
+				});
+				//Executing the command lists left the immediate context at default state
+				bindOpaquePipeline(*renderContext, frameConstants);
+			}
+			else
+			{
+				for (uint32_t i = 0; i < opaqueQueue.size(); i++)
+				{
+					drawObjectIndexed(*renderContext, &cubeModel, cubeConstants, i, cubeLodSelector.level(opaqueQueue[i].drawIndex));
+				}
+			}
+		}
 	}
 	
 	//Enable blending
-	d3dImmediateContext->RSSetState(0);
-	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-	d3dImmediateContext->OMSetBlendState(blendState.Get(), blendFactor, 0xffffffff);
+	renderContext->setRasterizerState(RasterizerStateHandle{});
+	renderContext->setBlendState(blendState);
 
 	//Calculate drawing order of quads according to distance from camera
-	for (size_t i = 0; i < quadTranslateVectors.size(); i++)
 	{
-		XMVECTOR viewPos = XMLoadFloat4(&cbufferperframe.viewPos);
-		XMVECTOR quadPos = XMLoadFloat3(&quadTranslateVectors[i]);
-		XMVECTOR diff = XMVectorSubtract(viewPos, quadPos);
-		XMVECTOR xDistance = XMVector3Length(diff);
+		PROFILE_SCOPE("transparentSort");
+		transparentQueue.clear();
+		for (size_t v = 0; v < visibleQuadCount; v++)
+		{
+			uint32_t i = visibleQuads[v];
+			XMVECTOR viewPos = XMLoadFloat4(&cbufferperframe.viewPos);
+			XMVECTOR quadPos = XMLoadFloat3(&quadTranslateVectors[i]);
+			XMVECTOR diff = XMVectorSubtract(viewPos, quadPos);
+			XMVECTOR xDistance = XMVector3Length(diff);
 
-		XMFLOAT3 fDistance;
-		XMStoreFloat3(&fDistance, xDistance);
-		float distance = fDistance.x;   //All components hold the same length value
+			XMFLOAT3 fDistance;
+			XMStoreFloat3(&fDistance, xDistance);
+			float distance = fDistance.x;   //All components hold the same length value
 
-		quadDistancesFromCamera[distance] = quadTranslateVectors[i];
+			transparentQueue.push(distance, i);
+		}
+		transparentQueue.sort();
 	}
-	//Draw Quads in reverse order i.e. furthest quad from camera is drawn first (std::map is using ascending order)
-	for (auto i = quadDistancesFromCamera.crbegin(); i != quadDistancesFromCamera.crend(); i++)
+
+	//Draw Quads back to front i.e. furthest quad from camera is drawn first
+	if (transparentQueue.size() != 0)
 	{
-		XMMATRIX translate = XMMatrixTranslation(i->second.x, i->second.y, i->second.z);
-		XMStoreFloat4x4(&quadModel.worldMatrix, translate);
-		drawObjectIndexed(&quadModel);
+		PROFILE_SCOPE("transparentDraws");
+		ConstantAllocation quadConstants;
+		uint8_t* mapped = static_cast<uint8_t*>(constantRing->map(*renderContext, sizeof(cbufferPerObject), static_cast<uint32_t>(transparentQueue.size()), quadConstants));
+		for (size_t i = 0; i < transparentQueue.size(); i++)
+		{
+			const XMFLOAT3& quadPos = quadTranslateVectors[transparentQueue[i].drawIndex];
+			XMStoreFloat4x4(&quadModel.worldMatrix, XMMatrixTranslation(quadPos.x, quadPos.y, quadPos.z));
+			writeObjectConstants(&quadModel, mapped + i * quadConstants.elementSize);
+		}
+		constantRing->unmap(*renderContext);
+
+		for (uint32_t i = 0; i < transparentQueue.size(); i++)
+		{
+			drawObjectIndexed(*renderContext, &quadModel, quadConstants, i, 0);
+		}
 	}
 
-	ThrowIfFailed(swapChain->Present(0, 0));
+	constantRing->endFrame();
+
+	PROFILE_SCOPE("present");
+	renderDevice->present(0);
 }
 
-//----------------------------------------------------
-void InitD3DApp::drawObjectIndexed(const Model* model)
+//Shaders, fixed function state and per frame constants shared by the per object draws
+//-----------------------------------------------------------------------------------------------
+void InitD3DApp::bindOpaquePipeline(IRenderContext& context, const ConstantAllocation& frameConstants)
 {
-	//==================//
-	//CBUFFER PER OBJECT//
-	//==================//
+	//Set shader programs
+	context.setVertexShader(vertexShader);
+	context.setPixelShader(pixelShader);
+
+	//Set Rasterizer state
+	context.setRasterizerState(rastState);
+
+	//Set Input Layout
+	context.setInputLayout(inputLayout);
+
+	//Set primitive topology
+	context.setPrimitiveTopology(PrimitiveTopology::TriangleList);
 
+	ConstantUploadRing::bind(context, ShaderStage::Pixel, 1, frameConstants);
+
+	if (useClusteredLighting())
+	{
+		context.setStructuredBuffer(ShaderStage::Pixel, 2, pointLightBuffer);
+		context.setStructuredBuffer(ShaderStage::Pixel, 3, spotLightBuffer);
+		context.setStructuredBuffer(ShaderStage::Pixel, 4, clusterBuffer);
+		context.setStructuredBuffer(ShaderStage::Pixel, 5, lightIndexBuffer);
+	}
+}
+
+//Fills cbufferperobject for the model and copies it to mapped constant memory
+//-------------------------------------------------------------------------------
+void InitD3DApp::writeObjectConstants(const Model* model, void* destination)
+{
 	//World View Projection Matrix
 	XMMATRIX worldViewProj;
-	XMMATRIX world = XMLoadFloat4x4(&model->worldMatrix);
+	XMMATRIX world = XMLoadFloat4x4(&model->positionDecode) * XMLoadFloat4x4(&model->worldMatrix);
 	XMMATRIX view = XMLoadFloat4x4(&fViewMatrix);
 	XMMATRIX proj = XMLoadFloat4x4(&fProjMatrix);
 	worldViewProj = world * view * proj;
@@ -533,23 +900,133 @@ void InitD3DApp::drawObjectIndexed(const Model* model)
 	cbufferperobject.clipAlpha = model->clipAlpha;
 	cbufferperobject.texTransformMatrix = XMMatrixTranspose(mTexTransformMatrix);
 
-	/*D3D11_MAPPED_SUBRESOURCE mappedSubResource;
-	ZeroMemory(&mappedSubResource, sizeof(mappedSubResource));
-	d3dImmediateContext->Map(constantBufferPerObject.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubResource);
-	memcpy(mappedSubResource.pData, &cbufferperobject, sizeof(cbufferPerObject));
-	d3dImmediateContext->Unmap(constantBufferPerObject.Get(), 0);*/
-	d3dImmediateContext->UpdateSubresource(constantBufferPerObject.Get(), 0, 0, &cbufferperobject, 0, 0);
+	memcpy(destination, &cbufferperobject, sizeof(cbufferPerObject));
+}
 
-	//=================================================//
+//------------------------------------------------------------------------------------------------------------------------------------
+void InitD3DApp::drawObjectIndexed(IRenderContext& context, const Model* model, const ConstantAllocation& constants, uint32_t element, uint32_t lod)
+{
+	//Per object constants written by writeObjectConstants
+	ConstantUploadRing::bind(context, ShaderStage::Vertex, 0, constants, element);
+	ConstantUploadRing::bind(context, ShaderStage::Pixel, 0, constants, element);
 
 	//Set Buffers
-	d3dImmediateContext->IASetVertexBuffers(0, 1, model->vertexBuffer.GetAddressOf(), &model->stride, &model->offset);
-	d3dImmediateContext->IASetIndexBuffer(model->indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	context.setVertexBuffers(0, 1, &model->vertexBuffer, &model->stride, &model->offset);
+	context.setIndexBuffer(model->indexBuffer, model->indexFormat, 0);
 
 	//Bind Textures
-	d3dImmediateContext->PSSetShaderResources(0, 1, model->texViews[model->currentFrame].GetAddressOf());
-	d3dImmediateContext->PSSetSamplers(0, 1, model->sampler.GetAddressOf());
+	context.setTexture(ShaderStage::Pixel, 0, model->texture);
+	context.setSampler(ShaderStage::Pixel, 0, model->sampler);
 
 	//Draw
-	d3dImmediateContext->DrawIndexed(model->indexCount, model->startIndex, model->baseVertex);
+	MeshLod level = model->lod(lod);
+	context.drawIndexed(level.indexCount, level.startIndex, model->baseVertex);
+}
+
+//Copies the clusters and light index list of the frame to their structured buffers, growing them when needed
+//----------------------------------------
+void InitD3DApp::uploadLightClusters()
+{
+	const std::vector<LightCluster>& clusters = lightClusters.lightClusters();
+	const std::vector<uint32_t>& indices = lightClusters.lightIndices();
+
+	auto upload = [this](BufferHandle& buffer, uint32_t& capacity, const void* data, size_t count, uint32_t stride)
+	{
+		//Empty buffers can't be created, keep at least one element
+		if (count > capacity || capacity == 0)
+		{
+			capacity = std::max<uint32_t>({ static_cast<uint32_t>(count), capacity * 2, 1 });
+
+			BufferDesc desc{ capacity * stride, BufferBinding::ShaderResource, ResourceUsage::Dynamic, stride };
+			renderDevice->destroyBuffer(buffer);
+			buffer = renderDevice->createBuffer(desc, nullptr);
+		}
+
+		void* mappedData = renderContext->mapBuffer(buffer, MapMode::WriteDiscard);
+		memcpy(mappedData, data, count * stride);
+		renderContext->unmapBuffer(buffer);
+	};
+
+	upload(clusterBuffer, clusterBufferCapacity, clusters.data(), clusters.size(), sizeof(LightCluster));
+	upload(lightIndexBuffer, lightIndexBufferCapacity, indices.data(), indices.size(), sizeof(uint32_t));
+}
+
+//Picks the cube's level of detail from its projected size and returns its view space depth
+//-------------------------------------------------------------------
+float InitD3DApp::selectCubeLod(uint32_t cube, FXMMATRIX view)
+{
+	const float radius = cubeModel.bounds.radius;
+	float viewDepth = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&cubeTranslateVectors[cube]), view));
+	float screenRadius = LodSelector::projectedRadius(radius, viewDepth, fProjMatrix._22, static_cast<float>(appHeight));
+	cubeLodSelector.select(cube, cubeModel.lods, radius, screenRadius);
+	return viewDepth;
+}
+
+//Draws the packed instances with one DrawIndexedInstanced call per level of detail
+//The instances are grouped by level, lodCounts[level] of them in a run from level 0 up
+//----------------------------------------------------------------------------------------------------------------------------------
+void InitD3DApp::drawObjectInstanced(const Model* model, const InstancePacker& instances, const std::vector<uint32_t>& lodCounts)
+{
+	if (instances.count() == 0)
+	{
+		return;
+	}
+
+	//Grow the per instance buffer when needed
+	if (instances.count() > instanceBufferCapacity)
+	{
+		instanceBufferCapacity = std::max<uint32_t>(static_cast<uint32_t>(instances.count()), instanceBufferCapacity * 2);
+
+		BufferDesc instDesc{ instanceBufferCapacity * static_cast<uint32_t>(sizeof(InstanceData)), BufferBinding::Vertex, ResourceUsage::Dynamic };
+		renderDevice->destroyBuffer(instanceBuffer);
+		instanceBuffer = renderDevice->createBuffer(instDesc, nullptr);
+	}
+
+	void* mappedData = renderContext->mapBuffer(instanceBuffer, MapMode::WriteDiscard);
+	memcpy(mappedData, instances.data(), instances.sizeInBytes());
+	renderContext->unmapBuffer(instanceBuffer);
+
+	//World matrices come from the instance stream so the cbuffer only holds view * proj
+	XMMATRIX view = XMLoadFloat4x4(&fViewMatrix);
+	XMMATRIX proj = XMLoadFloat4x4(&fProjMatrix);
+	cbufferperobject.worldViewProj = XMMatrixTranspose(view * proj);
+	cbufferperobject.world = XMMatrixIdentity();
+	cbufferperobject.texTransformMatrix = XMMatrixTranspose(XMLoadFloat4x4(&model->texTransformMatrix));
+	ConstantAllocation objectConstants = constantRing->upload(*renderContext, &cbufferperobject, sizeof(cbufferPerObject));
+	ConstantUploadRing::bind(*renderContext, ShaderStage::Vertex, 0, objectConstants);
+	ConstantUploadRing::bind(*renderContext, ShaderStage::Pixel, 0, objectConstants);
+
+	//Set instanced pipeline
+	renderContext->setInputLayout(instancedInputLayout);
+	renderContext->setVertexShader(instancedVertexShader);
+	renderContext->setPixelShader(instancedPixelShader);
+
+	//Set Buffers
+	BufferHandle buffers[2]{ model->vertexBuffer, instanceBuffer };
+	uint32_t strides[2]{ model->stride, sizeof(InstanceData) };
+	uint32_t offsets[2]{ model->offset, 0 };
+	renderContext->setVertexBuffers(0, 2, buffers, strides, offsets);
+	renderContext->setIndexBuffer(model->indexBuffer, model->indexFormat, 0);
+
+	//Bind Textures
+	renderContext->setTexture(ShaderStage::Pixel, 0, model->texture);
+	renderContext->setSampler(ShaderStage::Pixel, 0, model->sampler);
+
+	//Draw, startInstance moves the instance stream on to each level's run
+	uint32_t startInstance{ 0 };
+	for (uint32_t level = 0; level < lodCounts.size(); level++)
+	{
+		if (lodCounts[level] == 0)
+		{
+			continue;
+		}
+		MeshLod lod = model->lod(level);
+		renderContext->drawIndexedInstanced(lod.indexCount, lodCounts[level], lod.startIndex, model->baseVertex, startInstance);
+		startInstance += lodCounts[level];
+	}
+
+	//Restore the per object pipeline for the remaining draws
+	renderContext->setInputLayout(inputLayout);
+	renderContext->setVertexShader(vertexShader);
+	renderContext->setPixelShader(pixelShader);
 }
\ No newline at end of file